@@ -111,6 +111,13 @@ int DoIt( int argc, char * argv[] )
   atlasBuilder->SetImageCountThreshold( lowerThreshold );
   atlasBuilder->AdjustResampledImageSize( doImageSizeAdjustment );
   atlasBuilder->AdjustResampledImageOrigin( doImageOriginAdjustment );
+  atlasBuilder->SetNumberOfOutlierImagesToRemove( outliersToRemove );
+  if( useMedian )
+    {
+    atlasBuilder->SetMaximumNumberOfImagesForExactMedian(
+      maximumImagesForExactMedian );
+    atlasBuilder->UseMedian( imageObjects.size() );
+    }
 
   ImageDocumentListType::const_iterator it_imgDoc = imageObjects.begin();
   tube::FmtInfoMessage( "Starting image addition..." );
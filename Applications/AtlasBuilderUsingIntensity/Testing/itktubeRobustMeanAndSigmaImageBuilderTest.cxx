@@ -0,0 +1,203 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeRobustMeanAndSigmaImageBuilder.h"
+
+#include <itkImageRegionIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+
+enum { Dimension = 3 };
+
+typedef itk::Image< float, Dimension >                         ImageType;
+typedef itk::tube::RobustMeanAndSigmaImageBuilder< ImageType,
+  ImageType, ImageType >                                       BuilderType;
+
+// Adds the cohort to a builder and forms its outputs
+void BuildImages( BuilderType * builder,
+  const std::vector< ImageType::Pointer > & images )
+{
+  builder->SetThresholdInputImageBelow( 0 );
+  builder->SetImageCountThreshold( 1 );
+  builder->SetUseStandardDeviation( false );
+  for( unsigned int i = 0; i < images.size(); ++i )
+    {
+    builder->AddImage( images[i] );
+    }
+  builder->FinalizeOutput();
+}
+
+int itktubeRobustMeanAndSigmaImageBuilderTest( int itkNotUsed( argc ),
+  char * itkNotUsed( argv )[] )
+{
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 6;
+  size[1] = 5;
+  size[2] = 4;
+  region.SetSize( size );
+  const unsigned int numberOfVoxels = region.GetNumberOfPixels();
+
+  // A small cohort in which about a fifth of the values are below the
+  // threshold, so that the voxels have different numbers of values
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::Pointer rndGen
+    = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  rndGen->Initialize( 1 );
+
+  const unsigned int numberOfImages = 9;
+  std::vector< ImageType::Pointer > images;
+  std::vector< std::vector< float > > values( numberOfVoxels );
+  for( unsigned int i = 0; i < numberOfImages; ++i )
+    {
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions( region );
+    image->Allocate();
+    float * buffer = image->GetBufferPointer();
+    for( unsigned int v = 0; v < numberOfVoxels; ++v )
+      {
+      buffer[v] = -1;
+      if( rndGen->GetUniformVariate( 0, 1 ) > 0.2 )
+        {
+        buffer[v] = static_cast< float >(
+          rndGen->GetUniformVariate( 1, 100 ) );
+        values[v].push_back( buffer[v] );
+        }
+      }
+    images.push_back( image );
+    }
+  for( unsigned int v = 0; v < numberOfVoxels; ++v )
+    {
+    std::sort( values[v].begin(), values[v].end() );
+    }
+
+  int returnStatus = EXIT_SUCCESS;
+
+  // The median of a cohort within the bound is exact, whatever the
+  // number of outliers
+  BuilderType::Pointer medianBuilder = BuilderType::New();
+  medianBuilder->SetNumberOfOutlierImagesToRemove( 1 );
+  medianBuilder->UseMedianImage( numberOfImages );
+  BuildImages( medianBuilder, images );
+  const float * median =
+    medianBuilder->GetOutputMeanImage()->GetBufferPointer();
+  for( unsigned int v = 0; v < numberOfVoxels; ++v )
+    {
+    const std::vector< float > & sorted = values[v];
+    double expected = 0;
+    if( !sorted.empty() )
+      {
+      const unsigned int n = sorted.size();
+      expected = ( static_cast< double >( sorted[( n - 1 ) / 2] )
+        + sorted[n / 2] ) / 2;
+      }
+    if( vnl_math_abs( median[v] - expected ) > 1e-4 )
+      {
+      std::cerr << "Error: voxel " << v << " median = " << median[v]
+        << ", expected " << expected << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  // Beyond the bound the median is estimated, exactly for up to five
+  // values and within the range of the values otherwise
+  BuilderType::Pointer estimateBuilder = BuilderType::New();
+  estimateBuilder->SetMaximumNumberOfImagesForExactMedian(
+    numberOfImages - 1 );
+  estimateBuilder->UseMedianImage( numberOfImages );
+  BuildImages( estimateBuilder, images );
+  const float * estimate =
+    estimateBuilder->GetOutputMeanImage()->GetBufferPointer();
+  for( unsigned int v = 0; v < numberOfVoxels; ++v )
+    {
+    const std::vector< float > & sorted = values[v];
+    const unsigned int n = sorted.size();
+    if( n == 0 )
+      {
+      continue;
+      }
+    const double expected = ( static_cast< double >(
+      sorted[( n - 1 ) / 2] ) + sorted[n / 2] ) / 2;
+    if( ( n <= 5 && vnl_math_abs( estimate[v] - expected ) > 1e-4 )
+      || estimate[v] < sorted.front() || estimate[v] > sorted.back() )
+      {
+      std::cerr << "Error: voxel " << v << " median estimate = "
+        << estimate[v] << " for " << n << " values, median " << expected
+        << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  // The mean and variance exclude the lowest and highest values of the
+  // voxels that have more than twice as many values
+  const unsigned int numberOfOutliers = 2;
+  BuilderType::Pointer robustBuilder = BuilderType::New();
+  robustBuilder->SetNumberOfOutlierImagesToRemove( numberOfOutliers );
+  BuildImages( robustBuilder, images );
+  const float * mean =
+    robustBuilder->GetOutputMeanImage()->GetBufferPointer();
+  const float * variance =
+    robustBuilder->GetOutputSigmaImage()->GetBufferPointer();
+  for( unsigned int v = 0; v < numberOfVoxels; ++v )
+    {
+    const std::vector< float > & sorted = values[v];
+    unsigned int begin = 0;
+    unsigned int end = sorted.size();
+    if( end > 2 * numberOfOutliers )
+      {
+      begin += numberOfOutliers;
+      end -= numberOfOutliers;
+      }
+    double expectedMean = 0;
+    for( unsigned int i = begin; i < end; ++i )
+      {
+      expectedMean += sorted[i];
+      }
+    if( end > begin )
+      {
+      expectedMean /= end - begin;
+      }
+    double expectedVariance = 0;
+    if( end - begin > 1 )
+      {
+      for( unsigned int i = begin; i < end; ++i )
+        {
+        expectedVariance += ( sorted[i] - expectedMean )
+          * ( sorted[i] - expectedMean );
+        }
+      expectedVariance /= end - begin - 1;
+      }
+    if( vnl_math_abs( mean[v] - expectedMean ) > 1e-3
+      || vnl_math_abs( variance[v] - expectedVariance )
+        > 1e-3 + 1e-5 * expectedVariance )
+      {
+      std::cerr << "Error: voxel " << v << " robust mean = " << mean[v]
+        << ", variance = " << variance[v] << ", expected "
+        << expectedMean << ", " << expectedVariance << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  return returnStatus;
+}
@@ -26,8 +26,12 @@ limitations under the License.
 
 #include "tubeMessage.h"
 
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkMultiThreader.h>
 #include <itkObject.h>
 #include <itkResampleImageFilter.h>
+#include <itkTransform.h>
 
 namespace itk
 {
@@ -40,6 +44,11 @@ namespace tube
  *   Images are processed and discarded as they are entered,
  *   which prevents memory overload.
  *
+ *  The running mean and the sum of squared deviations from it are updated
+ *  with Welford's method, in parallel over slabs of the output region.
+ *  Images given with a transform are resampled into the output grid
+ *  inside the same pass, so no resampled copy is ever allocated.
+ *
  *  All inputed images entered to AddImage() are assumed to have the
  *  same spacing, origin.  Optionally, the output size can be changed by using
  *  AdjustOutputImageSize() and all subsequent additions to AddImage()
@@ -88,7 +97,10 @@ public:
   typedef typename InputImageType::PointType            PointType;
 
   typedef Image<
-    float,itkGetStaticConstMacro( ImageDimension )>           ProcessImageType;
+    double,itkGetStaticConstMacro( ImageDimension )>          ProcessImageType;
+
+  typedef Transform< double, itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension ) >          TransformType;
 
   /**
    * Add an image to the group being summed.
@@ -100,6 +112,17 @@ public:
    */
   virtual void AddImage( InputImagePointer );
 
+  /**
+   * Resample an image into the output grid and add it to the group.
+   *
+   * The transform maps output (atlas) points to input image points, as
+   * for ResampleImageFilter.  Values are linearly interpolated, and
+   * output voxels that map outside of the image get the
+   * DefaultPixelValue.  At least one image must have been added with
+   * AddImage( InputImagePointer ) to define the output grid.
+   */
+  virtual void AddImage( InputImagePointer, const TransformType * );
+
   /**
    * Must call this function to finish image additions and form the
    * mean and variance
@@ -185,6 +208,18 @@ public:
    */
   itkSetMacro( DynamicallyAdjustOutputSize, bool );
 
+  /**
+   * Get the value given to output voxels that map outside of an image
+   * added with a transform.  Default is 0
+   */
+  itkGetConstMacro( DefaultPixelValue, InputPixelType );
+
+  /**
+   * Set the value given to output voxels that map outside of an image
+   * added with a transform.  Default is 0
+   */
+  itkSetMacro( DefaultPixelValue, InputPixelType );
+
   /**
    * Update the output images to the inputed size.
    *
@@ -214,7 +249,11 @@ public:
   /** Set the current size of the output images */
   itkSetMacro( OutputOrigin, PointType );
 
-  itkGetObjectMacro( SumImage, ProcessImageType );
+  /** Get the running mean image */
+  itkGetObjectMacro( RunningMeanImage, ProcessImageType );
+
+  /** Get the running sum of squared deviations from the mean */
+  itkGetObjectMacro( SumOfSquaredDeviationsImage, ProcessImageType );
 
 protected:
 
@@ -233,10 +272,12 @@ protected:
   typedef ImageRegionIterator< OutputMeanImageType >   OutputMeanIteratorType;
   typedef ImageRegionIterator< OutputSigmaImageType >  OutputSigmaIteratorType;
 
-  itkSetObjectMacro( SumImage, ProcessImageType );
+  typedef LinearInterpolateImageFunction< InputImageType, double >
+                                                       InterpolatorType;
+
+  itkSetObjectMacro( RunningMeanImage, ProcessImageType );
 
-  itkGetObjectMacro( SumSquareImage, ProcessImageType );
-  itkSetObjectMacro( SumSquareImage, ProcessImageType );
+  itkSetObjectMacro( SumOfSquaredDeviationsImage, ProcessImageType );
 
   itkSetObjectMacro( ValidCountImage, CountImageType );
 
@@ -260,14 +301,65 @@ protected:
 
   /**
    * Build new processing images, i.e.,
-   * sumImage, sumSquareImage, validCountImage
+   * runningMeanImage, sumOfSquaredDeviationsImage, validCountImage
    */
   virtual void BuildProcessingImages( InputImagePointer i );
 
+  /**
+   * Add a valid value to the statistics of the voxel at the given buffer
+   * offset of the processing images.  Called concurrently for distinct
+   * offsets; subclasses extend it to keep more per-voxel statistics
+   */
+  virtual void AccumulateValue( SizeValueType offset, InputPixelType value );
+
+  /**
+   * Remove a value from the statistics of the voxel at the given buffer
+   * offset, reversing AccumulateValue()
+   */
+  void RemoveValue( SizeValueType offset, InputPixelType value );
+
+  /** Resize an image to the given size, keeping its spacing and origin */
+  template< class TImage >
+  typename TImage::Pointer ResizeImage( TImage * image,
+    const SizeType & size ) const
+    {
+    typedef ResampleImageFilter< TImage, TImage > ResampleFilterType;
+
+    typename ResampleFilterType::Pointer filter = ResampleFilterType::New();
+    filter->SetInput( image );
+    filter->SetSize( size );
+    filter->SetOutputSpacing( image->GetSpacing() );
+    filter->SetOutputOrigin( image->GetOrigin() );
+    filter->Update();
+    return filter->GetOutput();
+    }
+
+  /** Split the output region into slabs along its last dimension */
+  bool SplitOutputRegion( ThreadIdType threadId, ThreadIdType numberOfThreads,
+    RegionType & slab ) const;
+
+  struct AccumulateThreadStruct
+    {
+    Self *                     Builder;
+    const InputImageType *     Image;
+    const TransformType *      Transform;
+    const InterpolatorType *   Interpolator;
+    };
+
+  static ITK_THREAD_RETURN_TYPE AccumulateThreaderCallback( void * arg );
+
+  /** Add the voxels of one slab of the output region */
+  void ThreadedAccumulate( const RegionType & slab,
+    const AccumulateThreadStruct * str );
+
+  /** Run ThreadedAccumulate() over all slabs of the output region */
+  void Accumulate( const InputImageType * image,
+    const TransformType * transform );
+
 private:
 
-  ProcessImagePointer                     m_SumImage;
-  ProcessImagePointer                     m_SumSquareImage;
+  ProcessImagePointer                     m_RunningMeanImage;
+  ProcessImagePointer                     m_SumOfSquaredDeviationsImage;
   CountImagePointer                       m_ValidCountImage;
 
   OutputMeanImagePointer                  m_OutputMeanImage;
@@ -279,6 +371,7 @@ private:
   bool                                    m_IsProcessing;
   bool                                    m_UseStandardDeviation;
   bool                                    m_DynamicallyAdjustOutputSize;
+  InputPixelType                          m_DefaultPixelValue;
 
   SizeType                                m_OutputSize;
   SpacingType                             m_OutputSpacing;
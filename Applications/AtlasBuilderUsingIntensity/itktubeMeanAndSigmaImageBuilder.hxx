@@ -37,7 +37,8 @@ MeanAndSigmaImageBuilder< TInputImageType,
   m_ThresholdInputImageBelow(0),
   m_IsProcessing(false),
   m_UseStandardDeviation(true),
-  m_DynamicallyAdjustOutputSize(false)
+  m_DynamicallyAdjustOutputSize(false),
+  m_DefaultPixelValue(0)
 {
   m_OutputSize.Fill(0);
   m_OutputSpacing.Fill(0);
@@ -56,51 +57,217 @@ void MeanAndSigmaImageBuilder< TInputImageType,
     BuildProcessingImages( i );
     }
 
-  // Iterate through current_image and copy values into the Sum Image,
-  // Sum Sqared Image, and Valid Count Image
-  //
-  // Note: Must transform the base image region so that the new added
-  // image has the appropriate region value
-  ProcessImagePointer sumImage = this->GetSumImage();
-  ProcessImagePointer sumSquareImage = this->GetSumSquareImage();
-  CountImagePointer validImage = this->GetValidCountImage();
+  // Note: the input image is read over the output region, so it must have
+  // at least the output size
+  this->Accumulate( i, NULL );
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+void MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::AddImage( InputImagePointer i, const TransformType * transform )
+{
+  if( !( this->GetIsProcessing() ) )
+    {
+    ::tube::ErrorMessage(
+      "Need to call AddImage() before adding transformed images!" );
+    return;
+    }
 
-  typename ProcessImageType::RegionType region;
-  region.SetSize( this->GetOutputSize() );
+  this->Accumulate( i, transform );
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+void MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::Accumulate( const InputImageType * image, const TransformType * transform )
+{
+  typename InterpolatorType::Pointer interpolator;
+  if( transform != NULL )
+    {
+    interpolator = InterpolatorType::New();
+    interpolator->SetInputImage( image );
+    }
 
-  InputConstIteratorType it_image( i, region );
-  CountIteratorType it_valid( validImage, region );
-  ProcessIteratorType it_sum( sumImage, region );
-  ProcessIteratorType it_sum_sqre( sumSquareImage, region );
+  AccumulateThreadStruct str;
+  str.Builder = this;
+  str.Image = image;
+  str.Transform = transform;
+  str.Interpolator = interpolator.GetPointer();
 
-  it_image.GoToBegin();
-  it_valid.GoToBegin();
-  it_sum.GoToBegin();
-  it_sum_sqre.GoToBegin();
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetSingleMethod( this->AccumulateThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+ITK_THREAD_RETURN_TYPE
+MeanAndSigmaImageBuilder< TInputImageType,
+                          TOutputMeanImageType,
+                          TOutputSigmaImageType>
+::AccumulateThreaderCallback( void * arg )
+{
+  ThreadIdType threadId =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->ThreadID;
+  ThreadIdType numberOfThreads =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->NumberOfThreads;
+  AccumulateThreadStruct * str = ( AccumulateThreadStruct * )
+    ( ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->UserData );
+
+  RegionType slab;
+  if( str->Builder->SplitOutputRegion( threadId, numberOfThreads, slab ) )
+    {
+    str->Builder->ThreadedAccumulate( slab, str );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+bool MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::SplitOutputRegion( ThreadIdType threadId, ThreadIdType numberOfThreads,
+  RegionType & slab ) const
+{
+  const unsigned int lastDim = ImageDimension - 1;
+
+  slab.SetSize( this->GetOutputSize() );
+  typename RegionType::IndexType index;
+  index.Fill( 0 );
+  slab.SetIndex( index );
+
+  const SizeValueType numberOfSlices = slab.GetSize( lastDim );
+  const SizeValueType slicesPerThread =
+    ( numberOfSlices + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType firstSlice = threadId * slicesPerThread;
+  if( firstSlice >= numberOfSlices )
+    {
+    return false;
+    }
+
+  slab.SetIndex( lastDim, firstSlice );
+  slab.SetSize( lastDim, std::min( slicesPerThread,
+    numberOfSlices - firstSlice ) );
+  return true;
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+void MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::ThreadedAccumulate( const RegionType & slab,
+  const AccumulateThreadStruct * str )
+{
+  // Slabs span whole slices of the processing images, so their voxels are
+  // contiguous in the processing buffers
+  SizeValueType offset = m_RunningMeanImage->ComputeOffset(
+    slab.GetIndex() );
+
+  const bool threshold = this->GetThresholdInputImageBelowOn();
+  const InputPixelType thresholdValue = this->GetThresholdInputImageBelow();
 
-  while( !it_image.IsAtEnd() && !it_sum.IsAtEnd() )
+  if( str->Transform == NULL )
     {
-    InputPixelType p = it_image.Get();
-
-    // If requested to be threshold, ensure that the value
-    // added has a value above the threshold (and not out of the
-    // image area), else ignore.
-    if( this->GetThresholdInputImageBelowOn() == false
-        || (this->GetThresholdInputImageBelowOn() == true
-        && p > this->GetThresholdInputImageBelow() ) )
+    InputConstIteratorType it_image( str->Image, slab );
+    while( !it_image.IsAtEnd() )
       {
-      it_valid.Set( it_valid.Get() + 1 );
-      it_sum.Set( it_sum.Get() + p );
-      it_sum_sqre.Set( it_sum_sqre.Get() + (p * p) );
+      InputPixelType p = it_image.Get();
+
+      // If requested to be threshold, ensure that the value
+      // added has a value above the threshold (and not out of the
+      // image area), else ignore.
+      if( !threshold || p > thresholdValue )
+        {
+        this->AccumulateValue( offset, p );
+        }
+      ++it_image;
+      ++offset;
       }
-    ++it_image;
-    ++it_sum;
-    ++it_sum_sqre;
-    ++it_valid;
     }
-  this->SetSumImage( sumImage );
-  this->SetSumSquareImage( sumSquareImage );
-  this->SetValidCountImage( validImage );
+  else
+    {
+    ImageRegionConstIteratorWithIndex< ProcessImageType > it_out(
+      m_RunningMeanImage, slab );
+    PointType outputPoint;
+    while( !it_out.IsAtEnd() )
+      {
+      m_RunningMeanImage->TransformIndexToPhysicalPoint( it_out.GetIndex(),
+        outputPoint );
+      typename TransformType::OutputPointType inputPoint =
+        str->Transform->TransformPoint( outputPoint );
+
+      InputPixelType p = m_DefaultPixelValue;
+      if( str->Interpolator->IsInsideBuffer( inputPoint ) )
+        {
+        p = static_cast< InputPixelType >(
+          str->Interpolator->Evaluate( inputPoint ) );
+        }
+
+      if( !threshold || p > thresholdValue )
+        {
+        this->AccumulateValue( offset, p );
+        }
+      ++it_out;
+      ++offset;
+      }
+    }
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+void MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::AccumulateValue( SizeValueType offset, InputPixelType value )
+{
+  // Welford's update of the running mean and sum of squared deviations
+  CountPixelType & count = m_ValidCountImage->GetBufferPointer()[offset];
+  ProcessPixelType & mean = m_RunningMeanImage->GetBufferPointer()[offset];
+  ProcessPixelType & m2 =
+    m_SumOfSquaredDeviationsImage->GetBufferPointer()[offset];
+
+  count += 1;
+  ProcessPixelType delta = value - mean;
+  mean += delta / count;
+  m2 += delta * ( value - mean );
+}
+
+template< class TInputImageType, class TOutputMeanImageType,
+          class TOutputSigmaImageType >
+void MeanAndSigmaImageBuilder< TInputImageType,
+                               TOutputMeanImageType,
+                               TOutputSigmaImageType>
+::RemoveValue( SizeValueType offset, InputPixelType value )
+{
+  CountPixelType & count = m_ValidCountImage->GetBufferPointer()[offset];
+  ProcessPixelType & mean = m_RunningMeanImage->GetBufferPointer()[offset];
+  ProcessPixelType & m2 =
+    m_SumOfSquaredDeviationsImage->GetBufferPointer()[offset];
+
+  if( count <= 1 )
+    {
+    count = 0;
+    mean = 0;
+    m2 = 0;
+    return;
+    }
+
+  ProcessPixelType delta = value - mean;
+  count -= 1;
+  mean -= delta / count;
+  m2 -= delta * ( value - mean );
+  if( m2 < 0 )
+    {
+    m2 = 0;
+    }
 }
 
 template< class TInputImageType, class TOutputMeanImageType,
@@ -116,13 +283,13 @@ void MeanAndSigmaImageBuilder< TInputImageType,
     return;
     }
 
-  ProcessImagePointer sumImage        = this->GetSumImage();
-  ProcessImagePointer sumSquareImage  = this->GetSumSquareImage();
+  ProcessImagePointer meanImageIn     = this->GetRunningMeanImage();
+  ProcessImagePointer m2Image         = this->GetSumOfSquaredDeviationsImage();
   CountImagePointer   validImages     = this->GetValidCountImage();
 
-  RegionType  outputRegion  = sumImage->GetLargestPossibleRegion();
-  SpacingType outputSpacing = sumImage->GetSpacing();
-  PointType   outputOrigin  = sumImage->GetOrigin();
+  RegionType  outputRegion  = meanImageIn->GetLargestPossibleRegion();
+  SpacingType outputSpacing = meanImageIn->GetSpacing();
+  PointType   outputOrigin  = meanImageIn->GetOrigin();
 
   // Build Mean and Variance Images
   OutputMeanImagePointer meanImage = OutputMeanImageType::New();
@@ -138,13 +305,13 @@ void MeanAndSigmaImageBuilder< TInputImageType,
   sigmaImage->Allocate();
 
   CountConstIteratorType it_valid( validImages, outputRegion );
-  ProcessConstIteratorType it_sum( sumImage, outputRegion );
-  ProcessConstIteratorType it_sum_sqre( sumSquareImage, outputRegion );
+  ProcessConstIteratorType it_runningMean( meanImageIn, outputRegion );
+  ProcessConstIteratorType it_m2( m2Image, outputRegion );
   OutputMeanIteratorType it_mean( meanImage, outputRegion );
   OutputSigmaIteratorType it_dev( sigmaImage, outputRegion );
 
-  it_sum.GoToBegin();
-  it_sum_sqre.GoToBegin();
+  it_runningMean.GoToBegin();
+  it_m2.GoToBegin();
   it_dev.GoToBegin();
   it_mean.GoToBegin();
   it_valid.GoToBegin();
@@ -156,7 +323,7 @@ void MeanAndSigmaImageBuilder< TInputImageType,
   // Calculate standard deviation or varaince
   const bool isStdDeviation = this->GetUseStandardDeviation();
 
-  while( !it_sum.IsAtEnd() )
+  while( !it_runningMean.IsAtEnd() )
     {
     // Ensure that the number of valid images at the point is above
     // the set minimum image threshold
@@ -165,11 +332,8 @@ void MeanAndSigmaImageBuilder< TInputImageType,
       {
       if( number > 1 ) // Prevent potential division by zero for variance
         {
-        ProcessPixelType sum = it_sum.Get();
-        ProcessPixelType sumSqr = it_sum_sqre.Get();
-        // Variance Calc. s^2 = ( (sum(x^2) - (sum(x)^2/n) )/ (n-1) )
-        ProcessPixelType variance =
-          ( sumSqr - ( (sum * sum ) / number )) / (number - 1);
+        // Variance Calc. s^2 = sum( (x - mean)^2 ) / (n-1)
+        ProcessPixelType variance = it_m2.Get() / (number - 1);
 
         // If Standard Deviation Calc. s = vcl_sqrt(s^2)
         if( isStdDeviation )
@@ -177,13 +341,12 @@ void MeanAndSigmaImageBuilder< TInputImageType,
           variance = vcl_sqrt(variance);
           }
         it_dev.Set( (OutputSigmaPixelType) variance );
-        it_mean.Set( (OutputMeanPixelType)
-                     ( sum / ( (ProcessPixelType) number )) );
+        it_mean.Set( (OutputMeanPixelType) it_runningMean.Get() );
         }
       else
         {
         it_dev.Set( 0 );
-        it_mean.Set( (OutputMeanPixelType) it_sum.Get() );
+        it_mean.Set( (OutputMeanPixelType) it_runningMean.Get() );
         }
       }
     else
@@ -195,8 +358,8 @@ void MeanAndSigmaImageBuilder< TInputImageType,
     ++it_valid;
     ++it_mean;
     ++it_dev;
-    ++it_sum;
-    ++it_sum_sqre;
+    ++it_runningMean;
+    ++it_m2;
     }
 
   this->SetOutputMeanImage( meanImage );
@@ -214,25 +377,25 @@ MeanAndSigmaImageBuilder< TInputImageType,
                           TOutputSigmaImageType >
 ::BuildProcessingImages( InputImagePointer i )
 {
-  ProcessImagePointer sumImage        = ProcessImageType::New();
-  ProcessImagePointer sumSquareImage  = ProcessImageType::New();
+  ProcessImagePointer meanImage       = ProcessImageType::New();
+  ProcessImagePointer m2Image         = ProcessImageType::New();
   CountImagePointer   validCountImage = CountImageType::New();
 
   RegionType  region  = i->GetLargestPossibleRegion();
   SpacingType spacing = i->GetSpacing();
   PointType   origin  = i->GetOrigin();
 
-  sumImage->SetRegions( region );
-  sumImage->SetSpacing( spacing );
-  sumImage->SetOrigin( origin );
-  sumImage->Allocate();
-  sumImage->FillBuffer( 0 );
+  meanImage->SetRegions( region );
+  meanImage->SetSpacing( spacing );
+  meanImage->SetOrigin( origin );
+  meanImage->Allocate();
+  meanImage->FillBuffer( 0 );
 
-  sumSquareImage->SetRegions( region );
-  sumSquareImage->SetSpacing( spacing );
-  sumSquareImage->SetOrigin( origin );
-  sumSquareImage->Allocate();
-  sumSquareImage->FillBuffer( 0 );
+  m2Image->SetRegions( region );
+  m2Image->SetSpacing( spacing );
+  m2Image->SetOrigin( origin );
+  m2Image->Allocate();
+  m2Image->FillBuffer( 0 );
 
   validCountImage->SetRegions( region );
   validCountImage->SetSpacing( spacing );
@@ -240,8 +403,8 @@ MeanAndSigmaImageBuilder< TInputImageType,
   validCountImage->Allocate();
   validCountImage->FillBuffer( 0 );
 
-  this->SetSumImage( sumImage );
-  this->SetSumSquareImage( sumSquareImage );
+  this->SetRunningMeanImage( meanImage );
+  this->SetSumOfSquaredDeviationsImage( m2Image );
   this->SetValidCountImage( validCountImage );
 
   // Set the new output parameters
@@ -266,51 +429,13 @@ MeanAndSigmaImageBuilder< TInputImageType,
     return;
     }
 
-  ProcessImagePointer sumImage        = this->GetSumImage();
-  ProcessImagePointer sumSquareImage  = this->GetSumSquareImage();
-  CountImagePointer   validImage      = this->GetValidCountImage();
-
-  typedef ResampleImageFilter< ProcessImageType, ProcessImageType >
-    ResampleProcessImageType;
-  typename ResampleProcessImageType::Pointer processFilter =
-                                             ResampleProcessImageType::New();
-
-  processFilter->SetInput( sumImage );
-  processFilter->SetSize( inputSize );
-  processFilter->SetOutputSpacing( sumImage->GetSpacing() );
-  processFilter->SetOutputOrigin( sumImage->GetOrigin() );
-  processFilter->Update();
-
-  this->SetSumImage( processFilter->GetOutput() );
-
-  typename ResampleProcessImageType::Pointer processFilter2 =
-                                             ResampleProcessImageType::New();
-  processFilter2->SetInput( sumSquareImage );
-  processFilter2->SetSize( inputSize );
-  // Keep all the spacing an origins constant for all images
-  // (so using only one to declare)
-  processFilter2->SetOutputSpacing( sumImage->GetSpacing() );
   // Keep all the spacing an origins constant for all images
-  // (so using only one to declare)
-  processFilter2->SetOutputOrigin( sumImage->GetOrigin() );
-  processFilter2->Update();
-  this->SetSumSquareImage( processFilter2->GetOutput() );
-
-
-  typedef ResampleImageFilter<CountImageType,CountImageType> ResampleCountImageType;
-  typename ResampleCountImageType::Pointer countFilter = ResampleCountImageType::New();
-
-  countFilter->SetInput( validImage );
-  countFilter->SetSize( inputSize );
-
-  // Keep all the spacing an origins constant for all images (so using only
-  // one to declare)
-  countFilter->SetOutputSpacing( sumImage->GetSpacing() );
-  // Keep all the spacing an origins constant for all images (so using only
-  // one to declare)
-  countFilter->SetOutputOrigin( sumImage->GetOrigin() );
-  countFilter->Update();
-  this->SetValidCountImage( countFilter->GetOutput() );
+  this->SetRunningMeanImage( this->ResizeImage(
+    this->GetRunningMeanImage(), inputSize ) );
+  this->SetSumOfSquaredDeviationsImage( this->ResizeImage(
+    this->GetSumOfSquaredDeviationsImage(), inputSize ) );
+  this->SetValidCountImage( this->ResizeImage(
+    this->GetValidCountImage(), inputSize ) );
 
   this->SetOutputSize( inputSize );
 }
@@ -27,6 +27,8 @@ limitations under the License.
 #include "itktubeMeanAndSigmaImageBuilder.h"
 #include "tubeMessage.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -36,10 +38,17 @@ namespace tube
 
 /** \class RobustMeanAndSigmaImageBuilder
  * \brief Class builds the median and robust variance from inputed images.
- * Images are processed and n/2 are kept to maintain the median calculation.
- * Therefore the number of images must be inputed prior to the start of the
- * image addition, as must be the number of outlier images to crop from the
- * ends.
+ * Images are processed and discarded as they are entered.  Each voxel keeps
+ * its NumberOfOutlierImagesToRemove lowest and highest values.
+ *
+ * The median is exact when the total number of images is at most
+ * MaximumNumberOfImagesForExactMedian: each voxel then keeps the lowest
+ * half of its values.  Larger cohorts use the five P-square markers of
+ * the median instead, so memory does not grow with the number of images,
+ * but the median is only an estimate once a voxel has more than five
+ * values.  The number of outlier images to crop from the ends, and
+ * whether the median is used, must be set prior to the start of the
+ * image addition.
  *
  * All Inputed images are assumed to have the same spacing, origin.
  * Optionally, if the tag DynamicallyAdjustOutputSize() is used, then the
@@ -83,15 +92,7 @@ public:
   typedef typename Superclass::SpacingType                  SpacingType;
   typedef typename Superclass::PointType                    PointType;
   typedef typename Superclass::SizeType                     SizeType;
-
-  /**
-   * Add an image to the group being summed. No check is made to insure
-   * the same image is not added twice
-   *
-   * It is assumed that the input image has the same spacing, origin & size
-   * (unless DynamicallyAdjustOutputSize() is set)
-   */
-  void AddImage( InputImagePointer );
+  typedef typename Superclass::TransformType                TransformType;
 
   /**
    * Must call this function to finish image additions and form the mean
@@ -114,15 +115,22 @@ public:
   itkSetMacro( NumberOfOutlierImagesToRemove, unsigned int );
 
   /**
-   * Function to define class to find the median image. Requires that the total
-   * number of images to be added to the form mean. Median will be returned using
-   * the GetOutputMeanImage() function.
+   * Function to define class to find the median image. Requires the total
+   * number of images to be added (any non-zero value enables the median).
+   * Median will be returned using the GetOutputMeanImage() function.
    */
   void UseMedianImage( unsigned int totalNumberOfImages )
     { m_TotalNumberOfImages = totalNumberOfImages; }
 
   itkGetConstMacro( TotalNumberOfImages, unsigned int );
 
+  /**
+   * Largest total number of images for which the median is exact.
+   * Larger cohorts use the P-square estimate.  Default is 32
+   */
+  itkSetMacro( MaximumNumberOfImagesForExactMedian, unsigned int );
+  itkGetConstMacro( MaximumNumberOfImagesForExactMedian, unsigned int );
+
   /**
    * Update the output images to the inputed size. Can be called at any
    * point during the mean building process.
@@ -148,7 +156,6 @@ protected:
   typedef typename Superclass::ProcessImagePointer      ProcessImagePointer;
   typedef typename Superclass::CountImagePointer        CountImagePointer;
 
-  typedef ImageRegionIterator<InputImageType>           InputIteratorType;
   typedef typename Superclass::InputConstIteratorType   InputConstIteratorType;
   typedef typename Superclass::ProcessConstIteratorType ProcessConstIteratorType;
   typedef typename Superclass::ProcessIteratorType      ProcessIteratorType;
@@ -158,71 +165,73 @@ protected:
   typedef typename Superclass::OutputSigmaIteratorType  OutputSigmaIteratorType;
 
   typedef typename std::vector<InputImagePointer>       InputImageListType;
+  typedef typename std::vector<ProcessImagePointer>     ProcessImageListType;
+  typedef typename std::vector<CountImagePointer>       CountImageListType;
 
   /**
-   * Build new processing images ( i.e., sumImage, sumSquareImage,
-   * validCountImage )
+   * Build new processing images ( i.e., runningMeanImage,
+   * sumOfSquaredDeviationsImage, validCountImage ) and the sketch images
    */
   void BuildProcessingImages( InputImagePointer i );
 
-  /**
-   * Get the ordered image list representing the lower half of voxel values.
-   * Used to determine median.  Order is ascending pixel value
-   */
-  InputImageListType& GetLowerOutlierImages( void )
-    { return m_LowerOutlierImages; }
+  /** Add a valid value to the voxel's sketch and running statistics */
+  void AccumulateValue( SizeValueType offset, InputPixelType value );
 
   /**
-   * Set the ordered image list representing the lower half of voxel values.
-   * Used to determine median.
+   * Keep the value if it is among the numberOfValues lowest (ascending)
+   * or highest (descending) values of the voxel's ordered list
    */
-  void  SetLowerOutlierImages( InputImageListType& list )
-    { m_LowerOutlierImages = list; }
+  void InsertOrderedValue( InputImageListType & list,
+                           SizeValueType offset,
+                           unsigned int numberOfValues,
+                           InputPixelType value,
+                           bool listIsAscending );
 
   /**
-   * Get the ordered image list representing the upper outlier values.
-   * Size is dependent on the number of outliers to remove for robust standard
-   * deviation calculation.  Used to determine sigma calculations. Order is
-   * descending starting from highest intensity
+   * Update the P-square median markers of a voxel with a value.
+   * numberOfValues is the number of values added before this one
    */
-  InputImageListType& GetUpperOutlierImages( void )
-    { return m_UpperOutlierImages; }
-
-  /**
-   * Set the ordered image list representing the upper outlier values.
-   * Size is dependent on the number of outliers to remove for robust standard
-   * deviation calculation. Used to determine sigma calculations. Order is
-   * descending starting from highest intensity
-   */
-  void SetUpperOutlierImages( InputImageListType& list )
-    { m_UpperOutlierImages = list; }
-
-  void SetUpperImages( InputImagePointer i );
-  void SetLowerImages( InputImagePointer i );
-  void SetMedianImages( InputImagePointer i );
-
-  InputImagePointer GetImageCopy( InputImagePointer );
-  InputImageListType& AddToUpdateImageList( InputImagePointer input,
-                                            InputImageListType& list,
-                                            bool ListIsAscending );
+  void InsertMedianValue( SizeValueType offset,
+                          unsigned int numberOfValues,
+                          InputPixelType value );
 
   bool UseMedian( void )
     { return ( m_TotalNumberOfImages > 0 ); }
 
+  bool UseExactMedian( void )
+    { return ( UseMedian() &&
+      m_TotalNumberOfImages <= m_MaximumNumberOfImagesForExactMedian ); }
+
   /**
-   * Builds median image from the LowerOutlierImages. Can only
-   * be (reasonably) called after at least 1 image has been added
+   * Builds median image from the lowest values or the median markers.
+   * Can only be (reasonably) called after at least 1 image has been added
    */
   OutputMeanImagePointer  GetMedianImage();
 
 
 private:
 
+  /** Per-voxel lowest values, ascending */
   InputImageListType                      m_LowerOutlierImages;
+
+  /** Per-voxel highest values, descending */
   InputImageListType                      m_UpperOutlierImages;
 
+  /** Per-voxel lowest half of the values, ascending, for the exact median */
+  InputImageListType                      m_MedianLowerImages;
+
+  /** Heights of the five P-square median markers */
+  ProcessImageListType                    m_MedianMarkerImages;
+
+  /**
+   * Positions of the three inner P-square markers; the outer markers
+   * are at the first and last positions
+   */
+  CountImageListType                      m_MedianPositionImages;
+
   unsigned int                            m_NumberOfOutlierImagesToRemove;
   unsigned int                            m_TotalNumberOfImages;
+  unsigned int                            m_MaximumNumberOfImagesForExactMedian;
 
 }; // End class RobustMeanAndSigmaImageBuilder
 
@@ -33,7 +33,8 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
                                 TOutputSigmaImageType >
 ::RobustMeanAndSigmaImageBuilder( void )
 : m_NumberOfOutlierImagesToRemove(0),
-  m_TotalNumberOfImages(0)
+  m_TotalNumberOfImages(0),
+  m_MaximumNumberOfImagesForExactMedian(32)
 {
 }
 
@@ -47,9 +48,10 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
 {
   Superclass::BuildProcessingImages( image );
 
-  InputImageListType  lowerImages = this->GetLowerOutlierImages();
-  InputImageListType  upperImages = this->GetUpperOutlierImages();
-
+  // The entries of the sketch images are only read once the voxel's valid
+  // count shows they have been written, so their initial values are unused
+  m_LowerOutlierImages.clear();
+  m_UpperOutlierImages.clear();
   for( unsigned int i = 0; i < this->GetNumberOfOutlierImagesToRemove(); i++ )
     {
     InputImagePointer lowerImage = InputImageType::New();
@@ -57,47 +59,64 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
     lowerImage->SetSpacing( image->GetSpacing() );
     lowerImage->SetOrigin( image->GetOrigin() );
     lowerImage->Allocate();
-    lowerImage->FillBuffer( NumericTraits<InputPixelType>::max() );
+    lowerImage->FillBuffer( 0 );
 
     InputImagePointer upperImage = InputImageType::New();
     upperImage->SetRegions( image->GetLargestPossibleRegion() );
     upperImage->SetSpacing( image->GetSpacing() );
     upperImage->SetOrigin( image->GetOrigin() );
     upperImage->Allocate();
-    upperImage->FillBuffer( NumericTraits<InputPixelType>::NonpositiveMin() );
+    upperImage->FillBuffer( 0 );
 
-    lowerImages.push_back( lowerImage );
-    upperImages.push_back( upperImage );
+    m_LowerOutlierImages.push_back( lowerImage );
+    m_UpperOutlierImages.push_back( upperImage );
     ::tube::FmtInfoMessage("Building outlier image %d!", i);
     }
 
-  // Add additional images to the lower outlier list if the median is used
-  if( UseMedian() )
+  m_MedianLowerImages.clear();
+  m_MedianMarkerImages.clear();
+  m_MedianPositionImages.clear();
+  if( UseExactMedian() )
     {
-    // Number of remaining images to add to lower group to insure that
-    // all possible median values are covered
-    unsigned int nTotal = this->GetTotalNumberOfImages();
-    unsigned int nOutliers = this->GetNumberOfOutlierImagesToRemove();
-    unsigned int remaining = ( nTotal / 2 ) + 1 - nOutliers;
-    ::tube::FmtInfoMessage("Images remaining to be built: %d!", remaining);
-
-    for( unsigned int i = 0; i < remaining; i++ )
+    // The median of up to TotalNumberOfImages values only involves the
+    // lowest half of them
+    for( unsigned int i = 0; i < m_TotalNumberOfImages / 2 + 1; i++ )
       {
       InputImagePointer lowerImage = InputImageType::New();
       lowerImage->SetRegions( image->GetLargestPossibleRegion() );
       lowerImage->SetSpacing( image->GetSpacing() );
       lowerImage->SetOrigin( image->GetOrigin() );
       lowerImage->Allocate();
-      lowerImage->FillBuffer( NumericTraits<InputPixelType>::max() );
+      lowerImage->FillBuffer( 0 );
 
-      lowerImages.push_back( lowerImage );
+      m_MedianLowerImages.push_back( lowerImage );
+      }
+    }
+  else if( UseMedian() )
+    {
+    for( unsigned int i = 0; i < 5; i++ )
+      {
+      ProcessImagePointer markerImage = ProcessImageType::New();
+      markerImage->SetRegions( image->GetLargestPossibleRegion() );
+      markerImage->SetSpacing( image->GetSpacing() );
+      markerImage->SetOrigin( image->GetOrigin() );
+      markerImage->Allocate();
+      markerImage->FillBuffer( 0 );
+
+      m_MedianMarkerImages.push_back( markerImage );
+      }
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      CountImagePointer positionImage = CountImageType::New();
+      positionImage->SetRegions( image->GetLargestPossibleRegion() );
+      positionImage->SetSpacing( image->GetSpacing() );
+      positionImage->SetOrigin( image->GetOrigin() );
+      positionImage->Allocate();
+      positionImage->FillBuffer( 0 );
+
+      m_MedianPositionImages.push_back( positionImage );
       }
     }
-  ::tube::FmtInfoMessage("This is the lower list size: %d",
-    lowerImages.size());
-
-  this->SetLowerOutlierImages( lowerImages );
-  this->SetUpperOutlierImages( upperImages );
 }
 
 template< class TInputImageType, class TOutputMeanImageType,
@@ -106,28 +125,33 @@ void
 RobustMeanAndSigmaImageBuilder< TInputImageType,
                                 TOutputMeanImageType,
                                 TOutputSigmaImageType >
-::AddImage( InputImagePointer i )
+::AccumulateValue( SizeValueType offset, InputPixelType value )
 {
-  // Add image to running total for the variance calculation
-  Superclass::AddImage( i );
+  const unsigned int numberOfValues = static_cast< unsigned int >(
+    this->GetValidCountImage()->GetBufferPointer()[offset] );
 
-  InputImagePointer medianCopy  = GetImageCopy( i );
-  InputImagePointer upperCopy   = GetImageCopy( i );
+  const unsigned int numberOfOutliers =
+    this->GetNumberOfOutlierImagesToRemove();
+  if( numberOfOutliers > 0 )
+    {
+    InsertOrderedValue( m_LowerOutlierImages, offset, numberOfValues, value,
+      true );
+    InsertOrderedValue( m_UpperOutlierImages, offset, numberOfValues, value,
+      false );
+    }
 
-  // Update the median image list
-  if( this->UseMedian() )
+  if( UseExactMedian() )
     {
-    // ** Update the lower half of the images
-    SetMedianImages( i );
+    InsertOrderedValue( m_MedianLowerImages, offset, numberOfValues, value,
+      true );
     }
-  else
+  else if( UseMedian() )
     {
-    // Update the lower outlying images
-    SetLowerImages( i );
+    InsertMedianValue( offset, numberOfValues, value );
     }
 
-  // Update the upper outlying images
-  SetUpperImages( i );
+  // Add value to running total for the variance calculation
+  Superclass::AccumulateValue( offset, value );
 }
 
 template< class TInputImageType, class TOutputMeanImageType,
@@ -136,14 +160,44 @@ void
 RobustMeanAndSigmaImageBuilder< TInputImageType,
                                 TOutputMeanImageType,
                                 TOutputSigmaImageType >
-::SetMedianImages( InputImagePointer i )
+::InsertOrderedValue( InputImageListType & list, SizeValueType offset,
+                      unsigned int numberOfValues, InputPixelType value,
+                      bool listIsAscending )
 {
-  // Get image copy, such that input pointer is not changed by fun
-  InputImagePointer image = GetImageCopy( i );
+  const unsigned int listSize = list.size();
 
-  bool isAscending = true;
-  AddToUpdateImageList( image, this->GetLowerOutlierImages(), isAscending );
+  // Append while the list is not full, otherwise replace the last entry
+  // if the value precedes it
+  unsigned int last;
+  if( numberOfValues < listSize )
+    {
+    last = numberOfValues;
+    }
+  else
+    {
+    last = listSize - 1;
+    InputPixelType tail = list[last]->GetBufferPointer()[offset];
+    if( ( listIsAscending && !( value < tail ) ) ||
+        ( !listIsAscending && !( value > tail ) ) )
+      {
+      return;
+      }
+    }
 
+  // Move the value towards the front of the list until it is in order
+  unsigned int i = last;
+  while( i > 0 )
+    {
+    InputPixelType prev = list[i-1]->GetBufferPointer()[offset];
+    if( ( listIsAscending && !( value < prev ) ) ||
+        ( !listIsAscending && !( value > prev ) ) )
+      {
+      break;
+      }
+    list[i]->GetBufferPointer()[offset] = prev;
+    --i;
+    }
+  list[i]->GetBufferPointer()[offset] = value;
 }
 
 template< class TInputImageType, class TOutputMeanImageType,
@@ -152,99 +206,108 @@ void
 RobustMeanAndSigmaImageBuilder< TInputImageType,
                                 TOutputMeanImageType,
                                 TOutputSigmaImageType >
-::SetLowerImages( InputImagePointer i )
-{
-  bool isAscending = true;
-  InputImagePointer image = GetImageCopy( i );
-  AddToUpdateImageList( image, this->GetLowerOutlierImages(), isAscending );
-}
-
-template< class TInputImageType, class TOutputMeanImageType,
-          class TOutputSigmaImageType >
-void
-RobustMeanAndSigmaImageBuilder< TInputImageType,
-                                TOutputMeanImageType,
-                                TOutputSigmaImageType>
-::SetUpperImages( InputImagePointer i )
+::InsertMedianValue( SizeValueType offset, unsigned int numberOfValues,
+                     InputPixelType value )
 {
-  bool isAscending = false;
-  InputImagePointer image = GetImageCopy( i );
-  AddToUpdateImageList( image, this->GetUpperOutlierImages(), isAscending );
-
-}
+  ProcessPixelType q[5];
+  for( unsigned int i = 0; i < 5; i++ )
+    {
+    q[i] = m_MedianMarkerImages[i]->GetBufferPointer()[offset];
+    }
 
-template< class TInputImageType, class TOutputMeanImageType,
-          class TOutputSigmaImageType >
-typename RobustMeanAndSigmaImageBuilder< TInputImageType,
-                                         TOutputMeanImageType,
-                                         TOutputSigmaImageType >::InputImageListType&
-RobustMeanAndSigmaImageBuilder< TInputImageType,
-                                TOutputMeanImageType,
-                                TOutputSigmaImageType >
-::AddToUpdateImageList( InputImagePointer input, InputImageListType& list,
-                        bool ListIsAscending )
-{
-  // List is filled from front to back and is assumed to be in ascending order
-  InputIteratorType  it_input( input, input->GetLargestPossibleRegion() );
-  for( int i = 0; i < list.size(); i ++ )
+  // The first five values are kept exactly, in ascending order
+  if( numberOfValues < 5 )
     {
-    InputIteratorType  it_list( list[i], list[i]->GetLargestPossibleRegion() );
+    unsigned int i = numberOfValues;
+    while( i > 0 && q[i-1] > value )
+      {
+      m_MedianMarkerImages[i]->GetBufferPointer()[offset] = q[i-1];
+      --i;
+      }
+    m_MedianMarkerImages[i]->GetBufferPointer()[offset] = value;
 
-    it_input.GoToBegin();
-    it_list.GoToBegin();
-    while( !it_list.IsAtEnd() && !it_input.IsAtEnd() )
+    if( numberOfValues == 4 )
       {
-      // Do not count a pixel if the user requests to threshold and the pixel
-      // is below the threshold
-      if( this->GetThresholdInputImageBelowOn() &&
-          it_input.Get() <= this->GetThresholdInputImageBelow() )
+      for( unsigned int j = 0; j < 3; j++ )
         {
-        // Do nothing for this pixel ( should not be included in calcualations
-        // ( same as itkMeanAndSigmaImageBuilder )
+        m_MedianPositionImages[j]->GetBufferPointer()[offset] = j + 2;
         }
-      /* List is ascending & the input value is less than list swap, and vice versa */
-      else if( ( ListIsAscending && it_input.Get() < it_list.Get() ) ||
-                  ( !ListIsAscending && it_input.Get() > it_list.Get() ) )
-        {
-        // Swap the values and continue
-        InputPixelType tmp = it_list.Get();
-        it_list.Set( it_input.Get() );
-        it_input.Set( tmp );
-        }
-      ++it_input;
-      ++it_list;
       }
+    return;
     }
-  return list;
-}
 
-template< class TInputImageType, class TOutputMeanImageType,
-          class TOutputSigmaImageType >
-typename RobustMeanAndSigmaImageBuilder< TInputImageType,
-                                         TOutputMeanImageType,
-                                        TOutputSigmaImageType >::InputImagePointer
-RobustMeanAndSigmaImageBuilder< TInputImageType,
-                                TOutputMeanImageType,
-                                TOutputSigmaImageType >
-::GetImageCopy( InputImagePointer input )
-{
-  InputImagePointer copy = InputImageType::New();
-  copy->SetRegions( input->GetLargestPossibleRegion() );
-  copy->SetSpacing( input->GetSpacing() );
-  copy->SetOrigin( input->GetOrigin() );
-  copy->Allocate();
+  // P-square update (Jain and Chlamtac, 1985) of the markers at the
+  // minimum, quartiles, median and maximum
+  double n[5];
+  n[0] = 1;
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    n[i+1] = m_MedianPositionImages[i]->GetBufferPointer()[offset];
+    }
+  n[4] = numberOfValues;
 
-  InputConstIteratorType it_input( input, input->GetLargestPossibleRegion() );
-  InputIteratorType it_copy( copy, copy->GetLargestPossibleRegion() );
+  unsigned int k;
+  if( value < q[0] )
+    {
+    q[0] = value;
+    k = 0;
+    }
+  else if( value < q[1] )
+    {
+    k = 0;
+    }
+  else if( value < q[2] )
+    {
+    k = 1;
+    }
+  else if( value < q[3] )
+    {
+    k = 2;
+    }
+  else if( value <= q[4] )
+    {
+    k = 3;
+    }
+  else
+    {
+    q[4] = value;
+    k = 3;
+    }
+  for( unsigned int i = k + 1; i < 5; i++ )
+    {
+    n[i] += 1;
+    }
 
-  while( !it_input.IsAtEnd() )
+  const double total = numberOfValues + 1;
+  for( unsigned int i = 1; i < 4; i++ )
     {
-    it_copy.Set( it_input.Get() );
+    const double desired = 1 + ( total - 1 ) * i / 4.0;
+    const double d = desired - n[i];
+    if( ( d >= 1 && n[i+1] - n[i] > 1 ) ||
+        ( d <= -1 && n[i-1] - n[i] < -1 ) )
+      {
+      const int s = ( d > 0 ) ? 1 : -1;
+      double qp = q[i] + s / ( n[i+1] - n[i-1] ) *
+        ( ( n[i] - n[i-1] + s ) * ( q[i+1] - q[i] ) / ( n[i+1] - n[i] ) +
+          ( n[i+1] - n[i] - s ) * ( q[i] - q[i-1] ) / ( n[i] - n[i-1] ) );
+      if( !( q[i-1] < qp && qp < q[i+1] ) )
+        {
+        // Fall back to linear prediction
+        qp = q[i] + s * ( q[i+s] - q[i] ) / ( n[i+s] - n[i] );
+        }
+      q[i] = qp;
+      n[i] += s;
+      }
+    }
 
-    ++it_input;
-    ++it_copy;
+  for( unsigned int i = 0; i < 5; i++ )
+    {
+    m_MedianMarkerImages[i]->GetBufferPointer()[offset] = q[i];
+    }
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    m_MedianPositionImages[i]->GetBufferPointer()[offset] = n[i+1];
     }
-  return copy;
 }
 
 template< class TInputImageType, class TOutputMeanImageType,
@@ -261,68 +324,44 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
     return;
     }
 
-  InputImageListType  lowInputs   = this->GetLowerOutlierImages();
-  InputImageListType  highInputs  = this->GetUpperOutlierImages();
-
-  ProcessImagePointer sumImage        = this->GetSumImage();
-  ProcessImagePointer sumSquareImage  = this->GetSumSquareImage();
-  CountImagePointer   validImages     = this->GetValidCountImage();
+  // The median uses all values, so it is formed before the outliers are
+  // removed from the running statistics
+  OutputMeanImagePointer medianImage;
+  if( UseMedian() )
+    {
+    medianImage = this->GetMedianImage();
+    }
 
-  // Output region is defined by the size of the images (i.e., the largest
-  // possible region)
-  ProcessIteratorType it_sum( sumImage,
-                              sumImage->GetLargestPossibleRegion() );
-  ProcessIteratorType it_sumSqr( sumSquareImage,
-                                 sumSquareImage->GetLargestPossibleRegion() );
-  CountIteratorType   it_valid( validImages,
-                                validImages->GetLargestPossibleRegion() );
+  CountImagePointer validImages = this->GetValidCountImage();
+  const CountPixelType * valid = validImages->GetBufferPointer();
+  const SizeValueType numberOfVoxels =
+    validImages->GetLargestPossibleRegion().GetNumberOfPixels();
 
   unsigned int outlierImage = this->GetNumberOfOutlierImagesToRemove();
   for( unsigned int i = 0; i < outlierImage; i++ )
     {
-    it_sum.GoToBegin();
-    it_sumSqr.GoToBegin();
-    it_valid.GoToBegin();
-
-    InputConstIteratorType it_lowInput( lowInputs[i],
-                                        lowInputs[i]->GetLargestPossibleRegion() );
-    InputConstIteratorType it_highInput( highInputs[i],
-                                         highInputs[i]->GetLargestPossibleRegion() );
-
-    while( !it_lowInput.IsAtEnd() )
+    const InputPixelType * low = m_LowerOutlierImages[i]->GetBufferPointer();
+    const InputPixelType * high = m_UpperOutlierImages[i]->GetBufferPointer();
+    for( SizeValueType v = 0; v < numberOfVoxels; v++ )
       {
-      if( it_valid.Get() > 2*outlierImage )
+      if( valid[v] > 2*outlierImage )
         {
-        ProcessPixelType  sumValue    = it_lowInput.Get() + it_highInput.Get();
-        ProcessPixelType  sumSqrValue = it_lowInput.Get()*it_lowInput.Get() +
-                                        it_highInput.Get()*it_highInput.Get();
-
-        it_sum.Set( it_sum.Get() - sumValue );
-        it_sumSqr.Set( it_sumSqr.Get() - sumSqrValue );
-        it_valid.Set( it_valid.Get() - 2 );
+        this->RemoveValue( v, low[v] );
+        this->RemoveValue( v, high[v] );
         }
-
-      ++it_lowInput;
-      ++it_highInput;
-      ++it_sum;
-      ++it_sumSqr;
-      ++it_valid;
       }
     }
-  SetSumImage( sumImage );
-  SetSumSquareImage( sumSquareImage );
-  SetValidCountImage( validImages );
 
   // Run the finalization using the superclass (NOTE: Must occur AFTER the
-  // subtraction of the outlier images from the summed images)
+  // removal of the outlier values from the running statistics)
   Superclass::FinalizeOutput();
 
   // NOTE: Must occur after the Superclass call to FinalizeOutput() --
   // Otherwise Median will be overwritten by mean
   if( UseMedian() )
     {
-    // Build the median image and replace the mean with the median
-    SetOutputMeanImage( this->GetMedianImage() );
+    // Replace the mean with the median
+    this->SetOutputMeanImage( medianImage );
     }
 }
 
@@ -337,59 +376,59 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
                                 TOutputSigmaImageType>
 ::GetMedianImage( void )
 {
-  unsigned int totalNumImages = this->GetTotalNumberOfImages();
-  InputImageListType lowerImages = this->GetLowerOutlierImages();
-
-  unsigned int numImages = totalNumImages/2;
-  typename InputImageType::ConstPointer lastLowerImage = lowerImages[numImages];
+  CountImagePointer validImages = this->GetValidCountImage();
 
   // Build output median image
   OutputMeanImagePointer medianImage = OutputMeanImageType::New();
-  medianImage->SetRegions( lastLowerImage->GetLargestPossibleRegion() );
-  medianImage->SetSpacing( lastLowerImage->GetSpacing() );
-  medianImage->SetOrigin( lastLowerImage->GetOrigin() );
+  medianImage->SetRegions( validImages->GetLargestPossibleRegion() );
+  medianImage->SetSpacing( validImages->GetSpacing() );
+  medianImage->SetOrigin( validImages->GetOrigin() );
   medianImage->Allocate();
 
-  OutputMeanIteratorType it_median( medianImage,
-                                    medianImage->GetLargestPossibleRegion() );
-  // Odd number
-  if( (totalNumImages % 2) )
-    {
-
-    InputConstIteratorType it_middle( lastLowerImage,
-                                      lastLowerImage->GetLargestPossibleRegion() );
-    it_middle.GoToBegin();
-    it_median.GoToBegin();
+  const CountPixelType * valid = validImages->GetBufferPointer();
+  OutputMeanPixelType * median = medianImage->GetBufferPointer();
+  const SizeValueType numberOfVoxels =
+    validImages->GetLargestPossibleRegion().GetNumberOfPixels();
 
-    while( !it_middle.IsAtEnd() )
+  for( SizeValueType v = 0; v < numberOfVoxels; v++ )
+    {
+    const unsigned int numberOfValues =
+      static_cast< unsigned int >( valid[v] );
+    if( numberOfValues == 0 )
       {
-      it_median.Set( it_middle.Get() );
-      ++it_middle;
-      ++it_median;
+      median[v] = 0;
       }
-    }
-  // Even number
-  else
-    {
-    InputConstIteratorType it_middle1( lastLowerImage,
-                                       lastLowerImage->GetLargestPossibleRegion() );
-    typename InputImageType::ConstPointer prevLowerImage = lowerImages[numImages - 1];
-    InputConstIteratorType it_middle2( prevLowerImage,
-                                       prevLowerImage->GetLargestPossibleRegion() );
-
-    it_middle1.GoToBegin();
-    it_middle2.GoToBegin();
-    it_median.GoToBegin();
-    while( !it_middle1.IsAtEnd() && !it_middle2.IsAtEnd() )
+    else if( !m_MedianLowerImages.empty() )
+      {
+      // Middle values of the ascending list; if more images were added
+      // than announced, only the kept values are used
+      const unsigned int last = m_MedianLowerImages.size() - 1;
+      const unsigned int lower = std::min( ( numberOfValues - 1 ) / 2,
+        last );
+      const unsigned int upper = std::min( numberOfValues / 2, last );
+      median[v] = static_cast< OutputMeanPixelType >(
+        ( static_cast< ProcessPixelType >(
+            m_MedianLowerImages[lower]->GetBufferPointer()[v] ) +
+          m_MedianLowerImages[upper]->GetBufferPointer()[v] ) / 2 );
+      }
+    else if( numberOfValues > 5 )
       {
-      // Average the values
-      OutputMeanPixelType median =  ( double(it_middle1.Get()) +
-                                      double(it_middle2.Get()) ) / 2;
-      it_median.Set( median );
-
-      ++it_middle1;
-      ++it_middle2;
-      ++it_median;
+      median[v] = static_cast< OutputMeanPixelType >(
+        m_MedianMarkerImages[2]->GetBufferPointer()[v] );
+      }
+    // Odd number of exactly kept values
+    else if( numberOfValues % 2 )
+      {
+      median[v] = static_cast< OutputMeanPixelType >(
+        m_MedianMarkerImages[numberOfValues/2]->GetBufferPointer()[v] );
+      }
+    // Even number: average the values
+    else
+      {
+      median[v] = static_cast< OutputMeanPixelType >(
+        ( m_MedianMarkerImages[numberOfValues/2-1]->GetBufferPointer()[v] +
+          m_MedianMarkerImages[numberOfValues/2]->GetBufferPointer()[v] )
+        / 2 );
       }
     }
   return medianImage;
@@ -411,36 +450,27 @@ RobustMeanAndSigmaImageBuilder< TInputImageType,
 
   Superclass::UpdateOutputImageSize( inputSize );
 
-  typedef ResampleImageFilter<InputImageType, InputImageType> ResampleInputImageType;
-
-  InputImageListType  lowerList = this->GetLowerOutlierImages();
-
-  typename InputImageListType::const_iterator  it_lower = lowerList.begin();
-  while( it_lower != lowerList.end() )
+  for( unsigned int i = 0; i < m_LowerOutlierImages.size(); i++ )
     {
-    typename ResampleInputImageType::Pointer filter = ResampleInputImageType::New();
-    filter->SetInput( *it_lower );
-    filter->SetSize( inputSize );
-    filter->SetOutputSpacing( (*it_lower)->GetSpacing() );
-    filter->SetOutputOrigin( (*it_lower)->GetOrigin() );
-    filter->Update();
-
-    ++it_lower;
+    m_LowerOutlierImages[i] = this->ResizeImage(
+      m_LowerOutlierImages[i].GetPointer(), inputSize );
+    m_UpperOutlierImages[i] = this->ResizeImage(
+      m_UpperOutlierImages[i].GetPointer(), inputSize );
     }
-
-  InputImageListType  upperList = this->GetUpperOutlierImages();
-
-  typename InputImageListType::const_iterator  it_upper = upperList.begin();
-  while( it_upper != upperList.end() )
+  for( unsigned int i = 0; i < m_MedianLowerImages.size(); i++ )
     {
-    typename ResampleInputImageType::Pointer filter = ResampleInputImageType::New();
-    filter->SetInput( *it_upper );
-    filter->SetSize( inputSize );
-    filter->SetOutputSpacing( (*it_upper)->GetSpacing() );
-    filter->SetOutputOrigin( (*it_upper)->GetOrigin() );
-    filter->Update();
-
-    ++it_upper;
+    m_MedianLowerImages[i] = this->ResizeImage(
+      m_MedianLowerImages[i].GetPointer(), inputSize );
+    }
+  for( unsigned int i = 0; i < m_MedianMarkerImages.size(); i++ )
+    {
+    m_MedianMarkerImages[i] = this->ResizeImage(
+      m_MedianMarkerImages[i].GetPointer(), inputSize );
+    }
+  for( unsigned int i = 0; i < m_MedianPositionImages.size(); i++ )
+    {
+    m_MedianPositionImages[i] = this->ResizeImage(
+      m_MedianPositionImages[i].GetPointer(), inputSize );
     }
 }
 
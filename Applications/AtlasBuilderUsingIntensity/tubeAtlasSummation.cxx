@@ -46,6 +46,8 @@ AtlasSummation
 
   m_ImageCountThreshold = 1; // Must be > than 0.
 
+  m_MeanBuilder->SetDefaultPixelValue( DEFAULT_PIXEL_FILL );
+
   m_ImageNumber = 0;
   m_NumOfImages  = 0;  // Variable used for median calculations
   m_MedianDefaultPixelValue = itk::NumericTraits<InputPixelType>::max();
@@ -70,7 +72,6 @@ void AtlasSummation
 void AtlasSummation
 ::AddImage( InputImageType::Pointer image, TransformType::Pointer t )
 {
-  InputImageType::Pointer image2 = image;
   if( m_AdjustResampledImageSize || m_AdjustResampledImageOrigin )
     {
     // Form the clipped image and update the base image if necessary
@@ -92,12 +93,10 @@ void AtlasSummation
       m_MeanBuilder->UpdateOutputImageSize( inputSize );
       }
 
+    // Resample onto the mean grid while adding the image
     TransformPointer identity = TransformType::New();
     identity->SetIdentity();
-    image2 = TransformInputImage( image, identity,
-      m_MeanBuilder->GetOutputSize(),
-      m_MeanBuilder->GetOutputSpacing(),
-      m_MeanBuilder->GetOutputOrigin() );
+    m_MeanBuilder->AddImage( image, identity.GetPointer() );
     }
   else // No adjustments or resampling
     {
@@ -111,48 +110,19 @@ void AtlasSummation
       }
     else
       {
-      image2 = TransformInputImage( image, t,
-        m_MeanBuilder->GetOutputSize(),
-        m_MeanBuilder->GetOutputSpacing(),
-        m_MeanBuilder->GetOutputOrigin() );
+      // Realign image to the base Image specifications while adding it.
+      // Resampling needs a FIXED -> MOVING image transform, so the
+      // inverse of the transform gives the desired result
+      TransformType::Pointer inverse = TransformType::New();
+      t->GetInverse(inverse);
+      m_MeanBuilder->AddImage( image, inverse.GetPointer() );
       }
     }
 
-  m_MeanBuilder->AddImage( image2 );
   ++m_ImageNumber;
 }
 
 
-AtlasSummation::InputImagePointer AtlasSummation
-::TransformInputImage( InputImagePointer image,
-                       TransformPointer trans,
-                       SizeType size,
-                       SpacingType spacing,
-                       PointType origin )
-{
-  // Realign image to the base Image specifications. If no adjustments
-  // are done to the image, then add the transform to the filter as well
-  typedef itk::ResampleImageFilter< InputImageType, InputImageType >
-               ResampleFilterType;
-
-  ResampleFilterType::Pointer transfilter = ResampleFilterType::New();
-  transfilter->SetInput( image );
-  transfilter->SetOutputSpacing( spacing );
-  transfilter->SetSize( size );
-  transfilter->SetOutputOrigin( origin );
-  transfilter->SetDefaultPixelValue( DEFAULT_PIXEL_FILL );
-
-  // For resampling, we need to use the inverse of the transform to get
-  // the desired result. Resample needs a FIXED -> MOVING image transform
-  TransformType::Pointer inverse = TransformType::New();
-  trans->GetInverse(inverse);
-  transfilter->SetTransform(inverse);
-  transfilter->Update();
-
-  return transfilter->GetOutput();
-}
-
-
 void AtlasSummation
 ::Start( InputImageType::Pointer )
 {
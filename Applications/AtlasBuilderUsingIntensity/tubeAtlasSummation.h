@@ -86,7 +86,7 @@ private:
 
   typedef std::vector<InputImagePointer>                  MedianImageListType;
 
-  typedef itk::tube::MeanAndSigmaImageBuilder<
+  typedef itk::tube::RobustMeanAndSigmaImageBuilder<
     InputImageType, MeanImageType, VarianceImageType >    RobustMeanBuilderType;
 
 public:
@@ -180,11 +180,36 @@ public:
    * Note: Needs to be called BEFORE adding the first image!!!
    */
   void UseMedian( unsigned int numOfImages )
-    { m_NumOfImages = numOfImages; }
+    {
+    m_NumOfImages = numOfImages;
+    m_MeanBuilder->UseMedianImage( numOfImages );
+    }
 
   bool UseMedian( void ) const
     { return (m_NumOfImages > 0); }
 
+  /**
+   * Set the largest number of images for which the median is exact;
+   * larger cohorts use an estimate.
+   * Note: Needs to be called BEFORE adding the first image!!!
+   */
+  void SetMaximumNumberOfImagesForExactMedian( unsigned int numOfImages )
+    { m_MeanBuilder->SetMaximumNumberOfImagesForExactMedian( numOfImages ); }
+
+  unsigned int GetMaximumNumberOfImagesForExactMedian( void ) const
+    { return m_MeanBuilder->GetMaximumNumberOfImagesForExactMedian(); }
+
+  /**
+   * Set the number of lowest and of highest values of each voxel that are
+   * excluded from the mean and variance;
+   * Note: Needs to be called BEFORE adding the first image!!!
+   */
+  void SetNumberOfOutlierImagesToRemove( unsigned int numOfOutliers )
+    { m_MeanBuilder->SetNumberOfOutlierImagesToRemove( numOfOutliers ); }
+
+  unsigned int GetNumberOfOutlierImagesToRemove( void ) const
+    { return m_MeanBuilder->GetNumberOfOutlierImagesToRemove(); }
+
   /**
    * Adjust all the resampled images origins and size (if not already defined)
    * so that no elements are cut off due to transforming & resampling the image
@@ -229,13 +254,6 @@ private:
    */
   bool UpdateOutputSizeParameter( SizeType& inputSize );
 
-  /** Resample the given image with transform & parameters */
-  InputImagePointer TransformInputImage( InputImagePointer image,
-                                         TransformPointer trans,
-                                         SizeType size,
-                                         SpacingType spacing,
-                                         PointType origin );
-
   void Start( InputImageType::Pointer );
   void SumImage( InputImageType::Pointer );
   void WriteImage( MeanImageType::Pointer, const std::string & );
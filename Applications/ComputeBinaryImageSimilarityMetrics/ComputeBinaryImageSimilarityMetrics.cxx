@@ -49,39 +49,27 @@ int DoIt( int argc, char * argv[] )
   reader1->SetFileName( inputVolume1.c_str() );
   reader2->SetFileName( inputVolume2.c_str() );
 
-  try
-    {
-    reader1->Update();
-    }
-  catch( itk::ExceptionObject & err )
-    {
-    std::cerr << "ExceptionObject caught, image reader 1 !" << std::endl;
-    std::cerr << err << std::endl;
-    return EXIT_FAILURE;
-    }
+  // The readers are updated by the metric filter, a slab at a time when
+  //   streaming.
+  typedef itk::tube::LabelOverlapMeasuresImageFilter< ImageType >
+    MetricFilterType;
+
+  typename MetricFilterType::Pointer metric = MetricFilterType::New();
+  metric->SetSourceImage( reader1->GetOutput() );
+  metric->SetTargetImage( reader2->GetOutput() );
+  metric->SetNumberOfStreamDivisions( streamDivisions );
 
   try
     {
-    reader2->Update();
+    metric->Update();
     }
   catch( itk::ExceptionObject & err )
     {
-    std::cerr << "ExceptionObject caught, image reader2 !" << std::endl;
+    std::cerr << "ExceptionObject caught, computing metrics !" << std::endl;
     std::cerr << err << std::endl;
     return EXIT_FAILURE;
     }
 
-  typename ImageType::Pointer image1 = reader1->GetOutput();
-  typename ImageType::Pointer image2 = reader2->GetOutput();
-
-  typedef itk::tube::LabelOverlapMeasuresImageFilter< ImageType >
-    MetricFilterType;
-
-  typename MetricFilterType::Pointer metric = MetricFilterType::New();
-  metric->SetSourceImage( image1 );
-  metric->SetTargetImage( image2 );
-  metric->Update();
-
   if( resultsFile.size() == 0 )
     {
     std::cout << "Total Overlap = " << metric->GetTotalOverlap()
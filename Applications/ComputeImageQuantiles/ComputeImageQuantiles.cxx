@@ -21,42 +21,37 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeImageQuantileCalculator.h"
 #include "tubeMessage.h"
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/p_square_quantile.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
-#include <boost/foreach.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 #include <itkImageFileReader.h>
 #include <itkImageRegionConstIterator.h>
-#include <itkStatisticsImageFilter.h>
 
 #include "ComputeImageQuantilesCLP.h"
 
 enum { Dimension = 3 };
 
-//using namespace boost;
-using namespace boost::accumulators;
-
 typedef itk::Image< float, Dimension >                      ImageType;
-typedef ImageType::IndexType                                ImageIndexType;
 typedef ImageType::PixelType                                ImagePixelType;
-typedef ImageType::SizeType                                 ImageSizeType;
 typedef itk::ImageFileReader< ImageType >                   ImageReaderType;
-typedef itk::StatisticsImageFilter< ImageType >             StatisticsImageFilterType;
-typedef accumulator_set< ImagePixelType,
-                         stats< tag::p_square_quantile > >  QuantileAccumulatorType;
-typedef itk::ImageRegionConstIterator<ImageType>            ImageIteratorType;
+typedef itk::tube::ImageQuantileCalculator< ImageType >     QuantileCalculatorType;
+typedef boost::accumulators::accumulator_set< ImagePixelType,
+  boost::accumulators::stats<
+    boost::accumulators::tag::p_square_quantile > >         QuantileAccumulatorType;
+typedef itk::ImageRegionConstIterator< ImageType >          ImageIteratorType;
 
 
 /**
- * Take an image and compute a collection of pixel/voxel quantiles
- * using the BOOST accumulators. The function uses P^2 quantile
- * computation which gives an approximate quantile and is very
- * efficient in terms of storage and runtime complexity. The values
- * are actually never stored.
+ * Take an image and compute a collection of pixel/voxel quantiles.
+ * The quantiles are exact: per-thread histograms locate the bins that
+ * hold the requested ranks and only the voxels of those bins are kept
+ * for the final selection. If a desired quantile is not within [0,1],
+ * throw an exception.
  */
 void computeQuantiles( ImageType::Pointer image,
                        const std::vector<float> & quantiles,
@@ -64,52 +59,78 @@ void computeQuantiles( ImageType::Pointer image,
 {
   assert(quantileValues.empty());
 
-  // Create a and configure a vector of length N of pointers
-  // to BOOST accumulators -- Each of the N accumulators will
-  // estimate exactly one of the given N desired quantile. If
-  // the desired quantile is not within (0,1), throw an exception.
-  std::vector<QuantileAccumulatorType *> accVec;
-  BOOST_FOREACH(float q, quantiles)
+  QuantileCalculatorType::QuantileListType probabilities;
+  for( unsigned int i=0; i<quantiles.size(); ++i )
+    {
+    tube::FmtInfoMessage("Configure quantile = %.2f", quantiles[i]);
+    probabilities.push_back( quantiles[i] );
+    }
+
+  QuantileCalculatorType::Pointer calculator =
+    QuantileCalculatorType::New();
+  calculator->SetImage( image );
+  calculator->SetQuantiles( probabilities );
+  try
+    {
+    calculator->Compute();
+    }
+  catch( itk::ExceptionObject &ex )
+    {
+    tube::ErrorMessage( ex.GetDescription() );
+    throw std::exception();
+    }
+
+  for( unsigned int i=0; i<quantiles.size(); ++i )
+    {
+    quantileValues.push_back( static_cast< ImagePixelType >(
+      calculator->GetQuantileValues()[i] ) );
+    }
+}
+
+
+/**
+ * Take an image and estimate a collection of pixel/voxel quantiles
+ * using one BOOST P^2 accumulator per quantile. The estimates are
+ * approximate and the values are never stored. If a desired quantile
+ * is not within (0,1), throw an exception.
+ */
+void computeApproximateQuantiles( ImageType::Pointer image,
+                                  const std::vector<float> & quantiles,
+                                  std::vector<ImagePixelType> & quantileValues)
+{
+  assert(quantileValues.empty());
+
+  std::vector<QuantileAccumulatorType> accVec;
+  for( unsigned int i=0; i<quantiles.size(); ++i )
     {
-    if( q <= 0 || q >= 1 )
+    if( quantiles[i] <= 0 || quantiles[i] >= 1 )
       {
       tube::ErrorMessage("Check quantile range!");
       throw std::exception();
       }
-    tube::FmtInfoMessage("Configure accumulator for quantile = %.2f", q);
-
-    QuantileAccumulatorType *acc = new QuantileAccumulatorType(
-      quantile_probability = q);
-    accVec.push_back(acc);
+    tube::FmtInfoMessage("Configure accumulator for quantile = %.2f",
+      quantiles[i]);
+    accVec.push_back( QuantileAccumulatorType(
+      boost::accumulators::quantile_probability = quantiles[i] ) );
     }
 
-
-  // Use an image iterator to iterate over all pixel/voxel and
-  // and then add those values to all the accumulators. Adding
-  // the values will incrementally compute the quantile estimates.
   ImageIteratorType imIt( image, image->GetLargestPossibleRegion() );
   imIt.GoToBegin();
   while( !imIt.IsAtEnd() )
     {
     ImagePixelType p = imIt.Get();
-    BOOST_FOREACH( QuantileAccumulatorType *acc, accVec )
+    for( unsigned int i=0; i<accVec.size(); ++i )
       {
-      (*acc)( p );
+      accVec[i]( p );
       }
     ++imIt;
     }
 
-
-  // Finally, iterate over the accumulators, query the
-  // estimated quantiles and fill the output vector
-  BOOST_FOREACH( QuantileAccumulatorType *acc, accVec)
+  for( unsigned int i=0; i<accVec.size(); ++i )
     {
-    ImagePixelType qVal = p_square_quantile(*acc);
-    quantileValues.push_back(qVal);
-    delete acc;
-    acc = NULL;
+    quantileValues.push_back(
+      boost::accumulators::p_square_quantile( accVec[i] ) );
     }
-  return;
 }
 
 
@@ -209,7 +230,14 @@ int main( int argc, char * argv[] )
   std::vector<float> quantileValues;
    try
     {
-    computeQuantiles(im, quantiles, quantileValues);
+    if( approximate )
+      {
+      computeApproximateQuantiles(im, quantiles, quantileValues);
+      }
+    else
+      {
+      computeQuantiles(im, quantiles, quantileValues);
+      }
     if( outputPlainText )
       {
       writeQuantilesToTextFile( quantileValues, outFile );
@@ -27,10 +27,10 @@ limitations under the License.
 #include <itkImageToVectorImageFilter.h>
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
+#include <itkKdTreeGenerator.h>
+#include <itkListSample.h>
+#include <itkMultiThreader.h>
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/min.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -231,6 +231,191 @@ void CreateRenumberingMap( const std::set< TPixel > & in,
 }
 
 
+/** Paths of the distance map and region mask files of a region.
+ *
+ *  \param directory Directory of the distance map files
+ *  \param label Original segmentation ID of the region
+ *  \param mapFilePath Set to directory/NNNN-map.mha
+ *  \param prtFilePath Set to directory/NNNN-prt.mha
+ */
+template< typename TPixel >
+void GetDistanceMapFilePaths( const std::string & directory, TPixel label,
+                              boost::filesystem::path & mapFilePath,
+                              boost::filesystem::path & prtFilePath )
+{
+  std::stringstream mapFileName, prtFileName;
+  mapFileName << boost::format("%04i-map.mha") % label;
+  prtFileName << boost::format("%04i-prt.mha") % label;
+
+  boost::filesystem::path dir( directory.c_str() );
+  mapFilePath = dir / boost::filesystem::path( mapFileName.str().c_str() );
+  prtFilePath = dir / boost::filesystem::path( prtFileName.str().c_str() );
+}
+
+
+/** Shared state of the region-parallel signature computation.
+ *
+ *  Thread t handles the regions t, t + T, t + 2T, ... and fills their
+ *  columns of the signature matrix, so at most T nearest-neighbor trees
+ *  are alive at any time.
+ *
+ */
+template< class TPixel, unsigned int VImageDimension >
+struct RegionSignatureThreadStruct
+{
+  typedef itk::Image< TPixel, VImageDimension >         ImageType;
+  typedef std::vector< itk::SizeValueType >             OffsetVectorType;
+
+  const ImageType *                                     Image;
+  const std::vector< OffsetVectorType > *               SegBoundaries;
+  const std::vector< OffsetVectorType > *               CVTBoundaries;
+  const std::vector< boost::dynamic_bitset<> > *        CVTOverlaps;
+  const std::vector< typename ImageType::IndexType > *  CVTCenters;
+  const boost::dynamic_bitset<> *                       ExcludeRegions;
+  const boost::dynamic_bitset<> *                       LoadedRegions;
+  int                                                   SignatureSelector;
+  vnl_matrix< TPixel > *                                SignatureMatrix;
+};
+
+
+/** Voxel coordinates of a buffer offset.
+ *
+ *  Distances are measured in voxel units, as the per-region distance maps
+ *  are computed on images with unit spacing.
+ *
+ */
+template< class ImageT >
+itk::Vector< double, ImageT::ImageDimension > GetVoxelPoint(
+  const ImageT * image, itk::SizeValueType offset )
+{
+  typename ImageT::IndexType index = image->ComputeIndex( offset );
+
+  itk::Vector< double, ImageT::ImageDimension > point;
+  for( unsigned int d=0; d<ImageT::ImageDimension; ++d )
+    {
+    point[d] = index[d];
+    }
+  return point;
+}
+
+
+/** Compute the signature matrix columns of the regions of one thread.
+ *
+ *  The boundary voxels of each region are put in a k-d tree, and the
+ *  distance of a voxel outside the region is that of its nearest boundary
+ *  voxel, so distances are only evaluated at the CVT centers (or at the
+ *  boundary voxels of the CVT cells) instead of over the whole image.
+ *
+ */
+template< class TPixel, unsigned int VImageDimension >
+ITK_THREAD_RETURN_TYPE RegionSignatureThreaderCallback( void * arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct          ThreadInfoType;
+  typedef RegionSignatureThreadStruct< TPixel, VImageDimension >
+                                                        ThreadStructType;
+  typedef itk::Vector< double, VImageDimension >        PointType;
+  typedef itk::Statistics::ListSample< PointType >      SampleType;
+  typedef itk::Statistics::KdTreeGenerator< SampleType >
+                                                        TreeGeneratorType;
+  typedef typename TreeGeneratorType::KdTreeType        TreeType;
+
+  ThreadInfoType * info = static_cast< ThreadInfoType * >( arg );
+  ThreadStructType * str = static_cast< ThreadStructType * >(
+    info->UserData );
+
+  const unsigned int numberOfRegions = str->SegBoundaries->size();
+  const unsigned int numberOfCVTCells = str->SignatureMatrix->rows();
+
+  for( unsigned int r=info->ThreadID; r<numberOfRegions;
+    r+=info->NumberOfThreads )
+    {
+    const typename ThreadStructType::OffsetVectorType & boundary =
+      ( *str->SegBoundaries )[r];
+
+    // A region without boundary covers the image; its distances are zero.
+    // Columns of regions read from existing distance maps are already set.
+    if( ( *str->ExcludeRegions )[r] || ( *str->LoadedRegions )[r]
+      || boundary.empty() )
+      {
+      continue;
+      }
+
+    typename SampleType::Pointer sample = SampleType::New();
+    sample->SetMeasurementVectorSize( VImageDimension );
+    for( unsigned int i=0; i<boundary.size(); ++i )
+      {
+      sample->PushBack( GetVoxelPoint( str->Image, boundary[i] ) );
+      }
+
+    typename TreeGeneratorType::Pointer treeGenerator =
+      TreeGeneratorType::New();
+    treeGenerator->SetSample( sample );
+    treeGenerator->SetBucketSize( 16 );
+    treeGenerator->Update();
+    typename TreeType::Pointer tree = treeGenerator->GetOutput();
+
+    typename TreeType::InstanceIdentifierVectorType neighbors;
+
+    switch( str->SignatureSelector )
+      {
+      case SIGNATURE_CVT_CTR:
+        {
+        for( unsigned int c=0; c<numberOfCVTCells; ++c )
+          {
+          // Distance to c-th (i.e., c-th CVT cell) center
+          itk::SizeValueType offset = str->Image->ComputeOffset(
+            ( *str->CVTCenters )[c] );
+
+          double dist = 0;
+          if( str->Image->GetBufferPointer()[offset]
+            != static_cast< TPixel >( r ) )
+            {
+            PointType p = GetVoxelPoint( str->Image, offset );
+            tree->Search( p, 1u, neighbors );
+            dist = ( p - tree->GetMeasurementVector( neighbors[0] ) )
+              .GetNorm();
+            }
+          str->SignatureMatrix->put( c, r, static_cast< TPixel >( dist ) );
+          }
+        break;
+        }
+      case SIGNATURE_CVT_MIN:
+        {
+        for( unsigned int c=0; c<numberOfCVTCells; ++c )
+          {
+          // The minimum distance of a cell that does not overlap the
+          // region is attained at one of the cell's boundary voxels
+          double minDist = 0;
+          if( !( *str->CVTOverlaps )[c][r] )
+            {
+            const typename ThreadStructType::OffsetVectorType &
+              cellBoundary = ( *str->CVTBoundaries )[c];
+
+            minDist = itk::NumericTraits< double >::max();
+            for( unsigned int i=0; i<cellBoundary.size(); ++i )
+              {
+              PointType p = GetVoxelPoint( str->Image, cellBoundary[i] );
+              tree->Search( p, 1u, neighbors );
+              double dist = ( p - tree->GetMeasurementVector(
+                neighbors[0] ) ).GetNorm();
+              if( dist < minDist )
+                {
+                minDist = dist;
+                }
+              }
+            }
+          str->SignatureMatrix->put( c, r,
+            static_cast< TPixel >( minDist ) );
+          }
+        break;
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
 template< class TPixel, unsigned int VImageDimension >
 int DoIt( int argc, char **argv )
 {
@@ -249,11 +434,6 @@ int DoIt( int argc, char **argv )
   typedef itk::ImageRegionIteratorWithIndex< InputImageType >
                                                           ImageIteratorType;
 
-  typedef std::vector< typename InputImageType::IndexType >
-                                                          InputIndexVectorType;
-
-  typedef std::map< TPixel, InputIndexVectorType >        IdToIndexVectorType;
-
 
   // Read segmenation image and image of Central-Voronoi-Tesellation (CVT) cells
   typename InputImageType::Pointer  segImage, cvtImage;
@@ -378,20 +558,6 @@ int DoIt( int argc, char **argv )
                          segmentationRegionCounter,
                          "Size mismatch after seg. region renumbering" );
 
-  // Create a map of (artificial) segmentation IDs -> Vector of voxel indices
-  IdToIndexVectorType segToIndexVector;
-
-  segImageIt.GoToBegin();
-  while( !segImageIt.IsAtEnd() )
-    {
-    const typename InputImageType::IndexType &index = segImageIt.GetIndex( );
-    segToIndexVector[ fwdSegMapper[ segImageIt.Get() ] ].push_back( index );
-    ++segImageIt;
-    }
-
-  itkAssertOrThrowMacro( segToIndexVector.size() == segmentationRegions.size(),
-                         "Size mismatch after region -> index vector mapping" );
-
   // Map CVT cell IDs to (artificial) CVT cell IDs {0, ..., C-1}
   ImageIteratorType cvtImageIt( cvtImage,
                                 cvtImage->GetLargestPossibleRegion());
@@ -410,22 +576,6 @@ int DoIt( int argc, char **argv )
   itkAssertOrThrowMacro( fwdCVTMapper.size() == cvtCellSet.size(),
                          "Size mismatch after renumbering CVT cells" );
 
-  // Create a map of (artificial) CVT cell IDs -> Vector of voxel indices
-  IdToIndexVectorType cvtToIndexVector;
-
-  cvtImageIt.GoToBegin();
-  while( !cvtImageIt.IsAtEnd() )
-    {
-    TPixel id = cvtImageIt.Get();
-    cvtToIndexVector[ fwdCVTMapper[id] ].push_back( cvtImageIt.GetIndex() );
-    ++cvtImageIt;
-    }
-
-  TPixel largestKey = cvtToIndexVector.rbegin()->first;
-  itkAssertOrThrowMacro( (largestKey + 1)
-                         ==  static_cast< TPixel >( cvtToIndexVector.size() ),
-                         "Size mismatch after CVT to index vector mapping" );
-
   // Build index vector for exclusion regions
   boost::dynamic_bitset<> excludeRegions( segmentationRegions.size() );
   for( unsigned int e = 0; e < argExcludeRegions.size(); ++e )
@@ -438,81 +588,215 @@ int DoIt( int argc, char **argv )
     }
 
   // Create numberOfSegmentedRegions-dimensional distance signature vectors
-  unsigned int numberOfCVTCells = cvtToIndexVector.size();
+  unsigned int numberOfCVTCells = cvtCellSet.size();
   unsigned int numberOfSegmentedRegions = segmentationRegions.size();
 
   vnl_matrix< TPixel > signatureMatrix ( numberOfCVTCells,
-                                         numberOfSegmentedRegions );
+                                         numberOfSegmentedRegions, 0 );
+
+  // Replace the labels of both images by their (artificial) IDs in place.
+  // There are at most as many IDs as distinct pixel values, so they fit.
+  const typename InputImageType::SizeType imageSize =
+    segImage->GetLargestPossibleRegion().GetSize();
+  const itk::SizeValueType numberOfVoxels =
+    segImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  TPixel * segBuffer = segImage->GetBufferPointer();
+  TPixel * cvtBuffer = cvtImage->GetBufferPointer();
+
+  TPixel lastSegLabel = segBuffer[0];
+  TPixel lastSegID = static_cast< TPixel >( fwdSegMapper[ lastSegLabel ] );
+  TPixel lastCVTLabel = cvtBuffer[0];
+  TPixel lastCVTID = static_cast< TPixel >( fwdCVTMapper[ lastCVTLabel ] );
+  for( itk::SizeValueType v=0; v<numberOfVoxels; ++v )
+    {
+    if( segBuffer[v] != lastSegLabel )
+      {
+      lastSegLabel = segBuffer[v];
+      lastSegID = static_cast< TPixel >( fwdSegMapper[ lastSegLabel ] );
+      }
+    segBuffer[v] = lastSegID;
+    if( cvtBuffer[v] != lastCVTLabel )
+      {
+      lastCVTLabel = cvtBuffer[v];
+      lastCVTID = static_cast< TPixel >( fwdCVTMapper[ lastCVTLabel ] );
+      }
+    cvtBuffer[v] = lastCVTID;
+    }
 
-  typename IdToIndexVectorType::iterator mapIt = segToIndexVector.begin();
-  while( mapIt != segToIndexVector.end() )
+  // Single sweep over both label images: the voxels on the face boundary
+  // of each region and of each CVT cell.
+
+  itk::OffsetValueType strides[VImageDimension];
+  strides[0] = 1;
+  for( unsigned int d=1; d<VImageDimension; ++d )
     {
-    TPixel id = (*mapIt).first;
+    strides[d] = strides[d-1] * imageSize[d-1];
+    }
 
-    if( excludeRegions[id] )
+  typedef std::vector< itk::SizeValueType > OffsetVectorType;
+
+  const bool useCellBoundaries = ( argSignatureSelector == SIGNATURE_CVT_MIN );
+  std::vector< OffsetVectorType > segBoundaries( numberOfSegmentedRegions );
+  std::vector< OffsetVectorType > cvtBoundaries( numberOfCVTCells );
+  std::vector< boost::dynamic_bitset<> > cvtOverlaps;
+  if( useCellBoundaries )
+    {
+    cvtOverlaps.assign( numberOfCVTCells,
+      boost::dynamic_bitset<>( numberOfSegmentedRegions ) );
+    }
+
+  typename InputImageType::IndexType index;
+  index.Fill( 0 );
+  for( itk::SizeValueType v=0; v<numberOfVoxels; ++v )
+    {
+    bool isSegBoundary = false;
+    bool isCVTBoundary = false;
+    for( unsigned int d=0; d<VImageDimension; ++d )
       {
-      tube::FmtInfoMessage( "Exclude segmentation region %d (Orig: %d)",
-        id, invSegMapper[id] );
+      if( index[d] > 0 )
+        {
+        isSegBoundary |= ( segBuffer[v - strides[d]] != segBuffer[v] );
+        isCVTBoundary |= ( cvtBuffer[v - strides[d]] != cvtBuffer[v] );
+        }
+      if( index[d] + 1 < static_cast< itk::IndexValueType >( imageSize[d] ) )
+        {
+        isSegBoundary |= ( segBuffer[v + strides[d]] != segBuffer[v] );
+        isCVTBoundary |= ( cvtBuffer[v + strides[d]] != cvtBuffer[v] );
+        }
+      }
+    const unsigned int segID = static_cast< unsigned int >( segBuffer[v] );
+    const unsigned int cvtID = static_cast< unsigned int >( cvtBuffer[v] );
+    if( isSegBoundary )
+      {
+      segBoundaries[ segID ].push_back( v );
+      }
+    if( useCellBoundaries )
+      {
+      cvtOverlaps[ cvtID ][ segID ] = 1;
+      if( isCVTBoundary )
+        {
+        cvtBoundaries[ cvtID ].push_back( v );
+        }
+      }
 
-      ++mapIt;
-      continue;
+    for( unsigned int d=0; d<VImageDimension; ++d )
+      {
+      if( ++index[d] < static_cast< itk::IndexValueType >( imageSize[d] ) )
+        {
+        break;
+        }
+      index[d] = 0;
       }
+    }
 
-    std::stringstream mapFileName, prtFileName;
-    mapFileName << boost::format("%04i-map.mha") % invSegMapper[id];
-    prtFileName << boost::format("%04i-prt.mha") % invSegMapper[id];
+  // Regions with existing distance maps take their signatures from them
+  boost::dynamic_bitset<> loadedRegions( numberOfSegmentedRegions );
+  if( argLoadDistanceMaps )
+    {
+    for( unsigned int id=0; id<numberOfSegmentedRegions; ++id )
+      {
+      if( excludeRegions[id] )
+        {
+        continue;
+        }
 
-    boost::filesystem::path dir( argOutputDirectory.c_str() );
-    boost::filesystem::path mapFilePath ( mapFileName.str().c_str() );
-    boost::filesystem::path prtFilePath ( prtFileName.str().c_str() );
-    boost::filesystem::path fullMapFilePath = dir / mapFilePath;
-    boost::filesystem::path fullPrtFilePath = dir / prtFilePath;
+      boost::filesystem::path fullMapFilePath, fullPrtFilePath;
+      GetDistanceMapFilePaths( argOutputDirectory, invSegMapper[id],
+        fullMapFilePath, fullPrtFilePath );
+      if( !boost::filesystem::exists( fullPrtFilePath.string().c_str() ) ||
+          !boost::filesystem::exists( fullMapFilePath.string().c_str() ) )
+        {
+        continue;
+        }
 
-    typename OutputImageType::Pointer prtImage, mapImage;
-    if( boost::filesystem::exists( fullPrtFilePath.string().c_str() ) &&
-        boost::filesystem::exists( fullMapFilePath.string().c_str() ) )
-      // Try to load existing data ...
-      {
       tube::FmtInfoMessage( "Found %s and %s - Loading ...",
         fullPrtFilePath.string().c_str(),
         fullMapFilePath.string().c_str() );
 
-      typename InputReaderType::Pointer singlePrtReader = InputReaderType::New();
-      typename InputReaderType::Pointer singleMapReader = InputReaderType::New();
-      singlePrtReader->SetFileName( fullPrtFilePath.string().c_str() );
-      singleMapReader->SetFileName( fullMapFilePath.string().c_str() );
+      typename InputReaderType::Pointer mapReader = InputReaderType::New();
+      mapReader->SetFileName( fullMapFilePath.string().c_str() );
       try
         {
-        singlePrtReader->Update();
-        singleMapReader->Update();
+        mapReader->Update();
         }
       catch( itk::ExceptionObject & ex )
         {
         tube::ErrorMessage( ex.what() );
         return EXIT_FAILURE;
         }
-      mapImage = singleMapReader->GetOutput();
-      prtImage = singlePrtReader->GetOutput();
+      typename InputImageType::Pointer mapImage = mapReader->GetOutput();
+      if( mapImage->GetLargestPossibleRegion().GetSize() != imageSize )
+        {
+        tube::FmtErrorMessage( "%s does not match the segmentation size",
+          fullMapFilePath.string().c_str() );
+        return EXIT_FAILURE;
+        }
+
+      switch( argSignatureSelector )
+        {
+        case SIGNATURE_CVT_CTR:
+          {
+          for( unsigned int c=0; c<numberOfCVTCells; ++c )
+            {
+            signatureMatrix.put( c, id,
+              mapImage->GetPixel( cvtCentersIdx[c] ) );
+            }
+          break;
+          }
+        case SIGNATURE_CVT_MIN:
+          {
+          // Minimum over the voxels of each cell, in one pass
+          const TPixel * mapBuffer = mapImage->GetBufferPointer();
+          std::vector< TPixel > minDist( numberOfCVTCells,
+            itk::NumericTraits< TPixel >::max() );
+          for( itk::SizeValueType v=0; v<numberOfVoxels; ++v )
+            {
+            const unsigned int cvtID =
+              static_cast< unsigned int >( cvtBuffer[v] );
+            if( mapBuffer[v] < minDist[cvtID] )
+              {
+              minDist[cvtID] = mapBuffer[v];
+              }
+            }
+          for( unsigned int c=0; c<numberOfCVTCells; ++c )
+            {
+            signatureMatrix.put( c, id, minDist[c] );
+            }
+          break;
+          }
+        }
+      loadedRegions[id] = 1;
       }
-    else
-      // Otherwise, recompute distance maps ...
+    }
+
+  // The full per-region distance maps are only computed when requested
+  if( argWriteDistanceMaps )
+    {
+    for( unsigned int id=0; id<numberOfSegmentedRegions; ++id )
       {
-      tube::FmtInfoMessage( "Recomputing distance map for (original) seg. %d",
+      if( excludeRegions[id] || loadedRegions[id] )
+        {
+        continue;
+        }
+
+      tube::FmtInfoMessage( "Computing distance map for (original) seg. %d",
         invSegMapper[id] );
 
-      typename OutputImageType::Pointer outImage = OutputImageType::New();
+      boost::filesystem::path fullMapFilePath, fullPrtFilePath;
+      GetDistanceMapFilePaths( argOutputDirectory, invSegMapper[id],
+        fullMapFilePath, fullPrtFilePath );
 
-      CreateEmptyImage< OutputImageType >( outImage,
-        segImage->GetLargestPossibleRegion().GetSize() );
+      typename OutputImageType::Pointer outImage = OutputImageType::New();
 
-      itkAssertOrThrowMacro( segImage->GetLargestPossibleRegion().GetSize() ==
-                             outImage->GetLargestPossibleRegion().GetSize(),
-                             "Newly created output image differs in size" );
+      CreateEmptyImage< OutputImageType >( outImage, imageSize );
 
-      const InputIndexVectorType &indices = ( *mapIt ).second;
-      for( unsigned int v=0; v<indices.size(); ++v )
+      OutputPixelType * outBuffer = outImage->GetBufferPointer();
+      for( itk::SizeValueType v=0; v<numberOfVoxels; ++v )
         {
-        outImage->SetPixel( indices[v], 1 );
+        if( segBuffer[v] == static_cast< TPixel >( id ) )
+          {
+          outBuffer[v] = 1;
+          }
         }
 
       typedef typename itk::DanielssonDistanceMapImageFilter<
@@ -525,17 +809,14 @@ int DoIt( int argc, char **argv )
       distanceMap->SetInput( outImage );
       distanceMap->Update();
 
-      mapImage = distanceMap->GetDistanceMap();
-      prtImage = outImage;
-
       typename OutputWriterType::Pointer prtWriter = OutputWriterType::New( );
       prtWriter->SetFileName( fullPrtFilePath.string().c_str() );
-      prtWriter->SetInput( prtImage );
+      prtWriter->SetInput( outImage );
       prtWriter->SetUseCompression( true );
 
       typename OutputWriterType::Pointer mapWriter = OutputWriterType::New( );
       mapWriter->SetFileName( fullMapFilePath.string().c_str() );
-      mapWriter->SetInput( mapImage );
+      mapWriter->SetInput( distanceMap->GetDistanceMap() );
       mapWriter->SetUseCompression( true );
 
       try
@@ -549,58 +830,39 @@ int DoIt( int argc, char **argv )
         return EXIT_FAILURE;
         }
       }
+    }
 
-      switch( argSignatureSelector )
+  for( unsigned int id=0; id<numberOfSegmentedRegions; ++id )
+    {
+    if( excludeRegions[id] )
       {
-      case SIGNATURE_CVT_CTR:
-        {
-        for( unsigned int c=0; c<numberOfCVTCells; ++c )
-          {
-          // Distance to c-th (i.e., c-th CVT cell) center
-          TPixel dist = mapImage->GetPixel( cvtCentersIdx[c] );
-          signatureMatrix.put(c, id , dist);
-          }
-        break;
-        }
-      case SIGNATURE_CVT_MIN:
-        {
-        namespace acc = boost::accumulators;
-        typedef acc::stats< acc::tag::min >               StatsType;
-        typedef acc::accumulator_set< TPixel, StatsType > AccumulatorType;
-
-        typename IdToIndexVectorType::iterator cvtToIndexVectorIt =
-          cvtToIndexVector.begin();
-
-        while( cvtToIndexVectorIt != cvtToIndexVector.end() )
-          {
-          AccumulatorType cellAcc;
-
-          // Artificial CVT cell ID
-          TPixel cvtCell = ( *cvtToIndexVectorIt ).first;
-
-          const std::vector< typename InputImageType::IndexType > &
-            voxelIndices = ( *cvtToIndexVectorIt ).second;
-
-          // Add distances to accumulator to keep track of the minimum
-          for( unsigned int i=0; i<voxelIndices.size(); ++i )
-            {
-            TPixel dist = mapImage->GetPixel( voxelIndices[i] );
-            cellAcc( dist );
-            }
-
-          // Get the minimum distance to the current segment
-          TPixel minDist = acc::min( cellAcc );
-
-          // We need to map the original CVT cell ID to the artificial one
-          signatureMatrix.put( cvtCell, id, minDist );
-          ++cvtToIndexVectorIt;
-          }
-        break;
-        }
+      tube::FmtInfoMessage( "Exclude segmentation region %d (Orig: %d)",
+        id, invSegMapper[id] );
       }
-      ++mapIt;
     }
 
+  // Compute the distances of all regions concurrently
+  RegionSignatureThreadStruct< TPixel, VImageDimension > str;
+  str.Image = segImage.GetPointer();
+  str.SegLabels = &segLabels;
+  str.SegBoundaries = &segBoundaries;
+  str.CVTBoundaries = &cvtBoundaries;
+  str.CVTOverlaps = &cvtOverlaps;
+  str.CVTCenters = &cvtCentersIdx;
+  str.ExcludeRegions = &excludeRegions;
+  str.LoadedRegions = &loadedRegions;
+  str.SignatureSelector = argSignatureSelector;
+  str.SignatureMatrix = &signatureMatrix;
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  if( threader->GetNumberOfThreads() > numberOfSegmentedRegions )
+    {
+    threader->SetNumberOfThreads( numberOfSegmentedRegions );
+    }
+  threader->SetSingleMethod(
+    RegionSignatureThreaderCallback< TPixel, VImageDimension >, &str );
+  threader->SingleMethodExecute();
+
   std::ofstream outSignatureFile( argDistanceSignatureFileName.c_str() );
   if( outSignatureFile.is_open() )
     {
@@ -25,8 +25,8 @@ limitations under the License.
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
 
+#include "itktubeDuplicateFrameDetector.h"
 #include "itktubeInnerOpticToPlusImageReader.h"
-#include "itktubeMarkDuplicateFramesInvalidImageFilter.h"
 
 #include <itkTimeProbesCollectorBase.h>
 #include <itkImageFileWriter.h>
@@ -106,20 +106,33 @@ int DoIt( int argc, char * argv[] )
   progress = 0.1;
   progressReporter.Report( progress );
 
-  typedef itk::tube::MarkDuplicateFramesInvalidImageFilter< OutputImageType >
-    DuplicateFilterType;
-  DuplicateFilterType::Pointer duplicateFilter = DuplicateFilterType::New();
+  // Frames are passed to the detector in acquisition order, as they would
+  //   be when streamed from the recording.
+  itk::MetaDataDictionary outputDictionary =
+    inputImage->GetMetaDataDictionary();
   if( ! duplicatesNotInvalid )
     {
     timeCollector.Start("Detecting duplicates");
-    duplicateFilter->SetInput( luminanceFilter->GetOutput() );
-    duplicateFilter->SetTolerance( duplicateTolerance );
-    duplicateFilter->SetFractionalThreshold( duplicateFractionalThreshold );
-    duplicateFilter->SetInputMetaDataDictionary(
-      &(inputImage->GetMetaDataDictionary()) );
+    typedef itk::tube::DuplicateFrameDetector< OutputImageType::PixelType >
+      DetectorType;
+    DetectorType::Pointer detector = DetectorType::New();
+    detector->SetTolerance( duplicateTolerance );
+    detector->SetFractionalThreshold( duplicateFractionalThreshold );
+
+    const OutputImageType * luminanceImage = luminanceFilter->GetOutput();
+    const OutputImageType::RegionType bufferedRegion =
+      luminanceImage->GetBufferedRegion();
+    const OutputImageType::SizeType bufferedSize = bufferedRegion.GetSize();
+    detector->SetFrameSize( bufferedSize[0], bufferedSize[1] );
+    const OutputImageType::PixelType * frame =
+      luminanceImage->GetBufferPointer();
     try
       {
-      duplicateFilter->Update();
+      for( itk::SizeValueType ii = 0; ii < bufferedSize[2]; ++ii )
+        {
+        detector->AddFrame( frame );
+        frame += bufferedSize[0] * bufferedSize[1];
+        }
       }
     catch( itk::ExceptionObject & err )
       {
@@ -128,6 +141,15 @@ int DoIt( int argc, char * argv[] )
       timeCollector.Report();
       return EXIT_FAILURE;
       }
+
+    const DetectorType::FrameListType & invalidFrames =
+      detector->GetInvalidFrames();
+    for( DetectorType::FrameListType::const_iterator it =
+      invalidFrames.begin(); it != invalidFrames.end(); ++it )
+      {
+      DetectorType::MarkFrameInvalid( outputDictionary,
+        *it + bufferedRegion.GetIndex()[2] );
+      }
     timeCollector.Stop("Detecting duplicates");
     }
 
@@ -139,16 +161,7 @@ int DoIt( int argc, char * argv[] )
   writer->SetUseInputMetaDataDictionary( false );
   typedef itk::MetaImageIO ImageIOType;
   ImageIOType::Pointer metaIO = ImageIOType::New();
-  if( duplicatesNotInvalid )
-    {
-    metaIO->SetMetaDataDictionary(
-      inputImage->GetMetaDataDictionary() );
-    }
-  else
-    {
-    metaIO->SetMetaDataDictionary(
-      duplicateFilter->GetOutputMetaDataDictionary() );
-    }
+  metaIO->SetMetaDataDictionary( outputDictionary );
   writer->SetImageIO( metaIO );
   writer->SetUseCompression( true );
   try
@@ -21,6 +21,8 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeFiniteDifferenceCostFunction.h"
+#include "itktubeGaussianScaleSpaceCache.h"
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
 
@@ -29,7 +31,6 @@ limitations under the License.
 #include <itkImageFileWriter.h>
 #include <itkNormalVariateGenerator.h>
 #include <itkOnePlusOneEvolutionaryOptimizer.h>
-#include <itkSmoothingRecursiveGaussianImageFilter.h>
 #include <itkTimeProbesCollectorBase.h>
 
 #include "DeblendTomosynthesisSlicesUsingPriorCLP.h"
@@ -47,16 +48,16 @@ namespace tube
 {
 
 template< class TPixel, unsigned int VDimension >
-class BlendCostFunction : public SingleValuedCostFunction
+class BlendCostFunction : public FiniteDifferenceCostFunction
 {
 public:
 
   typedef BlendCostFunction                       Self;
-  typedef SingleValuedCostFunction                Superclass;
+  typedef FiniteDifferenceCostFunction            Superclass;
   typedef SmartPointer< Self >                    Pointer;
   typedef SmartPointer< const Self >              ConstPointer;
 
-  itkTypeMacro( BlendCostFunction, SingleValuedCostFunction );
+  itkTypeMacro( BlendCostFunction, FiniteDifferenceCostFunction );
 
   itkNewMacro( Self );
 
@@ -103,6 +104,13 @@ public:
   void SetScales( ParametersType & _scales )
     {
     m_Scales = _scales;
+
+    ParametersType stepSizes( _scales.size() );
+    for( unsigned int i=0; i<_scales.size(); i++ )
+      {
+      stepSizes[i] = 1.0 / _scales[i];
+      }
+    this->SetDerivativeStepSizes( stepSizes );
     }
 
   void Initialize( void )
@@ -110,29 +118,35 @@ public:
     m_CallsToGetValue = 0;
     }
 
-  void GetDerivative( const ParametersType & params,
-                      DerivativeType & deriv ) const
+  MeasureType GetValue( const ParametersType & params ) const
     {
-    ParametersType tmpP = params;
-    deriv = params;
+    MeasureType result = this->ComputeValue( params, m_ImageOutput );
 
-    for( unsigned int i=0; i<this->GetNumberOfParameters(); i++ )
-      {
-      tmpP[i] = params[i] - 1.0 / m_Scales[i];
-      double tf = this->GetValue( tmpP );
-      tmpP[i] = params[i] + 1.0 / m_Scales[i];
-      deriv[i] = this->GetValue( tmpP ) - tf;
-      tmpP[i] = params[i];
-      }
+    std::cout << ++m_CallsToGetValue << " : "
+              << params[0] << ", "
+              << params[1] << ", "
+              << params[2] << ", ";
+    std::cout << " : result = " << result << std::endl;
+
+    return result;
     }
 
-  MeasureType GetValue( const ParametersType & params ) const
+protected:
+
+  BlendCostFunction( void )
+    : m_Mode(0), m_CallsToGetValue(0) {}
+  virtual ~BlendCostFunction( void ) {}
+
+  /** Derivative probes run concurrently, so they neither report nor
+   *  write the output image */
+  MeasureType EvaluateProbe( const ParametersType & params ) const
     {
-    typedef itk::ImageRegionConstIterator< ImageType >
-      ConstImageIteratorType;
-    typedef itk::ImageRegionIterator< ImageType >
-      ImageIteratorType;
+    return this->ComputeValue( params, NULL );
+    }
 
+  MeasureType ComputeValue( const ParametersType & params,
+                            ImageType * output ) const
+    {
     double result = 0;
     double sum255 = 0;
     double sumNot = 0;
@@ -141,43 +155,45 @@ public:
     unsigned int count255 = 0;
     unsigned int countNot = 0;
 
-    ConstImageIteratorType iterBottomB( m_ImageBottom,
-      m_ImageBottom->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterMiddle( m_ImageMiddle,
-      m_ImageMiddle->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterTopB( m_ImageTop,
-      m_ImageTop->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterMiddleTarget( m_ImageMiddleTarget,
-      m_ImageMiddleTarget->GetLargestPossibleRegion() );
-    ImageIteratorType iterOutput( m_ImageOutput,
-      m_ImageOutput->GetLargestPossibleRegion() );
-
-    typename ImageType::Pointer tmpMask = m_ImageOutput;
+    const SizeValueType numberOfVoxels =
+      m_ImageMiddle->GetLargestPossibleRegion().GetNumberOfPixels();
+    const TPixel * bottom = m_ImageBottom->GetBufferPointer();
+    const TPixel * middle = m_ImageMiddle->GetBufferPointer();
+    const TPixel * top = m_ImageTop->GetBufferPointer();
+    const TPixel * middleTarget = m_ImageMiddleTarget->GetBufferPointer();
+    const TPixel * mask = NULL;
     if( m_MetricMask.IsNotNull() )
       {
-      tmpMask = m_MetricMask;
+      mask = m_MetricMask->GetBufferPointer();
+      }
+    TPixel * out = NULL;
+    if( output != NULL )
+      {
+      out = output->GetBufferPointer();
       }
-    ConstImageIteratorType iterMask( tmpMask,
-      tmpMask->GetLargestPossibleRegion() );
-    while( !iterMiddle.IsAtEnd() )
+
+    for( SizeValueType v = 0; v < numberOfVoxels; v++ )
       {
-      float tf = ( params[0] * iterBottomB.Get() +
-        iterMiddle.Get() +
-        params[1] * iterTopB.Get() )
+      float tf = ( params[0] * bottom[v] +
+        middle[v] +
+        params[1] * top[v] )
         + params[2];
 
-      iterOutput.Set( tf );
+      if( out != NULL )
+        {
+        out[v] = tf;
+        }
 
-      if( m_MetricMask.IsNull() )
+      if( mask == NULL )
         {
-        double diff = iterMiddleTarget.Get() - tf;
+        double diff = middleTarget[v] - tf;
         result += diff * diff;
         }
-      else if( iterMask.Get() != 0 )
+      else if( mask[v] != 0 )
         {
-        double diff = iterMiddleTarget.Get() - tf;
+        double diff = middleTarget[v] - tf;
         result += diff * diff;
-        if( iterMask.Get() == 255 )
+        if( mask[v] == 255 )
           {
           sum255 += tf;
           sums255 += tf * tf;
@@ -190,13 +206,6 @@ public:
           ++countNot;
           }
         }
-
-      ++iterBottomB;
-      ++iterMiddle;
-      ++iterTopB;
-      ++iterMiddleTarget;
-      ++iterMask;
-      ++iterOutput;
       }
 
     if( count255 > 0 && countNot > 0 )
@@ -211,21 +220,9 @@ public:
         / vcl_sqrt( stdDev255 * stdDevNot );
       }
 
-    std::cout << ++m_CallsToGetValue << " : "
-              << params[0] << ", "
-              << params[1] << ", "
-              << params[2] << ", ";
-    std::cout << " : result = " << result << std::endl;
-
     return result;
     }
 
-protected:
-
-  BlendCostFunction( void )
-    : m_Mode(0), m_CallsToGetValue(0) {}
-  virtual ~BlendCostFunction( void ) {}
-
   void PrintSelf( std::ostream & os, Indent indent ) const
     {
     Superclass::PrintSelf( os, indent );
@@ -252,16 +249,16 @@ private:
 }; // End class BlendCostFunction
 
 template< class TPixel, unsigned int VDimension >
-class BlendScaleCostFunction : public SingleValuedCostFunction
+class BlendScaleCostFunction : public FiniteDifferenceCostFunction
 {
 public:
 
   typedef BlendScaleCostFunction                  Self;
-  typedef SingleValuedCostFunction                Superclass;
+  typedef FiniteDifferenceCostFunction            Superclass;
   typedef SmartPointer< Self >                    Pointer;
   typedef SmartPointer< const Self >              ConstPointer;
 
-  itkTypeMacro( BlendScaleCostFunction, SingleValuedCostFunction );
+  itkTypeMacro( BlendScaleCostFunction, FiniteDifferenceCostFunction );
 
   itkNewMacro( Self );
 
@@ -270,8 +267,7 @@ public:
   typedef Superclass::DerivativeType      DerivativeType;
   typedef itk::Image<TPixel, VDimension>  ImageType;
 
-  typedef itk::SmoothingRecursiveGaussianImageFilter< ImageType, ImageType >
-                                                  BlurFilterType;
+  typedef GaussianScaleSpaceCache< ImageType >    ScaleSpaceCacheType;
 
   unsigned int GetNumberOfParameters( void ) const
     {
@@ -281,6 +277,7 @@ public:
   void SetImageTop( typename ImageType::Pointer _top )
     {
     m_ImageTop = _top;
+    m_ScaleSpaceTop->SetInput( m_ImageTop );
     }
 
   void SetImageMiddle( typename ImageType::Pointer _middle )
@@ -291,6 +288,7 @@ public:
   void SetImageBottom( typename ImageType::Pointer _bottom )
     {
     m_ImageBottom = _bottom;
+    m_ScaleSpaceBottom->SetInput( m_ImageBottom );
     }
 
   void SetImageMiddleTarget( typename ImageType::Pointer _targetMiddle )
@@ -311,6 +309,21 @@ public:
   void SetScales( ParametersType & _scales )
     {
     m_Scales = _scales;
+
+    ParametersType stepSizes( _scales.size() );
+    for( unsigned int i=0; i<_scales.size(); i++ )
+      {
+      stepSizes[i] = 1.0 / _scales[i];
+      }
+    this->SetDerivativeStepSizes( stepSizes );
+    }
+
+  /** Number of cached blurrings per doubling of sigma; 0 blurs at
+   *  exactly the requested sigmas */
+  void SetNumberOfScalesPerOctave( unsigned int _numberOfScales )
+    {
+    m_ScaleSpaceTop->SetNumberOfScalesPerOctave( _numberOfScales );
+    m_ScaleSpaceBottom->SetNumberOfScalesPerOctave( _numberOfScales );
     }
 
   void Initialize( void )
@@ -318,47 +331,60 @@ public:
     m_CallsToGetValue = 0;
     }
 
-  void GetDerivative( const ParametersType & params,
-                      DerivativeType & deriv ) const
+  MeasureType GetValue( const ParametersType & params ) const
     {
-    ParametersType tmpP = params;
-    deriv = params;
+    MeasureType result = this->ComputeValue( params, m_ImageOutput );
 
-    for( unsigned int i=0; i<this->GetNumberOfParameters(); i++ )
-      {
-      tmpP[i] = params[i] - 1.0 / m_Scales[i];
-      double tf = this->GetValue( tmpP );
-      tmpP[i] = params[i] + 1.0 / m_Scales[i];
-      deriv[i] = this->GetValue( tmpP ) - tf;
-      tmpP[i] = params[i];
-      }
+    std::cout << ++m_CallsToGetValue << " : "
+              << params[0] << ", "
+              << params[1] << ", "
+              << params[2] << ", "
+              << params[3];
+    std::cout << " : result = " << result << std::endl;
+
+    return result;
     }
 
-  MeasureType GetValue( const ParametersType & params ) const
+protected:
+
+  BlendScaleCostFunction( void )
+    : m_Mode(0), m_CallsToGetValue(0)
     {
-    typedef itk::ImageRegionConstIterator< ImageType >
-      ConstImageIteratorType;
-    typedef itk::ImageRegionIterator< ImageType >
-      ImageIteratorType;
+    // Sigmas below 0.333 are clamped by ComputeValue
+    m_ScaleSpaceTop = ScaleSpaceCacheType::New();
+    m_ScaleSpaceTop->SetMinimumSigma( 0.333 );
+    m_ScaleSpaceBottom = ScaleSpaceCacheType::New();
+    m_ScaleSpaceBottom->SetMinimumSigma( 0.333 );
+    }
+  virtual ~BlendScaleCostFunction( void ) {}
 
-    typename BlurFilterType::Pointer filterBottom = BlurFilterType::New();
-    filterBottom->SetInput( m_ImageBottom );
-    typename BlurFilterType::Pointer filterTop = BlurFilterType::New();
-    filterTop->SetInput( m_ImageTop );
+  /** Derivative probes run concurrently, so they neither report nor
+   *  write the output image */
+  MeasureType EvaluateProbe( const ParametersType & params ) const
+    {
+    return this->ComputeValue( params, NULL );
+    }
+
+  MeasureType ComputeValue( const ParametersType & params,
+                            ImageType * output ) const
+    {
+    double sigma = 0.333;
     if( params[3] > 0.333 )
       {
-      filterBottom->SetSigma( params[3] );
-      filterTop->SetSigma( params[3] );
-      }
-    else
-      {
-      filterBottom->SetSigma( 0.333 );
-      filterTop->SetSigma( 0.333 );
+      sigma = params[3];
       }
-    filterBottom->Update();
-    typename ImageType::Pointer imageBottomB = filterBottom->GetOutput();
-    filterTop->Update();
-    typename ImageType::Pointer imageTopB = filterTop->GetOutput();
+
+    typename ImageType::Pointer imageBottomFine;
+    typename ImageType::Pointer imageBottomCoarse;
+    double weightBottom;
+    m_ScaleSpaceBottom->GetBracketingImages( sigma, imageBottomFine,
+      imageBottomCoarse, weightBottom );
+
+    typename ImageType::Pointer imageTopFine;
+    typename ImageType::Pointer imageTopCoarse;
+    double weightTop;
+    m_ScaleSpaceTop->GetBracketingImages( sigma, imageTopFine,
+      imageTopCoarse, weightTop );
 
     double result = 0;
     double sum255 = 0;
@@ -368,43 +394,51 @@ public:
     unsigned int count255 = 0;
     unsigned int countNot = 0;
 
-    ConstImageIteratorType iterBottomB( imageBottomB,
-      imageBottomB->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterMiddle( m_ImageMiddle,
-      m_ImageMiddle->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterTopB( imageTopB,
-      imageTopB->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterMiddleTarget( m_ImageMiddleTarget,
-      m_ImageMiddleTarget->GetLargestPossibleRegion() );
-    ImageIteratorType iterOutput( m_ImageOutput,
-      m_ImageOutput->GetLargestPossibleRegion() );
-
-    typename ImageType::Pointer tmpMask = m_ImageOutput;
+    const SizeValueType numberOfVoxels =
+      m_ImageMiddle->GetLargestPossibleRegion().GetNumberOfPixels();
+    const TPixel * bottomFine = imageBottomFine->GetBufferPointer();
+    const TPixel * bottomCoarse = imageBottomCoarse->GetBufferPointer();
+    const TPixel * middle = m_ImageMiddle->GetBufferPointer();
+    const TPixel * topFine = imageTopFine->GetBufferPointer();
+    const TPixel * topCoarse = imageTopCoarse->GetBufferPointer();
+    const TPixel * middleTarget = m_ImageMiddleTarget->GetBufferPointer();
+    const TPixel * mask = NULL;
     if( m_MetricMask.IsNotNull() )
       {
-      tmpMask = m_MetricMask;
+      mask = m_MetricMask->GetBufferPointer();
+      }
+    TPixel * out = NULL;
+    if( output != NULL )
+      {
+      out = output->GetBufferPointer();
       }
-    ConstImageIteratorType iterMask( tmpMask,
-      tmpMask->GetLargestPossibleRegion() );
-    while( !iterMiddle.IsAtEnd() )
+
+    for( SizeValueType v = 0; v < numberOfVoxels; v++ )
       {
-      float tf = ( params[0] * iterBottomB.Get() +
-        iterMiddle.Get() +
-        params[1] * iterTopB.Get() )
+      double valBottom = ( 1 - weightBottom ) * bottomFine[v]
+        + weightBottom * bottomCoarse[v];
+      double valTop = ( 1 - weightTop ) * topFine[v]
+        + weightTop * topCoarse[v];
+      float tf = ( params[0] * valBottom +
+        middle[v] +
+        params[1] * valTop )
         + params[2];
 
-      iterOutput.Set( tf );
+      if( out != NULL )
+        {
+        out[v] = tf;
+        }
 
-      if( m_MetricMask.IsNull() )
+      if( mask == NULL )
         {
-        double diff = iterMiddleTarget.Get() - tf;
+        double diff = middleTarget[v] - tf;
         result += diff * diff;
         }
-      else if( iterMask.Get() != 0 )
+      else if( mask[v] != 0 )
         {
-        double diff = iterMiddleTarget.Get() - tf;
+        double diff = middleTarget[v] - tf;
         result += diff * diff;
-        if( iterMask.Get() == 255 )
+        if( mask[v] == 255 )
           {
           sum255 += tf;
           sums255 += tf * tf;
@@ -417,13 +451,6 @@ public:
           ++countNot;
           }
         }
-
-      ++iterBottomB;
-      ++iterMiddle;
-      ++iterTopB;
-      ++iterMiddleTarget;
-      ++iterMask;
-      ++iterOutput;
       }
 
     if( count255 > 0 && countNot > 0 )
@@ -438,22 +465,9 @@ public:
         / vcl_sqrt( stdDev255 * stdDevNot );
       }
 
-    std::cout << ++m_CallsToGetValue << " : "
-              << params[0] << ", "
-              << params[1] << ", "
-              << params[2] << ", "
-              << params[3];
-    std::cout << " : result = " << result << std::endl;
-
     return result;
     }
 
-protected:
-
-  BlendScaleCostFunction( void )
-    : m_Mode(0), m_CallsToGetValue(0) {}
-  virtual ~BlendScaleCostFunction( void ) {}
-
   void PrintSelf( std::ostream & os, Indent indent ) const
     {
     Superclass::PrintSelf( os, indent );
@@ -473,6 +487,9 @@ private:
   typename ImageType::Pointer         m_MetricMask;
   mutable typename ImageType::Pointer m_ImageOutput;
 
+  typename ScaleSpaceCacheType::Pointer m_ScaleSpaceTop;
+  typename ScaleSpaceCacheType::Pointer m_ScaleSpaceBottom;
+
   ParametersType                      m_Scales;
 
   mutable unsigned int                m_CallsToGetValue;
@@ -697,6 +714,7 @@ int DoIt( int argc, char * argv[] )
 
     typename BlendScaleCostFunctionType::Pointer costFunc =
       BlendScaleCostFunctionType::New();
+    costFunc->SetNumberOfScalesPerOctave( scalesPerOctave );
     costFunc->SetImageBottom( imageBottom );
     costFunc->SetImageMiddle( imageMiddle );
     costFunc->SetImageTop( imageTop );
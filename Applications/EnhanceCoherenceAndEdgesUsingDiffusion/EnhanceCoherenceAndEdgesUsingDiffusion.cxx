@@ -126,6 +126,13 @@ int DoIt( int argc, char * argv[] )
     hybridContrastParameter );
   HybridEnhancingFilter->SetTimeStep( timeStep );
   HybridEnhancingFilter->SetNumberOfIterations( numberOfIterations );
+  HybridEnhancingFilter->SetUseSemiImplicitScheme( useSemiImplicitScheme );
+  HybridEnhancingFilter->SetTensorUpdateInterval( tensorUpdateInterval );
+  if( tensorUpdateChangeThreshold > 0 )
+    {
+    HybridEnhancingFilter->SetTensorUpdateChangeThreshold(
+      tensorUpdateChangeThreshold );
+    }
 
   double progressFraction = 0.8;
   tube::CLIFilterWatcher watcher( HybridEnhancingFilter,
@@ -122,6 +122,13 @@ int DoIt( int argc, char * argv[] )
     cedContrastParameter );
   CoherenceEnhancingFilter->SetTimeStep( timeStep );
   CoherenceEnhancingFilter->SetNumberOfIterations( numberOfIterations );
+  CoherenceEnhancingFilter->SetUseSemiImplicitScheme( useSemiImplicitScheme );
+  CoherenceEnhancingFilter->SetTensorUpdateInterval( tensorUpdateInterval );
+  if( tensorUpdateChangeThreshold > 0 )
+    {
+    CoherenceEnhancingFilter->SetTensorUpdateChangeThreshold(
+      tensorUpdateChangeThreshold );
+    }
 
   double progressFraction = 0.8;
   tube::CLIFilterWatcher watcher( CoherenceEnhancingFilter,
@@ -21,6 +21,8 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeFiniteDifferenceCostFunction.h"
+#include "itktubeGaussianScaleSpaceCache.h"
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
 
@@ -29,7 +31,6 @@ limitations under the License.
 #include <itkImageFileWriter.h>
 #include <itkNormalVariateGenerator.h>
 #include <itkOnePlusOneEvolutionaryOptimizer.h>
-#include <itkSmoothingRecursiveGaussianImageFilter.h>
 #include <itkTimeProbesCollectorBase.h>
 
 #include "EnhanceContrastUsingPriorCLP.h"
@@ -47,16 +48,16 @@ namespace tube
 {
 
 template< class TPixel, unsigned int VDimension >
-class ContrastCostFunction : public SingleValuedCostFunction
+class ContrastCostFunction : public FiniteDifferenceCostFunction
 {
 public:
 
   typedef ContrastCostFunction                    Self;
-  typedef SingleValuedCostFunction                Superclass;
+  typedef FiniteDifferenceCostFunction            Superclass;
   typedef SmartPointer< Self >                    Pointer;
   typedef SmartPointer< const Self >              ConstPointer;
 
-  itkTypeMacro( ContrastCostFunction, SingleValuedCostFunction );
+  itkTypeMacro( ContrastCostFunction, FiniteDifferenceCostFunction );
 
   itkNewMacro( Self );
 
@@ -65,8 +66,7 @@ public:
   typedef Superclass::DerivativeType      DerivativeType;
   typedef itk::Image<TPixel, VDimension>  ImageType;
 
-  typedef itk::SmoothingRecursiveGaussianImageFilter< ImageType, ImageType >
-                                                  BlurFilterType;
+  typedef GaussianScaleSpaceCache< ImageType >    ScaleSpaceCacheType;
 
   unsigned int GetNumberOfParameters( void ) const
     {
@@ -76,6 +76,7 @@ public:
   void SetInputImage( typename ImageType::Pointer _inputImage )
     {
     m_InputImage = _inputImage;
+    m_ScaleSpace->SetInput( m_InputImage );
     }
 
   void SetInputMask( typename ImageType::Pointer _maskImage )
@@ -101,60 +102,77 @@ public:
   void SetScales( ParametersType & _scales )
     {
     m_Scales = _scales;
+
+    ParametersType stepSizes( _scales.size() );
+    for( unsigned int i=0; i<_scales.size(); i++ )
+      {
+      stepSizes[i] = 0.5 / _scales[i];
+      }
+    this->SetDerivativeStepSizes( stepSizes );
     }
 
+  /** Number of cached blurrings per doubling of sigma; 0 blurs at
+   *  exactly the requested sigmas */
+  void SetNumberOfScalesPerOctave( unsigned int _numberOfScales )
+    {
+    m_ScaleSpace->SetNumberOfScalesPerOctave( _numberOfScales );
+    }
 
   void Initialize( void )
     {
     m_CallsToGetValue = 0;
     }
 
-  void GetDerivative( const ParametersType & params,
-                      DerivativeType & deriv ) const
+  MeasureType GetValue( const ParametersType & params ) const
     {
-    ParametersType tmpP = params;
-    deriv = params;
+    return this->ComputeValue( params, m_OutputImage, true );
+    }
 
-    for( unsigned int i=0; i<this->GetNumberOfParameters(); i++ )
-      {
-      tmpP[i] = params[i] - 0.5 / m_Scales[i];
-      double tf = this->GetValue( tmpP );
-      tmpP[i] = params[i] + 0.5 / m_Scales[i];
-      deriv[i] = this->GetValue( tmpP ) - tf;
-      tmpP[i] = params[i];
-      }
+protected:
+
+  ContrastCostFunction() : m_InputMean(0.0),
+                           m_MaskObjectValue(0),
+                           m_MaskBackgroundValue(0),
+                           m_CallsToGetValue(0)
+    {
+    // Sigmas at or below 0.3 are rejected by ComputeValue
+    m_ScaleSpace = ScaleSpaceCacheType::New();
+    m_ScaleSpace->SetMinimumSigma( 0.3 );
+    }
+  virtual ~ContrastCostFunction( void ) {}
+
+  /** Derivative probes run concurrently, so they neither report nor
+   *  write the output image */
+  MeasureType EvaluateProbe( const ParametersType & params ) const
+    {
+    return this->ComputeValue( params, NULL, false );
     }
 
-  MeasureType GetValue( const ParametersType & params ) const
+  MeasureType ComputeValue( const ParametersType & params,
+                            ImageType * output, bool report ) const
     {
-    typename BlurFilterType::Pointer filterInputObj = BlurFilterType::New();
-    filterInputObj->SetInput( m_InputImage );
     double sigmaObj = params[0];
-    if( sigmaObj > 0.3 && sigmaObj < 100 )
-      {
-      filterInputObj->SetSigma( sigmaObj );
-      }
-    else
+    if( sigmaObj <= 0.3 || sigmaObj >= 100 )
       {
       return 100;
       }
-    filterInputObj->Update();
-    typename ImageType::Pointer imgObj = filterInputObj->GetOutput();
-
-    typename BlurFilterType::Pointer filterInputBkg =
-      BlurFilterType::New();
-    filterInputBkg->SetInput( m_InputImage );
     double sigmaBkg = params[1];
-    if( sigmaBkg > sigmaObj && sigmaBkg < 100 )
-      {
-      filterInputBkg->SetSigma( sigmaBkg );
-      }
-    else
+    if( sigmaBkg <= sigmaObj || sigmaBkg >= 100 )
       {
       return 100;
       }
-    filterInputBkg->Update();
-    typename ImageType::Pointer imgBkg = filterInputBkg->GetOutput();
+
+    typename ImageType::Pointer imgObjFine;
+    typename ImageType::Pointer imgObjCoarse;
+    double weightObj;
+    m_ScaleSpace->GetBracketingImages( sigmaObj, imgObjFine, imgObjCoarse,
+      weightObj );
+
+    typename ImageType::Pointer imgBkgFine;
+    typename ImageType::Pointer imgBkgCoarse;
+    double weightBkg;
+    m_ScaleSpace->GetBracketingImages( sigmaBkg, imgBkgFine, imgBkgCoarse,
+      weightBkg );
 
     double alpha = params[2];
 
@@ -170,49 +188,50 @@ public:
     double sumBkg = 0;
     double sumsBkg = 0;
 
-    typedef ImageRegionIterator< ImageType >       ImageIteratorType;
-    typedef ImageRegionConstIterator< ImageType >  ConstImageIteratorType;
-
-    ConstImageIteratorType iterObj( imgObj,
-      imgObj->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterBkg( imgBkg,
-      imgBkg->GetLargestPossibleRegion() );
-    ConstImageIteratorType iterMask( m_InputMask,
-      m_InputMask->GetLargestPossibleRegion() );
-    ImageIteratorType iterOut( m_OutputImage,
-      m_OutputImage->GetLargestPossibleRegion() );
+    const SizeValueType numberOfVoxels =
+      m_InputImage->GetLargestPossibleRegion().GetNumberOfPixels();
+    const TPixel * objFine = imgObjFine->GetBufferPointer();
+    const TPixel * objCoarse = imgObjCoarse->GetBufferPointer();
+    const TPixel * bkgFine = imgBkgFine->GetBufferPointer();
+    const TPixel * bkgCoarse = imgBkgCoarse->GetBufferPointer();
+    const TPixel * mask = m_InputMask->GetBufferPointer();
+    TPixel * out = NULL;
+    if( output != NULL )
+      {
+      out = output->GetBufferPointer();
+      }
 
     double meanRawBkg = 0;
-    double countRawBkg = 0;
-    while( !iterBkg.IsAtEnd() )
+    for( SizeValueType v = 0; v < numberOfVoxels; v++ )
       {
-      meanRawBkg += iterBkg.Get();
-      ++countRawBkg;
-      ++iterBkg;
+      meanRawBkg += ( 1 - weightBkg ) * bkgFine[v]
+        + weightBkg * bkgCoarse[v];
       }
-    meanRawBkg /= countRawBkg;
+    meanRawBkg /= numberOfVoxels;
 
-    iterBkg.GoToBegin();
-    while( !iterObj.IsAtEnd() )
+    for( SizeValueType v = 0; v < numberOfVoxels; v++ )
       {
-      double tf = iterObj.Get() * ( 1 + alpha * (iterBkg.Get()-meanRawBkg) );
-      if( iterMask.Get() == m_MaskObjectValue )
+      double valObj = ( 1 - weightObj ) * objFine[v]
+        + weightObj * objCoarse[v];
+      double valBkg = ( 1 - weightBkg ) * bkgFine[v]
+        + weightBkg * bkgCoarse[v];
+      double tf = valObj * ( 1 + alpha * ( valBkg - meanRawBkg ) );
+      if( mask[v] == m_MaskObjectValue )
         {
         sumObj += tf;
         sumsObj += tf * tf;
         ++countObj;
         }
-      else if( iterMask.Get() == m_MaskBackgroundValue )
+      else if( mask[v] == m_MaskBackgroundValue )
         {
         sumBkg += tf;
         sumsBkg += tf * tf;
         ++countBkg;
         }
-      iterOut.Set( tf );
-      ++iterObj;
-      ++iterBkg;
-      ++iterMask;
-      ++iterOut;
+      if( out != NULL )
+        {
+        out[v] = tf;
+        }
       }
 
     if( countObj > 0 )
@@ -228,24 +247,19 @@ public:
 
     double dp = vnl_math_abs(meanObj - meanBkg) / (stdDevObj * stdDevBkg);
 
-    std::cout << ++m_CallsToGetValue << " : "
-              << params[0] << ", " << params[1] << ", "
-              << params[2] << ": "
-              << meanObj << " (" << stdDevObj << ") "
-              << meanBkg << " (" << stdDevBkg << ") "
-              << " : " << dp << std::endl;
+    if( report )
+      {
+      std::cout << ++m_CallsToGetValue << " : "
+                << params[0] << ", " << params[1] << ", "
+                << params[2] << ": "
+                << meanObj << " (" << stdDevObj << ") "
+                << meanBkg << " (" << stdDevBkg << ") "
+                << " : " << dp << std::endl;
+      }
 
     return dp;
     }
 
-protected:
-
-  ContrastCostFunction() : m_InputMean(0.0),
-                           m_MaskObjectValue(0),
-                           m_MaskBackgroundValue(0),
-                           m_CallsToGetValue(0) {}
-  virtual ~ContrastCostFunction( void ) {}
-
   void PrintSelf( std::ostream & os, Indent indent ) const
     {
     Superclass::PrintSelf( os, indent );
@@ -260,6 +274,8 @@ private:
   typename ImageType::Pointer         m_InputMask;
   mutable typename ImageType::Pointer m_OutputImage;
 
+  typename ScaleSpaceCacheType::Pointer m_ScaleSpace;
+
   double                              m_InputMean;
 
   unsigned int                        m_MaskObjectValue;
@@ -382,6 +398,7 @@ int DoIt( int argc, char * argv[] )
   costFunc->SetOutputImage( outputImage );
   costFunc->SetMaskObjectValue( maskObjectValue );
   costFunc->SetMaskBackgroundValue( maskBackgroundValue );
+  costFunc->SetNumberOfScalesPerOctave( scalesPerOctave );
 
   InitialOptimizerType::Pointer initOptimizer =
     InitialOptimizerType::New();
@@ -119,6 +119,13 @@ int DoIt( int argc, char * argv[] )
   EdgeEnhancementFilter->SetContrastParameterLambdaE( eedContrastParameter );
   EdgeEnhancementFilter->SetTimeStep( timeStep );
   EdgeEnhancementFilter->SetNumberOfIterations( numberOfIterations );
+  EdgeEnhancementFilter->SetUseSemiImplicitScheme( useSemiImplicitScheme );
+  EdgeEnhancementFilter->SetTensorUpdateInterval( tensorUpdateInterval );
+  if( tensorUpdateChangeThreshold > 0 )
+    {
+    EdgeEnhancementFilter->SetTensorUpdateChangeThreshold(
+      tensorUpdateChangeThreshold );
+    }
 
   double progressFraction = 0.8;
   tube::CLIFilterWatcher watcher( EdgeEnhancementFilter,
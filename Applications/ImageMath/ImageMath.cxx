@@ -22,6 +22,7 @@ limitations under the License.
 =========================================================================*/
 
 #include "itktubeCVTImageFilter.h"
+#include "itktubeImageQuantileCalculator.h"
 #include "itktubeRidgeExtractor.h"
 
 #include <itkBinaryBallStructuringElement.h>
@@ -504,6 +505,40 @@ int DoIt( MetaCommand & command )
         normFilter->Update();
         imIn = normFilter->GetOutput();
         }
+      else if( normType == 3 )
+        {
+        // Median and interquartile range; the IQR of a Gaussian is
+        // 1.349 standard deviations
+        typedef itk::tube::ImageQuantileCalculator< ImageType >
+                                                      QuantileCalculatorType;
+        typename QuantileCalculatorType::Pointer quantileCalculator =
+          QuantileCalculatorType::New();
+        quantileCalculator->SetImage( imIn );
+        typename QuantileCalculatorType::QuantileListType quantiles;
+        quantiles.push_back( 0.25 );
+        quantiles.push_back( 0.5 );
+        quantiles.push_back( 0.75 );
+        quantileCalculator->SetQuantiles( quantiles );
+        quantileCalculator->Compute();
+        double medianV = quantileCalculator->GetQuantileValues()[1];
+        double iqrStdDevV = ( quantileCalculator->GetQuantileValues()[2]
+          - quantileCalculator->GetQuantileValues()[0] ) / 1.349;
+        if( iqrStdDevV <= 0 )
+          {
+          iqrStdDevV = 1;
+          }
+        std::cout << "  Median = " << medianV << " : IQR StdDev = "
+          << iqrStdDevV << std::endl;
+
+        itk::ImageRegionIterator< ImageType > it1( imIn,
+              imIn->GetLargestPossibleRegion() );
+        while( !it1.IsAtEnd() )
+          {
+          double tf = it1.Get();
+          it1.Set( ( tf - medianV ) / iqrStdDevV );
+          ++it1;
+          }
+        }
       else
         {
         unsigned int nBins = 50;
@@ -1815,7 +1850,7 @@ int main( int argc, char * argv[] )
     "Correction", "referenceVolume", MetaCommand::STRING, true );
 
   command.SetOption( "Normalize", "d", false,
-    "Normalize: type0 = data's mean/std; 1 = FWHM estimate; 2 = FWHM mean (shift) only" );
+    "Normalize: type0 = data's mean/std; 1 = FWHM estimate; 2 = FWHM mean (shift) only; 3 = median/IQR" );
   command.AddOptionField( "Normalize", "type", MetaCommand::INT, true );
 
   command.SetOption( "Fuse", "f", false,
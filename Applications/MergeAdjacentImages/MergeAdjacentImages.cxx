@@ -21,15 +21,18 @@ limitations under the License.
 
 =========================================================================*/
 
-#include "itkGeneralizedDistanceTransformImageFilter.h"
+#include "itktubeGeneralizedDistanceTransformImageFilter.h"
+#include "itktubeTileBlendImageFilter.h"
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
 
-#include <itkImageRegionIteratorWithIndex.h>
+#include <itkBinaryFunctorImageFilter.h>
+#include <itkBinaryThresholdImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
 #include <itkImageToImageRegistrationHelper.h>
 #include <itkSignedDanielssonDistanceMapImageFilter.h>
 #include <itkTimeProbesCollectorBase.h>
-#include <itkBinaryThresholdImageFilter.h>
 
 #include "MergeAdjacentImagesCLP.h"
 
@@ -84,7 +87,6 @@ int DoIt( int argc, char * argv[] )
   typename ImageType::Pointer curImage1 = reader1->GetOutput();
 
   typename ImageType::PointType pointX;
-  typename ImageType::IndexType indexX;
 
   typename ImageType::IndexType minX1Org;
   minX1Org = curImage1->GetLargestPossibleRegion().GetIndex();
@@ -122,28 +124,14 @@ int DoIt( int argc, char * argv[] )
     {
     sizeOut[i] = maxXOut[i] - minXOut[i] + 1;
     }
-  timeCollector.Start("Load data");
-  typename ReaderType::Pointer reader2 = ReaderType::New();
-  reader2->SetFileName( inputVolume2.c_str() );
-  try
-    {
-    reader2->Update();
-    }
-  catch( itk::ExceptionObject & err )
-    {
-    tube::ErrorMessage( "Reading volume: Exception caught: "
-                        + std::string(err.GetDescription()) );
-    timeCollector.Stop("Load data");
-    timeCollector.Report();
-    return EXIT_FAILURE;
-    }
-  timeCollector.Stop("Load data");
-
-  timeCollector.Start("Determine ROI");
-  progress += 1.0/(double)inputVolume2.size() * 0.4;
-  progressReporter.Report( progress );
 
-  typename ImageType::Pointer curImage2 = reader2->GetOutput();
+  // The second volume and any additional volumes are the tiles that are
+  //   merged into the space of the first volume, one after the other.
+  std::vector< std::string > tileFileNames;
+  tileFileNames.push_back( inputVolume2 );
+  tileFileNames.insert( tileFileNames.end(), additionalVolumes.begin(),
+    additionalVolumes.end() );
+  const unsigned int numberOfTiles = tileFileNames.size();
 
   bool useInitialTransform = false;
   typedef itk::AffineTransform<double, VDimension >   AffineTransformType;
@@ -173,74 +161,109 @@ int DoIt( int argc, char * argv[] )
       }
     }
 
-  typename ImageType::IndexType minX2;
-  typename ImageType::IndexType minX2Org;
-  minX2Org = curImage2->GetLargestPossibleRegion().GetIndex();
-  if( boundary.size() == VDimension )
+  // Read all tiles first, so that the output image covering all of them
+  //   is allocated only once.
+  std::vector< typename ImageType::Pointer > tiles( numberOfTiles );
+  for( unsigned int t=0; t<numberOfTiles; t++ )
     {
-    for( unsigned int i=0; i<VDimension; i++ )
+    timeCollector.Start("Load data");
+    typename ReaderType::Pointer reader2 = ReaderType::New();
+    reader2->SetFileName( tileFileNames[t].c_str() );
+    try
       {
-      minX2Org[i] -= boundary[i];
+      reader2->Update();
       }
-    }
-  curImage2->TransformIndexToPhysicalPoint( minX2Org, pointX );
-  if( useInitialTransform )
-    {
-    pointX = initialTransform->GetInverseTransform()->TransformPoint( pointX );
-    }
-  curImage1->TransformPhysicalPointToIndex( pointX, minX2 );
+    catch( itk::ExceptionObject & err )
+      {
+      tube::ErrorMessage( "Reading volume: Exception caught: "
+                          + std::string(err.GetDescription()) );
+      timeCollector.Stop("Load data");
+      timeCollector.Report();
+      return EXIT_FAILURE;
+      }
+    timeCollector.Stop("Load data");
 
-  typename ImageType::SizeType size2 = curImage2->
-                                         GetLargestPossibleRegion().
-                                         GetSize();
-  typename ImageType::IndexType maxX2;
-  typename ImageType::IndexType maxX2Org;
-  for( unsigned int i=0; i<VDimension; i++ )
-    {
-    maxX2Org[i] = minX2Org[i] + size2[i] - 1;
-    }
-  if( boundary.size() == VDimension )
-    {
-    for( unsigned int i=0; i<VDimension; i++ )
+    timeCollector.Start("Determine ROI");
+    progress += 1.0/(double)numberOfTiles * 0.1;
+    progressReporter.Report( progress );
+
+    typename ImageType::Pointer curImage2 = reader2->GetOutput();
+    tiles[t] = curImage2;
+
+    // The loaded transform only applies to the second volume
+    const bool useTileTransform = ( useInitialTransform && t == 0 );
+
+    typename ImageType::IndexType minX2;
+    typename ImageType::IndexType minX2Org;
+    minX2Org = curImage2->GetLargestPossibleRegion().GetIndex();
+    if( boundary.size() == VDimension )
       {
-      maxX2Org[i] += 2*boundary[i];
+      for( unsigned int i=0; i<VDimension; i++ )
+        {
+        minX2Org[i] -= boundary[i];
+        }
       }
-    }
-  curImage2->TransformIndexToPhysicalPoint( maxX2Org, pointX );
-  if( useInitialTransform )
-    {
-    pointX = initialTransform->GetInverseTransform()->TransformPoint( pointX );
-    }
-  curImage1->TransformPhysicalPointToIndex( pointX, maxX2 );
+    curImage2->TransformIndexToPhysicalPoint( minX2Org, pointX );
+    if( useTileTransform )
+      {
+      pointX = initialTransform->GetInverseTransform()->TransformPoint(
+        pointX );
+      }
+    curImage1->TransformPhysicalPointToIndex( pointX, minX2 );
 
-  for( unsigned int i=0; i<VDimension; i++ )
-    {
-    if( minX2[i] < minXOut[i] )
+    typename ImageType::SizeType size2 = curImage2->
+                                           GetLargestPossibleRegion().
+                                           GetSize();
+    typename ImageType::IndexType maxX2;
+    typename ImageType::IndexType maxX2Org;
+    for( unsigned int i=0; i<VDimension; i++ )
       {
-      minXOut[i] = minX2[i];
+      maxX2Org[i] = minX2Org[i] + size2[i] - 1;
       }
-    if( maxX2[i] < minXOut[i] )
+    if( boundary.size() == VDimension )
       {
-      minXOut[i] = maxX2[i];
+      for( unsigned int i=0; i<VDimension; i++ )
+        {
+        maxX2Org[i] += 2*boundary[i];
+        }
       }
-    }
-  for( unsigned int i=0; i<VDimension; i++ )
-    {
-    if( minX2[i] > maxXOut[i] )
+    curImage2->TransformIndexToPhysicalPoint( maxX2Org, pointX );
+    if( useTileTransform )
       {
-      maxXOut[i] = minX2[i];
+      pointX = initialTransform->GetInverseTransform()->TransformPoint(
+        pointX );
       }
-    if( maxX2[i] > maxXOut[i] )
+    curImage1->TransformPhysicalPointToIndex( pointX, maxX2 );
+
+    for( unsigned int i=0; i<VDimension; i++ )
       {
-      maxXOut[i] = maxX2[i];
+      if( minX2[i] < minXOut[i] )
+        {
+        minXOut[i] = minX2[i];
+        }
+      if( maxX2[i] < minXOut[i] )
+        {
+        minXOut[i] = maxX2[i];
+        }
       }
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      if( minX2[i] > maxXOut[i] )
+        {
+        maxXOut[i] = minX2[i];
+        }
+      if( maxX2[i] > maxXOut[i] )
+        {
+        maxXOut[i] = maxX2[i];
+        }
+      }
+    timeCollector.Stop("Determine ROI");
     }
 
   for( unsigned int i=0; i<VDimension; i++ )
     {
     sizeOut[i] = maxXOut[i] - minXOut[i] + 1;
     }
-  timeCollector.Stop("Determine ROI");
 
   timeCollector.Start("Allocate output image");
   typename ImageType::RegionType regionOut;
@@ -253,329 +276,215 @@ int DoIt( int argc, char * argv[] )
   outImage->Allocate();
   outImage->FillBuffer( background );
 
-  itk::ImageRegionIteratorWithIndex< ImageType > iter( curImage1,
+  // The first image lies within the output region, so both can be
+  //   traversed in the same order.
+  itk::ImageRegionConstIterator< ImageType > iter( curImage1,
+    curImage1->GetLargestPossibleRegion() );
+  itk::ImageRegionIterator< ImageType > iterOut( outImage,
     curImage1->GetLargestPossibleRegion() );
   while( !iter.IsAtEnd() )
     {
-    indexX = iter.GetIndex();
     double tf = iter.Get();
     if( !mask || tf != 0 )
       {
-      outImage->SetPixel( indexX, tf );
+      iterOut.Set( tf );
       }
     ++iter;
+    ++iterOut;
     }
   progress += 0.1;
   progressReporter.Report( progress );
   timeCollector.Stop("Allocate output image");
 
-  typename ImageType::ConstPointer tmpImage;
   typedef typename itk::ImageToImageRegistrationHelper< ImageType >
     RegFilterType;
-  typename RegFilterType::Pointer regOp = RegFilterType::New();
-  regOp->SetFixedImage( curImage1 );
-  regOp->SetMovingImage( curImage2 );
-  regOp->SetSampleFromOverlap( true );
-  regOp->SetEnableLoadedRegistration( false );
-  regOp->SetEnableInitialRegistration( false );
-  regOp->SetEnableRigidRegistration( true );
-  regOp->SetRigidSamplingRatio( samplingRatio );
-  regOp->SetRigidMaxIterations( iterations );
-  regOp->SetEnableAffineRegistration( false );
-  regOp->SetEnableBSplineRegistration( false );
-  regOp->SetExpectedOffsetPixelMagnitude( expectedOffset );
-  regOp->SetExpectedRotationMagnitude( expectedRotation );
-
-  if( useInitialTransform )
-    {
-    regOp->SetLoadedMatrixTransform( *initialTransform );
-    }
-
-  regOp->Initialize();
-  if( iterations > 0 )
-    {
-    timeCollector.Start("Register images");
-    regOp->SetReportProgress( true );
-    regOp->Update();
-    timeCollector.Stop("Register images");
-    }
-
-  if( ! saveTransform.empty() )
-    {
-    regOp->SaveTransform( saveTransform );
-    }
-
-  timeCollector.Start("Resample Image");
-  regOp->SetFixedImage( outImage );
-  tmpImage = regOp->ResampleImage(
-    RegFilterType::OptimizedRegistrationMethodType::
-    LINEAR_INTERPOLATION,
-    curImage2, NULL, NULL, background );
-  timeCollector.Stop("Resample Image");
-
-  if( averagePixels )
+  typedef itk::tube::TileBlendImageFilter< ImageType >  BlendFilterType;
+  typedef itk::tube::Functor::TileOverlapLabel< PixelType >
+    OverlapLabelType;
+  typedef itk::BinaryFunctorImageFilter< ImageType, ImageType, ImageType,
+    OverlapLabelType >                                  OverlapFilterType;
+  typedef itk::BinaryThresholdImageFilter< ImageType, ImageType >
+    Indicator;
+  typedef typename itk::tube::GeneralizedDistanceTransformImageFilter<
+    ImageType, ImageType >                              FastMapFilterType;
+
+  for( unsigned int t=0; t<numberOfTiles; t++ )
     {
-    itk::ImageRegionConstIteratorWithIndex< ImageType > iter2( tmpImage,
-      tmpImage->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iterOut( outImage,
-      outImage->GetLargestPossibleRegion() );
-    while( !iter2.IsAtEnd() )
+    typename ImageType::ConstPointer tmpImage;
+    typename RegFilterType::Pointer regOp = RegFilterType::New();
+    regOp->SetFixedImage( curImage1 );
+    regOp->SetMovingImage( tiles[t] );
+    regOp->SetSampleFromOverlap( true );
+    regOp->SetEnableLoadedRegistration( false );
+    regOp->SetEnableInitialRegistration( false );
+    regOp->SetEnableRigidRegistration( true );
+    regOp->SetRigidSamplingRatio( samplingRatio );
+    regOp->SetRigidMaxIterations( iterations );
+    regOp->SetEnableAffineRegistration( false );
+    regOp->SetEnableBSplineRegistration( false );
+    regOp->SetExpectedOffsetPixelMagnitude( expectedOffset );
+    regOp->SetExpectedRotationMagnitude( expectedRotation );
+
+    if( useInitialTransform && t == 0 )
       {
-      double iVal = iter2.Get();
-      bool image2Point = false;
-      if( iVal != background && (!mask || iVal != 0) )
-        {
-        image2Point = true;
-        }
-      double oVal = iterOut.Get();
-      bool imageOutPoint = false;
-      if( oVal != background && (!mask || oVal != 0) )
-        {
-        imageOutPoint = true;
-        }
-
-      if( imageOutPoint )
-        {
-        if( image2Point )
-          {
-          oVal = 0.5 * iVal + 0.5 * oVal;
-          }
-        }
-      else if( image2Point )
-        {
-        oVal = iVal;
-        }
-
-      iterOut.Set( oVal );
-
-      ++iter2;
-      ++iterOut;
-      }
-    }
-  else
-    {
-    timeCollector.Start("Resample Image2");
-    typename ImageType::Pointer curImage2Reg = ImageType::New();
-    curImage2Reg->CopyInformation( tmpImage );
-    curImage2Reg->SetRegions( tmpImage->GetLargestPossibleRegion() );
-    curImage2Reg->Allocate();
-    curImage2Reg->FillBuffer( background );
-
-    typename ImageType::Pointer outImageMap = ImageType::New();
-    outImageMap->CopyInformation( tmpImage );
-    outImageMap->SetRegions( tmpImage->GetLargestPossibleRegion() );
-    outImageMap->Allocate();
-    outImageMap->FillBuffer( 3 );
-    itk::ImageRegionConstIteratorWithIndex< ImageType > iterTmp(
-      tmpImage, tmpImage->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iter2(
-      curImage2Reg, curImage2Reg->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iterOut(
-      outImage, outImage->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iterOutMap(
-      outImageMap, outImageMap->GetLargestPossibleRegion() );
-
-    while( !iter2.IsAtEnd() )
-      {
-      double iVal = iterTmp.Get();
-      iter2.Set( iVal );
-      bool image2Point = false;
-      if( iVal != background && (!mask || iVal != 0) )
-        {
-        image2Point = true;
-        }
-      double oVal = iterOut.Get();
-      bool imageOutPoint = false;
-      if( oVal != background && (!mask || oVal != 0) )
-        {
-        imageOutPoint = true;
-        }
-      if( image2Point && imageOutPoint )
-        {
-        iterOutMap.Set( 0 );
-        }
-      else if( image2Point )
-        {
-        iterOutMap.Set( 2 );
-        }
-      else if( imageOutPoint )
-        {
-        iterOutMap.Set( 1 );
-        }
-      ++iterTmp;
-      ++iter2;
-      ++iterOut;
-      ++iterOutMap;
+      regOp->SetLoadedMatrixTransform( *initialTransform );
       }
-    timeCollector.Stop("Resample Image2");
 
-    timeCollector.Start("Out Distance Map");
-    typename ImageType::Pointer outImageDistMap = NULL;
-    typename ImageType::Pointer outImageVoronoiMap = NULL;
-    if( useFastBlending )
+    regOp->Initialize();
+    if( iterations > 0 )
       {
-      typedef typename itk::GeneralizedDistanceTransformImageFilter<
-        ImageType, ImageType >   MapFilterType;
-      typename MapFilterType::Pointer mapDistFilter = MapFilterType::New();
-
-      typedef itk::BinaryThresholdImageFilter<ImageType, ImageType>
-        Indicator;
-      typename Indicator::Pointer indicator = Indicator::New();
-      indicator->SetLowerThreshold(0);
-      indicator->SetUpperThreshold(0);
-      indicator->SetOutsideValue(0);
-      indicator->SetInsideValue(
-        mapDistFilter->GetMaximalSquaredDistance() );
-      indicator->SetInput( outImageMap );
-      indicator->Update();
-
-      mapDistFilter->SetInput1( indicator->GetOutput() );
-      mapDistFilter->SetInput2( outImageMap );
-      mapDistFilter->UseImageSpacingOff();
-      mapDistFilter->CreateVoronoiMapOn();
-      mapDistFilter->Update();
-      outImageDistMap = mapDistFilter->GetOutput();
-      outImageVoronoiMap = mapDistFilter->GetVoronoiMap();
+      timeCollector.Start("Register images");
+      regOp->SetReportProgress( true );
+      regOp->Update();
+      timeCollector.Stop("Register images");
       }
-    else
+
+    if( ! saveTransform.empty() && t == 0 )
       {
-      typedef typename itk::DanielssonDistanceMapImageFilter< ImageType,
-        ImageType>   MapFilterType;
-      typename MapFilterType::Pointer mapDistFilter = MapFilterType::New();
-      mapDistFilter->SetInput( outImageMap );
-      mapDistFilter->SetInputIsBinary( false );
-      mapDistFilter->SetUseImageSpacing( false );
-      mapDistFilter->Update();
-      outImageDistMap = mapDistFilter->GetDistanceMap();
-      outImageVoronoiMap = mapDistFilter->GetVoronoiMap();
+      regOp->SaveTransform( saveTransform );
       }
-    timeCollector.Stop("Out Distance Map");
 
-    progress += 1.0/(double)inputVolume2.size() * 0.2;
-    progressReporter.Report( progress );
+    timeCollector.Start("Resample Image");
+    regOp->SetFixedImage( outImage );
+    tmpImage = regOp->ResampleImage(
+      RegFilterType::OptimizedRegistrationMethodType::
+      LINEAR_INTERPOLATION,
+      tiles[t], NULL, NULL, background );
+    timeCollector.Stop("Resample Image");
 
-    timeCollector.Start("Distance Map Selection");
-    typename ImageType::Pointer vorImageMap = ImageType::New();
-    vorImageMap->CopyInformation( outImage );
-    vorImageMap->SetRegions( outImage->GetLargestPossibleRegion() );
-    vorImageMap->Allocate();
-    vorImageMap->FillBuffer( 1 );
-    itk::ImageRegionConstIteratorWithIndex< ImageType > iterOutVor(
-      outImageVoronoiMap, outImageVoronoiMap->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iterVorMap(
-      vorImageMap, vorImageMap->GetLargestPossibleRegion() );
-    while( !iterOutVor.IsAtEnd() )
-      {
-      double tf = iterOutVor.Get();
-      if( tf != 1 )
-        {
-        iterVorMap.Set( 0 );
-        }
-      ++iterOutVor;
-      ++iterVorMap;
-      }
-    timeCollector.Stop("Distance Map Selection");
+    // The tile is no longer needed once it has been resampled
+    tiles[t] = NULL;
 
-    typename ImageType::Pointer vorImageDistMap = NULL;
-    if( useFastBlending )
-      {
-      typedef typename itk::GeneralizedDistanceTransformImageFilter<
-        ImageType, ImageType >   MapFilterType;
-      typename MapFilterType::Pointer mapVorFilter = MapFilterType::New();
+    progress += 1.0/(double)numberOfTiles * 0.4;
+    progressReporter.Report( progress );
 
-      timeCollector.Start("Voronoi Distance Map");
-      typedef itk::BinaryThresholdImageFilter<ImageType, ImageType>
-        Indicator;
-      typename Indicator::Pointer indicator2 = Indicator::New();
-      indicator2->SetLowerThreshold(0);
-      indicator2->SetUpperThreshold(0);
-      indicator2->SetOutsideValue(0);
-      indicator2->SetInsideValue(
-        mapVorFilter->GetMaximalSquaredDistance() );
-      indicator2->SetInput( vorImageMap );
-      indicator2->Update();
-
-      mapVorFilter->SetInput1( indicator2->GetOutput() );
-      mapVorFilter->SetInput2( vorImageMap );
-      mapVorFilter->UseImageSpacingOff();
-      mapVorFilter->CreateVoronoiMapOn();
-      mapVorFilter->Update();
-      vorImageDistMap = mapVorFilter->GetOutput();
-      timeCollector.Stop("Voronoi Distance Map");
-      }
-    else
-      {
-      timeCollector.Start("Voronoi Distance Map");
-      typedef typename itk::SignedDanielssonDistanceMapImageFilter<
-        ImageType, ImageType>   SignedMapFilterType;
-      typename SignedMapFilterType::Pointer mapVorFilter =
-        SignedMapFilterType::New();
-      mapVorFilter->SetInput( vorImageMap );
-      mapVorFilter->SetUseImageSpacing( false );
-      mapVorFilter->Update();
-      vorImageDistMap = mapVorFilter->GetDistanceMap();
-      timeCollector.Stop("Voronoi Distance Map");
-      }
+    // The tile is blended into the output image in place
+    typename BlendFilterType::Pointer blendFilter = BlendFilterType::New();
+    blendFilter->SetInput( outImage );
+    blendFilter->SetTileImage( tmpImage );
+    blendFilter->SetBackground( background );
+    blendFilter->SetMask( mask );
 
-    timeCollector.Start("Voronoi Distance Selection");
-    iter2.GoToBegin();
-    iterOut.GoToBegin();
-    itk::ImageRegionIteratorWithIndex< ImageType > iterOutDistMap(
-      outImageDistMap, outImageDistMap->GetLargestPossibleRegion() );
-    itk::ImageRegionIteratorWithIndex< ImageType > iterVorDistMap(
-      vorImageDistMap, vorImageDistMap->GetLargestPossibleRegion() );
-    while( !iter2.IsAtEnd() )
+    typename ImageType::Pointer outImageDistMap = NULL;
+    typename ImageType::Pointer vorImageDistMap = NULL;
+    if( !averagePixels )
       {
-      double iVal = iter2.Get();
-      bool image2Point = false;
-      if( iVal != background && (!mask || iVal != 0) )
+      timeCollector.Start("Overlap Map");
+      OverlapLabelType overlapLabel;
+      overlapLabel.SetBackground( background );
+      overlapLabel.SetMask( mask );
+      typename OverlapFilterType::Pointer overlapFilter =
+        OverlapFilterType::New();
+      overlapFilter->SetInput1( outImage );
+      overlapFilter->SetInput2( tmpImage );
+      overlapFilter->SetFunctor( overlapLabel );
+      overlapFilter->Update();
+      typename ImageType::Pointer outImageMap = overlapFilter->GetOutput();
+      timeCollector.Stop("Overlap Map");
+
+      timeCollector.Start("Out Distance Map");
+      typename ImageType::Pointer outImageVoronoiMap = NULL;
+      if( useFastBlending )
         {
-        image2Point = true;
+        typename FastMapFilterType::Pointer mapDistFilter =
+          FastMapFilterType::New();
+
+        typename Indicator::Pointer indicator = Indicator::New();
+        indicator->SetLowerThreshold(0);
+        indicator->SetUpperThreshold(0);
+        indicator->SetOutsideValue(0);
+        indicator->SetInsideValue(
+          mapDistFilter->GetMaximalSquaredDistance() );
+        indicator->SetInput( outImageMap );
+        indicator->Update();
+
+        mapDistFilter->SetInput1( indicator->GetOutput() );
+        mapDistFilter->SetInput2( outImageMap );
+        mapDistFilter->UseImageSpacingOff();
+        mapDistFilter->CreateVoronoiMapOn();
+        mapDistFilter->Update();
+        outImageDistMap = mapDistFilter->GetOutput();
+        outImageVoronoiMap = mapDistFilter->GetVoronoiMap();
         }
-      double oVal = iterOut.Get();
-      bool imageOutPoint = false;
-      if( oVal != background && (!mask || oVal != 0) )
+      else
         {
-        imageOutPoint = true;
+        typedef typename itk::DanielssonDistanceMapImageFilter< ImageType,
+          ImageType>   MapFilterType;
+        typename MapFilterType::Pointer mapDistFilter = MapFilterType::New();
+        mapDistFilter->SetInput( outImageMap );
+        mapDistFilter->SetInputIsBinary( false );
+        mapDistFilter->SetUseImageSpacing( false );
+        mapDistFilter->Update();
+        outImageDistMap = mapDistFilter->GetDistanceMap();
+        outImageVoronoiMap = mapDistFilter->GetVoronoiMap();
         }
+      timeCollector.Stop("Out Distance Map");
+
+      progress += 1.0/(double)numberOfTiles * 0.2;
+      progressReporter.Report( progress );
+
+      // Select the pixels that are closest to the output image
+      timeCollector.Start("Distance Map Selection");
+      typename Indicator::Pointer vorSelection = Indicator::New();
+      vorSelection->SetLowerThreshold(1);
+      vorSelection->SetUpperThreshold(1);
+      vorSelection->SetInsideValue(1);
+      vorSelection->SetOutsideValue(0);
+      vorSelection->SetInput( outImageVoronoiMap );
+      vorSelection->Update();
+      typename ImageType::Pointer vorImageMap = vorSelection->GetOutput();
+      timeCollector.Stop("Distance Map Selection");
 
-      if( imageOutPoint )
+      timeCollector.Start("Voronoi Distance Map");
+      if( useFastBlending )
         {
-        if( image2Point )
-          {
-          double vDist = iterVorDistMap.Get();
-          double oDist = iterOutDistMap.Get();
-
-          if( vDist < 0 && !averagePixels )
-            {
-            vDist = -vDist;
-            double ratio = 0.5*vDist/(oDist+vDist) + 0.5;
-            oVal = ratio * oVal + (1-ratio)*iVal;
-            }
-          else if( vDist > 0 && !averagePixels )
-            {
-            double ratio = 0.5*vDist/(oDist+vDist) + 0.5;
-            oVal = ratio * iVal + (1-ratio)*oVal;
-            }
-          else
-            {
-            oVal = 0.5 * iVal + 0.5 * oVal;
-            }
-          }
+        typename FastMapFilterType::Pointer mapVorFilter =
+          FastMapFilterType::New();
+
+        typename Indicator::Pointer indicator2 = Indicator::New();
+        indicator2->SetLowerThreshold(0);
+        indicator2->SetUpperThreshold(0);
+        indicator2->SetOutsideValue(0);
+        indicator2->SetInsideValue(
+          mapVorFilter->GetMaximalSquaredDistance() );
+        indicator2->SetInput( vorImageMap );
+        indicator2->Update();
+
+        mapVorFilter->SetInput1( indicator2->GetOutput() );
+        mapVorFilter->SetInput2( vorImageMap );
+        mapVorFilter->UseImageSpacingOff();
+        mapVorFilter->CreateVoronoiMapOn();
+        mapVorFilter->Update();
+        vorImageDistMap = mapVorFilter->GetOutput();
         }
-      else if( image2Point )
+      else
         {
-        oVal = iVal;
+        typedef typename itk::SignedDanielssonDistanceMapImageFilter<
+          ImageType, ImageType>   SignedMapFilterType;
+        typename SignedMapFilterType::Pointer mapVorFilter =
+          SignedMapFilterType::New();
+        mapVorFilter->SetInput( vorImageMap );
+        mapVorFilter->SetUseImageSpacing( false );
+        mapVorFilter->Update();
+        vorImageDistMap = mapVorFilter->GetDistanceMap();
         }
+      timeCollector.Stop("Voronoi Distance Map");
 
-      iterOut.Set( oVal );
+      blendFilter->SetMergedDistanceImage( outImageDistMap );
+      blendFilter->SetSeamDistanceImage( vorImageDistMap );
+      }
+
+    timeCollector.Start("Blend");
+    blendFilter->Update();
+    outImage = blendFilter->GetOutput();
+    outImage->DisconnectPipeline();
+    timeCollector.Stop("Blend");
 
-      ++iter2;
-      ++iterOut;
-      ++iterOutDistMap;
-      ++iterVorDistMap;
+    if( averagePixels )
+      {
+      progress += 1.0/(double)numberOfTiles * 0.2;
+      progressReporter.Report( progress );
       }
-    timeCollector.Stop("Voronoi Distance Selection");
     }
 
   timeCollector.Start("Save data");
@@ -0,0 +1,182 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeTileBlendImageFilter_h
+#define __itktubeTileBlendImageFilter_h
+
+#include <itkInPlaceImageFilter.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+namespace Functor
+{
+
+/** \class TileOverlapLabel
+ * \brief Label a pixel of a merged image by the images that cover it.
+ *
+ * The label is 0 where both the merged image and the tile are valid, 1 where
+ * only the merged image is valid, 2 where only the tile is valid and 3 where
+ * neither is.  A pixel is valid if it differs from the background and, when
+ * masking, from zero. */
+template< class TInput1, class TInput2 = TInput1, class TOutput = TInput1 >
+class TileOverlapLabel
+{
+public:
+  TileOverlapLabel( void ) : m_Background( 0 ), m_Mask( false ) {}
+  ~TileOverlapLabel( void ) {}
+
+  void SetBackground( double background ) { m_Background = background; }
+  void SetMask( bool mask ) { m_Mask = mask; }
+
+  bool operator!=( const TileOverlapLabel & other ) const
+    {
+    return m_Background != other.m_Background || m_Mask != other.m_Mask;
+    }
+  bool operator==( const TileOverlapLabel & other ) const
+    {
+    return !( *this != other );
+    }
+
+  inline TOutput operator()( const TInput1 & merged,
+    const TInput2 & tile ) const
+    {
+    const bool mergedPoint = this->IsValid( merged );
+    const bool tilePoint = this->IsValid( tile );
+    if( mergedPoint && tilePoint )
+      {
+      return static_cast< TOutput >( 0 );
+      }
+    else if( tilePoint )
+      {
+      return static_cast< TOutput >( 2 );
+      }
+    else if( mergedPoint )
+      {
+      return static_cast< TOutput >( 1 );
+      }
+    return static_cast< TOutput >( 3 );
+    }
+
+private:
+  inline bool IsValid( double val ) const
+    {
+    return val != m_Background && ( !m_Mask || val != 0 );
+    }
+
+  double m_Background;
+  bool   m_Mask;
+
+}; // End class TileOverlapLabel
+
+} // End namespace Functor
+
+/** \class TileBlendImageFilter
+ * \brief Blend a resampled tile into a merged image, in place.
+ *
+ * The first input is the merged image and is overwritten by the output.
+ * The tile and the optional distance images have to share its grid.
+ *
+ * Where only the tile is valid, the tile value is copied.  Where both images
+ * are valid, they are averaged, unless both distance images are given: the
+ * distance to the nearest pixel that is not in the overlap and the signed
+ * distance to the seam between the images then weight the two values so
+ * that the output changes smoothly across the seam.
+ *
+ * All of this is done in one multithreaded pass over the output region. */
+template< class TImage >
+class TileBlendImageFilter
+  : public InPlaceImageFilter< TImage, TImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef TileBlendImageFilter                     Self;
+  typedef InPlaceImageFilter< TImage, TImage >     Superclass;
+  typedef SmartPointer< Self >                     Pointer;
+  typedef SmartPointer< const Self >               ConstPointer;
+
+  typedef TImage                                   ImageType;
+  typedef typename ImageType::PixelType            PixelType;
+  typedef typename ImageType::RegionType           RegionType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TileBlendImageFilter, InPlaceImageFilter );
+
+  /** Set/Get the tile that is blended into the merged image. */
+  void SetTileImage( const ImageType * tile );
+  const ImageType * GetTileImage( void ) const;
+
+  /** Set/Get the distance to the nearest pixel outside of the overlap. */
+  void SetMergedDistanceImage( const ImageType * distance );
+  const ImageType * GetMergedDistanceImage( void ) const;
+
+  /** Set/Get the signed distance to the seam between the images. */
+  void SetSeamDistanceImage( const ImageType * distance );
+  const ImageType * GetSeamDistanceImage( void ) const;
+
+  /** Value of the pixels that are not covered by an image. */
+  itkSetMacro( Background, double );
+  itkGetMacro( Background, double );
+
+  /** Ignore zero-valued pixels. */
+  itkSetMacro( Mask, bool );
+  itkGetMacro( Mask, bool );
+  itkBooleanMacro( Mask );
+
+protected:
+
+  TileBlendImageFilter( void );
+  virtual ~TileBlendImageFilter( void ) {}
+
+  void ThreadedGenerateData( const RegionType & outputRegionForThread,
+    ThreadIdType threadId );
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  // Purposely not implemented
+  TileBlendImageFilter( const Self & );
+  void operator=( const Self & );
+
+  double m_Background;
+  bool   m_Mask;
+
+}; // End class TileBlendImageFilter
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeTileBlendImageFilter.hxx"
+#endif
+
+#endif // End !defined(__itktubeTileBlendImageFilter_h)
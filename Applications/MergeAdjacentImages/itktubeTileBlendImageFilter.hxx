@@ -0,0 +1,205 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeTileBlendImageFilter_hxx
+#define __itktubeTileBlendImageFilter_hxx
+
+#include "itktubeTileBlendImageFilter.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< class TImage >
+TileBlendImageFilter< TImage >
+::TileBlendImageFilter( void )
+{
+  m_Background = 0;
+  m_Mask = false;
+
+  this->SetNumberOfRequiredInputs( 2 );
+  this->InPlaceOn();
+}
+
+template< class TImage >
+void
+TileBlendImageFilter< TImage >
+::SetTileImage( const ImageType * tile )
+{
+  this->SetNthInput( 1, const_cast< ImageType * >( tile ) );
+}
+
+template< class TImage >
+const typename TileBlendImageFilter< TImage >::ImageType *
+TileBlendImageFilter< TImage >
+::GetTileImage( void ) const
+{
+  return static_cast< const ImageType * >(
+    this->ProcessObject::GetInput( 1 ) );
+}
+
+template< class TImage >
+void
+TileBlendImageFilter< TImage >
+::SetMergedDistanceImage( const ImageType * distance )
+{
+  this->SetNthInput( 2, const_cast< ImageType * >( distance ) );
+}
+
+template< class TImage >
+const typename TileBlendImageFilter< TImage >::ImageType *
+TileBlendImageFilter< TImage >
+::GetMergedDistanceImage( void ) const
+{
+  return static_cast< const ImageType * >(
+    this->ProcessObject::GetInput( 2 ) );
+}
+
+template< class TImage >
+void
+TileBlendImageFilter< TImage >
+::SetSeamDistanceImage( const ImageType * distance )
+{
+  this->SetNthInput( 3, const_cast< ImageType * >( distance ) );
+}
+
+template< class TImage >
+const typename TileBlendImageFilter< TImage >::ImageType *
+TileBlendImageFilter< TImage >
+::GetSeamDistanceImage( void ) const
+{
+  return static_cast< const ImageType * >(
+    this->ProcessObject::GetInput( 3 ) );
+}
+
+template< class TImage >
+void
+TileBlendImageFilter< TImage >
+::ThreadedGenerateData( const RegionType & outputRegionForThread,
+  ThreadIdType itkNotUsed( threadId ) )
+{
+  const ImageType * mergedDistance = this->GetMergedDistanceImage();
+  const ImageType * seamDistance = this->GetSeamDistanceImage();
+  const bool useDistances = ( mergedDistance != NULL
+    && seamDistance != NULL );
+
+  // When running in place, the merged image and the output share a buffer
+  ImageRegionConstIterator< ImageType > itMerged( this->GetInput(),
+    outputRegionForThread );
+  ImageRegionConstIterator< ImageType > itTile( this->GetTileImage(),
+    outputRegionForThread );
+  ImageRegionIterator< ImageType > itOut( this->GetOutput(),
+    outputRegionForThread );
+  ImageRegionConstIterator< ImageType > itMergedDistance;
+  ImageRegionConstIterator< ImageType > itSeamDistance;
+  if( useDistances )
+    {
+    itMergedDistance = ImageRegionConstIterator< ImageType >(
+      mergedDistance, outputRegionForThread );
+    itSeamDistance = ImageRegionConstIterator< ImageType >(
+      seamDistance, outputRegionForThread );
+    }
+
+  while( !itOut.IsAtEnd() )
+    {
+    double iVal = itTile.Get();
+    bool tilePoint = false;
+    if( iVal != m_Background && ( !m_Mask || iVal != 0 ) )
+      {
+      tilePoint = true;
+      }
+    double oVal = itMerged.Get();
+    bool mergedPoint = false;
+    if( oVal != m_Background && ( !m_Mask || oVal != 0 ) )
+      {
+      mergedPoint = true;
+      }
+
+    if( mergedPoint )
+      {
+      if( tilePoint )
+        {
+        double vDist = 0;
+        double oDist = 0;
+        if( useDistances )
+          {
+          vDist = itSeamDistance.Get();
+          oDist = itMergedDistance.Get();
+          }
+
+        if( vDist < 0 )
+          {
+          vDist = -vDist;
+          double ratio = 0.5*vDist/(oDist+vDist) + 0.5;
+          oVal = ratio * oVal + (1-ratio)*iVal;
+          }
+        else if( vDist > 0 )
+          {
+          double ratio = 0.5*vDist/(oDist+vDist) + 0.5;
+          oVal = ratio * iVal + (1-ratio)*oVal;
+          }
+        else
+          {
+          oVal = 0.5 * iVal + 0.5 * oVal;
+          }
+        }
+      }
+    else if( tilePoint )
+      {
+      oVal = iVal;
+      }
+
+    itOut.Set( static_cast< PixelType >( oVal ) );
+
+    ++itMerged;
+    ++itTile;
+    ++itOut;
+    if( useDistances )
+      {
+      ++itMergedDistance;
+      ++itSeamDistance;
+      }
+    }
+}
+
+template< class TImage >
+void
+TileBlendImageFilter< TImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Background: " << m_Background << std::endl;
+  os << indent << "Mask: " << m_Mask << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeTileBlendImageFilter_hxx)
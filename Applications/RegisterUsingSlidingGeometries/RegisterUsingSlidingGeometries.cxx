@@ -41,6 +41,8 @@ limitations under the License.
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkXMLPolyDataReader.h>
 
+#include <fstream>
+
 #include "RegisterUsingSlidingGeometriesCLP.h"
 
 template< class TPixel, unsigned int VDimension >
@@ -117,6 +119,138 @@ bool ReorientAndWriteImage( TImage * inputImage,
   return true;
 }
 
+// Image filenames of a geometry cache
+std::string GetGeometryCacheImageFileName( const std::string & cacheFileName,
+                                           const std::string & imageName )
+{
+  std::string base = cacheFileName;
+  std::string::size_type loc = base.find_last_of(".");
+  if( loc != std::string::npos
+      && ( base.find_last_of("/\\") == std::string::npos
+           || loc > base.find_last_of("/\\") ) )
+    {
+    base = base.substr( 0, loc );
+    }
+  return base + imageName + ".mha";
+}
+
+// Read a cached image, which is stored in the internal (axial) orientation
+template< class TImage >
+bool ReadGeometryCacheImage( TImage & outputImage, std::string fileName )
+{
+  typedef typename TImage::ObjectType ObjectType;
+
+  typedef itk::ImageFileReader< ObjectType > FileReaderType;
+  typename FileReaderType::Pointer imageReader = FileReaderType::New();
+  imageReader->SetFileName( fileName.c_str() );
+  try
+    {
+    imageReader->Update();
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    tube::ErrorMessage( "Reading geometry cache: Exception caught: "
+                        + std::string(err.GetDescription()) );
+    return false;
+    }
+  outputImage = imageReader->GetOutput();
+  return true;
+}
+
+// Write a cached image in the internal (axial) orientation
+template< class TImage >
+bool WriteGeometryCacheImage( TImage * inputImage, std::string fileName )
+{
+  typedef itk::ImageFileWriter< TImage > FileWriterType;
+  typename FileWriterType::Pointer imageWriter = FileWriterType::New();
+  imageWriter->SetFileName( fileName );
+  imageWriter->SetUseCompression( true );
+  imageWriter->SetInput( inputImage );
+  try
+    {
+    imageWriter->Update();
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    tube::ErrorMessage( "Writing geometry cache: Exception caught: "
+                        + std::string(err.GetDescription()) );
+    return false;
+    }
+  return true;
+}
+
+// Load the normal matrix and weight images from a geometry cache.  Returns
+// false if there is no cache or if it was computed from a different geometry.
+template< class TFilter >
+bool ReadGeometryCache( TFilter * filter, const std::string & cacheFileName,
+                        const std::string & hash )
+{
+  std::ifstream cacheFile( cacheFileName.c_str() );
+  if( !cacheFile )
+    {
+    return false;
+    }
+  std::string key;
+  std::string cachedHash;
+  cacheFile >> key >> cachedHash;
+  if( key != "GeometryHash" || cachedHash != hash )
+    {
+    tube::InformationMessage( "Geometry cache is stale: recomputing" );
+    return false;
+    }
+
+  typename TFilter::NormalMatrixImageType::Pointer normalImage = 0;
+  typename TFilter::WeightMatrixImageType::Pointer weightStructuresImage = 0;
+  typename TFilter::WeightComponentImageType::Pointer
+      weightRegularizationsImage = 0;
+  if( !ReadGeometryCacheImage( normalImage, GetGeometryCacheImageFileName(
+        cacheFileName, "NormalMatrix" ) )
+      || !ReadGeometryCacheImage( weightStructuresImage,
+        GetGeometryCacheImageFileName( cacheFileName, "WeightStructures" ) )
+      || !ReadGeometryCacheImage( weightRegularizationsImage,
+        GetGeometryCacheImageFileName( cacheFileName,
+                                       "WeightRegularizations" ) ) )
+    {
+    return false;
+    }
+  filter->SetNormalMatrixImage( normalImage );
+  filter->SetWeightStructuresImage( weightStructuresImage );
+  filter->SetWeightRegularizationsImage( weightRegularizationsImage );
+  return true;
+}
+
+// Save the high resolution normal matrix and weight images to a geometry
+// cache, stamped with the hash of the geometry they were computed from
+template< class TFilter >
+bool WriteGeometryCache( TFilter * filter, const std::string & cacheFileName,
+                         const std::string & hash )
+{
+  if( !WriteGeometryCacheImage(
+        filter->GetHighResolutionNormalMatrixImage(),
+        GetGeometryCacheImageFileName( cacheFileName, "NormalMatrix" ) )
+      || !WriteGeometryCacheImage(
+        filter->GetHighResolutionWeightStructuresImage(),
+        GetGeometryCacheImageFileName( cacheFileName, "WeightStructures" ) )
+      || !WriteGeometryCacheImage(
+        filter->GetHighResolutionWeightRegularizationsImage(),
+        GetGeometryCacheImageFileName( cacheFileName,
+                                       "WeightRegularizations" ) ) )
+    {
+    return false;
+    }
+
+  // The hash is written last, so an interrupted write leaves a stale cache
+  std::ofstream cacheFile( cacheFileName.c_str() );
+  if( !cacheFile )
+    {
+    tube::ErrorMessage( "Writing geometry cache: cannot open "
+                        + cacheFileName );
+    return false;
+    }
+  cacheFile << "GeometryHash " << hash << std::endl;
+  return true;
+}
+
 // Your code should be within the DoIt function...
 template< class TPixel, unsigned int VDimension >
 int DoIt( int argc, char * argv[] )
@@ -650,6 +784,79 @@ int DoIt( int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  // Reuse the normal matrix and weight images of a geometry cache, or compute
+  // and cache them.  Images given on the command line are never replaced by
+  // cached ones, so the cache is not used with them.
+  bool useGeometryCache = ( geometryCacheFileName != "" );
+  if( useGeometryCache && !sparseAnisotropicRegistrator )
+    {
+    tube::WarningMessage( "The geometry cache applies to sparse sliding "
+                          "organ registration only" );
+    useGeometryCache = false;
+    }
+  if( useGeometryCache
+      && ( inputNormalVectorImageFileName != ""
+           || inputWeightStructuresImageFileName != ""
+           || inputWeightRegularizationsImageFileName != "" ) )
+    {
+    tube::WarningMessage( "The geometry cache is not used when normal or "
+                          "weight images are given" );
+    useGeometryCache = false;
+    }
+  if( useGeometryCache )
+    {
+    timeCollector.Start( "Geometry cache" );
+    sparseAnisotropicRegistrator->SetLambda( lambda );
+    sparseAnisotropicRegistrator->SetGamma( gamma );
+    sparseAnisotropicRegistrator->SetHighResolutionTemplate(
+        orientFixed->GetOutput() );
+    std::string hash = sparseAnisotropicRegistrator->ComputeGeometryHash();
+    if( !ReadGeometryCache( sparseAnisotropicRegistrator.GetPointer(),
+                            geometryCacheFileName, hash ) )
+      {
+      bool success = true;
+      try
+        {
+        sparseAnisotropicRegistrator
+            ->ComputeHighResolutionNormalMatrixAndWeightImages();
+        }
+      catch( itk::ExceptionObject & err )
+        {
+        tube::ErrorMessage( "Computing geometry: Exception caught: "
+                            + std::string(err.GetDescription()) );
+        success = false;
+        }
+      if( !success || !WriteGeometryCache(
+            sparseAnisotropicRegistrator.GetPointer(),
+            geometryCacheFileName, hash ) )
+        {
+        timeCollector.Report();
+        if( tubeSpatialObjectFileName != "" )
+          {
+          delete tubeList;
+          }
+        return EXIT_FAILURE;
+        }
+      }
+    timeCollector.Stop( "Geometry cache" );
+    }
+  if( computeGeometryOnly )
+    {
+    timeCollector.Report();
+    if( sparseAnisotropicRegistrator && tubeSpatialObjectFileName != "" )
+      {
+      delete tubeList;
+      }
+    if( !useGeometryCache )
+      {
+      tube::ErrorMessage( "Computing the geometry only requires sparse "
+                          "sliding organ registration and a geometry cache, "
+                          "without normal or weight images" );
+      return EXIT_FAILURE;
+      }
+    return EXIT_SUCCESS;
+    }
+
   // Error checking on number of iterations
   if( numberOfIterations.size() <= 0 )
     {
@@ -662,6 +869,19 @@ int DoIt( int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  // Error checking on checkpointing
+  if( resumeFromCheckpoint && checkpointFileName == "" )
+    {
+    tube::ErrorMessage( "Resuming from a checkpoint requires a checkpoint "
+                        "file." );
+    timeCollector.Report();
+    if( sparseAnisotropicRegistrator && tubeSpatialObjectFileName != "" )
+      {
+      delete tubeList;
+      }
+    return EXIT_FAILURE;
+    }
+
   // Error checking on regularization weightings
   if( regularizationWeightings.size() <= 0 )
     {
@@ -704,6 +924,11 @@ int DoIt( int argc, char * argv[] )
   registrator->SetStoppingCriterionEvaluationPeriod(
         static_cast<unsigned int>(stoppingCriterionPeriod));
   registrator->SetStoppingCriterionMaxTotalEnergyChange(maximumTotalEnergyChange);
+  registrator->SetCheckpointFileName( checkpointFileName );
+  registrator->SetCheckpointIterationPeriod(
+        static_cast<unsigned int>(checkpointIterationPeriod));
+  registrator->SetCheckpointTimePeriod( checkpointTimePeriod );
+  registrator->SetResumeFromCheckpoint( resumeFromCheckpoint );
 
   // Setup the multiresolution PDE filter - we use the recursive pyramid because
   // we don't want the deformation field to undergo Gaussian smoothing on the
@@ -24,6 +24,8 @@ limitations under the License.
 #include "tubeCLIFilterWatcher.h"
 #include "tubeCLIProgressReporter.h"
 
+#include "itktubeVotingResampleImageFilter.h"
+
 #include <itkBSplineInterpolateImageFunction.h>
 #include <itkCompensatedSummation.h>
 #include <itkImageFileReader.h>
@@ -181,69 +183,103 @@ int DoIt( int argc, char * argv[] )
     }
 
   typename OutputImageType::Pointer outIm;
-  {
-  timeCollector.Start( "Resample" );
-  reporter.Report( 0.25 );
-  typedef typename itk::ResampleImageFilter< InputImageType,
-          OutputImageType >             ResampleFilterType;
-
-  typename ResampleFilterType::Pointer filter = ResampleFilterType::New();
-
-  filter->SetInput( inIm );
-
-  typedef typename itk::InterpolateImageFunction< InputImageType,
-          double >                      InterpType;
-  typename InterpType::Pointer interp;
-  if( interpolator == "BSpline" )
-    {
-    typedef typename itk::BSplineInterpolateImageFunction< InputImageType,
-            double >                    MyInterpType;
-    interp = MyInterpType::New();
-    }
-  else if( interpolator == "NearestNeighbor" )
+  if( interpolator == "Voting" && loadTransform.size() == 0
+    && outDirection == inDirection )
     {
-    typedef typename itk::NearestNeighborInterpolateImageFunction<
-            InputImageType, double >    MyInterpType;
-    interp = MyInterpType::New();
+    // Label maps resampled without rotation use the dedicated filter.
+    timeCollector.Start( "Resample" );
+    reporter.Report( 0.25 );
+    typedef typename itk::tube::VotingResampleImageFilter< InputImageType,
+            OutputImageType >           VotingFilterType;
+
+    typename VotingFilterType::Pointer filter = VotingFilterType::New();
+    filter->SetInput( inIm );
+    filter->SetSize( outSize );
+    filter->SetOutputStartIndex( outIndex );
+    filter->SetOutputOrigin( outOrigin );
+    filter->SetOutputSpacing( outSpacing );
+    filter->SetOutputDirection( outDirection );
+    filter->SetDefaultPixelValue( 0 );
+    tube::CLIFilterWatcher  watcher( filter,
+                                     "Voting Resample Filter",
+                                     CLPProcessInformation,
+                                     0.7,
+                                     0.25,
+                                     true );
+    filter->Update();
+
+    outIm = filter->GetOutput();
     }
-  else // default = if( interpolator == "Linear" )
+  else
     {
-    typedef typename itk::LinearInterpolateImageFunction<
-            InputImageType, double >    MyInterpType;
-    interp = MyInterpType::New();
-    }
-  filter->SetInterpolator( interp );
+    timeCollector.Start( "Resample" );
+    reporter.Report( 0.25 );
+    typedef typename itk::ResampleImageFilter< InputImageType,
+            OutputImageType >             ResampleFilterType;
 
-  if( loadTransform.size() > 0 )
-    {
-    itk::TransformFileReader::Pointer treader =
-      itk::TransformFileReader::New();
-    treader->SetFileName(loadTransform);
-    treader->Update();
+    typename ResampleFilterType::Pointer filter = ResampleFilterType::New();
 
-    typedef itk::Transform<double, DimensionI, DimensionI> TransformType;
-    typename TransformType::Pointer tfm = static_cast< TransformType * >(
-      treader->GetTransformList()->front().GetPointer() );
+    filter->SetInput( inIm );
 
-    filter->SetTransform( tfm );
-    }
+    typedef typename itk::InterpolateImageFunction< InputImageType,
+            double >                      InterpType;
+    typename InterpType::Pointer interp;
+    if( interpolator == "BSpline" )
+      {
+      typedef typename itk::BSplineInterpolateImageFunction< InputImageType,
+              double >                    MyInterpType;
+      interp = MyInterpType::New();
+      }
+    else if( interpolator == "NearestNeighbor" )
+      {
+      typedef typename itk::NearestNeighborInterpolateImageFunction<
+              InputImageType, double >    MyInterpType;
+      interp = MyInterpType::New();
+      }
+    else if( interpolator == "Voting" )
+      {
+      typedef typename itk::tube::VotingResampleImageFunction<
+              InputImageType, double >    MyInterpType;
+      interp = MyInterpType::New();
+      }
+    else // default = if( interpolator == "Linear" )
+      {
+      typedef typename itk::LinearInterpolateImageFunction<
+              InputImageType, double >    MyInterpType;
+      interp = MyInterpType::New();
+      }
+    filter->SetInterpolator( interp );
 
-  filter->SetSize( outSize );
-  filter->SetOutputStartIndex( outIndex );
-  filter->SetOutputOrigin( outOrigin );
-  filter->SetOutputSpacing( outSpacing );
-  filter->SetOutputDirection( outDirection );
-  filter->SetDefaultPixelValue( 0 );
-  tube::CLIFilterWatcher  watcher( filter,
-                                   "Resample Filter",
-                                   CLPProcessInformation,
-                                   0.7,
-                                   0.25,
-                                   true );
-  filter->Update();
-
-  outIm = filter->GetOutput();
-  }
+    if( loadTransform.size() > 0 )
+      {
+      itk::TransformFileReader::Pointer treader =
+        itk::TransformFileReader::New();
+      treader->SetFileName(loadTransform);
+      treader->Update();
+
+      typedef itk::Transform<double, DimensionI, DimensionI> TransformType;
+      typename TransformType::Pointer tfm = static_cast< TransformType * >(
+        treader->GetTransformList()->front().GetPointer() );
+
+      filter->SetTransform( tfm );
+      }
+
+    filter->SetSize( outSize );
+    filter->SetOutputStartIndex( outIndex );
+    filter->SetOutputOrigin( outOrigin );
+    filter->SetOutputSpacing( outSpacing );
+    filter->SetOutputDirection( outDirection );
+    filter->SetDefaultPixelValue( 0 );
+    tube::CLIFilterWatcher  watcher( filter,
+                                     "Resample Filter",
+                                     CLPProcessInformation,
+                                     0.7,
+                                     0.25,
+                                     true );
+    filter->Update();
+
+    outIm = filter->GetOutput();
+    }
   reporter.Report( 0.95 );
   timeCollector.Stop( "Resample" );
 
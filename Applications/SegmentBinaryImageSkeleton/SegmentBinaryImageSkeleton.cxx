@@ -21,6 +21,7 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeSparseSkeletonizationImageFilter.h"
 #include "tubeCLIFilterWatcher.h"
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
@@ -32,6 +33,8 @@ limitations under the License.
 #include <itkImageFileWriter.h>
 #include <itkTimeProbesCollectorBase.h>
 
+#include <fstream>
+
 #include "SegmentBinaryImageSkeletonCLP.h"
 
 template< class TPixel, unsigned int VDimension >
@@ -82,6 +85,8 @@ int DoIt( int argc, char * argv[] )
 
   typedef itk::BinaryThinningImageFilter< ImageType, ImageType >
     FilterType;
+  typedef itk::tube::SparseSkeletonizationImageFilter< ImageType, ImageType >
+    SkeletonFilterType;
   typedef itk::BinaryBallStructuringElement< PixelType, VDimension>
     SEType;
   typedef itk::BinaryDilateImageFilter< ImageType, ImageType, SEType >
@@ -91,16 +96,59 @@ int DoIt( int argc, char * argv[] )
   // Progress per iteration
   double progressFraction = 0.8/VDimension;
 
-  typename FilterType::Pointer filter = FilterType::New();
-  filter->SetInput( curImage );
-  tube::CLIFilterWatcher watcher( filter,
-                                  "Binary Thinning",
-                                  CLPProcessInformation,
-                                  progressFraction,
-                                  progress,
-                                  true );
-  filter->Update();
-  curImage = filter->GetOutput();
+  if( useBinaryThinning )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( curImage );
+    tube::CLIFilterWatcher watcher( filter,
+                                    "Binary Thinning",
+                                    CLPProcessInformation,
+                                    progressFraction,
+                                    progress,
+                                    true );
+    filter->Update();
+    curImage = filter->GetOutput();
+    }
+  else
+    {
+    typename SkeletonFilterType::Pointer filter = SkeletonFilterType::New();
+    filter->SetInput( curImage );
+    filter->SetBlockSize( blockSize );
+    tube::CLIFilterWatcher watcher( filter,
+                                    "Sparse Skeletonization",
+                                    CLPProcessInformation,
+                                    progressFraction,
+                                    progress,
+                                    true );
+    filter->Update();
+    curImage = filter->GetOutput();
+
+    if( !outputSkeletonPoints.empty() )
+      {
+      // One skeleton point per line: physical position, then the number
+      // of skeleton neighbors (1 at ends, more than 2 at junctions).
+      std::ofstream writeStream( outputSkeletonPoints.c_str() );
+      if( !writeStream.is_open() )
+        {
+        tube::ErrorMessage( "Cannot write skeleton points to "
+                            + outputSkeletonPoints );
+        timeCollector.Report();
+        return EXIT_FAILURE;
+        }
+      writeStream.precision( 6 );
+      const typename SkeletonFilterType::SkeletonPointListType & points =
+        filter->GetSkeletonPoints();
+      for( unsigned int i = 0; i < points.size(); ++i )
+        {
+        for( unsigned int j = 0; j < VDimension; ++j )
+          {
+          writeStream << points[i].Position[j] << " ";
+          }
+        writeStream << points[i].NumberOfNeighbors << std::endl;
+        }
+      writeStream.close();
+      }
+    }
   timeCollector.Stop("Binary Thinning");
 
   if( radius > 0 )
@@ -117,7 +165,7 @@ int DoIt( int argc, char * argv[] )
     dilator->Update();
     curImage = dilator->GetOutput();
     }
-  
+
   typedef itk::ImageFileWriter< ImageType  >   ImageWriterType;
 
   timeCollector.Start("Save data");
@@ -26,6 +26,8 @@ limitations under the License.
 
 #include "SegmentConnectedComponentsUsingParzenPDFsCLP.h"
 
+#include <itkImageDuplicator.h>
+
 // Get the component type and dimension of the image.
 void GetImageInformation( const std::string & fileName,
                           itk::ImageIOBase::IOComponentType & componentType,
@@ -97,6 +99,13 @@ int DoIt( int argc, char * argv[] )
     PDFSegmenterType;
   typename PDFSegmenterType::Pointer pdfSegmenter = PDFSegmenterType::New();
 
+  typedef typename PDFSegmenterType::SampleHistogramImageType
+    SampleHistogramImageType;
+  typedef itk::ImageFileReader< SampleHistogramImageType >
+    SampleHistogramReaderType;
+  typedef itk::ImageFileWriter< SampleHistogramImageType >
+    SampleHistogramWriterType;
+
   timeCollector.Start( "LoadData" );
 
   typename LabelMapReaderType::Pointer  inLabelMapReader =
@@ -143,6 +152,40 @@ int DoIt( int argc, char * argv[] )
     pdfSegmenter->SetInput( i, reader->GetOutput() );
     }
 
+  // Read the previous state before the new one is written, since both
+  // may share a base name
+  typename LabelMapType::Pointer previousLabelMap;
+  if( loadPDFStateBase.size() > 0 )
+    {
+    typename LabelMapReaderType::Pointer previousLabelMapReader =
+      LabelMapReaderType::New();
+    previousLabelMapReader->SetFileName(
+      ( loadPDFStateBase + ".labelmap.mha" ).c_str() );
+    previousLabelMapReader->Update();
+    previousLabelMap = previousLabelMapReader->GetOutput();
+    if( !CheckImageAttributes( previousLabelMap.GetPointer(),
+        inLabelMapReader->GetOutput() ) )
+      {
+      std::cout << "Image attributes of the previous and current label "
+        << "maps do not match.  Please check size, spacing, origin."
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The label map is overwritten by the classification, so the labels
+  // the PDFs are trained on are kept for the state
+  typename LabelMapType::Pointer trainingLabelMap;
+  if( savePDFStateBase.size() > 0 )
+    {
+    typedef itk::ImageDuplicator< LabelMapType > LabelMapDuplicatorType;
+    typename LabelMapDuplicatorType::Pointer labelMapDuplicator =
+      LabelMapDuplicatorType::New();
+    labelMapDuplicator->SetInputImage( inLabelMapReader->GetOutput() );
+    labelMapDuplicator->Update();
+    trainingLabelMap = labelMapDuplicator->GetOutput();
+    }
+
   timeCollector.Stop( "LoadData" );
 
   pdfSegmenter->SetObjectId( objectId[0] );
@@ -171,7 +214,31 @@ int DoIt( int argc, char * argv[] )
     pdfSegmenter->SetForceClassification( true );
     }
 
-  if( loadClassPDFBase.size() > 0 )
+  if( loadPDFStateBase.size() > 0 )
+    {
+    unsigned int numClasses = pdfSegmenter->GetNumberOfClasses();
+    for( unsigned int i = 0; i < numClasses; i++ )
+      {
+      std::string fname = loadPDFStateBase;
+      char c[80];
+      std::sprintf(c, ".c%u.samples.mha", i );
+      fname += std::string( c );
+      typename SampleHistogramReaderType::Pointer sampleHistogramReader =
+        SampleHistogramReaderType::New();
+      sampleHistogramReader->SetFileName( fname.c_str() );
+      sampleHistogramReader->Update();
+      pdfSegmenter->SetClassSampleHistogram( i,
+        sampleHistogramReader->GetOutput() );
+      }
+    pdfSegmenter->UpdateFromLabelMapChanges( previousLabelMap );
+    if( pdfSegmenter->GetRetrainedAllClasses() )
+      {
+      std::cout << "Samples lie outside of the histogram bins of the "
+        << "previous training; retrained all classes." << std::endl;
+      }
+    pdfSegmenter->ClassifyImages();
+    }
+  else if( loadClassPDFBase.size() > 0 )
     {
     unsigned int numClasses = pdfSegmenter->GetNumberOfClasses();
     std::cout << "loading classes" << std::endl;
@@ -254,6 +321,46 @@ int DoIt( int argc, char * argv[] )
       }
     }
 
+  if( savePDFStateBase.size() > 0 )
+    {
+    unsigned int numClasses = pdfSegmenter->GetNumberOfClasses();
+    bool hasSampleHistograms = true;
+    for( unsigned int i = 0; i < numClasses; i++ )
+      {
+      if( pdfSegmenter->GetClassSampleHistogram( i ).IsNull() )
+        {
+        hasSampleHistograms = false;
+        }
+      }
+    if( hasSampleHistograms )
+      {
+      for( unsigned int i = 0; i < numClasses; i++ )
+        {
+        std::string fname = savePDFStateBase;
+        char c[80];
+        std::sprintf(c, ".c%u.samples.mha", i );
+        fname += std::string( c );
+        typename SampleHistogramWriterType::Pointer sampleHistogramWriter =
+          SampleHistogramWriterType::New();
+        sampleHistogramWriter->SetFileName( fname.c_str() );
+        sampleHistogramWriter->SetInput(
+          pdfSegmenter->GetClassSampleHistogram( i ) );
+        sampleHistogramWriter->Update();
+        }
+      typename LabelMapWriterType::Pointer labelMapWriter =
+        LabelMapWriterType::New();
+      labelMapWriter->SetFileName(
+        ( savePDFStateBase + ".labelmap.mha" ).c_str() );
+      labelMapWriter->SetInput( trainingLabelMap );
+      labelMapWriter->Update();
+      }
+    else
+      {
+      std::cout << "No sample histograms to save when the PDFs are "
+        << "loaded." << std::endl;
+      }
+    }
+
   timeCollector.Stop( "Save" );
 
   timeCollector.Report();
@@ -21,11 +21,13 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeImageQuantileCalculator.h"
 #include "tubeCLIProgressReporter.h"
 #include "tubeMessage.h"
 
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
+#include <itkImageRegionConstIterator.h>
 #include <itkTimeProbesCollectorBase.h>
 #include <itkBinaryThresholdImageFilter.h>
 
@@ -101,57 +103,77 @@ int DoIt( int argc, char * argv[] )
 
   if( thresholdQuantile >= 0 && thresholdQuantile <= 1.0 )
     {
-    timeCollector.Start( "Boost accumulate" );
-
-    typedef boost::accumulators::accumulator_set< PixelType,
-      boost::accumulators::stats<
-        boost::accumulators::tag::p_square_quantile > >
-      QuantileAccumulatorType;
-    typedef itk::ImageRegionConstIterator< ImageType >
-      ImageIteratorType;
-
-    /*
-     * Create a and configure a vector of length N of pointers
-     * to BOOST accumulators -- Each of the N accumulators will
-     * estimate exactly one of the given N desired quantile. If
-     * the desired quantile is not within (0,1), throw an exception.
-     */
-    QuantileAccumulatorType acc( boost::accumulators::quantile_probability
-      = thresholdQuantile );
-
-    /*
-     * Use an image iterator to iterate over all pixel/voxel and
-     * and then add those values to the accumulators. Adding
-     * the values will incrementally compute the quantile estimates.
-     */
-    ImageIteratorType imIt( image, image->GetLargestPossibleRegion() );
-    if( !maskVolume.empty() )
+    timeCollector.Start( "Quantile threshold" );
+
+    PixelType qVal = 0;
+    if( approximate )
       {
-      ImageIteratorType maskIt( maskImage,
-        maskImage->GetLargestPossibleRegion() );
-      while( !imIt.IsAtEnd() )
+      // P^2 estimate, as computed by earlier versions
+      typedef boost::accumulators::accumulator_set< PixelType,
+        boost::accumulators::stats<
+          boost::accumulators::tag::p_square_quantile > >
+        QuantileAccumulatorType;
+      typedef itk::ImageRegionConstIterator< ImageType >
+        ImageIteratorType;
+
+      QuantileAccumulatorType acc( boost::accumulators::quantile_probability
+        = thresholdQuantile );
+
+      ImageIteratorType imIt( image, image->GetLargestPossibleRegion() );
+      if( !maskVolume.empty() )
         {
-        PixelType p = imIt.Get();
-        PixelType m = maskIt.Get();
-        if( m != 0 )
+        ImageIteratorType maskIt( maskImage,
+          maskImage->GetLargestPossibleRegion() );
+        while( !imIt.IsAtEnd() )
           {
-          acc( p );
+          if( maskIt.Get() != 0 )
+            {
+            acc( imIt.Get() );
+            }
+          ++imIt;
+          ++maskIt;
           }
-        ++imIt;
-        ++maskIt;
         }
+      else
+        {
+        while( !imIt.IsAtEnd() )
+          {
+          acc( imIt.Get() );
+          ++imIt;
+          }
+        }
+
+      qVal = boost::accumulators::p_square_quantile( acc );
       }
     else
       {
-      while( !imIt.IsAtEnd() )
+      typedef itk::tube::ImageQuantileCalculator< ImageType, ImageType >
+        QuantileCalculatorType;
+
+      typename QuantileCalculatorType::Pointer calculator =
+        QuantileCalculatorType::New();
+      calculator->SetImage( image );
+      if( !maskVolume.empty() )
         {
-        PixelType p = imIt.Get();
-        acc( p );
-        ++imIt;
+        calculator->SetMask( maskImage );
+        }
+      typename QuantileCalculatorType::QuantileListType quantiles( 1,
+        thresholdQuantile );
+      calculator->SetQuantiles( quantiles );
+      try
+        {
+        calculator->Compute();
+        }
+      catch( itk::ExceptionObject & err )
+        {
+        tube::ErrorMessage( "Computing quantile: Exception caught: "
+                            + std::string( err.GetDescription() ) );
+        timeCollector.Report();
+        return EXIT_FAILURE;
         }
-      }
 
-    PixelType qVal = boost::accumulators::p_square_quantile( acc );
+      qVal = static_cast< PixelType >( calculator->GetQuantileValues()[0] );
+      }
 
     typedef itk::BinaryThresholdImageFilter< ImageType, ImageType >
       FilterType;
@@ -166,7 +188,7 @@ int DoIt( int argc, char * argv[] )
 
     image = filter->GetOutput();
 
-    timeCollector.Stop( "Boost accumulate" );
+    timeCollector.Stop( "Quantile threshold" );
     }
 
   typedef itk::ImageFileWriter< ImageType  >   ImageWriterType;
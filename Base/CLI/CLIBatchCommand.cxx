@@ -0,0 +1,287 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+// Runs a chain of TubeTK CLI modules in one process.
+//
+// Each line of the chain file names a module followed by its command-line
+// arguments, exactly as they would be given to the module's executable.
+// Blank lines and lines starting with '#' are ignored, arguments containing
+// spaces can be enclosed in double quotes, and ${SCRATCH} is replaced by the
+// scratch directory.  For example:
+//
+//   ResampleImage input.mha memory:resampled --spacing 0.5,0.5,0.5
+//   EnhanceTubesUsingDiffusion memory:resampled memory:enhanced
+//   SegmentTubes memory:enhanced --seedX 10,20,30 ${SCRATCH}/vessels.tre
+//   ConvertTubesToImage memory:enhanced ${SCRATCH}/vessels.tre output.mha
+//
+// The shared library of each module (the ModuleEntryPoint library built
+// by SEMMacroBuildCLI) is loaded once and called directly.  Images named
+// "memory:<name>" are handed between steps by itk::tube::MemoryImageIO
+// instead of being written to and read back from disk; other data, such as
+// tube files, goes through the scratch directory.  If a module library
+// cannot be found, the module's executable is run instead, and the
+// in-memory images it uses are moved to the scratch directory.  The
+// useDisk option sends every "memory:" image through the scratch
+// directory, which is also needed when ITK is built statically and each
+// module holds its own ImageIO factory registry.  An in-memory image is
+// released as soon as the last step using it has run.
+
+#include "itktubeMemoryImageIO.h"
+#include "itktubeMemoryImageIOFactory.h"
+#include "tubeCLIBatchCommand.h"
+
+#include <itkDynamicLoader.h>
+#include <itkTimeProbesCollectorBase.h>
+
+#include <itksys/Process.h>
+#include <itksys/SystemTools.hxx>
+
+#include <metaCommand.h>
+
+#include <map>
+#include <sstream>
+
+typedef int ( * ModuleEntryPointType )( int argc, char * argv[] );
+
+ModuleEntryPointType FindModuleEntryPoint( const std::string & module,
+  const std::vector< std::string > & moduleDirectories,
+  std::map< std::string, ModuleEntryPointType > & loadedModules )
+{
+  std::map< std::string, ModuleEntryPointType >::const_iterator loadedIt =
+    loadedModules.find( module );
+  if( loadedIt != loadedModules.end() )
+    {
+    return loadedIt->second;
+    }
+
+  ModuleEntryPointType entryPoint = NULL;
+  for( unsigned int i = 0; i < moduleDirectories.size() && !entryPoint; ++i )
+    {
+    const std::string libraryName = moduleDirectories[i] + "/"
+      + itk::DynamicLoader::LibPrefix() + module + "Lib"
+      + itk::DynamicLoader::LibExtension();
+    if( !itksys::SystemTools::FileExists( libraryName.c_str(), true ) )
+      {
+      continue;
+      }
+    itk::LibHandle library =
+      itk::DynamicLoader::OpenLibrary( libraryName.c_str() );
+    if( !library )
+      {
+      std::cerr << "Cannot load " << libraryName << ": "
+        << itk::DynamicLoader::LastError() << std::endl;
+      continue;
+      }
+    entryPoint = reinterpret_cast< ModuleEntryPointType >(
+      itk::DynamicLoader::GetSymbolAddress( library, "ModuleEntryPoint" ) );
+    }
+
+  // Libraries stay loaded until the process exits
+  loadedModules[module] = entryPoint;
+  return entryPoint;
+}
+
+std::string FindModuleExecutable( const std::string & module,
+  const std::vector< std::string > & moduleDirectories )
+{
+  for( unsigned int i = 0; i < moduleDirectories.size(); ++i )
+    {
+    const std::string executableName = moduleDirectories[i] + "/" + module
+      + itksys::SystemTools::GetExecutableExtension();
+    if( itksys::SystemTools::FileExists( executableName.c_str(), true ) )
+      {
+      return executableName;
+      }
+    }
+  return "";
+}
+
+int RunModuleExecutable( const std::string & executable,
+  const std::vector< std::string > & arguments )
+{
+  std::vector< const char * > commandLine;
+  commandLine.push_back( executable.c_str() );
+  for( unsigned int i = 0; i < arguments.size(); ++i )
+    {
+    commandLine.push_back( arguments[i].c_str() );
+    }
+  commandLine.push_back( NULL );
+
+  itksysProcess * process = itksysProcess_New();
+  itksysProcess_SetCommand( process, &( commandLine[0] ) );
+  itksysProcess_SetPipeShared( process, itksysProcess_Pipe_STDOUT, 1 );
+  itksysProcess_SetPipeShared( process, itksysProcess_Pipe_STDERR, 1 );
+  itksysProcess_Execute( process );
+  itksysProcess_WaitForExit( process, NULL );
+
+  int status = EXIT_FAILURE;
+  if( itksysProcess_GetState( process ) == itksysProcess_State_Exited )
+    {
+    status = itksysProcess_GetExitValue( process );
+    }
+  itksysProcess_Delete( process );
+  return status;
+}
+
+int main( int argc, char * argv[] )
+{
+  MetaCommand command;
+
+  command.SetOption( "chainFile", "c", true,
+    "Text file listing one module and its arguments per line" );
+  command.AddOptionField( "chainFile", "filename", MetaCommand::STRING,
+    true );
+
+  command.SetOption( "modulePath", "p", true,
+    "Directories holding the module libraries, separated by ';'" );
+  command.AddOptionField( "modulePath", "directories", MetaCommand::STRING,
+    true );
+
+  command.SetOption( "scratchDirectory", "s", false,
+    "Directory for intermediate data not kept in memory (default '.')" );
+  command.AddOptionField( "scratchDirectory", "directory",
+    MetaCommand::STRING, true );
+
+  command.SetOption( "useDisk", "d", false,
+    "Hand memory: images between steps through the scratch directory" );
+
+  if( !command.Parse( argc, argv ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  tube::CLIBatchCommand chain;
+  if( !chain.ReadChainFile( command.GetValueAsString( "chainFile",
+    "filename" ) ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::vector< std::string > moduleDirectories;
+  std::stringstream modulePath(
+    command.GetValueAsString( "modulePath", "directories" ) );
+  std::string directory;
+  while( std::getline( modulePath, directory, ';' ) )
+    {
+    if( !directory.empty() )
+      {
+      moduleDirectories.push_back( directory );
+      }
+    }
+
+  std::string scratchDirectory = ".";
+  if( command.GetOptionWasSet( "scratchDirectory" ) )
+    {
+    scratchDirectory = command.GetValueAsString( "scratchDirectory",
+      "directory" );
+    }
+  itksys::SystemTools::MakeDirectory( scratchDirectory.c_str() );
+  chain.SetScratchDirectory( scratchDirectory );
+
+  chain.SetUseDisk( command.GetOptionWasSet( "useDisk" ) );
+  if( !chain.GetUseDisk() )
+    {
+    itk::tube::MemoryImageIOFactory::RegisterOneFactory();
+    }
+
+  std::map< std::string, ModuleEntryPointType > loadedModules;
+
+  itk::TimeProbesCollectorBase timeCollector;
+
+  int status = EXIT_SUCCESS;
+  for( unsigned int s = 0; s < chain.GetNumberOfSteps()
+    && status == EXIT_SUCCESS; ++s )
+    {
+    const tube::CLIBatchCommand::Step & step = chain.GetStep( s );
+
+    ModuleEntryPointType entryPoint = FindModuleEntryPoint( step.Module,
+      moduleDirectories, loadedModules );
+    std::string executable;
+    if( !entryPoint )
+      {
+      executable = FindModuleExecutable( step.Module, moduleDirectories );
+      if( executable.empty() )
+        {
+        std::cerr << "Line " << step.LineNumber << ": module "
+          << step.Module << " not found" << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+
+    const std::vector< std::string > arguments =
+      chain.GetStepArguments( s, entryPoint != NULL );
+
+    std::stringstream label;
+    label << s + 1 << ": " << step.Module;
+    std::cout << "Step " << label.str()
+      << ( entryPoint ? "" : " (executable)" ) << std::endl;
+
+    timeCollector.Start( label.str().c_str() );
+    if( entryPoint )
+      {
+      std::vector< char * > moduleArgv;
+      moduleArgv.push_back( const_cast< char * >( step.Module.c_str() ) );
+      for( unsigned int i = 0; i < arguments.size(); ++i )
+        {
+        moduleArgv.push_back( const_cast< char * >( arguments[i].c_str() ) );
+        }
+      moduleArgv.push_back( NULL );
+      try
+        {
+        status = entryPoint( static_cast< int >( moduleArgv.size() - 1 ),
+          &( moduleArgv[0] ) );
+        }
+      catch( itk::ExceptionObject & err )
+        {
+        std::cerr << err << std::endl;
+        status = EXIT_FAILURE;
+        }
+      catch( std::exception & err )
+        {
+        std::cerr << err.what() << std::endl;
+        status = EXIT_FAILURE;
+        }
+      }
+    else
+      {
+      status = RunModuleExecutable( executable, arguments );
+      }
+    timeCollector.Stop( label.str().c_str() );
+
+    if( status != EXIT_SUCCESS )
+      {
+      std::cerr << "Line " << step.LineNumber << ": " << step.Module
+        << " failed with status " << status << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // Free the in-memory images no later step reads
+    chain.ReleaseImagesLastUsedByStep( s );
+    }
+
+  timeCollector.Report();
+  itk::tube::MemoryImageIO::RemoveAllImages();
+
+  return status;
+}
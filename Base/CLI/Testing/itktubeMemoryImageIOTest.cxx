@@ -0,0 +1,190 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeMemoryImageIO.h"
+#include "itktubeMemoryImageIOFactory.h"
+
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+
+template< class TImage >
+bool CompareImages( const TImage * expected, const TImage * computed )
+{
+  if( expected->GetLargestPossibleRegion()
+    != computed->GetLargestPossibleRegion()
+    || expected->GetSpacing() != computed->GetSpacing()
+    || expected->GetOrigin() != computed->GetOrigin()
+    || expected->GetDirection() != computed->GetDirection() )
+    {
+    std::cerr << "Error: image information differs." << std::endl;
+    return false;
+    }
+
+  itk::ImageRegionConstIterator< TImage > expectedIt( expected,
+    expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > computedIt( computed,
+    computed->GetLargestPossibleRegion() );
+  while( !expectedIt.IsAtEnd() )
+    {
+    if( expectedIt.Get() != computedIt.Get() )
+      {
+      std::cerr << "Error: pixel " << expectedIt.GetIndex() << " is "
+        << computedIt.Get() << ", expected " << expectedIt.Get()
+        << std::endl;
+      return false;
+      }
+    ++expectedIt;
+    ++computedIt;
+    }
+  return true;
+}
+
+int itktubeMemoryImageIOTest( int argc, char * argv[] )
+{
+  if( argc != 2 )
+    {
+    std::cerr << "Missing arguments." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << " outputImage" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::Image< short, 3 >                  ImageType;
+  typedef itk::Image< double, 3 >                 DoubleImageType;
+  typedef itk::tube::MemoryImageIO                MemoryImageIOType;
+
+  itk::tube::MemoryImageIOFactory::RegisterOneFactory();
+
+  ImageType::SizeType size;
+  size[0] = 11;
+  size[1] = 7;
+  size[2] = 5;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.5;
+  spacing[2] = 2.0;
+  ImageType::PointType origin;
+  origin[0] = -3;
+  origin[1] = 4;
+  origin[2] = 10;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->Allocate();
+
+  DoubleImageType::Pointer doubleImage = DoubleImageType::New();
+  doubleImage->SetRegions( size );
+  doubleImage->SetSpacing( spacing );
+  doubleImage->SetOrigin( origin );
+  doubleImage->Allocate();
+
+  itk::ImageRegionIterator< ImageType > imageIt( image,
+    image->GetLargestPossibleRegion() );
+  itk::ImageRegionIterator< DoubleImageType > doubleIt( doubleImage,
+    doubleImage->GetLargestPossibleRegion() );
+  short value = -200;
+  while( !imageIt.IsAtEnd() )
+    {
+    imageIt.Set( value );
+    doubleIt.Set( value );
+    value += 3;
+    ++imageIt;
+    ++doubleIt;
+    }
+
+  const std::string memoryFileName = "memory:itktubeMemoryImageIOTest";
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( memoryFileName );
+  writer->Update();
+
+  if( !MemoryImageIOType::HasImage( memoryFileName ) )
+    {
+    std::cerr << "Error: image was not stored." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int returnStatus = EXIT_SUCCESS;
+
+  // Read back with the stored pixel type and with a converted one
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( memoryFileName );
+  reader->Update();
+  if( !CompareImages< ImageType >( image, reader->GetOutput() ) )
+    {
+    returnStatus = EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< DoubleImageType > DoubleReaderType;
+  DoubleReaderType::Pointer doubleReader = DoubleReaderType::New();
+  doubleReader->SetFileName( memoryFileName );
+  doubleReader->Update();
+  if( !CompareImages< DoubleImageType >( doubleImage,
+    doubleReader->GetOutput() ) )
+    {
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Move the image to disk and read it from there
+  if( !MemoryImageIOType::WriteImageToFile( memoryFileName, argv[1] ) )
+    {
+    std::cerr << "Error: image was not written to " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  MemoryImageIOType::RemoveImage( memoryFileName );
+  if( MemoryImageIOType::HasImage( memoryFileName ) )
+    {
+    std::cerr << "Error: image was not removed." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  ReaderType::Pointer diskReader = ReaderType::New();
+  diskReader->SetFileName( argv[1] );
+  diskReader->Update();
+  if( !CompareImages< ImageType >( image, diskReader->GetOutput() ) )
+    {
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Removed images can no longer be read
+  ReaderType::Pointer missingReader = ReaderType::New();
+  missingReader->SetFileName( memoryFileName );
+  try
+    {
+    missingReader->Update();
+    std::cerr << "Error: removed image was read." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+  catch( itk::ExceptionObject & )
+    {
+    }
+
+  return returnStatus;
+}
@@ -21,6 +21,9 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeMemoryImageIO.h"
+#include "itktubeMemoryImageIOFactory.h"
+#include "tubeCLIBatchCommand.h"
 #include "tubeCLIFilterWatcher.h"
 #include "tubeCLIProgressReporter.h"
 #include "TubeTKLogo.h"
@@ -21,9 +21,16 @@ limitations under the License.
 
 =========================================================================*/
 
+#include "itktubeMemoryImageIO.h"
 #include "tubeMacro.h"
 
 int tubeBaseCLIPrintTest( int tubeNotUsed( argc ), char * tubeNotUsed( argv )[] )
 {
+  itk::tube::MemoryImageIO::Pointer memoryImageIO =
+    itk::tube::MemoryImageIO::New();
+  std::cout << "-------------itktubeMemoryImageIO"
+            << memoryImageIO
+            << std::endl;
+
   return EXIT_SUCCESS;
 }
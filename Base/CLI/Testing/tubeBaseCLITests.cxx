@@ -27,6 +27,8 @@ limitations under the License.
 void RegisterTests( void )
 {
   REGISTER_TEST( tubeBaseCLIPrintTest );
+  REGISTER_TEST( itktubeMemoryImageIOTest );
+  REGISTER_TEST( tubeCLIBatchCommandTest );
   REGISTER_TEST( tubeCLIFilterWatcherTest );
   REGISTER_TEST( tubeCLIHelperFunctionsTest );
   REGISTER_TEST( tubeCLIProgressReporterTest );
@@ -0,0 +1,199 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeMemoryImageIO.h"
+#include "itktubeMemoryImageIOFactory.h"
+#include "tubeCLIBatchCommand.h"
+
+#include <itkImageFileWriter.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <sstream>
+
+int tubeCLIBatchCommandTest( int argc, char * argv[] )
+{
+  if( argc != 2 )
+    {
+    std::cerr << "Missing arguments." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0] << " scratchDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::Image< short, 2 >                  ImageType;
+  typedef itk::tube::MemoryImageIO                MemoryImageIOType;
+
+  itk::tube::MemoryImageIOFactory::RegisterOneFactory();
+
+  const std::string scratchDirectory = std::string( argv[1] )
+    + "/tubeCLIBatchCommandTest";
+  itksys::SystemTools::MakeDirectory( scratchDirectory.c_str() );
+
+  int returnStatus = EXIT_SUCCESS;
+
+  // Chain parsing: comments, blank lines, quoted arguments
+  std::stringstream chainText;
+  chainText << "# Enhance and segment" << std::endl
+    << std::endl
+    << "ModuleA input.mha memory:a \"${SCRATCH}/a b.tre\" --x 1"
+    << std::endl
+    << "  ModuleB\tmemory:a memory:b" << std::endl
+    << "ModuleC memory:b ${SCRATCH}/c.mha" << std::endl;
+
+  tube::CLIBatchCommand chain;
+  chain.SetScratchDirectory( scratchDirectory );
+  if( !chain.ReadChain( chainText, "chainText" ) )
+    {
+    std::cerr << "Error: valid chain rejected." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( chain.GetNumberOfSteps() != 3
+    || chain.GetStep( 0 ).Module != "ModuleA"
+    || chain.GetStep( 0 ).LineNumber != 3
+    || chain.GetStep( 0 ).Arguments.size() != 5
+    || chain.GetStep( 0 ).Arguments[2] != "${SCRATCH}/a b.tre"
+    || chain.GetStep( 1 ).Module != "ModuleB"
+    || chain.GetStep( 1 ).Arguments.size() != 2
+    || chain.GetStep( 2 ).LineNumber != 5 )
+    {
+    std::cerr << "Error: chain parsed incorrectly." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  std::stringstream badChainText;
+  badChainText << "ModuleA \"unterminated" << std::endl;
+  tube::CLIBatchCommand badChain;
+  if( badChain.ReadChain( badChainText, "badChainText" )
+    || badChain.GetNumberOfSteps() != 0 )
+    {
+    std::cerr << "Error: unmatched quote accepted." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // ${SCRATCH} substitution; memory: images stay in memory in process
+  std::vector< std::string > arguments = chain.GetStepArguments( 0, true );
+  if( arguments.size() != 5
+    || arguments[1] != "memory:a"
+    || arguments[2] != scratchDirectory + "/a b.tre" )
+    {
+    std::cerr << "Error: step 1 arguments are wrong." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Last uses of the memory: images
+  if( !chain.GetImagesLastUsedByStep( 0 ).empty()
+    || chain.GetImagesLastUsedByStep( 1 ).size() != 1
+    || chain.GetImagesLastUsedByStep( 1 )[0] != "memory:a"
+    || chain.GetImagesLastUsedByStep( 2 ).size() != 1
+    || chain.GetImagesLastUsedByStep( 2 )[0] != "memory:b" )
+    {
+    std::cerr << "Error: last uses are wrong." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Step 1 leaves an image in memory
+  ImageType::SizeType size;
+  size.Fill( 4 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( 7 );
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( "memory:a" );
+  writer->Update();
+
+  // Memory to scratch fallback: a step run outside the process reads the
+  // image from the scratch directory, and so do later in-process steps
+  const std::string scratchFileA = scratchDirectory + "/a.mha";
+  itksys::SystemTools::RemoveFile( scratchFileA.c_str() );
+  arguments = chain.GetStepArguments( 1, false );
+  if( arguments.size() != 2
+    || arguments[0] != scratchFileA
+    || arguments[1] != scratchDirectory + "/b.mha" )
+    {
+    std::cerr << "Error: fallback arguments are wrong." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+  if( MemoryImageIOType::HasImage( "memory:a" )
+    || !itksys::SystemTools::FileExists( scratchFileA.c_str(), true ) )
+    {
+    std::cerr << "Error: image was not moved to the scratch directory."
+      << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+  arguments = chain.GetStepArguments( 2, true );
+  if( arguments[0] != scratchDirectory + "/b.mha" )
+    {
+    std::cerr << "Error: later step does not read the scratch file."
+      << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // useDisk sends every memory: image through the scratch directory
+  tube::CLIBatchCommand diskChain;
+  std::stringstream diskChainText;
+  diskChainText << "ModuleA memory:c.nrrd" << std::endl;
+  diskChain.ReadChain( diskChainText, "diskChainText" );
+  diskChain.SetScratchDirectory( scratchDirectory );
+  diskChain.SetUseDisk( true );
+  arguments = diskChain.GetStepArguments( 0, true );
+  if( arguments.size() != 1
+    || arguments[0] != scratchDirectory + "/c.nrrd" )
+    {
+    std::cerr << "Error: useDisk arguments are wrong." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Images are released after their last use
+  std::stringstream releaseChainText;
+  releaseChainText << "ModuleA memory:d" << std::endl
+    << "ModuleB memory:d memory:e" << std::endl;
+  tube::CLIBatchCommand releaseChain;
+  releaseChain.ReadChain( releaseChainText, "releaseChainText" );
+  writer->SetFileName( "memory:d" );
+  writer->Update();
+  releaseChain.ReleaseImagesLastUsedByStep( 0 );
+  if( !MemoryImageIOType::HasImage( "memory:d" ) )
+    {
+    std::cerr << "Error: image released before its last use." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+  writer->SetFileName( "memory:e" );
+  writer->Update();
+  releaseChain.ReleaseImagesLastUsedByStep( 1 );
+  if( MemoryImageIOType::HasImage( "memory:d" )
+    || MemoryImageIOType::HasImage( "memory:e" ) )
+    {
+    std::cerr << "Error: image not released after its last use."
+      << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  MemoryImageIOType::RemoveAllImages();
+
+  return returnStatus;
+}
@@ -0,0 +1,290 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeMemoryImageIO.h"
+
+#include <itkImageIOFactory.h>
+#include <itkSimpleFastMutexLock.h>
+
+#include <cstring>
+#include <map>
+
+namespace itk
+{
+
+namespace tube
+{
+
+namespace
+{
+
+struct MemoryImageEntry
+  {
+  unsigned int                          NumberOfDimensions;
+  std::vector< SizeValueType >          Dimensions;
+  std::vector< double >                 Spacing;
+  std::vector< double >                 Origin;
+  std::vector< std::vector< double > >  Direction;
+  ImageIOBase::IOPixelType              PixelType;
+  ImageIOBase::IOComponentType          ComponentType;
+  unsigned int                          NumberOfComponents;
+  std::vector< char >                   Buffer;
+  };
+
+typedef std::map< std::string, MemoryImageEntry > MemoryImageRegistryType;
+
+MemoryImageRegistryType & GetMemoryImageRegistry( void )
+{
+  static MemoryImageRegistryType registry;
+  return registry;
+}
+
+SimpleFastMutexLock & GetMemoryImageRegistryLock( void )
+{
+  static SimpleFastMutexLock lock;
+  return lock;
+}
+
+std::string GetMemoryImageKey( const std::string & fileName )
+{
+  return fileName.substr( std::strlen( MemoryImageIO::GetFileNamePrefix() ) );
+}
+
+void CopyImageInformation( const MemoryImageEntry & entry,
+  ImageIOBase * imageIO )
+{
+  imageIO->SetNumberOfDimensions( entry.NumberOfDimensions );
+  for( unsigned int i = 0; i < entry.NumberOfDimensions; ++i )
+    {
+    imageIO->SetDimensions( i, entry.Dimensions[i] );
+    imageIO->SetSpacing( i, entry.Spacing[i] );
+    imageIO->SetOrigin( i, entry.Origin[i] );
+    imageIO->SetDirection( i, entry.Direction[i] );
+    }
+  imageIO->SetPixelType( entry.PixelType );
+  imageIO->SetComponentType( entry.ComponentType );
+  imageIO->SetNumberOfComponents( entry.NumberOfComponents );
+}
+
+} // End anonymous namespace
+
+MemoryImageIO
+::MemoryImageIO( void )
+{
+}
+
+MemoryImageIO
+::~MemoryImageIO( void )
+{
+}
+
+const char *
+MemoryImageIO
+::GetFileNamePrefix( void )
+{
+  return "memory:";
+}
+
+bool
+MemoryImageIO
+::IsMemoryFileName( const std::string & fileName )
+{
+  return fileName.compare( 0, std::strlen( GetFileNamePrefix() ),
+    GetFileNamePrefix() ) == 0;
+}
+
+bool
+MemoryImageIO
+::HasImage( const std::string & fileName )
+{
+  if( !IsMemoryFileName( fileName ) )
+    {
+    return false;
+    }
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  return GetMemoryImageRegistry().count( GetMemoryImageKey( fileName ) ) > 0;
+}
+
+void
+MemoryImageIO
+::RemoveImage( const std::string & fileName )
+{
+  if( !IsMemoryFileName( fileName ) )
+    {
+    return;
+    }
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  GetMemoryImageRegistry().erase( GetMemoryImageKey( fileName ) );
+}
+
+void
+MemoryImageIO
+::RemoveAllImages( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  GetMemoryImageRegistry().clear();
+}
+
+bool
+MemoryImageIO
+::WriteImageToFile( const std::string & memoryFileName,
+  const std::string & diskFileName )
+{
+  if( !IsMemoryFileName( memoryFileName ) )
+    {
+    return false;
+    }
+
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  MemoryImageRegistryType::const_iterator entryIt =
+    GetMemoryImageRegistry().find( GetMemoryImageKey( memoryFileName ) );
+  if( entryIt == GetMemoryImageRegistry().end() )
+    {
+    return false;
+    }
+  const MemoryImageEntry & entry = entryIt->second;
+
+  ImageIOBase::Pointer imageIO = ImageIOFactory::CreateImageIO(
+    diskFileName.c_str(), ImageIOFactory::WriteMode );
+  if( imageIO.IsNull() )
+    {
+    return false;
+    }
+
+  CopyImageInformation( entry, imageIO );
+  ImageIORegion ioRegion( entry.NumberOfDimensions );
+  for( unsigned int i = 0; i < entry.NumberOfDimensions; ++i )
+    {
+    ioRegion.SetIndex( i, 0 );
+    ioRegion.SetSize( i, entry.Dimensions[i] );
+    }
+  imageIO->SetIORegion( ioRegion );
+  imageIO->SetFileName( diskFileName );
+  imageIO->SetUseCompression( true );
+  imageIO->WriteImageInformation();
+  imageIO->Write( &( entry.Buffer[0] ) );
+
+  return true;
+}
+
+bool
+MemoryImageIO
+::CanReadFile( const char * fileName )
+{
+  return fileName != NULL && HasImage( fileName );
+}
+
+void
+MemoryImageIO
+::ReadImageInformation( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  MemoryImageRegistryType::const_iterator entryIt =
+    GetMemoryImageRegistry().find( GetMemoryImageKey( m_FileName ) );
+  if( entryIt == GetMemoryImageRegistry().end() )
+    {
+    itkExceptionMacro( << "No image is stored as " << m_FileName );
+    }
+
+  CopyImageInformation( entryIt->second, this );
+}
+
+void
+MemoryImageIO
+::Read( void * buffer )
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  MemoryImageRegistryType::const_iterator entryIt =
+    GetMemoryImageRegistry().find( GetMemoryImageKey( m_FileName ) );
+  if( entryIt == GetMemoryImageRegistry().end() )
+    {
+    itkExceptionMacro( << "No image is stored as " << m_FileName );
+    }
+
+  const std::vector< char > & stored = entryIt->second.Buffer;
+  if( stored.size() != this->GetImageSizeInBytes() )
+    {
+    itkExceptionMacro( << "Stored image " << m_FileName
+      << " does not match the requested region." );
+    }
+  if( !stored.empty() )
+    {
+    std::memcpy( buffer, &( stored[0] ), stored.size() );
+    }
+}
+
+bool
+MemoryImageIO
+::CanWriteFile( const char * fileName )
+{
+  return fileName != NULL && IsMemoryFileName( fileName );
+}
+
+void
+MemoryImageIO
+::WriteImageInformation( void )
+{
+}
+
+void
+MemoryImageIO
+::Write( const void * buffer )
+{
+  MemoryImageEntry entry;
+  entry.NumberOfDimensions = this->GetNumberOfDimensions();
+  for( unsigned int i = 0; i < entry.NumberOfDimensions; ++i )
+    {
+    entry.Dimensions.push_back( this->GetDimensions( i ) );
+    entry.Spacing.push_back( this->GetSpacing( i ) );
+    entry.Origin.push_back( this->GetOrigin( i ) );
+    entry.Direction.push_back( this->GetDirection( i ) );
+    }
+  entry.PixelType = this->GetPixelType();
+  entry.ComponentType = this->GetComponentType();
+  entry.NumberOfComponents = this->GetNumberOfComponents();
+
+  const char * bytes = static_cast< const char * >( buffer );
+  entry.Buffer.assign( bytes, bytes + this->GetImageSizeInBytes() );
+
+  MutexLockHolder< SimpleFastMutexLock > holder(
+    GetMemoryImageRegistryLock() );
+  std::swap( GetMemoryImageRegistry()[ GetMemoryImageKey( m_FileName ) ],
+    entry );
+}
+
+void
+MemoryImageIO
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+}
+
+} // End namespace tube
+
+} // End namespace itk
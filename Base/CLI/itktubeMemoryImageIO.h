@@ -0,0 +1,108 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeMemoryImageIO_h
+#define __itktubeMemoryImageIO_h
+
+#include <itkImageIOBase.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class MemoryImageIO
+ * \brief ImageIO that keeps images in a process-wide registry.
+ *
+ * File names of the form "memory:<name>" are handled by this class: writing
+ * stores a copy of the pixel buffer and image information under <name>, and
+ * reading returns it.  This lets CLI modules that run in the same process
+ * (see CLIBatchCommand) hand images to each other through the usual
+ * ImageFileReader/ImageFileWriter calls without touching the disk.
+ *
+ * Streaming is not supported; the whole image is copied on each read and
+ * write.  Use MemoryImageIOFactory to make the class available to
+ * ImageIOFactory.
+ */
+class MemoryImageIO : public ImageIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryImageIO                 Self;
+  typedef ImageIOBase                   Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MemoryImageIO, ImageIOBase );
+
+  /** Prefix identifying file names handled by this class. */
+  static const char * GetFileNamePrefix( void );
+
+  /** Return true if the file name carries the memory prefix. */
+  static bool IsMemoryFileName( const std::string & fileName );
+
+  /** Return true if an image is stored under the given file name. */
+  static bool HasImage( const std::string & fileName );
+
+  /** Release the image stored under the given file name. */
+  static void RemoveImage( const std::string & fileName );
+
+  /** Release every stored image. */
+  static void RemoveAllImages( void );
+
+  /** Write the image stored under memoryFileName to diskFileName using
+   *  whichever ImageIO handles diskFileName.  Returns false if no image is
+   *  stored or no ImageIO can write the file. */
+  static bool WriteImageToFile( const std::string & memoryFileName,
+    const std::string & diskFileName );
+
+  virtual bool CanReadFile( const char * fileName );
+  virtual void ReadImageInformation( void );
+  virtual void Read( void * buffer );
+
+  virtual bool CanWriteFile( const char * fileName );
+  virtual void WriteImageInformation( void );
+  virtual void Write( const void * buffer );
+
+protected:
+  MemoryImageIO( void );
+  virtual ~MemoryImageIO( void );
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+  MemoryImageIO( const Self & ); // Purposely not implemented
+  void operator=( const Self & ); // Purposely not implemented
+
+}; // End class MemoryImageIO
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeMemoryImageIO_h)
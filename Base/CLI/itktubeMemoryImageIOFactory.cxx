@@ -0,0 +1,68 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeMemoryImageIOFactory.h"
+
+#include "itktubeMemoryImageIO.h"
+
+#include <itkVersion.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+MemoryImageIOFactory
+::MemoryImageIOFactory( void )
+{
+  this->RegisterOverride( "itkImageIOBase",
+                          "itkMemoryImageIO",
+                          "In-process image registry IO",
+                          1,
+                          CreateObjectFunction< MemoryImageIO >::New() );
+}
+
+MemoryImageIOFactory
+::~MemoryImageIOFactory( void )
+{
+}
+
+const char *
+MemoryImageIOFactory
+::GetITKSourceVersion( void ) const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char *
+MemoryImageIOFactory
+::GetDescription( void ) const
+{
+  return "In-process image registry ImageIO Factory, allows the "
+    "loading of images stored by other modules in the same process";
+}
+
+} // End namespace tube
+
+} // End namespace itk
@@ -0,0 +1,77 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeMemoryImageIOFactory_h
+#define __itktubeMemoryImageIOFactory_h
+
+#include <itkObjectFactoryBase.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class MemoryImageIOFactory
+ * \brief Create instances of MemoryImageIO through the object factory. */
+class MemoryImageIOFactory : public ObjectFactoryBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryImageIOFactory          Self;
+  typedef ObjectFactoryBase             Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** Class methods used to interface with the registered factories. */
+  virtual const char * GetITKSourceVersion( void ) const;
+  virtual const char * GetDescription( void ) const;
+
+  /** Method for class instantiation. */
+  itkFactorylessNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MemoryImageIOFactory, ObjectFactoryBase );
+
+  /** Register one factory of this type. */
+  static void RegisterOneFactory( void )
+    {
+    MemoryImageIOFactory::Pointer factory = MemoryImageIOFactory::New();
+    ObjectFactoryBase::RegisterFactory( factory );
+    }
+
+protected:
+  MemoryImageIOFactory( void );
+  virtual ~MemoryImageIOFactory( void );
+
+private:
+  MemoryImageIOFactory( const Self & ); // Purposely not implemented
+  void operator=( const Self & ); // Purposely not implemented
+
+}; // End class MemoryImageIOFactory
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeMemoryImageIOFactory_h)
@@ -0,0 +1,265 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "tubeCLIBatchCommand.h"
+
+#include "itktubeMemoryImageIO.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace tube
+{
+
+CLIBatchCommand
+::CLIBatchCommand( void )
+{
+  m_ScratchDirectory = ".";
+  m_UseDisk = false;
+}
+
+bool
+CLIBatchCommand
+::ReadChain( std::istream & chain, const std::string & name )
+{
+  m_Steps.clear();
+  m_LastUse.clear();
+  m_ScratchImages.clear();
+
+  std::vector< Step > steps;
+  std::string line;
+  unsigned int lineNumber = 0;
+  while( std::getline( chain, line ) )
+    {
+    ++lineNumber;
+
+    std::vector< std::string > tokens;
+    std::string token;
+    bool inToken = false;
+    bool inQuotes = false;
+    for( std::string::size_type i = 0; i < line.size(); ++i )
+      {
+      const char c = line[i];
+      if( c == '"' )
+        {
+        inQuotes = !inQuotes;
+        inToken = true;
+        }
+      else if( !inQuotes && ( c == ' ' || c == '\t' || c == '\r' ) )
+        {
+        if( inToken )
+          {
+          tokens.push_back( token );
+          token.clear();
+          inToken = false;
+          }
+        }
+      else
+        {
+        token += c;
+        inToken = true;
+        }
+      }
+    if( inQuotes )
+      {
+      std::cerr << name << ":" << lineNumber << ": unmatched quote"
+        << std::endl;
+      return false;
+      }
+    if( inToken )
+      {
+      tokens.push_back( token );
+      }
+
+    if( tokens.empty() || tokens[0][0] == '#' )
+      {
+      continue;
+      }
+
+    Step step;
+    step.Module = tokens[0];
+    step.Arguments.assign( tokens.begin() + 1, tokens.end() );
+    step.LineNumber = lineNumber;
+    steps.push_back( step );
+    }
+
+  m_Steps.swap( steps );
+  for( unsigned int s = 0; s < m_Steps.size(); ++s )
+    {
+    for( unsigned int i = 0; i < m_Steps[s].Arguments.size(); ++i )
+      {
+      if( itk::tube::MemoryImageIO::IsMemoryFileName(
+        m_Steps[s].Arguments[i] ) )
+        {
+        m_LastUse[ m_Steps[s].Arguments[i] ] = s;
+        }
+      }
+    }
+
+  return true;
+}
+
+bool
+CLIBatchCommand
+::ReadChainFile( const std::string & fileName )
+{
+  std::ifstream chainFile( fileName.c_str() );
+  if( !chainFile )
+    {
+    std::cerr << "Cannot open chain file " << fileName << std::endl;
+    return false;
+    }
+  return this->ReadChain( chainFile, fileName );
+}
+
+unsigned int
+CLIBatchCommand
+::GetNumberOfSteps( void ) const
+{
+  return static_cast< unsigned int >( m_Steps.size() );
+}
+
+const CLIBatchCommand::Step &
+CLIBatchCommand
+::GetStep( unsigned int step ) const
+{
+  return m_Steps[step];
+}
+
+void
+CLIBatchCommand
+::SetScratchDirectory( const std::string & scratchDirectory )
+{
+  m_ScratchDirectory = scratchDirectory;
+}
+
+const std::string &
+CLIBatchCommand
+::GetScratchDirectory( void ) const
+{
+  return m_ScratchDirectory;
+}
+
+void
+CLIBatchCommand
+::SetUseDisk( bool useDisk )
+{
+  m_UseDisk = useDisk;
+}
+
+bool
+CLIBatchCommand
+::GetUseDisk( void ) const
+{
+  return m_UseDisk;
+}
+
+std::vector< std::string >
+CLIBatchCommand
+::GetStepArguments( unsigned int step, bool inProcess )
+{
+  const std::vector< std::string > & stepArguments =
+    m_Steps[step].Arguments;
+
+  std::vector< std::string > arguments;
+  for( unsigned int i = 0; i < stepArguments.size(); ++i )
+    {
+    std::string argument = stepArguments[i];
+    std::string::size_type pos;
+    while( ( pos = argument.find( "${SCRATCH}" ) ) != std::string::npos )
+      {
+      argument.replace( pos, 10, m_ScratchDirectory );
+      }
+
+    if( itk::tube::MemoryImageIO::IsMemoryFileName( argument )
+      && ( m_UseDisk || !inProcess || m_ScratchImages.count( argument ) ) )
+      {
+      const std::string scratchFileName = GetScratchFileName( argument,
+        m_ScratchDirectory );
+      if( !inProcess )
+        {
+        // The step runs in another process; move the image to the
+        // scratch directory for this and all later steps
+        if( itk::tube::MemoryImageIO::HasImage( argument ) )
+          {
+          itk::tube::MemoryImageIO::WriteImageToFile( argument,
+            scratchFileName );
+          itk::tube::MemoryImageIO::RemoveImage( argument );
+          }
+        m_ScratchImages.insert( argument );
+        }
+      argument = scratchFileName;
+      }
+    arguments.push_back( argument );
+    }
+
+  return arguments;
+}
+
+std::vector< std::string >
+CLIBatchCommand
+::GetImagesLastUsedByStep( unsigned int step ) const
+{
+  std::vector< std::string > images;
+  std::map< std::string, unsigned int >::const_iterator lastUseIt =
+    m_LastUse.begin();
+  for( ; lastUseIt != m_LastUse.end(); ++lastUseIt )
+    {
+    if( lastUseIt->second == step )
+      {
+      images.push_back( lastUseIt->first );
+      }
+    }
+  return images;
+}
+
+void
+CLIBatchCommand
+::ReleaseImagesLastUsedByStep( unsigned int step ) const
+{
+  const std::vector< std::string > images =
+    this->GetImagesLastUsedByStep( step );
+  for( unsigned int i = 0; i < images.size(); ++i )
+    {
+    itk::tube::MemoryImageIO::RemoveImage( images[i] );
+    }
+}
+
+std::string
+CLIBatchCommand
+::GetScratchFileName( const std::string & memoryFileName,
+  const std::string & scratchDirectory )
+{
+  std::string name = memoryFileName.substr(
+    std::strlen( itk::tube::MemoryImageIO::GetFileNamePrefix() ) );
+  if( itksys::SystemTools::GetFilenameLastExtension( name ).empty() )
+    {
+    name += ".mha";
+    }
+  return scratchDirectory + "/" + name;
+}
+
+} // End namespace tube
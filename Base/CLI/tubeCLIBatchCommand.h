@@ -0,0 +1,107 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __tubeCLIBatchCommand_h
+#define __tubeCLIBatchCommand_h
+
+#include <istream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tube
+{
+
+/** \class CLIBatchCommand
+ * \brief Chain of CLI module steps run by the CLIBatchCommand executable.
+ *
+ * Each line of a chain names a module followed by its command-line
+ * arguments.  Blank lines and lines starting with '#' are ignored,
+ * arguments containing spaces can be enclosed in double quotes, and
+ * ${SCRATCH} is replaced by the scratch directory.  Images named
+ * "memory:<name>" are kept by itk::tube::MemoryImageIO; they are sent
+ * through the scratch directory when UseDisk is set or when a step runs
+ * outside the process, and are released after their last use.
+ */
+class CLIBatchCommand
+{
+public:
+
+  struct Step
+    {
+    std::string                 Module;
+    std::vector< std::string >  Arguments;
+    unsigned int                LineNumber;
+    };
+
+  CLIBatchCommand( void );
+
+  /** Parse a chain; name is used in error messages.  Returns false and
+   *  keeps no steps if a line cannot be parsed. */
+  bool ReadChain( std::istream & chain, const std::string & name );
+  bool ReadChainFile( const std::string & fileName );
+
+  unsigned int GetNumberOfSteps( void ) const;
+  const Step & GetStep( unsigned int step ) const;
+
+  void SetScratchDirectory( const std::string & scratchDirectory );
+  const std::string & GetScratchDirectory( void ) const;
+
+  /** Hand every memory: image through the scratch directory. */
+  void SetUseDisk( bool useDisk );
+  bool GetUseDisk( void ) const;
+
+  /** Arguments of a step as given to its module.  ${SCRATCH} is
+   *  substituted and memory: images that cannot stay in memory are
+   *  replaced by their scratch file names.  If inProcess is false, the
+   *  memory: images of the step are written to the scratch directory and
+   *  released, and later steps read them from there. */
+  std::vector< std::string > GetStepArguments( unsigned int step,
+    bool inProcess );
+
+  /** memory: images that no step after the given one uses. */
+  std::vector< std::string > GetImagesLastUsedByStep( unsigned int step )
+    const;
+
+  /** Release the memory: images that no step after the given one uses. */
+  void ReleaseImagesLastUsedByStep( unsigned int step ) const;
+
+  /** Scratch file name of a memory: image; ".mha" is appended when the
+   *  name has no extension. */
+  static std::string GetScratchFileName( const std::string & memoryFileName,
+    const std::string & scratchDirectory );
+
+private:
+
+  std::vector< Step >                     m_Steps;
+  std::map< std::string, unsigned int >   m_LastUse;
+  std::set< std::string >                 m_ScratchImages;
+  std::string                             m_ScratchDirectory;
+  bool                                    m_UseDisk;
+
+}; // End class CLIBatchCommand
+
+} // End namespace tube
+
+#endif // End !defined(__tubeCLIBatchCommand_h)
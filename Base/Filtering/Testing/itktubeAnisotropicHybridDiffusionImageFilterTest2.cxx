@@ -0,0 +1,194 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeAnisotropicHybridDiffusionImageFilter.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkTimeProbe.h>
+
+#include <cmath>
+
+// Root mean square difference of two images
+template< class TImage >
+double RMSDifference( const TImage * image1, const TImage * image2 )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1,
+    image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2,
+    image2->GetLargestPossibleRegion() );
+  double sum = 0;
+  unsigned int count = 0;
+  while( !it1.IsAtEnd() )
+    {
+    const double difference = it1.Get() - it2.Get();
+    sum += difference * difference;
+    ++count;
+    ++it1;
+    ++it2;
+    }
+  return std::sqrt( sum / count );
+}
+
+int itktubeAnisotropicHybridDiffusionImageFilterTest2(
+  int itkNotUsed( argc ), char * itkNotUsed( argv )[] )
+{
+  enum { Dimension = 3 };
+  typedef double                                PixelType;
+  typedef itk::Image< PixelType, Dimension >    ImageType;
+
+  typedef itk::tube::AnisotropicHybridDiffusionImageFilter<
+    ImageType, ImageType >                      FilterType;
+
+  // A noisy tube along the z axis
+  ImageType::SizeType size;
+  size.Fill( 24 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator
+    RandGenType;
+  RandGenType::Pointer rndGen = RandGenType::New();
+  rndGen->Initialize( 1 );
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image,
+    image->GetLargestPossibleRegion() );
+  while( !it.IsAtEnd() )
+    {
+    const double dx = it.GetIndex()[0] - 11.5;
+    const double dy = it.GetIndex()[1] - 11.5;
+    it.Set( 100.0 * std::exp( -( dx * dx + dy * dy ) / 18.0 )
+      + rndGen->GetNormalVariate( 0, 100 ) );
+    ++it;
+    }
+
+  // Explicit steps, below the stability limit
+  FilterType::Pointer explicitFilter = FilterType::New();
+  explicitFilter->SetInput( image );
+  explicitFilter->SetTimeStep( 0.05 );
+  explicitFilter->SetNumberOfIterations( 40 );
+
+  itk::TimeProbe explicitTimer;
+  explicitTimer.Start();
+  explicitFilter->Update();
+  explicitTimer.Stop();
+
+  // Semi-implicit steps ten times larger, over the same diffusion time
+  FilterType::Pointer semiImplicitFilter = FilterType::New();
+  semiImplicitFilter->SetInput( image );
+  semiImplicitFilter->SetUseSemiImplicitScheme( true );
+  semiImplicitFilter->SetTimeStep( 0.5 );
+  semiImplicitFilter->SetNumberOfIterations( 4 );
+
+  itk::TimeProbe semiImplicitTimer;
+  semiImplicitTimer.Start();
+  semiImplicitFilter->Update();
+  semiImplicitTimer.Stop();
+
+  // Semi-implicit steps, computing the tensors every other iteration
+  FilterType::Pointer reuseFilter = FilterType::New();
+  reuseFilter->SetInput( image );
+  reuseFilter->SetUseSemiImplicitScheme( true );
+  reuseFilter->SetTimeStep( 0.5 );
+  reuseFilter->SetNumberOfIterations( 4 );
+  reuseFilter->SetTensorUpdateInterval( 2 );
+
+  itk::TimeProbe reuseTimer;
+  reuseTimer.Start();
+  reuseFilter->Update();
+  reuseTimer.Stop();
+
+  // Tensors reused for all iterations, unless the image changes too much
+  FilterType::Pointer intervalFilter = FilterType::New();
+  intervalFilter->SetInput( image );
+  intervalFilter->SetUseSemiImplicitScheme( true );
+  intervalFilter->SetTimeStep( 0.5 );
+  intervalFilter->SetNumberOfIterations( 4 );
+  intervalFilter->SetTensorUpdateInterval( 4 );
+  intervalFilter->Update();
+
+  FilterType::Pointer changeFilter = FilterType::New();
+  changeFilter->SetInput( image );
+  changeFilter->SetUseSemiImplicitScheme( true );
+  changeFilter->SetTimeStep( 0.5 );
+  changeFilter->SetNumberOfIterations( 4 );
+  changeFilter->SetTensorUpdateInterval( 4 );
+  changeFilter->SetTensorUpdateChangeThreshold( 0.001 );
+  changeFilter->Update();
+
+  std::cout << "Explicit time: " << explicitTimer.GetMean() << " s"
+    << std::endl;
+  std::cout << "Semi-implicit time: " << semiImplicitTimer.GetMean()
+    << " s" << std::endl;
+  std::cout << "Semi-implicit time, tensors every other iteration: "
+    << reuseTimer.GetMean() << " s" << std::endl;
+
+  int status = EXIT_SUCCESS;
+
+  if( explicitFilter->GetNumberOfTensorUpdates() != 40
+    || semiImplicitFilter->GetNumberOfTensorUpdates() != 4
+    || reuseFilter->GetNumberOfTensorUpdates() != 2
+    || intervalFilter->GetNumberOfTensorUpdates() != 1
+    || changeFilter->GetNumberOfTensorUpdates() != 4 )
+    {
+    std::cerr << "Wrong number of tensor updates: "
+      << explicitFilter->GetNumberOfTensorUpdates() << ", "
+      << semiImplicitFilter->GetNumberOfTensorUpdates() << ", "
+      << reuseFilter->GetNumberOfTensorUpdates() << ", "
+      << intervalFilter->GetNumberOfTensorUpdates() << ", "
+      << changeFilter->GetNumberOfTensorUpdates() << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  // Every iteration changes the image by more than the threshold, so the
+  // tensors are computed as often as without reuse
+  if( RMSDifference< ImageType >( changeFilter->GetOutput(),
+    semiImplicitFilter->GetOutput() ) != 0 )
+    {
+    std::cerr << "The change threshold did not force tensor updates."
+      << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  // Both schemes approximate the same diffusion
+  const double inputDifference = RMSDifference< ImageType >( image,
+    explicitFilter->GetOutput() );
+  const double semiImplicitDifference = RMSDifference< ImageType >(
+    semiImplicitFilter->GetOutput(), explicitFilter->GetOutput() );
+  const double reuseDifference = RMSDifference< ImageType >(
+    reuseFilter->GetOutput(), explicitFilter->GetOutput() );
+  std::cout << "RMS difference to the explicit result: input = "
+    << inputDifference << ", semi-implicit = " << semiImplicitDifference
+    << ", reused tensors = " << reuseDifference << std::endl;
+  if( !( semiImplicitDifference < 0.35 * inputDifference )
+    || !( reuseDifference < 0.35 * inputDifference ) )
+    {
+    std::cerr << "Semi-implicit result differs from the explicit result."
+      << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  return status;
+}
@@ -0,0 +1,185 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeGeneralizedDistanceTransformImageFilter.h"
+
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <vector>
+
+// Compare the distance and voronoi maps of a few scattered foreground
+// pixels against an exhaustive search over those pixels.
+template< unsigned int VDimension >
+int itktubeGeneralizedDistanceTransformImageFilterTestBruteForce(
+  const typename itk::Image< float, VDimension >::SizeType & size,
+  const typename itk::Image< float, VDimension >::SpacingType & spacing,
+  bool useImageSpacing, unsigned int numberOfThreads )
+{
+  typedef itk::Image< float, VDimension >               ImageType;
+  typedef itk::Image< unsigned short, VDimension >      LabelImageType;
+  typedef itk::tube::GeneralizedDistanceTransformImageFilter< ImageType,
+    ImageType, LabelImageType >                         FilterType;
+  typedef typename ImageType::IndexType                 IndexType;
+
+  typename ImageType::RegionType region;
+  region.SetSize( size );
+
+  typename ImageType::Pointer function = ImageType::New();
+  function->SetRegions( region );
+  function->SetSpacing( spacing );
+  function->Allocate();
+
+  typename LabelImageType::Pointer labels = LabelImageType::New();
+  labels->SetRegions( region );
+  labels->SetSpacing( spacing );
+  labels->Allocate();
+  labels->FillBuffer( 0 );
+
+  typename FilterType::Pointer filter = FilterType::New();
+  function->FillBuffer( filter->GetMaximalSquaredDistance() );
+
+  // Deterministic, irregularly spaced foreground pixels, including one
+  // on the image border.
+  std::vector< IndexType > points;
+  for( unsigned int p = 0; p < 5; ++p )
+    {
+    IndexType index;
+    for( unsigned int d = 0; d < VDimension; ++d )
+      {
+      index[d] = ( 7 * p + 3 * d * p + 2 * d ) % size[d];
+      }
+    bool duplicate = false;
+    for( unsigned int q = 0; q < points.size(); ++q )
+      {
+      duplicate = duplicate || points[q] == index;
+      }
+    if( !duplicate )
+      {
+      points.push_back( index );
+      function->SetPixel( index, 0 );
+      labels->SetPixel( index, points.size() );
+      }
+    }
+
+  filter->SetInput1( function );
+  filter->SetInput2( labels );
+  filter->SetCreateVoronoiMap( true );
+  filter->SetUseImageSpacing( useImageSpacing );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+
+  typename ImageType::Pointer distance = filter->GetDistance();
+  typename LabelImageType::Pointer voronoi = filter->GetVoronoiMap();
+
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( distance,
+    region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const IndexType index = it.GetIndex();
+    double minimum = filter->GetMaximalSquaredDistance();
+    std::vector< double > pointDistances( points.size() );
+    for( unsigned int q = 0; q < points.size(); ++q )
+      {
+      double dist = 0;
+      for( unsigned int d = 0; d < VDimension; ++d )
+        {
+        double delta = index[d] - points[q][d];
+        if( useImageSpacing )
+          {
+          delta *= spacing[d];
+          }
+        dist += delta * delta;
+        }
+      pointDistances[q] = dist;
+      if( dist < minimum )
+        {
+        minimum = dist;
+        }
+      }
+
+    if( vnl_math_abs( it.Get() - minimum ) > 1e-3 * ( 1 + minimum ) )
+      {
+      std::cerr << "Distance at " << index << " is " << it.Get()
+        << " instead of " << minimum << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Ties may go to any of the nearest points.
+    const unsigned short label = voronoi->GetPixel( index );
+    if( label == 0 || label > points.size()
+      || vnl_math_abs( pointDistances[label - 1] - minimum )
+        > 1e-3 * ( 1 + minimum ) )
+      {
+      std::cerr << "Voronoi label at " << index << " is " << label
+        << ", which is not a nearest foreground pixel." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int itktubeGeneralizedDistanceTransformImageFilterTest(
+  int itkNotUsed( argc ), char * itkNotUsed( argv )[] )
+{
+  itk::Image< float, 2 >::SizeType size2D;
+  size2D[0] = 23;
+  size2D[1] = 17;
+  itk::Image< float, 2 >::SpacingType spacing2D;
+  spacing2D[0] = 0.5;
+  spacing2D[1] = 2.0;
+
+  itk::Image< float, 3 >::SizeType size3D;
+  size3D[0] = 11;
+  size3D[1] = 9;
+  size3D[2] = 13;
+  itk::Image< float, 3 >::SpacingType spacing3D;
+  spacing3D[0] = 1.0;
+  spacing3D[1] = 0.75;
+  spacing3D[2] = 1.5;
+
+  // Pixel units, physical units, and a single thread against several.
+  for( unsigned int threads = 1; threads <= 4; threads += 3 )
+    {
+    for( unsigned int useSpacing = 0; useSpacing < 2; ++useSpacing )
+      {
+      if( itktubeGeneralizedDistanceTransformImageFilterTestBruteForce< 2 >(
+          size2D, spacing2D, useSpacing != 0, threads ) != EXIT_SUCCESS
+        || itktubeGeneralizedDistanceTransformImageFilterTestBruteForce< 3 >(
+          size3D, spacing3D, useSpacing != 0, threads ) != EXIT_SUCCESS )
+        {
+        std::cerr << "Failed with " << threads << " threads and "
+          << ( useSpacing ? "" : "no " ) << "image spacing." << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  typedef itk::tube::GeneralizedDistanceTransformImageFilter<
+    itk::Image< float, 2 > > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  std::cout << filter << std::endl;
+
+  return EXIT_SUCCESS;
+}
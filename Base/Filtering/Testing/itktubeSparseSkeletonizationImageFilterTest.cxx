@@ -0,0 +1,219 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeSparseSkeletonizationImageFilter.h"
+
+#include <itkConnectedComponentImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+int itktubeSparseSkeletonizationImageFilterTest( int itkNotUsed( argc ),
+  char * itkNotUsed( argv )[] )
+{
+  typedef unsigned char                                  PixelType;
+  typedef itk::Image< PixelType, 3 >                     ImageType;
+  typedef itk::Image< PixelType, 2 >                     Image2DType;
+  typedef itk::tube::SparseSkeletonizationImageFilter< ImageType,
+    ImageType >                                          FilterType;
+  typedef itk::tube::SparseSkeletonizationImageFilter< Image2DType,
+    Image2DType >                                        Filter2DType;
+
+  // Two thick cylinders forming a T: the skeleton must be a single
+  // connected curve with three end points.
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 60;
+  size[1] = 30;
+  size[2] = 30;
+  region.SetSize( size );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const long dy = index[1] - 15;
+    const long dz = index[2] - 15;
+    const long dx = index[0] - 30;
+    const bool trunk = index[0] >= 5 && index[0] < 55
+      && dy * dy + dz * dz <= 64;
+    const bool branch = index[1] >= 15 && dx * dx + dz * dz <= 16;
+    it.Set( ( trunk || branch ) ? 1 : 0 );
+    }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetBlockSize( 4 );
+  filter->SetForegroundValue( 255 );
+  filter->Update();
+  ImageType::Pointer skeleton = filter->GetOutput();
+
+  // The result must not depend on the number of threads.
+  FilterType::Pointer singleThreadFilter = FilterType::New();
+  singleThreadFilter->SetInput( image );
+  singleThreadFilter->SetBlockSize( 4 );
+  singleThreadFilter->SetForegroundValue( 255 );
+  singleThreadFilter->SetNumberOfThreads( 1 );
+  singleThreadFilter->Update();
+
+  // Nor on the block size, including blocks of one slice and a last
+  // block shorter than the others.
+  FilterType::Pointer sliceBlockFilter = FilterType::New();
+  sliceBlockFilter->SetInput( image );
+  sliceBlockFilter->SetBlockSize( 1 );
+  sliceBlockFilter->SetForegroundValue( 255 );
+  sliceBlockFilter->Update();
+
+  FilterType::Pointer oddBlockFilter = FilterType::New();
+  oddBlockFilter->SetInput( image );
+  oddBlockFilter->SetBlockSize( 7 );
+  oddBlockFilter->SetForegroundValue( 255 );
+  oddBlockFilter->Update();
+
+  typedef itk::ImageRegionConstIterator< ImageType > ConstIteratorType;
+  ConstIteratorType inputIt( image, region );
+  ConstIteratorType skeletonIt( skeleton, region );
+  ConstIteratorType singleThreadIt( singleThreadFilter->GetOutput(),
+    region );
+  ConstIteratorType sliceBlockIt( sliceBlockFilter->GetOutput(), region );
+  ConstIteratorType oddBlockIt( oddBlockFilter->GetOutput(), region );
+  unsigned int numberOfSkeletonVoxels = 0;
+  for( ; !inputIt.IsAtEnd(); ++inputIt, ++skeletonIt, ++singleThreadIt,
+    ++sliceBlockIt, ++oddBlockIt )
+    {
+    if( skeletonIt.Get() != singleThreadIt.Get() )
+      {
+      std::cerr << "The skeleton depends on the number of threads."
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( skeletonIt.Get() != sliceBlockIt.Get()
+      || skeletonIt.Get() != oddBlockIt.Get() )
+      {
+      std::cerr << "The skeleton depends on the block size."
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( skeletonIt.Get() != 0 )
+      {
+      if( skeletonIt.Get() != 255 || inputIt.Get() == 0 )
+        {
+        std::cerr << "Invalid skeleton voxel." << std::endl;
+        return EXIT_FAILURE;
+        }
+      ++numberOfSkeletonVoxels;
+      }
+    }
+
+  const FilterType::SkeletonPointListType & points =
+    filter->GetSkeletonPoints();
+  if( sliceBlockFilter->GetSkeletonPoints().size() != points.size()
+    || oddBlockFilter->GetSkeletonPoints().size() != points.size() )
+    {
+    std::cerr << "The skeleton points depend on the block size."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( numberOfSkeletonVoxels == 0 || points.size() != numberOfSkeletonVoxels )
+    {
+    std::cerr << "Expected " << numberOfSkeletonVoxels
+      << " skeleton points, got " << points.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned int numberOfEndPoints = 0;
+  for( unsigned int i = 0; i < points.size(); ++i )
+    {
+    if( skeleton->GetPixel( points[i].Index ) == 0 )
+      {
+      std::cerr << "Skeleton point " << points[i].Index
+        << " is not in the skeleton image." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( points[i].NumberOfNeighbors == 1 )
+      {
+      ++numberOfEndPoints;
+      }
+    }
+  if( numberOfEndPoints != 3 )
+    {
+    std::cerr << "Expected 3 end points, got " << numberOfEndPoints
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ConnectedComponentImageFilter< ImageType, ImageType >
+    ComponentsType;
+  ComponentsType::Pointer components = ComponentsType::New();
+  components->SetInput( skeleton );
+  components->SetFullyConnected( true );
+  components->Update();
+  if( components->GetObjectCount() != 1 )
+    {
+    std::cerr << "The skeleton has " << components->GetObjectCount()
+      << " components instead of 1." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A 2D ring must thin to a closed loop.
+  Image2DType::RegionType region2D;
+  Image2DType::SizeType size2D;
+  size2D.Fill( 50 );
+  region2D.SetSize( size2D );
+  Image2DType::Pointer ring = Image2DType::New();
+  ring->SetRegions( region2D );
+  ring->Allocate();
+  itk::ImageRegionIteratorWithIndex< Image2DType > ringIt( ring, region2D );
+  for( ringIt.GoToBegin(); !ringIt.IsAtEnd(); ++ringIt )
+    {
+    const long dx = ringIt.GetIndex()[0] - 25;
+    const long dy = ringIt.GetIndex()[1] - 25;
+    const long r2 = dx * dx + dy * dy;
+    ringIt.Set( ( r2 >= 100 && r2 <= 400 ) ? 1 : 0 );
+    }
+
+  Filter2DType::Pointer filter2D = Filter2DType::New();
+  filter2D->SetInput( ring );
+  filter2D->Update();
+  const Filter2DType::SkeletonPointListType & loop =
+    filter2D->GetSkeletonPoints();
+  if( loop.empty() )
+    {
+    std::cerr << "The ring vanished." << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( unsigned int i = 0; i < loop.size(); ++i )
+    {
+    if( loop[i].NumberOfNeighbors != 2 )
+      {
+      std::cerr << "Ring skeleton point " << loop[i].Index << " has "
+        << loop[i].NumberOfNeighbors << " neighbors." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << filter << std::endl;
+
+  return EXIT_SUCCESS;
+}
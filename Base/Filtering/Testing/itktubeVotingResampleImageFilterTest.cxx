@@ -0,0 +1,174 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeVotingResampleImageFilter.h"
+
+#include <itkIdentityTransform.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkResampleImageFilter.h>
+
+int itktubeVotingResampleImageFilterTest( int itkNotUsed( argc ),
+  char * itkNotUsed( argv )[] )
+{
+  const unsigned int Dimension = 3;
+  typedef unsigned char                         PixelType;
+  typedef itk::Image< PixelType, Dimension >    ImageType;
+
+  // Blocky label image with some noise, so that the votes are not all
+  // unanimous.
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 23;
+  size[1] = 17;
+  size[2] = 11;
+  region.SetSize( size );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.5;
+  spacing[2] = 2.0;
+  image->SetSpacing( spacing );
+  ImageType::PointType origin;
+  origin[0] = -3.0;
+  origin[1] = 1.5;
+  origin[2] = 0.25;
+  image->SetOrigin( origin );
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator
+    RandomType;
+  RandomType::Pointer random = RandomType::New();
+  random->Initialize( 1234 );
+  typedef itk::ImageRegionIterator< ImageType > IteratorType;
+  IteratorType it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    PixelType label = static_cast< PixelType >( ( index[0] / 4
+      + index[1] / 5 + index[2] / 3 ) % 4 );
+    if( random->GetUniformVariate( 0.0, 1.0 ) < 0.2 )
+      {
+      label = static_cast< PixelType >( random->GetIntegerVariate( 5 ) );
+      }
+    it.Set( label );
+    }
+
+  typedef itk::tube::VotingResampleImageFilter< ImageType > FilterType;
+  typedef itk::ResampleImageFilter< ImageType, ImageType >  ResampleType;
+  typedef itk::tube::VotingResampleImageFunction< ImageType, double >
+    FunctionType;
+  typedef itk::IdentityTransform< double, Dimension > TransformType;
+
+  // Upsampling, downsampling and grids extending past the input; the
+  // spacings and origins are exact in binary so that both filters see the
+  // same continuous indices.
+  const double scales[] = { 0.5, 0.75, 2.0, 1.25 };
+  const double shifts[] = { 0.0, 0.25, -1.5, 3.0 };
+  for( unsigned int test = 0; test < 4; ++test )
+    {
+    ImageType::SpacingType outputSpacing;
+    ImageType::PointType outputOrigin;
+    ImageType::SizeType outputSize;
+    ImageType::IndexType outputIndex;
+    for( unsigned int i = 0; i < Dimension; ++i )
+      {
+      outputSpacing[i] = spacing[i] * scales[test];
+      outputOrigin[i] = origin[i] + shifts[test];
+      outputSize[i] = static_cast< itk::SizeValueType >(
+        size[i] / scales[test] ) + 2;
+      outputIndex[i] = -1;
+      }
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( image );
+    filter->SetSize( outputSize );
+    filter->SetOutputStartIndex( outputIndex );
+    filter->SetOutputOrigin( outputOrigin );
+    filter->SetOutputSpacing( outputSpacing );
+    filter->SetDefaultPixelValue( 7 );
+    filter->Update();
+
+    ResampleType::Pointer resample = ResampleType::New();
+    resample->SetInput( image );
+    resample->SetInterpolator( FunctionType::New() );
+    resample->SetTransform( TransformType::New() );
+    resample->SetOutputParametersFromImage( filter->GetOutput() );
+    resample->SetDefaultPixelValue( 7 );
+    resample->Update();
+
+    typedef itk::ImageRegionConstIterator< ImageType > ConstIteratorType;
+    ConstIteratorType filterIt( filter->GetOutput(),
+      filter->GetOutput()->GetLargestPossibleRegion() );
+    ConstIteratorType resampleIt( resample->GetOutput(),
+      resample->GetOutput()->GetLargestPossibleRegion() );
+    unsigned int numberOfDifferences = 0;
+    while( !filterIt.IsAtEnd() )
+      {
+      if( filterIt.Get() != resampleIt.Get() )
+        {
+        ++numberOfDifferences;
+        }
+      ++filterIt;
+      ++resampleIt;
+      }
+    if( numberOfDifferences > 0 )
+      {
+      std::cerr << "Test " << test << ": " << numberOfDifferences
+        << " voxels differ from ResampleImageFilter." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Grids with different directions are rejected.
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetSize( size );
+  FilterType::DirectionType direction;
+  direction.Fill( 0.0 );
+  direction[0][1] = 1.0;
+  direction[1][0] = 1.0;
+  direction[2][2] = 1.0;
+  filter->SetOutputDirection( direction );
+  bool caught = false;
+  try
+    {
+    filter->Update();
+    }
+  catch( itk::ExceptionObject & )
+    {
+    caught = true;
+    }
+  if( !caught )
+    {
+    std::cerr << "Expected an exception for differing directions."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << filter << std::endl;
+
+  return EXIT_SUCCESS;
+}
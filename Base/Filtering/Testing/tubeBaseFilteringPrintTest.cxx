@@ -28,12 +28,16 @@ limitations under the License.
 #include "itktubeAnisotropicHybridDiffusionImageFilter.h"
 #include "itktubeExtractTubePointsSpatialObjectFilter.h"
 #include "itktubeFFTGaussianDerivativeIFFTFilter.h"
+#include "itktubeGaussianScaleSpaceCache.h"
+#include "itktubeGeneralizedDistanceTransformImageFilter.h"
 #include "itktubeRidgeFFTFilter.h"
 #include "itktubeSheetnessMeasureImageFilter.h"
 #include "itktubeShrinkUsingMaxImageFilter.h"
+#include "itktubeSparseSkeletonizationImageFilter.h"
 #include "itktubeStructureTensorRecursiveGaussianImageFilter.h"
 #include "itktubeSymmetricEigenVectorAnalysisImageFilter.h"
 #include "itktubeTubeEnhancingDiffusion2DImageFilter.h"
+#include "itktubeVotingResampleImageFilter.h"
 
 #include <itkImage.h>
 #include <itkMatrix.h>
@@ -82,6 +86,18 @@ int tubeBaseFilteringPrintTest( int itkNotUsed( argc ), char * itkNotUsed( argv
     FFTGaussianDerivativeIFFTFilter::New();
   std::cout << "-------------fgdif " << fgdif << std::endl;
 
+  typedef itk::tube::GaussianScaleSpaceCache< ImageType >
+    GaussianScaleSpaceCacheType;
+  GaussianScaleSpaceCacheType::Pointer gssc =
+    GaussianScaleSpaceCacheType::New();
+  std::cout << "-------------gssc " << gssc << std::endl;
+
+  typedef itk::tube::GeneralizedDistanceTransformImageFilter< ImageType >
+    GeneralizedDistanceTransformImageFilterType;
+  GeneralizedDistanceTransformImageFilterType::Pointer gdtif =
+    GeneralizedDistanceTransformImageFilterType::New();
+  std::cout << "-------------gdtif " << gdtif << std::endl;
+
   typedef itk::tube::RidgeFFTFilter< ImageType > RidgeFFTFilterType;
   RidgeFFTFilterType::Pointer rfif = RidgeFFTFilterType::New();
   std::cout << "-------------rfif " << rfif << std::endl;
@@ -126,5 +142,19 @@ int tubeBaseFilteringPrintTest( int itkNotUsed( argc ), char * itkNotUsed( argv
   std::cout << "-------------ShrinkUsingMaxImageFilter"
     << shrinkUsingMaxImageFilterObj << std::endl;
 
+  typedef itk::Image< unsigned char, Dimension > BinaryImageType;
+  itk::tube::SparseSkeletonizationImageFilter< BinaryImageType,
+    BinaryImageType >::Pointer sparseSkeletonizationImageFilterObj =
+    itk::tube::SparseSkeletonizationImageFilter< BinaryImageType,
+      BinaryImageType >::New();
+  std::cout << "-------------SparseSkeletonizationImageFilter"
+    << sparseSkeletonizationImageFilterObj << std::endl;
+
+  itk::tube::VotingResampleImageFilter< ImageType, ImageType >::Pointer
+    votingResampleImageFilterObj =
+    itk::tube::VotingResampleImageFilter< ImageType, ImageType >::New();
+  std::cout << "-------------VotingResampleImageFilter"
+    << votingResampleImageFilterObj << std::endl;
+
   return EXIT_SUCCESS;
 }
@@ -31,6 +31,8 @@ void RegisterTests( void )
   REGISTER_TEST( tubeBaseFilteringPrintTest );
   REGISTER_TEST( itktubeExtractTubePointsSpatialObjectFilterTest );
   REGISTER_TEST( itktubeFFTGaussianDerivativeIFFTFilterTest );
+  REGISTER_TEST( itktubeGaussianScaleSpaceCacheTest );
+  REGISTER_TEST( itktubeGeneralizedDistanceTransformImageFilterTest );
   REGISTER_TEST( itktubeRidgeFFTFilterTest );
   REGISTER_TEST( itktubeSubSampleTubeSpatialObjectFilterTest );
   REGISTER_TEST( itktubeSubSampleTubeTreeSpatialObjectFilterTest );
@@ -40,7 +42,10 @@ void RegisterTests( void )
   REGISTER_TEST( itktubeSheetnessMeasureImageFilterTest );
   REGISTER_TEST( itktubeSheetnessMeasureImageFilterTest2 );
   REGISTER_TEST( itktubeShrinkUsingMaxImageFilterTest );
+  REGISTER_TEST( itktubeSparseSkeletonizationImageFilterTest );
   REGISTER_TEST( itktubeAnisotropicHybridDiffusionImageFilterTest );
+  REGISTER_TEST( itktubeAnisotropicHybridDiffusionImageFilterTest2 );
   REGISTER_TEST( itktubeAnisotropicCoherenceEnhancingDiffusionImageFilterTest );
   REGISTER_TEST( itktubeAnisotropicEdgeEnhancementDiffusionImageFilterTest );
+  REGISTER_TEST( itktubeVotingResampleImageFilterTest );
 }
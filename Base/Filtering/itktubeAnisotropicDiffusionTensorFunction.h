@@ -42,6 +42,9 @@ namespace tube
  * \brief This class is a function object that is used
  * to create a solver filter for edge enhancement diffusion equation
  *
+ * The diffusion tensors and the derivatives are computed and stored with the
+ * TScalarValue precision.
+ *
  * \warning Does not handle image directions.  Re-orient images to axial
  * (direction cosines = identity matrix) before using this function.
  *
@@ -49,7 +52,7 @@ namespace tube
  * \ingroup FiniteDifferenceFunctions
  * \ingroup Functions
  */
-template< class TImageType >
+template< class TImageType, class TScalarValue = double >
 class AnisotropicDiffusionTensorFunction
   : public FiniteDifferenceFunction< TImageType >
 {
@@ -72,13 +75,13 @@ public:
   /** Convenient typedefs. */
   typedef typename Superclass::TimeStepType               TimeStepType;
   typedef typename Superclass::PixelType                  PixelType;
-  typedef double                                          ScalarValueType;
+  typedef TScalarValue                                    ScalarValueType;
   typedef typename Superclass::NeighborhoodType           NeighborhoodType;
   typedef typename Superclass::FloatOffsetType            FloatOffsetType;
   typedef typename Superclass::ImageType::SpacingType     SpacingType;
 
   /** Diffusion tensor typedefs. */
-  typedef DiffusionTensor3D< double >                     DiffusionTensorType;
+  typedef DiffusionTensor3D< ScalarValueType >            DiffusionTensorType;
   typedef itk::Image< DiffusionTensorType, 3 >
       DiffusionTensorImageType;
   /** The default boundary condition for finite difference
@@ -32,8 +32,8 @@ namespace itk
 namespace tube
 {
 
-template< class TImageType >
-AnisotropicDiffusionTensorFunction< TImageType>
+template< class TImageType, class TScalarValue >
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::AnisotropicDiffusionTensorFunction( void )
 {
   typename Superclass::RadiusType r;
@@ -71,17 +71,17 @@ AnisotropicDiffusionTensorFunction< TImageType>
   this->m_UseImageSpacing = true;
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 void
-AnisotropicDiffusionTensorFunction<TImageType>
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::PrintSelf(std::ostream& os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
 }
 
-template< class TImageType >
-typename AnisotropicDiffusionTensorFunction< TImageType >::PixelType
-AnisotropicDiffusionTensorFunction< TImageType >
+template< class TImageType, class TScalarValue >
+typename AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >::PixelType
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeUpdate(const NeighborhoodType &neighborhood,
                 void *globalData,
                 const FloatOffsetType& offset)
@@ -95,9 +95,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
                               offset );
 }
 
-template< class TImageType >
-typename AnisotropicDiffusionTensorFunction< TImageType >::PixelType
-AnisotropicDiffusionTensorFunction< TImageType >
+template< class TImageType, class TScalarValue >
+typename AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >::PixelType
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeUpdate(const NeighborhoodType &neighborhood,
                 const DiffusionTensorNeighborhoodType &tensorNeighborhood,
                 const SpacingType &spacing,
@@ -121,9 +121,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
   return this->ComputeFinalUpdateTerm( tensorNeighborhood, gd );
 }
 
-template< class TImageType >
-typename AnisotropicDiffusionTensorFunction< TImageType >::PixelType
-AnisotropicDiffusionTensorFunction< TImageType >
+template< class TImageType, class TScalarValue >
+typename AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >::PixelType
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeUpdate(
     const DiffusionTensorNeighborhoodType &tensorNeighborhood,
     const ScalarDerivativeImageRegionType &intensityFirstDerivatives,
@@ -150,9 +150,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
   return this->ComputeFinalUpdateTerm( tensorNeighborhood, gd );
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 void
-AnisotropicDiffusionTensorFunction< TImageType >
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeDiffusionTensorFirstOrderPartialDerivatives(
     const DiffusionTensorNeighborhoodType &tensorNeighborhood,
     TensorDerivativeType &firstOrderResult,
@@ -179,9 +179,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
     }
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 void
-AnisotropicDiffusionTensorFunction< TImageType >
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeDiffusionTensorFirstOrderPartialDerivatives(
     const DiffusionTensorNeighborhoodType &tensorNeighborhood,
     TensorDerivativeImageRegionType &firstOrderResult,
@@ -191,9 +191,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
       tensorNeighborhood, firstOrderResult.Value(), spacing );
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 void
-AnisotropicDiffusionTensorFunction< TImageType >
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeIntensityFirstAndSecondOrderPartialDerivatives(
     const NeighborhoodType &neighborhood,
     ScalarDerivativeType &firstOrderResult,
@@ -240,9 +240,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
     }
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 void
-AnisotropicDiffusionTensorFunction< TImageType >
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeIntensityFirstAndSecondOrderPartialDerivatives(
     const NeighborhoodType &neighborhood,
     ScalarDerivativeImageRegionType &firstOrderResult,
@@ -256,9 +256,9 @@ AnisotropicDiffusionTensorFunction< TImageType >
      spacing );
 }
 
-template< class TImageType >
-typename AnisotropicDiffusionTensorFunction< TImageType >::PixelType
-AnisotropicDiffusionTensorFunction< TImageType >
+template< class TImageType, class TScalarValue >
+typename AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >::PixelType
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::ComputeFinalUpdateTerm(
     const DiffusionTensorNeighborhoodType &tensorNeighborhood,
     const GlobalDataStruct *gd) const
@@ -299,10 +299,10 @@ AnisotropicDiffusionTensorFunction< TImageType >
   return ( PixelType ) ( total );
 }
 
-template< class TImageType >
+template< class TImageType, class TScalarValue >
 template< class TPixel, unsigned int VImageDimension >
 void
-AnisotropicDiffusionTensorFunction<TImageType>
+AnisotropicDiffusionTensorFunction< TImageType, TScalarValue >
 ::CheckTimeStepStability(
     const itk::Image< TPixel, VImageDimension > * input,
     bool useImageSpacing )
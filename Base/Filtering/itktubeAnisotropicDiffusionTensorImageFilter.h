@@ -29,6 +29,8 @@ limitations under the License.
 #include <itkFiniteDifferenceImageFilter.h>
 #include <itkMultiThreader.h>
 
+#include <vector>
+
 namespace itk
 {
 
@@ -39,6 +41,23 @@ namespace tube
  * \brief This is a superclass for filters that iteratively enhance edges in
  *        an image by solving a non-linear diffusion equation.
  *
+ * By default the diffusion equation is solved with explicit finite-difference
+ * steps, whose time step is limited by stability.  When
+ * UseSemiImplicitScheme is on, each iteration instead solves the diagonal
+ * terms of the diffusion tensor implicitly using additive operator
+ * splitting (AOS), one tridiagonal system per image line and axis, while
+ * the mixed derivative terms are treated explicitly.  This allows much
+ * larger time steps, although a warning is still issued when the time step
+ * is too large for the explicit mixed terms.  The semi-implicit solver
+ * reads the diffusion tensors from a packed, single precision copy of the
+ * diffusion tensor image; the buffer of the diffusion tensor image itself
+ * is released between tensor updates.
+ *
+ * Computing the diffusion tensors usually dominates the cost of an
+ * iteration.  The tensors can be reused for up to TensorUpdateInterval
+ * iterations, as long as the root mean square change of the image since
+ * they were computed stays below TensorUpdateChangeThreshold.
+ *
  * \warning Does not handle image directions.  Re-orient images to axial
  * (direction cosines = identity matrix) before using this function.
  *
@@ -104,6 +123,30 @@ public:
   itkSetMacro( TimeStep, double );
   itkGetMacro( TimeStep, double );
 
+  /** Set/Get whether the semi-implicit (AOS) scheme is used instead of
+   * explicit steps.  Defaults to false. */
+  itkSetMacro( UseSemiImplicitScheme, bool );
+  itkGetConstMacro( UseSemiImplicitScheme, bool );
+  itkBooleanMacro( UseSemiImplicitScheme );
+
+  /** Set/Get the maximum number of iterations the diffusion tensors are
+   * reused for.  Defaults to 1: the tensors are computed every
+   * iteration. */
+  itkSetClampMacro( TensorUpdateInterval, unsigned int, 1,
+    NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( TensorUpdateInterval, unsigned int );
+
+  /** Set/Get the root mean square change of the image, accumulated over
+   * the iterations since the diffusion tensors were computed, above which
+   * they are computed again before TensorUpdateInterval is reached.
+   * Defaults to the largest double: only the interval is used. */
+  itkSetMacro( TensorUpdateChangeThreshold, double );
+  itkGetConstMacro( TensorUpdateChangeThreshold, double );
+
+  /** Get the number of times the diffusion tensors were computed by the
+   * last update. */
+  itkGetConstMacro( NumberOfTensorUpdates, unsigned int );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( OutputTimesDoubleCheck,
@@ -188,6 +231,19 @@ protected:
 
   DiffusionTensorImagePointerType GetDiffusionTensorImage( void );
 
+  /** Advance the output by one semi-implicit step of size dt, using the
+   * packed diffusion tensors.
+   * \sa SemiImplicitThreaderCallback */
+  virtual void ApplySemiImplicitUpdate( const TimeStepType & dt );
+
+  /** Copy the diffusion tensor image into the packed single precision
+   * tensors read by the semi-implicit scheme, then release its buffer. */
+  void PackDiffusionTensorImage( void );
+
+  /** Warn if the time step is too large for the explicit mixed derivative
+   * terms of the semi-implicit scheme, given the packed tensors. */
+  void CheckSemiImplicitTimeStepStability( void );
+
 private:
   //purposely not implemented
   AnisotropicDiffusionTensorImageFilter(const Self&);
@@ -212,6 +268,54 @@ private:
    * which it then passes to ThreadedCalculateChange for processing. */
   static ITK_THREAD_RETURN_TYPE CalculateChangeThreaderCallback( void *arg );
 
+  /** Steps of the semi-implicit scheme, each run on all threads */
+  enum SemiImplicitStageType { PackStage, ExplicitTermsStage, SolveStage,
+    ApplyStage };
+
+  /** Structure for passing information into the semi-implicit callback */
+  struct SemiImplicitThreadStruct
+    {
+    AnisotropicDiffusionTensorImageFilter * Filter;
+    SemiImplicitStageType                   Stage;
+    TimeStepType                            TimeStep;
+    unsigned int                            Axis;
+    FixedArray< double, ImageDimension >    Spacing;
+
+    }; // End struct SemiImplicitThreadStruct
+
+  /** This callback method splits the slices of the buffered region, or
+   * the image lines along an axis, among the threads. */
+  static ITK_THREAD_RETURN_TYPE SemiImplicitThreaderCallback( void *arg );
+
+  /** Pack the diffusion tensors of the pixels [begin, end), recording the
+   * largest weight of their mixed derivative terms */
+  void ThreadedPackDiffusionTensors( const SemiImplicitThreadStruct & str,
+    OffsetValueType begin, OffsetValueType end, ThreadIdType threadId );
+
+  /** Spacing used by the finite differences of the semi-implicit scheme */
+  FixedArray< double, ImageDimension > GetSemiImplicitSpacing( void );
+
+  /** Store u + dt * ( mixed derivative terms ) in the update buffer for
+   * the pixels [begin, end) */
+  void ThreadedSemiImplicitExplicitTerms(
+    const SemiImplicitThreadStruct & str, OffsetValueType begin,
+    OffsetValueType end );
+
+  /** Solve the implicit one-dimensional diffusion along str.Axis for the
+   * image lines [beginLine, endLine), adding the average of the
+   * solutions to the semi-implicit buffer */
+  void ThreadedSemiImplicitSolve( const SemiImplicitThreadStruct & str,
+    SizeValueType beginLine, SizeValueType endLine );
+
+  /** Copy the semi-implicit buffer to the output for the pixels
+   * [begin, end), measuring the change */
+  void ThreadedSemiImplicitApply( OffsetValueType begin,
+    OffsetValueType end, ThreadIdType threadId );
+
+  /** Add the root mean square change of the last iteration, gathered per
+   * thread, to the change since the last tensor update */
+  void AccumulateChangeSinceTensorUpdate( void );
+
   typename DiffusionTensorImageType::Pointer            m_DiffusionTensorImage;
 
   /** The buffer that holds the updates for an iteration of the algorithm. */
@@ -219,6 +323,27 @@ private:
 
   TimeStepType                                          m_TimeStep;
 
+  bool                                                  m_UseSemiImplicitScheme;
+
+  /** Holds the sum of the AOS solutions of an iteration */
+  typename UpdateBufferType::Pointer                    m_SemiImplicitBuffer;
+
+  /** Upper triangles of the diffusion tensors, pixel after pixel */
+  std::vector< float >                                  m_PackedDiffusionTensors;
+
+  unsigned int                                          m_TensorUpdateInterval;
+  double                                                m_TensorUpdateChangeThreshold;
+  unsigned int                                          m_NumberOfTensorUpdates;
+  unsigned int                                          m_IterationsSinceTensorUpdate;
+  double                                                m_ChangeSinceTensorUpdate;
+
+  /** Sum of the squared changes of the last iteration, per thread */
+  std::vector< double >                                 m_ThreadChangeList;
+
+  /** Largest sum over i != j of |D_ij| / ( h_i h_j ) of the packed
+   * tensors, per thread */
+  std::vector< double >                                 m_ThreadMixedWeightList;
+
 }; // End class AnisotropicDiffusionTensorImageFilter
 
 } // End namespace tube
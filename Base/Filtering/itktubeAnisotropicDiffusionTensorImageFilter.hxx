@@ -36,6 +36,8 @@ limitations under the License.
 #include <itkNumericTraits.h>
 #include <itkVector.h>
 
+#include <algorithm>
+#include <cmath>
 #include <list>
 
 namespace itk
@@ -56,6 +58,15 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   this->SetNumberOfIterations(1);
   m_TimeStep = 0.11;
 
+  m_UseSemiImplicitScheme = false;
+  m_SemiImplicitBuffer = UpdateBufferType::New();
+
+  m_TensorUpdateInterval = 1;
+  m_TensorUpdateChangeThreshold = NumericTraits< double >::max();
+  m_NumberOfTensorUpdates = 0;
+  m_IterationsSinceTensorUpdate = 0;
+  m_ChangeSinceTensorUpdate = 0;
+
   //set the finite difference function object
   typename AnisotropicDiffusionTensorFunction<UpdateBufferType>::Pointer q
       = AnisotropicDiffusionTensorFunction<UpdateBufferType>::New();
@@ -85,8 +96,12 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
 
   f->SetTimeStep(m_TimeStep);
 
-  // Check the timestep for stability
-  f->CheckTimeStepStability( this->GetInput(), this->GetUseImageSpacing() );
+  // Check the timestep for stability; the semi-implicit scheme is meant to
+  // take larger steps
+  if( !m_UseSemiImplicitScheme )
+    {
+    f->CheckTimeStepStability( this->GetInput(), this->GetUseImageSpacing() );
+    }
 
   f->InitializeIteration();
 
@@ -101,8 +116,29 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
     }
 
   // Update the diffusion tensor image: implemented in subclasses, for example
-  // to calculate the structure tensor and its eigenvectors and eigenvalues
-  this->UpdateDiffusionTensorImage();
+  // to calculate the structure tensor and its eigenvectors and eigenvalues.
+  // The tensors are reused while they are recent and the image changed little.
+  if( m_NumberOfTensorUpdates == 0
+    || m_IterationsSinceTensorUpdate >= m_TensorUpdateInterval
+    || m_ChangeSinceTensorUpdate > m_TensorUpdateChangeThreshold )
+    {
+    // The semi-implicit scheme releases the buffer once the tensors are
+    // packed
+    if( m_DiffusionTensorImage->GetBufferedRegion()
+      != this->GetOutput()->GetBufferedRegion() )
+      {
+      this->AllocateDiffusionTensorImage();
+      }
+    this->UpdateDiffusionTensorImage();
+    if( m_UseSemiImplicitScheme )
+      {
+      this->PackDiffusionTensorImage();
+      this->CheckSemiImplicitTimeStepStability();
+      }
+    ++m_NumberOfTensorUpdates;
+    m_IterationsSinceTensorUpdate = 0;
+    m_ChangeSinceTensorUpdate = 0;
+    }
 }
 
 template< class TInputImage, class TOutputImage >
@@ -160,6 +196,18 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   m_UpdateBuffer->SetRequestedRegion(output->GetRequestedRegion());
   m_UpdateBuffer->SetBufferedRegion(output->GetBufferedRegion());
   m_UpdateBuffer->Allocate();
+
+  if( m_UseSemiImplicitScheme )
+    {
+    m_SemiImplicitBuffer->SetSpacing(output->GetSpacing());
+    m_SemiImplicitBuffer->SetOrigin(output->GetOrigin());
+    m_SemiImplicitBuffer->SetDirection(output->GetDirection());
+    m_SemiImplicitBuffer->SetLargestPossibleRegion(
+      output->GetLargestPossibleRegion());
+    m_SemiImplicitBuffer->SetRequestedRegion(output->GetRequestedRegion());
+    m_SemiImplicitBuffer->SetBufferedRegion(output->GetBufferedRegion());
+    m_SemiImplicitBuffer->Allocate();
+    }
 }
 
 template< class TInputImage, class TOutputImage >
@@ -193,6 +241,7 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   DenseFDThreadStruct str;
   str.Filter = this;
   str.TimeStep = dt;
+  m_ThreadChangeList.assign( this->GetNumberOfThreads(), 0.0 );
   this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
   this->GetMultiThreader()->SetSingleMethod(this->ApplyUpdateThreaderCallback,
                                             &str);
@@ -321,7 +370,7 @@ void
 AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
 ::ThreadedApplyUpdate(TimeStepType dt, const ThreadRegionType &regionToProcess,
                       const ThreadDiffusionTensorImageRegionType &,
-                      ThreadIdType )
+                      ThreadIdType threadId )
 {
   ImageRegionIterator<UpdateBufferType> u(m_UpdateBuffer,    regionToProcess);
   ImageRegionIterator<OutputImageType>  o(this->GetOutput(), regionToProcess);
@@ -329,14 +378,19 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   u.GoToBegin();
   o.GoToBegin();
 
+  double changeSquared = 0;
   while( !u.IsAtEnd() )
     {
+    const PixelType change = static_cast<PixelType>(u.Value() * dt);
 
-    o.Value() += static_cast<PixelType>(u.Value() * dt);  // no adaptor support
+    o.Value() += change;  // no adaptor support
+    changeSquared += static_cast<double>( change ) * change;
 
     ++o;
     ++u;
     }
+
+  m_ThreadChangeList[threadId] = changeSquared;
 }
 
 template< class TInputImage, class TOutputImage >
@@ -487,14 +541,26 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   TimeStepType dt;
   unsigned int iter = 0;
 
+  m_NumberOfTensorUpdates = 0;
+
   while( !this->Halt() )
     {
     this->InitializeIteration(); // An optional method for precalculating
                                  // global values, or otherwise setting up
                                  // for the next iteration
-    dt = this->CalculateChange();
+    if( m_UseSemiImplicitScheme )
+      {
+      this->ApplySemiImplicitUpdate( m_TimeStep );
+      }
+    else
+      {
+      dt = this->CalculateChange();
 
-    this->ApplyUpdate(dt);
+      this->ApplyUpdate(dt);
+      }
+
+    this->AccumulateChangeSinceTensorUpdate();
+    ++m_IterationsSinceTensorUpdate;
 
     ++iter;
 
@@ -509,6 +575,453 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
       throw ProcessAborted(__FILE__,__LINE__);
       }
     }
+
+  // The packed tensors are computed again by the next update
+  std::vector< float >().swap( m_PackedDiffusionTensors );
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::AccumulateChangeSinceTensorUpdate( void )
+{
+  const SizeValueType numberOfPixels
+    = this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
+
+  double changeSquared = 0;
+  for( std::vector< double >::const_iterator it = m_ThreadChangeList.begin();
+    it != m_ThreadChangeList.end(); ++it )
+    {
+    changeSquared += *it;
+    }
+
+  if( numberOfPixels > 0 )
+    {
+    m_ChangeSinceTensorUpdate += std::sqrt( changeSquared / numberOfPixels );
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::PackDiffusionTensorImage( void )
+{
+  itkDebugMacro( << "PackDiffusionTensorImage() called." );
+
+  m_PackedDiffusionTensors.resize(
+    this->GetOutput()->GetBufferedRegion().GetNumberOfPixels()
+    * TensorPixelType::InternalDimension );
+
+  SemiImplicitThreadStruct str;
+  str.Filter = this;
+  str.Stage = PackStage;
+  str.TimeStep = NumericTraits<TimeStepType>::Zero;  // Not used
+  str.Axis = 0;
+  str.Spacing = this->GetSemiImplicitSpacing();
+  m_ThreadMixedWeightList.assign( this->GetNumberOfThreads(), 0.0 );
+  this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+  this->GetMultiThreader()->SetSingleMethod(
+    this->SemiImplicitThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  // Only the packed tensors are read until the next tensor update
+  m_DiffusionTensorImage->Initialize();
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::CheckSemiImplicitTimeStepStability( void )
+{
+  double mixedWeight = 0;
+  for( std::vector< double >::const_iterator it
+    = m_ThreadMixedWeightList.begin(); it != m_ThreadMixedWeightList.end();
+    ++it )
+    {
+    mixedWeight = std::max( mixedWeight, *it );
+    }
+
+  // The explicit mixed terms change a pixel by at most dt * mixedWeight / 2
+  // times the variation of its neighborhood; keep that below one half.
+  if( m_TimeStep * mixedWeight > 1.0 )
+    {
+    itkWarningMacro( << std::endl
+      << "Anisotropic diffusion unstable time step for the explicit mixed "
+      << "terms:" << m_TimeStep << std::endl << "Maximum stable time step "
+      << "for these diffusion tensors is " << 1.0 / mixedWeight );
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+FixedArray< double,
+  AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+    ::ImageDimension >
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::GetSemiImplicitSpacing( void )
+{
+  AnisotropicDiffusionTensorFunction<UpdateBufferType> *f =
+     dynamic_cast<AnisotropicDiffusionTensorFunction<UpdateBufferType> *>
+     (this->GetDifferenceFunction().GetPointer());
+
+  FixedArray< double, ImageDimension > spacing;
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    spacing[i] = ( f && !f->GetUseImageSpacing() ) ? 1.0
+      : this->GetOutput()->GetSpacing()[i];
+    }
+  return spacing;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::ApplySemiImplicitUpdate( const TimeStepType & dt )
+{
+  itkDebugMacro( << "ApplySemiImplicitUpdate Invoked with time step size: "
+    << dt );
+
+  // The scheme may have been switched on after the buffers were allocated
+  if( m_SemiImplicitBuffer->GetBufferedRegion()
+    != this->GetOutput()->GetBufferedRegion() )
+    {
+    this->AllocateUpdateBuffer();
+    }
+
+  // Set up for multithreaded processing.
+  SemiImplicitThreadStruct str;
+  str.Filter = this;
+  str.TimeStep = dt;
+  str.Axis = 0;
+  str.Spacing = this->GetSemiImplicitSpacing();
+  m_ThreadChangeList.assign( this->GetNumberOfThreads(), 0.0 );
+  this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+  this->GetMultiThreader()->SetSingleMethod(
+    this->SemiImplicitThreaderCallback, &str );
+
+  // The mixed derivative terms are explicit: r = u + dt * mixed( u )
+  str.Stage = ExplicitTermsStage;
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  // Additive operator splitting of the diagonal terms: the new image is the
+  // average over the axes of ( I - m dt A_axis )^-1 r
+  str.Stage = SolveStage;
+  for( unsigned int axis = 0; axis < ImageDimension; ++axis )
+    {
+    str.Axis = axis;
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+
+  str.Stage = ApplyStage;
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::SemiImplicitThreaderCallback( void * arg )
+{
+  SemiImplicitThreadStruct * str;
+  ThreadIdType threadId, threadCount;
+
+  threadId = ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  threadCount = ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  str = (SemiImplicitThreadStruct *)
+    (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  OutputImageType * output = str->Filter->GetOutput();
+  const typename OutputImageType::RegionType & region
+    = output->GetBufferedRegion();
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  if( str->Stage == SolveStage )
+    {
+    // Split the image lines along the axis
+    const SizeValueType numberOfLines = region.GetNumberOfPixels()
+      / region.GetSize( str->Axis );
+    const SizeValueType beginLine = numberOfLines * threadId / threadCount;
+    const SizeValueType endLine = numberOfLines * ( threadId + 1 )
+      / threadCount;
+    if( beginLine < endLine )
+      {
+      str->Filter->ThreadedSemiImplicitSolve( *str, beginLine, endLine );
+      }
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  // Split whole slices along the last axis
+  const SizeValueType numberOfSlices = region.GetSize( ImageDimension - 1 );
+  const OffsetValueType sliceStride
+    = output->GetOffsetTable()[ImageDimension - 1];
+  const OffsetValueType begin = sliceStride
+    * static_cast< OffsetValueType >( numberOfSlices * threadId
+      / threadCount );
+  const OffsetValueType end = sliceStride
+    * static_cast< OffsetValueType >( numberOfSlices * ( threadId + 1 )
+      / threadCount );
+  if( begin < end )
+    {
+    switch( str->Stage )
+      {
+      case PackStage:
+        str->Filter->ThreadedPackDiffusionTensors( *str, begin, end,
+          threadId );
+        break;
+      case ExplicitTermsStage:
+        str->Filter->ThreadedSemiImplicitExplicitTerms( *str, begin, end );
+        break;
+      case ApplyStage:
+        str->Filter->ThreadedSemiImplicitApply( begin, end, threadId );
+        break;
+      default:
+        break;
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::ThreadedPackDiffusionTensors( const SemiImplicitThreadStruct & str,
+  OffsetValueType begin, OffsetValueType end, ThreadIdType threadId )
+{
+  const unsigned int numberOfComponents = TensorPixelType::InternalDimension;
+
+  const TensorPixelType * tensors = m_DiffusionTensorImage->GetBufferPointer();
+  float * packed = &m_PackedDiffusionTensors[0];
+
+  double maxMixedWeight = 0;
+  for( OffsetValueType p = begin; p < end; ++p )
+    {
+    for( unsigned int c = 0; c < numberOfComponents; ++c )
+      {
+      packed[p * numberOfComponents + c] = static_cast< float >(
+        tensors[p][c] );
+      }
+
+    // sum over i != j of |D_ij| / ( h_i h_j ), from the upper triangle
+    double mixedWeight = 0;
+    unsigned int c = 0;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      for( unsigned int j = i; j < ImageDimension; ++j, ++c )
+        {
+        if( j != i )
+          {
+          mixedWeight += 2.0 * std::fabs( packed[p * numberOfComponents + c] )
+            / ( str.Spacing[i] * str.Spacing[j] );
+          }
+        }
+      }
+    maxMixedWeight = std::max( maxMixedWeight, mixedWeight );
+    }
+
+  m_ThreadMixedWeightList[threadId] = maxMixedWeight;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::ThreadedSemiImplicitExplicitTerms( const SemiImplicitThreadStruct & str,
+  OffsetValueType begin, OffsetValueType end )
+{
+  OutputImageType * output = this->GetOutput();
+  const typename OutputImageType::SizeType size
+    = output->GetBufferedRegion().GetSize();
+  const OffsetValueType * stride = output->GetOffsetTable();
+
+  const PixelType * u = output->GetBufferPointer();
+  PixelType * r = m_UpdateBuffer->GetBufferPointer();
+  const float * tensors = &m_PackedDiffusionTensors[0];
+
+  // Position of each tensor element in the packed upper triangle, and the
+  // weights of the central differences of the mixed derivatives
+  const unsigned int numberOfComponents = TensorPixelType::InternalDimension;
+  unsigned int component[ImageDimension][ImageDimension];
+  double weight[ImageDimension][ImageDimension];
+  unsigned int c = 0;
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    for( unsigned int j = i; j < ImageDimension; ++j )
+      {
+      component[i][j] = c;
+      component[j][i] = c;
+      ++c;
+      weight[i][j] = 1.0 / ( 4.0 * str.Spacing[i] * str.Spacing[j] );
+      weight[j][i] = weight[i][j];
+      }
+    }
+
+  OffsetValueType index[ImageDimension];
+  OffsetValueType remainder = begin;
+  for( int i = ImageDimension - 1; i >= 0; --i )
+    {
+    index[i] = remainder / stride[i];
+    remainder -= index[i] * stride[i];
+    }
+
+  // Neighbors outside the image are replaced by the pixel itself
+  // (zero flux boundary)
+  OffsetValueType forward[ImageDimension];
+  OffsetValueType backward[ImageDimension];
+  for( OffsetValueType p = begin; p < end; ++p )
+    {
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      forward[i] = ( index[i] + 1 < static_cast< OffsetValueType >( size[i] ) )
+        ? stride[i] : 0;
+      backward[i] = ( index[i] > 0 ) ? stride[i] : 0;
+      }
+
+    // sum over i != j of d/di( D_ij du/dj )
+    double mixed = 0;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      const OffsetValueType pf = p + forward[i];
+      const OffsetValueType pb = p - backward[i];
+      for( unsigned int j = 0; j < ImageDimension; ++j )
+        {
+        if( i != j )
+          {
+          c = component[i][j];
+          mixed += weight[i][j]
+            * ( tensors[pf * numberOfComponents + c]
+                * ( u[pf + forward[j]] - u[pf - backward[j]] )
+              - tensors[pb * numberOfComponents + c]
+                * ( u[pb + forward[j]] - u[pb - backward[j]] ) );
+          }
+        }
+      }
+    r[p] = static_cast< PixelType >( u[p] + str.TimeStep * mixed );
+
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      if( ++index[i] < static_cast< OffsetValueType >( size[i] ) )
+        {
+        break;
+        }
+      index[i] = 0;
+      }
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::ThreadedSemiImplicitSolve( const SemiImplicitThreadStruct & str,
+  SizeValueType beginLine, SizeValueType endLine )
+{
+  OutputImageType * output = this->GetOutput();
+  const typename OutputImageType::SizeType size
+    = output->GetBufferedRegion().GetSize();
+  const OffsetValueType * stride = output->GetOffsetTable();
+
+  const unsigned int axis = str.Axis;
+  const SizeValueType n = size[axis];
+  const OffsetValueType step = stride[axis];
+
+  const PixelType * r = m_UpdateBuffer->GetBufferPointer();
+  PixelType * sum = m_SemiImplicitBuffer->GetBufferPointer();
+  const float * tensors = &m_PackedDiffusionTensors[0];
+
+  const unsigned int numberOfComponents = TensorPixelType::InternalDimension;
+  unsigned int component = 0;
+  for( unsigned int i = 0; i < axis; ++i )
+    {
+    component += ImageDimension - i;
+    }
+
+  const double weight = 0.5 * ImageDimension * str.TimeStep
+    / ( str.Spacing[axis] * str.Spacing[axis] );
+  const double average = 1.0 / ImageDimension;
+
+  std::vector< double > diffusivity( n );
+  std::vector< double > upper( n );
+  std::vector< double > solution( n );
+
+  for( SizeValueType line = beginLine; line < endLine; ++line )
+    {
+    // Offset of the first pixel of the line
+    OffsetValueType start = 0;
+    SizeValueType remainder = line;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      if( i != axis )
+        {
+        start += static_cast< OffsetValueType >( remainder % size[i] )
+          * stride[i];
+        remainder /= size[i];
+        }
+      }
+
+    // m dt / h^2 times the diffusivity between pixels k and k+1
+    for( SizeValueType k = 0; k + 1 < n; ++k )
+      {
+      diffusivity[k] = weight
+        * ( tensors[( start + k * step ) * numberOfComponents + component]
+          + tensors[( start + ( k + 1 ) * step ) * numberOfComponents
+            + component] );
+      }
+
+    // Thomas algorithm for the tridiagonal system ( I - m dt A ) v = r
+    // with zero flux boundaries
+    for( SizeValueType k = 0; k < n; ++k )
+      {
+      const double previous = ( k > 0 ) ? diffusivity[k - 1] : 0;
+      const double next = ( k + 1 < n ) ? diffusivity[k] : 0;
+      double denominator = 1.0 + previous + next;
+      double rhs = r[start + k * step];
+      if( k > 0 )
+        {
+        denominator += previous * upper[k - 1];
+        rhs += previous * solution[k - 1];
+        }
+      upper[k] = -next / denominator;
+      solution[k] = rhs / denominator;
+      }
+    for( SizeValueType k = n - 1; k > 0; --k )
+      {
+      solution[k - 1] -= upper[k - 1] * solution[k];
+      }
+
+    for( SizeValueType k = 0; k < n; ++k )
+      {
+      const OffsetValueType p = start + k * step;
+      if( axis == 0 )
+        {
+        sum[p] = static_cast< PixelType >( average * solution[k] );
+        }
+      else
+        {
+        sum[p] += static_cast< PixelType >( average * solution[k] );
+        }
+      }
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
+::ThreadedSemiImplicitApply( OffsetValueType begin, OffsetValueType end,
+  ThreadIdType threadId )
+{
+  PixelType * u = this->GetOutput()->GetBufferPointer();
+  const PixelType * sum = m_SemiImplicitBuffer->GetBufferPointer();
+
+  double changeSquared = 0;
+  for( OffsetValueType p = begin; p < end; ++p )
+    {
+    const double change = static_cast< double >( sum[p] ) - u[p];
+    changeSquared += change * change;
+    u[p] = sum[p];
+    }
+
+  m_ThreadChangeList[threadId] = changeSquared;
 }
 
 template< class TInputImage, class TOutputImage >
@@ -528,6 +1041,14 @@ AnisotropicDiffusionTensorImageFilter<TInputImage, TOutputImage>
   Superclass::PrintSelf(os, indent);
 
   os << indent << "TimeStep: " << m_TimeStep  << std::endl;
+  os << indent << "UseSemiImplicitScheme: " << m_UseSemiImplicitScheme
+    << std::endl;
+  os << indent << "TensorUpdateInterval: " << m_TensorUpdateInterval
+    << std::endl;
+  os << indent << "TensorUpdateChangeThreshold: "
+    << m_TensorUpdateChangeThreshold << std::endl;
+  os << indent << "NumberOfTensorUpdates: " << m_NumberOfTensorUpdates
+    << std::endl;
 }
 
 } // End namespace tube
@@ -29,6 +29,8 @@
 #include "itkParametricImageSource.h"
 #include "itkSize.h"
 
+#include <list>
+
 namespace itk
 {
 
@@ -79,6 +81,15 @@ public:
     std::vector< typename TOutputImage::Pointer > & Dx,
     std::vector< typename TOutputImage::Pointer > & Dxx );
 
+  /** Maximum number of kernel spectra kept between updates.  Kernels are
+   *  reused whenever an input of the same size, spacing and direction is
+   *  convolved with the same orders and sigmas (e.g., equally sized tiles).
+   *  Zero, the default, disables the cache. */
+  itkSetMacro( MaximumNumberOfCachedKernels, unsigned int );
+  itkGetConstMacro( MaximumNumberOfCachedKernels, unsigned int );
+
+  void ClearKernelCache( void );
+
 protected:
   typedef ForwardFFTImageFilter< RealImageType >          FFTFilterType;
 
@@ -110,6 +121,22 @@ private:
   FFTGaussianDerivativeIFFTFilter( const Self & );
   void operator = ( const Self & );
 
+  struct KernelCacheEntry
+    {
+    typename InputImageType::SizeType        inputSize;
+    typename ComplexImageType::SizeType      fftSize;
+    typename ComplexImageType::OffsetType    fftOffset;
+    typename ComplexImageType::SpacingType   spacing;
+    typename ComplexImageType::DirectionType direction;
+    OrdersType                               orders;
+    SigmasType                               sigmas;
+    typename ComplexImageType::Pointer       kernelFFT;
+    };
+
+  typedef std::list< KernelCacheEntry >               KernelCacheType;
+
+  bool FindCachedKernel( KernelCacheEntry & entry ) const;
+
   typename ComplexImageType::Pointer                  m_InputImageFFT;
 
   typename ComplexImageType::Pointer                  m_KernelImageFFT;
@@ -123,6 +150,10 @@ private:
   SigmasType                                          m_Sigmas;
 
   const InputImageType *                              m_LastInputImage;
+  unsigned long                                       m_LastInputImageMTime;
+
+  unsigned int                                        m_MaximumNumberOfCachedKernels;
+  KernelCacheType                                     m_KernelCache;
 };
 
 
@@ -43,6 +43,9 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   this->m_Sigmas.Fill(0);
 
   this->m_LastInputImage = NULL;
+  this->m_LastInputImageMTime = 0;
+
+  this->m_MaximumNumberOfCachedKernels = 0;
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -63,6 +66,38 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   this->Modified();
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
+::ClearKernelCache( void )
+{
+  m_KernelCache.clear();
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
+::FindCachedKernel( KernelCacheEntry & entry ) const
+{
+  typename KernelCacheType::const_iterator iter = m_KernelCache.begin();
+  while( iter != m_KernelCache.end() )
+    {
+    if( iter->inputSize == entry.inputSize
+      && iter->fftSize == entry.fftSize
+      && iter->fftOffset == entry.fftOffset
+      && iter->spacing == entry.spacing
+      && iter->direction == entry.direction
+      && iter->orders == entry.orders
+      && iter->sigmas == entry.sigmas )
+      {
+      entry.kernelFFT = iter->kernelFFT;
+      return true;
+      }
+    ++iter;
+    }
+  return false;
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
@@ -110,6 +145,23 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   const typename ComplexImageType::DirectionType fftDirection =
     m_InputImageFFT->GetDirection();
 
+  KernelCacheEntry entry;
+  if( m_MaximumNumberOfCachedKernels > 0 )
+    {
+    entry.inputSize = inputSize;
+    entry.fftSize = fftSize;
+    entry.fftOffset = fftRegion.GetIndex() - inputRegion.GetIndex();
+    entry.spacing = fftSpacing;
+    entry.direction = fftDirection;
+    entry.orders = m_Orders;
+    entry.sigmas = m_Sigmas;
+    if( this->FindCachedKernel( entry ) )
+      {
+      m_KernelImageFFT = entry.kernelFFT;
+      return;
+      }
+    }
+
   gaussSource->SetIndex( fftRegion.GetIndex() );
   gaussSource->SetSize( fftSize );
   gaussSource->SetSpacing( fftSpacing );
@@ -140,6 +192,16 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   fftFilter->SetInput( fftShiftFilter->GetOutput() );
   fftFilter->Update();
   m_KernelImageFFT = fftFilter->GetOutput();
+
+  if( m_MaximumNumberOfCachedKernels > 0 )
+    {
+    entry.kernelFFT = m_KernelImageFFT;
+    m_KernelCache.push_back( entry );
+    while( m_KernelCache.size() > m_MaximumNumberOfCachedKernels )
+      {
+      m_KernelCache.pop_front();
+      }
+    }
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -186,9 +248,11 @@ void
 FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
 ::GenerateData()
 {
-  if( m_LastInputImage != this->GetInput() )
+  if( m_LastInputImage != this->GetInput()
+    || m_LastInputImageMTime != this->GetInput()->GetMTime() )
     {
     m_LastInputImage = this->GetInput();
+    m_LastInputImageMTime = this->GetInput()->GetMTime();
     ComputeInputImageFFT();
     }
 
@@ -206,9 +270,11 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   std::vector< typename TOutputImage::Pointer > & dX,
   std::vector< typename TOutputImage::Pointer > & dXX )
 {
-  if( m_LastInputImage != this->GetInput() )
+  if( m_LastInputImage != this->GetInput()
+    || m_LastInputImageMTime != this->GetInput()->GetMTime() )
     {
     m_LastInputImage = this->GetInput();
+    m_LastInputImageMTime = this->GetInput()->GetMTime();
     ComputeInputImageFFT();
     }
 
@@ -318,6 +384,9 @@ FFTGaussianDerivativeIFFTFilter<TInputImage, TOutputImage>
   os << indent << "Orders              : " << m_Orders << std::endl;
   os << indent << "Sigmas               : " << m_Sigmas << std::endl;
   os << indent << "Last Input Image    : " << m_LastInputImage << std::endl;
+  os << indent << "Max Cached Kernels  : " << m_MaximumNumberOfCachedKernels
+    << std::endl;
+  os << indent << "Cached Kernels      : " << m_KernelCache.size() << std::endl;
 }
 
 } // End namespace tube
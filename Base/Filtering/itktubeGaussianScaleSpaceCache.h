@@ -0,0 +1,163 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeGaussianScaleSpaceCache_h
+#define __itktubeGaussianScaleSpaceCache_h
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkSimpleFastMutexLock.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class GaussianScaleSpaceCache
+ * \brief Caches Gaussian blurrings of an image on a logarithmic grid of
+ * scales and interpolates between them.
+ *
+ * Scale k is MinimumSigma * 2^( k / NumberOfScalesPerOctave ).  A blurring
+ * at an arbitrary sigma is approximated by linearly interpolating the
+ * blurrings at the two cached scales that bracket it.  Scales are blurred
+ * the first time they are needed, so optimizers that evaluate a cost
+ * function many times at nearby sigmas blur the image only a few times.
+ *
+ * If NumberOfScalesPerOctave is 0, nothing is cached and every request
+ * blurs the image at exactly the requested sigma.
+ *
+ * At most MaximumNumberOfCachedScales blurrings are kept; the least
+ * recently used one is released to make room for a new one.
+ *
+ * The accessors are thread safe.  Scales are blurred outside of the lock,
+ * so threads needing different scales blur them concurrently.
+ */
+template< class TImage >
+class GaussianScaleSpaceCache : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef GaussianScaleSpaceCache         Self;
+  typedef Object                          Superclass;
+  typedef SmartPointer< Self >            Pointer;
+  typedef SmartPointer< const Self >      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( GaussianScaleSpaceCache, Object );
+
+  typedef TImage                          ImageType;
+  typedef typename ImageType::Pointer     ImagePointer;
+  typedef typename ImageType::PixelType   PixelType;
+
+  /** Set the image to be blurred.  Clears the cache. */
+  void SetInput( const ImageType * input );
+  const ImageType * GetInput( void ) const;
+
+  /** Smallest cached sigma, in physical units.  Smaller sigmas are
+   *  approximated by it.  Clears the cache. */
+  void SetMinimumSigma( double sigma );
+  itkGetConstMacro( MinimumSigma, double );
+
+  /** Number of cached scales per doubling of sigma.  Clears the cache. */
+  void SetNumberOfScalesPerOctave( unsigned int numberOfScales );
+  itkGetConstMacro( NumberOfScalesPerOctave, unsigned int );
+
+  /** Maximum number of cached blurrings; 0 does not limit it.  Lowering
+   *  it releases the least recently used blurrings.  Default is 32. */
+  void SetMaximumNumberOfCachedScales( unsigned int numberOfScales );
+  itkGetConstMacro( MaximumNumberOfCachedScales, unsigned int );
+
+  /** Number of blurrings currently cached. */
+  unsigned int GetNumberOfCachedScales( void ) const;
+
+  /** Releases the cached blurrings. */
+  void ClearCache( void );
+
+  /** Returns the blurrings at the two cached scales that bracket sigma and
+   *  the weight of the coarser one: the blurring at sigma is approximated
+   *  by ( 1 - coarseWeight ) * fineImage + coarseWeight * coarseImage. */
+  void GetBracketingImages( double sigma, ImagePointer & fineImage,
+    ImagePointer & coarseImage, double & coarseWeight ) const;
+
+  /** Returns the interpolated blurring at sigma as a new image. */
+  ImagePointer GetBlurredImage( double sigma ) const;
+
+  /** Sigma of the kth cached scale. */
+  double GetScaleSigma( unsigned int k ) const;
+
+protected:
+  GaussianScaleSpaceCache( void );
+  virtual ~GaussianScaleSpaceCache( void ) {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Blurs the input at sigma. */
+  ImagePointer Blur( double sigma ) const;
+
+  /** Returns the blurring at the kth cached scale, computing it if
+   *  needed. */
+  ImagePointer GetScaleImage( unsigned int k ) const;
+
+private:
+  // Purposely not implemented
+  GaussianScaleSpaceCache( const Self & );
+  void operator = ( const Self & );
+
+  /** A cached blurring and when it was last used */
+  struct ScaleImageType
+    {
+    ImagePointer      Image;
+    unsigned long     LastUse;
+    };
+
+  /** Releases least recently used blurrings until at most
+   *  MaximumNumberOfCachedScales remain.  The lock must be held. */
+  void ReleaseLeastRecentlyUsedScales( void ) const;
+
+  typename ImageType::ConstPointer      m_Input;
+
+  double                                m_MinimumSigma;
+  unsigned int                          m_NumberOfScalesPerOctave;
+  unsigned int                          m_MaximumNumberOfCachedScales;
+
+  mutable std::vector< ScaleImageType > m_ScaleImages;
+  mutable unsigned long                 m_ScaleImagesUseCount;
+  mutable SimpleFastMutexLock           m_ScaleImagesLock;
+
+}; // End class GaussianScaleSpaceCache
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeGaussianScaleSpaceCache.hxx"
+#endif
+
+#endif // End !defined(__itktubeGaussianScaleSpaceCache_h)
@@ -0,0 +1,351 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeGaussianScaleSpaceCache_hxx
+#define __itktubeGaussianScaleSpaceCache_hxx
+
+#include "itktubeGaussianScaleSpaceCache.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkSmoothingRecursiveGaussianImageFilter.h>
+
+#include <cmath>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< class TImage >
+GaussianScaleSpaceCache< TImage >
+::GaussianScaleSpaceCache( void )
+{
+  m_Input = NULL;
+  m_MinimumSigma = 0.5;
+  m_NumberOfScalesPerOctave = 8;
+  m_MaximumNumberOfCachedScales = 32;
+  m_ScaleImagesUseCount = 0;
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::SetInput( const ImageType * input )
+{
+  if( m_Input.GetPointer() != input )
+    {
+    m_Input = input;
+    this->ClearCache();
+    this->Modified();
+    }
+}
+
+template< class TImage >
+const typename GaussianScaleSpaceCache< TImage >::ImageType *
+GaussianScaleSpaceCache< TImage >
+::GetInput( void ) const
+{
+  return m_Input.GetPointer();
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::SetMinimumSigma( double sigma )
+{
+  if( sigma != m_MinimumSigma )
+    {
+    m_MinimumSigma = sigma;
+    this->ClearCache();
+    this->Modified();
+    }
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::SetNumberOfScalesPerOctave( unsigned int numberOfScales )
+{
+  if( numberOfScales != m_NumberOfScalesPerOctave )
+    {
+    m_NumberOfScalesPerOctave = numberOfScales;
+    this->ClearCache();
+    this->Modified();
+    }
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::SetMaximumNumberOfCachedScales( unsigned int numberOfScales )
+{
+  if( numberOfScales != m_MaximumNumberOfCachedScales )
+    {
+    m_ScaleImagesLock.Lock();
+    m_MaximumNumberOfCachedScales = numberOfScales;
+    this->ReleaseLeastRecentlyUsedScales();
+    m_ScaleImagesLock.Unlock();
+    this->Modified();
+    }
+}
+
+template< class TImage >
+unsigned int
+GaussianScaleSpaceCache< TImage >
+::GetNumberOfCachedScales( void ) const
+{
+  unsigned int numberOfScales = 0;
+  m_ScaleImagesLock.Lock();
+  for( unsigned int k = 0; k < m_ScaleImages.size(); ++k )
+    {
+    if( m_ScaleImages[k].Image.IsNotNull() )
+      {
+      ++numberOfScales;
+      }
+    }
+  m_ScaleImagesLock.Unlock();
+  return numberOfScales;
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::ClearCache( void )
+{
+  m_ScaleImagesLock.Lock();
+  m_ScaleImages.clear();
+  m_ScaleImagesLock.Unlock();
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::ReleaseLeastRecentlyUsedScales( void ) const
+{
+  if( m_MaximumNumberOfCachedScales == 0 )
+    {
+    return;
+    }
+  while( true )
+    {
+    unsigned int numberOfScales = 0;
+    unsigned int oldest = 0;
+    for( unsigned int k = 0; k < m_ScaleImages.size(); ++k )
+      {
+      if( m_ScaleImages[k].Image.IsNotNull() )
+        {
+        if( numberOfScales == 0
+          || m_ScaleImages[k].LastUse < m_ScaleImages[oldest].LastUse )
+          {
+          oldest = k;
+          }
+        ++numberOfScales;
+        }
+      }
+    if( numberOfScales <= m_MaximumNumberOfCachedScales )
+      {
+      return;
+      }
+    m_ScaleImages[oldest].Image = NULL;
+    }
+}
+
+template< class TImage >
+double
+GaussianScaleSpaceCache< TImage >
+::GetScaleSigma( unsigned int k ) const
+{
+  return m_MinimumSigma * std::pow( 2.0,
+    static_cast< double >( k ) / m_NumberOfScalesPerOctave );
+}
+
+template< class TImage >
+typename GaussianScaleSpaceCache< TImage >::ImagePointer
+GaussianScaleSpaceCache< TImage >
+::Blur( double sigma ) const
+{
+  if( m_Input.IsNull() )
+    {
+    itkExceptionMacro( << "Input image not set." );
+    }
+
+  typedef SmoothingRecursiveGaussianImageFilter< ImageType, ImageType >
+    BlurFilterType;
+  typename BlurFilterType::Pointer filter = BlurFilterType::New();
+  filter->SetInput( m_Input );
+  filter->SetSigma( sigma );
+  filter->Update();
+
+  ImagePointer image = filter->GetOutput();
+  image->DisconnectPipeline();
+  return image;
+}
+
+template< class TImage >
+typename GaussianScaleSpaceCache< TImage >::ImagePointer
+GaussianScaleSpaceCache< TImage >
+::GetScaleImage( unsigned int k ) const
+{
+  m_ScaleImagesLock.Lock();
+  if( k < m_ScaleImages.size() && m_ScaleImages[k].Image.IsNotNull() )
+    {
+    m_ScaleImages[k].LastUse = ++m_ScaleImagesUseCount;
+    ImagePointer image = m_ScaleImages[k].Image;
+    m_ScaleImagesLock.Unlock();
+    return image;
+    }
+  m_ScaleImagesLock.Unlock();
+
+  // Blur outside of the lock, so that other scales can be read and blurred
+  //   meanwhile.  If another thread cached this scale in the meantime, its
+  //   blurring is used and this one is dropped.
+  ImagePointer image = this->Blur( this->GetScaleSigma( k ) );
+
+  m_ScaleImagesLock.Lock();
+  if( k >= m_ScaleImages.size() )
+    {
+    ScaleImageType emptyScale;
+    emptyScale.LastUse = 0;
+    m_ScaleImages.resize( k + 1, emptyScale );
+    }
+  if( m_ScaleImages[k].Image.IsNull() )
+    {
+    m_ScaleImages[k].Image = image;
+    }
+  else
+    {
+    image = m_ScaleImages[k].Image;
+    }
+  m_ScaleImages[k].LastUse = ++m_ScaleImagesUseCount;
+  this->ReleaseLeastRecentlyUsedScales();
+  m_ScaleImagesLock.Unlock();
+
+  return image;
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::GetBracketingImages( double sigma, ImagePointer & fineImage,
+  ImagePointer & coarseImage, double & coarseWeight ) const
+{
+  if( m_NumberOfScalesPerOctave == 0 )
+    {
+    fineImage = this->Blur( sigma );
+    coarseImage = fineImage;
+    coarseWeight = 0;
+    return;
+    }
+
+  if( sigma <= m_MinimumSigma )
+    {
+    fineImage = this->GetScaleImage( 0 );
+    coarseImage = fineImage;
+    coarseWeight = 0;
+    return;
+    }
+
+  unsigned int k = static_cast< unsigned int >( std::floor(
+    std::log( sigma / m_MinimumSigma ) / std::log( 2.0 )
+    * m_NumberOfScalesPerOctave ) );
+  double fineSigma = this->GetScaleSigma( k );
+  double coarseSigma = this->GetScaleSigma( k + 1 );
+  coarseWeight = ( sigma - fineSigma ) / ( coarseSigma - fineSigma );
+  if( coarseWeight < 0 )
+    {
+    coarseWeight = 0;
+    }
+  else if( coarseWeight > 1 )
+    {
+    coarseWeight = 1;
+    }
+
+  fineImage = this->GetScaleImage( k );
+  if( coarseWeight > 0 )
+    {
+    coarseImage = this->GetScaleImage( k + 1 );
+    }
+  else
+    {
+    coarseImage = fineImage;
+    }
+}
+
+template< class TImage >
+typename GaussianScaleSpaceCache< TImage >::ImagePointer
+GaussianScaleSpaceCache< TImage >
+::GetBlurredImage( double sigma ) const
+{
+  ImagePointer fineImage;
+  ImagePointer coarseImage;
+  double coarseWeight;
+  this->GetBracketingImages( sigma, fineImage, coarseImage, coarseWeight );
+
+  ImagePointer image = ImageType::New();
+  image->CopyInformation( fineImage );
+  image->SetRegions( fineImage->GetLargestPossibleRegion() );
+  image->Allocate();
+
+  ImageRegionConstIterator< ImageType > iterFine( fineImage,
+    fineImage->GetLargestPossibleRegion() );
+  ImageRegionConstIterator< ImageType > iterCoarse( coarseImage,
+    coarseImage->GetLargestPossibleRegion() );
+  ImageRegionIterator< ImageType > iterOut( image,
+    image->GetLargestPossibleRegion() );
+  while( !iterOut.IsAtEnd() )
+    {
+    iterOut.Set( static_cast< PixelType >(
+      ( 1 - coarseWeight ) * iterFine.Get()
+      + coarseWeight * iterCoarse.Get() ) );
+    ++iterFine;
+    ++iterCoarse;
+    ++iterOut;
+    }
+
+  return image;
+}
+
+template< class TImage >
+void
+GaussianScaleSpaceCache< TImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Input: " << m_Input.GetPointer() << std::endl;
+  os << indent << "MinimumSigma: " << m_MinimumSigma << std::endl;
+  os << indent << "NumberOfScalesPerOctave: " << m_NumberOfScalesPerOctave
+    << std::endl;
+  os << indent << "MaximumNumberOfCachedScales: "
+    << m_MaximumNumberOfCachedScales << std::endl;
+  os << indent << "Number of cached scales: "
+    << this->GetNumberOfCachedScales() << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeGaussianScaleSpaceCache_hxx)
@@ -1,10 +1,37 @@
-#ifndef __itkGeneralizedDistanceTransformImageFilter_h
-#define __itkGeneralizedDistanceTransformImageFilter_h
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeGeneralizedDistanceTransformImageFilter_h
+#define __itktubeGeneralizedDistanceTransformImageFilter_h
 
 #include "itkImageToImageFilter.h"
 
 namespace itk
 {
+
+namespace tube
+{
+
 /** \class GeneralizedDistanceTransformImageFilter
 *
 * This filter computes a generalized variant of the distance transform with a
@@ -125,6 +152,12 @@ public:
   typedef typename FunctionImageType::IndexValueType IndexValueType;
   typedef typename LabelImageType::PixelType LabelPixelType;
   typedef typename DistanceImageType::PixelType DistancePixelType;
+  typedef typename DistanceImageType::SizeType SizeType;
+  typedef typename DistanceImageType::SizeValueType SizeValueType;
+
+  /** Extract dimension from the function image. */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+    FunctionImageType::ImageDimension);
 
   /** Set if a voronoi map should be created. */
   void SetCreateVoronoiMap(bool);
@@ -180,7 +213,10 @@ protected:
   /** Allocate and initialize output images. Used by GenerateData() */
   void PrepareData();
 
-  /** Compute distance transform and optionally the voronoi map as well. */
+  /** Compute distance transform and optionally the voronoi map as well.
+   *
+   * The scanlines along each dimension are independent of each other, so
+   * every dimension is processed by one multithreaded pass over them. */
   void GenerateData();
 
 
@@ -221,6 +257,31 @@ private:
    * abscissa ordinate. */
   typedef std::vector<Parabola> Parabolas;
 
+  /** Everything the threads need to know about the pass over one dimension.
+   * A unit of work is one scanline in dimension 0 and a strip of
+   * PixelsInCacheLine adjacent scanlines in the other dimensions. */
+  struct ThreadStruct
+  {
+    GeneralizedDistanceTransformImageFilter *Filter;
+    unsigned int Dimension;
+    DistancePixelType *Distance;
+    LabelPixelType *Labels;
+    SizeType Size;
+    SpacingType SquaredSpacing;
+    const std::vector< SpacingType > *DivisionTable;
+    SizeValueType MaxSize;
+    SizeValueType PixelsInCacheLine;
+    SizeValueType NumberOfUnits;
+  };
+
+  /** Split the units of work of a pass among the threads. */
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback(void *arg);
+
+  /** Transform the scanlines of the units [firstUnit, endUnit) of a pass.
+   * Different units never share a pixel, so the threads need no locking. */
+  void ProcessScanlines(const ThreadStruct &str,
+    SizeValueType firstUnit, SizeValueType endUnit);
+
   /** Compute the intersection abscissa of two parabolas p and q. Their apex
    * ordinates have to be different.
    *
@@ -302,11 +363,14 @@ private:
     const AbscissaIndexType &from, const long &steps,
     LabelPixelType *buffer);
 }; // end of GeneralizedDistanceTransformImageFilter class
-} //end namespace itk
+
+} // End namespace tube
+
+} // End namespace itk
 
 
 #ifndef ITK_MANUAL_INSTANTIATION
-#include "itkGeneralizedDistanceTransformImageFilter.txx"
+#include "itktubeGeneralizedDistanceTransformImageFilter.hxx"
 #endif
 
-#endif
+#endif // End !defined(__itktubeGeneralizedDistanceTransformImageFilter_h)
@@ -1,10 +1,32 @@
-#ifndef __itkGeneralizedDistanceTransformImageFilter_txx
-#define __itkGeneralizedDistanceTransformImageFilter_txx
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeGeneralizedDistanceTransformImageFilter_hxx
+#define __itktubeGeneralizedDistanceTransformImageFilter_hxx
 
 #include <limits>
 
-#include "itkGeneralizedDistanceTransformImageFilter.h"
-#include "itkImageLinearIteratorWithIndex.h"
+#include "itktubeGeneralizedDistanceTransformImageFilter.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
 
@@ -28,6 +50,10 @@ namespace
 namespace itk
 {
 
+namespace tube
+{
+
+
 template < class TFunctionImage,class TDistanceImage, class TLabelImage >
 void
 GeneralizedDistanceTransformImageFilter<
@@ -196,11 +222,9 @@ GeneralizedDistanceTransformImageFilter<
   FunctionImageConstPointer functionImage  =
     dynamic_cast<FunctionImageType *>(ProcessObject::GetInput(0));
 
-  std::cout << "spacing = " << functionImage->GetSpacing() << std::endl;
   DistanceImagePointer distance = this->GetDistance();
   distance->SetRegions( functionImage->GetLargestPossibleRegion() );
   distance->CopyInformation( functionImage );
-  std::cout << "spacing = " << distance->GetSpacing() << std::endl;
   distance->Allocate();
 
   ImageRegionConstIterator<FunctionImageType>
@@ -266,6 +290,10 @@ GeneralizedDistanceTransformImageFilter<
   typename DistanceImageType::SpacingType spacing = distance->GetSpacing();
   typename DistanceImageType::SizeType size =
     distance->GetRequestedRegion().GetSize();
+  const SizeValueType numberOfPixels =
+    distance->GetRequestedRegion().GetNumberOfPixels();
+  if (numberOfPixels == 0)
+    return;
 
   // The distance image has been initialized to contain the function values
   // f(x) at x = (x1 x2 ... xN).
@@ -274,145 +302,178 @@ GeneralizedDistanceTransformImageFilter<
   // Information on the region covered by a paraboloid is provided optionally
   // by copying the label at x.
   //
-  // The iterations visit each scanline in each dimension.
+  // Each pass over a dimension visits every scanline along that dimension
+  // once, and the scanlines are independent of each other.  The scanlines of
+  // a pass are therefore split among the threads, see ProcessScanlines().
   //
-  // To make better use of L1 cache, a few scanlines are read and written in
-  // parallel for dimensions 1 and upward. See below for details.
-  typedef itk::ImageLinearIteratorWithIndex<DistanceImageType> DIt;
-  DIt distanceIt(distance, distance->GetRequestedRegion());
-
-  typedef itk::ImageLinearIteratorWithIndex<LabelImageType> LIt;
-  LIt voronoiMapIt;
-  if (this->m_CreateVoronoiMap)
-  {
-    LabelImagePointer voronoiMap =
-      dynamic_cast<LabelImageType *>(this->ProcessObject::GetOutput(1));
-    voronoiMapIt = LIt(voronoiMap, voronoiMap->GetRequestedRegion());
-  }
-
   // Compute the maximal extent in number of pixels, rounded up to fill full
   // cache lines.
   // This is used to set up various vectors, buffers, and a division table
-  typedef typename DistanceImageType::SizeValueType DistSizeValueType;
-  DistSizeValueType maxSize = 0;
-  for (unsigned int d = 0; d < FunctionImageType::ImageDimension; ++d)
+  SizeValueType maxSize = 0;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
     maxSize = std::max(maxSize, size[d]);
-  maxSize = (DistSizeValueType)(
+  maxSize = (SizeValueType)(
     std::ceil((double)maxSize / CacheLineSize) * CacheLineSize);
 
+  // For dimensions 1 and up, a few scanlines that are adjacent in dimension
+  // 0 are processed together, so that each cache line that is read holds a
+  // pixel of every one of them.  The number of scanlines is the number of
+  // pixels that fit in a L1 cache line or a small multiple thereof.
+  const SizeValueType pixelsInCacheLine =
+    std::max((SizeValueType)1,
+             (SizeValueType)(CacheLineSize/
+             sizeof(typename DistanceImageType::PixelType)));
+
   // With the division table, we reduce the cost of the code that needs to
   // take image spacing into account.
-  // It will be initialized later, once for each dimension.
+  // It will be initialized once for each dimension, before the threads of
+  // that dimension start, and is only read by them.
   std::vector< SpacingType > divisionTable( maxSize, 0 );
 
-  // Loop over all dimensions and compute the generalized distance transform
-  // and voronoi map for each scanline.
+  ThreadStruct str;
+  str.Filter = this;
+  str.Distance = distance->GetBufferPointer();
+  str.Labels = this->m_CreateVoronoiMap ?
+    this->GetVoronoiMap()->GetBufferPointer() : 0;
+  str.Size = size;
+  str.DivisionTable = &divisionTable;
+  str.MaxSize = maxSize;
+  str.PixelsInCacheLine = pixelsInCacheLine;
+
+  // Dimension 0 is processed first.  The remaining dimensions are processed
+  // starting with the highest. This is due to the following observation:
   //
-  // Scanning lines along dimension 0 exhibit a good hit rate of L1 cache and no
-  // special care has to be taken to make use of this fact.
+  // The algorithm detects scanlines with all background pixels and can
+  // afterwards skip writing them back. On the other hand, when you have a
+  // single non-background pixel in an axial slice, after scanning and
+  // resampling along dimension 0 you will have a whole scanline of
+  // non-background pixels. After that, none of the scanlines on this slice in
+  // dimension 1 will stay empty.
   //
-  // We can work on multiple scanlines in parallel, however, thus making use of
-  // multiple processors.
-  { // dimension 0
-    const SpacingType sqrs = spacing[0]*spacing[0];
-    Parabolas envelope;
-    envelope.reserve(size[0]);
+  // The CT data sets that we have investigated almost never had a completely
+  // empty axial slice. They had a certain amount of empty coronary slices,
+  // however.
+  //
+  // This iteration order saves about 8% runtime on our test system, so we opted
+  // to investigate that direction first.
+  for (unsigned int pass = 0; pass < ImageDimension; ++pass)
+  {
+    const unsigned int d = (pass == 0) ? 0 : ImageDimension - pass;
 
-    // dimension 0, nice and easy
-    //
-    // To use openmp, we let distanceIt advance in direction 1 and parallelize
-    // the loop over each scanline along direction 1. See below for details.
-    distanceIt.SetDirection(1);
-    distanceIt.GoToBegin();
+    str.Dimension = d;
+    str.SquaredSpacing = spacing[d]*spacing[d];
+    if (this->m_UseImageSpacing)
+      updateDivisionTable(divisionTable, spacing[d], size[d]);
 
-    if (this->m_CreateVoronoiMap)
+    // A unit of work is a scanline in dimension 0, and a strip of
+    // pixelsInCacheLine scanlines in the other dimensions
+    if (d == 0)
+    {
+      str.NumberOfUnits = numberOfPixels / size[0];
+    }
+    else
     {
-      voronoiMapIt.SetDirection(1);
-      voronoiMapIt.GoToBegin();
+      const SizeValueType strips =
+        (size[0] + pixelsInCacheLine - 1) / pixelsInCacheLine;
+      str.NumberOfUnits = numberOfPixels / (size[0] * size[d]) * strips;
     }
 
-    if (this->m_UseImageSpacing)
-      updateDivisionTable(divisionTable, spacing[0], size[0]);
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+    this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+} // end GenerateData()
 
-    // Distance in pixels from one scanline to the next
-    const size_t stride = size[ 0 ];
+/**
+ *  Split the work units of a dimension among the threads
+ */
+template < class TFunctionImage,class TDistanceImage, class TLabelImage >
+ITK_THREAD_RETURN_TYPE
+GeneralizedDistanceTransformImageFilter<
+  TFunctionImage, TDistanceImage, TLabelImage >
+::ThreaderCallback(void * arg)
+{
+  const ThreadIdType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const ThreadIdType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  ThreadStruct * str = (ThreadStruct *)
+    (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  const SizeValueType firstUnit =
+    str->NumberOfUnits * threadId / threadCount;
+  const SizeValueType endUnit =
+    str->NumberOfUnits * (threadId + 1) / threadCount;
+  if (firstUnit < endUnit)
+    str->Filter->ProcessScanlines(*str, firstUnit, endUnit);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-    // Iterate over all scanlines. The outer while advances slices, the for-loop
-    // below iterates along direction 1 over each scanline in direction 0.
-    while (!distanceIt.IsAtEnd())
+/**
+ *  Compute the lower envelopes of the scanlines of some work units and
+ *  sample them back into the images
+ */
+template < class TFunctionImage,class TDistanceImage, class TLabelImage >
+void
+GeneralizedDistanceTransformImageFilter<
+  TFunctionImage, TDistanceImage, TLabelImage >
+::ProcessScanlines(const ThreadStruct & str,
+  SizeValueType firstUnit, SizeValueType endUnit)
+{
+  // The image buffers are accessed through raw pointers and offsets.
+  //
+  // \todo When ITK offers new methods to store images in memory, this code
+  // would need to be revisited, as it assumes row mayor layout and
+  // contiguous memory.
+  const unsigned int d = str.Dimension;
+  const SizeType & size = str.Size;
+  const SizeValueType lineLength = size[d];
+  const bool createVoronoiMap = this->m_CreateVoronoiMap;
+  const bool useImageSpacing = this->m_UseImageSpacing;
+  const LabelPixelType noLabel = LabelPixelType();
+
+  // Scanning lines along dimension 0 exhibit a good hit rate of L1 cache and
+  // no special care has to be taken to make use of this fact.
+  if (d == 0)
+  {
+    Parabolas envelope;
+    envelope.reserve(lineLength);
+    for (SizeValueType unit = firstUnit; unit < endUnit; ++unit)
     {
-      // Compute the generalized distance transform for the current scanline.
-      // We are using raw pointers to the data in order to simplify access with
-      // OpenMP.
-      //
-      // \todo When ITK offers new methods to store images in memory, this code
-      // would need to be revisited, as it assumes row mayor layout and
-      // contiguous memory.
-      DistancePixelType *rawDistance = &distanceIt.Value();
+      DistancePixelType *rawDistance = str.Distance + unit * lineLength;
       LabelPixelType *rawLabel =
-        this->m_CreateVoronoiMap ?  &voronoiMapIt.Value() : 0;
-      for (size_t i = 0; i < size[ 1 ]; ++i)
+        createVoronoiMap ? str.Labels + unit * lineLength : 0;
+
+      // First compute the lower envelope of parabolas
+      envelope.clear();
+      for (SizeValueType j = 0; j < lineLength; ++j)
       {
-        // Where does the scanline start in rawDistance?
-        size_t offset = i * stride;
-
-        // First compute the lower envelope of parabolas
-        envelope.clear();
-        if (this->m_UseImageSpacing)
-        {
-          for (size_t j = 0; j < size[0]; ++j, ++offset)
-          {
-            addParabola(
-              envelope, size[0],
-              j,
-              *(rawDistance + offset),
-              this->m_CreateVoronoiMap ?
-              *(rawLabel + offset) :
-              typename LabelImageType::PixelType(),
-              divisionTable);
-          }
-          offset -= size[0];
-        }
-        else
-        {
-          for (size_t j = 0; j < size[ 0 ]; ++j, ++offset)
-          {
-            addParabola(
-              envelope, size[0],
-              j,
-              *(rawDistance + offset),
-              this->m_CreateVoronoiMap ?
-              *(rawLabel + offset) :
-              typename LabelImageType::PixelType());
-          }
-          offset -= size[0];
-        }
-
-        // And now sample the lower envelope for the whole scanline
-        if (this->m_UseImageSpacing)
-          sampleValues(envelope, 0, size[0], rawDistance + offset, sqrs);
+        if (useImageSpacing)
+          addParabola(envelope, lineLength, j, rawDistance[j],
+            createVoronoiMap ? rawLabel[j] : noLabel, *str.DivisionTable);
         else
-          sampleValues(envelope, 0, size[0], rawDistance + offset);
-
-        if (this->m_CreateVoronoiMap)
-          sampleVoronoi(envelope, 0, size[0], rawLabel + offset);
+          addParabola(envelope, lineLength, j, rawDistance[j],
+            createVoronoiMap ? rawLabel[j] : noLabel);
       }
 
-      // Advance the iterators to the next slice
-      for (size_t i = 0; i < size[ 1 ]; ++i)
-      {
-        distanceIt.NextLine();
-        if (this->m_CreateVoronoiMap)
-          voronoiMapIt.NextLine();
-      }
+      // And now sample the lower envelope for the whole scanline
+      if (useImageSpacing)
+        sampleValues(envelope, 0, lineLength, rawDistance,
+          str.SquaredSpacing);
+      else
+        sampleValues(envelope, 0, lineLength, rawDistance);
+
+      if (createVoronoiMap)
+        sampleVoronoi(envelope, 0, lineLength, rawLabel);
     }
+    return;
   }
 
-
   // Dimensions 1 and up are interesting when it comes to L1 cache usage.
   //
-  // We will build several envelopes in parallel along direction d by reading a
-  // number of scanlines along direction 0 at once.
+  // We build several envelopes at once along direction d by reading a strip
+  // of scanlines that are adjacent in direction 0.
   //
   // For writing the result, we first sample all new scanlines into a cache
   // efficient buffer and then write that buffer into the output image, again in
@@ -422,242 +483,122 @@ GeneralizedDistanceTransformImageFilter<
   // be better optimized when it can be handled in one go. Therefore we can not
   // sample multiple envelopes at once without loosing a lot of runtime
   // performance.
+  //
+  // Each thread has its own envelopes and buffers.  In the buffers, the
+  // scanlines are maxSize elements apart.
+  const SizeValueType pixelsInCacheLine = str.PixelsInCacheLine;
+  const SizeValueType maxSize = str.MaxSize;
+  const SizeValueType strips =
+    (size[0] + pixelsInCacheLine - 1) / pixelsInCacheLine;
+
+  std::vector< Parabolas > envelope( pixelsInCacheLine );
+  for (SizeValueType line = 0; line < pixelsInCacheLine; ++line)
+    envelope[line].reserve( lineLength );
+  std::vector< DistancePixelType > valuesBuffer( pixelsInCacheLine*maxSize );
+  std::vector< LabelPixelType > voronoiBuffer;
+  if (createVoronoiMap)
+    voronoiBuffer.resize( pixelsInCacheLine*maxSize );
+  std::vector< bool > lineNeedsCopy( pixelsInCacheLine, false );
 
-  // The number of scanlines is the number of pixels that fit in a L1 cache
-  // line or a small multiple thereof. This way, we will use everything from L1
-  // cache (when the memory is properly aligned).
-  const DistSizeValueType pixelsInCacheLine =
-    std::max((DistSizeValueType)1,
-             (DistSizeValueType)(CacheLineSize/
-             sizeof(typename DistanceImageType::PixelType)));
+  // Distance in pixels from one pixel of a scanline in direction d to the
+  // next
+  SizeValueType stride = 1;
+  for (unsigned int k = 0; k < d; ++k)
+    stride *= size[k];
 
-  // We are using a buffer for each thread for intermediate output.
-  std::vector< DistancePixelType > valuesBuffer;
-  valuesBuffer.resize(pixelsInCacheLine*maxSize);
-  std::vector< LabelPixelType > voronoiBuffer;
-  if( this->m_UseImageSpacing )
+  for (SizeValueType unit = firstUnit; unit < endUnit; ++unit)
+  {
+    // Find the first pixel of the strip from its index in dimension 0 and
+    // its position in the dimensions other than 0 and d
+    SizeValueType stripStart = (unit % strips) * pixelsInCacheLine;
+    SizeValueType position = unit / strips;
+    SizeValueType dimensionStride = size[0];
+    for (unsigned int k = 1; k < ImageDimension; ++k)
     {
-    voronoiBuffer.resize(pixelsInCacheLine*maxSize);
+      if (k != d)
+      {
+        stripStart += (position % size[k]) * dimensionStride;
+        position /= size[k];
+      }
+      dimensionStride *= size[k];
     }
 
-  // We are looping over the remaining image dimensions starting with the
-  // highest. This is due to the following observation:
-  //
-  // The algorithm detects scanlines with all background pixels and can
-  // afterwards skip writing them back. On the other hand, when you have a
-  // single non-background pixel in an axial slice, after scanning and
-  // resampling along dimension 0 you will have a whole scanline of
-  // non-background pixels. After that, none of the scanlines on this slice in
-  // dimension 1 will stay empty.
-  //
-  // The CT data sets that we have investigated almost never had a completely
-  // empty axial slice. They had a certain amount of empty coronary slices,
-  // however.
-  //
-  // This iteration order saves about 8% runtime on our test system, so we opted
-  // to investigate that direction first.
-  for (int d = FunctionImageType::ImageDimension-1; d > 0; --d)
-  // Curious how it works for you the other way round? Then try this instead:
-  //for (int d = 1; d < FunctionImageType::ImageDimension; ++d)
-  {
-    // Set up spacing and division info
-    const SpacingType sqrs = spacing[d]*spacing[d];
-    if (this->m_UseImageSpacing)
-      updateDivisionTable(divisionTable, spacing[d], size[d]);
-    distanceIt.SetDirection(d);
-    distanceIt.GoToBegin();
+    // To avoid wrap-around effects at the end of a line, we also need to take
+    // the image size in dimension 0 into account.
+    const SizeValueType parallelLines = std::min(
+      pixelsInCacheLine,
+      size[0] - (unit % strips) * pixelsInCacheLine);
 
-    if (this->m_CreateVoronoiMap)
+    // Now compute the lower envelope of parabolas for each scanline
+    for (SizeValueType line = 0; line < parallelLines; ++line)
+      envelope[line].clear();
+    for (SizeValueType j = 0; j < lineLength; ++j)
     {
-      voronoiMapIt.SetDirection(d);
-      voronoiMapIt.GoToBegin();
+      // This is the inner loop where it matters to utilize L1 cache
+      const SizeValueType offset = stripStart + j * stride;
+      for (SizeValueType line = 0; line < parallelLines; ++line)
+      {
+        if (useImageSpacing)
+          addParabola(envelope[line], lineLength, j,
+            str.Distance[offset + line],
+            createVoronoiMap ? str.Labels[offset + line] : noLabel,
+            *str.DivisionTable);
+        else
+          addParabola(envelope[line], lineLength, j,
+            str.Distance[offset + line],
+            createVoronoiMap ? str.Labels[offset + line] : noLabel);
+      }
     }
 
-    std::vector< Parabolas > envelope( pixelsInCacheLine );
-    for (size_t i = 0; i < pixelsInCacheLine; ++i)
-      envelope[i].reserve( maxSize );
+    // And now evaluate the lower envelopes into the intermediate buffer.
+    //
+    // We can avoid to write empty lines into the output buffer because we
+    // already know that the output image has to be all background anyway.
+    // We only have to remember that a line is empty.
+    bool stripNeedsCopy = false;
+    for (SizeValueType line = 0; line < parallelLines; ++line)
+    {
+      if (useImageSpacing)
+        lineNeedsCopy[line] = sampleValues(envelope[line], 0, lineLength,
+          &valuesBuffer[line * maxSize], str.SquaredSpacing);
+      else
+        lineNeedsCopy[line] = sampleValues(envelope[line], 0, lineLength,
+          &valuesBuffer[line * maxSize]);
+      stripNeedsCopy = stripNeedsCopy || lineNeedsCopy[line];
+    }
+    if (!stripNeedsCopy)
+      continue;
 
-    // We call the group of scanlines that is sampled in parallel a strip. How
-    // many strips are there? This many:
-    const int strips =
-      static_cast< int >(std::ceil(double(size[0]) / pixelsInCacheLine));
+    // Now we write the buffer to the output image, for all scanlines in the
+    // strip at once.  The output is written sequentially, and after
+    // parallelLines reads, the cache line read first from the buffer can be
+    // reused again.
+    for (SizeValueType j = 0; j < lineLength; ++j)
+    {
+      const SizeValueType offset = stripStart + j * stride;
+      for (SizeValueType line = 0; line < parallelLines; ++line)
+        if (lineNeedsCopy[line])
+          str.Distance[offset + line] = valuesBuffer[line * maxSize + j];
+    }
 
-    // Compute stride from one scanline in direction d to the next
-    size_t stride = 1;
-    for (int i = 0; i < d; ++i)
-      stride *= size[i];
-    while (!distanceIt.IsAtEnd())
+    if (createVoronoiMap)
     {
-      // Inside the for loop, we are working with lean and mean pointers into
-      // the image buffer and offsets therein.
-      // This makes parallelization with openmp easier as we do not need to
-      // modify an iterator in the inner loop.
-      //
-      // \todo Again, this needs to be reinvestigated when other memory layouts
-      // are introduced into ITK
-      DistancePixelType *rawDistance = &distanceIt.Value();
-      LabelPixelType *rawLabel =
-        this->m_CreateVoronoiMap ?  &voronoiMapIt.Value() : 0;
-
-      // When you compile with openmp support, this loop can be handled in
-      // parallel. Each thread gets its own copy of envelope and output buffers
-      // to work on. All other data can be shared as it is not written to.
-      //
-      // The alternative implementation to make valuesBuffer and voronoiBuffer
-      // cover the whole slice and share the data for output has been discarded
-      // as it would create a prohibitively large intermediate image when used
-      // with large 2D-images.
-      //
-      // The static schedule seemed best for the task at hand. It has the least
-      // overhead to implement and as each strip takes approximately the same
-      // time to complete, it fits well.
-      //
-      // Each thread will handle a single strip and therefore have everything in
-      // L1 cache of its CPU.
-      for (int i = 0; i < strips; ++i)
-      {
-        const IndexValueType currentStripOffset = i * pixelsInCacheLine;
-
-        // We can work on at most linesInCache lines in parallel to be cache
-        // effective. To avoid wrap-around effects at the end of a line, we also
-        // need to take the image size in dimension 0 in account.
-        const DistSizeValueType parallelLines = std::min(
-          pixelsInCacheLine,
-          size[0] - i * pixelsInCacheLine);
-
-        // Now compute the lower envelope of parabolas for each scanline
-        for (size_t line = 0; line < parallelLines; ++line)
-          envelope[line].clear();
-
-        // Read a strip of parallelLines scanlines along direction d
-        for (size_t j = 0, offset = currentStripOffset;
-              j < size[d];
-              ++j, offset += stride - parallelLines)
-        {
-          if (this->m_UseImageSpacing)
-          {
-            // This is the inner loop where it matters to utilize L1 cache
-            for (size_t line = 0; line < parallelLines; ++line, ++offset)
-              addParabola(
-                envelope[line], size[d],
-                j,
-                *(rawDistance + offset),
-                this->m_CreateVoronoiMap ?
-                *(rawLabel + offset) :
-                typename LabelImageType::PixelType(),
-                divisionTable);
-          }
-          else
-          {
-            // No wait, this one! ;-)
-            for (size_t line = 0; line < parallelLines; ++line, ++offset)
-              addParabola(
-                envelope[line], size[d],
-                j,
-                *(rawDistance + offset),
-                this->m_CreateVoronoiMap ?
-                *(rawLabel + offset) :
-                typename LabelImageType::PixelType());
-          }
-        }
-
-        // And now evaluate the lower envelope
-        //
-        // We first sample into the intermediate buffer. Each envelope samples a
-        // whole line.  This allows for efficient loop unrolling in sampleValues
-        // by the compiler and effective use of L1 cache during the sampling.
-        //
-        // We can avoid to write empty lines into the output buffer because we
-        // already know that the output image has to be all background anyway.
-        // We only have to remember that a line is empty.
-        //
-        // There is also some possibility that we can avoid to write the whole
-        // strip.
-        //
-        // In the output buffers, the scanlines are maxSize elements apart.
-        bool stripNeedsCopy = true;
-        std::vector< bool > lineNeedsCopy( parallelLines, false );
-        if (m_UseImageSpacing)
-          for (size_t line = 0, offset = 0;
-                line < parallelLines;
-                ++line, offset += maxSize)
-          {
-            lineNeedsCopy[line] =
-              sampleValues(
-                envelope[line], 0, size[d], &valuesBuffer[offset], sqrs);
-            stripNeedsCopy &= lineNeedsCopy[line];
-          }
-        else
-          for (size_t line = 0, offset = 0;
-                line < parallelLines;
-                ++line, offset += maxSize)
-          {
-            lineNeedsCopy[line] =
-              sampleValues(
-                envelope[line], 0, size[d], &valuesBuffer[offset]);
-            stripNeedsCopy &= lineNeedsCopy[line];
-          }
-
-        // Now we write the buffer to the output image. This is done in parallel
-        // for all scanlines in the strip. Therefore, we utilize the cache lines
-        // that hold a few words of each scanline in valuesBuffer and a cache
-        // line for the output to rawDistance.
-        //
-        // With probably 1000 lines of L1 cache available and much less lines in
-        // a single strip, we utilize L1 cache quite well again.
-        if (!stripNeedsCopy) continue;
-        for (size_t j = 0,
-              outoffset = currentStripOffset;
-              j < size[d];
-              ++j, outoffset += stride - parallelLines)
-        {
-          for (size_t line = 0, inoffset = j;
-                line < parallelLines;
-                ++line,
-                inoffset += maxSize, // ...scanlines are maxSize elements apart
-                ++outoffset)
-          {
-            // outoffset advances by 1, so rawDistance is written sequentially.
-            // inoffset advances by a larger amount, but after parallelLines
-            // iterations, the cache line read first can be reused again.
-            if (lineNeedsCopy[line])
-              *(rawDistance + outoffset) =
-                valuesBuffer[inoffset];
-          }
-        }
-
-        if (this->m_CreateVoronoiMap)
-        {
-          // More of the same
-          for (size_t line = 0, offset = 0;
-                line < parallelLines;
-                ++line, offset += maxSize)
-            if (lineNeedsCopy[line])
-              sampleVoronoi(
-                envelope[line], 0, size[d], &voronoiBuffer[offset]);
-
-          for (size_t j = 0, outoffset = currentStripOffset;
-                j < size[d];
-                ++j, outoffset += stride - parallelLines)
-            for (size_t line = 0, inoffset = j;
-                  line < parallelLines;
-                  ++line, inoffset += maxSize, ++outoffset)
-              if (lineNeedsCopy[line])
-                *(rawLabel + outoffset) =
-                  voronoiBuffer[inoffset];
-        }
-      }
+      // More of the same
+      for (SizeValueType line = 0; line < parallelLines; ++line)
+        if (lineNeedsCopy[line])
+          sampleVoronoi(envelope[line], 0, lineLength,
+            &voronoiBuffer[line * maxSize]);
 
-      // Ok, all strips are done
-      for (size_t i = 0; i < size[0]; ++i)
+      for (SizeValueType j = 0; j < lineLength; ++j)
       {
-        distanceIt.NextLine();
-        if (this->m_CreateVoronoiMap)
-          voronoiMapIt.NextLine();
+        const SizeValueType offset = stripStart + j * stride;
+        for (SizeValueType line = 0; line < parallelLines; ++line)
+          if (lineNeedsCopy[line])
+            str.Labels[offset + line] = voronoiBuffer[line * maxSize + j];
       }
     }
   }
-} // end GenerateData()
+}
 
 template < class TFunctionImage, class TDistanceImage, class TLabelImage >
 typename GeneralizedDistanceTransformImageFilter<
@@ -1025,5 +966,9 @@ GeneralizedDistanceTransformImageFilter<
   }
   return true;
 }
-} // end namespace itk
-#endif
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeGeneralizedDistanceTransformImageFilter_hxx)
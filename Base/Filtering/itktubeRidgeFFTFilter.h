@@ -22,6 +22,8 @@
 
 #include "itkImageToImageFilter.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -57,6 +59,19 @@ public:
   itkSetMacro( UseIntensityOnly, bool );
   itkGetMacro( UseIntensityOnly, bool );
 
+  typedef typename OutputImageType::SizeType                SizeType;
+  typedef typename OutputImageType::RegionType              RegionType;
+
+  /** Process the input in blocks of this size (overlap-save).  Each block
+   *  is padded by a margin of TileMarginInSigmas * Scale, filtered, and
+   *  only its center is kept, so memory is bounded by the tile size
+   *  rather than the image size.  A zero size disables tiling. */
+  itkSetMacro( TileSize, SizeType );
+  itkGetConstReferenceMacro( TileSize, SizeType );
+
+  itkSetMacro( TileMarginInSigmas, double );
+  itkGetMacro( TileMarginInSigmas, double );
+
   itkGetConstReferenceMacro( Intensity, typename OutputImageType::Pointer );
   itkGetConstReferenceMacro( Ridgeness, typename OutputImageType::Pointer );
   itkGetConstReferenceMacro( Curvature, typename OutputImageType::Pointer );
@@ -69,6 +84,33 @@ protected:
 
   void GenerateData();
 
+  void GenerateTiledData();
+
+  /** Computes ridgeness, roundness, curvature and levelness from the N-jet
+   *  within inputRegion and writes them into outputRegion of the outputs.
+   *  The voxels are split among threads. */
+  void ComputeRidgeFeatures(
+    const std::vector< typename OutputImageType::Pointer > & dx,
+    const std::vector< typename OutputImageType::Pointer > & ddx,
+    const RegionType & inputRegion, const RegionType & outputRegion );
+
+  void ThreadedComputeRidgeFeatures(
+    const std::vector< typename OutputImageType::Pointer > & dx,
+    const std::vector< typename OutputImageType::Pointer > & ddx,
+    const RegionType & inputRegion, const RegionType & outputRegion );
+
+  struct ComputeRidgeFeaturesThreadStruct
+    {
+    Self *                                                   Filter;
+    const std::vector< typename OutputImageType::Pointer > * Dx;
+    const std::vector< typename OutputImageType::Pointer > * Ddx;
+    RegionType                                               InputRegion;
+    RegionType                                               OutputRegion;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ComputeRidgeFeaturesThreaderCallback(
+    void * arg );
+
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
 private:
@@ -89,6 +131,9 @@ private:
 
   double                                                m_Scale;
   bool                                                  m_UseIntensityOnly;
+
+  SizeType                                              m_TileSize;
+  double                                                m_TileMarginInSigmas;
 };
 
 
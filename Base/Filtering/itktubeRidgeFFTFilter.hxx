@@ -22,6 +22,13 @@
 
 #include "tubeMatrixMath.h"
 
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkRegionOfInterestImageFilter.h"
+
+#include <algorithm>
+#include <set>
+
 namespace itk {
 
 namespace tube {
@@ -39,6 +46,9 @@ RidgeFFTFilter< TInputImage >
   m_Scale = 1;
   m_UseIntensityOnly = false;
 
+  m_TileSize.Fill( 0 );
+  m_TileMarginInSigmas = 4;
+
   m_DerivativeFilter = DerivativeFilterType::New();
 }
 
@@ -50,6 +60,37 @@ RidgeFFTFilter< TInputImage >
 {
   std::cout << "Ridge FFT Filter: GenerateData" << std::endl;
 
+  const typename InputImageType::RegionType inputRegion =
+    this->GetInput()->GetLargestPossibleRegion();
+  bool useTiles = true;
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+    if( m_TileSize[i] == 0 )
+      {
+      useTiles = false;
+      break;
+      }
+    }
+  if( useTiles )
+    {
+    useTiles = false;
+    for( unsigned int i=0; i<ImageDimension; ++i )
+      {
+      if( m_TileSize[i] < inputRegion.GetSize()[i] )
+        {
+        useTiles = true;
+        break;
+        }
+      }
+    }
+  if( useTiles )
+    {
+    this->GenerateTiledData();
+    return;
+    }
+
+  // The derivative filter keeps the spectrum of its input, so successive
+  //   scales on the same input share a single forward FFT.
   m_DerivativeFilter->SetInput( this->GetInput() );
 
   typename DerivativeFilterType::OrdersType orders;
@@ -58,32 +99,37 @@ RidgeFFTFilter< TInputImage >
   sigmas.Fill( m_Scale );
   m_DerivativeFilter->SetSigmas( sigmas );
 
-  // Intensity
-  orders.Fill( 0 );
-  m_DerivativeFilter->SetOrders( orders );
-  m_DerivativeFilter->Update();
-  m_Intensity = m_DerivativeFilter->GetOutput();
-
-  if( !m_UseIntensityOnly )
+  if( m_UseIntensityOnly )
     {
+    orders.Fill( 0 );
+    m_DerivativeFilter->SetOrders( orders );
+    m_DerivativeFilter->Update();
+    m_Intensity = m_DerivativeFilter->GetOutput();
+    m_Intensity->DisconnectPipeline();
+    }
+  else
+    {
+    // The intensity is the zeroth-order term of the N-jet
+    const RegionType region = this->GetInput()->GetLargestPossibleRegion();
+
     m_Ridgeness = OutputImageType::New();
-    m_Ridgeness->CopyInformation( m_Intensity );
-    m_Ridgeness->SetRegions( m_Intensity->GetLargestPossibleRegion() );
+    m_Ridgeness->CopyInformation( this->GetInput() );
+    m_Ridgeness->SetRegions( region );
     m_Ridgeness->Allocate();
   
     m_Roundness = OutputImageType::New();
-    m_Roundness->CopyInformation( m_Intensity );
-    m_Roundness->SetRegions( m_Intensity->GetLargestPossibleRegion() );
+    m_Roundness->CopyInformation( this->GetInput() );
+    m_Roundness->SetRegions( region );
     m_Roundness->Allocate();
   
     m_Curvature = OutputImageType::New();
-    m_Curvature->CopyInformation( m_Intensity );
-    m_Curvature->SetRegions( m_Intensity->GetLargestPossibleRegion() );
+    m_Curvature->CopyInformation( this->GetInput() );
+    m_Curvature->SetRegions( region );
     m_Curvature->Allocate();
   
     m_Levelness = OutputImageType::New();
-    m_Levelness->CopyInformation( m_Intensity );
-    m_Levelness->SetRegions( m_Intensity->GetLargestPossibleRegion() );
+    m_Levelness->CopyInformation( this->GetInput() );
+    m_Levelness->SetRegions( region );
     m_Levelness->Allocate();
   
     std::vector< typename OutputImageType::Pointer > dx( ImageDimension );
@@ -97,70 +143,340 @@ RidgeFFTFilter< TInputImage >
   
     m_DerivativeFilter->GenerateNJet( m_Intensity, dx, ddx );
   
-    ImageRegionIterator< OutputImageType > iterRidge( m_Ridgeness, 
-      m_Ridgeness->GetLargestPossibleRegion() );
-    ImageRegionIterator< OutputImageType > iterRound( m_Roundness, 
-      m_Roundness->GetLargestPossibleRegion() );
-    ImageRegionIterator< OutputImageType > iterCurve( m_Curvature, 
-      m_Curvature->GetLargestPossibleRegion() );
-    ImageRegionIterator< OutputImageType > iterLevel( m_Levelness, 
-      m_Levelness->GetLargestPossibleRegion() );
-  
-    std::vector< ImageRegionIterator< OutputImageType > > iterDx( 
-      ImageDimension );
-  
-    std::vector< ImageRegionIterator< OutputImageType > > iterDdx( ddxSize );
-  
-    unsigned int count = 0;
+    this->ComputeRidgeFeatures( dx, ddx, region, region );
+    }
+
+  this->SetNthOutput( 0, m_Intensity );
+}
+
+template< typename TInputImage >
+void
+RidgeFFTFilter< TInputImage >
+::GenerateTiledData()
+{
+  std::cout << "Ridge FFT Filter: GenerateTiledData" << std::endl;
+
+  typename InputImageType::ConstPointer input = this->GetInput();
+  const RegionType inputRegion = input->GetLargestPossibleRegion();
+
+  m_Intensity = OutputImageType::New();
+  m_Intensity->CopyInformation( input );
+  m_Intensity->SetRegions( inputRegion );
+  m_Intensity->Allocate();
+
+  if( !m_UseIntensityOnly )
+    {
+    m_Ridgeness = OutputImageType::New();
+    m_Ridgeness->CopyInformation( input );
+    m_Ridgeness->SetRegions( inputRegion );
+    m_Ridgeness->Allocate();
+
+    m_Roundness = OutputImageType::New();
+    m_Roundness->CopyInformation( input );
+    m_Roundness->SetRegions( inputRegion );
+    m_Roundness->Allocate();
+
+    m_Curvature = OutputImageType::New();
+    m_Curvature->CopyInformation( input );
+    m_Curvature->SetRegions( inputRegion );
+    m_Curvature->Allocate();
+
+    m_Levelness = OutputImageType::New();
+    m_Levelness->CopyInformation( input );
+    m_Levelness->SetRegions( inputRegion );
+    m_Levelness->Allocate();
+    }
+
+  // Margin, in voxels, that makes the center of each tile independent of
+  //   the data outside of its padded block
+  typename InputImageType::SizeType margin;
+  typename InputImageType::SizeType numberOfTiles;
+  unsigned int totalNumberOfTiles = 1;
+  unsigned int numberOfBlockShapes = 1;
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+    margin[i] = static_cast< typename SizeType::SizeValueType >(
+      vcl_ceil( m_TileMarginInSigmas * m_Scale / input->GetSpacing()[i] ) );
+    numberOfTiles[i] = ( inputRegion.GetSize()[i] + m_TileSize[i] - 1 )
+      / m_TileSize[i];
+    totalNumberOfTiles *= numberOfTiles[i];
+
+    // Padded blocks are clipped at the lower and at the upper image
+    //   borders, and the last tile may be shorter, so an axis can have up
+    //   to three (or more, for wide margins) distinct block sizes.
+    const long regionSize = static_cast< long >( inputRegion.GetSize()[i] );
+    const long tileSize = static_cast< long >( m_TileSize[i] );
+    const long tileMargin = static_cast< long >( margin[i] );
+    std::set< long > blockSizes;
+    for( long tileNum=0; tileNum<static_cast< long >( numberOfTiles[i] );
+      ++tileNum )
+      {
+      const long tileStart = tileNum * tileSize;
+      const long tileEnd = std::min( tileStart + tileSize, regionSize );
+      blockSizes.insert( std::min( tileEnd + tileMargin, regionSize )
+        - std::max( tileStart - tileMargin, 0L ) );
+      }
+    numberOfBlockShapes *= blockSizes.size();
+    }
+
+  // Blocks of the same shape share kernel spectra: keep the kernels of
+  //   every shape so that no tile recomputes them.
+  const unsigned int numberOfKernelsPerBlock = m_UseIntensityOnly ? 1
+    : ImageDimension + 1;
+  if( m_DerivativeFilter->GetMaximumNumberOfCachedKernels()
+    < numberOfKernelsPerBlock * numberOfBlockShapes )
+    {
+    m_DerivativeFilter->SetMaximumNumberOfCachedKernels(
+      numberOfKernelsPerBlock * numberOfBlockShapes );
+    }
+
+  typename DerivativeFilterType::SigmasType sigmas;
+  sigmas.Fill( m_Scale );
+  m_DerivativeFilter->SetSigmas( sigmas );
+
+  typedef RegionOfInterestImageFilter< InputImageType, InputImageType >
+    ROIFilterType;
+
+  int ddxSize = 0;
+  for( unsigned int i=1; i<=ImageDimension; ++i )
+    {
+    ddxSize += i;
+    }
+
+  for( unsigned int t=0; t<totalNumberOfTiles; ++t )
+    {
+    RegionType tileRegion;
+    RegionType paddedRegion;
+    unsigned int tileCount = t;
     for( unsigned int i=0; i<ImageDimension; ++i )
       {
-      iterDx[i] = ImageRegionIterator< OutputImageType >( dx[i],
-        dx[i]->GetLargestPossibleRegion() );
-      for( unsigned int j=i; j<ImageDimension; ++j )
+      const long tileNum = static_cast< long >(
+        tileCount % numberOfTiles[i] );
+      tileCount /= numberOfTiles[i];
+
+      const long tileSize = static_cast< long >( m_TileSize[i] );
+      const long tileMargin = static_cast< long >( margin[i] );
+      const long tileStart = inputRegion.GetIndex()[i] + tileNum * tileSize;
+      const long regionEnd = inputRegion.GetIndex()[i]
+        + static_cast< long >( inputRegion.GetSize()[i] );
+      long tileEnd = tileStart + tileSize;
+      if( tileEnd > regionEnd )
         {
-        iterDdx[count] = ImageRegionIterator< OutputImageType >( ddx[count],
-          ddx[count]->GetLargestPossibleRegion() );
-        ++count;
+        tileEnd = regionEnd;
+        }
+      tileRegion.SetIndex( i, tileStart );
+      tileRegion.SetSize( i, tileEnd - tileStart );
+
+      long paddedStart = tileStart - tileMargin;
+      if( paddedStart < inputRegion.GetIndex()[i] )
+        {
+        paddedStart = inputRegion.GetIndex()[i];
         }
+      long paddedEnd = tileEnd + tileMargin;
+      if( paddedEnd > regionEnd )
+        {
+        paddedEnd = regionEnd;
+        }
+      paddedRegion.SetIndex( i, paddedStart );
+      paddedRegion.SetSize( i, paddedEnd - paddedStart );
       }
-  
-    double ridgeness = 0;
-    double roundness = 0;
-    double curvature = 0;
-    double levelness = 0;
-    vnl_matrix<double> H( ImageDimension, ImageDimension);
-    vnl_vector<double> D( ImageDimension );
-    vnl_matrix<double> HEVect( ImageDimension, ImageDimension);
-    vnl_vector<double> HEVal( ImageDimension );
-    while( !iterRidge.IsAtEnd() )
+
+    typename ROIFilterType::Pointer roiFilter = ROIFilterType::New();
+    roiFilter->SetInput( input );
+    roiFilter->SetRegionOfInterest( paddedRegion );
+    roiFilter->Update();
+
+    // The extracted block starts at index zero
+    RegionType blockRegion;
+    for( unsigned int i=0; i<ImageDimension; ++i )
+      {
+      blockRegion.SetIndex( i, tileRegion.GetIndex()[i]
+        - paddedRegion.GetIndex()[i] );
+      blockRegion.SetSize( i, tileRegion.GetSize()[i] );
+      }
+
+    m_DerivativeFilter->SetInput( roiFilter->GetOutput() );
+
+    typename OutputImageType::Pointer blockIntensity;
+    if( m_UseIntensityOnly )
+      {
+      typename DerivativeFilterType::OrdersType orders;
+      orders.Fill( 0 );
+      m_DerivativeFilter->SetOrders( orders );
+      m_DerivativeFilter->Update();
+      blockIntensity = m_DerivativeFilter->GetOutput();
+      }
+    else
+      {
+      std::vector< typename OutputImageType::Pointer > dx( ImageDimension );
+      std::vector< typename OutputImageType::Pointer > ddx( ddxSize );
+
+      m_DerivativeFilter->GenerateNJet( blockIntensity, dx, ddx );
+
+      this->ComputeRidgeFeatures( dx, ddx, blockRegion, tileRegion );
+      }
+
+    ImageRegionConstIterator< OutputImageType > iterBlock( blockIntensity,
+      blockRegion );
+    ImageRegionIterator< OutputImageType > iterInt( m_Intensity,
+      tileRegion );
+    while( !iterInt.IsAtEnd() )
       {
-      count = 0;
-      for( unsigned int i=0; i<ImageDimension; ++i )
+      iterInt.Set( iterBlock.Get() );
+      ++iterBlock;
+      ++iterInt;
+      }
+    }
+
+  // Release the last block and its spectrum before returning
+  m_DerivativeFilter->SetInput( NULL );
+
+  this->SetNthOutput( 0, m_Intensity );
+}
+
+template< typename TInputImage >
+void
+RidgeFFTFilter< TInputImage >
+::ComputeRidgeFeatures(
+  const std::vector< typename OutputImageType::Pointer > & dx,
+  const std::vector< typename OutputImageType::Pointer > & ddx,
+  const RegionType & inputRegion, const RegionType & outputRegion )
+{
+  ComputeRidgeFeaturesThreadStruct str;
+  str.Filter = this;
+  str.Dx = &dx;
+  str.Ddx = &ddx;
+  str.InputRegion = inputRegion;
+  str.OutputRegion = outputRegion;
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->ComputeRidgeFeaturesThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  m_Ridgeness->Modified();
+  m_Roundness->Modified();
+  m_Curvature->Modified();
+  m_Levelness->Modified();
+}
+
+template< typename TInputImage >
+ITK_THREAD_RETURN_TYPE
+RidgeFFTFilter< TInputImage >
+::ComputeRidgeFeaturesThreaderCallback( void * arg )
+{
+  const long threadId = ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const long threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  ComputeRidgeFeaturesThreadStruct * str =
+    (ComputeRidgeFeaturesThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  // Split along the slowest varying axis that has more than one voxel.
+  //   The input and output regions have the same size, so they are split
+  //   identically.
+  RegionType inputSplit = str->InputRegion;
+  RegionType outputSplit = str->OutputRegion;
+  int splitAxis = ImageDimension - 1;
+  while( splitAxis > 0 && outputSplit.GetSize()[splitAxis] == 1 )
+    {
+    --splitAxis;
+    }
+  const long range = outputSplit.GetSize()[splitAxis];
+  const long valuesPerThread = ( range + threadCount - 1 ) / threadCount;
+  const long start = threadId * valuesPerThread;
+  if( start < range )
+    {
+    long size = valuesPerThread;
+    if( start + size > range )
+      {
+      size = range - start;
+      }
+    inputSplit.SetIndex( splitAxis, inputSplit.GetIndex()[splitAxis]
+      + start );
+    inputSplit.SetSize( splitAxis, size );
+    outputSplit.SetIndex( splitAxis, outputSplit.GetIndex()[splitAxis]
+      + start );
+    outputSplit.SetSize( splitAxis, size );
+
+    str->Filter->ThreadedComputeRidgeFeatures( *(str->Dx), *(str->Ddx),
+      inputSplit, outputSplit );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage >
+void
+RidgeFFTFilter< TInputImage >
+::ThreadedComputeRidgeFeatures(
+  const std::vector< typename OutputImageType::Pointer > & dx,
+  const std::vector< typename OutputImageType::Pointer > & ddx,
+  const RegionType & inputRegion, const RegionType & outputRegion )
+{
+  ImageRegionIterator< OutputImageType > iterRidge( m_Ridgeness,
+    outputRegion );
+  ImageRegionIterator< OutputImageType > iterRound( m_Roundness,
+    outputRegion );
+  ImageRegionIterator< OutputImageType > iterCurve( m_Curvature,
+    outputRegion );
+  ImageRegionIterator< OutputImageType > iterLevel( m_Levelness,
+    outputRegion );
+
+  std::vector< ImageRegionConstIterator< OutputImageType > > iterDx(
+    ImageDimension );
+
+  std::vector< ImageRegionConstIterator< OutputImageType > > iterDdx(
+    ddx.size() );
+
+  unsigned int count = 0;
+  for( unsigned int i=0; i<ImageDimension; ++i )
+    {
+    iterDx[i] = ImageRegionConstIterator< OutputImageType >( dx[i],
+      inputRegion );
+    for( unsigned int j=i; j<ImageDimension; ++j )
+      {
+      iterDdx[count] = ImageRegionConstIterator< OutputImageType >(
+        ddx[count], inputRegion );
+      ++count;
+      }
+    }
+
+  double ridgeness = 0;
+  double roundness = 0;
+  double curvature = 0;
+  double levelness = 0;
+  vnl_matrix<double> H( ImageDimension, ImageDimension);
+  vnl_vector<double> D( ImageDimension );
+  vnl_matrix<double> HEVect( ImageDimension, ImageDimension);
+  vnl_vector<double> HEVal( ImageDimension );
+  while( !iterRidge.IsAtEnd() )
+    {
+    count = 0;
+    for( unsigned int i=0; i<ImageDimension; ++i )
+      {
+      D[i] = iterDx[i].Get();
+      ++iterDx[i];
+      for( unsigned int j=i; j<ImageDimension; ++j )
         {
-        D[i] = iterDx[i].Get();
-        ++iterDx[i];
-        for( unsigned int j=i; j<ImageDimension; ++j )
-          {
-          H[i][j] = iterDdx[count].Get();
-          H[j][i] = H[i][j];
-          ++iterDdx[count];
-          ++count;
-          }
+        H[i][j] = iterDdx[count].Get();
+        H[j][i] = H[i][j];
+        ++iterDdx[count];
+        ++count;
         }
-      ::tube::ComputeRidgeness( H, D, ridgeness, roundness, curvature, levelness,
-        HEVect, HEVal );
-      iterRidge.Set( ridgeness );
-      iterRound.Set( roundness );
-      iterCurve.Set( curvature );
-      iterLevel.Set( levelness );
-  
-      ++iterRidge;
-      ++iterRound;
-      ++iterCurve;
-      ++iterLevel;
       }
-  
-    this->SetNthOutput( 0, m_Intensity );
+    ::tube::ComputeRidgeness( H, D, ridgeness, roundness, curvature, levelness,
+      HEVect, HEVal );
+    iterRidge.Set( ridgeness );
+    iterRound.Set( roundness );
+    iterCurve.Set( curvature );
+    iterLevel.Set( levelness );
+
+    ++iterRidge;
+    ++iterRound;
+    ++iterCurve;
+    ++iterLevel;
     }
 }
 
@@ -218,6 +534,8 @@ RidgeFFTFilter< TInputImage >
 
   os << indent << "Scale             : " << m_Scale << std::endl;
   os << indent << "UseIntensityOnly  : " << m_UseIntensityOnly << std::endl;
+  os << indent << "TileSize          : " << m_TileSize << std::endl;
+  os << indent << "TileMarginInSigmas: " << m_TileMarginInSigmas << std::endl;
 }
 
 } // End namespace tube
@@ -0,0 +1,210 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeSparseSkeletonizationImageFilter_h
+#define __itktubeSparseSkeletonizationImageFilter_h
+
+#include <itkImageToImageFilter.h>
+#include <itkMultiThreader.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class SparseSkeletonizationImageFilter
+ *
+ * \brief Thins a binary object to a one voxel wide curve skeleton.
+ *
+ * Every non-zero input pixel is foreground.  Foreground voxels are removed
+ * in directional sub-iterations (one per face direction) as long as they
+ * are simple points and not curve end points, so that the topology of the
+ * object is preserved.  Simple points are recognized from the topological
+ * numbers of their 8 (2D) or 26 (3D) neighborhood, using a complete lookup
+ * table in 2D and precomputed neighbor adjacency masks in 3D.
+ *
+ * Instead of sweeping the whole image until convergence, only the voxels
+ * whose neighborhood has changed are kept in a queue and re-examined.  In
+ * each sub-iteration, the border voxels of the whole image are selected
+ * before any is removed.  They are then removed in two phases, first in
+ * the even slices along the last axis and then in the odd ones, each slice
+ * in scan order.  The image is split along its last axis into blocks of
+ * BlockSize slices that are thinned in parallel; since slices of the same
+ * parity are never neighbors, the result depends neither on the number of
+ * threads nor on the block size.
+ *
+ * Besides the skeleton image, the filter provides the list of skeleton
+ * points with their number of skeleton neighbors (1 at end points, 2
+ * along a branch, more at junctions), in image scan order.
+ *
+ * Only 2D and 3D images are supported.
+ */
+template< class TInputImage, class TOutputImage >
+class SparseSkeletonizationImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SparseSkeletonizationImageFilter                 Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >  Superclass;
+  typedef SmartPointer< Self >                             Pointer;
+  typedef SmartPointer< const Self >                       ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SparseSkeletonizationImageFilter, ImageToImageFilter );
+
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TInputImage::ImageDimension );
+
+  typedef TInputImage                           InputImageType;
+  typedef TOutputImage                          OutputImageType;
+  typedef typename InputImageType::PixelType    InputPixelType;
+  typedef typename OutputImageType::PixelType   OutputPixelType;
+  typedef typename OutputImageType::IndexType   IndexType;
+  typedef typename OutputImageType::SizeType    SizeType;
+  typedef typename OutputImageType::PointType   PointType;
+
+  /** A point of the skeleton. */
+  struct SkeletonPoint
+    {
+    IndexType    Index;
+    PointType    Position;
+    unsigned int NumberOfNeighbors;
+    };
+
+  typedef std::vector< SkeletonPoint >          SkeletonPointListType;
+
+  /** Set/Get the value given to skeleton pixels in the output.  Defaults
+   *  to 1. */
+  itkSetMacro( ForegroundValue, OutputPixelType );
+  itkGetConstMacro( ForegroundValue, OutputPixelType );
+
+  /** Set/Get the number of slices, along the last axis, in the blocks
+   *  thinned in parallel.  Defaults to 8. */
+  itkSetClampMacro( BlockSize, SizeValueType, 1,
+    NumericTraits< SizeValueType >::max() );
+  itkGetConstMacro( BlockSize, SizeValueType );
+
+  /** Get the number of thinning cycles run by the last update. */
+  itkGetConstMacro( NumberOfIterations, unsigned int );
+
+  /** Get the skeleton points found by the last update. */
+  const SkeletonPointListType & GetSkeletonPoints( void ) const
+    { return m_SkeletonPoints; }
+
+protected:
+  SparseSkeletonizationImageFilter( void );
+  virtual ~SparseSkeletonizationImageFilter( void ) {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  void GenerateInputRequestedRegion( void );
+  void EnlargeOutputRequestedRegion( DataObject * output );
+
+  void GenerateData( void );
+
+private:
+  SparseSkeletonizationImageFilter( const Self & ); // Purposely not implemented
+  void operator=( const Self & );                   // Purposely not implemented
+
+  itkStaticConstMacro( NumberOfNeighbors, unsigned int,
+    ImageDimension == 2 ? 8 : 26 );
+
+  /** Bits of the status buffer */
+  enum { Foreground = 1, Queued = 2, Touched = 4 };
+
+  enum PassType { ReadPass, BorderPass, CandidatePass, ThinPass,
+    WritePass };
+
+  typedef std::vector< OffsetValueType >        VoxelListType;
+
+  struct SkeletonThreadStruct
+    {
+    Self *                                Filter;
+    PassType                              Pass;
+    unsigned int                          Parity;
+    OffsetValueType                       FaceOffset;
+    unsigned char *                       Status;
+    std::vector< VoxelListType >          Active;
+    std::vector< VoxelListType >          Candidates;
+    std::vector< VoxelListType >          Changed;
+    std::vector< SizeValueType >          Deleted;
+    };
+
+  static ITK_THREAD_RETURN_TYPE SkeletonThreaderCallback( void * arg );
+
+  void ThreadedPass( SizeValueType block, SkeletonThreadStruct * str );
+
+  /** Compute the neighbor offsets and lookup tables for the current
+   *  image size. */
+  void InitializeNeighborhood( void );
+
+  /** Neighborhood configuration of a voxel of the status buffer */
+  unsigned int GetConfiguration( const unsigned char * status,
+    OffsetValueType voxel ) const;
+
+  bool IsSimple( unsigned int configuration ) const;
+
+  bool ComputeIsSimple( unsigned int configuration ) const;
+
+  unsigned int CountComponents( unsigned int set, unsigned int seeds,
+    const std::vector< unsigned int > & adjacency ) const;
+
+  static unsigned int CountBits( unsigned int configuration );
+
+  /** Block holding a voxel of the status buffer */
+  SizeValueType GetBlock( OffsetValueType voxel ) const;
+
+  OutputPixelType                 m_ForegroundValue;
+  SizeValueType                   m_BlockSize;
+  unsigned int                    m_NumberOfIterations;
+  SkeletonPointListType           m_SkeletonPoints;
+
+  SizeType                        m_Size;
+  SizeValueType                   m_NumberOfBlocks;
+  OffsetValueType                 m_PaddedStride[ImageDimension];
+  OffsetValueType                 m_ImageStride[ImageDimension];
+  std::vector< OffsetValueType >  m_NeighborOffsets;
+  std::vector< unsigned int >     m_ForegroundAdjacency;
+  std::vector< unsigned int >     m_BackgroundAdjacency;
+  unsigned int                    m_BackgroundNeighborhood;
+  unsigned int                    m_FaceNeighbors;
+  std::vector< bool >             m_SimpleTable;
+
+}; // End class SparseSkeletonizationImageFilter
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeSparseSkeletonizationImageFilter.hxx"
+#endif
+
+#endif // End !defined(__itktubeSparseSkeletonizationImageFilter_h)
@@ -0,0 +1,656 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeSparseSkeletonizationImageFilter_hxx
+#define __itktubeSparseSkeletonizationImageFilter_hxx
+
+#include "itktubeSparseSkeletonizationImageFilter.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< class TInputImage, class TOutputImage >
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::SparseSkeletonizationImageFilter( void )
+{
+  m_ForegroundValue = NumericTraits< OutputPixelType >::One;
+  m_BlockSize = 8;
+  m_NumberOfIterations = 0;
+
+  m_Size.Fill( 0 );
+  m_NumberOfBlocks = 0;
+  for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+    m_PaddedStride[k] = 0;
+    m_ImageStride[k] = 0;
+    }
+  m_BackgroundNeighborhood = 0;
+  m_FaceNeighbors = 0;
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >(
+    this->GetInput() );
+  if( input )
+    {
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion( DataObject * output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::GenerateData( void )
+{
+  if( ImageDimension != 2 && ImageDimension != 3 )
+    {
+    itkExceptionMacro( << "Only 2D and 3D images are supported." );
+    }
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
+
+  m_Size = output->GetBufferedRegion().GetSize();
+  if( input->GetBufferedRegion().GetSize() != m_Size )
+    {
+    itkExceptionMacro( << "The input buffer does not match the output." );
+    }
+
+  this->InitializeNeighborhood();
+  m_NumberOfBlocks = ( m_Size[ImageDimension - 1] + m_BlockSize - 1 )
+    / m_BlockSize;
+  m_NumberOfIterations = 0;
+  m_SkeletonPoints.clear();
+
+  // The status buffer is padded by one background voxel on every side, so
+  // that neighborhoods never need bound checks.
+  SizeValueType numberOfPaddedVoxels = 1;
+  for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+    numberOfPaddedVoxels *= m_Size[k] + 2;
+    }
+  std::vector< unsigned char > status( numberOfPaddedVoxels, 0 );
+
+  SkeletonThreadStruct str;
+  str.Filter = this;
+  str.Parity = 0;
+  str.FaceOffset = 0;
+  str.Status = &status[0];
+  str.Active.resize( m_NumberOfBlocks );
+  str.Candidates.resize( m_NumberOfBlocks );
+  str.Changed.resize( m_NumberOfBlocks );
+  str.Deleted.assign( m_NumberOfBlocks, 0 );
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->SkeletonThreaderCallback,
+    &str );
+
+  // Copy the object into the status buffer, then queue its border voxels
+  str.Pass = ReadPass;
+  this->GetMultiThreader()->SingleMethodExecute();
+  str.Pass = BorderPass;
+  this->GetMultiThreader()->SingleMethodExecute();
+  for( SizeValueType block = 0; block < m_NumberOfBlocks; ++block )
+    {
+    for( typename VoxelListType::const_iterator it =
+      str.Active[block].begin(); it != str.Active[block].end(); ++it )
+      {
+      status[*it] |= Queued;
+      }
+    }
+
+  SizeValueType deleted = 1;
+  while( deleted > 0 )
+    {
+    deleted = 0;
+    for( unsigned int k = 0; k < ImageDimension; ++k )
+      {
+      for( int sign = -1; sign <= 1; sign += 2 )
+        {
+        str.FaceOffset = sign * m_PaddedStride[k];
+
+        // Select the border voxels of every block before any is removed
+        str.Pass = CandidatePass;
+        this->GetMultiThreader()->SingleMethodExecute();
+
+        str.Pass = ThinPass;
+        for( str.Parity = 0; str.Parity < 2; ++str.Parity )
+          {
+          this->GetMultiThreader()->SingleMethodExecute();
+
+          // Queue the neighbors of the removed voxels, whichever block
+          // they belong to
+          for( SizeValueType block = 0; block < m_NumberOfBlocks; ++block )
+            {
+            deleted += str.Deleted[block];
+            str.Deleted[block] = 0;
+            for( typename VoxelListType::const_iterator it =
+              str.Changed[block].begin(); it != str.Changed[block].end();
+              ++it )
+              {
+              unsigned char & voxelStatus = status[*it];
+              if( voxelStatus & Foreground )
+                {
+                voxelStatus |= Touched;
+                if( !( voxelStatus & Queued ) )
+                  {
+                  voxelStatus |= Queued;
+                  str.Active[this->GetBlock( *it )].push_back( *it );
+                  }
+                }
+              }
+            str.Changed[block].clear();
+            }
+          }
+        }
+      }
+    ++m_NumberOfIterations;
+
+    // A voxel whose neighborhood did not change during the cycle has been
+    // rejected in every direction and cannot be removed anymore.
+    for( SizeValueType block = 0; block < m_NumberOfBlocks; ++block )
+      {
+      VoxelListType & active = str.Active[block];
+      typename VoxelListType::iterator last = active.begin();
+      for( typename VoxelListType::const_iterator it = active.begin();
+        it != active.end(); ++it )
+        {
+        unsigned char & voxelStatus = status[*it];
+        if( ( voxelStatus & Foreground ) && ( voxelStatus & Touched ) )
+          {
+          voxelStatus &= ~Touched;
+          *last = *it;
+          ++last;
+          }
+        else
+          {
+          voxelStatus &= ~Queued;
+          }
+        }
+      active.erase( last, active.end() );
+      }
+    }
+
+  // Write the skeleton, collecting its voxels block by block
+  for( SizeValueType block = 0; block < m_NumberOfBlocks; ++block )
+    {
+    str.Active[block].clear();
+    str.Candidates[block].clear();
+    }
+  str.Pass = WritePass;
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  const IndexType & start = output->GetBufferedRegion().GetIndex();
+  for( SizeValueType block = 0; block < m_NumberOfBlocks; ++block )
+    {
+    for( typename VoxelListType::const_iterator it =
+      str.Active[block].begin(); it != str.Active[block].end(); ++it )
+      {
+      SkeletonPoint point;
+      OffsetValueType offset = *it;
+      for( int k = ImageDimension - 1; k >= 0; --k )
+        {
+        const OffsetValueType coordinate = offset / m_PaddedStride[k];
+        offset -= coordinate * m_PaddedStride[k];
+        point.Index[k] = start[k] + coordinate - 1;
+        }
+      output->TransformIndexToPhysicalPoint( point.Index, point.Position );
+      point.NumberOfNeighbors = CountBits( this->GetConfiguration(
+        &status[0], *it ) );
+      m_SkeletonPoints.push_back( point );
+      }
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::SkeletonThreaderCallback( void * arg )
+{
+  ThreadIdType threadId =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->ThreadID;
+  ThreadIdType numberOfThreads =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->NumberOfThreads;
+  SkeletonThreadStruct * str = ( SkeletonThreadStruct * )
+    ( ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->UserData );
+
+  const SizeValueType numberOfBlocks = str->Filter->m_NumberOfBlocks;
+  for( SizeValueType block = threadId; block < numberOfBlocks;
+    block += numberOfThreads )
+    {
+    str->Filter->ThreadedPass( block, str );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::ThreadedPass( SizeValueType block, SkeletonThreadStruct * str )
+{
+  unsigned char * status = str->Status;
+
+  if( str->Pass == CandidatePass )
+    {
+    // Border voxels in the current direction are selected in all blocks
+    // before any is removed, so that the object is peeled by one layer at
+    // a time.  They are kept in scan order, whatever the queue order.
+    const OffsetValueType faceOffset = str->FaceOffset;
+    const VoxelListType & active = str->Active[block];
+    VoxelListType & candidates = str->Candidates[block];
+    candidates.clear();
+    for( typename VoxelListType::const_iterator it = active.begin();
+      it != active.end(); ++it )
+      {
+      if( ( status[*it] & Foreground )
+        && !( status[*it + faceOffset] & Foreground ) )
+        {
+        candidates.push_back( *it );
+        }
+      }
+    std::sort( candidates.begin(), candidates.end() );
+    return;
+    }
+
+  if( str->Pass == ThinPass )
+    {
+    // Only the slices of the current parity are thinned, so that the
+    // neighboring slices, possibly in other blocks, do not change.
+    const OffsetValueType sliceStride = m_PaddedStride[ImageDimension - 1];
+    const OffsetValueType parity = str->Parity;
+    const VoxelListType & candidates = str->Candidates[block];
+    VoxelListType & changed = str->Changed[block];
+    for( typename VoxelListType::const_iterator it = candidates.begin();
+      it != candidates.end(); ++it )
+      {
+      if( ( *it / sliceStride ) % 2 != parity )
+        {
+        continue;
+        }
+      const unsigned int configuration =
+        this->GetConfiguration( status, *it );
+      if( CountBits( configuration ) > 1 && this->IsSimple( configuration ) )
+        {
+        status[*it] &= ~Foreground;
+        ++str->Deleted[block];
+        for( unsigned int i = 0; i < NumberOfNeighbors; ++i )
+          {
+          const OffsetValueType neighbor = *it + m_NeighborOffsets[i];
+          if( status[neighbor] & Foreground )
+            {
+            changed.push_back( neighbor );
+            }
+          }
+        }
+      }
+    return;
+    }
+
+  const InputPixelType * inputBuffer = this->GetInput()->GetBufferPointer();
+  OutputPixelType * outputBuffer = this->GetOutput()->GetBufferPointer();
+  const InputPixelType inputZero = NumericTraits< InputPixelType >::Zero;
+  const OutputPixelType outputZero = NumericTraits< OutputPixelType >::Zero;
+
+  const SizeValueType endSlice = std::min( ( block + 1 ) * m_BlockSize,
+    static_cast< SizeValueType >( m_Size[ImageDimension - 1] ) );
+
+  // Image index of the current row, ignoring the first axis
+  SizeValueType row[ImageDimension];
+  for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+    row[k] = 0;
+    }
+  row[ImageDimension - 1] = block * m_BlockSize;
+
+  while( row[ImageDimension - 1] < endSlice )
+    {
+    OffsetValueType padded = 1;
+    OffsetValueType image = 0;
+    for( unsigned int k = 1; k < ImageDimension; ++k )
+      {
+      padded += ( row[k] + 1 ) * m_PaddedStride[k];
+      image += row[k] * m_ImageStride[k];
+      }
+
+    switch( str->Pass )
+      {
+      case ReadPass:
+        for( SizeValueType x = 0; x < m_Size[0]; ++x, ++padded, ++image )
+          {
+          status[padded] = ( inputBuffer[image] != inputZero ) ? Foreground
+            : 0;
+          }
+        break;
+      case BorderPass:
+        for( SizeValueType x = 0; x < m_Size[0]; ++x, ++padded )
+          {
+          if( status[padded] & Foreground )
+            {
+            for( unsigned int k = 0; k < ImageDimension; ++k )
+              {
+              if( !( status[padded - m_PaddedStride[k]] & Foreground )
+                || !( status[padded + m_PaddedStride[k]] & Foreground ) )
+                {
+                str->Active[block].push_back( padded );
+                break;
+                }
+              }
+            }
+          }
+        break;
+      case WritePass:
+        for( SizeValueType x = 0; x < m_Size[0]; ++x, ++padded, ++image )
+          {
+          if( status[padded] & Foreground )
+            {
+            outputBuffer[image] = m_ForegroundValue;
+            str->Active[block].push_back( padded );
+            }
+          else
+            {
+            outputBuffer[image] = outputZero;
+            }
+          }
+        break;
+      default:
+        break;
+      }
+
+    // Next row
+    unsigned int k = 1;
+    while( k < ImageDimension - 1 && ++row[k] == m_Size[k] )
+      {
+      row[k] = 0;
+      ++k;
+      }
+    if( k == ImageDimension - 1 )
+      {
+      ++row[k];
+      }
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::InitializeNeighborhood( void )
+{
+  OffsetValueType paddedStride = 1;
+  OffsetValueType imageStride = 1;
+  for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+    m_PaddedStride[k] = paddedStride;
+    m_ImageStride[k] = imageStride;
+    paddedStride *= m_Size[k] + 2;
+    imageStride *= m_Size[k];
+    }
+
+  // Neighbors are numbered in scan order, skipping the center voxel.
+  unsigned int numberOfPositions = 1;
+  for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+    numberOfPositions *= 3;
+    }
+
+  std::vector< std::vector< int > > coordinates;
+  m_NeighborOffsets.clear();
+  m_BackgroundNeighborhood = 0;
+  m_FaceNeighbors = 0;
+  for( unsigned int n = 0; n < numberOfPositions; ++n )
+    {
+    if( n == numberOfPositions / 2 )
+      {
+      continue;
+      }
+    std::vector< int > coordinate( ImageDimension );
+    unsigned int remainder = n;
+    OffsetValueType offset = 0;
+    int distance = 0;
+    for( unsigned int k = 0; k < ImageDimension; ++k )
+      {
+      coordinate[k] = static_cast< int >( remainder % 3 ) - 1;
+      remainder /= 3;
+      offset += coordinate[k] * m_PaddedStride[k];
+      distance += std::abs( coordinate[k] );
+      }
+
+    const unsigned int bit = 1u << m_NeighborOffsets.size();
+    if( distance == 1 )
+      {
+      m_FaceNeighbors |= bit;
+      }
+    if( distance <= 2 )
+      {
+      m_BackgroundNeighborhood |= bit;
+      }
+    m_NeighborOffsets.push_back( offset );
+    coordinates.push_back( coordinate );
+    }
+
+  // Foreground neighbors are connected through faces, edges and corners,
+  // background neighbors through faces only.
+  m_ForegroundAdjacency.assign( NumberOfNeighbors, 0 );
+  m_BackgroundAdjacency.assign( NumberOfNeighbors, 0 );
+  for( unsigned int i = 0; i < NumberOfNeighbors; ++i )
+    {
+    for( unsigned int j = 0; j < NumberOfNeighbors; ++j )
+      {
+      if( i == j )
+        {
+        continue;
+        }
+      int maximumDistance = 0;
+      int distance = 0;
+      for( unsigned int k = 0; k < ImageDimension; ++k )
+        {
+        const int d = std::abs( coordinates[i][k] - coordinates[j][k] );
+        maximumDistance = std::max( maximumDistance, d );
+        distance += d;
+        }
+      if( maximumDistance <= 1 )
+        {
+        m_ForegroundAdjacency[i] |= 1u << j;
+        }
+      if( distance == 1 )
+        {
+        m_BackgroundAdjacency[i] |= 1u << j;
+        }
+      }
+    }
+
+  // In 2D every configuration is tabulated; the 2^26 configurations of 3D
+  // are tested on the fly.
+  m_SimpleTable.clear();
+  if( NumberOfNeighbors <= 8 )
+    {
+    m_SimpleTable.resize( 1u << NumberOfNeighbors );
+    for( unsigned int configuration = 0;
+      configuration < m_SimpleTable.size(); ++configuration )
+      {
+      m_SimpleTable[configuration] = this->ComputeIsSimple( configuration );
+      }
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+unsigned int
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::GetConfiguration( const unsigned char * status,
+  OffsetValueType voxel ) const
+{
+  unsigned int configuration = 0;
+  for( unsigned int i = 0; i < NumberOfNeighbors; ++i )
+    {
+    if( status[voxel + m_NeighborOffsets[i]] & Foreground )
+      {
+      configuration |= 1u << i;
+      }
+    }
+  return configuration;
+}
+
+
+template< class TInputImage, class TOutputImage >
+bool
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::IsSimple( unsigned int configuration ) const
+{
+  if( !m_SimpleTable.empty() )
+    {
+    return m_SimpleTable[configuration];
+    }
+  return this->ComputeIsSimple( configuration );
+}
+
+
+template< class TInputImage, class TOutputImage >
+bool
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::ComputeIsSimple( unsigned int configuration ) const
+{
+  // A voxel is simple when its foreground neighbors form a single 8 (2D)
+  // or 26 (3D) connected component, and the background neighbors face
+  // connected to it form a single 4 (2D) or 6 (3D) connected component
+  // within the 8 (2D) or 18 (3D) neighborhood.
+  if( this->CountComponents( configuration, configuration,
+    m_ForegroundAdjacency ) != 1 )
+    {
+    return false;
+    }
+  const unsigned int background = ~configuration & m_BackgroundNeighborhood;
+  return this->CountComponents( background, m_FaceNeighbors,
+    m_BackgroundAdjacency ) == 1;
+}
+
+
+template< class TInputImage, class TOutputImage >
+unsigned int
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::CountComponents( unsigned int set, unsigned int seeds,
+  const std::vector< unsigned int > & adjacency ) const
+{
+  // Components are grown as bit masks; counting stops at two.
+  unsigned int count = 0;
+  unsigned int remaining = set;
+  while( ( remaining & seeds ) && count < 2 )
+    {
+    const unsigned int candidates = remaining & seeds;
+    unsigned int component = 0;
+    unsigned int grown = candidates & ( ~candidates + 1 );
+    while( grown != component )
+      {
+      component = grown;
+      for( unsigned int i = 0; i < NumberOfNeighbors; ++i )
+        {
+        if( component & ( 1u << i ) )
+          {
+          grown |= adjacency[i] & set;
+          }
+        }
+      }
+    remaining &= ~component;
+    ++count;
+    }
+  return count;
+}
+
+
+template< class TInputImage, class TOutputImage >
+unsigned int
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::CountBits( unsigned int configuration )
+{
+  unsigned int count = 0;
+  while( configuration )
+    {
+    configuration &= configuration - 1;
+    ++count;
+    }
+  return count;
+}
+
+
+template< class TInputImage, class TOutputImage >
+SizeValueType
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::GetBlock( OffsetValueType voxel ) const
+{
+  const SizeValueType slice = static_cast< SizeValueType >(
+    voxel / m_PaddedStride[ImageDimension - 1] - 1 );
+  return slice / m_BlockSize;
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+SparseSkeletonizationImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "ForegroundValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >(
+       m_ForegroundValue ) << std::endl;
+  os << indent << "BlockSize: " << m_BlockSize << std::endl;
+  os << indent << "NumberOfIterations: " << m_NumberOfIterations
+     << std::endl;
+  os << indent << "NumberOfSkeletonPoints: " << m_SkeletonPoints.size()
+     << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeSparseSkeletonizationImageFilter_hxx)
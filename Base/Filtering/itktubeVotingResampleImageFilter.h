@@ -0,0 +1,147 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeVotingResampleImageFilter_h
+#define __itktubeVotingResampleImageFilter_h
+
+#include "itktubeVotingResampleImageFunction.h"
+
+#include <itkImageToImageFilter.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class VotingResampleImageFilter
+ * \brief Resample a label image by a majority vote.
+ *
+ * Each output voxel takes the label chosen by
+ * VotingResampleImageFunction at its position, with the same result as a
+ * ResampleImageFilter using that function and an identity transform.
+ * Output voxels that map outside the input get DefaultPixelValue.
+ *
+ * The input and output grids must have the same direction, so the
+ * continuous index along each input axis only depends on the output index
+ * along that axis.  The clamped neighbor offsets are tabulated per axis
+ * before the threads start, and each vote is taken in a fixed-size array.
+ *
+ * \sa VotingResampleImageFunction
+ */
+template< class TInputImage, class TOutputImage = TInputImage >
+class VotingResampleImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef VotingResampleImageFilter                       Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VotingResampleImageFilter, ImageToImageFilter );
+
+  itkStaticConstMacro( ImageDimension, unsigned int,
+                       TOutputImage::ImageDimension );
+
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::PixelType      InputPixelType;
+  typedef TOutputImage                            OutputImageType;
+  typedef typename OutputImageType::PixelType     OutputPixelType;
+  typedef typename OutputImageType::RegionType    OutputImageRegionType;
+  typedef typename OutputImageType::SizeType      SizeType;
+  typedef typename OutputImageType::IndexType     IndexType;
+  typedef typename OutputImageType::PointType     PointType;
+  typedef typename OutputImageType::SpacingType   SpacingType;
+  typedef typename OutputImageType::DirectionType DirectionType;
+  typedef ImageBase< ImageDimension >             ImageBaseType;
+
+  typedef VotingResampleImageFunction< InputImageType, double >
+    FunctionType;
+
+  /** Set/Get the output image grid. */
+  itkSetMacro( Size, SizeType );
+  itkGetConstReferenceMacro( Size, SizeType );
+  itkSetMacro( OutputStartIndex, IndexType );
+  itkGetConstReferenceMacro( OutputStartIndex, IndexType );
+  itkSetMacro( OutputOrigin, PointType );
+  itkGetConstReferenceMacro( OutputOrigin, PointType );
+  itkSetMacro( OutputSpacing, SpacingType );
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  /** Copy the output grid from an image. */
+  void SetOutputParametersFromImage( const ImageBaseType * image );
+
+  /** Set/Get the value of output voxels that map outside the input. */
+  itkSetMacro( DefaultPixelValue, OutputPixelType );
+  itkGetConstReferenceMacro( DefaultPixelValue, OutputPixelType );
+
+protected:
+  VotingResampleImageFilter( void );
+  virtual ~VotingResampleImageFilter( void ) {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  virtual void GenerateOutputInformation( void );
+  virtual void GenerateInputRequestedRegion( void );
+
+  virtual void BeforeThreadedGenerateData( void );
+  virtual void ThreadedGenerateData( const OutputImageRegionType &
+    outputRegionForThread, ThreadIdType threadId );
+
+private:
+  VotingResampleImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  SizeType          m_Size;
+  IndexType         m_OutputStartIndex;
+  PointType         m_OutputOrigin;
+  SpacingType       m_OutputSpacing;
+  DirectionType     m_OutputDirection;
+  OutputPixelType   m_DefaultPixelValue;
+
+  /** Per axis, for each output index, the three neighbor buffer offsets
+   * and whether the position is inside the input. */
+  std::vector< OffsetValueType >  m_AxisOffsets[ImageDimension];
+  std::vector< unsigned char >    m_AxisInside[ImageDimension];
+
+}; // End class VotingResampleImageFilter
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeVotingResampleImageFilter.hxx"
+#endif
+
+#endif // End !defined(__itktubeVotingResampleImageFilter_h)
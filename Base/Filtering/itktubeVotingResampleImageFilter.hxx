@@ -0,0 +1,288 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeVotingResampleImageFilter_hxx
+#define __itktubeVotingResampleImageFilter_hxx
+
+#include "itktubeVotingResampleImageFilter.h"
+
+#include <itkImageScanlineIterator.h>
+#include <itkProgressReporter.h>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< class TInputImage, class TOutputImage >
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::VotingResampleImageFilter( void )
+{
+  m_Size.Fill( 0 );
+  m_OutputStartIndex.Fill( 0 );
+  m_OutputOrigin.Fill( 0.0 );
+  m_OutputSpacing.Fill( 1.0 );
+  m_OutputDirection.SetIdentity();
+  m_DefaultPixelValue = NumericTraits< OutputPixelType >::Zero;
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::SetOutputParametersFromImage( const ImageBaseType * image )
+{
+  this->SetOutputOrigin( image->GetOrigin() );
+  this->SetOutputSpacing( image->GetSpacing() );
+  this->SetOutputDirection( image->GetDirection() );
+  this->SetOutputStartIndex( image->GetLargestPossibleRegion().GetIndex() );
+  this->SetSize( image->GetLargestPossibleRegion().GetSize() );
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::GenerateOutputInformation( void )
+{
+  Superclass::GenerateOutputInformation();
+
+  OutputImageType * output = this->GetOutput();
+  if( !output )
+    {
+    return;
+    }
+
+  OutputImageRegionType outputLargestPossibleRegion;
+  outputLargestPossibleRegion.SetSize( m_Size );
+  outputLargestPossibleRegion.SetIndex( m_OutputStartIndex );
+  output->SetLargestPossibleRegion( outputLargestPossibleRegion );
+  output->SetSpacing( m_OutputSpacing );
+  output->SetOrigin( m_OutputOrigin );
+  output->SetDirection( m_OutputDirection );
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >(
+    this->GetInput() );
+  if( !input )
+    {
+    return;
+    }
+  input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  const InputImageType * input = this->GetInput();
+  const OutputImageType * output = this->GetOutput();
+
+  const typename InputImageType::DirectionType & inputDirection =
+    input->GetDirection();
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    for( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+      if( vnl_math_abs( inputDirection[i][j] - m_OutputDirection[i][j] )
+        > 1.0e-6 )
+        {
+        itkExceptionMacro( << "The input and output directions differ; "
+          << "use a ResampleImageFilter with a "
+          << "VotingResampleImageFunction instead." );
+        }
+      }
+    }
+
+  const typename InputImageType::RegionType bufferedRegion =
+    input->GetBufferedRegion();
+  const typename InputImageType::IndexType bufferedIndex =
+    bufferedRegion.GetIndex();
+  const typename InputImageType::SizeType bufferedSize =
+    bufferedRegion.GetSize();
+  const OffsetValueType * offsetTable = input->GetOffsetTable();
+
+  const OutputImageRegionType outputRegion =
+    output->GetLargestPossibleRegion();
+
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    const SizeValueType size = outputRegion.GetSize()[i];
+    m_AxisOffsets[i].resize( 3 * size );
+    m_AxisInside[i].resize( size );
+
+    const IndexValueType first = bufferedIndex[i];
+    const IndexValueType last = first
+      + static_cast< IndexValueType >( bufferedSize[i] ) - 1;
+
+    IndexType outputIndex = outputRegion.GetIndex();
+    for( SizeValueType j = 0; j < size; ++j )
+      {
+      outputIndex[i] = outputRegion.GetIndex()[i]
+        + static_cast< IndexValueType >( j );
+      PointType point;
+      output->TransformIndexToPhysicalPoint( outputIndex, point );
+      ContinuousIndex< double, ImageDimension > continuousIndex;
+      input->TransformPhysicalPointToContinuousIndex( point,
+        continuousIndex );
+
+      const double position = continuousIndex[i];
+      m_AxisInside[i][j] = ( position >= first - 0.5
+        && position < last + 0.5 ) ? 1 : 0;
+
+      const IndexValueType center = (int)position;
+      for( IndexValueType k = 0; k < 3; ++k )
+        {
+        IndexValueType value = center + k - 1;
+        if( value < first )
+          {
+          value = first;
+          }
+        else if( value > last )
+          {
+          value = last;
+          }
+        m_AxisOffsets[i][3 * j + k] = ( value - first ) * offsetTable[i];
+        }
+      }
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  const unsigned int NumberOfVotes = FunctionType::NumberOfVotes;
+  const unsigned int NumberOfRows = NumberOfVotes / 3;
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  const InputPixelType * inputBuffer = input->GetBufferPointer();
+  const IndexType outputStart = output->GetLargestPossibleRegion().GetIndex();
+
+  ProgressReporter progress( this, threadId,
+    outputRegionForThread.GetNumberOfPixels()
+    / outputRegionForThread.GetSize()[0] );
+
+  InputPixelType labels[NumberOfVotes];
+  OffsetValueType rowOffsets[NumberOfRows];
+
+  typedef ImageScanlineIterator< OutputImageType > IteratorType;
+  IteratorType outIt( output, outputRegionForThread );
+  outIt.GoToBegin();
+  while( !outIt.IsAtEnd() )
+    {
+    const IndexType lineIndex = outIt.GetIndex();
+
+    // The offsets of the neighbor rows along the higher axes are fixed
+    // for the scanline.
+    bool lineInside = true;
+    for( unsigned int i = 1; i < ImageDimension; ++i )
+      {
+      if( !m_AxisInside[i][lineIndex[i] - outputStart[i]] )
+        {
+        lineInside = false;
+        break;
+        }
+      }
+    if( lineInside )
+      {
+      for( unsigned int m = 0; m < NumberOfRows; ++m )
+        {
+        unsigned int digits = m;
+        OffsetValueType offset = 0;
+        for( unsigned int i = 1; i < ImageDimension; ++i )
+          {
+          offset += m_AxisOffsets[i][3 * ( lineIndex[i] - outputStart[i] )
+            + digits % 3];
+          digits /= 3;
+          }
+        rowOffsets[m] = offset;
+        }
+      }
+
+    SizeValueType j = lineIndex[0] - outputStart[0];
+    while( !outIt.IsAtEndOfLine() )
+      {
+      if( lineInside && m_AxisInside[0][j] )
+        {
+        const OffsetValueType * columnOffsets = &( m_AxisOffsets[0][3 * j] );
+        for( unsigned int m = 0; m < NumberOfRows; ++m )
+          {
+          const InputPixelType * row = inputBuffer + rowOffsets[m];
+          labels[3 * m] = row[columnOffsets[0]];
+          labels[3 * m + 1] = row[columnOffsets[1]];
+          labels[3 * m + 2] = row[columnOffsets[2]];
+          }
+        outIt.Set( static_cast< OutputPixelType >(
+          FunctionType::VoteOnLabels( labels, NumberOfVotes ) ) );
+        }
+      else
+        {
+        outIt.Set( m_DefaultPixelValue );
+        }
+      ++outIt;
+      ++j;
+      }
+    outIt.NextLine();
+    progress.CompletedPixel();
+    }
+}
+
+
+template< class TInputImage, class TOutputImage >
+void
+VotingResampleImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "OutputStartIndex: " << m_OutputStartIndex << std::endl;
+  os << indent << "OutputOrigin: " << m_OutputOrigin << std::endl;
+  os << indent << "OutputSpacing: " << m_OutputSpacing << std::endl;
+  os << indent << "OutputDirection: " << m_OutputDirection << std::endl;
+  os << indent << "DefaultPixelValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >(
+       m_DefaultPixelValue ) << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeVotingResampleImageFilter_hxx)
@@ -0,0 +1,398 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeImageQuantileCalculator.h"
+
+#include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+#include <itkImageIOFactory.h>
+#include <itkImageRegionIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Quantile of sorted values, interpolated between the two nearest ranks
+template< class TPixel >
+double BruteForceQuantile( const std::vector< TPixel > & sortedValues,
+  double quantile )
+{
+  const size_t lastRank = sortedValues.size() - 1;
+  const double h = quantile * lastRank;
+  const size_t lower = std::min( static_cast< size_t >( h ), lastRank );
+  const size_t upper = std::min( lower + 1, lastRank );
+  const double lowerValue = sortedValues[lower];
+  const double upperValue = sortedValues[upper];
+  return lowerValue + ( h - lower ) * ( upperValue - lowerValue );
+}
+
+template< class TImage >
+void SortImageValues( const TImage * image,
+  std::vector< typename TImage::PixelType > & values )
+{
+  itk::ImageRegionConstIterator< TImage > it( image,
+    image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    values.push_back( it.Get() );
+    }
+  std::sort( values.begin(), values.end() );
+}
+
+// Quantiles of an image, written one per line as by ComputeImageQuantiles
+int BruteForceImageQuantiles( const char * inputImage,
+  const char * outputText, const std::vector< double > & quantiles )
+{
+  typedef itk::Image< float, 3 >             ImageType;
+  typedef itk::ImageFileReader< ImageType >  ReaderType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( inputImage );
+  reader->Update();
+
+  std::vector< float > values;
+  SortImageValues< ImageType >( reader->GetOutput(), values );
+
+  std::ofstream quantileFile( outputText );
+  for( unsigned int i = 0; i < quantiles.size(); ++i )
+    {
+    quantileFile << static_cast< float >( BruteForceQuantile( values,
+      quantiles[i] ) ) << std::endl;
+    }
+  return EXIT_SUCCESS;
+}
+
+// Voxels at or above a quantile, labeled as by
+// SegmentUsingQuantileThreshold in the pixel type of the input
+template< class TPixel, unsigned int VDimension >
+int BruteForceQuantileThreshold( const char * inputImage,
+  const char * outputImage, double quantile )
+{
+  typedef itk::Image< TPixel, VDimension >   ImageType;
+  typedef itk::ImageFileReader< ImageType >  ReaderType;
+  typedef itk::ImageFileWriter< ImageType >  WriterType;
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( inputImage );
+  reader->Update();
+  typename ImageType::Pointer image = reader->GetOutput();
+
+  std::vector< TPixel > values;
+  SortImageValues< ImageType >( image, values );
+  const TPixel threshold = static_cast< TPixel >( BruteForceQuantile(
+    values, quantile ) );
+
+  itk::ImageRegionIterator< ImageType > it( image,
+    image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( it.Get() >= threshold ? 1 : 0 );
+    }
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( outputImage );
+  writer->SetInput( image );
+  writer->SetUseCompression( true );
+  writer->Update();
+  return EXIT_SUCCESS;
+}
+
+template< unsigned int VDimension >
+int BruteForceQuantileThreshold( itk::ImageIOBase::IOComponentType
+  componentType, const char * inputImage, const char * outputImage,
+  double quantile )
+{
+  switch( componentType )
+    {
+    case itk::ImageIOBase::UCHAR:
+      return BruteForceQuantileThreshold< unsigned char, VDimension >(
+        inputImage, outputImage, quantile );
+    case itk::ImageIOBase::CHAR:
+      return BruteForceQuantileThreshold< char, VDimension >(
+        inputImage, outputImage, quantile );
+    case itk::ImageIOBase::USHORT:
+      return BruteForceQuantileThreshold< unsigned short, VDimension >(
+        inputImage, outputImage, quantile );
+    case itk::ImageIOBase::SHORT:
+      return BruteForceQuantileThreshold< short, VDimension >(
+        inputImage, outputImage, quantile );
+    case itk::ImageIOBase::FLOAT:
+      return BruteForceQuantileThreshold< float, VDimension >(
+        inputImage, outputImage, quantile );
+    case itk::ImageIOBase::DOUBLE:
+      return BruteForceQuantileThreshold< double, VDimension >(
+        inputImage, outputImage, quantile );
+    default:
+      std::cerr << "Unsupported component type." << std::endl;
+      return EXIT_FAILURE;
+    }
+}
+
+// Reference outputs for the application tests, computed by sorting every
+// voxel of the input:
+//   quantiles inputImage outputText quantile [quantile ...]
+//   threshold inputImage outputImage quantile
+int BruteForceQuantileReference( int argc, char * argv[] )
+{
+  const std::string mode = argv[1];
+  std::vector< double > quantiles;
+  for( int i = 4; i < argc; ++i )
+    {
+    quantiles.push_back( std::atof( argv[i] ) );
+    }
+
+  try
+    {
+    if( mode == "quantiles" && !quantiles.empty() )
+      {
+      return BruteForceImageQuantiles( argv[2], argv[3], quantiles );
+      }
+    if( mode == "threshold" && quantiles.size() == 1 )
+      {
+      itk::ImageIOBase::Pointer imageIO =
+        itk::ImageIOFactory::CreateImageIO( argv[2],
+          itk::ImageIOFactory::ReadMode );
+      if( !imageIO )
+        {
+        std::cerr << "No ImageIO was found." << std::endl;
+        return EXIT_FAILURE;
+        }
+      imageIO->SetFileName( argv[2] );
+      imageIO->ReadImageInformation();
+      if( imageIO->GetNumberOfDimensions() == 2 )
+        {
+        return BruteForceQuantileThreshold< 2 >(
+          imageIO->GetComponentType(), argv[2], argv[3], quantiles[0] );
+        }
+      if( imageIO->GetNumberOfDimensions() == 3 )
+        {
+        return BruteForceQuantileThreshold< 3 >(
+          imageIO->GetComponentType(), argv[2], argv[3], quantiles[0] );
+        }
+      std::cerr << "Unsupported dimension." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cerr << "Exception caught: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cerr << "Usage: " << std::endl;
+  std::cerr << argv[0] << " [quantiles inputImage outputText quantile"
+    << " [quantile ...] | threshold inputImage outputImage quantile]"
+    << std::endl;
+  return EXIT_FAILURE;
+}
+
+int itktubeImageQuantileCalculatorTest( int argc, char * argv[] )
+{
+  if( argc > 1 )
+    {
+    return BruteForceQuantileReference( argc, argv );
+    }
+
+  enum { Dimension = 3 };
+
+  typedef itk::Image< float, Dimension >         ImageType;
+  typedef itk::Image< unsigned char, Dimension > MaskType;
+
+  typedef itk::tube::ImageQuantileCalculator< ImageType, MaskType >
+    CalculatorType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 29;
+  size[2] = 23;
+  region.SetSize( size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetRegions( region );
+  mask->Allocate();
+
+  // A large block of identical background values, as in a skull-stripped
+  // image, plus normally distributed foreground values
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::Pointer rndGen
+    = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  rndGen->Initialize( 1 );
+
+  std::vector< float > allValues;
+  std::vector< float > maskedValues;
+  itk::ImageRegionIterator< ImageType > imageIt( image, region );
+  itk::ImageRegionIterator< MaskType > maskIt( mask, region );
+  while( !imageIt.IsAtEnd() )
+    {
+    float value = 0;
+    if( rndGen->GetUniformVariate( 0, 1 ) > 0.4 )
+      {
+      value = static_cast< float >( rndGen->GetNormalVariate( 100, 400 ) );
+      }
+    imageIt.Set( value );
+    allValues.push_back( value );
+
+    unsigned char inside = ( rndGen->GetUniformVariate( 0, 1 ) > 0.5 );
+    maskIt.Set( inside );
+    if( inside )
+      {
+      maskedValues.push_back( value );
+      }
+    ++imageIt;
+    ++maskIt;
+    }
+  std::sort( allValues.begin(), allValues.end() );
+  std::sort( maskedValues.begin(), maskedValues.end() );
+
+  CalculatorType::QuantileListType quantiles;
+  quantiles.push_back( 0.0 );
+  quantiles.push_back( 0.01 );
+  quantiles.push_back( 0.25 );
+  quantiles.push_back( 0.5 );
+  quantiles.push_back( 0.5 );
+  quantiles.push_back( 0.9 );
+  quantiles.push_back( 0.999 );
+  quantiles.push_back( 1.0 );
+
+  int returnStatus = EXIT_SUCCESS;
+
+  // Few bins force several ranks into the same bin
+  const unsigned int numberOfBins[3] = { 1, 7, 65536 };
+  for( unsigned int b = 0; b < 3; ++b )
+    {
+    for( unsigned int useMask = 0; useMask < 2; ++useMask )
+      {
+      const std::vector< float > & values = useMask ? maskedValues
+        : allValues;
+
+      CalculatorType::Pointer calculator = CalculatorType::New();
+      calculator->SetImage( image );
+      if( useMask )
+        {
+        calculator->SetMask( mask );
+        }
+      calculator->SetNumberOfBins( numberOfBins[b] );
+      calculator->SetQuantiles( quantiles );
+      calculator->Compute();
+
+      if( calculator->GetNumberOfValues() != values.size() )
+        {
+        std::cerr << "Error: counted " << calculator->GetNumberOfValues()
+          << " values, expected " << values.size() << std::endl;
+        returnStatus = EXIT_FAILURE;
+        }
+
+      for( unsigned int i = 0; i < quantiles.size(); ++i )
+        {
+        const double h = quantiles[i] * ( values.size() - 1 );
+        const size_t lower = static_cast< size_t >( h );
+        const size_t upper = std::min( lower + 1, values.size() - 1 );
+        const double expected = values[lower] + ( h - lower )
+          * ( static_cast< double >( values[upper] ) - values[lower] );
+        const double computed = calculator->GetQuantileValues()[i];
+        if( vnl_math_abs( computed - expected ) > 1e-6 )
+          {
+          std::cerr << "Error: bins = " << numberOfBins[b]
+            << ", mask = " << useMask
+            << ", quantile " << quantiles[i] << " = " << computed
+            << ", expected " << expected << std::endl;
+          returnStatus = EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // Few distinct values make the bins single-valued, so the ranks are
+  // taken from the bin ranges without collecting any voxels
+  allValues.clear();
+  for( imageIt.GoToBegin(); !imageIt.IsAtEnd(); ++imageIt )
+    {
+    const float value = std::floor( imageIt.Get() / 50 );
+    imageIt.Set( value );
+    allValues.push_back( value );
+    }
+  std::sort( allValues.begin(), allValues.end() );
+  for( unsigned int b = 0; b < 3; ++b )
+    {
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetImage( image );
+    calculator->SetNumberOfBins( numberOfBins[b] );
+    calculator->SetQuantiles( quantiles );
+    calculator->Compute();
+    for( unsigned int i = 0; i < quantiles.size(); ++i )
+      {
+      const double h = quantiles[i] * ( allValues.size() - 1 );
+      const size_t lower = static_cast< size_t >( h );
+      const size_t upper = std::min( lower + 1, allValues.size() - 1 );
+      const double expected = allValues[lower] + ( h - lower )
+        * ( static_cast< double >( allValues[upper] ) - allValues[lower] );
+      const double computed = calculator->GetQuantileValues()[i];
+      if( vnl_math_abs( computed - expected ) > 1e-6 )
+        {
+        std::cerr << "Error: discrete image, bins = " << numberOfBins[b]
+          << ", quantile " << quantiles[i] << " = " << computed
+          << ", expected " << expected << std::endl;
+        returnStatus = EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Constant images have every quantile equal to the constant
+  image->FillBuffer( 3.5f );
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetImage( image );
+  calculator->SetQuantiles( quantiles );
+  calculator->Compute();
+  for( unsigned int i = 0; i < quantiles.size(); ++i )
+    {
+    if( calculator->GetQuantileValues()[i] != 3.5 )
+      {
+      std::cerr << "Error: constant image quantile " << quantiles[i]
+        << " = " << calculator->GetQuantileValues()[i] << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  // Out-of-range quantiles are rejected
+  quantiles.push_back( 1.5 );
+  calculator->SetQuantiles( quantiles );
+  try
+    {
+    calculator->Compute();
+    std::cerr << "Error: quantile 1.5 was accepted." << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+  catch( itk::ExceptionObject & )
+    {
+    }
+
+  return returnStatus;
+}
@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "itktubeImageRegionMomentsCalculator.h"
 
+#include <itkEllipseSpatialObject.h>
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
 
@@ -84,6 +85,88 @@ int itktubeImageRegionMomentsCalculatorTest( int argc, char * argv[] )
     {
     return EXIT_FAILURE;
     }
+
+  // The moments of an unchanged image are remembered
+  FilterType::Pointer cachedFilter = FilterType::New();
+  cachedFilter->SetImage( inputImage );
+  cachedFilter->Compute();
+  if( !cachedFilter->GetMomentsFromCache()
+    || cachedFilter->GetTotalMass() != filter->GetTotalMass()
+    || cachedFilter->GetCentralMoments() != filter->GetCentralMoments() )
+    {
+    std::cerr << "Moments of an unchanged image were not reused."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A single thread gives the same moments as several threads
+  FilterType::ClearMomentsCache();
+  FilterType::Pointer serialFilter = FilterType::New();
+  serialFilter->SetNumberOfThreads( 1 );
+  serialFilter->SetImage( inputImage );
+  serialFilter->Compute();
+  if( serialFilter->GetMomentsFromCache()
+    || serialFilter->GetTotalMass() != filter->GetTotalMass() )
+    {
+    std::cerr << "Single threaded mass differs." << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( unsigned int i = 0; i < Dimension; ++i )
+    {
+    if( vnl_math_abs( serialFilter->GetCenterOfGravity()[i]
+        - filter->GetCenterOfGravity()[i] ) > 1e-9 )
+      {
+      std::cerr << "Single threaded center of gravity differs."
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    for( unsigned int j = 0; j < Dimension; ++j )
+      {
+      if( vnl_math_abs( serialFilter->GetCentralMoments()[i][j]
+          - filter->GetCentralMoments()[i][j] ) > 1e-6 )
+        {
+        std::cerr << "Single threaded central moments differ."
+          << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // A modified image is computed again
+  inputImage->Modified();
+  cachedFilter->Compute();
+  if( cachedFilter->GetMomentsFromCache() )
+    {
+    std::cerr << "Moments of a modified image were reused." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Moving a mask only modifies its transform, but the moments are
+  // computed again
+  typedef itk::EllipseSpatialObject< Dimension > MaskType;
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetRadius( 20 );
+  MaskType::TransformType::OffsetType maskOffset;
+  maskOffset.Fill( 60 );
+  mask->GetObjectToParentTransform()->SetOffset( maskOffset );
+  mask->ComputeObjectToWorldTransform();
+  FilterType::Pointer maskedFilter = FilterType::New();
+  maskedFilter->SetImage( inputImage );
+  maskedFilter->SetSpatialObjectMask( mask.GetPointer() );
+  maskedFilter->Compute();
+  const double maskedMass = maskedFilter->GetTotalMass();
+  maskOffset.Fill( 80 );
+  mask->GetObjectToParentTransform()->SetOffset( maskOffset );
+  mask->ComputeObjectToWorldTransform();
+  maskedFilter->Compute();
+  if( maskedFilter->GetMomentsFromCache() )
+    {
+    std::cerr << "Moments within a moved mask were reused." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Masked mass = " << maskedMass << " then "
+    << maskedFilter->GetTotalMass() << std::endl;
+
   std::cout << "Second = " << filter->GetSecondMoments() << std::endl;
   std::cout << "CoG = " << filter->GetCenterOfGravity() << std::endl;
   std::cout << "Moments = " << filter->GetCentralMoments() << std::endl;
@@ -142,5 +142,40 @@ int itktubeRidgeBasisFeatureVectorGeneratorTest( int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  // Projecting onto only the leading basis vectors gives the same values
+  //   as the individual basis images
+  const unsigned int numberOfLeadingFeatures = 2;
+  BasisFilterType::FeatureVectorImageType::Pointer featureVectorImage =
+    basisFilter->GetFeatureVectorImage( numberOfLeadingFeatures );
+  if( featureVectorImage->GetNumberOfComponentsPerPixel()
+    != numberOfLeadingFeatures )
+    {
+    std::cerr << "Feature vector image has the wrong number of components."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+  const BasisFilterType::FeatureValueType * featureBuffer =
+    featureVectorImage->GetBufferPointer();
+  const itk::SizeValueType numberOfVoxels =
+    inputImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  for( unsigned int f = 0; f < numberOfLeadingFeatures; f++ )
+    {
+    BasisFilterType::FeatureImageType::Pointer featureImage =
+      basisFilter->GetFeatureImage( f );
+    const BasisFilterType::FeatureValueType * featureImageBuffer =
+      featureImage->GetBufferPointer();
+    for( itk::SizeValueType v = 0; v < numberOfVoxels; v++ )
+      {
+      const double value = featureImageBuffer[v];
+      if( vnl_math_abs( featureBuffer[ v * numberOfLeadingFeatures + f ]
+          - value ) > 1e-5 * ( 1 + vnl_math_abs( value ) ) )
+        {
+        std::cerr << "Feature vector image differs from basis image " << f
+          << " at voxel " << v << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
   return EXIT_SUCCESS;
 }
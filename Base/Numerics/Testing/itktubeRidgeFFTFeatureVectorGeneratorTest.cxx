@@ -23,6 +23,10 @@ limitations under the License.
 
 #include "itktubeRidgeFFTFeatureVectorGenerator.h"
 
+#include <itkImageRegionConstIteratorWithIndex.h>
+
+#include <algorithm>
+
 int itktubeRidgeFFTFeatureVectorGeneratorTest( int argc, char * argv[] )
 {
   if( argc != 4 )
@@ -77,6 +81,72 @@ int itktubeRidgeFFTFeatureVectorGeneratorTest( int argc, char * argv[] )
 
   filter->GenerateData();
 
+  // The trailing features hold the maximum over scales of each per-scale
+  //   feature, preceded by the scale at which the intensity (feature 0)
+  //   is maximal
+  const unsigned int numFeatures = filter->GetNumberOfFeatures();
+  const unsigned int numFeaturesPerScale = 5;
+  const unsigned int foScale = numFeatures - numFeaturesPerScale - 1;
+  const unsigned int foFeat = numFeatures - numFeaturesPerScale;
+  itk::ImageRegionConstIteratorWithIndex< ImageType > iter( inputImage,
+    inputImage->GetLargestPossibleRegion() );
+  while( !iter.IsAtEnd() )
+    {
+    for( unsigned int f=0; f<numFeaturesPerScale; ++f )
+      {
+      const float maxValue = std::max(
+        filter->GetFeatureVectorValue( iter.GetIndex(), f ),
+        filter->GetFeatureVectorValue( iter.GetIndex(),
+          numFeaturesPerScale + f ) );
+      if( filter->GetFeatureVectorValue( iter.GetIndex(), foFeat + f )
+        != maxValue )
+        {
+        std::cerr << "Max over scales of feature " << f
+          << " is wrong at " << iter.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    const float scale = filter->GetFeatureVectorValue( iter.GetIndex(),
+      foScale );
+    const unsigned int maxScale = ( filter->GetFeatureVectorValue(
+      iter.GetIndex(), numFeaturesPerScale ) > filter->GetFeatureVectorValue(
+      iter.GetIndex(), 0 ) ) ? 1 : 0;
+    if( scale != static_cast< float >( scales[maxScale] ) )
+      {
+      std::cerr << "Scale of maximum is wrong at " << iter.GetIndex()
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    ++iter;
+    }
+
+  // The interleaved image must hold the same values as the per-voxel API
+  FilterType::FeatureVectorImageType::Pointer featureVectorImage =
+    filter->GetFeatureVectorImage();
+  if( featureVectorImage->GetNumberOfComponentsPerPixel() != numFeatures )
+    {
+    std::cerr << "Feature vector image has the wrong number of components."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+  const FilterType::FeatureValueType * featureBuffer =
+    featureVectorImage->GetBufferPointer();
+  for( iter.GoToBegin(); !iter.IsAtEnd(); ++iter )
+    {
+    const itk::OffsetValueType offset =
+      inputImage->ComputeOffset( iter.GetIndex() );
+    for( unsigned int f=0; f<numFeatures; ++f )
+      {
+      if( featureBuffer[ offset * numFeatures + f ]
+        != filter->GetFeatureVectorValue( iter.GetIndex(), f ) )
+        {
+        std::cerr << "Feature vector image differs at " << iter.GetIndex()
+          << " feature " << f << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
   WriterType::Pointer imageFeature0Writer = WriterType::New();
   imageFeature0Writer->SetFileName( argv[2] );
   imageFeature0Writer->SetUseCompression( true );
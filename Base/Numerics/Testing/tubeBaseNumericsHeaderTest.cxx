@@ -24,6 +24,8 @@ limitations under the License.
 #include "itktubeBasisFeatureVectorGenerator.h"
 #include "itktubeBlurImageFunction.h"
 #include "itktubeFeatureVectorGenerator.h"
+#include "itktubeFiniteDifferenceCostFunction.h"
+#include "itktubeImageQuantileCalculator.h"
 #include "itktubeImageRegionMomentsCalculator.h"
 #include "itktubeJointHistogramImageFunction.h"
 #include "itktubeNJetFeatureVectorGenerator.h"
@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "itktubeBasisFeatureVectorGenerator.h"
 #include "itktubeBlurImageFunction.h"
+#include "itktubeImageQuantileCalculator.h"
 #include "itktubeImageRegionMomentsCalculator.h"
 #include "itktubeJointHistogramImageFunction.h"
 #include "itktubeNJetFeatureVectorGenerator.h"
@@ -39,6 +40,13 @@ int tubeBaseNumericsPrintTest( int itkNotUsed( argc ), char * itkNotUsed( argv )
   typedef itk::Image< float, 2 >                 ImageType;
   typedef itk::Image< itk::Vector<float, 2>, 2 > VectorImageType;
 
+  itk::tube::ImageQuantileCalculator< ImageType >::Pointer
+    quantileObject =
+    itk::tube::ImageQuantileCalculator< ImageType >::New();
+  std::cout << "-------------itktubeImageQuantileCalculator"
+            << quantileObject
+            << std::endl;
+
   itk::tube::ImageRegionMomentsCalculator< ImageType >::Pointer
     regionMomentsObject =
     itk::tube::ImageRegionMomentsCalculator< ImageType >::New();
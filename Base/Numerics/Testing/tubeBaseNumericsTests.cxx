@@ -34,6 +34,7 @@ void RegisterTests( void )
 {
   REGISTER_TEST( tubeBaseNumericsPrintTest );
   REGISTER_TEST( itktubeBlurImageFunctionTest );
+  REGISTER_TEST( itktubeImageQuantileCalculatorTest );
   REGISTER_TEST( itktubeImageRegionMomentsCalculatorTest );
   REGISTER_TEST( itktubeJointHistogramImageFunctionTest );
   REGISTER_TEST( itktubeNJetBasisFeatureVectorGeneratorTest );
@@ -27,6 +27,7 @@ limitations under the License.
 #include "itktubeFeatureVectorGenerator.h"
 
 #include <itkImage.h>
+#include <itkMultiThreader.h>
 
 #include <vnl/vnl_matrix.h>
 #include <vnl/vnl_vector.h>
@@ -66,6 +67,8 @@ public:
   typedef typename Superclass::FeatureValueType  FeatureValueType;
   typedef typename Superclass::FeatureVectorType FeatureVectorType;
   typedef typename Superclass::FeatureImageType  FeatureImageType;
+  typedef typename Superclass::FeatureVectorImageType
+                                                 FeatureVectorImageType;
 
   typedef FeatureVectorGenerator< TImage >       FeatureVectorGeneratorType;
 
@@ -118,6 +121,14 @@ public:
 
   typename FeatureImageType::Pointer GetFeatureImage( unsigned int fNum ) const;
 
+  using Superclass::GetFeatureVectorImage;
+
+  /** Projects every voxel onto the first numberOfFeatures basis vectors
+   *  only, into an interleaved image.  As in GetFeatureImage(), voxels
+   *  outside the object ids of the label map, when one is set, are 0. */
+  typename FeatureVectorImageType::Pointer GetFeatureVectorImage(
+    unsigned int numberOfFeatures ) const;
+
   virtual void GenerateBasis( void );
 
   void SetNumberOfBasisToUseAsFeatures( unsigned int numBasisUsed );
@@ -130,6 +141,9 @@ public:
   virtual FeatureValueType  GetFeatureVectorValue( const IndexType & indx,
     unsigned int fNum ) const;
 
+  virtual void GenerateFeatureVectors( SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
 protected:
 
   BasisFeatureVectorGenerator( void );
@@ -137,6 +151,73 @@ protected:
 
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  /** Number of voxels whose feature vectors are generated together */
+  itkStaticConstMacro( ChunkSize, SizeValueType, 1024 );
+
+  /** Count, running mean, and sum of squared deviations of one class */
+  struct ClassStatisticsType
+    {
+    double     Count;
+    VectorType Mean;
+    MatrixType Covariance;
+    };
+  typedef std::vector< ClassStatisticsType > ClassStatisticsListType;
+
+  struct GenerateStatisticsThreadStruct
+    {
+    const Self *                           Generator;
+    std::vector< ClassStatisticsListType > ThreadStatistics;
+    SizeValueType                          NumberOfVoxels;
+    bool                                   AccumulateCovariance;
+    };
+
+  struct GenerateFeatureImageThreadStruct
+    {
+    const Self *       Generator;
+    unsigned int       FeatureNumber;
+    unsigned int       NumberOfFeatures;
+    FeatureValueType * Buffer;
+    SizeValueType      NumberOfVoxels;
+    };
+
+  static void InitializeStatistics( unsigned int numClasses,
+    unsigned int numInputFeatures, ClassStatisticsListType & stats );
+  static void MergeMeans( const ClassStatisticsType & from,
+    ClassStatisticsType & into );
+
+  static ITK_THREAD_RETURN_TYPE GenerateStatisticsThreaderCallback(
+    void * arg );
+  /** Updates the running count and mean of each class, and of all
+   *  classes in the last entry of stats, over the voxels of the range.
+   *  If accumulateCovariance, also adds the deviation of each sample
+   *  from the updated running mean to the sums of squared deviations. */
+  void ThreadedGenerateStatistics( SizeValueType startVoxel,
+    SizeValueType endVoxel, ClassStatisticsListType & stats,
+    bool accumulateCovariance ) const;
+
+  static ITK_THREAD_RETURN_TYPE GenerateFeatureImageThreaderCallback(
+    void * arg );
+  /** Writes features [firstFeature, firstFeature+numberOfFeatures) of
+   *  each voxel contiguously into buffer */
+  void ThreadedGenerateFeatureImage( unsigned int firstFeature,
+    unsigned int numberOfFeatures, SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
+  /** Copies basis vectors [firstFeature, firstFeature+numberOfFeatures)
+   *  into consecutive rows of basis */
+  void GetTransposedBasis( unsigned int firstFeature,
+    unsigned int numberOfFeatures, std::vector< ValueType > & basis ) const;
+  void ProjectFeatureVectors( const FeatureValueType * inputVectors,
+    SizeValueType numberOfVoxels, const std::vector< ValueType > & basis,
+    unsigned int numberOfFeatures, FeatureValueType * outputVectors ) const;
+
+  /** Index of objectId in the object id list, or -1 */
+  int GetObjectIdIndex( ObjectIdType objectId ) const;
+
+  static bool SplitVoxels( SizeValueType threadId, SizeValueType threadCount,
+    SizeValueType numberOfVoxels, SizeValueType & start,
+    SizeValueType & end );
+
 private:
 
   // Purposely not implemented
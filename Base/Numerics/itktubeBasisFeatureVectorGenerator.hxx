@@ -32,6 +32,7 @@ limitations under the License.
 #include <itkImageFileWriter.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
 #include <itkTimeProbesCollectorBase.h>
 
 #include <iostream>
@@ -333,9 +334,6 @@ BasisFeatureVectorGenerator< TImage, TLabelMap >
 
     timeCollector.Start( "GenerateBasisImage" );
 
-    typedef itk::ImageRegionIteratorWithIndex< FeatureImageType >
-      ImageIteratorType;
-
     typename FeatureImageType::RegionType region;
     region = this->m_InputImageList[0]->GetLargestPossibleRegion();
 
@@ -345,57 +343,17 @@ BasisFeatureVectorGenerator< TImage, TLabelMap >
     featureImage->CopyInformation( this->m_InputImageList[0] );
     featureImage->Allocate();
 
-    ImageIteratorType itBasisIm( featureImage,
-      featureImage->GetLargestPossibleRegion() );
+    GenerateFeatureImageThreadStruct str;
+    str.Generator = this;
+    str.FeatureNumber = featureNum;
+    str.NumberOfFeatures = 1;
+    str.Buffer = featureImage->GetBufferPointer();
+    str.NumberOfVoxels = region.GetNumberOfPixels();
 
-    if( m_LabelMap.IsNotNull() )
-      {
-      const unsigned int numClasses = this->GetNumberOfObjectIds();
-      typedef itk::ImageRegionConstIteratorWithIndex< LabelMapType >
-        ConstLabelMapIteratorType;
-      ConstLabelMapIteratorType itInMask( m_LabelMap,
-        m_LabelMap->GetLargestPossibleRegion() );
-      bool found = false;
-      ObjectIdType previousMaskValue =
-        static_cast<ObjectIdType>( itInMask.Get() ) + 1;
-      while( !itBasisIm.IsAtEnd() )
-        {
-        ObjectIdType maskVal = static_cast<ObjectIdType>( itInMask.Get() );
-        if( maskVal != previousMaskValue )
-          {
-          found = false;
-          previousMaskValue = maskVal;
-          for( unsigned int c = 0; c < numClasses; c++ )
-            {
-            if( maskVal == m_ObjectIdList[c] )
-              {
-              found = true;
-              break;
-              }
-            }
-          }
-        if( !found )
-          {
-          itBasisIm.Set( 0 );
-          }
-        else
-          {
-          IndexType indx = itBasisIm.GetIndex();
-          itBasisIm.Set( this->GetFeatureVectorValue( indx, featureNum ) );
-          }
-        ++itBasisIm;
-        ++itInMask;
-        }
-      }
-    else
-      {
-      while( !itBasisIm.IsAtEnd() )
-        {
-        IndexType indx = itBasisIm.GetIndex();
-        itBasisIm.Set( this->GetFeatureVectorValue( indx, featureNum ) );
-        ++itBasisIm;
-        }
-      }
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetSingleMethod( this->GenerateFeatureImageThreaderCallback,
+      &str );
+    threader->SingleMethodExecute();
 
     timeCollector.Stop( "GenerateBasisImage" );
     timeCollector.Report();
@@ -409,118 +367,314 @@ BasisFeatureVectorGenerator< TImage, TLabelMap >
 }
 
 template< class TImage, class TLabelMap >
-void
+typename BasisFeatureVectorGenerator< TImage, TLabelMap >
+::FeatureVectorImageType::Pointer
 BasisFeatureVectorGenerator< TImage, TLabelMap >
-::GenerateBasis( void )
+::GetFeatureVectorImage( unsigned int numberOfFeatures ) const
 {
+  if( numberOfFeatures == 0
+    || numberOfFeatures > m_NumberOfBasisToUseAsFeatures )
+    {
+    throw;
+    }
+
   itk::TimeProbesCollectorBase timeCollector;
 
-  timeCollector.Start( "GenerateStatistics" );
+  timeCollector.Start( "GenerateBasisVectorImage" );
 
-  typedef itk::ImageRegionConstIteratorWithIndex< LabelMapType >
-    ConstLabelMapIteratorType;
-  ConstLabelMapIteratorType itInMask( m_LabelMap,
-    m_LabelMap->GetLargestPossibleRegion() );
+  typename FeatureImageType::RegionType region;
+  region = this->m_InputImageList[0]->GetLargestPossibleRegion();
 
-  const unsigned int numClasses = this->GetNumberOfObjectIds();
+  typename FeatureVectorImageType::Pointer featureVectorImage =
+    FeatureVectorImageType::New();
+  featureVectorImage->CopyInformation( this->m_InputImageList[0] );
+  featureVectorImage->SetRegions( region );
+  featureVectorImage->SetNumberOfComponentsPerPixel( numberOfFeatures );
+  featureVectorImage->Allocate();
+
+  GenerateFeatureImageThreadStruct str;
+  str.Generator = this;
+  str.FeatureNumber = 0;
+  str.NumberOfFeatures = numberOfFeatures;
+  str.Buffer = featureVectorImage->GetBufferPointer();
+  str.NumberOfVoxels = region.GetNumberOfPixels();
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetSingleMethod( this->GenerateFeatureImageThreaderCallback,
+    &str );
+  threader->SingleMethodExecute();
+
+  timeCollector.Stop( "GenerateBasisVectorImage" );
+  timeCollector.Report();
+
+  return featureVectorImage;
+}
+
+template< class TImage, class TLabelMap >
+ITK_THREAD_RETURN_TYPE
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GenerateFeatureImageThreaderCallback( void * arg )
+{
+  const SizeValueType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const SizeValueType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  GenerateFeatureImageThreadStruct * str =
+    (GenerateFeatureImageThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  SizeValueType start;
+  SizeValueType end;
+  if( SplitVoxels( threadId, threadCount, str->NumberOfVoxels, start, end ) )
+    {
+    str->Generator->ThreadedGenerateFeatureImage( str->FeatureNumber,
+      str->NumberOfFeatures, start, end,
+      str->Buffer + start * str->NumberOfFeatures );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::ThreadedGenerateFeatureImage( unsigned int firstFeature,
+  unsigned int numberOfFeatures, SizeValueType startVoxel,
+  SizeValueType endVoxel, FeatureValueType * buffer ) const
+{
   const unsigned int numInputFeatures =
     m_InputFeatureVectorGenerator->GetNumberOfFeatures();
-  m_ObjectMeanList.resize( numClasses );
-  m_ObjectCovarianceList.resize( numClasses );
-  std::vector< unsigned int > countList( numClasses );
-  for( unsigned int i = 0; i < numClasses; i++ )
-    {
-    m_ObjectMeanList[i].set_size( numInputFeatures );
-    m_ObjectMeanList[i].fill( 0 );
-    m_ObjectCovarianceList[i].set_size( numInputFeatures,
-      numInputFeatures );
-    m_ObjectCovarianceList[i].fill( 0 );
-    countList[i] = 0;
-    }
-
-  m_GlobalMean.set_size( numInputFeatures );
-  m_GlobalMean.fill( 0 );
-  m_GlobalCovariance.set_size( numInputFeatures, numInputFeatures );
-  m_GlobalCovariance.fill( 0 );
-
-  unsigned int globalCount = 0;
-
-  double delta = 0;
-  double deltaJ = 0;
-  unsigned int valC = 0;
-  bool found = false;
-  itInMask.GoToBegin();
-  ObjectIdType previousMaskValue =
-    static_cast<ObjectIdType>( itInMask.Get() ) + 1;
-  while( !itInMask.IsAtEnd() )
-    {
-    ObjectIdType maskVal = static_cast<ObjectIdType>( itInMask.Get() );
-    if( maskVal != previousMaskValue )
+
+  std::vector< ValueType > basis;
+  this->GetTransposedBasis( firstFeature, numberOfFeatures, basis );
+
+  std::vector< FeatureValueType > inputBuffer( ChunkSize * numInputFeatures );
+
+  if( m_LabelMap.IsNotNull() )
+    {
+    // Only voxels of the training classes are projected; runs of such
+    //   voxels are projected together
+    const typename LabelMapType::PixelType * labelBuffer =
+      m_LabelMap->GetBufferPointer();
+    SizeValueType v = startVoxel;
+    while( v < endVoxel )
       {
-      previousMaskValue = maskVal;
-      found = false;
-      for( unsigned int c = 0; c < numClasses; c++ )
+      if( this->GetObjectIdIndex( labelBuffer[v] ) < 0 )
         {
-        if( maskVal == m_ObjectIdList[c] )
+        FeatureValueType * outputVector =
+          buffer + ( v - startVoxel ) * numberOfFeatures;
+        for( unsigned int i = 0; i < numberOfFeatures; i++ )
           {
-          valC = c;
-          found = true;
-          break;
+          outputVector[i] = 0;
           }
+        ++v;
+        continue;
         }
-      }
-    if( found )
-      {
-      IndexType indx = itInMask.GetIndex();
-      FeatureVectorType v = m_InputFeatureVectorGenerator->
-        GetFeatureVector( indx );
-
-      ++globalCount;
-      ++countList[valC];
-      for( unsigned int i = 0; i < numInputFeatures; i++ )
+      SizeValueType runEnd = v + 1;
+      while( runEnd < endVoxel && runEnd - v < ChunkSize
+        && this->GetObjectIdIndex( labelBuffer[runEnd] ) >= 0 )
         {
-        delta = v[i] - m_GlobalMean[i];
-        m_GlobalMean[i] += delta / globalCount;
-
-        delta = v[i] - m_ObjectMeanList[valC][i];
-        m_ObjectMeanList[valC][i] += delta / countList[valC];
+        ++runEnd;
         }
-      for( unsigned int i = 0; i < numInputFeatures; i++ )
+      m_InputFeatureVectorGenerator->GenerateFeatureVectors( v, runEnd,
+        &( inputBuffer[0] ) );
+      this->ProjectFeatureVectors( &( inputBuffer[0] ), runEnd - v, basis,
+        numberOfFeatures, buffer + ( v - startVoxel ) * numberOfFeatures );
+      v = runEnd;
+      }
+    }
+  else
+    {
+    for( SizeValueType chunkStart = startVoxel; chunkStart < endVoxel;
+      chunkStart += ChunkSize )
+      {
+      SizeValueType chunkEnd = chunkStart + ChunkSize;
+      if( chunkEnd > endVoxel )
         {
-        for( unsigned int j = 0; j < numInputFeatures; j++ )
-          {
-          delta = v[i] - m_GlobalMean[i];
-          deltaJ = v[j] - m_GlobalMean[j];
-          m_GlobalCovariance[i][j] += delta * deltaJ;
-
-          delta = v[i] - m_ObjectMeanList[valC][i];
-          deltaJ = v[j] - m_ObjectMeanList[valC][j];
-          m_ObjectCovarianceList[valC][i][j] += delta * deltaJ;
-          }
+        chunkEnd = endVoxel;
         }
+      m_InputFeatureVectorGenerator->GenerateFeatureVectors( chunkStart,
+        chunkEnd, &( inputBuffer[0] ) );
+      this->ProjectFeatureVectors( &( inputBuffer[0] ),
+        chunkEnd - chunkStart, basis, numberOfFeatures,
+        buffer + ( chunkStart - startVoxel ) * numberOfFeatures );
       }
-    ++itInMask;
     }
+}
 
-  for( unsigned int i = 0; i < numInputFeatures; i++ )
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GetTransposedBasis( unsigned int firstFeature,
+  unsigned int numberOfFeatures, std::vector< ValueType > & basis ) const
+{
+  const unsigned int numInputFeatures = m_BasisMatrix.rows();
+
+  basis.resize( numberOfFeatures * numInputFeatures );
+  for( unsigned int i = 0; i < numberOfFeatures; i++ )
     {
     for( unsigned int j = 0; j < numInputFeatures; j++ )
       {
-      m_GlobalCovariance[i][j] /= globalCount - 1;
-      for( unsigned int c = 0; c < numClasses; c++ )
+      basis[ i * numInputFeatures + j ] = m_BasisMatrix[j][firstFeature + i];
+      }
+    }
+}
+
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::ProjectFeatureVectors( const FeatureValueType * inputVectors,
+  SizeValueType numberOfVoxels, const std::vector< ValueType > & basis,
+  unsigned int numberOfFeatures, FeatureValueType * outputVectors ) const
+{
+  const unsigned int numInputFeatures = basis.size() / numberOfFeatures;
+
+  // Product of a (numberOfVoxels x numInputFeatures) block of feature
+  //   vectors with the (numInputFeatures x numberOfFeatures) basis.  The
+  //   basis is stored transposed so the inner loop is contiguous.
+  for( SizeValueType v = 0; v < numberOfVoxels; v++ )
+    {
+    const ValueType * basisVector = &( basis[0] );
+    for( unsigned int i = 0; i < numberOfFeatures; i++ )
+      {
+      ValueType sum = 0;
+      for( unsigned int j = 0; j < numInputFeatures; j++ )
         {
-        if( countList[c] > 1 )
-          {
-          m_ObjectCovarianceList[c][i][j] /= countList[c] - 1;
-          }
-        else
-          {
-          m_ObjectCovarianceList[c][i][j] = 1;
-          }
+        sum += basisVector[j] * inputVectors[j];
         }
+      *outputVectors = static_cast< FeatureValueType >( sum );
+      ++outputVectors;
+      basisVector += numInputFeatures;
+      }
+    inputVectors += numInputFeatures;
+    }
+}
+
+template< class TImage, class TLabelMap >
+int
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GetObjectIdIndex( ObjectIdType objectId ) const
+{
+  const unsigned int numClasses = m_ObjectIdList.size();
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    if( objectId == m_ObjectIdList[c] )
+      {
+      return c;
+      }
+    }
+  return -1;
+}
+
+template< class TImage, class TLabelMap >
+bool
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::SplitVoxels( SizeValueType threadId, SizeValueType threadCount,
+  SizeValueType numberOfVoxels, SizeValueType & start, SizeValueType & end )
+{
+  // Multiples of ChunkSize keep threads off each other's cache lines
+  SizeValueType voxelsPerThread =
+    ( numberOfVoxels + threadCount - 1 ) / threadCount;
+  voxelsPerThread = ( ( voxelsPerThread + ChunkSize - 1 ) / ChunkSize )
+    * ChunkSize;
+  start = threadId * voxelsPerThread;
+  if( start >= numberOfVoxels )
+    {
+    return false;
+    }
+  end = start + voxelsPerThread;
+  if( end > numberOfVoxels )
+    {
+    end = numberOfVoxels;
+    }
+  return true;
+}
+
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GenerateBasis( void )
+{
+  itk::TimeProbesCollectorBase timeCollector;
+
+  timeCollector.Start( "GenerateStatistics" );
+
+  const unsigned int numClasses = this->GetNumberOfObjectIds();
+  const unsigned int numInputFeatures =
+    m_InputFeatureVectorGenerator->GetNumberOfFeatures();
+
+  // The sums of squared deviations use the running mean of the voxels up
+  //   to and including each sample, in scan order.  A first pass over the
+  //   threads' shares of the voxels counts and averages the samples; the
+  //   second pass starts each thread from the running means of the shares
+  //   before it and accumulates the deviations.  The last entry of each
+  //   list holds the statistics of all classes together.
+  MultiThreader::Pointer threader = MultiThreader::New();
+  const unsigned int numThreads = threader->GetNumberOfThreads();
+
+  GenerateStatisticsThreadStruct str;
+  str.Generator = this;
+  str.NumberOfVoxels = m_LabelMap->GetLargestPossibleRegion()
+    .GetNumberOfPixels();
+  str.ThreadStatistics.resize( numThreads );
+  for( unsigned int t = 0; t < numThreads; t++ )
+    {
+    this->InitializeStatistics( numClasses + 1, numInputFeatures,
+      str.ThreadStatistics[t] );
+    }
+
+  threader->SetSingleMethod( this->GenerateStatisticsThreaderCallback,
+    &str );
+  str.AccumulateCovariance = false;
+  threader->SingleMethodExecute();
+
+  ClassStatisticsListType classStatistics;
+  this->InitializeStatistics( numClasses + 1, numInputFeatures,
+    classStatistics );
+  for( unsigned int t = 0; t < numThreads; t++ )
+    {
+    ClassStatisticsListType threadStatistics = str.ThreadStatistics[t];
+    for( unsigned int c = 0; c <= numClasses; c++ )
+      {
+      str.ThreadStatistics[t][c] = classStatistics[c];
+      MergeMeans( threadStatistics[c], classStatistics[c] );
+      }
+    }
+
+  str.AccumulateCovariance = true;
+  threader->SingleMethodExecute();
+
+  for( unsigned int t = 0; t < numThreads; t++ )
+    {
+    for( unsigned int c = 0; c <= numClasses; c++ )
+      {
+      classStatistics[c].Covariance += str.ThreadStatistics[t][c].Covariance;
+      }
+    }
+
+  m_ObjectMeanList.resize( numClasses );
+  m_ObjectCovarianceList.resize( numClasses );
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    m_ObjectMeanList[c] = classStatistics[c].Mean;
+    if( classStatistics[c].Count > 1 )
+      {
+      m_ObjectCovarianceList[c] = classStatistics[c].Covariance
+        / ( classStatistics[c].Count - 1 );
+      }
+    else
+      {
+      m_ObjectCovarianceList[c].set_size( numInputFeatures,
+        numInputFeatures );
+      m_ObjectCovarianceList[c].fill( 1 );
       }
     }
 
+  m_GlobalMean = classStatistics[numClasses].Mean;
+  m_GlobalCovariance = classStatistics[numClasses].Covariance
+    / ( classStatistics[numClasses].Count - 1 );
+
   timeCollector.Stop( "GenerateStatistics" );
 
   timeCollector.Start( "GenerateBasis" );
@@ -585,6 +739,138 @@ BasisFeatureVectorGenerator< TImage, TLabelMap >
   timeCollector.Report();
 }
 
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::InitializeStatistics( unsigned int numClasses,
+  unsigned int numInputFeatures, ClassStatisticsListType & stats )
+{
+  stats.resize( numClasses );
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    stats[c].Count = 0;
+    stats[c].Mean.set_size( numInputFeatures );
+    stats[c].Mean.fill( 0 );
+    stats[c].Covariance.set_size( numInputFeatures, numInputFeatures );
+    stats[c].Covariance.fill( 0 );
+    }
+}
+
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::MergeMeans( const ClassStatisticsType & from,
+  ClassStatisticsType & into )
+{
+  if( from.Count == 0 )
+    {
+    return;
+    }
+  const double count = into.Count + from.Count;
+  into.Mean += ( from.Mean - into.Mean ) * ( from.Count / count );
+  into.Count = count;
+}
+
+template< class TImage, class TLabelMap >
+ITK_THREAD_RETURN_TYPE
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GenerateStatisticsThreaderCallback( void * arg )
+{
+  const SizeValueType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const SizeValueType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  GenerateStatisticsThreadStruct * str =
+    (GenerateStatisticsThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  SizeValueType start;
+  SizeValueType end;
+  if( SplitVoxels( threadId, threadCount, str->NumberOfVoxels, start, end ) )
+    {
+    str->Generator->ThreadedGenerateStatistics( start, end,
+      str->ThreadStatistics[threadId], str->AccumulateCovariance );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::ThreadedGenerateStatistics( SizeValueType startVoxel,
+  SizeValueType endVoxel, ClassStatisticsListType & stats,
+  bool accumulateCovariance ) const
+{
+  const unsigned int numInputFeatures =
+    m_InputFeatureVectorGenerator->GetNumberOfFeatures();
+
+  std::vector< FeatureValueType > inputBuffer( ChunkSize * numInputFeatures );
+  std::vector< ValueType > delta( numInputFeatures );
+
+  ClassStatisticsType & globalStats = stats[stats.size() - 1];
+
+  // Feature vectors are only generated for runs of voxels of one class
+  const typename LabelMapType::PixelType * labelBuffer =
+    m_LabelMap->GetBufferPointer();
+  SizeValueType v = startVoxel;
+  while( v < endVoxel )
+    {
+    const int valC = this->GetObjectIdIndex( labelBuffer[v] );
+    if( valC < 0 )
+      {
+      ++v;
+      continue;
+      }
+    SizeValueType runEnd = v + 1;
+    while( runEnd < endVoxel && runEnd - v < ChunkSize
+      && labelBuffer[runEnd] == labelBuffer[v] )
+      {
+      ++runEnd;
+      }
+    m_InputFeatureVectorGenerator->GenerateFeatureVectors( v, runEnd,
+      &( inputBuffer[0] ) );
+
+    ClassStatisticsType & classStats = stats[valC];
+    const FeatureValueType * x = &( inputBuffer[0] );
+    for( SizeValueType r = v; r < runEnd; r++ )
+      {
+      globalStats.Count += 1;
+      classStats.Count += 1;
+      for( unsigned int i = 0; i < numInputFeatures; i++ )
+        {
+        globalStats.Mean[i] += ( x[i] - globalStats.Mean[i] )
+          / globalStats.Count;
+        classStats.Mean[i] += ( x[i] - classStats.Mean[i] )
+          / classStats.Count;
+        }
+      if( accumulateCovariance )
+        {
+        ClassStatisticsType * updatedStats[2] = { &globalStats,
+          &classStats };
+        for( unsigned int u = 0; u < 2; u++ )
+          {
+          for( unsigned int i = 0; i < numInputFeatures; i++ )
+            {
+            delta[i] = x[i] - updatedStats[u]->Mean[i];
+            }
+          for( unsigned int i = 0; i < numInputFeatures; i++ )
+            {
+            ValueType * covarianceRow = updatedStats[u]->Covariance[i];
+            for( unsigned int j = 0; j < numInputFeatures; j++ )
+              {
+              covarianceRow[j] += delta[i] * delta[j];
+              }
+            }
+          }
+        }
+      x += numInputFeatures;
+      }
+    v = runEnd;
+    }
+}
+
 template< class TImage, class TLabelMap >
 void
 BasisFeatureVectorGenerator< TImage, TLabelMap >
@@ -656,6 +942,37 @@ BasisFeatureVectorGenerator< TImage, TLabelMap >
   return featureVector;
 }
 
+template< class TImage, class TLabelMap >
+void
+BasisFeatureVectorGenerator< TImage, TLabelMap >
+::GenerateFeatureVectors( SizeValueType startVoxel, SizeValueType endVoxel,
+  FeatureValueType * buffer ) const
+{
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+  const unsigned int numInputFeatures =
+    m_InputFeatureVectorGenerator->GetNumberOfFeatures();
+
+  std::vector< ValueType > basis;
+  this->GetTransposedBasis( 0, numFeatures, basis );
+
+  // Project chunks of interleaved input feature vectors
+  std::vector< FeatureValueType > inputBuffer( ChunkSize * numInputFeatures );
+  for( SizeValueType chunkStart = startVoxel; chunkStart < endVoxel;
+    chunkStart += ChunkSize )
+    {
+    SizeValueType chunkEnd = chunkStart + ChunkSize;
+    if( chunkEnd > endVoxel )
+      {
+      chunkEnd = endVoxel;
+      }
+    m_InputFeatureVectorGenerator->GenerateFeatureVectors( chunkStart,
+      chunkEnd, &( inputBuffer[0] ) );
+    this->ProjectFeatureVectors( &( inputBuffer[0] ), chunkEnd - chunkStart,
+      basis, numFeatures, buffer );
+    buffer += ( chunkEnd - chunkStart ) * numFeatures;
+    }
+}
+
 template< class TImage, class TLabelMap >
 void
 BasisFeatureVectorGenerator< TImage, TLabelMap >
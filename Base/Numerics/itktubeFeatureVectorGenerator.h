@@ -26,6 +26,8 @@ limitations under the License.
 
 #include <itkImage.h>
 #include <itkLightProcessObject.h>
+#include <itkMultiThreader.h>
+#include <itkVectorImage.h>
 
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_matrix.h>
@@ -64,6 +66,11 @@ public:
   typedef vnl_vector< FeatureValueType >                    FeatureVectorType;
   typedef Image< FeatureValueType, TImage::ImageDimension > FeatureImageType;
 
+  /** Pixel-interleaved image holding every feature of a voxel contiguously;
+   *  the stride between voxels is GetNumberOfFeatures(). */
+  typedef VectorImage< FeatureValueType, TImage::ImageDimension >
+                                                   FeatureVectorImageType;
+
   typedef double                   ValueType;
   typedef std::vector< ValueType > ValueListType;
 
@@ -97,6 +104,18 @@ public:
   virtual typename FeatureImageType::Pointer GetFeatureImage(
     unsigned int num ) const;
 
+  /** Computes all features of all voxels, whitened where this generator
+   *  whitens, in one multithreaded pass into an interleaved image. */
+  typename FeatureVectorImageType::Pointer GetFeatureVectorImage( void )
+    const;
+
+  /** Writes the feature vectors of the voxels at buffer offsets
+   *  [startVoxel, endVoxel) of the input images into buffer, one vector of
+   *  GetNumberOfFeatures() values after another.  Used for bulk access
+   *  without per-voxel allocations; must be thread-safe. */
+  virtual void GenerateFeatureVectors( SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
 protected:
 
   FeatureVectorGenerator( void );
@@ -106,6 +125,22 @@ protected:
 
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  /** Implements GenerateFeatureVectors() using GetFeatureVector() at each
+   *  voxel's index, for generators whose features are not stored */
+  void GenerateFeatureVectorsAtIndices( SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
+  struct GenerateFeatureVectorsThreadStruct
+    {
+    const Self *        Generator;
+    FeatureValueType *  Buffer;
+    unsigned int        NumberOfFeatures;
+    SizeValueType       NumberOfVoxels;
+    };
+
+  static ITK_THREAD_RETURN_TYPE GenerateFeatureVectorsThreaderCallback(
+    void * arg );
+
 private:
 
   // Purposely not implemented
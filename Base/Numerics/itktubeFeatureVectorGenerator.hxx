@@ -335,6 +335,136 @@ FeatureVectorGenerator< TImage >
 }
 
 
+template< class TImage >
+typename FeatureVectorGenerator< TImage >::FeatureVectorImageType::Pointer
+FeatureVectorGenerator< TImage >
+::GetFeatureVectorImage( void ) const
+{
+  itk::TimeProbesCollectorBase timeCollector;
+
+  timeCollector.Start( "GenerateFeatureVectorImage" );
+
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+
+  typename FeatureVectorImageType::Pointer featureVectorImage =
+    FeatureVectorImageType::New();
+  featureVectorImage->CopyInformation( m_InputImageList[0] );
+  featureVectorImage->SetRegions(
+    m_InputImageList[0]->GetLargestPossibleRegion() );
+  featureVectorImage->SetNumberOfComponentsPerPixel( numFeatures );
+  featureVectorImage->Allocate();
+
+  GenerateFeatureVectorsThreadStruct str;
+  str.Generator = this;
+  str.Buffer = featureVectorImage->GetBufferPointer();
+  str.NumberOfFeatures = numFeatures;
+  str.NumberOfVoxels = m_InputImageList[0]->GetLargestPossibleRegion()
+    .GetNumberOfPixels();
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetSingleMethod( this->GenerateFeatureVectorsThreaderCallback,
+    &str );
+  threader->SingleMethodExecute();
+
+  timeCollector.Stop( "GenerateFeatureVectorImage" );
+  timeCollector.Report();
+
+  return featureVectorImage;
+}
+
+template< class TImage >
+ITK_THREAD_RETURN_TYPE
+FeatureVectorGenerator< TImage >
+::GenerateFeatureVectorsThreaderCallback( void * arg )
+{
+  const SizeValueType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const SizeValueType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  GenerateFeatureVectorsThreadStruct * str =
+    (GenerateFeatureVectorsThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  // Chunks are multiples of 64 voxels so that threads do not write to
+  //   the same cache lines
+  const SizeValueType blockSize = 64;
+  SizeValueType voxelsPerThread =
+    ( str->NumberOfVoxels + threadCount - 1 ) / threadCount;
+  voxelsPerThread = ( ( voxelsPerThread + blockSize - 1 ) / blockSize )
+    * blockSize;
+  const SizeValueType start = threadId * voxelsPerThread;
+  if( start < str->NumberOfVoxels )
+    {
+    SizeValueType end = start + voxelsPerThread;
+    if( end > str->NumberOfVoxels )
+      {
+      end = str->NumberOfVoxels;
+      }
+    str->Generator->GenerateFeatureVectors( start, end,
+      str->Buffer + start * str->NumberOfFeatures );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage >
+void
+FeatureVectorGenerator< TImage >
+::GenerateFeatureVectors( SizeValueType startVoxel, SizeValueType endVoxel,
+  FeatureValueType * buffer ) const
+{
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+
+  for( unsigned int f = 0; f < numFeatures; f++ )
+    {
+    const typename ImageType::PixelType * inputBuffer =
+      m_InputImageList[f]->GetBufferPointer();
+    FeatureValueType * outputBuffer = buffer + f;
+    if( m_WhitenFeatureImageStdDev.size() > 0 &&
+      m_WhitenFeatureImageStdDev[f] > 0 )
+      {
+      const double mean = m_WhitenFeatureImageMean[f];
+      const double stdDev = m_WhitenFeatureImageStdDev[f];
+      for( SizeValueType v = startVoxel; v < endVoxel; v++ )
+        {
+        *outputBuffer = static_cast< FeatureValueType >(
+          ( inputBuffer[v] - mean ) / stdDev );
+        outputBuffer += numFeatures;
+        }
+      }
+    else
+      {
+      for( SizeValueType v = startVoxel; v < endVoxel; v++ )
+        {
+        *outputBuffer = static_cast< FeatureValueType >( inputBuffer[v] );
+        outputBuffer += numFeatures;
+        }
+      }
+    }
+}
+
+template< class TImage >
+void
+FeatureVectorGenerator< TImage >
+::GenerateFeatureVectorsAtIndices( SizeValueType startVoxel,
+  SizeValueType endVoxel, FeatureValueType * buffer ) const
+{
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+
+  for( SizeValueType v = startVoxel; v < endVoxel; v++ )
+    {
+    const IndexType indx = m_InputImageList[0]->ComputeIndex(
+      static_cast< OffsetValueType >( v ) );
+    const FeatureVectorType featureVector = this->GetFeatureVector( indx );
+    for( unsigned int f = 0; f < numFeatures; f++ )
+      {
+      *buffer = featureVector[f];
+      ++buffer;
+      }
+    }
+}
+
 template< class TImage >
 void
 FeatureVectorGenerator< TImage >
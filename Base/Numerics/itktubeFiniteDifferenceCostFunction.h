@@ -0,0 +1,174 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeFiniteDifferenceCostFunction_h
+#define __itktubeFiniteDifferenceCostFunction_h
+
+#include <itkMultiThreader.h>
+#include <itkSingleValuedCostFunction.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class FiniteDifferenceCostFunction
+ * \brief Single valued cost function whose derivative is estimated by
+ * central differences, with the probes evaluated concurrently.
+ *
+ * The derivative along parameter i is
+ * EvaluateProbe( p + h_i ) - EvaluateProbe( p - h_i ), where h_i is the
+ * ith derivative step size.  The 2N probes are independent and are spread
+ * over the threads of a MultiThreader, so EvaluateProbe() must be thread
+ * safe: it must not modify the cost function.
+ */
+class FiniteDifferenceCostFunction : public SingleValuedCostFunction
+{
+public:
+
+  typedef FiniteDifferenceCostFunction            Self;
+  typedef SingleValuedCostFunction                Superclass;
+  typedef SmartPointer< Self >                    Pointer;
+  typedef SmartPointer< const Self >              ConstPointer;
+
+  itkTypeMacro( FiniteDifferenceCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType         MeasureType;
+  typedef Superclass::ParametersType      ParametersType;
+  typedef Superclass::DerivativeType      DerivativeType;
+
+  /** Set/get the step size h_i of each parameter's central difference */
+  void SetDerivativeStepSizes( const ParametersType & stepSizes )
+    {
+    m_DerivativeStepSizes = stepSizes;
+    }
+  const ParametersType & GetDerivativeStepSizes( void ) const
+    {
+    return m_DerivativeStepSizes;
+    }
+
+  /** Set/get the maximum number of probes evaluated concurrently */
+  itkSetMacro( NumberOfThreads, ThreadIdType );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  void GetDerivative( const ParametersType & params,
+                      DerivativeType & deriv ) const
+    {
+    const unsigned int numParams = this->GetNumberOfParameters();
+
+    std::vector< ParametersType > probes( 2 * numParams, params );
+    for( unsigned int i=0; i<numParams; i++ )
+      {
+      probes[2*i][i] = params[i] - m_DerivativeStepSizes[i];
+      probes[2*i+1][i] = params[i] + m_DerivativeStepSizes[i];
+      }
+    std::vector< MeasureType > values( probes.size() );
+
+    ProbeThreadStruct str;
+    str.CostFunction = this;
+    str.Probes = &probes;
+    str.Values = &values;
+
+    ThreadIdType numThreads = m_NumberOfThreads;
+    if( numThreads > probes.size() )
+      {
+      numThreads = probes.size();
+      }
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads( numThreads );
+    threader->SetSingleMethod( this->ProbeThreaderCallback, &str );
+    threader->SingleMethodExecute();
+
+    deriv = params;
+    for( unsigned int i=0; i<numParams; i++ )
+      {
+      deriv[i] = values[2*i+1] - values[2*i];
+      }
+    }
+
+protected:
+
+  FiniteDifferenceCostFunction( void )
+    {
+    m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  virtual ~FiniteDifferenceCostFunction( void ) {}
+
+  /** Evaluates the cost function at a derivative probe.  Called
+   *  concurrently from several threads. */
+  virtual MeasureType EvaluateProbe( const ParametersType & params ) const = 0;
+
+  void PrintSelf( std::ostream & os, Indent indent ) const
+    {
+    Superclass::PrintSelf( os, indent );
+    os << indent << "DerivativeStepSizes: " << m_DerivativeStepSizes
+      << std::endl;
+    os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+    }
+
+private:
+
+  FiniteDifferenceCostFunction( const Self & );
+  void operator=( const Self & );
+
+  struct ProbeThreadStruct
+    {
+    const Self *                    CostFunction;
+    std::vector< ParametersType > * Probes;
+    std::vector< MeasureType > *    Values;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ProbeThreaderCallback( void * arg )
+    {
+    const ThreadIdType threadId =
+      ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+    const ThreadIdType threadCount =
+      ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+    ProbeThreadStruct * str = (ProbeThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+    for( unsigned int p = threadId; p < str->Probes->size();
+      p += threadCount )
+      {
+      (*str->Values)[p] =
+        str->CostFunction->EvaluateProbe( (*str->Probes)[p] );
+      }
+
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  ParametersType                      m_DerivativeStepSizes;
+
+  ThreadIdType                        m_NumberOfThreads;
+
+}; // End class FiniteDifferenceCostFunction
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeFiniteDifferenceCostFunction_h)
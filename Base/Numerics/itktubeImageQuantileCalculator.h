@@ -0,0 +1,178 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeImageQuantileCalculator_h
+#define __itktubeImageQuantileCalculator_h
+
+#include <itkImage.h>
+#include <itkMultiThreader.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class ImageQuantileCalculator
+ * \brief Compute exact quantiles of the intensities of an image.
+ *
+ * The buffered region of the image is split into contiguous voxel ranges
+ * that are processed by separate threads.  A first pass finds the
+ * intensity range, a second pass fills one fine-grained histogram per
+ * thread and merges them, and a third pass collects only the voxels that
+ * fall in the histogram bins containing the requested ranks.  Selecting
+ * within those bins gives the exact order statistics, so any number of
+ * quantiles costs at most three passes over the image.  The second pass
+ * also records the range of each bin; a rank in a single-valued bin, or
+ * at either end of its bin, is taken from that range, and the third pass
+ * is skipped when no bin needs collecting.
+ *
+ * Quantiles are interpolated linearly between the order statistics at
+ * ranks floor( q * ( N - 1 ) ) and ceil( q * ( N - 1 ) ), where N is the
+ * number of voxels considered.  If a mask is given, only voxels whose
+ * mask value is nonzero are considered; the mask must have the same
+ * buffered region as the image.
+ */
+template< class TImage, class TMaskImage = TImage >
+class ImageQuantileCalculator : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageQuantileCalculator                Self;
+  typedef Object                                 Superclass;
+  typedef SmartPointer< Self >                   Pointer;
+  typedef SmartPointer< const Self >             ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageQuantileCalculator, Object );
+
+  typedef TImage                                 ImageType;
+  typedef typename ImageType::PixelType          PixelType;
+  typedef typename ImageType::ConstPointer       ImageConstPointer;
+
+  typedef TMaskImage                             MaskImageType;
+  typedef typename MaskImageType::PixelType      MaskPixelType;
+  typedef typename MaskImageType::ConstPointer   MaskImageConstPointer;
+
+  typedef std::vector< double >                  QuantileListType;
+  typedef std::vector< double >                  QuantileValueListType;
+
+  /** Set/Get the image whose intensities are summarized. */
+  itkSetConstObjectMacro( Image, ImageType );
+  itkGetConstObjectMacro( Image, ImageType );
+
+  /** Set/Get an optional mask; only voxels with nonzero mask values are
+   *  considered. */
+  itkSetConstObjectMacro( Mask, MaskImageType );
+  itkGetConstObjectMacro( Mask, MaskImageType );
+
+  /** Set/Get the number of histogram bins used to locate the requested
+   *  ranks.  More bins mean fewer voxels to select from in the final
+   *  pass, at the cost of more memory per thread. */
+  itkSetClampMacro( NumberOfBins, unsigned int, 1,
+    NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( NumberOfBins, unsigned int );
+
+  /** Set/Get the requested quantiles; each must lie within [0, 1]. */
+  void SetQuantiles( const QuantileListType & quantiles );
+  const QuantileListType & GetQuantiles( void ) const;
+
+  /** Get the quantile values computed by the last call to Compute(). */
+  const QuantileValueListType & GetQuantileValues( void ) const;
+
+  /** Get the number of voxels considered by the last call to Compute(). */
+  itkGetConstMacro( NumberOfValues, SizeValueType );
+
+  /** Get the intensity range found by the last call to Compute(). */
+  itkGetConstMacro( Minimum, double );
+  itkGetConstMacro( Maximum, double );
+
+  /** Compute the quantiles.  Throws if no image is set, the mask does not
+   *  match the image, a quantile is outside [0, 1], or no voxel is
+   *  considered. */
+  void Compute( void );
+
+protected:
+  ImageQuantileCalculator( void );
+  virtual ~ImageQuantileCalculator( void ) {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+  ImageQuantileCalculator( const Self & ); // Purposely not implemented
+  void operator=( const Self & );          // Purposely not implemented
+
+  typedef std::vector< SizeValueType >           HistogramType;
+
+  enum PassType { RangePass, HistogramPass, CollectPass };
+
+  struct QuantileThreadStruct
+    {
+    const Self *                            Calculator;
+    PassType                                Pass;
+    std::vector< double >                   Minimum;
+    std::vector< double >                   Maximum;
+    std::vector< SizeValueType >            Count;
+    std::vector< HistogramType >            Histogram;
+    std::vector< std::vector< PixelType > > BinMinimum;
+    std::vector< std::vector< PixelType > > BinMaximum;
+    std::vector< int >                      BinSlot;
+    unsigned int                            NumberOfSlots;
+    std::vector< std::vector< PixelType > > Collected;
+    };
+
+  static ITK_THREAD_RETURN_TYPE QuantileThreaderCallback( void * arg );
+
+  void ThreadedPass( SizeValueType begin, SizeValueType end,
+    ThreadIdType threadId, QuantileThreadStruct * str ) const;
+
+  unsigned int ComputeBin( double value ) const;
+
+  ImageConstPointer        m_Image;
+  MaskImageConstPointer    m_Mask;
+
+  unsigned int             m_NumberOfBins;
+  QuantileListType         m_Quantiles;
+  QuantileValueListType    m_QuantileValues;
+
+  SizeValueType            m_NumberOfValues;
+  double                   m_Minimum;
+  double                   m_Maximum;
+  double                   m_BinScale;
+
+}; // End class ImageQuantileCalculator
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeImageQuantileCalculator.hxx"
+#endif
+
+#endif // End !defined(__itktubeImageQuantileCalculator_h)
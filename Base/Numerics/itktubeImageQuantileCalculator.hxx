@@ -0,0 +1,447 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeImageQuantileCalculator_hxx
+#define __itktubeImageQuantileCalculator_hxx
+
+#include "itktubeImageQuantileCalculator.h"
+
+#include <algorithm>
+#include <map>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< class TImage, class TMaskImage >
+ImageQuantileCalculator< TImage, TMaskImage >
+::ImageQuantileCalculator( void )
+{
+  m_Image = NULL;
+  m_Mask = NULL;
+
+  m_NumberOfBins = 65536;
+
+  m_NumberOfValues = 0;
+  m_Minimum = 0;
+  m_Maximum = 0;
+  m_BinScale = 0;
+}
+
+template< class TImage, class TMaskImage >
+void
+ImageQuantileCalculator< TImage, TMaskImage >
+::SetQuantiles( const QuantileListType & quantiles )
+{
+  m_Quantiles = quantiles;
+  this->Modified();
+}
+
+template< class TImage, class TMaskImage >
+const typename ImageQuantileCalculator< TImage, TMaskImage >::QuantileListType &
+ImageQuantileCalculator< TImage, TMaskImage >
+::GetQuantiles( void ) const
+{
+  return m_Quantiles;
+}
+
+template< class TImage, class TMaskImage >
+const typename ImageQuantileCalculator< TImage,
+  TMaskImage >::QuantileValueListType &
+ImageQuantileCalculator< TImage, TMaskImage >
+::GetQuantileValues( void ) const
+{
+  return m_QuantileValues;
+}
+
+template< class TImage, class TMaskImage >
+unsigned int
+ImageQuantileCalculator< TImage, TMaskImage >
+::ComputeBin( double value ) const
+{
+  const double bin = ( value - m_Minimum ) * m_BinScale;
+  if( bin >= m_NumberOfBins - 1 )
+    {
+    return m_NumberOfBins - 1;
+    }
+  return static_cast< unsigned int >( bin );
+}
+
+template< class TImage, class TMaskImage >
+void
+ImageQuantileCalculator< TImage, TMaskImage >
+::Compute( void )
+{
+  m_QuantileValues.clear();
+  m_NumberOfValues = 0;
+  m_BinScale = 0;
+
+  if( m_Image.IsNull() )
+    {
+    itkExceptionMacro( << "Image not set." );
+    }
+  if( m_Mask.IsNotNull() && m_Mask->GetBufferedRegion()
+    != m_Image->GetBufferedRegion() )
+    {
+    itkExceptionMacro( << "Mask buffered region does not match image." );
+    }
+  for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+    {
+    if( m_Quantiles[i] < 0 || m_Quantiles[i] > 1 )
+      {
+      itkExceptionMacro( << "Quantile " << m_Quantiles[i]
+        << " is outside [0, 1]." );
+      }
+    }
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  const ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+
+  QuantileThreadStruct str;
+  str.Calculator = this;
+  str.Minimum.resize( numberOfThreads );
+  str.Maximum.resize( numberOfThreads );
+  str.Count.assign( numberOfThreads, 0 );
+  str.NumberOfSlots = 0;
+
+  threader->SetSingleMethod( this->QuantileThreaderCallback, &str );
+
+  // Pass 1: intensity range and number of considered voxels
+  str.Pass = RangePass;
+  threader->SingleMethodExecute();
+
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+    {
+    if( str.Count[t] == 0 )
+      {
+      continue;
+      }
+    if( m_NumberOfValues == 0 || str.Minimum[t] < m_Minimum )
+      {
+      m_Minimum = str.Minimum[t];
+      }
+    if( m_NumberOfValues == 0 || str.Maximum[t] > m_Maximum )
+      {
+      m_Maximum = str.Maximum[t];
+      }
+    m_NumberOfValues += str.Count[t];
+    }
+  if( m_NumberOfValues == 0 )
+    {
+    itkExceptionMacro( << "No voxels to compute quantiles from." );
+    }
+
+  // Order statistics needed by each quantile, with interpolation weights
+  const SizeValueType lastRank = m_NumberOfValues - 1;
+  std::vector< SizeValueType > lowerRank( m_Quantiles.size() );
+  std::vector< SizeValueType > upperRank( m_Quantiles.size() );
+  std::vector< double >        upperWeight( m_Quantiles.size() );
+  for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+    {
+    const double h = m_Quantiles[i] * lastRank;
+    lowerRank[i] = std::min( static_cast< SizeValueType >( h ), lastRank );
+    upperRank[i] = std::min( lowerRank[i] + 1, lastRank );
+    upperWeight[i] = h - lowerRank[i];
+    }
+
+  std::map< SizeValueType, double > rankValue;
+  if( m_Maximum == m_Minimum )
+    {
+    for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+      {
+      rankValue[ lowerRank[i] ] = m_Minimum;
+      rankValue[ upperRank[i] ] = m_Minimum;
+      }
+    }
+  else
+    {
+    m_BinScale = m_NumberOfBins / ( m_Maximum - m_Minimum );
+
+    // Pass 2: per-thread histograms with the range of each bin, merged
+    str.Histogram.assign( numberOfThreads,
+      HistogramType( m_NumberOfBins, 0 ) );
+    str.BinMinimum.assign( numberOfThreads, std::vector< PixelType >(
+      m_NumberOfBins, NumericTraits< PixelType >::max() ) );
+    str.BinMaximum.assign( numberOfThreads, std::vector< PixelType >(
+      m_NumberOfBins, NumericTraits< PixelType >::NonpositiveMin() ) );
+    str.Pass = HistogramPass;
+    threader->SingleMethodExecute();
+
+    HistogramType cumulative( m_NumberOfBins, 0 );
+    std::vector< PixelType > binMinimum( str.BinMinimum[0] );
+    std::vector< PixelType > binMaximum( str.BinMaximum[0] );
+    SizeValueType total = 0;
+    for( unsigned int b = 0; b < m_NumberOfBins; ++b )
+      {
+      for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+        {
+        total += str.Histogram[t][b];
+        if( str.BinMinimum[t][b] < binMinimum[b] )
+          {
+          binMinimum[b] = str.BinMinimum[t][b];
+          }
+        if( str.BinMaximum[t][b] > binMaximum[b] )
+          {
+          binMaximum[b] = str.BinMaximum[t][b];
+          }
+        }
+      cumulative[b] = total;
+      }
+    str.Histogram.clear();
+    str.BinMinimum.clear();
+    str.BinMaximum.clear();
+
+    // Bins holding the needed ranks; cumulative[b] counts the voxels in
+    // bins 0 through b.  A rank in a single-valued bin, or at either end
+    // of its bin, is given by the bin range, so only the remaining bins
+    // are collected.
+    std::map< SizeValueType, unsigned int > rankBin;
+    str.BinSlot.assign( m_NumberOfBins, -1 );
+    std::vector< unsigned int > slotBin;
+    for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+      {
+      const SizeValueType ranks[2] = { lowerRank[i], upperRank[i] };
+      for( unsigned int r = 0; r < 2; ++r )
+        {
+        const unsigned int bin = static_cast< unsigned int >(
+          std::upper_bound( cumulative.begin(), cumulative.end(),
+            ranks[r] ) - cumulative.begin() );
+        const SizeValueType binStart = ( bin > 0 ) ? cumulative[bin - 1] : 0;
+        if( binMinimum[bin] == binMaximum[bin] || ranks[r] == binStart )
+          {
+          rankValue[ ranks[r] ] = static_cast< double >( binMinimum[bin] );
+          continue;
+          }
+        if( ranks[r] + 1 == cumulative[bin] )
+          {
+          rankValue[ ranks[r] ] = static_cast< double >( binMaximum[bin] );
+          continue;
+          }
+        rankBin[ ranks[r] ] = bin;
+        if( str.BinSlot[bin] < 0 )
+          {
+          str.BinSlot[bin] = static_cast< int >( slotBin.size() );
+          slotBin.push_back( bin );
+          }
+        }
+      }
+    str.NumberOfSlots = static_cast< unsigned int >( slotBin.size() );
+
+    // Pass 3: collect the voxels of those bins only
+    if( str.NumberOfSlots > 0 )
+      {
+      str.Collected.assign( numberOfThreads * str.NumberOfSlots,
+        std::vector< PixelType >() );
+      str.Pass = CollectPass;
+      threader->SingleMethodExecute();
+      }
+
+    std::vector< PixelType > values;
+    for( unsigned int slot = 0; slot < str.NumberOfSlots; ++slot )
+      {
+      const unsigned int bin = slotBin[slot];
+      const SizeValueType binStart = ( bin > 0 ) ? cumulative[bin - 1] : 0;
+
+      values.clear();
+      values.reserve( cumulative[bin] - binStart );
+      for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+        {
+        std::vector< PixelType > & collected =
+          str.Collected[t * str.NumberOfSlots + slot];
+        values.insert( values.end(), collected.begin(), collected.end() );
+        std::vector< PixelType >().swap( collected );
+        }
+
+      typename std::map< SizeValueType, unsigned int >::const_iterator
+        rankIt = rankBin.begin();
+      for( ; rankIt != rankBin.end(); ++rankIt )
+        {
+        if( rankIt->second != bin )
+          {
+          continue;
+          }
+        typename std::vector< PixelType >::iterator nth = values.begin()
+          + ( rankIt->first - binStart );
+        std::nth_element( values.begin(), nth, values.end() );
+        rankValue[ rankIt->first ] = static_cast< double >( *nth );
+        }
+      }
+    str.Collected.clear();
+    }
+
+  m_QuantileValues.resize( m_Quantiles.size() );
+  for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+    {
+    const double lower = rankValue[ lowerRank[i] ];
+    const double upper = rankValue[ upperRank[i] ];
+    m_QuantileValues[i] = lower + upperWeight[i] * ( upper - lower );
+    }
+}
+
+template< class TImage, class TMaskImage >
+ITK_THREAD_RETURN_TYPE
+ImageQuantileCalculator< TImage, TMaskImage >
+::QuantileThreaderCallback( void * arg )
+{
+  ThreadIdType threadId =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->ThreadID;
+  ThreadIdType numberOfThreads =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->NumberOfThreads;
+  QuantileThreadStruct * str = ( QuantileThreadStruct * )
+    ( ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->UserData );
+
+  const SizeValueType numberOfPixels =
+    str->Calculator->m_Image->GetBufferedRegion().GetNumberOfPixels();
+  const SizeValueType pixelsPerThread =
+    ( numberOfPixels + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = threadId * pixelsPerThread;
+  if( begin < numberOfPixels )
+    {
+    str->Calculator->ThreadedPass( begin,
+      std::min( begin + pixelsPerThread, numberOfPixels ), threadId, str );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage, class TMaskImage >
+void
+ImageQuantileCalculator< TImage, TMaskImage >
+::ThreadedPass( SizeValueType begin, SizeValueType end,
+  ThreadIdType threadId, QuantileThreadStruct * str ) const
+{
+  const PixelType * image = m_Image->GetBufferPointer();
+  const MaskPixelType * mask = m_Mask.IsNotNull()
+    ? m_Mask->GetBufferPointer() : NULL;
+
+  switch( str->Pass )
+    {
+    case RangePass:
+      {
+      double minimum = 0;
+      double maximum = 0;
+      SizeValueType count = 0;
+      for( SizeValueType i = begin; i < end; ++i )
+        {
+        if( mask && mask[i] == 0 )
+          {
+          continue;
+          }
+        const double value = static_cast< double >( image[i] );
+        if( count == 0 || value < minimum )
+          {
+          minimum = value;
+          }
+        if( count == 0 || value > maximum )
+          {
+          maximum = value;
+          }
+        ++count;
+        }
+      str->Minimum[threadId] = minimum;
+      str->Maximum[threadId] = maximum;
+      str->Count[threadId] = count;
+      break;
+      }
+    case HistogramPass:
+      {
+      HistogramType & histogram = str->Histogram[threadId];
+      std::vector< PixelType > & binMinimum = str->BinMinimum[threadId];
+      std::vector< PixelType > & binMaximum = str->BinMaximum[threadId];
+      for( SizeValueType i = begin; i < end; ++i )
+        {
+        if( mask && mask[i] == 0 )
+          {
+          continue;
+          }
+        const unsigned int bin =
+          this->ComputeBin( static_cast< double >( image[i] ) );
+        ++histogram[bin];
+        if( image[i] < binMinimum[bin] )
+          {
+          binMinimum[bin] = image[i];
+          }
+        if( image[i] > binMaximum[bin] )
+          {
+          binMaximum[bin] = image[i];
+          }
+        }
+      break;
+      }
+    case CollectPass:
+      {
+      std::vector< PixelType > * collected =
+        &( str->Collected[threadId * str->NumberOfSlots] );
+      for( SizeValueType i = begin; i < end; ++i )
+        {
+        if( mask && mask[i] == 0 )
+          {
+          continue;
+          }
+        const int slot = str->BinSlot[
+          this->ComputeBin( static_cast< double >( image[i] ) ) ];
+        if( slot >= 0 )
+          {
+          collected[slot].push_back( image[i] );
+          }
+        }
+      break;
+      }
+    }
+}
+
+template< class TImage, class TMaskImage >
+void
+ImageQuantileCalculator< TImage, TMaskImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Image: " << m_Image.GetPointer() << std::endl;
+  os << indent << "Mask: " << m_Mask.GetPointer() << std::endl;
+  os << indent << "NumberOfBins: " << m_NumberOfBins << std::endl;
+  os << indent << "Quantiles:";
+  for( unsigned int i = 0; i < m_Quantiles.size(); ++i )
+    {
+    os << " " << m_Quantiles[i];
+    }
+  os << std::endl;
+  os << indent << "QuantileValues:";
+  for( unsigned int i = 0; i < m_QuantileValues.size(); ++i )
+    {
+    os << " " << m_QuantileValues[i];
+    }
+  os << std::endl;
+  os << indent << "NumberOfValues: " << m_NumberOfValues << std::endl;
+  os << indent << "Minimum: " << m_Minimum << std::endl;
+  os << indent << "Maximum: " << m_Maximum << std::endl;
+  os << indent << "BinScale: " << m_BinScale << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeImageQuantileCalculator_hxx)
@@ -25,13 +25,18 @@ limitations under the License.
 #define __itktubeImageRegionMomentsCalculator_h
 
 #include <itkAffineTransform.h>
+#include <itkCompensatedSummation.h>
 #include <itkImage.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
 #include <itkSpatialObject.h>
 
 #include <vnl/vnl_diag_matrix.h>
 #include <vnl/vnl_matrix_fixed.h>
 #include <vnl/vnl_vector_fixed.h>
 
+#include <vector>
+
 namespace itk
 {
 
@@ -61,6 +66,14 @@ namespace tube
  * computing the moments and doing so simplifies memory management for
  * the caller.
  *
+ * The image is split among threads, each accumulating partial sums with
+ * compensated summation.  The moments are remembered, for all calculators
+ * of the same image type, per image, image modification time, requested
+ * region, mask and region of interest: computing them again for an
+ * unchanged image returns the remembered values.  An image whose buffer is
+ * edited in place must be marked Modified() for its moments to be
+ * recomputed.
+ *
  * \ingroup Operators
  *
  * \todo It's not yet clear how multi-echo images should be handled here.
@@ -164,6 +177,19 @@ public:
   itkGetMacro( RegionOfInterestPoint1, PointType );
   itkGetMacro( RegionOfInterestPoint2, PointType );
 
+  /** Set/Get the number of threads used to compute the moments.  Defaults
+   * to the global default number of threads. */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Whether the last call to Compute() reused remembered moments. */
+  itkGetConstMacro( MomentsFromCache, bool );
+
+  /** Forget the moments remembered for all images of this type.  The
+   * cache holds the last few images and masks it has seen; this also
+   * releases them. */
+  static void ClearMomentsCache( void );
+
   /** Compute moments of a new or modified image.
    * This method computes the moments of the image given as a
    * parameter and stores them in the object.  The values of these
@@ -261,6 +287,66 @@ private:
   ImageConstPointer         m_Image;
   SpatialObjectConstPointer m_SpatialObjectMask;
 
+  ThreadIdType              m_NumberOfThreads;
+  bool                      m_MomentsFromCache;
+
+  typedef CompensatedSummation< ScalarType >  SummationType;
+
+  /** Raw sums of one thread; only the upper triangles of the second
+   * order sums are accumulated. */
+  struct MomentSums
+    {
+    SummationType M0;
+    SummationType M1[ImageDimension];
+    SummationType M2[ImageDimension][ImageDimension];
+    SummationType Cg[ImageDimension];
+    SummationType Cm[ImageDimension][ImageDimension];
+    };
+
+  struct MomentsThreadStruct
+    {
+    const Self *               Calculator;
+    std::vector< MomentSums >  Sums;
+    };
+
+  static ITK_THREAD_RETURN_TYPE MomentsThreaderCallback( void * arg );
+
+  void ThreadedCompute( const typename ImageType::RegionType & region,
+    MomentSums & sums ) const;
+
+  /** Moments remembered for one image.  The entry holds the image and
+   * the mask, so that their addresses cannot be reused by other objects
+   * while it is cached. */
+  struct MomentsCacheEntry
+    {
+    ImageConstPointer                  Image;
+    unsigned long                      ImageMTime;
+    typename ImageType::RegionType     Region;
+    SpatialObjectConstPointer          Mask;
+    unsigned long                      MaskMTime;
+    unsigned long                      MaskTransformMTime;
+    bool                               UseRegionOfInterest;
+    PointType                          RegionOfInterestPoint1;
+    PointType                          RegionOfInterestPoint2;
+    ScalarType                         M0;
+    VectorType                         M1;
+    MatrixType                         M2;
+    VectorType                         Cg;
+    MatrixType                         Cm;
+    VectorType                         Pm;
+    MatrixType                         Pa;
+    };
+
+  typedef std::vector< MomentsCacheEntry >   MomentsCacheType;
+
+  static MomentsCacheType & GetMomentsCache( void );
+  static SimpleFastMutexLock & GetMomentsCacheLock( void );
+
+  /** Fill the key of the cache entry of the current inputs */
+  void GetMomentsCacheKey( MomentsCacheEntry & entry ) const;
+  static bool IsSameMomentsCacheKey( const MomentsCacheEntry & entry1,
+    const MomentsCacheEntry & entry2 );
+
 }; // End class ImageRegionMomentsCalculator
 
 } // End namespace tube
@@ -27,10 +27,13 @@ limitations under the License.
 #include "itktubeImageRegionMomentsCalculator.h"
 
 #include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkMutexLockHolder.h>
 
 #include <vnl/algo/vnl_real_eigensystem.h>
 #include <vnl/algo/vnl_symmetric_eigensystem.h>
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -77,6 +80,8 @@ ImageRegionMomentsCalculator<TImage>::ImageRegionMomentsCalculator( void )
   m_UseRegionOfInterest = false;
   m_RegionOfInterestPoint1.Fill( 0 );
   m_RegionOfInterestPoint2.Fill( 0 );
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_MomentsFromCache = false;
 }
 
 //----------------------------------------------------------------------
@@ -105,6 +110,8 @@ ImageRegionMomentsCalculator<TInputImage>
   os << indent << "Use RegionOfInterest : " << m_UseRegionOfInterest << std::endl;
   os << indent << "RegionOfInterest Point1: " << m_RegionOfInterestPoint1 << std::endl;
   os << indent << "RegionOfInterest Point2: " << m_RegionOfInterestPoint2 << std::endl;
+  os << indent << "Number of threads: " << m_NumberOfThreads << std::endl;
+  os << indent << "Moments from cache: " << m_MomentsFromCache << std::endl;
 }
 
 //----------------------------------------------------------------------
@@ -120,71 +127,81 @@ Compute( void )
   m_Cg.Fill( NumericTraits<typename VectorType::ValueType>::Zero );
   m_Cm.Fill( NumericTraits<typename MatrixType::ValueType>::Zero );
 
-  typedef typename ImageType::IndexType IndexType;
+  m_MomentsFromCache = false;
 
   if( !m_Image )
     {
     return;
     }
 
-  ImageRegionConstIteratorWithIndex< ImageType > it( m_Image,
-                                                     m_Image->GetRequestedRegion() );
-
-  while( !it.IsAtEnd() )
+  MomentsCacheEntry entry;
+  this->GetMomentsCacheKey( entry );
+  if( entry.ImageMTime > 0 )
     {
-    double value = it.Value();
-
-    IndexType indexPosition = it.GetIndex();
-
-    Point<double, ImageDimension> physicalPosition;
-    m_Image->TransformIndexToPhysicalPoint( indexPosition, physicalPosition );
-
-    bool isInsideRegionOfInterest = true;
-    if( m_UseRegionOfInterest )
+    MutexLockHolder< SimpleFastMutexLock > holder( GetMomentsCacheLock() );
+    const MomentsCacheType & cache = GetMomentsCache();
+    for( typename MomentsCacheType::const_iterator it = cache.begin();
+      it != cache.end(); ++it )
       {
-      for( unsigned int i=0; i<ImageDimension; i++ )
+      if( IsSameMomentsCacheKey( *it, entry ) )
         {
-        if( !( ( physicalPosition[i]<=m_RegionOfInterestPoint1[i]
-               && physicalPosition[i]>=m_RegionOfInterestPoint2[i] )
-              || ( physicalPosition[i]<=m_RegionOfInterestPoint2[i]
-                  && physicalPosition[i]>=m_RegionOfInterestPoint1[i] ) ) )
-          {
-          isInsideRegionOfInterest = false;
-          break;
-          }
+        m_M0 = it->M0;
+        m_M1 = it->M1;
+        m_M2 = it->M2;
+        m_Cg = it->Cg;
+        m_Cm = it->Cm;
+        m_Pm = it->Pm;
+        m_Pa = it->Pa;
+        m_MomentsFromCache = true;
+        m_Valid = true;
+        return;
         }
       }
+    }
 
-    if( isInsideRegionOfInterest &&
-        ( m_SpatialObjectMask.IsNull()
-         || m_SpatialObjectMask->IsInside( physicalPosition ) ) )
+  // Accumulate the raw sums in parallel
+  MomentsThreadStruct str;
+  str.Calculator = this;
+  str.Sums.resize( m_NumberOfThreads );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( m_NumberOfThreads );
+  threader->SetSingleMethod( this->MomentsThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  SummationType m0;
+  SummationType m1[ImageDimension];
+  SummationType m2[ImageDimension][ImageDimension];
+  SummationType cg[ImageDimension];
+  SummationType cm[ImageDimension][ImageDimension];
+  for( ThreadIdType t = 0; t < m_NumberOfThreads; ++t )
+    {
+    const MomentSums & sums = str.Sums[t];
+    m0 += sums.M0.GetSum();
+    for( unsigned int i=0; i<ImageDimension; i++ )
       {
-      m_M0 += value;
-
-      for( unsigned int i=0; i<ImageDimension; i++ )
+      m1[i] += sums.M1[i].GetSum();
+      cg[i] += sums.Cg[i].GetSum();
+      for( unsigned int j=i; j<ImageDimension; j++ )
         {
-        m_M1[i] += static_cast<double>( indexPosition[i] ) * value;
-        for( unsigned int j=0; j<ImageDimension; j++ )
-          {
-          double weight = value * static_cast<double>( indexPosition[i] ) *
-            static_cast<double>( indexPosition[j] );
-          m_M2[i][j] += weight;
-          }
-        }
-
-      for( unsigned int i=0; i<ImageDimension; i++ )
-        {
-        m_Cg[i] += physicalPosition[i] * value;
-        for( unsigned int j=0; j<ImageDimension; j++ )
-          {
-          double weight = value * physicalPosition[i] * physicalPosition[j];
-          m_Cm[i][j] += weight;
-          }
-
+        m2[i][j] += sums.M2[i][j].GetSum();
+        cm[i][j] += sums.Cm[i][j].GetSum();
         }
       }
+    }
 
-    ++it;
+  m_M0 = m0.GetSum();
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    m_M1[i] = m1[i].GetSum();
+    m_Cg[i] = cg[i].GetSum();
+    for( unsigned int j=i; j<ImageDimension; j++ )
+      {
+      m_M2[i][j] = m2[i][j].GetSum();
+      m_M2[j][i] = m_M2[i][j];
+      m_Cm[i][j] = cm[i][j].GetSum();
+      m_Cm[j][i] = m_Cm[i][j];
+      }
     }
 
   // Throw an error if the total mass is zero
@@ -245,6 +262,210 @@ Compute( void )
   /* Remember that the moments are valid */
   m_Valid = 1;
 
+  if( entry.ImageMTime > 0 )
+    {
+    entry.M0 = m_M0;
+    entry.M1 = m_M1;
+    entry.M2 = m_M2;
+    entry.Cg = m_Cg;
+    entry.Cm = m_Cm;
+    entry.Pm = m_Pm;
+    entry.Pa = m_Pa;
+
+    // Only the most recent images are remembered.  Entries of earlier
+    // versions of this image can no longer match, so they are dropped.
+    const unsigned int maximumNumberOfEntries = 8;
+    MutexLockHolder< SimpleFastMutexLock > holder( GetMomentsCacheLock() );
+    MomentsCacheType & cache = GetMomentsCache();
+    typename MomentsCacheType::iterator it = cache.begin();
+    while( it != cache.end() )
+      {
+      if( it->Image == entry.Image && it->ImageMTime < entry.ImageMTime )
+        {
+        it = cache.erase( it );
+        }
+      else
+        {
+        ++it;
+        }
+      }
+    if( cache.size() >= maximumNumberOfEntries )
+      {
+      cache.erase( cache.begin() );
+      }
+    cache.push_back( entry );
+    }
+}
+
+
+//----------------------------------------------------------------------
+// Split the requested region among the threads along its last axis
+template< class TImage >
+ITK_THREAD_RETURN_TYPE
+ImageRegionMomentsCalculator<TImage>::
+MomentsThreaderCallback( void * arg )
+{
+  ThreadIdType threadId =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->ThreadID;
+  ThreadIdType numberOfThreads =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->NumberOfThreads;
+  MomentsThreadStruct * str = ( MomentsThreadStruct * )
+    ( ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->UserData );
+
+  typename ImageType::RegionType region =
+    str->Calculator->m_Image->GetRequestedRegion();
+  const SizeValueType numberOfSlices = region.GetSize( ImageDimension-1 );
+  const SizeValueType begin = numberOfSlices * threadId / numberOfThreads;
+  const SizeValueType end = numberOfSlices * ( threadId+1 ) / numberOfThreads;
+  if( begin < end )
+    {
+    region.SetIndex( ImageDimension-1,
+      region.GetIndex( ImageDimension-1 ) + begin );
+    region.SetSize( ImageDimension-1, end - begin );
+    str->Calculator->ThreadedCompute( region, str->Sums[threadId] );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+//----------------------------------------------------------------------
+// Accumulate the raw sums of a region
+template< class TImage >
+void
+ImageRegionMomentsCalculator<TImage>::
+ThreadedCompute( const typename ImageType::RegionType & region,
+  MomentSums & sums ) const
+{
+  typedef typename ImageType::IndexType IndexType;
+
+  ImageRegionConstIteratorWithIndex< ImageType > it( m_Image, region );
+
+  while( !it.IsAtEnd() )
+    {
+    double value = it.Value();
+
+    IndexType indexPosition = it.GetIndex();
+
+    Point<double, ImageDimension> physicalPosition;
+    m_Image->TransformIndexToPhysicalPoint( indexPosition, physicalPosition );
+
+    bool isInsideRegionOfInterest = true;
+    if( m_UseRegionOfInterest )
+      {
+      for( unsigned int i=0; i<ImageDimension; i++ )
+        {
+        if( !( ( physicalPosition[i]<=m_RegionOfInterestPoint1[i]
+               && physicalPosition[i]>=m_RegionOfInterestPoint2[i] )
+              || ( physicalPosition[i]<=m_RegionOfInterestPoint2[i]
+                  && physicalPosition[i]>=m_RegionOfInterestPoint1[i] ) ) )
+          {
+          isInsideRegionOfInterest = false;
+          break;
+          }
+        }
+      }
+
+    if( isInsideRegionOfInterest &&
+        ( m_SpatialObjectMask.IsNull()
+         || m_SpatialObjectMask->IsInside( physicalPosition ) ) )
+      {
+      sums.M0 += value;
+
+      for( unsigned int i=0; i<ImageDimension; i++ )
+        {
+        const double indexValue = static_cast<double>( indexPosition[i] )
+          * value;
+        sums.M1[i] += indexValue;
+        sums.Cg[i] += physicalPosition[i] * value;
+        for( unsigned int j=i; j<ImageDimension; j++ )
+          {
+          sums.M2[i][j] += indexValue
+            * static_cast<double>( indexPosition[j] );
+          sums.Cm[i][j] += value * physicalPosition[i]
+            * physicalPosition[j];
+          }
+        }
+      }
+
+    ++it;
+    }
+}
+
+
+//----------------------------------------------------------------------
+// Cache of the moments shared by all calculators of the image type
+template< class TImage >
+typename ImageRegionMomentsCalculator<TImage>::MomentsCacheType &
+ImageRegionMomentsCalculator<TImage>::
+GetMomentsCache( void )
+{
+  static MomentsCacheType cache;
+  return cache;
+}
+
+template< class TImage >
+SimpleFastMutexLock &
+ImageRegionMomentsCalculator<TImage>::
+GetMomentsCacheLock( void )
+{
+  static SimpleFastMutexLock lock;
+  return lock;
+}
+
+template< class TImage >
+void
+ImageRegionMomentsCalculator<TImage>::
+ClearMomentsCache( void )
+{
+  MutexLockHolder< SimpleFastMutexLock > holder( GetMomentsCacheLock() );
+  GetMomentsCache().clear();
+}
+
+template< class TImage >
+void
+ImageRegionMomentsCalculator<TImage>::
+GetMomentsCacheKey( MomentsCacheEntry & entry ) const
+{
+  entry.Image = m_Image;
+  entry.ImageMTime = m_Image->GetMTime();
+  entry.Region = m_Image->GetRequestedRegion();
+  entry.Mask = m_SpatialObjectMask;
+  entry.MaskMTime = 0;
+  entry.MaskTransformMTime = 0;
+  if( m_SpatialObjectMask.IsNotNull() )
+    {
+    entry.MaskMTime = m_SpatialObjectMask->GetMTime();
+    // Moving the mask modifies its transforms, not the mask itself
+    entry.MaskTransformMTime = std::max(
+      m_SpatialObjectMask->GetObjectToWorldTransform()->GetMTime(),
+      m_SpatialObjectMask->GetIndexToWorldTransform()->GetMTime() );
+    }
+  entry.UseRegionOfInterest = m_UseRegionOfInterest;
+  entry.RegionOfInterestPoint1 = m_RegionOfInterestPoint1;
+  entry.RegionOfInterestPoint2 = m_RegionOfInterestPoint2;
+}
+
+template< class TImage >
+bool
+ImageRegionMomentsCalculator<TImage>::
+IsSameMomentsCacheKey( const MomentsCacheEntry & entry1,
+  const MomentsCacheEntry & entry2 )
+{
+  if( entry1.Image != entry2.Image
+    || entry1.ImageMTime != entry2.ImageMTime
+    || entry1.Region != entry2.Region
+    || entry1.Mask != entry2.Mask
+    || entry1.MaskMTime != entry2.MaskMTime
+    || entry1.MaskTransformMTime != entry2.MaskTransformMTime
+    || entry1.UseRegionOfInterest != entry2.UseRegionOfInterest )
+    {
+    return false;
+    }
+  // The region of interest only matters when it is used.
+  return !entry1.UseRegionOfInterest
+    || ( entry1.RegionOfInterestPoint1 == entry2.RegionOfInterestPoint1
+      && entry1.RegionOfInterestPoint2 == entry2.RegionOfInterestPoint2 );
 }
 
 
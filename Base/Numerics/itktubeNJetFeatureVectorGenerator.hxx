@@ -145,6 +145,15 @@ NJetFeatureVectorGenerator< TImage >
   return featureVector;
 }
 
+template< class TImage >
+void
+NJetFeatureVectorGenerator< TImage >
+::GenerateFeatureVectors( SizeValueType startVoxel, SizeValueType endVoxel,
+  FeatureValueType * buffer ) const
+{
+  this->GenerateFeatureVectorsAtIndices( startVoxel, endVoxel, buffer );
+}
+
 template< class TImage >
 typename NJetFeatureVectorGenerator< TImage >::FeatureValueType
 NJetFeatureVectorGenerator< TImage >
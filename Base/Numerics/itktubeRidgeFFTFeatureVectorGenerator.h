@@ -27,6 +27,7 @@ limitations under the License.
 #include "itktubeFeatureVectorGenerator.h"
 
 #include <itkImage.h>
+#include <itkMultiThreader.h>
 
 #include <vnl/vnl_matrix.h>
 #include <vnl/vnl_vector.h>
@@ -89,11 +90,21 @@ public:
   virtual typename FeatureImageType::Pointer GetFeatureImage(
     unsigned int fNum ) const;
 
+  virtual void GenerateFeatureVectors( SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
   void GenerateData( void );
 
   itkSetMacro( UseIntensityOnly, bool );
   itkGetMacro( UseIntensityOnly, bool );
 
+  typedef typename FeatureImageType::SizeType        SizeType;
+
+  /** Block size used by the underlying RidgeFFTFilter; zero disables
+   *  tiling. */
+  itkSetMacro( TileSize, SizeType );
+  itkGetConstReferenceMacro( TileSize, SizeType );
+
 protected:
 
   RidgeFFTFeatureVectorGenerator( void );
@@ -101,6 +112,23 @@ protected:
 
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  /** Fills the trailing max-over-scales features and the scale of the
+   *  maximum of feature scaleFeature, splitting the voxels among threads */
+  void ComputeMaximumOverScales( unsigned int scaleFeature );
+
+  void ThreadedComputeMaximumOverScales( unsigned int scaleFeature,
+    SizeValueType start, SizeValueType end );
+
+  struct ComputeMaximumOverScalesThreadStruct
+    {
+    Self *              Generator;
+    unsigned int        ScaleFeature;
+    SizeValueType       NumberOfVoxels;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ComputeMaximumOverScalesThreaderCallback(
+    void * arg );
+
 private:
 
   // Purposely not implemented
@@ -113,6 +141,8 @@ private:
 
   bool                               m_UseIntensityOnly;
 
+  SizeType                           m_TileSize;
+
 }; // End class RidgeFFTFeatureVectorGenerator
 
 } // End namespace tube
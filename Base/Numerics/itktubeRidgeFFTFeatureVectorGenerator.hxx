@@ -29,6 +29,7 @@ limitations under the License.
 #include "tubeMatrixMath.h"
 
 #include <itkImage.h>
+#include <itkMultiThreader.h>
 #include <itkProgressReporter.h>
 #include <itkTimeProbesCollectorBase.h>
 
@@ -45,6 +46,7 @@ RidgeFFTFeatureVectorGenerator< TImage >
 ::RidgeFFTFeatureVectorGenerator( void )
 {
   m_UseIntensityOnly = false;
+  m_TileSize.Fill( 0 );
   m_Scales.resize( 0 );
   m_FeatureImageList.resize( 0 );
 }
@@ -76,9 +78,12 @@ void
 RidgeFFTFeatureVectorGenerator< TImage >
 ::GenerateData( void )
 {
+  // A single filter is reused for all scales so that the forward FFT of
+  //   the input is computed once and shared by every scale.
   typedef RidgeFFTFilter< TImage > RidgeFilterType;
   typename RidgeFilterType::Pointer ridgeF = RidgeFilterType::New();
   ridgeF->SetInput( this->m_InputImageList[0] );
+  ridgeF->SetTileSize( m_TileSize );
 
   const unsigned int numFeatures = this->GetNumberOfFeatures();
 
@@ -118,41 +123,7 @@ RidgeFFTFeatureVectorGenerator< TImage >
       ++feat;
       }
   
-    typedef ImageRegionIterator< FeatureImageType >  IterType;
-    std::vector< IterType > iterF( numFeatures );
-    for( unsigned int f=0; f<numFeatures; ++f )
-      {
-      iterF[f] = IterType( m_FeatureImageList[f], region );
-      }
-    unsigned int foScale = numFeatures - numFeaturesPerScale - 1;
-    unsigned int foFeat = numFeatures - numFeaturesPerScale;
-    while( !iterF[0].IsAtEnd() )
-      {
-      for( unsigned int f=0; f<numFeaturesPerScale; ++f )
-        {
-        iterF[ foFeat + f ].Set( iterF[ f ].Get() );
-        }
-      iterF[ foScale ].Set( m_Scales[ 0 ] );
-      for( unsigned int s=1; s<m_Scales.size(); ++s )
-        {
-        feat = s * numFeaturesPerScale;
-        for( unsigned int f=0; f<numFeaturesPerScale; ++f )
-          {
-          if( iterF[ feat + f ].Get() > iterF[ foFeat + f ].Get() )
-            {
-            iterF[ foFeat + f ].Set( iterF[ feat + f ].Get() );
-            if( f == 0 )
-              {
-              iterF[ foScale ].Set( m_Scales[ s ] );
-              }
-            }
-          }
-        }
-      for( unsigned int f=0; f<numFeatures; ++f )
-        {
-        ++iterF[ f ];
-        }
-      }
+    this->ComputeMaximumOverScales( 0 );
     }
   else
     {
@@ -221,39 +192,110 @@ RidgeFFTFeatureVectorGenerator< TImage >
       ++feat;
       }
   
-    std::vector< IterType > iterF( numFeatures );
-    for( unsigned int f=0; f<numFeatures; ++f )
+    this->ComputeMaximumOverScales( 1 );
+    }
+}
+
+template< class TImage >
+void
+RidgeFFTFeatureVectorGenerator< TImage >
+::ComputeMaximumOverScales( unsigned int scaleFeature )
+{
+  ComputeMaximumOverScalesThreadStruct str;
+  str.Generator = this;
+  str.ScaleFeature = scaleFeature;
+  str.NumberOfVoxels = m_FeatureImageList[0]->GetLargestPossibleRegion()
+    .GetNumberOfPixels();
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetSingleMethod( this->ComputeMaximumOverScalesThreaderCallback,
+    &str );
+  threader->SingleMethodExecute();
+
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+  for( unsigned int f=0; f<numFeatures; ++f )
+    {
+    m_FeatureImageList[f]->Modified();
+    }
+}
+
+template< class TImage >
+ITK_THREAD_RETURN_TYPE
+RidgeFFTFeatureVectorGenerator< TImage >
+::ComputeMaximumOverScalesThreaderCallback( void * arg )
+{
+  const SizeValueType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const SizeValueType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  ComputeMaximumOverScalesThreadStruct * str =
+    (ComputeMaximumOverScalesThreadStruct *)
+      (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  const SizeValueType voxelsPerThread =
+    ( str->NumberOfVoxels + threadCount - 1 ) / threadCount;
+  const SizeValueType start = threadId * voxelsPerThread;
+  if( start < str->NumberOfVoxels )
+    {
+    SizeValueType end = start + voxelsPerThread;
+    if( end > str->NumberOfVoxels )
       {
-      iterF[f] = IterType( m_FeatureImageList[f], region );
+      end = str->NumberOfVoxels;
       }
-    unsigned int foScale = numFeatures - numFeaturesPerScale - 1;
-    unsigned int foFeat = numFeatures - numFeaturesPerScale;
-    while( !iterF[0].IsAtEnd() )
+    str->Generator->ThreadedComputeMaximumOverScales( str->ScaleFeature,
+      start, end );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage >
+void
+RidgeFFTFeatureVectorGenerator< TImage >
+::ThreadedComputeMaximumOverScales( unsigned int scaleFeature,
+  SizeValueType start, SizeValueType end )
+{
+  // All feature images share one region, so their buffers are walked in
+  //   lockstep.
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+
+  unsigned int numFeaturesPerScale = 5;
+  if( m_UseIntensityOnly )
+    {
+    numFeaturesPerScale = 2;
+    }
+
+  std::vector< FeatureValueType * > buffer( numFeatures );
+  for( unsigned int f=0; f<numFeatures; ++f )
+    {
+    buffer[f] = m_FeatureImageList[f]->GetBufferPointer();
+    }
+
+  const unsigned int foScale = numFeatures - numFeaturesPerScale - 1;
+  const unsigned int foFeat = numFeatures - numFeaturesPerScale;
+  const unsigned int numScales = m_Scales.size();
+  for( SizeValueType v=start; v<end; ++v )
+    {
+    for( unsigned int f=0; f<numFeaturesPerScale; ++f )
       {
+      buffer[ foFeat + f ][v] = buffer[ f ][v];
+      }
+    buffer[ foScale ][v] = m_Scales[ 0 ];
+    for( unsigned int s=1; s<numScales; ++s )
+      {
+      const unsigned int feat = s * numFeaturesPerScale;
       for( unsigned int f=0; f<numFeaturesPerScale; ++f )
         {
-        iterF[ foFeat + f ].Set( iterF[ f ].Get() );
-        }
-      iterF[ foScale ].Set( m_Scales[ 0 ] );
-      for( unsigned int s=1; s<m_Scales.size(); ++s )
-        {
-        feat = s * numFeaturesPerScale;
-        for( unsigned int f=0; f<numFeaturesPerScale; ++f )
+        if( buffer[ feat + f ][v] > buffer[ foFeat + f ][v] )
           {
-          if( iterF[ feat + f ].Get() > iterF[ foFeat + f ].Get() )
+          buffer[ foFeat + f ][v] = buffer[ feat + f ][v];
+          if( f == scaleFeature )
             {
-            iterF[ foFeat + f ].Set( iterF[ feat + f ].Get() );
-            if( f == 1 )
-              {
-              iterF[ foScale ].Set( m_Scales[ s ] );
-              }
+            buffer[ foScale ][v] = m_Scales[ s ];
             }
           }
         }
-      for( unsigned int f=0; f<numFeatures; ++f )
-        {
-        ++iterF[ f ];
-        }
       }
     }
 }
@@ -283,6 +325,27 @@ RidgeFFTFeatureVectorGenerator< TImage >
   return this->m_FeatureImageList[ fNum ]->GetPixel( indx );
 }
 
+template< class TImage >
+void
+RidgeFFTFeatureVectorGenerator< TImage >
+::GenerateFeatureVectors( SizeValueType startVoxel, SizeValueType endVoxel,
+  FeatureValueType * buffer ) const
+{
+  const unsigned int numFeatures = this->GetNumberOfFeatures();
+
+  for( unsigned int f=0; f<numFeatures; ++f )
+    {
+    const FeatureValueType * featureBuffer =
+      m_FeatureImageList[f]->GetBufferPointer();
+    FeatureValueType * outputBuffer = buffer + f;
+    for( SizeValueType v=startVoxel; v<endVoxel; ++v )
+      {
+      *outputBuffer = featureBuffer[v];
+      outputBuffer += numFeatures;
+      }
+    }
+}
+
 template< class TImage >
 typename RidgeFFTFeatureVectorGenerator< TImage >::FeatureImageType::Pointer
 RidgeFFTFeatureVectorGenerator< TImage >
@@ -315,6 +378,8 @@ RidgeFFTFeatureVectorGenerator< TImage >
   Superclass::PrintSelf( os, indent );
 
   os << indent << "Scales.size() = " << m_Scales.size() << std::endl;
+  os << indent << "UseIntensityOnly = " << m_UseIntensityOnly << std::endl;
+  os << indent << "TileSize = " << m_TileSize << std::endl;
 }
 
 } // End namespace tube
@@ -81,6 +81,9 @@ public:
   virtual FeatureValueType GetFeatureVectorValue( const IndexType & indx,
     unsigned int fNum ) const;
 
+  virtual void GenerateFeatureVectors( SizeValueType startVoxel,
+    SizeValueType endVoxel, FeatureValueType * buffer ) const;
+
 protected:
 
   RidgeFeatureVectorGenerator( void );
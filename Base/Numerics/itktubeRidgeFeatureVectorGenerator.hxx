@@ -116,6 +116,15 @@ RidgeFeatureVectorGenerator< TImage >
   return featureVector;
 }
 
+template< class TImage >
+void
+RidgeFeatureVectorGenerator< TImage >
+::GenerateFeatureVectors( SizeValueType startVoxel, SizeValueType endVoxel,
+  FeatureValueType * buffer ) const
+{
+  this->GenerateFeatureVectorsAtIndices( startVoxel, endVoxel, buffer );
+}
+
 template< class TImage >
 typename RidgeFeatureVectorGenerator< TImage >::FeatureValueType
 RidgeFeatureVectorGenerator< TImage >
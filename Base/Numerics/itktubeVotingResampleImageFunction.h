@@ -32,20 +32,34 @@ namespace itk
 namespace tube
 {
 
+/** Number of voxels, 3^VDimension, in the neighborhood that votes. */
+template< unsigned int VDimension >
+struct VotingNeighborhoodSize
+{
+  static const unsigned int Value =
+    3 * VotingNeighborhoodSize< VDimension - 1 >::Value;
+};
+
+template<>
+struct VotingNeighborhoodSize< 0 >
+{
+  static const unsigned int Value = 1;
+};
+
 /** \class VotingResampleImageFunction
- * \brief Linearly interpolate an image at specified positions.
+ * \brief Interpolate a label image by a majority vote.
  *
- * VotingResampleImageFunction linearly interpolates image intensity at
- * a non-integer pixel position. This class is templated
+ * VotingResampleImageFunction returns the most frequent label in the
+ * neighborhood of a non-integer pixel position. This class is templated
  * over the input image type and the coordinate representation type
  * (e.g. float or double).
  *
  * This function works for N-dimensional images.
  *
  * \warning This function work only for images with scalar pixel
- * types. For vector images use VectorVotingResampleImageFunction.
+ * types.
  *
- * \sa VectorVotingResampleImageFunction
+ * \sa VotingResampleImageFilter
  *
  * \ingroup ImageFunctions ImageInterpolators
  */
@@ -84,10 +98,24 @@ public:
   /** ContinuousIndex typedef support. */
   typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
 
+  /** Pixel type of the labels. */
+  typedef typename InputImageType::PixelType InputPixelType;
+
+  /** Number of labels in the voting neighborhood. */
+  itkStaticConstMacro( NumberOfVotes, unsigned int,
+    VotingNeighborhoodSize< ImageDimension >::Value );
+
+  /** Return the most frequent of the given labels, choosing the smallest
+   * label on ties.  The labels are sorted in place; no memory is
+   * allocated. */
+  static InputPixelType VoteOnLabels( InputPixelType * labels,
+    unsigned int numberOfLabels );
+
   /** Evaluate the function at a ContinuousIndex position
    *
-   * Returns the linearly interpolated image intensity at a
-   * specified point position. No bounds checking is done.
+   * Returns the majority label of the 3^N neighborhood of the voxel that
+   * contains the position. Neighbors outside the buffered region of the
+   * image are clamped to its boundary. No bounds checking is done.
    * The point is assume to lie within the image buffer.
    *
    * ImageFunction::IsInsideBuffer() can be used to check bounds before
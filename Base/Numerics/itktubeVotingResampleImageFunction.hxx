@@ -26,13 +26,6 @@ limitations under the License.
 
 #include "itktubeVotingResampleImageFunction.h"
 
-#include <itkConstNeighborhoodIterator.h>
-#include <itkNeighborhood.h>
-
-#include <vnl/vnl_math.h>
-
-#include <map>
-
 namespace itk
 {
 
@@ -71,6 +64,49 @@ VotingResampleImageFunction< TInputImage, TCoordRep >
 }
 
 
+/**
+ * Majority vote with ties going to the smallest label
+ */
+template< class TInputImage, class TCoordRep >
+typename VotingResampleImageFunction< TInputImage, TCoordRep >
+::InputPixelType
+VotingResampleImageFunction< TInputImage, TCoordRep >
+::VoteOnLabels( InputPixelType * labels, unsigned int numberOfLabels )
+{
+  // Insertion sort; the neighborhood is small.
+  for( unsigned int i = 1; i < numberOfLabels; i++ )
+    {
+    const InputPixelType label = labels[i];
+    unsigned int j = i;
+    while( j > 0 && label < labels[j - 1] )
+      {
+      labels[j] = labels[j - 1];
+      --j;
+      }
+    labels[j] = label;
+    }
+
+  InputPixelType ret = labels[0];
+  unsigned int max = 0;
+  unsigned int i = 0;
+  while( i < numberOfLabels )
+    {
+    unsigned int j = i + 1;
+    while( j < numberOfLabels && labels[j] == labels[i] )
+      {
+      ++j;
+      }
+    if( j - i > max )
+      {
+      max = j - i;
+      ret = labels[i];
+      }
+    i = j;
+    }
+  return ret;
+}
+
+
 /**
  * Evaluate at image index position
  */
@@ -81,46 +117,47 @@ VotingResampleImageFunction< TInputImage, TCoordRep >
 ::EvaluateAtContinuousIndex(
   const ContinuousIndexType& index) const
 {
-  typedef itk::ConstNeighborhoodIterator< TInputImage >
-    NeighborhoodIteratorType;
-
-  typename NeighborhoodIteratorType::RadiusType radius;
-  radius.Fill(1);
-  NeighborhoodIteratorType it( radius, this->GetInputImage(),
-    this->GetInputImage()->GetRequestedRegion() );
+  const InputImageType * image = this->GetInputImage();
+  const typename InputImageType::RegionType & region =
+    image->GetBufferedRegion();
+  const IndexType regionIndex = region.GetIndex();
+  const typename InputImageType::SizeType regionSize = region.GetSize();
 
   IndexType newIndex;
-  for(int i = 0; i < ImageDimension; i++)
+  for( unsigned int i = 0; i < ImageDimension; i++ )
     {
     newIndex[i] = (int)index[i];
     }
 
-  it.SetLocation(newIndex);
-  itk::Neighborhood<typename TInputImage::PixelType, ImageDimension> n =
-    it.GetNeighborhood();
-  std::map<typename TInputImage::PixelType, int> tally;
-  typename std::map<typename TInputImage::PixelType, int>::const_iterator itr;
-  for(unsigned int i = 0; i < n.Size(); i++)
-    {
-    tally[n[i]] = 0;
-    }
-  for(unsigned int i = 0; i < n.Size(); i++)
+  // Visit the 3^N neighbors, clamping to the buffer as the zero-flux
+  // boundary condition would.
+  InputPixelType labels[NumberOfVotes];
+  IndexType neighborIndex;
+  for( unsigned int n = 0; n < NumberOfVotes; n++ )
     {
-    tally[n[i]] += 1;
-    }
-  bool first = true;
-  int max = 0;
-  unsigned short ret = 0;
-  for(itr = tally.begin(); itr != tally.end(); ++itr)
-    {
-    if(first == true || itr->second > max)
+    unsigned int digits = n;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
       {
-      first = false;
-      max = itr->second;
-      ret = itr->first;
+      IndexValueType value = newIndex[i] + static_cast< IndexValueType >(
+        digits % 3 ) - 1;
+      digits /= 3;
+      if( value < regionIndex[i] )
+        {
+        value = regionIndex[i];
+        }
+      else if( value >= regionIndex[i]
+        + static_cast< IndexValueType >( regionSize[i] ) )
+        {
+        value = regionIndex[i]
+          + static_cast< IndexValueType >( regionSize[i] ) - 1;
+        }
+      neighborIndex[i] = value;
       }
+    labels[n] = image->GetPixel( neighborIndex );
     }
-  return ret;
+
+  return static_cast< OutputType >( VoteOnLabels( labels,
+    NumberOfVotes ) );
 }
 
 } // End namespace tube
@@ -24,31 +24,19 @@ limitations under the License.
 #include "itktubeAnisotropicDiffusiveRegistrationFilter.h"
 
 #include <itkImageFileWriter.h>
+#include <itkMemoryUsageObserver.h>
 #include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkTimeProbe.h>
 
 #include <vtkPlaneSource.h>
 
-int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv[] )
+template< class TVectorScalar >
+int RegularizeMotionField( int argc, char * argv[] )
 {
-  if( argc < 7 )
-    {
-    std::cerr << "Missing arguments." << std::endl;
-    std::cerr << "Usage: " << std::endl;
-    std::cerr << argv[0]
-              << "smoothed motion field image, "
-              << "noise variance, "
-              << "border slope, "
-              << "number of iterations, "
-              << "time step, "
-              << "should use anisotropic regularization"
-              << std::endl;
-    return EXIT_FAILURE;
-    }
-
   // Typedefs
   enum { Dimension = 3 };
   typedef double                                          PixelType;
-  typedef double                                          VectorScalarType;
+  typedef TVectorScalar                                   VectorScalarType;
   typedef itk::Image< PixelType, Dimension >              FixedImageType;
   typedef itk::Image< PixelType, Dimension >              MovingImageType;
   typedef itk::Vector< VectorScalarType, Dimension >      VectorType;
@@ -65,18 +53,18 @@ int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv
   double      originValue = 0.0;
 
   // Allocate the motion field image
-  DeformationFieldType::Pointer      deformationField
+  typename DeformationFieldType::Pointer      deformationField
                                                   = DeformationFieldType::New();
-  DeformationFieldType::IndexType    start;
+  typename DeformationFieldType::IndexType    start;
   start.Fill( startValue );
-  DeformationFieldType::SizeType     size;
+  typename DeformationFieldType::SizeType     size;
   size.Fill( sizeValue );
-  DeformationFieldType::RegionType   region;
+  typename DeformationFieldType::RegionType   region;
   region.SetSize( size );
   region.SetIndex( start );
-  DeformationFieldType::SpacingType  spacing;
+  typename DeformationFieldType::SpacingType  spacing;
   spacing.Fill( spacingValue );
-  DeformationFieldType::PointType    origin;
+  typename DeformationFieldType::PointType    origin;
   origin.Fill( originValue);
 
   deformationField->SetRegions( region );
@@ -199,9 +187,9 @@ int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv
       < FixedImageType, MovingImageType, DeformationFieldType >
       AnisotropicDiffusiveRegistrationFilterType;
 
-  DiffusiveRegistrationFilterType::Pointer registrator = 0;
-  AnisotropicDiffusiveRegistrationFilterType::Pointer anisotropicRegistrator
-      = 0;
+  typename DiffusiveRegistrationFilterType::Pointer registrator = 0;
+  typename AnisotropicDiffusiveRegistrationFilterType::Pointer
+      anisotropicRegistrator = 0;
   int useAnisotropic = std::atoi( argv[6] );
   if( useAnisotropic )
     {
@@ -221,6 +209,10 @@ int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv
   registrator->SetComputeIntensityDistanceTerm( false );
   registrator->SetTimeStep( std::atof( argv[5] ) );
   registrator->SetNumberOfIterations( std::atoi( argv[4] ) );
+  if( argc > 7 )
+    {
+    registrator->SetStoreDerivativeImages( std::atoi( argv[7] ) != 0 );
+    }
   if( anisotropicRegistrator )
     {
     anisotropicRegistrator->SetBorderSurface( plane->GetOutput() );
@@ -228,19 +220,36 @@ int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv
 
   // Save the smoothed deformation field
   typedef itk::ImageFileWriter< DeformationFieldType > WriterType;
-  WriterType::Pointer writer = WriterType::New();
+  typename WriterType::Pointer writer = WriterType::New();
   writer->SetFileName( argv[1] );
   writer->SetInput( registrator->GetOutput() );
   writer->SetUseCompression( true );
+  itk::TimeProbe timer;
+  itk::MemoryUsageObserver memoryObserver;
+  itk::MemoryUsageObserver::MemoryLoadType memoryBefore = 0;
+  itk::MemoryUsageObserver::MemoryLoadType memoryAfter = 0;
   try
     {
+    memoryBefore = memoryObserver.GetMemoryUsage();
+    timer.Start();
     writer->Update();
+    timer.Stop();
+    memoryAfter = memoryObserver.GetMemoryUsage();
     }
   catch( itk::ExceptionObject & err )
     {
     std::cerr << "Exception caught: " << err << std::endl;
     return EXIT_FAILURE;
     }
+  std::cout << "Registration time (store derivative images = "
+            << registrator->GetStoreDerivativeImages() << ", "
+            << sizeof( VectorScalarType ) << " byte components): "
+            << timer.GetMean() << " s" << std::endl;
+  // The filter keeps its member images after the update, so the growth of
+  // the process memory measures them
+  std::cout << "Memory used by the registration: "
+            << ( memoryAfter > memoryBefore ? memoryAfter - memoryBefore : 0 )
+            << " kB" << std::endl;
 
   // Check to make sure the border normals were calculated correctly by the
   // registrator
@@ -278,3 +287,29 @@ int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv
 
   return EXIT_SUCCESS;
 }
+
+int itkAnisotropicDiffusiveRegistrationRegularizationTest( int argc, char * argv[] )
+{
+  if( argc < 7 )
+    {
+    std::cerr << "Missing arguments." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << argv[0]
+              << "smoothed motion field image, "
+              << "noise variance, "
+              << "border slope, "
+              << "number of iterations, "
+              << "time step, "
+              << "should use anisotropic regularization, "
+              << "[should store derivative images], "
+              << "[should use a float deformation field]"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( argc > 8 && std::atoi( argv[8] ) != 0 )
+    {
+    return RegularizeMotionField< float >( argc, argv );
+    }
+  return RegularizeMotionField< double >( argc, argv );
+}
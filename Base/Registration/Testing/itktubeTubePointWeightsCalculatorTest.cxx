@@ -89,9 +89,31 @@ int itktubeTubePointWeightsCalculatorTest( int argc, char * argv[] )
   resolutionWeightsCalculator->SetTubeTreeSpatialObject( group );
   resolutionWeightsCalculator->SetPointWeightFunction( weightFunction );
   resolutionWeightsCalculator->Compute();
-  const PointWeightsType & resolutionWeights
+  const PointWeightsType resolutionWeights
     = resolutionWeightsCalculator->GetPointWeights();
 
+  // The threaded weights must match a direct evaluation of every point.
+  if( resolutionWeights.GetSize() != numberOfPoints )
+    {
+    std::cerr << "Wrong number of weights: " << resolutionWeights.GetSize()
+      << " != " << numberOfPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+  resolutionWeightsCalculator->SetNumberOfThreads( 1 );
+  resolutionWeightsCalculator->Compute();
+  for( unsigned int ii = 0; ii < numberOfPoints; ++ii )
+    {
+    const float expected =
+      weightFunction->Evaluate( tubes->GetPoints()[ii] );
+    if( resolutionWeights[ii] != expected
+      || resolutionWeightsCalculator->GetPointWeights()[ii] != expected )
+      {
+      std::cerr << "Weight mismatch at point " << ii << ": "
+        << resolutionWeights[ii] << " != " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   for( unsigned int ii = 0; ii < numberOfPoints; ++ii )
     {
     const float pointWeight = resolutionWeights[ii];
@@ -122,6 +122,53 @@ int itktubeTubeToTubeTransformFilterTest( int argc, char * argv[] )
     return EXIT_FAILURE;
     }
 
+  // the positions-only mode must give the same positions
+  TubeTransformFilterType::Pointer positionsFilter =
+    TubeTransformFilterType::New();
+  positionsFilter->SetInput(reader->GetGroup());
+  positionsFilter->SetScale(1.0);
+  positionsFilter->SetTransform(transform);
+  positionsFilter->PositionsOnlyOn();
+  positionsFilter->Update();
+
+  typedef TubeTransformFilterType::TubeType TubeType;
+  TubeNetType::ChildrenListType * tubes =
+    transformFilter->GetOutput()->GetChildren();
+  TubeNetType::ChildrenListType * positionsTubes =
+    positionsFilter->GetOutput()->GetChildren();
+  if( tubes->size() != positionsTubes->size() )
+    {
+    std::cerr << "Positions only: number of tubes differs." << std::endl;
+    return EXIT_FAILURE;
+    }
+  TubeNetType::ChildrenListType::const_iterator positionsIt =
+    positionsTubes->begin();
+  for( TubeNetType::ChildrenListType::const_iterator tubeIt = tubes->begin();
+    tubeIt != tubes->end(); ++tubeIt, ++positionsIt )
+    {
+    const TubeType::PointListType & points =
+      static_cast< TubeType * >( tubeIt->GetPointer() )->GetPoints();
+    const TubeType::PointListType & positionsPoints =
+      static_cast< TubeType * >( positionsIt->GetPointer() )->GetPoints();
+    if( points.size() != positionsPoints.size() )
+      {
+      std::cerr << "Positions only: number of points differs." << std::endl;
+      return EXIT_FAILURE;
+      }
+    for( unsigned int i = 0; i < points.size(); ++i )
+      {
+      if( points[i].GetPosition().EuclideanDistanceTo(
+        positionsPoints[i].GetPosition() ) > 1e-10 )
+        {
+        std::cerr << "Positions only: point " << i << " differs."
+          << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  delete tubes;
+  delete positionsTubes;
+
   // write vessel
   TubeNetWriterType::Pointer writer = TubeNetWriterType::New();
   writer->SetFileName(argv[2]);
@@ -20,7 +20,7 @@
 
 #include "itkInitialImageToImageRegistrationMethod.h"
 
-#include "itkImageRegionMomentsCalculator.h"
+#include "itktubeImageRegionMomentsCalculator.h"
 
 namespace itk
 {
@@ -155,7 +155,7 @@ InitialImageToImageRegistrationMethod<TImage>
     return;
     }
 
-  typedef ImageRegionMomentsCalculator<TImage> MomentsCalculatorType;
+  typedef tube::ImageRegionMomentsCalculator<TImage> MomentsCalculatorType;
 
   typename MomentsCalculatorType::AffineTransformType::Pointer newTransform;
   newTransform = MomentsCalculatorType::AffineTransformType::New();
@@ -252,8 +252,7 @@ InitialImageToImageRegistrationMethod<TImage>
       std::cout << "Init: Using full image extent" << std::endl;
       }
 
-    // HELP: ImageMomentsCalculator isn't multi-threaded :(
-    // momCalc->SetNumberOfThreads( this->GetRegistrationNumberOfThreads() );
+    momCalc->SetNumberOfThreads( this->GetRegistrationNumberOfThreads() );
     try
       {
       momCalc->Compute();
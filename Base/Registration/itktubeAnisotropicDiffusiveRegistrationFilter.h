@@ -155,7 +155,7 @@ public:
       DeformationVectorImageRegionType;
 
   /** Normal vector types */
-  typedef double NormalVectorComponentType;
+  typedef DeformationVectorComponentType NormalVectorComponentType;
   typedef itk::Vector< NormalVectorComponentType, ImageDimension >
       NormalVectorType;
   typedef itk::Image< NormalVectorType, ImageDimension >
@@ -171,7 +171,7 @@ public:
 
   /** Types for weighting between the anisotropic and diffusive (Gaussian)
     * regularization */
-  typedef double                                        WeightType;
+  typedef DeformationVectorComponentType                WeightType;
   typedef itk::Image< WeightType, ImageDimension >      WeightImageType;
   typedef typename WeightImageType::Pointer             WeightImagePointer;
   typedef itk::ImageRegionIterator< WeightImageType >   WeightImageRegionType;
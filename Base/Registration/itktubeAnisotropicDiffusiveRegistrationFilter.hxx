@@ -140,9 +140,9 @@ AnisotropicDiffusiveRegistrationFilter
     for( int j = 0; j < ImageDimension; j++ )
       {
       firstOrder = ScalarDerivativeImageType::New();
-      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( firstOrder, output );
+      this->AllocateSpaceForDerivativeImage( firstOrder, output );
       secondOrder = TensorDerivativeImageType::New();
-      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( secondOrder, output );
+      this->AllocateSpaceForDerivativeImage( secondOrder, output );
       this->SetDeformationComponentFirstOrderDerivative( i, j, firstOrder );
       this->SetDeformationComponentSecondOrderDerivative( i, j, secondOrder );
       }
@@ -130,9 +130,10 @@ public:
   typedef typename IntensityDistanceFunctionType::Pointer
       IntensityDistanceFunctionPointer;
 
-  /** Typedefs for the regularization function */
+  /** Typedefs for the regularization function.  The diffusion tensors and
+   *  the derivatives share the precision of the deformation field. */
   typedef AnisotropicDiffusionTensorFunction
-      < DeformationVectorComponentImageType >
+      < DeformationVectorComponentImageType, DeformationVectorComponentType >
       RegularizationFunctionType;
   typedef typename RegularizationFunctionType::Pointer
       RegularizationFunctionPointer;
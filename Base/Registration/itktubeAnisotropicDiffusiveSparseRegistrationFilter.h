@@ -29,8 +29,12 @@ limitations under the License.
 #include <itkGroupSpatialObject.h>
 #include <itkVesselTubeSpatialObject.h>
 
+#include <itksys/MD5.h>
+
 #include <vtkSmartPointer.h>
 
+#include <string>
+
 class vtkFloatArray;
 class vtkPointLocator;
 class vtkPolyData;
@@ -159,7 +163,7 @@ public:
   /** Normal vector types.  There are three normals at each voxel, which are
    *  stored in a matrix.  If the normals are based on the structure tensor,
    *  then the matrix will be symmetric, but we won't enforce that. */
-  typedef double NormalVectorComponentType;
+  typedef DeformationVectorComponentType NormalVectorComponentType;
   typedef itk::Vector< NormalVectorComponentType, ImageDimension >
       NormalVectorType;
   typedef itk::Image< NormalVectorType, ImageDimension >
@@ -183,7 +187,7 @@ public:
   /** Types for weighting between the plane/tube/point states of the
     * regularization - a matrix A, likely symmetric but we won't enforce
     * that here. */
-  typedef double                                        WeightComponentType;
+  typedef DeformationVectorComponentType                WeightComponentType;
   typedef typename itk::Matrix< WeightComponentType,
                                 ImageDimension,
                                 ImageDimension >        WeightMatrixType;
@@ -302,6 +306,20 @@ public:
       GetHighResolutionWeightRegularizationsImage( void ) const
     { return m_HighResolutionWeightRegularizationsImage; }
 
+  /** Computes the normal matrix and weight images that were not supplied on
+   *  the high resolution template, without running the registration.  The
+   *  results can be saved and supplied to later registrations of the same
+   *  geometry through SetNormalMatrixImage(), SetWeightStructuresImage() and
+   *  SetWeightRegularizationsImage(). */
+  virtual void ComputeHighResolutionNormalMatrixAndWeightImages( void );
+
+  /** Returns an MD5 hash of the inputs the normal matrix and weight images
+   *  are computed from: the border surface, the tubes of the tube list,
+   *  lambda, gamma, the geometry of the high resolution template, and any
+   *  normal matrix or weight images that were supplied.  Saved images whose
+   *  hash differs from the current one are stale. */
+  std::string ComputeGeometryHash( void ) const;
+
   /** Get the normal components of the deformation field.  The normal
    *  deformation field component images are the same for both the SMOOTH_NORMAL
    *  and PROP_NORMAL terms, so we will return one arbitrarily. */
@@ -346,6 +364,13 @@ protected:
   /** If needed, allocates and computes the normal vector and weight images. */
   virtual void SetupNormalMatrixAndWeightImages( void );
 
+  /** Computes the normals of the border surface and the tube list, and
+   *  allocates and computes the requested normal matrix and weight images on
+   *  the high resolution template, or on the output if there is none. */
+  void InitializeNormalMatrixAndWeightImages( bool computeNormals,
+                                              bool computeWeightStructures,
+                                              bool computeWeightRegularizations );
+
   /** Compute the normals for the border surface. */
   void ComputeBorderSurfaceNormals( void );
 
@@ -414,6 +439,12 @@ private:
   AnisotropicDiffusiveSparseRegistrationFilter(const Self&);
   void operator=(const Self&); // Purposely not implemented
 
+  /** Appends whether an image is set and, if so, its geometry and pixels to
+   *  an MD5 hash */
+  template< class TImage >
+  static void AppendImageToGeometryHash( itksysMD5 * md5,
+                                         const TImage * image );
+
   /** Structure for passing information into static callback methods.  Used in
    * the subclasses threading mechanisms. */
   struct AnisotropicDiffusiveSparseRegistrationFilterThreadStruct
@@ -33,6 +33,8 @@ limitations under the License.
 #include <itkImageRegionSplitter.h>
 #include <itkSmoothingRecursiveGaussianImageFilter.h>
 
+#include <vtkCellArray.h>
+
 #include <vtkFloatArray.h>
 #include <vtkPointData.h>
 #include <vtkPointLocator.h>
@@ -173,11 +175,9 @@ AnisotropicDiffusiveSparseRegistrationFilter
       if( t == SMOOTH_TANGENTIAL || t == SMOOTH_NORMAL )
         {
         firstOrder = ScalarDerivativeImageType::New();
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( firstOrder,
-                                 output );
+        this->AllocateSpaceForDerivativeImage( firstOrder, output );
         secondOrder = TensorDerivativeImageType::New();
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( secondOrder,
-                                 output );
+        this->AllocateSpaceForDerivativeImage( secondOrder, output );
         }
       this->SetDeformationComponentFirstOrderDerivative( t, i, firstOrder );
       this->SetDeformationComponentSecondOrderDerivative( t, i, secondOrder );
@@ -206,89 +206,15 @@ AnisotropicDiffusiveSparseRegistrationFilter
   bool computeWeightStructures = !m_WeightStructuresImage;
   bool computeWeightRegularizations = !m_WeightRegularizationsImage;
 
-  // If we have a template for image attributes, use it.  The normal and weight
-  // images will be stored at their full resolution.  The diffusion tensor,
-  // deformation component, derivative and multiplication vector images are
-  // recalculated every time Initialize() is called to regenerate them at the
-  // correct resolution.
-  FixedImagePointer highResolutionTemplate = this->GetHighResolutionTemplate();
-
-  // If we don't have a template:
-  // The output will be used as the template to allocate the images we will
-  // use to store data computed before/during the registration
   OutputImagePointer output = this->GetOutput();
 
   // Compute the normal vector and/or weight images if required
   if( computeNormals || computeWeightStructures
       || computeWeightRegularizations )
     {
-    // Ensure we have a border surface or a tube list to work with
-    if( !this->GetBorderSurface() && !this->GetTubeList() )
-      {
-      itkExceptionMacro( << "You must provide a border surface, or a tube "
-                         << "list, or both a normal matrix image and a weight "
-                         << "image" );
-      }
-
-    // Compute the normals for the surface
-    if( this->GetBorderSurface() )
-      {
-      this->ComputeBorderSurfaceNormals();
-      }
-    // Compute the normals for the tube list
-    if( this->GetTubeList() )
-      {
-      this->ComputeTubeNormals();
-      }
-
-    // Allocate the normal vector and/or weight images
-    if( computeNormals )
-      {
-      m_NormalMatrixImage = NormalMatrixImageType::New();
-      if( highResolutionTemplate )
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( m_NormalMatrixImage,
-                                 highResolutionTemplate );
-        }
-      else
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( m_NormalMatrixImage,
-                                 output );
-        }
-      }
-    if( computeWeightStructures )
-      {
-      m_WeightStructuresImage = WeightMatrixImageType::New();
-      if( highResolutionTemplate )
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
-                                 m_WeightStructuresImage, highResolutionTemplate );
-        }
-      else
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
-                                 m_WeightStructuresImage, output );
-        }
-      }
-    if( computeWeightRegularizations )
-      {
-      m_WeightRegularizationsImage = WeightComponentImageType::New();
-      if( highResolutionTemplate )
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
-                                  m_WeightRegularizationsImage, highResolutionTemplate );
-        }
-      else
-        {
-        DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
-                                 m_WeightRegularizationsImage, output );
-        }
-      }
-
-    // Actually compute the normal vectors and/or weights
-    this->ComputeNormalMatrixAndWeightImages( computeNormals,
-                                              computeWeightStructures,
-                                              computeWeightRegularizations );
+    this->InitializeNormalMatrixAndWeightImages( computeNormals,
+                                                 computeWeightStructures,
+                                                 computeWeightRegularizations );
     }
 
   // On the first iteration of the first level, the normal and weight images
@@ -342,6 +268,275 @@ AnisotropicDiffusiveSparseRegistrationFilter
     }
 }
 
+/**
+ * Allocates and computes the normal matrix and weight images
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+AnisotropicDiffusiveSparseRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::InitializeNormalMatrixAndWeightImages( bool computeNormals,
+                                         bool computeWeightStructures,
+                                         bool computeWeightRegularizations )
+{
+  // If we have a template for image attributes, use it.  The normal and weight
+  // images will be stored at their full resolution.  The diffusion tensor,
+  // deformation component, derivative and multiplication vector images are
+  // recalculated every time Initialize() is called to regenerate them at the
+  // correct resolution.
+  FixedImagePointer highResolutionTemplate = this->GetHighResolutionTemplate();
+
+  // If we don't have a template:
+  // The output will be used as the template to allocate the images we will
+  // use to store data computed before/during the registration
+  OutputImagePointer output = this->GetOutput();
+
+  // Ensure we have a border surface or a tube list to work with
+  if( !this->GetBorderSurface() && !this->GetTubeList() )
+    {
+    itkExceptionMacro( << "You must provide a border surface, or a tube "
+                       << "list, or both a normal matrix image and a weight "
+                       << "image" );
+    }
+
+  // Compute the normals for the surface
+  if( this->GetBorderSurface() )
+    {
+    this->ComputeBorderSurfaceNormals();
+    }
+  // Compute the normals for the tube list
+  if( this->GetTubeList() )
+    {
+    this->ComputeTubeNormals();
+    }
+
+  // Allocate the normal vector and/or weight images
+  if( computeNormals )
+    {
+    m_NormalMatrixImage = NormalMatrixImageType::New();
+    if( highResolutionTemplate )
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( m_NormalMatrixImage,
+                               highResolutionTemplate );
+      }
+    else
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( m_NormalMatrixImage,
+                               output );
+      }
+    }
+  if( computeWeightStructures )
+    {
+    m_WeightStructuresImage = WeightMatrixImageType::New();
+    if( highResolutionTemplate )
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+                               m_WeightStructuresImage, highResolutionTemplate );
+      }
+    else
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+                               m_WeightStructuresImage, output );
+      }
+    }
+  if( computeWeightRegularizations )
+    {
+    m_WeightRegularizationsImage = WeightComponentImageType::New();
+    if( highResolutionTemplate )
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+                                m_WeightRegularizationsImage, highResolutionTemplate );
+      }
+    else
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+                               m_WeightRegularizationsImage, output );
+      }
+    }
+
+  // Actually compute the normal vectors and/or weights
+  this->ComputeNormalMatrixAndWeightImages( computeNormals,
+                                            computeWeightStructures,
+                                            computeWeightRegularizations );
+}
+
+/**
+ * Computes the normal matrix and weight images without registering
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+AnisotropicDiffusiveSparseRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::ComputeHighResolutionNormalMatrixAndWeightImages( void )
+{
+  if( !this->GetHighResolutionTemplate() )
+    {
+    itkExceptionMacro( << "A high resolution template is required to "
+                       << "compute the normal matrix and weight images" );
+    }
+
+  bool computeNormals = !m_NormalMatrixImage;
+  bool computeWeightStructures = !m_WeightStructuresImage;
+  bool computeWeightRegularizations = !m_WeightRegularizationsImage;
+  if( computeNormals || computeWeightStructures
+      || computeWeightRegularizations )
+    {
+    this->InitializeNormalMatrixAndWeightImages( computeNormals,
+                                                 computeWeightStructures,
+                                                 computeWeightRegularizations );
+    }
+
+  m_HighResolutionNormalMatrixImage = m_NormalMatrixImage;
+  m_HighResolutionWeightStructuresImage = m_WeightStructuresImage;
+  m_HighResolutionWeightRegularizationsImage = m_WeightRegularizationsImage;
+}
+
+/**
+ * Hash of the inputs to the normal matrix and weight images
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+std::string
+AnisotropicDiffusiveSparseRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::ComputeGeometryHash( void ) const
+{
+  itksysMD5 * md5 = itksysMD5_New();
+  itksysMD5_Initialize( md5 );
+
+  const unsigned int dimension = ImageDimension;
+  itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+    &dimension ), sizeof( dimension ) );
+  itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+    &m_Lambda ), sizeof( m_Lambda ) );
+  itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+    &m_Gamma ), sizeof( m_Gamma ) );
+
+  // Only the geometry of the template matters, not its intensities
+  const FixedImageType * highResolutionTemplate =
+    this->GetHighResolutionTemplate();
+  if( highResolutionTemplate )
+    {
+    double geometry[ ImageDimension * ( ImageDimension + 4 ) ];
+    int g = 0;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      geometry[g++] = highResolutionTemplate->GetLargestPossibleRegion()
+        .GetIndex()[i];
+      geometry[g++] = highResolutionTemplate->GetLargestPossibleRegion()
+        .GetSize()[i];
+      geometry[g++] = highResolutionTemplate->GetSpacing()[i];
+      geometry[g++] = highResolutionTemplate->GetOrigin()[i];
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        geometry[g++] = highResolutionTemplate->GetDirection()[i][j];
+        }
+      }
+    itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+      geometry ), sizeof( geometry ) );
+    }
+
+  // The border normals are derived from the points and polygons
+  if( m_BorderSurface )
+    {
+    double point[3];
+    for( vtkIdType i = 0; i < m_BorderSurface->GetNumberOfPoints(); i++ )
+      {
+      m_BorderSurface->GetPoint( i, point );
+      itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+        point ), sizeof( point ) );
+      }
+    vtkCellArray * polys = m_BorderSurface->GetPolys();
+    if( polys && polys->GetNumberOfConnectivityEntries() > 0 )
+      {
+      itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+        polys->GetPointer() ), polys->GetNumberOfConnectivityEntries()
+        * sizeof( vtkIdType ) );
+      }
+    }
+
+  // The tube normals are derived from the point positions, and the tangents
+  //   from the points of each tube
+  if( m_TubeList )
+    {
+    for( typename TubeListType::const_iterator tubeIt = m_TubeList->begin();
+         tubeIt != m_TubeList->end();
+         ++tubeIt )
+      {
+      const TubeType * tube
+          = static_cast< const TubeType * >( tubeIt->GetPointer() );
+      const TubePointListType & tubePointList = tube->GetPoints();
+      const unsigned long numberOfPoints = tubePointList.size();
+      itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+        &numberOfPoints ), sizeof( numberOfPoints ) );
+      for( typename TubePointListType::const_iterator pointIt
+             = tubePointList.begin();
+           pointIt != tubePointList.end();
+           ++pointIt )
+        {
+        double values[ ImageDimension + 1 ];
+        for( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          values[i] = pointIt->GetPosition()[i];
+          }
+        values[ImageDimension] = pointIt->GetRadius();
+        itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+          values ), sizeof( values ) );
+        }
+      }
+    }
+
+  // Supplied images are used instead of being computed
+  AppendImageToGeometryHash( md5, m_NormalMatrixImage.GetPointer() );
+  AppendImageToGeometryHash( md5, m_WeightStructuresImage.GetPointer() );
+  AppendImageToGeometryHash( md5, m_WeightRegularizationsImage.GetPointer() );
+
+  char hash[33];
+  itksysMD5_FinalizeHex( md5, hash );
+  hash[32] = '\0';
+  itksysMD5_Delete( md5 );
+
+  return std::string( hash );
+}
+
+/**
+ * Appends an image to a hash
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+template< class TImage >
+void
+AnisotropicDiffusiveSparseRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::AppendImageToGeometryHash( itksysMD5 * md5, const TImage * image )
+{
+  const unsigned char isSet = ( image != NULL );
+  itksysMD5_Append( md5, &isSet, sizeof( isSet ) );
+  if( !image )
+    {
+    return;
+    }
+
+  double geometry[ ImageDimension * ( ImageDimension + 4 ) ];
+  int g = 0;
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    geometry[g++] = image->GetLargestPossibleRegion().GetIndex()[i];
+    geometry[g++] = image->GetLargestPossibleRegion().GetSize()[i];
+    geometry[g++] = image->GetSpacing()[i];
+    geometry[g++] = image->GetOrigin()[i];
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      geometry[g++] = image->GetDirection()[i][j];
+      }
+    }
+  itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+    geometry ), sizeof( geometry ) );
+
+  itksysMD5_Append( md5, reinterpret_cast< const unsigned char * >(
+    image->GetBufferPointer() ),
+    image->GetBufferedRegion().GetNumberOfPixels()
+    * sizeof( typename TImage::PixelType ) );
+}
+
 /**
  * Compute the normals for the border surface
  */
@@ -25,10 +25,15 @@ limitations under the License.
 #define __itktubeDiffusiveRegistrationFilter_h
 
 #include "itktubeAnisotropicDiffusiveRegistrationFunction.h"
+#include "itktubeDiffusiveRegistrationFilterUtils.h"
 
 #include <itkPDEDeformableRegistrationFilter.h>
+#include <itkRealTimeClock.h>
 #include <itkVectorIndexSelectionCastImageFilter.h>
 
+#include <algorithm>
+#include <string>
+
 namespace itk
 {
 
@@ -104,6 +109,17 @@ struct EnergiesStruct
  * - UpdateDeformationComponentImages(): update the u images at each iteration
  * See itktubeAnisotropicDiffusiveRegistrationFilter for an example derived filter.
  *
+ * Each regularization term stores, per voxel, a diffusion tensor (6 values),
+ * its first-order derivatives (9), the first- and second-order derivatives
+ * of each deformation component (3 x (3 + 9)) and, for the anisotropic
+ * filters, the multiplication vectors (3 x 3).  Turning StoreDerivativeImages
+ * off drops the derivative images, at the cost of computing the derivatives
+ * twice per iteration (once for the update and once for the energies), slab
+ * by slab within each thread region.  All member images use the component
+ * type of the deformation field, so a float deformation field stores them
+ * in single precision.  itkAnisotropicDiffusiveRegistrationRegularizationTest
+ * reports the run time and the memory used for each of these settings.
+ *
  * See: D.F. Pace et al., Deformable image registration of sliding organs using
  * anisotropic diffusive regularization, ISBI 2011.
  *
@@ -328,6 +344,8 @@ public:
     { m_HighResolutionTemplate = templateImage; }
   virtual FixedImageType * GetHighResolutionTemplate( void )
     { return m_HighResolutionTemplate; }
+  virtual const FixedImageType * GetHighResolutionTemplate( void ) const
+    { return m_HighResolutionTemplate; }
 
   /** Get current resolution level being processed. */
   itkGetConstReferenceMacro( CurrentLevel, unsigned int );
@@ -357,6 +375,50 @@ public:
   double GetStoppingCriterionMaxTotalEnergyChange( void ) const
     { return m_StoppingCriterionMaxTotalEnergyChange; }
 
+  /** Set/get whether the derivatives of the deformation components and of
+   *  the diffusion tensors are stored in whole-image member images.  If
+   *  false, they are recomputed into slab-sized images wherever they are
+   *  needed, trading computation time for memory.  Default true. */
+  void SetStoreDerivativeImages( bool store )
+    { m_StoreDerivativeImages = store; }
+  bool GetStoreDerivativeImages( void ) const
+    { return m_StoreDerivativeImages; }
+
+  /** Set/get the file to which checkpoints of the registration state are
+   *  written, and from which the state is read when resuming.  A checkpoint
+   *  holds the current deformation field, the multiresolution level, the
+   *  iteration count, the energy and update statistics and the time step
+   *  history, in the native byte order.  Default empty, i.e. no
+   *  checkpoints. */
+  void SetCheckpointFileName( const std::string & fileName )
+    { m_CheckpointFileName = fileName; }
+  const std::string & GetCheckpointFileName( void ) const
+    { return m_CheckpointFileName; }
+
+  /** Set/get the number of iterations, counted over all levels, between
+   *  checkpoints.  Default 0, i.e. no checkpoints by iteration count. */
+  void SetCheckpointIterationPeriod( unsigned int numIterations )
+    { m_CheckpointIterationPeriod = numIterations; }
+  unsigned int GetCheckpointIterationPeriod( void ) const
+    { return m_CheckpointIterationPeriod; }
+
+  /** Set/get the wall clock time, in seconds, between checkpoints.
+   *  Default 0, i.e. no checkpoints by time. */
+  void SetCheckpointTimePeriod( double seconds )
+    { m_CheckpointTimePeriod = seconds; }
+  double GetCheckpointTimePeriod( void ) const
+    { return m_CheckpointTimePeriod; }
+
+  /** Set/get whether to resume the registration from the checkpoint file.
+   *  The levels completed before the checkpoint are skipped, and the
+   *  checkpointed level continues after the checkpointed iteration, so that
+   *  the result matches that of an uninterrupted registration.  Default
+   *  false. */
+  void SetResumeFromCheckpoint( bool resume )
+    { m_ResumeFromCheckpoint = resume; }
+  bool GetResumeFromCheckpoint( void ) const
+    { return m_ResumeFromCheckpoint; }
+
 protected:
   DiffusiveRegistrationFilter( void );
   virtual ~DiffusiveRegistrationFilter( void ) {}
@@ -368,6 +430,11 @@ protected:
   /** Initialization occuring before the registration iterations begin. */
   virtual void Initialize( void );
 
+  /** Halts on the levels completed before the checkpoint being resumed,
+   *  and restores the iteration state when reaching the checkpointed
+   *  level. */
+  virtual bool Halt( void );
+
   /** Allocate images used during the registration. */
   virtual void AllocateImageMembers( void );
 
@@ -376,6 +443,26 @@ protected:
    *  classes. */
   virtual void InitializeDeformationComponentAndDerivativeImages( void );
 
+  /** Allocate a derivative image on the grid of the template image.  If the
+   *  derivative images are not stored, only the image information is set.
+   *  Derived classes should use this for the deformation component
+   *  derivative images. */
+  template< class TDerivativeImagePointer >
+  void AllocateSpaceForDerivativeImage( TDerivativeImagePointer & image,
+    const OutputImagePointer & templateImage ) const
+    {
+    if( m_StoreDerivativeImages )
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage( image,
+        templateImage );
+      }
+    else
+      {
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImageRegion( image,
+        templateImage, ThreadRegionType() );
+      }
+    }
+
   /** Allocate and populate the diffusion tensor images.
    *  Reimplement in derived classes. */
   virtual void ComputeDiffusionTensorImages( void );
@@ -431,17 +518,35 @@ protected:
    *  \sa ComputeDeformationComponentDerivativeImageHelperThreadedCallback */
    virtual void ThreadedComputeDeformationComponentDerivativeImageHelper(
        const DeformationVectorComponentImagePointer & deformationComponentImage,
+       const ScalarDerivativeImagePointer & firstOrderDerivativeImage,
+       const TensorDerivativeImagePointer & secondOrderDerivativeImage,
        const ThreadDeformationVectorComponentImageRegionType
          & deformationVectorComponenntRegionToProcess,
        const ThreadScalarDerivativeImageRegionType
          & scalarDerivativeRegionToProcess,
        const ThreadTensorDerivativeImageRegionType
          & tensorDerivativeRegionToProcess,
-       int term,
-       int dimension,
        const SpacingType & spacing,
        const typename OutputImageType::SizeType & radius ) const;
 
+  /** Splits a thread region into the slabs within which the derivatives are
+   *  recomputed when the derivative images are not stored.  If they are
+   *  stored, the region is returned as is. */
+  virtual void SplitRegionIntoDerivativeSlabs( const ThreadRegionType & region,
+    std::vector< ThreadRegionType > & slabs ) const;
+
+  /** Computes the first- and second-order partial derivatives of the
+   *  deformation component images and the first-order partial derivatives
+   *  of the diffusion tensor images over a region, when the derivative
+   *  images are not stored.  The arrays receive new images buffering the
+   *  region padded by the neighborhood radius, shared between terms in the
+   *  same way as the member derivative images. */
+  virtual void ComputeDerivativeImagesForRegion(
+      const ThreadRegionType & region,
+      ScalarDerivativeImageArrayVectorType & firstOrderArrays,
+      TensorDerivativeImageArrayVectorType & secondOrderArrays,
+      TensorDerivativeImageVectorType & tensorDerivativeImages );
+
   /** Get a diffusion tensor image */
   DiffusionTensorImageType * GetDiffusionTensorImage( int index ) const
     {
@@ -750,6 +855,15 @@ protected:
    * change metrics and evaluate the stopping conditions. */
   virtual void PostProcessIteration(TimeStepType stepSize);
 
+  /** Version of the checkpoint file layout */
+  itkStaticConstMacro( CheckpointFileVersion, unsigned int, 1 );
+
+  /** Writes the current registration state to the checkpoint file */
+  virtual void WriteCheckpoint( void ) const;
+
+  /** Reads the registration state to resume from the checkpoint file */
+  virtual void ReadCheckpoint( void );
+
 private:
   // Purposely not implemented
   DiffusiveRegistrationFilter(const Self&);
@@ -856,12 +970,39 @@ private:
   unsigned int                              m_StoppingCriterionEvaluationPeriod;
   double                                    m_StoppingCriterionMaxTotalEnergyChange;
 
+  /** Whether the derivative images are stored or recomputed per slab */
+  bool                                      m_StoreDerivativeImages;
+
   /** Parameters for energies and update magnitude metrics */
   EnergiesStruct                            m_Energies;
   EnergiesStruct                            m_PreviousEnergies;
   UpdateMetricsStruct                       m_UpdateMetrics;
   UpdateMetricsStruct                       m_PreviousUpdateMetrics;
 
+  /** State carried between iterations and levels */
+  std::vector< TimeStepType >               m_TimeStepHistory;
+  TimeStepType                              m_TotalTime;
+  double                                    m_TotalEnergyChangeInEvaluationPeriod;
+  unsigned int                              m_NumberOfEnergyViolations;
+  bool                                      m_RegistrationStopped;
+
+  /** Checkpoint parameters */
+  std::string                               m_CheckpointFileName;
+  unsigned int                              m_CheckpointIterationPeriod;
+  double                                    m_CheckpointTimePeriod;
+  RealTimeClock::Pointer                    m_CheckpointClock;
+  RealTimeClock::TimeStampType              m_LastCheckpointTime;
+
+  /** State read from a checkpoint, applied when the registration reaches the
+   *  checkpointed level */
+  bool                                      m_ResumeFromCheckpoint;
+  bool                                      m_ResumePending;
+  unsigned int                              m_ResumeLevel;
+  IdentifierType                            m_ResumeElapsedIterations;
+  double                                    m_ResumeRMSChange;
+  bool                                      m_ResumeRegistrationStopped;
+  OutputImagePointer                        m_ResumeDeformationField;
+
 }; // End class DiffusiveRegistrationFilter
 
 } // End namespace tube
@@ -26,7 +26,8 @@ limitations under the License.
 
 #include "itktubeDiffusiveRegistrationFilter.h"
 
-#include "itktubeDiffusiveRegistrationFilterUtils.h"
+#include <cstdio>
+#include <fstream>
 
 namespace itk
 {
@@ -65,10 +66,30 @@ DiffusiveRegistrationFilter
   m_StoppingCriterionEvaluationPeriod     = 50;
   m_StoppingCriterionMaxTotalEnergyChange = -1;
 
+  m_StoreDerivativeImages = true;
+
   m_Energies.zero();
   m_PreviousEnergies.zero();
   m_UpdateMetrics.zero();
   m_PreviousUpdateMetrics.zero();
+
+  m_TotalTime                           = 0.0;
+  m_TotalEnergyChangeInEvaluationPeriod = 0.0;
+  m_NumberOfEnergyViolations            = 0;
+  m_RegistrationStopped                 = false;
+
+  m_CheckpointIterationPeriod = 0;
+  m_CheckpointTimePeriod      = 0.0;
+  m_CheckpointClock           = RealTimeClock::New();
+  m_LastCheckpointTime        = m_CheckpointClock->GetTimeInSeconds();
+
+  m_ResumeFromCheckpoint      = false;
+  m_ResumePending             = false;
+  m_ResumeLevel               = 0;
+  m_ResumeElapsedIterations   = 0;
+  m_ResumeRMSChange           = 0.0;
+  m_ResumeRegistrationStopped = false;
+  m_ResumeDeformationField    = 0;
 }
 
 
@@ -145,6 +166,16 @@ DiffusiveRegistrationFilter
      << m_StoppingCriterionEvaluationPeriod << std::endl;
   os << "Stopping criterion maximum total energy change: "
      << m_StoppingCriterionMaxTotalEnergyChange << std::endl;
+  os << indent << "Store derivative images: " << m_StoreDerivativeImages
+     << std::endl;
+  os << indent << "Checkpoint file name: " << m_CheckpointFileName
+     << std::endl;
+  os << indent << "Checkpoint iteration period: "
+     << m_CheckpointIterationPeriod << std::endl;
+  os << indent << "Checkpoint time period: " << m_CheckpointTimePeriod
+     << std::endl;
+  os << indent << "Resume from checkpoint: " << m_ResumeFromCheckpoint
+     << std::endl;
 }
 
 
@@ -230,6 +261,40 @@ DiffusiveRegistrationFilter
 
   // Update the current multiresolution level (when registering, level is 1..N)
   m_CurrentLevel++;
+  m_RegistrationStopped = false;
+
+  // When resuming, read the checkpoint at the start of the registration and
+  // skip the levels that were completed before it was written
+  if( m_ResumeFromCheckpoint && m_CurrentLevel == 1 )
+    {
+    this->ReadCheckpoint();
+    }
+  if( m_ResumePending && m_CurrentLevel < m_ResumeLevel )
+    {
+    return;
+    }
+  if( m_ResumePending && m_CurrentLevel == m_ResumeLevel )
+    {
+    OutputImagePointer output = this->GetOutput();
+    if( !DiffusiveRegistrationFilterUtils::CompareImageAttributes(
+          m_ResumeDeformationField.GetPointer(), output.GetPointer() ) )
+      {
+      itkExceptionMacro( << "Checkpoint deformation field attributes do not "
+                         << "match level " << m_CurrentLevel );
+      }
+    ImageRegionIterator< OutputImageType > checkpointIt(
+        m_ResumeDeformationField,
+        m_ResumeDeformationField->GetLargestPossibleRegion() );
+    ImageRegionIterator< OutputImageType > outputIt(
+        output, output->GetLargestPossibleRegion() );
+    for( checkpointIt.GoToBegin(), outputIt.GoToBegin();
+         !outputIt.IsAtEnd(); ++checkpointIt, ++outputIt )
+      {
+      outputIt.Set( checkpointIt.Get() );
+      }
+    output->Modified();
+    m_ResumeDeformationField = 0;
+    }
 
   // Check the time step for stability if we are using the diffusive or
   // anisotropic diffusive regularization terms
@@ -303,11 +368,47 @@ DiffusiveRegistrationFilter
     {
     this->InitializeDeformationComponentAndDerivativeImages();
     this->ComputeDiffusionTensorImages();
-    this->ComputeDiffusionTensorDerivativeImages();
+    if( m_StoreDerivativeImages )
+      {
+      this->ComputeDiffusionTensorDerivativeImages();
+      }
     this->ComputeMultiplicationVectorImages();
     }
 }
 
+/**
+ * Skips the levels completed before a checkpoint and restores the iteration
+ * state of the checkpointed level
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+bool
+DiffusiveRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::Halt( void )
+{
+  if( m_ResumePending )
+    {
+    if( m_CurrentLevel < m_ResumeLevel )
+      {
+      return true;
+      }
+
+    // The superclass resets the elapsed iterations after Initialize(), so the
+    // iteration state can only be restored here, before the first iteration
+    this->SetElapsedIterations( m_ResumeElapsedIterations );
+    this->SetRMSChange( m_ResumeRMSChange );
+    if( m_ResumeRegistrationStopped )
+      {
+      m_RegistrationStopped = true;
+      this->StopRegistration();
+      }
+    m_ResumePending = false;
+    m_LastCheckpointTime = m_CheckpointClock->GetTimeInSeconds();
+    }
+
+  return Superclass::Halt();
+}
+
 /**
  * Allocate the images we will use to store data computed during the
  * registration
@@ -339,8 +440,7 @@ DiffusiveRegistrationFilter
       DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
             diffusionTensorPointer, output );
       tensorDerivativePointer = TensorDerivativeImageType::New();
-      DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
-            tensorDerivativePointer, output );
+      this->AllocateSpaceForDerivativeImage( tensorDerivativePointer, output );
       }
     if( (int) m_DiffusionTensorImages.size() < numTerms )
       {
@@ -434,12 +534,12 @@ DiffusiveRegistrationFilter
     {
     m_DeformationComponentFirstOrderDerivativeArrays[GAUSSIAN][i]
         = ScalarDerivativeImageType::New();
-    DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+    this->AllocateSpaceForDerivativeImage(
         m_DeformationComponentFirstOrderDerivativeArrays[GAUSSIAN][i], output );
 
     m_DeformationComponentSecondOrderDerivativeArrays[GAUSSIAN][i]
         = TensorDerivativeImageType::New();
-    DiffusiveRegistrationFilterUtils::AllocateSpaceForImage(
+    this->AllocateSpaceForDerivativeImage(
         m_DeformationComponentSecondOrderDerivativeArrays[GAUSSIAN][i],
         output );
     }
@@ -674,11 +774,13 @@ DiffusiveRegistrationFilter
     {
     str->Filter->ThreadedComputeDeformationComponentDerivativeImageHelper(
         str->DeformationComponentImage,
+        str->Filter->m_DeformationComponentFirstOrderDerivativeArrays
+          [str->Term][str->Dimension],
+        str->Filter->m_DeformationComponentSecondOrderDerivativeArrays
+          [str->Term][str->Dimension],
         splitDeformationVectorComponentRegion,
         splitScalarDerivativeRegion,
         splitTensorDerivativeRegion,
-        str->Term,
-        str->Dimension,
         str->Spacing,
         str->Radius );
     }
@@ -695,22 +797,18 @@ DiffusiveRegistrationFilter
   < TFixedImage, TMovingImage, TDeformationField >
 ::ThreadedComputeDeformationComponentDerivativeImageHelper(
     const DeformationVectorComponentImagePointer & deformationComponentImage,
+    const ScalarDerivativeImagePointer & firstOrderDerivativeImage,
+    const TensorDerivativeImagePointer & secondOrderDerivativeImage,
     const ThreadDeformationVectorComponentImageRegionType
       & deformationVectorComponentRegionToProcess,
     const ThreadScalarDerivativeImageRegionType
       & scalarDerivativeRegionToProcess,
     const ThreadTensorDerivativeImageRegionType
       & tensorDerivativeRegionToProcess,
-    int term,
-    int dimension,
     const SpacingType & spacing,
     const typename OutputImageType::SizeType & radius ) const
 {
-  ScalarDerivativeImagePointer firstOrderDerivativeImage
-      = m_DeformationComponentFirstOrderDerivativeArrays[term][dimension];
   assert( firstOrderDerivativeImage );
-  TensorDerivativeImagePointer secondOrderDerivativeImage
-      = m_DeformationComponentSecondOrderDerivativeArrays[term][dimension];
   assert( secondOrderDerivativeImage );
 
   // Get the FiniteDifferenceFunction to use in calculations.
@@ -767,6 +865,214 @@ DiffusiveRegistrationFilter
     }
 }
 
+/**
+ * Splits a thread region into the slabs within which the derivatives are
+ * recomputed
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+DiffusiveRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::SplitRegionIntoDerivativeSlabs( const ThreadRegionType & region,
+  std::vector< ThreadRegionType > & slabs ) const
+{
+  slabs.clear();
+  if( m_StoreDerivativeImages )
+    {
+    slabs.push_back( region );
+    return;
+    }
+
+  // Slabs of a few slices along the last dimension keep the recomputed
+  // derivative images small, while the slices on either side of each slab
+  // that are needed by the derivative neighborhoods remain a small overhead
+  const unsigned int slabThickness = 8;
+  const unsigned int lastDimension = ImageDimension - 1;
+  const typename ThreadRegionType::IndexValueType regionEnd
+    = region.GetIndex( lastDimension ) + region.GetSize( lastDimension );
+  ThreadRegionType slab = region;
+  for( typename ThreadRegionType::IndexValueType start
+    = region.GetIndex( lastDimension ); start < regionEnd;
+    start += slabThickness )
+    {
+    slab.SetIndex( lastDimension, start );
+    slab.SetSize( lastDimension, std::min(
+      static_cast< typename ThreadRegionType::SizeValueType >(
+        regionEnd - start ),
+      static_cast< typename ThreadRegionType::SizeValueType >(
+        slabThickness ) ) );
+    slabs.push_back( slab );
+    }
+}
+
+/**
+ * Computes the deformation component and diffusion tensor derivatives over a
+ * region
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+DiffusiveRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::ComputeDerivativeImagesForRegion(
+    const ThreadRegionType & region,
+    ScalarDerivativeImageArrayVectorType & firstOrderArrays,
+    TensorDerivativeImageArrayVectorType & secondOrderArrays,
+    TensorDerivativeImageVectorType & tensorDerivativeImages )
+{
+  assert( this->GetComputeRegularizationTerm() );
+  assert( this->GetOutput() );
+
+  OutputImagePointer output = this->GetOutput();
+  const SpacingType spacing = output->GetSpacing();
+  const RegistrationFunctionType * df = this->GetRegistrationFunctionPointer();
+  assert( df );
+  typename RegularizationFunctionType::ConstPointer reg
+      = df->GetRegularizationFunctionPointer();
+  assert( reg );
+  const typename OutputImageType::SizeType radius = df->GetRadius();
+
+  // The images buffer the region padded by the radius, so that the
+  // neighborhoods have the same boundary faces as they have on the whole
+  // images
+  ThreadRegionType paddedRegion = region;
+  paddedRegion.PadByRadius( radius );
+  paddedRegion.Crop( output->GetLargestPossibleRegion() );
+
+  int numTerms = this->GetNumberOfTerms();
+  firstOrderArrays = m_DeformationComponentFirstOrderDerivativeArrays;
+  secondOrderArrays = m_DeformationComponentSecondOrderDerivativeArrays;
+  tensorDerivativeImages = m_DiffusionTensorDerivativeImages;
+
+  // Deformation component derivatives
+  DeformationComponentImageArrayType deformationComponentImageArray;
+  for( int i = 0; i < numTerms; i++ )
+    {
+    bool haveComponents = false;
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      if( !m_DeformationComponentFirstOrderDerivativeArrays[i][j] )
+        {
+        continue;
+        }
+
+      // Terms sharing derivative images also share the recomputed ones
+      bool shared = false;
+      for( int k = 0; k < i && !shared; k++ )
+        {
+        if( m_DeformationComponentFirstOrderDerivativeArrays[k][j]
+            == m_DeformationComponentFirstOrderDerivativeArrays[i][j] )
+          {
+          firstOrderArrays[i][j] = firstOrderArrays[k][j];
+          secondOrderArrays[i][j] = secondOrderArrays[k][j];
+          shared = true;
+          }
+        }
+      if( shared )
+        {
+        continue;
+        }
+
+      // Extract the components of this term over the padded region
+      if( !haveComponents )
+        {
+        DeformationFieldPointer deformationComponentImage
+            = this->GetDeformationComponentImage( i );
+        assert( deformationComponentImage );
+        ImageRegionIterator< DeformationFieldType > fieldIt(
+            deformationComponentImage, paddedRegion );
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          deformationComponentImageArray[d]
+              = DeformationVectorComponentImageType::New();
+          DiffusiveRegistrationFilterUtils::AllocateSpaceForImageRegion(
+              deformationComponentImageArray[d], output, paddedRegion );
+          ImageRegionIterator< DeformationVectorComponentImageType >
+              componentIt( deformationComponentImageArray[d], paddedRegion );
+          for( fieldIt.GoToBegin(), componentIt.GoToBegin();
+               !componentIt.IsAtEnd(); ++fieldIt, ++componentIt )
+            {
+            componentIt.Set( fieldIt.Get()[d] );
+            }
+          }
+        haveComponents = true;
+        }
+
+      firstOrderArrays[i][j] = ScalarDerivativeImageType::New();
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImageRegion(
+          firstOrderArrays[i][j], output, paddedRegion );
+      secondOrderArrays[i][j] = TensorDerivativeImageType::New();
+      DiffusiveRegistrationFilterUtils::AllocateSpaceForImageRegion(
+          secondOrderArrays[i][j], output, paddedRegion );
+      this->ThreadedComputeDeformationComponentDerivativeImageHelper(
+          deformationComponentImageArray[j],
+          firstOrderArrays[i][j],
+          secondOrderArrays[i][j],
+          region,
+          region,
+          region,
+          spacing,
+          radius );
+      }
+    }
+
+  // Diffusion tensor derivatives
+  for( int i = 0; i < numTerms; i++ )
+    {
+    if( !m_DiffusionTensorDerivativeImages[i] )
+      {
+      continue;
+      }
+    bool shared = false;
+    for( int k = 0; k < i && !shared; k++ )
+      {
+      if( m_DiffusionTensorDerivativeImages[k]
+          == m_DiffusionTensorDerivativeImages[i] )
+        {
+        tensorDerivativeImages[i] = tensorDerivativeImages[k];
+        shared = true;
+        }
+      }
+    if( shared )
+      {
+      continue;
+      }
+
+    DiffusionTensorImagePointer tensorImage = m_DiffusionTensorImages[i];
+    assert( tensorImage );
+    TensorDerivativeImagePointer tensorDerivativeImage
+        = TensorDerivativeImageType::New();
+    DiffusiveRegistrationFilterUtils::AllocateSpaceForImageRegion(
+        tensorDerivativeImage, output, paddedRegion );
+    tensorDerivativeImages[i] = tensorDerivativeImage;
+
+    FaceStruct< DiffusionTensorImagePointer > tensorStruct(
+        tensorImage, region, radius );
+    DiffusionTensorNeighborhoodType tensorNeighborhood;
+
+    FaceStruct< TensorDerivativeImagePointer > tensorDerivativeStruct(
+        tensorDerivativeImage, region, radius );
+    TensorDerivativeImageRegionType tensorDerivativeRegion;
+
+    for( tensorStruct.GoToBegin(), tensorDerivativeStruct.GoToBegin();
+         !tensorDerivativeStruct.IsAtEnd();
+         tensorStruct.Increment(), tensorDerivativeStruct.Increment() )
+      {
+      tensorStruct.SetIteratorToCurrentFace(
+          tensorNeighborhood, tensorImage, radius );
+      tensorDerivativeStruct.SetIteratorToCurrentFace(
+          tensorDerivativeRegion, tensorDerivativeImage );
+
+      for( tensorNeighborhood.GoToBegin(), tensorDerivativeRegion.GoToBegin();
+           !tensorNeighborhood.IsAtEnd();
+           ++tensorNeighborhood, ++tensorDerivativeRegion )
+        {
+        reg->ComputeDiffusionTensorFirstOrderPartialDerivatives(
+            tensorNeighborhood, tensorDerivativeRegion, spacing );
+        }
+      }
+    }
+}
+
 /**
  * Initialize the state of the filter and equation before each iteration.
  */
@@ -785,7 +1091,10 @@ DiffusiveRegistrationFilter
   if( this->GetComputeRegularizationTerm() )
     {
     this->UpdateDeformationComponentImages( this->GetOutput() );
-    this->ComputeDeformationComponentDerivativeImages();
+    if( m_StoreDerivativeImages )
+      {
+      this->ComputeDeformationComponentDerivativeImages();
+      }
     }
 
   // Initialize the energy and update metrics
@@ -1007,52 +1316,6 @@ DiffusiveRegistrationFilter
   const typename OutputImageType::SizeType radius = df->GetRadius();
   OutputImagePointer output = this->GetOutput();
 
-  // Break the input into a series of regions.  The first region is free
-  // of boundary conditions, the rest with boundary conditions.  We operate
-  // on the output region because the input has been copied to the output.
-
-  // Setup the types of structs for the face calculations
-  // (Struct handles the case where the image pointer doesn't exist)
-  FaceStruct< OutputImagePointer > outputStruct(
-      output, regionToProcess, radius );
-  NeighborhoodType outputNeighborhood;
-
-  ImageRegionIterator< UpdateBufferType > updateIt;
-
-  FaceStruct< DiffusionTensorImagePointer > tensorStruct(
-      m_DiffusionTensorImages, tensorRegionToProcess, radius );
-  DiffusionTensorNeighborhoodVectorType tensorNeighborhoods;
-
-  FaceStruct< ScalarDerivativeImagePointer >
-      deformationComponentFirstOrderStruct(
-          m_DeformationComponentFirstOrderDerivativeArrays,
-          scalarDerivativeRegionToProcess,
-          radius );
-  ScalarDerivativeImageRegionArrayVectorType
-      deformationComponentFirstOrderRegionArrays;
-
-  FaceStruct< TensorDerivativeImagePointer >
-      deformationComponentSecondOrderStruct(
-          m_DeformationComponentSecondOrderDerivativeArrays,
-          tensorDerivativeRegionToProcess,
-          radius );
-  TensorDerivativeImageRegionArrayVectorType
-      deformationComponentSecondOrderRegionArrays;
-
-  FaceStruct< TensorDerivativeImagePointer > tensorDerivativeStruct(
-      m_DiffusionTensorDerivativeImages,
-      tensorDerivativeRegionToProcess,
-      radius );
-  TensorDerivativeImageRegionVectorType tensorDerivativeRegions;
-
-  FaceStruct< DeformationFieldPointer > multiplicationVectorStruct(
-      m_MultiplicationVectorImageArrays, regionToProcess, radius );
-  DeformationVectorImageRegionArrayVectorType multiplicationVectorRegionArrays;
-
-  FaceStruct< FixedImagePointer > stoppingCriterionMaskStruct(
-      m_StoppingCriterionMask, stoppingCriterionMaskRegionToProcess, radius );
-  StoppingCriterionMaskImageRegionType stoppingCriterionMaskRegion;
-
   // Get the type of registration
   bool computeRegularization = this->GetComputeRegularizationTerm();
   bool haveStoppingCriterionMask = ( m_StoppingCriterionMask.GetPointer() != 0 );
@@ -1061,168 +1324,250 @@ DiffusiveRegistrationFilter
   UpdateMetricsIntermediateStruct localUpdateMetricsIntermediate;
   localUpdateMetricsIntermediate.zero();
 
-  // Go to the first face
-  outputStruct.GoToBegin();
-  if( computeRegularization )
+  // When the derivative images are not stored, the region is processed in
+  // slabs, and the derivatives are recomputed for each slab
+  ScalarDerivativeImageArrayVectorType deformationComponentFirstOrderArrays
+      = m_DeformationComponentFirstOrderDerivativeArrays;
+  TensorDerivativeImageArrayVectorType deformationComponentSecondOrderArrays
+      = m_DeformationComponentSecondOrderDerivativeArrays;
+  TensorDerivativeImageVectorType diffusionTensorDerivativeImages
+      = m_DiffusionTensorDerivativeImages;
+
+  std::vector< ThreadRegionType > slabs;
+  this->SplitRegionIntoDerivativeSlabs( regionToProcess, slabs );
+  for( unsigned int slab = 0; slab < slabs.size(); slab++ )
     {
-    tensorStruct.GoToBegin();
-    deformationComponentFirstOrderStruct.GoToBegin();
-    deformationComponentSecondOrderStruct.GoToBegin();
-    tensorDerivativeStruct.GoToBegin();
-    multiplicationVectorStruct.GoToBegin();
-    }
-  if( haveStoppingCriterionMask )
-    {
-    stoppingCriterionMaskStruct.GoToBegin();
-    }
-
-  // Iterate over each face
-  while( !outputStruct.IsAtEnd() )
-    {
-    // Set the neighborhood iterators to the current face
-    outputStruct.SetIteratorToCurrentFace( outputNeighborhood, output, radius );
-    outputStruct.SetIteratorToCurrentFace( updateIt, m_UpdateBuffer );
-    if( computeRegularization )
+    const ThreadRegionType & slabRegion = slabs[slab];
+    ThreadDiffusionTensorImageRegionType slabTensorRegion
+        = tensorRegionToProcess;
+    slabTensorRegion.Crop( slabRegion );
+    ThreadTensorDerivativeImageRegionType slabTensorDerivativeRegion
+        = tensorDerivativeRegionToProcess;
+    slabTensorDerivativeRegion.Crop( slabRegion );
+    ThreadScalarDerivativeImageRegionType slabScalarDerivativeRegion
+        = scalarDerivativeRegionToProcess;
+    slabScalarDerivativeRegion.Crop( slabRegion );
+    ThreadStoppingCriterionMaskImageRegionType slabStoppingCriterionMaskRegion
+        = stoppingCriterionMaskRegionToProcess;
+    slabStoppingCriterionMaskRegion.Crop( slabRegion );
+
+    if( computeRegularization && !m_StoreDerivativeImages )
       {
-      tensorStruct.SetIteratorToCurrentFace(
-          tensorNeighborhoods, m_DiffusionTensorImages, radius );
-      deformationComponentFirstOrderStruct.SetIteratorToCurrentFace(
-          deformationComponentFirstOrderRegionArrays,
-          m_DeformationComponentFirstOrderDerivativeArrays );
-      deformationComponentSecondOrderStruct.SetIteratorToCurrentFace(
-          deformationComponentSecondOrderRegionArrays,
-          m_DeformationComponentSecondOrderDerivativeArrays );
-      tensorDerivativeStruct.SetIteratorToCurrentFace(
-          tensorDerivativeRegions, m_DiffusionTensorDerivativeImages );
-      multiplicationVectorStruct.SetIteratorToCurrentFace(
-          multiplicationVectorRegionArrays,
-          m_MultiplicationVectorImageArrays );
-      }
-    if( haveStoppingCriterionMask )
-      {
-      stoppingCriterionMaskStruct.SetIteratorToCurrentFace(
-          stoppingCriterionMaskRegion, m_StoppingCriterionMask );
+      this->ComputeDerivativeImagesForRegion( slabRegion,
+        deformationComponentFirstOrderArrays,
+        deformationComponentSecondOrderArrays,
+        diffusionTensorDerivativeImages );
       }
 
-    // Go to the beginning of the neighborhood for this face
-    outputNeighborhood.GoToBegin();
-    updateIt.GoToBegin();
+    // Break the input into a series of regions.  The first region is free
+    // of boundary conditions, the rest with boundary conditions.  We operate
+    // on the output region because the input has been copied to the output.
+
+    // Setup the types of structs for the face calculations
+    // (Struct handles the case where the image pointer doesn't exist)
+    FaceStruct< OutputImagePointer > outputStruct(
+        output, slabRegion, radius );
+    NeighborhoodType outputNeighborhood;
+
+    ImageRegionIterator< UpdateBufferType > updateIt;
+
+    FaceStruct< DiffusionTensorImagePointer > tensorStruct(
+        m_DiffusionTensorImages, slabTensorRegion, radius );
+    DiffusionTensorNeighborhoodVectorType tensorNeighborhoods;
+
+    FaceStruct< ScalarDerivativeImagePointer >
+        deformationComponentFirstOrderStruct(
+            deformationComponentFirstOrderArrays,
+            slabScalarDerivativeRegion,
+            radius );
+    ScalarDerivativeImageRegionArrayVectorType
+        deformationComponentFirstOrderRegionArrays;
+
+    FaceStruct< TensorDerivativeImagePointer >
+        deformationComponentSecondOrderStruct(
+            deformationComponentSecondOrderArrays,
+            slabTensorDerivativeRegion,
+            radius );
+    TensorDerivativeImageRegionArrayVectorType
+        deformationComponentSecondOrderRegionArrays;
+
+    FaceStruct< TensorDerivativeImagePointer > tensorDerivativeStruct(
+        diffusionTensorDerivativeImages,
+        slabTensorDerivativeRegion,
+        radius );
+    TensorDerivativeImageRegionVectorType tensorDerivativeRegions;
+
+    FaceStruct< DeformationFieldPointer > multiplicationVectorStruct(
+        m_MultiplicationVectorImageArrays, slabRegion, radius );
+    DeformationVectorImageRegionArrayVectorType multiplicationVectorRegionArrays;
+
+    FaceStruct< FixedImagePointer > stoppingCriterionMaskStruct(
+        m_StoppingCriterionMask, slabStoppingCriterionMaskRegion, radius );
+    StoppingCriterionMaskImageRegionType stoppingCriterionMaskRegion;
+
+    // Go to the first face
+    outputStruct.GoToBegin();
     if( computeRegularization )
       {
-      for( int i = 0; i < this->GetNumberOfTerms(); i++ )
-        {
-        tensorNeighborhoods[i].GoToBegin();
-        tensorDerivativeRegions[i].GoToBegin();
-        for( unsigned int j = 0; j < ImageDimension; j++ )
-          {
-          deformationComponentFirstOrderRegionArrays[i][j].GoToBegin();
-          deformationComponentSecondOrderRegionArrays[i][j].GoToBegin();
-          multiplicationVectorRegionArrays[i][j].GoToBegin();
-          }
-        }
+      tensorStruct.GoToBegin();
+      deformationComponentFirstOrderStruct.GoToBegin();
+      deformationComponentSecondOrderStruct.GoToBegin();
+      tensorDerivativeStruct.GoToBegin();
+      multiplicationVectorStruct.GoToBegin();
       }
     if( haveStoppingCriterionMask )
       {
-      stoppingCriterionMaskRegion.GoToBegin();
+      stoppingCriterionMaskStruct.GoToBegin();
       }
 
-    // Iterate through the neighborhood for this face and compute updates
-    while( !outputNeighborhood.IsAtEnd() )
+    // Iterate over each face
+    while( !outputStruct.IsAtEnd() )
       {
-      typename UpdateBufferType::PixelType updateTerm;
-      typename UpdateBufferType::PixelType intensityDistanceTerm;
-      typename UpdateBufferType::PixelType regularizationTerm;
-
-      // Compute updates
-      updateTerm = df->ComputeUpdate(
-          outputNeighborhood,
-          tensorNeighborhoods,
-          deformationComponentFirstOrderRegionArrays,
-          deformationComponentSecondOrderRegionArrays,
-          tensorDerivativeRegions,
-          multiplicationVectorRegionArrays,
-          globalData,
-          intensityDistanceTerm,
-          regularizationTerm );
-      updateIt.Value() = updateTerm;
-
-      // Get whether or not to include this pixel in the stopping criterion
-      bool includeInStoppingCriterion = true;
+      // Set the neighborhood iterators to the current face
+      outputStruct.SetIteratorToCurrentFace( outputNeighborhood, output, radius );
+      outputStruct.SetIteratorToCurrentFace( updateIt, m_UpdateBuffer );
+      if( computeRegularization )
+        {
+        tensorStruct.SetIteratorToCurrentFace(
+            tensorNeighborhoods, m_DiffusionTensorImages, radius );
+        deformationComponentFirstOrderStruct.SetIteratorToCurrentFace(
+            deformationComponentFirstOrderRegionArrays,
+            deformationComponentFirstOrderArrays );
+        deformationComponentSecondOrderStruct.SetIteratorToCurrentFace(
+            deformationComponentSecondOrderRegionArrays,
+            deformationComponentSecondOrderArrays );
+        tensorDerivativeStruct.SetIteratorToCurrentFace(
+            tensorDerivativeRegions, diffusionTensorDerivativeImages );
+        multiplicationVectorStruct.SetIteratorToCurrentFace(
+            multiplicationVectorRegionArrays,
+            m_MultiplicationVectorImageArrays );
+        }
       if( haveStoppingCriterionMask )
         {
-        includeInStoppingCriterion
-            = ( stoppingCriterionMaskRegion.Value() == 0.0 );
+        stoppingCriterionMaskStruct.SetIteratorToCurrentFace(
+            stoppingCriterionMaskRegion, m_StoppingCriterionMask );
         }
 
-      // Update the metrics
-      if( includeInStoppingCriterion )
+      // Go to the beginning of the neighborhood for this face
+      outputNeighborhood.GoToBegin();
+      updateIt.GoToBegin();
+      if( computeRegularization )
         {
-        double squaredTotalUpdateMagnitude = 0.0;
-        double squaredIntensityDistanceUpdateMagnitude = 0.0;
-        double squaredRegularizationUpdateMagnitude = 0.0;
-        for( unsigned int i = 0; i < ImageDimension; i++ )
+        for( int i = 0; i < this->GetNumberOfTerms(); i++ )
           {
-          squaredTotalUpdateMagnitude += vnl_math_sqr( updateTerm[i] );
-          squaredIntensityDistanceUpdateMagnitude
-              += vnl_math_sqr( intensityDistanceTerm[i] );
-          squaredRegularizationUpdateMagnitude
-              += vnl_math_sqr( regularizationTerm[i] );
+          tensorNeighborhoods[i].GoToBegin();
+          tensorDerivativeRegions[i].GoToBegin();
+          for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+            deformationComponentFirstOrderRegionArrays[i][j].GoToBegin();
+            deformationComponentSecondOrderRegionArrays[i][j].GoToBegin();
+            multiplicationVectorRegionArrays[i][j].GoToBegin();
+            }
           }
-        localUpdateMetricsIntermediate.NumberOfPixelsProcessed++;
-        localUpdateMetricsIntermediate.SumOfSquaredTotalUpdateMagnitude
-            += squaredTotalUpdateMagnitude;
-        localUpdateMetricsIntermediate.SumOfSquaredIntensityDistanceUpdateMagnitude
-            += squaredIntensityDistanceUpdateMagnitude;
-        localUpdateMetricsIntermediate.SumOfSquaredRegularizationUpdateMagnitude
-            += squaredRegularizationUpdateMagnitude;
-        localUpdateMetricsIntermediate.SumOfTotalUpdateMagnitude
-            += vcl_sqrt( squaredTotalUpdateMagnitude );
-        localUpdateMetricsIntermediate.SumOfIntensityDistanceUpdateMagnitude
-            += vcl_sqrt( squaredIntensityDistanceUpdateMagnitude );
-        localUpdateMetricsIntermediate.SumOfRegularizationUpdateMagnitude
-            += vcl_sqrt( squaredRegularizationUpdateMagnitude );
+        }
+      if( haveStoppingCriterionMask )
+        {
+        stoppingCriterionMaskRegion.GoToBegin();
         }
 
-      // Go to the next neighborhood
-      ++outputNeighborhood;
-      ++updateIt;
-      if( computeRegularization )
+      // Iterate through the neighborhood for this face and compute updates
+      while( !outputNeighborhood.IsAtEnd() )
         {
-        for( int i = 0; i < this->GetNumberOfTerms(); i++ )
+        typename UpdateBufferType::PixelType updateTerm;
+        typename UpdateBufferType::PixelType intensityDistanceTerm;
+        typename UpdateBufferType::PixelType regularizationTerm;
+
+        // Compute updates
+        updateTerm = df->ComputeUpdate(
+            outputNeighborhood,
+            tensorNeighborhoods,
+            deformationComponentFirstOrderRegionArrays,
+            deformationComponentSecondOrderRegionArrays,
+            tensorDerivativeRegions,
+            multiplicationVectorRegionArrays,
+            globalData,
+            intensityDistanceTerm,
+            regularizationTerm );
+        updateIt.Value() = updateTerm;
+
+        // Get whether or not to include this pixel in the stopping criterion
+        bool includeInStoppingCriterion = true;
+        if( haveStoppingCriterionMask )
           {
-          ++tensorNeighborhoods[i];
-          ++tensorDerivativeRegions[i];
-          for( unsigned int j = 0; j < ImageDimension; j++ )
+          includeInStoppingCriterion
+              = ( stoppingCriterionMaskRegion.Value() == 0.0 );
+          }
+
+        // Update the metrics
+        if( includeInStoppingCriterion )
+          {
+          double squaredTotalUpdateMagnitude = 0.0;
+          double squaredIntensityDistanceUpdateMagnitude = 0.0;
+          double squaredRegularizationUpdateMagnitude = 0.0;
+          for( unsigned int i = 0; i < ImageDimension; i++ )
+            {
+            squaredTotalUpdateMagnitude += vnl_math_sqr( updateTerm[i] );
+            squaredIntensityDistanceUpdateMagnitude
+                += vnl_math_sqr( intensityDistanceTerm[i] );
+            squaredRegularizationUpdateMagnitude
+                += vnl_math_sqr( regularizationTerm[i] );
+            }
+          localUpdateMetricsIntermediate.NumberOfPixelsProcessed++;
+          localUpdateMetricsIntermediate.SumOfSquaredTotalUpdateMagnitude
+              += squaredTotalUpdateMagnitude;
+          localUpdateMetricsIntermediate.SumOfSquaredIntensityDistanceUpdateMagnitude
+              += squaredIntensityDistanceUpdateMagnitude;
+          localUpdateMetricsIntermediate.SumOfSquaredRegularizationUpdateMagnitude
+              += squaredRegularizationUpdateMagnitude;
+          localUpdateMetricsIntermediate.SumOfTotalUpdateMagnitude
+              += vcl_sqrt( squaredTotalUpdateMagnitude );
+          localUpdateMetricsIntermediate.SumOfIntensityDistanceUpdateMagnitude
+              += vcl_sqrt( squaredIntensityDistanceUpdateMagnitude );
+          localUpdateMetricsIntermediate.SumOfRegularizationUpdateMagnitude
+              += vcl_sqrt( squaredRegularizationUpdateMagnitude );
+          }
+
+        // Go to the next neighborhood
+        ++outputNeighborhood;
+        ++updateIt;
+        if( computeRegularization )
+          {
+          for( int i = 0; i < this->GetNumberOfTerms(); i++ )
             {
-            ++deformationComponentFirstOrderRegionArrays[i][j];
-            ++deformationComponentSecondOrderRegionArrays[i][j];
-            if( multiplicationVectorRegionArrays[i][j].GetImage() )
+            ++tensorNeighborhoods[i];
+            ++tensorDerivativeRegions[i];
+            for( unsigned int j = 0; j < ImageDimension; j++ )
               {
-              ++multiplicationVectorRegionArrays[i][j];
+              ++deformationComponentFirstOrderRegionArrays[i][j];
+              ++deformationComponentSecondOrderRegionArrays[i][j];
+              if( multiplicationVectorRegionArrays[i][j].GetImage() )
+                {
+                ++multiplicationVectorRegionArrays[i][j];
+                }
               }
             }
           }
+        if( haveStoppingCriterionMask )
+          {
+          ++stoppingCriterionMaskRegion;
+          }
+        }
+
+      // Go to the next face
+      outputStruct.Increment();
+      if( computeRegularization )
+        {
+        tensorStruct.Increment();
+        tensorDerivativeStruct.Increment();
+        deformationComponentFirstOrderStruct.Increment();
+        deformationComponentSecondOrderStruct.Increment();
+        multiplicationVectorStruct.Increment();
         }
       if( haveStoppingCriterionMask )
         {
-        ++stoppingCriterionMaskRegion;
+        stoppingCriterionMaskStruct.Increment();
         }
       }
-
-    // Go to the next face
-    outputStruct.Increment();
-    if( computeRegularization )
-      {
-      tensorStruct.Increment();
-      tensorDerivativeStruct.Increment();
-      deformationComponentFirstOrderStruct.Increment();
-      deformationComponentSecondOrderStruct.Increment();
-      multiplicationVectorStruct.Increment();
-      }
-    if( haveStoppingCriterionMask )
-      {
-      stoppingCriterionMaskStruct.Increment();
-      }
     }
 
   updateMetricsIntermediate.copyFrom(localUpdateMetricsIntermediate);
@@ -1252,7 +1597,10 @@ DiffusiveRegistrationFilter
     {
     this->UpdateDeformationComponentImages( outputField );
     // TODO this will compute first and second derivatives, we need first only
-    this->ComputeDeformationComponentDerivativeImages();
+    if( m_StoreDerivativeImages )
+      {
+      this->ComputeDeformationComponentDerivativeImages();
+      }
     }
 
   // Set up for multithreaded processing.
@@ -1363,32 +1711,6 @@ DiffusiveRegistrationFilter
   // Get the radius and output
   const typename OutputImageType::SizeType radius = df->GetRadius();
 
-  // Break the input into a series of regions.  The first region is free
-  // of boundary conditions, the rest with boundary conditions.  We operate
-  // on the output region because the input has been copied to the output.
-
-  // Setup the types of structs for the face calculations
-  // (Struct handles the case where the image pointer doesn't exist)
-  FaceStruct< OutputImagePointer > outputStruct(
-      output, regionToProcess, radius );
-  NeighborhoodType outputNeighborhood;
-
-  FaceStruct< DiffusionTensorImagePointer > tensorStruct(
-      m_DiffusionTensorImages, tensorRegionToProcess, radius );
-  DiffusionTensorNeighborhoodVectorType tensorNeighborhoods;
-
-  FaceStruct< ScalarDerivativeImagePointer >
-      deformationComponentFirstOrderStruct(
-          m_DeformationComponentFirstOrderDerivativeArrays,
-          scalarDerivativeRegionToProcess,
-          radius );
-  ScalarDerivativeImageRegionArrayVectorType
-      deformationComponentFirstOrderRegionArrays;
-
-  FaceStruct< FixedImagePointer > stoppingCriterionMaskStruct(
-      m_StoppingCriterionMask, stoppingCriterionMaskRegionToProcess, radius );
-  StoppingCriterionMaskImageRegionType stoppingCriterionMaskRegion;
-
   // Get the type of registration
   bool computeIntensityDistance = this->GetComputeIntensityDistanceTerm();
   bool computeRegularization = this->GetComputeRegularizationTerm();
@@ -1398,114 +1720,173 @@ DiffusiveRegistrationFilter
   double localIntensityDistanceEnergy = 0.0;
   double localRegularizationEnergy = 0.0;
 
-  // Go to the first face
-  outputStruct.GoToBegin();
-  if( computeRegularization )
+  // When the derivative images are not stored, the region is processed in
+  // slabs, and the derivatives are recomputed for each slab
+  ScalarDerivativeImageArrayVectorType deformationComponentFirstOrderArrays
+      = m_DeformationComponentFirstOrderDerivativeArrays;
+  TensorDerivativeImageArrayVectorType deformationComponentSecondOrderArrays
+      = m_DeformationComponentSecondOrderDerivativeArrays;
+  TensorDerivativeImageVectorType diffusionTensorDerivativeImages
+      = m_DiffusionTensorDerivativeImages;
+
+  std::vector< ThreadRegionType > slabs;
+  this->SplitRegionIntoDerivativeSlabs( regionToProcess, slabs );
+  for( unsigned int slab = 0; slab < slabs.size(); slab++ )
     {
-    tensorStruct.GoToBegin();
-    deformationComponentFirstOrderStruct.GoToBegin();
-    }
-  if( haveStoppingCriterionMask )
-    {
-    stoppingCriterionMaskStruct.GoToBegin();
-    }
+    const ThreadRegionType & slabRegion = slabs[slab];
+    ThreadDiffusionTensorImageRegionType slabTensorRegion
+        = tensorRegionToProcess;
+    slabTensorRegion.Crop( slabRegion );
+    ThreadScalarDerivativeImageRegionType slabScalarDerivativeRegion
+        = scalarDerivativeRegionToProcess;
+    slabScalarDerivativeRegion.Crop( slabRegion );
+    ThreadStoppingCriterionMaskImageRegionType slabStoppingCriterionMaskRegion
+        = stoppingCriterionMaskRegionToProcess;
+    slabStoppingCriterionMaskRegion.Crop( slabRegion );
+
+    if( computeRegularization && !m_StoreDerivativeImages )
+      {
+      this->ComputeDerivativeImagesForRegion( slabRegion,
+        deformationComponentFirstOrderArrays,
+        deformationComponentSecondOrderArrays,
+        diffusionTensorDerivativeImages );
+      }
 
-  // Iterate over each face
-  while( !outputStruct.IsAtEnd() )
-    {
-    // Set the neighborhood iterators to the current face
-    outputStruct.SetIteratorToCurrentFace( outputNeighborhood, output, radius );
+    // Break the input into a series of regions.  The first region is free
+    // of boundary conditions, the rest with boundary conditions.  We operate
+    // on the output region because the input has been copied to the output.
+
+    // Setup the types of structs for the face calculations
+    // (Struct handles the case where the image pointer doesn't exist)
+    FaceStruct< OutputImagePointer > outputStruct(
+        output, slabRegion, radius );
+    NeighborhoodType outputNeighborhood;
+
+    FaceStruct< DiffusionTensorImagePointer > tensorStruct(
+        m_DiffusionTensorImages, slabTensorRegion, radius );
+    DiffusionTensorNeighborhoodVectorType tensorNeighborhoods;
+
+    FaceStruct< ScalarDerivativeImagePointer >
+        deformationComponentFirstOrderStruct(
+            deformationComponentFirstOrderArrays,
+            slabScalarDerivativeRegion,
+            radius );
+    ScalarDerivativeImageRegionArrayVectorType
+        deformationComponentFirstOrderRegionArrays;
+
+    FaceStruct< FixedImagePointer > stoppingCriterionMaskStruct(
+        m_StoppingCriterionMask, slabStoppingCriterionMaskRegion, radius );
+    StoppingCriterionMaskImageRegionType stoppingCriterionMaskRegion;
+
+    // Go to the first face
+    outputStruct.GoToBegin();
     if( computeRegularization )
       {
-      tensorStruct.SetIteratorToCurrentFace(
-          tensorNeighborhoods, m_DiffusionTensorImages, radius );
-      deformationComponentFirstOrderStruct.SetIteratorToCurrentFace(
-          deformationComponentFirstOrderRegionArrays,
-          m_DeformationComponentFirstOrderDerivativeArrays );
+      tensorStruct.GoToBegin();
+      deformationComponentFirstOrderStruct.GoToBegin();
       }
     if( haveStoppingCriterionMask )
       {
-      stoppingCriterionMaskStruct.SetIteratorToCurrentFace(
-          stoppingCriterionMaskRegion, m_StoppingCriterionMask );
+      stoppingCriterionMaskStruct.GoToBegin();
       }
 
-    // Go to the beginning of the neighborhood for this face
-    outputNeighborhood.GoToBegin();
-    if( computeRegularization )
+    // Iterate over each face
+    while( !outputStruct.IsAtEnd() )
       {
-      for( int i = 0; i < this->GetNumberOfTerms(); i++ )
+      // Set the neighborhood iterators to the current face
+      outputStruct.SetIteratorToCurrentFace( outputNeighborhood, output, radius );
+      if( computeRegularization )
+        {
+        tensorStruct.SetIteratorToCurrentFace(
+            tensorNeighborhoods, m_DiffusionTensorImages, radius );
+        deformationComponentFirstOrderStruct.SetIteratorToCurrentFace(
+            deformationComponentFirstOrderRegionArrays,
+            deformationComponentFirstOrderArrays );
+        }
+      if( haveStoppingCriterionMask )
         {
-        tensorNeighborhoods[i].GoToBegin();
-        for( unsigned int j = 0; j < ImageDimension; j++ )
+        stoppingCriterionMaskStruct.SetIteratorToCurrentFace(
+            stoppingCriterionMaskRegion, m_StoppingCriterionMask );
+        }
+
+      // Go to the beginning of the neighborhood for this face
+      outputNeighborhood.GoToBegin();
+      if( computeRegularization )
+        {
+        for( int i = 0; i < this->GetNumberOfTerms(); i++ )
           {
-          deformationComponentFirstOrderRegionArrays[i][j].GoToBegin();
+          tensorNeighborhoods[i].GoToBegin();
+          for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+            deformationComponentFirstOrderRegionArrays[i][j].GoToBegin();
+            }
           }
         }
-      }
-    if( haveStoppingCriterionMask )
-      {
-      stoppingCriterionMaskRegion.GoToBegin();
-      }
-
-    // Iterate through the neighborhood for this face and compute updates
-    while( !outputNeighborhood.IsAtEnd() )
-      {
-      // Get whether or not to include this pixel in the stopping criterion
-      bool includeInStoppingCriterion = true;
       if( haveStoppingCriterionMask )
         {
-        includeInStoppingCriterion
-            = ( stoppingCriterionMaskRegion.Value() == 0.0 );
+        stoppingCriterionMaskRegion.GoToBegin();
         }
 
-      if( includeInStoppingCriterion )
+      // Iterate through the neighborhood for this face and compute updates
+      while( !outputNeighborhood.IsAtEnd() )
         {
-        // Calculate intensity distance energy
-        if( computeIntensityDistance )
+        // Get whether or not to include this pixel in the stopping criterion
+        bool includeInStoppingCriterion = true;
+        if( haveStoppingCriterionMask )
           {
-          localIntensityDistanceEnergy += df->ComputeIntensityDistanceEnergy(
-                outputNeighborhood.GetIndex(), outputNeighborhood.GetCenterPixel() );
+          includeInStoppingCriterion
+              = ( stoppingCriterionMaskRegion.Value() == 0.0 );
           }
 
-        // Calculate regularization energy
-        if( computeRegularization )
+        if( includeInStoppingCriterion )
           {
-          localRegularizationEnergy += df->ComputeRegularizationEnergy(
-                tensorNeighborhoods,
-                deformationComponentFirstOrderRegionArrays );
+          // Calculate intensity distance energy
+          if( computeIntensityDistance )
+            {
+            localIntensityDistanceEnergy += df->ComputeIntensityDistanceEnergy(
+                  outputNeighborhood.GetIndex(), outputNeighborhood.GetCenterPixel() );
+            }
+
+          // Calculate regularization energy
+          if( computeRegularization )
+            {
+            localRegularizationEnergy += df->ComputeRegularizationEnergy(
+                  tensorNeighborhoods,
+                  deformationComponentFirstOrderRegionArrays );
+            }
           }
-        }
 
-      // Go to the next neighborhood
-      ++outputNeighborhood;
-      if( computeRegularization )
-        {
-        for( int i = 0; i < this->GetNumberOfTerms(); i++ )
+        // Go to the next neighborhood
+        ++outputNeighborhood;
+        if( computeRegularization )
           {
-          ++tensorNeighborhoods[i];
-          for( unsigned int j = 0; j < ImageDimension; j++ )
+          for( int i = 0; i < this->GetNumberOfTerms(); i++ )
             {
-            ++deformationComponentFirstOrderRegionArrays[i][j];
+            ++tensorNeighborhoods[i];
+            for( unsigned int j = 0; j < ImageDimension; j++ )
+              {
+              ++deformationComponentFirstOrderRegionArrays[i][j];
+              }
             }
           }
+        if( haveStoppingCriterionMask )
+          {
+          ++stoppingCriterionMaskRegion;
+          }
+        }
+
+      // Go to the next face
+      outputStruct.Increment();
+      if( computeRegularization )
+        {
+        tensorStruct.Increment();
+        deformationComponentFirstOrderStruct.Increment();
         }
       if( haveStoppingCriterionMask )
         {
-        ++stoppingCriterionMaskRegion;
+        stoppingCriterionMaskStruct.Increment();
         }
       }
-
-    // Go to the next face
-    outputStruct.Increment();
-    if( computeRegularization )
-      {
-      tensorStruct.Increment();
-      deformationComponentFirstOrderStruct.Increment();
-      }
-    if( haveStoppingCriterionMask )
-      {
-      stoppingCriterionMaskStruct.Increment();
-      }
     }
 
   intensityDistanceEnergy = localIntensityDistanceEnergy;
@@ -1719,8 +2100,8 @@ DiffusiveRegistrationFilter
 ::PostProcessIteration(TimeStepType stepSize)
 {
   // Keep track of the total registration time
-  static TimeStepType totalTime = 0.0;
-  totalTime += stepSize;
+  m_TimeStepHistory.push_back( stepSize );
+  m_TotalTime += stepSize;
 
   // Get the change in energy and update metrics since the previous iteration
   EnergiesStruct energiesChange;
@@ -1731,10 +2112,9 @@ DiffusiveRegistrationFilter
   // Keep track of the total energy change within each stopping criterion
   // evaluation block
   unsigned int elapsedIterations = this->GetElapsedIterations();
-  static double totalEnergyChangeInEvaluationPeriod = 0;
   if(elapsedIterations != 0)
     {
-    totalEnergyChangeInEvaluationPeriod += energiesChange.TotalEnergy;
+    m_TotalEnergyChangeInEvaluationPeriod += energiesChange.TotalEnergy;
     }
 
   // Print out logging information
@@ -1760,7 +2140,7 @@ DiffusiveRegistrationFilter
   std::cout.precision(6);
   std::cout << elapsedIterations << delimiter
             << stepSize << delimiter
-            << totalTime << sectionDelimiter
+            << m_TotalTime << sectionDelimiter
 
             << m_UpdateMetrics.RMSTotalUpdateMagnitude << delimiter
             << m_UpdateMetrics.RMSIntensityDistanceUpdateMagnitude << delimiter
@@ -1786,22 +2166,22 @@ DiffusiveRegistrationFilter
             << energiesChange.IntensityDistanceEnergy << delimiter
             << energiesChange.RegularizationEnergy << sectionDelimiter
 
-            << ",,, " << totalEnergyChangeInEvaluationPeriod << " ,,, ";
+            << ",,, " << m_TotalEnergyChangeInEvaluationPeriod << " ,,, ";
 
 
   // Error checking for energy increase that indicates we should stop
   // This should never happen with the line search turned on
   // TODO this makes tests fail
-  static int numEnergyViolations = 0;
   if(elapsedIterations != 0 && energiesChange.TotalEnergy > 0.0)
     {
-    numEnergyViolations++;
+    m_NumberOfEnergyViolations++;
     }
-  if(numEnergyViolations > 10)
+  if(m_NumberOfEnergyViolations > 10)
     {
     std::cout << "Total energy is increasing, indicating numeric instability. "
               << energiesChange.TotalEnergy << ".  "
               << "Registration halting.";
+    m_RegistrationStopped = true;
     this->StopRegistration();
     std::cout << delimiter <<  "!!!";
     }
@@ -1812,15 +2192,271 @@ DiffusiveRegistrationFilter
   if(elapsedIterations != 0
       && ((elapsedIterations + 1) % m_StoppingCriterionEvaluationPeriod) == 0)
     {
-    if(totalEnergyChangeInEvaluationPeriod > m_StoppingCriterionMaxTotalEnergyChange)
+    if(m_TotalEnergyChangeInEvaluationPeriod > m_StoppingCriterionMaxTotalEnergyChange)
       {
       std::cout << "Stopping criterion satisfied. "
-                << totalEnergyChangeInEvaluationPeriod << ".  "
+                << m_TotalEnergyChangeInEvaluationPeriod << ".  "
                 << "Registration halting.";
+      m_RegistrationStopped = true;
       this->StopRegistration();
       }
-    totalEnergyChangeInEvaluationPeriod = 0;
+    m_TotalEnergyChangeInEvaluationPeriod = 0;
+    }
+
+  // Write a checkpoint if one is due by iteration count or by time
+  if( !m_CheckpointFileName.empty() )
+    {
+    bool checkpointDue = m_CheckpointIterationPeriod > 0
+      && ( m_TimeStepHistory.size() % m_CheckpointIterationPeriod ) == 0;
+    RealTimeClock::TimeStampType now = m_CheckpointClock->GetTimeInSeconds();
+    if( m_CheckpointTimePeriod > 0.0
+        && now - m_LastCheckpointTime >= m_CheckpointTimePeriod )
+      {
+      checkpointDue = true;
+      }
+    if( checkpointDue )
+      {
+      this->WriteCheckpoint();
+      m_LastCheckpointTime = now;
+      }
+    }
+}
+
+/**
+ * Writes the registration state after the current iteration.  The state is
+ * written to a temporary file first, so that an interruption while writing
+ * leaves the previous checkpoint intact.
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+DiffusiveRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::WriteCheckpoint( void ) const
+{
+  typedef DiffusiveRegistrationFilterUtils Utils;
+
+  const OutputImageType * output = this->GetOutput();
+  assert( output );
+  const typename OutputImageType::RegionType region
+      = output->GetBufferedRegion();
+
+  std::string temporaryFileName = m_CheckpointFileName + ".tmp";
+  std::ofstream file( temporaryFileName.c_str(),
+                      std::ios::out | std::ios::binary | std::ios::trunc );
+  if( !file )
+    {
+    itkExceptionMacro( << "Could not write checkpoint file "
+                       << temporaryFileName );
+    }
+
+  // Header
+  Utils::WriteBinaryValue( file, static_cast< unsigned int >(
+      CheckpointFileVersion ) );
+  Utils::WriteBinaryValue( file, static_cast< unsigned int >(
+      ImageDimension ) );
+  Utils::WriteBinaryValue( file, static_cast< unsigned int >(
+      sizeof( DeformationVectorComponentType ) ) );
+
+  // Iteration state.  The elapsed iterations are incremented by the
+  // superclass once this iteration returns.
+  Utils::WriteBinaryValue( file, m_CurrentLevel );
+  Utils::WriteBinaryValue( file, static_cast< IdentifierType >(
+      this->GetElapsedIterations() + 1 ) );
+  Utils::WriteBinaryValue( file, this->GetRMSChange() );
+  Utils::WriteBinaryValue( file, m_RegistrationStopped );
+  Utils::WriteBinaryValue( file, m_TotalEnergyChangeInEvaluationPeriod );
+  Utils::WriteBinaryValue( file, m_NumberOfEnergyViolations );
+
+  Utils::WriteBinaryValue( file, m_Energies.TotalEnergy );
+  Utils::WriteBinaryValue( file, m_Energies.IntensityDistanceEnergy );
+  Utils::WriteBinaryValue( file, m_Energies.RegularizationEnergy );
+
+  const UpdateMetricsIntermediateStruct & intermediate
+      = m_UpdateMetrics.IntermediateStruct;
+  Utils::WriteBinaryValue( file, intermediate.NumberOfPixelsProcessed );
+  Utils::WriteBinaryValue( file,
+    intermediate.SumOfSquaredTotalUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    intermediate.SumOfSquaredIntensityDistanceUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    intermediate.SumOfSquaredRegularizationUpdateMagnitude );
+  Utils::WriteBinaryValue( file, intermediate.SumOfTotalUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    intermediate.SumOfIntensityDistanceUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    intermediate.SumOfRegularizationUpdateMagnitude );
+  Utils::WriteBinaryValue( file, m_UpdateMetrics.RMSTotalUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    m_UpdateMetrics.RMSIntensityDistanceUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    m_UpdateMetrics.RMSRegularizationUpdateMagnitude );
+  Utils::WriteBinaryValue( file, m_UpdateMetrics.MeanTotalUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    m_UpdateMetrics.MeanIntensityDistanceUpdateMagnitude );
+  Utils::WriteBinaryValue( file,
+    m_UpdateMetrics.MeanRegularizationUpdateMagnitude );
+
+  // Time step history
+  Utils::WriteBinaryValue( file, static_cast< unsigned long >(
+      m_TimeStepHistory.size() ) );
+  for( unsigned int i = 0; i < m_TimeStepHistory.size(); i++ )
+    {
+    Utils::WriteBinaryValue( file, m_TimeStepHistory[i] );
+    }
+
+  // Deformation field geometry and voxels
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    Utils::WriteBinaryValue( file, region.GetIndex()[i] );
+    Utils::WriteBinaryValue( file, region.GetSize()[i] );
+    Utils::WriteBinaryValue( file, output->GetOrigin()[i] );
+    Utils::WriteBinaryValue( file, output->GetSpacing()[i] );
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      Utils::WriteBinaryValue( file, output->GetDirection()[i][j] );
+      }
+    }
+  file.write( reinterpret_cast< const char * >( output->GetBufferPointer() ),
+              region.GetNumberOfPixels()
+                * sizeof( typename OutputImageType::PixelType ) );
+
+  if( !file.good() )
+    {
+    itkExceptionMacro( << "Could not write checkpoint file "
+                       << temporaryFileName );
     }
+  file.close();
+
+  std::remove( m_CheckpointFileName.c_str() );
+  if( std::rename( temporaryFileName.c_str(),
+                   m_CheckpointFileName.c_str() ) != 0 )
+    {
+    itkExceptionMacro( << "Could not rename " << temporaryFileName
+                       << " to " << m_CheckpointFileName );
+    }
+}
+
+/**
+ * Reads the registration state written by WriteCheckpoint
+ */
+template< class TFixedImage, class TMovingImage, class TDeformationField >
+void
+DiffusiveRegistrationFilter
+  < TFixedImage, TMovingImage, TDeformationField >
+::ReadCheckpoint( void )
+{
+  typedef DiffusiveRegistrationFilterUtils Utils;
+
+  std::ifstream file( m_CheckpointFileName.c_str(),
+                      std::ios::in | std::ios::binary );
+  if( !file )
+    {
+    itkExceptionMacro( << "Could not read checkpoint file "
+                       << m_CheckpointFileName );
+    }
+
+  // Header
+  unsigned int version = 0;
+  unsigned int dimension = 0;
+  unsigned int componentSize = 0;
+  Utils::ReadBinaryValue( file, version );
+  Utils::ReadBinaryValue( file, dimension );
+  Utils::ReadBinaryValue( file, componentSize );
+  if( version != static_cast< unsigned int >( CheckpointFileVersion )
+      || dimension != ImageDimension
+      || componentSize != sizeof( DeformationVectorComponentType ) )
+    {
+    itkExceptionMacro( << "Checkpoint file " << m_CheckpointFileName
+                       << " was not written by this registration type" );
+    }
+
+  // Iteration state
+  Utils::ReadBinaryValue( file, m_ResumeLevel );
+  Utils::ReadBinaryValue( file, m_ResumeElapsedIterations );
+  Utils::ReadBinaryValue( file, m_ResumeRMSChange );
+  Utils::ReadBinaryValue( file, m_ResumeRegistrationStopped );
+  Utils::ReadBinaryValue( file, m_TotalEnergyChangeInEvaluationPeriod );
+  Utils::ReadBinaryValue( file, m_NumberOfEnergyViolations );
+
+  Utils::ReadBinaryValue( file, m_Energies.TotalEnergy );
+  Utils::ReadBinaryValue( file, m_Energies.IntensityDistanceEnergy );
+  Utils::ReadBinaryValue( file, m_Energies.RegularizationEnergy );
+
+  UpdateMetricsIntermediateStruct & intermediate
+      = m_UpdateMetrics.IntermediateStruct;
+  Utils::ReadBinaryValue( file, intermediate.NumberOfPixelsProcessed );
+  Utils::ReadBinaryValue( file,
+    intermediate.SumOfSquaredTotalUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    intermediate.SumOfSquaredIntensityDistanceUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    intermediate.SumOfSquaredRegularizationUpdateMagnitude );
+  Utils::ReadBinaryValue( file, intermediate.SumOfTotalUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    intermediate.SumOfIntensityDistanceUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    intermediate.SumOfRegularizationUpdateMagnitude );
+  Utils::ReadBinaryValue( file, m_UpdateMetrics.RMSTotalUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    m_UpdateMetrics.RMSIntensityDistanceUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    m_UpdateMetrics.RMSRegularizationUpdateMagnitude );
+  Utils::ReadBinaryValue( file, m_UpdateMetrics.MeanTotalUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    m_UpdateMetrics.MeanIntensityDistanceUpdateMagnitude );
+  Utils::ReadBinaryValue( file,
+    m_UpdateMetrics.MeanRegularizationUpdateMagnitude );
+
+  // Time step history.  The total time is summed in the same order as during
+  // the interrupted registration, so that it matches exactly.
+  unsigned long numberOfTimeSteps = 0;
+  Utils::ReadBinaryValue( file, numberOfTimeSteps );
+  m_TimeStepHistory.resize( numberOfTimeSteps );
+  m_TotalTime = 0.0;
+  for( unsigned long i = 0; i < numberOfTimeSteps; i++ )
+    {
+    Utils::ReadBinaryValue( file, m_TimeStepHistory[i] );
+    m_TotalTime += m_TimeStepHistory[i];
+    }
+
+  // Deformation field geometry and voxels
+  typename OutputImageType::RegionType region;
+  typename OutputImageType::PointType origin;
+  typename OutputImageType::SpacingType spacing;
+  typename OutputImageType::DirectionType direction;
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    typename OutputImageType::IndexValueType index = 0;
+    typename OutputImageType::SizeValueType size = 0;
+    Utils::ReadBinaryValue( file, index );
+    Utils::ReadBinaryValue( file, size );
+    region.SetIndex( i, index );
+    region.SetSize( i, size );
+    Utils::ReadBinaryValue( file, origin[i] );
+    Utils::ReadBinaryValue( file, spacing[i] );
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      Utils::ReadBinaryValue( file, direction[i][j] );
+      }
+    }
+  m_ResumeDeformationField = OutputImageType::New();
+  m_ResumeDeformationField->SetRegions( region );
+  m_ResumeDeformationField->SetOrigin( origin );
+  m_ResumeDeformationField->SetSpacing( spacing );
+  m_ResumeDeformationField->SetDirection( direction );
+  m_ResumeDeformationField->Allocate();
+  file.read( reinterpret_cast< char * >(
+               m_ResumeDeformationField->GetBufferPointer() ),
+             region.GetNumberOfPixels()
+               * sizeof( typename OutputImageType::PixelType ) );
+
+  if( !file.good() )
+    {
+    itkExceptionMacro( << "Checkpoint file " << m_CheckpointFileName
+                       << " is truncated" );
+    }
+
+  m_ResumePending = true;
 }
 
 } // End namespace tube
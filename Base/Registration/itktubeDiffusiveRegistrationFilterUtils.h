@@ -24,6 +24,7 @@ limitations under the License.
 #ifndef __itktubeDiffusiveRegistrationFilterUtils_h
 #define __itktubeDiffusiveRegistrationFilterUtils_h
 
+#include <iostream>
 #include <vector>
 
 namespace itk
@@ -41,6 +42,14 @@ public:
   static void AllocateSpaceForImage( TUnallocatedImagePointer & image,
                                      const TTemplateImagePointer & templateImage );
 
+  /** Helper function to allocate an image based on a template, buffering
+   *  only the given region of the template grid */
+  template< class TUnallocatedImagePointer, class TTemplateImagePointer >
+  static void AllocateSpaceForImageRegion(
+      TUnallocatedImagePointer & image,
+      const TTemplateImagePointer & templateImage,
+      const typename TTemplateImagePointer::ObjectType::RegionType & region );
+
   /** Helper function to check whether the attributes of an image match a
     * template */
   template< class TCheckedImage, class TTemplateImage >
@@ -85,6 +94,15 @@ public:
       const TDeformationField * deformationField,
       TDeformationComponentImageArray & deformationComponentImages );
 
+  /** Writes a value to a binary stream in the native byte order */
+  template< class TValue >
+  static void WriteBinaryValue( std::ostream & os, const TValue & value );
+
+  /** Reads a value written by WriteBinaryValue.  Returns false if the
+   *  stream ended first. */
+  template< class TValue >
+  static bool ReadBinaryValue( std::istream & is, TValue & value );
+
 }; // End class DiffusiveRegistrationFilterUtils
 
 
@@ -56,6 +56,28 @@ DiffusiveRegistrationFilterUtils
   image->Allocate();
 }
 
+/**
+ * Helper function to allocate space for part of an image given a template
+ * image
+ */
+template< class TUnallocatedImagePointer, class TemplateImagePointer >
+void
+DiffusiveRegistrationFilterUtils
+::AllocateSpaceForImageRegion( TUnallocatedImagePointer& image,
+    const TemplateImagePointer& templateImage,
+    const typename TemplateImagePointer::ObjectType::RegionType & region )
+{
+  assert( image );
+  assert( templateImage );
+  image->SetOrigin( templateImage->GetOrigin() );
+  image->SetSpacing( templateImage->GetSpacing() );
+  image->SetDirection( templateImage->GetDirection() );
+  image->SetLargestPossibleRegion( templateImage->GetLargestPossibleRegion() );
+  image->SetRequestedRegion( region );
+  image->SetBufferedRegion( region );
+  image->Allocate();
+}
+
 /**
  * Helper function to check whether the attributes of an image matches template
  */
@@ -244,6 +266,29 @@ DiffusiveRegistrationFilterUtils
     }
 }
 
+/**
+ * Writes a value to a binary stream
+ */
+template< class TValue >
+void
+DiffusiveRegistrationFilterUtils
+::WriteBinaryValue( std::ostream & os, const TValue & value )
+{
+  os.write( reinterpret_cast< const char * >( &value ), sizeof( TValue ) );
+}
+
+/**
+ * Reads a value from a binary stream
+ */
+template< class TValue >
+bool
+DiffusiveRegistrationFilterUtils
+::ReadBinaryValue( std::istream & is, TValue & value )
+{
+  is.read( reinterpret_cast< char * >( &value ), sizeof( TValue ) );
+  return is.good();
+}
+
 } // End namespace tube
 
 } // End namespace itk
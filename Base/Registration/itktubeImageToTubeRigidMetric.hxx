@@ -145,6 +145,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
 
   CompensatedSummationType featureWeightSum;
 
+  const ScalarType * featureWeights = this->m_FeatureWeights.data_block();
   SizeValueType weightCount = 0;
   typedef typename TubeTreeType::ChildrenListType::iterator TubesIteratorType;
   for( TubesIteratorType tubeIterator = tubeList->begin();
@@ -165,7 +166,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
             tubePointIterator != currentTubePoints.end();
             ++tubePointIterator )
         {
-        const ScalarType weight = this->m_FeatureWeights[weightCount];
+        const ScalarType weight = featureWeights[weightCount];
         ++weightCount;
 
         for( unsigned int ii = 0; ii < TubeDimension; ++ii )
@@ -233,6 +234,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
 
   typename TubeTreeType::ChildrenListType::iterator tubeIterator;
   typename TubeTreeType::ChildrenListType * tubeList = GetTubes();
+  const ScalarType * featureWeights = this->m_FeatureWeights.data_block();
   SizeValueType weightCount = 0;
   for( tubeIterator = tubeList->begin();
        tubeIterator != tubeList->end();
@@ -251,13 +253,14 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
         OutputPointType currentPoint;
         if( this->IsInside( inputPoint, currentPoint, transformCopy ) )
           {
-          weightSum += m_FeatureWeights[weightCount];
+          const ScalarType weight = featureWeights[weightCount];
+          weightSum += weight;
           ScalarType scalingRadius = pointIterator->GetRadius();
           scalingRadius = std::max( scalingRadius, m_MinimumScalingRadius );
 
           const ScalarType scale = scalingRadius * m_Kappa;
 
-          matchMeasure += m_FeatureWeights[weightCount] * vnl_math_abs(
+          matchMeasure += weight * vnl_math_abs(
             this->ComputeLaplacianMagnitude( pointIterator->GetNormal1(),
               scale,
               currentPoint ) );
@@ -404,6 +407,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
   VnlMatrixType biasVI( TubeDimension, TubeDimension,
     NumericTraits< ScalarType >::Zero );
 
+  const ScalarType * featureWeights = this->m_FeatureWeights.data_block();
   SizeValueType weightCount = 0;
 
   CompensatedSummationType dPosition[TubeDimension];
@@ -443,6 +447,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
         if( this->IsInside( inputPoint, currentPoint, transformCopy ) )
           {
           transformedTubePoints.push_back( currentPoint );
+          const ScalarType weight = featureWeights[weightCount];
 
           //! \todo: these should be CovariantVectors?
           VectorType v1;
@@ -460,7 +465,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
             }
           tM = outer_product( v1T, v1T );
           tM = tM + outer_product( v2T, v2T );
-          tM = m_FeatureWeights[weightCount] * tM;
+          tM = weight * tM;
           biasV += tM;
 
           v1 = transformCopy->TransformVector( v1 );
@@ -480,8 +485,7 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
           for( unsigned int ii = 0; ii < TubeDimension; ++ii )
             {
             dtransformedTubePoint[ii] = ( dXProj1 * v1[ii] + dXProj2 * v2[ii] );
-            dPosition[ii] +=
-              m_FeatureWeights[weightCount] * ( dtransformedTubePoint[ii] );
+            dPosition[ii] += weight * ( dtransformedTubePoint[ii] );
             }
           dtransformedTubePoints.push_back( dtransformedTubePoint );
           }
@@ -546,9 +550,10 @@ ImageToTubeRigidMetric< TFixedImage, TMovingSpatialObject, TTubeSpatialObject >
 
           ScalarType angleDelta[TubeDimension];
           this->GetDeltaAngles( *transformedTubePointsIt, dXT, offsets, angleDelta );
+          const ScalarType weight = featureWeights[weightCount];
           for( unsigned int ii = 0; ii < TubeDimension; ++ii )
             {
-            dAngle[ii] += m_FeatureWeights[weightCount] * angleDelta[ii];
+            dAngle[ii] += weight * angleDelta[ii];
             }
           ++dtransformedTubePointsIt;
           ++transformedTubePointsIt;
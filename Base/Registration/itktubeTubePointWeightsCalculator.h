@@ -24,10 +24,13 @@ limitations under the License.
 #ifndef __itktubeTubePointWeightsCalculator_h
 #define __itktubeTubePointWeightsCalculator_h
 
+#include <itkMultiThreader.h>
 #include <itkObject.h>
 #include <itkObjectFactory.h>
 #include <itkSpatialObject.h>
 
+#include <vector>
+
 namespace itk
 {
 
@@ -38,6 +41,12 @@ namespace tube
  *  This class computes scalar weights for every point in a tube tree based on
  *  the radius at that point.
  *
+ *  The weights are written into one contiguous array, in the order the tube
+ *  points are visited by the registration metrics, and are evaluated in
+ *  parallel.  When the weight function is exactly of type
+ *  TPointWeightFunction, Evaluate() is called non-virtually so that it can
+ *  be inlined into the loop over the points.
+ *
  *  \tparam TTubeTreeSpatialObject input tube tree spatial object type.
  *  \tparam TPointWeightFunction type of the function used to compute the
  *  weights.
@@ -65,6 +74,10 @@ public:
   typedef TPointWeightFunction       PointWeightFunctionType;
   typedef TPointWeights              PointWeightsType;
 
+  typedef typename PointWeightsType::ValueType          WeightValueType;
+  typedef typename TubeSpatialObjectType::PointListType TubePointListType;
+  typedef typename TubePointListType::value_type        TubePointType;
+
   /** Method for creation through the object factory. */
   itkNewMacro( Self );
 
@@ -87,6 +100,11 @@ public:
   /** Get the output resolution weights. */
   itkGetConstReferenceMacro( PointWeights, PointWeightsType );
 
+  /** Set/Get the number of threads used to evaluate the weights.  Defaults
+   *  to the global default number of threads. */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
 protected:
   TubePointWeightsCalculator( void );
   virtual ~TubePointWeightsCalculator( void ) {}
@@ -101,8 +119,24 @@ private:
   TubePointWeightsCalculator(const Self&); //purposely not implemented
   void operator=(const Self&);            //purposely not implemented
 
+  struct WeightsThreadStruct
+    {
+    const Self *                           Calculator;
+    std::vector< const TubePointType * >   TubePoints;
+    std::vector< SizeValueType >           TubeOffsets;
+    WeightValueType *                      Weights;
+    bool                                   EvaluateInline;
+    };
+
+  static ITK_THREAD_RETURN_TYPE WeightsThreaderCallback( void * arg );
+
+  void ThreadedCompute( SizeValueType begin, SizeValueType end,
+    const WeightsThreadStruct * str ) const;
+
   typename TubeTreeSpatialObjectType::ConstPointer m_TubeTreeSpatialObject;
 
+  ThreadIdType                                     m_NumberOfThreads;
+
 }; // End class TubePointWeightsCalculator
 
 } // End namespace tube
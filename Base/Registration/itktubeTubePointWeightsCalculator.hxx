@@ -26,6 +26,9 @@ limitations under the License.
 
 #include "itktubeTubePointWeightsCalculator.h"
 
+#include <algorithm>
+#include <typeinfo>
+
 namespace itk
 {
 
@@ -42,6 +45,7 @@ TubePointWeightsCalculator< VDimension,
   TPointWeights >
 ::TubePointWeightsCalculator( void )
 {
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 
@@ -56,13 +60,25 @@ TubePointWeightsCalculator< VDimension,
   TPointWeights >
 ::Compute( void )
 {
+  if( this->m_TubeTreeSpatialObject.IsNull() )
+    {
+    itkExceptionMacro( << "TubeTreeSpatialObject is not set." );
+    }
+  if( this->m_PointWeightFunction.IsNull() )
+    {
+    itkExceptionMacro( << "PointWeightFunction is not set." );
+    }
+
   char childName[] = "Tube";
   typename TubeTreeSpatialObjectType::ChildrenListType * tubeList =
     this->m_TubeTreeSpatialObject->GetChildren(
       this->m_TubeTreeSpatialObject->GetMaximumDepth(), childName );
 
-  // Count the tube points.
-  SizeValueType tubePoints = 0;
+  // Record where the points of every non-empty tube start in the output
+  // array.
+  WeightsThreadStruct str;
+  str.Calculator = this;
+  str.TubeOffsets.push_back( 0 );
   typedef typename TubeTreeSpatialObjectType::ChildrenListType::iterator
     TubesIteratorType;
   for( TubesIteratorType tubeIterator = tubeList->begin();
@@ -71,37 +87,115 @@ TubePointWeightsCalculator< VDimension,
     {
     TubeSpatialObjectType * currentTube =
       dynamic_cast< TubeSpatialObjectType * >( ( *tubeIterator ).GetPointer() );
-    if( currentTube != NULL )
+    if( currentTube != NULL && currentTube->GetNumberOfPoints() > 0 )
       {
-      tubePoints += currentTube->GetNumberOfPoints();
+      str.TubePoints.push_back( &( currentTube->GetPoints()[0] ) );
+      str.TubeOffsets.push_back( str.TubeOffsets.back()
+        + currentTube->GetNumberOfPoints() );
       }
     }
+  delete tubeList;
+
+  const SizeValueType tubePoints = str.TubeOffsets.back();
   this->m_PointWeights.SetSize( tubePoints );
+  if( tubePoints == 0 )
+    {
+    return;
+    }
+  str.Weights = this->m_PointWeights.data_block();
+
+  // A function of a derived type must keep going through the virtual call.
+  str.EvaluateInline = ( typeid( *this->m_PointWeightFunction )
+    == typeid( PointWeightFunctionType ) );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+    std::min( static_cast< SizeValueType >( this->m_NumberOfThreads ),
+      tubePoints ) ) );
+  threader->SetSingleMethod( this->WeightsThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
 
-  SizeValueType tubeIndex = 0;
-  for( TubesIteratorType tubeIterator = tubeList->begin();
-       tubeIterator != tubeList->end();
-       ++tubeIterator )
+
+template< unsigned int VDimension,
+  class TTubeSpatialObject,
+  class TPointWeightFunction,
+  class TPointWeights >
+ITK_THREAD_RETURN_TYPE
+TubePointWeightsCalculator< VDimension,
+  TTubeSpatialObject,
+  TPointWeightFunction,
+  TPointWeights >
+::WeightsThreaderCallback( void * arg )
+{
+  ThreadIdType threadId =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->ThreadID;
+  ThreadIdType numberOfThreads =
+    ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->NumberOfThreads;
+  WeightsThreadStruct * str = ( WeightsThreadStruct * )
+    ( ( ( MultiThreader::ThreadInfoStruct * )( arg ) )->UserData );
+
+  const SizeValueType numberOfPoints = str->TubeOffsets.back();
+  const SizeValueType pointsPerThread =
+    ( numberOfPoints + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = threadId * pointsPerThread;
+  if( begin < numberOfPoints )
     {
-    TubeSpatialObjectType * currentTube =
-      dynamic_cast< TubeSpatialObjectType * >( ( *tubeIterator ).GetPointer() );
-    if( currentTube != NULL )
+    str->Calculator->ThreadedCompute( begin,
+      std::min( begin + pointsPerThread, numberOfPoints ), str );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template< unsigned int VDimension,
+  class TTubeSpatialObject,
+  class TPointWeightFunction,
+  class TPointWeights >
+void
+TubePointWeightsCalculator< VDimension,
+  TTubeSpatialObject,
+  TPointWeightFunction,
+  TPointWeights >
+::ThreadedCompute( SizeValueType begin, SizeValueType end,
+  const WeightsThreadStruct * str ) const
+{
+  const PointWeightFunctionType * function =
+    this->m_PointWeightFunction.GetPointer();
+
+  // Tube holding the first point of the range
+  SizeValueType tube = static_cast< SizeValueType >(
+    std::upper_bound( str->TubeOffsets.begin(), str->TubeOffsets.end(),
+      begin ) - str->TubeOffsets.begin() ) - 1;
+
+  SizeValueType index = begin;
+  while( index < end )
+    {
+    const SizeValueType tubeEnd = std::min( str->TubeOffsets[tube + 1], end );
+    const TubePointType * point = str->TubePoints[tube]
+      + ( index - str->TubeOffsets[tube] );
+    WeightValueType * weight = str->Weights + index;
+    WeightValueType * const weightEnd = str->Weights + tubeEnd;
+    if( str->EvaluateInline )
+      {
+      for( ; weight != weightEnd; ++weight, ++point )
+        {
+        *weight = static_cast< WeightValueType >(
+          function->PointWeightFunctionType::Evaluate( *point ) );
+        }
+      }
+    else
       {
-      const typename TubeSpatialObjectType::PointListType & currentTubePoints
-        = currentTube->GetPoints();
-      typedef typename TubeSpatialObjectType::PointListType::const_iterator
-        TubePointIteratorType;
-      for( TubePointIteratorType tubePointIterator = currentTubePoints.begin();
-            tubePointIterator != currentTubePoints.end();
-            ++tubePointIterator )
+      for( ; weight != weightEnd; ++weight, ++point )
         {
-        this->m_PointWeights[tubeIndex]
-          = this->m_PointWeightFunction->Evaluate( *tubePointIterator );
-        ++tubeIndex;
+        *weight = static_cast< WeightValueType >(
+          function->Evaluate( *point ) );
         }
       }
+    index = tubeEnd;
+    ++tube;
     }
-  delete tubeList;
 }
 
 
@@ -134,6 +228,7 @@ TubePointWeightsCalculator< VDimension,
     {
     os << indent << "PointWeightFunction: " << "(0x0)" << std::endl;
     }
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
   os << indent << "PointWeights: " << m_PointWeights << std::endl;
 }
 
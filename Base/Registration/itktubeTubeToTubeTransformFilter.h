@@ -27,6 +27,8 @@ limitations under the License.
 #include "itktubeSpatialObjectToSpatialObjectFilter.h"
 
 #include <itkGroupSpatialObject.h>
+#include <itkMatrixOffsetTransformBase.h>
+#include <itkMultiThreader.h>
 #include <itkObject.h>
 #include <itkObjectFactory.h>
 #include <itkVesselTubeSpatialObject.h>
@@ -49,6 +51,14 @@ namespace tube
  *
  *  The resulting tube could be cropped and/or a narrow band could be
  *  defined.
+ *
+ *  The points of all tubes are gathered into contiguous arrays and
+ *  transformed by several threads before the output tubes are assembled.
+ *  Transforms derived from MatrixOffsetTransformBase are applied directly
+ *  from their matrix and offset; other transforms, e.g. displacement
+ *  fields, are evaluated through TransformPoint in each thread.  With
+ *  PositionsOnly set, the normals are neither transformed nor recomputed,
+ *  which suffices for display.
  */
 template< class TTransformType, unsigned int VDimension >
 class TubeToTubeTransformFilter
@@ -67,6 +77,8 @@ public:
   typedef SmartPointer< const Self >                           ConstPointer;
 
   typedef VesselTubeSpatialObject<VDimension>     TubeType;
+  typedef typename TubeType::PointType            PointType;
+  typedef typename TubeType::CovariantVectorType  CovariantVectorType;
 
   /** Typedef for the transformations */
   typedef TTransformType                          TransformType;
@@ -116,6 +128,12 @@ public:
   /** Set the size of the Region of Interest */
   void SetCropSize(double* cropSize) {m_CropSize = cropSize;}
 
+  /** Only transform the point positions; the tangents and normals of the
+   * output tubes are left unset. */
+  itkSetMacro( PositionsOnly, bool );
+  itkGetConstMacro( PositionsOnly, bool );
+  itkBooleanMacro( PositionsOnly );
+
 protected:
 
   TubeToTubeTransformFilter( void );
@@ -127,6 +145,32 @@ private:
   TubeToTubeTransformFilter(const Self&); //purposely not implemented
   void operator=(const Self&);            //purposely not implemented
 
+  typedef MatrixOffsetTransformBase< double, VDimension, VDimension >
+    MatrixOffsetTransformType;
+  typedef typename MatrixOffsetTransformType::MatrixType MatrixType;
+  typedef typename MatrixOffsetTransformType::OutputVectorType VectorType;
+
+  /** The gathered tube points; the positions are transformed in place. */
+  struct TransformThreadStruct
+    {
+    Self *                                Filter;
+    std::vector< PointType > *            Positions;
+    std::vector< CovariantVectorType > *  Normals1;
+    std::vector< CovariantVectorType > *  Normals2;
+    const std::vector< unsigned int > *   PointTube;
+    const std::vector< VectorType > *     TubeSpacing;
+    bool                                  IsAffine;
+    MatrixType                            Matrix;
+    VectorType                            Offset;
+    MatrixType                            InverseTransposeMatrix;
+    };
+
+  static ITK_THREAD_RETURN_TYPE TransformThreaderCallback( void * arg );
+
+  /** Transform the points in [first, last). */
+  void ThreadedTransformPoints( TransformThreadStruct * str,
+    SizeValueType first, SizeValueType last ) const;
+
   typename GroupType::ConstPointer      m_TransformAsGroup;
   typename TransformType::Pointer       m_Transform;
   typename GroupType::Pointer           m_Output;
@@ -137,6 +181,7 @@ private:
   double*                m_CropSize;
   double                 m_Ridgeness; // default -1
   double                 m_Medialness; // default -1
+  bool                   m_PositionsOnly;
 
 }; // End class TubeToTubeTransformFilter
 
@@ -45,6 +45,7 @@ TubeToTubeTransformFilter< TTransformType, TDimension >
   m_TransformAsGroup = 0;
   m_Ridgeness = -1;
   m_Medialness = -1;
+  m_PositionsOnly = false;
 }
 
 /**
@@ -59,7 +60,6 @@ TubeToTubeTransformFilter< TTransformType, TDimension >
 
   // Set the spacing first;
   double* groupspacing = new double[TDimension];
-  const double* tubespacing;
 
   for( unsigned int i = 0; i < TDimension; i++ )
     {
@@ -75,142 +75,275 @@ TubeToTubeTransformFilter< TTransformType, TDimension >
     itkExceptionMacro( << "No transform is set." );
     }
 
-  Point<double, TDimension> point;
-  CovariantVector< double, TDimension > normal1;
-  CovariantVector< double, TDimension > normal2;
-
   typename TubeType::ChildrenListType::iterator TubeIterator;
   typedef typename TubeType::PointListType      TubePointListType;
 
   const GroupType * inputGroup = this->GetInput();
   typename TubeType::ChildrenListPointer inputTubeList =
     inputGroup->GetChildren( inputGroup->GetMaximumDepth() );
+
+  // Gather the points of all tubes, scaled into the space of the
+  // transform, into contiguous arrays.
+  std::vector< TubeType * >             tubes;
+  std::vector< VectorType >             tubeSpacing;
+  std::vector< SizeValueType >          tubeFirstPoint;
+  std::vector< PointType >              positions;
+  std::vector< CovariantVectorType >    normals1;
+  std::vector< CovariantVectorType >    normals2;
+  std::vector< unsigned int >           pointTube;
   for( TubeIterator = inputTubeList->begin();
        TubeIterator != inputTubeList->end();
        TubeIterator++ )
     {
-    if( !strcmp( (*TubeIterator)->GetTypeName(), "VesselTubeSpatialObject" ) )
+    if( strcmp( (*TubeIterator)->GetTypeName(), "VesselTubeSpatialObject" ) )
+      {
+      continue;
+      }
+    TubeType * inputTube = (TubeType *)((*TubeIterator).GetPointer());
+    const double * tubespacing = inputTube->GetSpacing();
+    VectorType spacing;
+    for( unsigned int i = 0; i < TDimension; i++ )
+      {
+      spacing[i] = tubespacing[i]*groupspacing[i];
+      }
+    const unsigned int tubeNumber = static_cast< unsigned int >(
+      tubes.size() );
+    tubes.push_back( inputTube );
+    tubeSpacing.push_back( spacing );
+    tubeFirstPoint.push_back( positions.size() );
+
+    const TubePointListType & tubePoints = inputTube->GetPoints();
+    for( typename TubePointListType::const_iterator TubePointIterator =
+      tubePoints.begin(); TubePointIterator != tubePoints.end();
+      ++TubePointIterator )
+      {
+      PointType point = (*TubePointIterator).GetPosition();
+      for( unsigned int i = 0; i < TDimension; i++ )
+        {
+        point[i] *= spacing[i]*m_Scale;
+        }
+      positions.push_back( point );
+      if( !m_PositionsOnly )
+        {
+        normals1.push_back( (*TubePointIterator).GetNormal1() );
+        normals2.push_back( (*TubePointIterator).GetNormal2() );
+        }
+      pointTube.push_back( tubeNumber );
+      }
+    }
+  tubeFirstPoint.push_back( positions.size() );
+
+  // Transform all points
+  TransformThreadStruct str;
+  str.Filter = this;
+  str.Positions = &positions;
+  str.Normals1 = &normals1;
+  str.Normals2 = &normals2;
+  str.PointTube = &pointTube;
+  str.TubeSpacing = &tubeSpacing;
+  const MatrixOffsetTransformType * matrixOffsetTransform;
+  if( m_TransformAsGroup )
+    {
+    matrixOffsetTransform =
+      m_TransformAsGroup->GetObjectToParentTransform();
+    }
+  else
+    {
+    matrixOffsetTransform = dynamic_cast< const MatrixOffsetTransformType * >(
+      m_Transform.GetPointer() );
+    }
+  str.IsAffine = ( matrixOffsetTransform != NULL );
+  if( str.IsAffine )
+    {
+    str.Matrix = matrixOffsetTransform->GetMatrix();
+    str.Offset = matrixOffsetTransform->GetOffset();
+    str.InverseTransposeMatrix.Fill( 0.0 );
+    if( !m_PositionsOnly )
       {
-      typename TubeType::Pointer tube = TubeType::New();
-      tubespacing = (*TubeIterator)->GetSpacing();
+      // Normals are covariant vectors: they map by the inverse transpose.
+      try
+        {
+        str.InverseTransposeMatrix = str.Matrix.GetInverse().transpose();
+        }
+      catch( ... )
+        {
+        itkWarningMacro( << "Singular transform matrix; normals are lost." );
+        }
+      }
+    }
 
-      tube->SetId(((TubeType *)((*TubeIterator).GetPointer()))->GetId());
-      tube->SetRoot(((TubeType *)((*TubeIterator).GetPointer()))->GetRoot());
-      tube->SetArtery(((TubeType *)((*TubeIterator).GetPointer()))->GetArtery());
-      tube->GetProperty()->SetColor((*TubeIterator)->GetProperty()->GetColor());
+  if( !positions.empty() )
+    {
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetSingleMethod( this->TransformThreaderCallback, &str );
+    threader->SingleMethodExecute();
+    }
 
-      TubePointListType tubeList =
-        ((TubeType *)((*TubeIterator).GetPointer()))->GetPoints();
-      typename TubePointListType::const_iterator TubePointIterator =
-        tubeList.begin();
+  // Scatter the transformed points into the output tubes
+  for( unsigned int tubeNumber = 0; tubeNumber < tubes.size(); tubeNumber++ )
+    {
+    const TubeType * inputTube = tubes[tubeNumber];
+
+    typename TubeType::Pointer tube = TubeType::New();
+    tube->SetId( inputTube->GetId() );
+    tube->SetRoot( inputTube->GetRoot() );
+    tube->SetArtery( inputTube->GetArtery() );
+    tube->GetProperty()->SetColor( inputTube->GetProperty()->GetColor() );
+
+    const TubePointListType & tubePoints = inputTube->GetPoints();
+    tube->GetPoints().reserve( tubePoints.size() );
+    SizeValueType pointNumber = tubeFirstPoint[tubeNumber];
+    for( typename TubePointListType::const_iterator TubePointIterator =
+      tubePoints.begin(); TubePointIterator != tubePoints.end();
+      ++TubePointIterator, ++pointNumber )
+      {
+      const PointType & point = positions[pointNumber];
 
-      while( TubePointIterator != tubeList.end() )
+      /** Crop the tube net to fit the image*/
+      if( m_Crop )
         {
-        point = (*TubePointIterator).GetPosition();
-        for( unsigned int i = 0; i < TDimension; i++ )
-          {
-          point[i] *= tubespacing[i]*groupspacing[i]*m_Scale;
-          }
-        if( m_TransformAsGroup )
-          {
-          point = m_TransformAsGroup->GetObjectToParentTransform()->
-                  TransformPoint( point );
-          }
-        else
-          {
-          point = m_Transform->TransformPoint( point );
-          }
-
-        for( unsigned int i = 0; i < TDimension; i++ )
-          {
-          point[i] /= tubespacing[i]*groupspacing[i];
-          }
-
-        /** Crop the tube net to fit the image*/
         bool IsInside = true;
-        if( m_Crop )
+        for( unsigned int i = 0; i < TDimension; i++ )
           {
-          for( unsigned int i = 0; i < TDimension; i++ )
+          if( ( point[i] > m_CropSize[i] + m_NarrowBandSize )
+              || ( point[i] < 0 ) )
+              // no negative numbers, the transformation should
+              // take care of the narrrowband
             {
-            if( ( point[i] > m_CropSize[i] + m_NarrowBandSize )
-                || ( point[i] < 0 ) )
-                // no negative numbers, the transformation should
-                // take care of the narrrowband
-              {
-              IsInside = false;
-              break;
-              }
+            IsInside = false;
+            break;
             }
           }
-
-        if( IsInside )
+        if( !IsInside )
           {
-          VesselTubeSpatialObjectPoint<TDimension> pnt;
-          pnt.SetPosition(point);
-
-          // get both normals
-          const typename TubeType::CovariantVectorType &n1 =
-            (*TubePointIterator).GetNormal1();
-          const typename TubeType::CovariantVectorType &n2 =
-            (*TubePointIterator).GetNormal2();
-
-          // only try transformation of normals if both are non-zero
-          if ( !n1.GetVnlVector().is_zero() && !n2.GetVnlVector().is_zero() )
-            {
-            if( m_TransformAsGroup )
-              {
-              normal1 = m_TransformAsGroup->GetObjectToParentTransform()
-                ->TransformCovariantVector( n1, point );
-              normal2  = m_TransformAsGroup->GetObjectToParentTransform()
-                ->TransformCovariantVector( n2, point );
-              pnt.SetNormal1( normal1 );
-              pnt.SetNormal2( normal2 );
-              }
-            else
-              {
-              normal1 = m_Transform->TransformCovariantVector( n1, point );
-              normal2 = m_Transform->TransformCovariantVector( n2, point );
-              pnt.SetNormal1( normal1 );
-              pnt.SetNormal2( normal2 );
-              }
-            }
-          pnt.SetRadius( (*TubePointIterator).GetRadius()*m_Scale );
+          continue;
+          }
+        }
 
-          if( m_Medialness == -1 )
-            {
-            pnt.SetMedialness( (*TubePointIterator).GetMedialness() );
-            }
-          else
-            {
-            pnt.SetMedialness(m_Medialness);
-            }
+      VesselTubeSpatialObjectPoint<TDimension> pnt;
+      pnt.SetPosition( point );
+      if( !m_PositionsOnly )
+        {
+        pnt.SetNormal1( normals1[pointNumber] );
+        pnt.SetNormal2( normals2[pointNumber] );
+        }
+      pnt.SetRadius( (*TubePointIterator).GetRadius()*m_Scale );
 
-          if( m_Ridgeness == -1 )
-            {
-            pnt.SetRidgeness( (*TubePointIterator).GetRidgeness() );
-            }
-          else
-            {
-            pnt.SetRidgeness( m_Ridgeness );
-            }
+      if( m_Medialness == -1 )
+        {
+        pnt.SetMedialness( (*TubePointIterator).GetMedialness() );
+        }
+      else
+        {
+        pnt.SetMedialness(m_Medialness);
+        }
 
-          pnt.SetBranchness( (*TubePointIterator).GetBranchness() );
-          tube->GetPoints().push_back( pnt );
-          }
-        TubePointIterator++;
+      if( m_Ridgeness == -1 )
+        {
+        pnt.SetRidgeness( (*TubePointIterator).GetRidgeness() );
         }
+      else
+        {
+        pnt.SetRidgeness( m_Ridgeness );
+        }
+
+      pnt.SetBranchness( (*TubePointIterator).GetBranchness() );
+      tube->GetPoints().push_back( pnt );
+      }
 
-      tube->GetIndexToObjectTransform()->SetScaleComponent(
-        ( (*TubeIterator)->GetIndexToObjectTransform()->GetScaleComponent() ) );
-      tube->RemoveDuplicatePoints();
+    tube->GetIndexToObjectTransform()->SetScaleComponent(
+      inputTube->GetIndexToObjectTransform()->GetScaleComponent() );
+    tube->RemoveDuplicatePoints();
+    if( !m_PositionsOnly )
+      {
       tube->ComputeTangentAndNormals();
-      m_Output->AddSpatialObject( tube );
       }
+    m_Output->AddSpatialObject( tube );
     }
   delete inputTubeList;
   delete [] groupspacing;
 }
 
+template< class TTransformType, unsigned int TDimension >
+ITK_THREAD_RETURN_TYPE
+TubeToTubeTransformFilter< TTransformType, TDimension >
+::TransformThreaderCallback( void * arg )
+{
+  const ThreadIdType threadId =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  const ThreadIdType threadCount =
+    ((MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+  TransformThreadStruct * str = (TransformThreadStruct *)
+    (((MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+
+  const SizeValueType numberOfPoints = str->Positions->size();
+  const SizeValueType first = numberOfPoints * threadId / threadCount;
+  const SizeValueType last = numberOfPoints * ( threadId + 1 ) / threadCount;
+  str->Filter->ThreadedTransformPoints( str, first, last );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TTransformType, unsigned int TDimension >
+void
+TubeToTubeTransformFilter< TTransformType, TDimension >
+::ThreadedTransformPoints( TransformThreadStruct * str,
+  SizeValueType first, SizeValueType last ) const
+{
+  std::vector< PointType > & positions = *( str->Positions );
+  std::vector< CovariantVectorType > & normals1 = *( str->Normals1 );
+  std::vector< CovariantVectorType > & normals2 = *( str->Normals2 );
+
+  for( SizeValueType k = first; k < last; k++ )
+    {
+    PointType point;
+    if( str->IsAffine )
+      {
+      point = str->Matrix * positions[k] + str->Offset;
+      }
+    else
+      {
+      point = m_Transform->TransformPoint( positions[k] );
+      }
+
+    const VectorType & spacing = ( *str->TubeSpacing )[( *str->PointTube )[k]];
+    for( unsigned int i = 0; i < TDimension; i++ )
+      {
+      point[i] /= spacing[i];
+      }
+    positions[k] = point;
+
+    if( m_PositionsOnly )
+      {
+      continue;
+      }
+
+    // only try transformation of normals if both are non-zero
+    if( !normals1[k].GetVnlVector().is_zero()
+      && !normals2[k].GetVnlVector().is_zero() )
+      {
+      if( str->IsAffine )
+        {
+        normals1[k] = str->InverseTransposeMatrix * normals1[k];
+        normals2[k] = str->InverseTransposeMatrix * normals2[k];
+        }
+      else
+        {
+        normals1[k] = m_Transform->TransformCovariantVector( normals1[k],
+          point );
+        normals2[k] = m_Transform->TransformCovariantVector( normals2[k],
+          point );
+        }
+      }
+    else
+      {
+      // the output point keeps zero normals
+      normals1[k].Fill( 0.0 );
+      normals2[k].Fill( 0.0 );
+      }
+    }
+}
+
 template< class TTransformType, unsigned int TDimension >
 void
 TubeToTubeTransformFilter< TTransformType,TDimension >
@@ -218,6 +351,12 @@ TubeToTubeTransformFilter< TTransformType,TDimension >
 {
   Superclass::PrintSelf(os,indent);
   os << indent << "Transformation: " << m_Transform << std::endl;
+  os << indent << "Scale: " << m_Scale << std::endl;
+  os << indent << "Crop: " << m_Crop << std::endl;
+  os << indent << "NarrowBandSize: " << m_NarrowBandSize << std::endl;
+  os << indent << "Ridgeness: " << m_Ridgeness << std::endl;
+  os << indent << "Medialness: " << m_Medialness << std::endl;
+  os << indent << "PositionsOnly: " << m_PositionsOnly << std::endl;
 }
 
 } // End namespace tube
@@ -0,0 +1,275 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubePDFSegmenter.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+template< class TImage >
+bool ImagesAreEqual( const TImage * image1, const TImage * image2 )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1,
+    image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2,
+    image2->GetLargestPossibleRegion() );
+  while( !it1.IsAtEnd() )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      return false;
+      }
+    ++it1;
+    ++it2;
+    }
+  return it2.IsAtEnd();
+}
+
+template< class TImage >
+typename TImage::Pointer CopyImage( const TImage * image )
+{
+  typename TImage::Pointer copy = TImage::New();
+  copy->SetRegions( image->GetLargestPossibleRegion() );
+  copy->CopyInformation( image );
+  copy->Allocate();
+  itk::ImageRegionConstIterator< TImage > itIn( image,
+    image->GetLargestPossibleRegion() );
+  itk::ImageRegionIterator< TImage > itOut( copy,
+    copy->GetLargestPossibleRegion() );
+  for( ; !itIn.IsAtEnd(); ++itIn, ++itOut )
+    {
+    itOut.Set( itIn.Get() );
+    }
+  return copy;
+}
+
+int itktubePDFSegmenterIncrementalTest( int itkNotUsed( argc ),
+  char * itkNotUsed( argv )[] )
+{
+  typedef itk::Image< float, 2 >                              ImageType;
+  typedef itk::tube::PDFSegmenter< ImageType, 2, ImageType >  FilterType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill( 64 );
+  region.SetSize( size );
+
+  // Two noisy regions in two features
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator
+    RandomType;
+  RandomType::Pointer random = RandomType::New();
+  random->Initialize( 42 );
+  ImageType::Pointer images[2];
+  for( unsigned int i = 0; i < 2; i++ )
+    {
+    images[i] = ImageType::New();
+    images[i]->SetRegions( region );
+    images[i]->Allocate();
+    itk::ImageRegionIteratorWithIndex< ImageType > it( images[i], region );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const bool inside = it.GetIndex()[0] < 32;
+      it.Set( ( inside ? 100 : 50 ) * ( i + 1 )
+        + random->GetNormalVariate( 0, 100 ) );
+      }
+    }
+
+  // The label map before and after an edit that adds, moves, and
+  // removes samples
+  ImageType::Pointer labelMaps[2];
+  for( unsigned int m = 0; m < 2; m++ )
+    {
+    labelMaps[m] = ImageType::New();
+    labelMaps[m]->SetRegions( region );
+    labelMaps[m]->Allocate();
+    itk::ImageRegionIteratorWithIndex< ImageType > it( labelMaps[m],
+      region );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const long x = it.GetIndex()[0];
+      const long y = it.GetIndex()[1];
+      float label = 0;
+      if( x >= 8 && x < 24 && y >= 8 && y < ( m == 0 ? 24 : 16 ) )
+        {
+        label = 255;
+        }
+      else if( x >= 40 && x < 56 && y >= 40 && y < 56 )
+        {
+        label = 127;
+        }
+      else if( m == 1 && x >= 40 && x < 48 && y >= 8 && y < 16 )
+        {
+        label = 127;
+        }
+      else if( m == 1 && x >= 24 && x < 30 && y >= 30 && y < 40 )
+        {
+        label = 255;
+        }
+      it.Set( label );
+      }
+    }
+
+  FilterType::Pointer filters[4];
+  for( unsigned int f = 0; f < 4; f++ )
+    {
+    filters[f] = FilterType::New();
+    filters[f]->SetInput( 0, images[0] );
+    filters[f]->SetInput( 1, images[1] );
+    filters[f]->SetObjectId( 255 );
+    filters[f]->AddObjectId( 127 );
+    filters[f]->SetVoidId( 0 );
+    filters[f]->SetErodeRadius( 1 );
+    filters[f]->SetHoleFillIterations( 2 );
+    filters[f]->SetHistogramSmoothingStandardDeviation( 2 );
+    filters[f]->SetOutlierRejectPortion( 0.1 );
+    }
+
+  // Trained from scratch on the edited label map
+  filters[0]->SetLabelMap( CopyImage( labelMaps[1].GetPointer() ) );
+  filters[0]->Update();
+
+  // Trained on the original label map, then updated in place
+  filters[1]->SetLabelMap( CopyImage( labelMaps[0].GetPointer() ) );
+  filters[1]->Update();
+  filters[1]->SetLabelMap( CopyImage( labelMaps[1].GetPointer() ) );
+  filters[1]->UpdateFromLabelMapChanges( labelMaps[0] );
+
+  // Updated from the sample histograms of the original training, as if
+  // they had been saved and read back
+  FilterType::Pointer original = FilterType::New();
+  original->SetInput( 0, images[0] );
+  original->SetInput( 1, images[1] );
+  original->SetObjectId( 255 );
+  original->AddObjectId( 127 );
+  original->SetVoidId( 0 );
+  original->SetLabelMap( CopyImage( labelMaps[0].GetPointer() ) );
+  original->Update();
+  for( unsigned int c = 0; c < 2; c++ )
+    {
+    filters[2]->SetClassSampleHistogram( c, CopyImage(
+      original->GetClassSampleHistogram( c ).GetPointer() ) );
+    }
+  filters[2]->SetLabelMap( CopyImage( labelMaps[1].GetPointer() ) );
+  filters[2]->UpdateFromLabelMapChanges( labelMaps[0] );
+
+  // Updated from sample histograms whose bins do not cover the current
+  // features, which requires training from scratch
+  ImageType::Pointer narrowImages[2];
+  for( unsigned int i = 0; i < 2; i++ )
+    {
+    narrowImages[i] = CopyImage( images[i].GetPointer() );
+    itk::ImageRegionIterator< ImageType > it( narrowImages[i], region );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( it.Get() / 2 );
+      }
+    }
+  FilterType::Pointer narrow = FilterType::New();
+  narrow->SetInput( 0, narrowImages[0] );
+  narrow->SetInput( 1, narrowImages[1] );
+  narrow->SetObjectId( 255 );
+  narrow->AddObjectId( 127 );
+  narrow->SetVoidId( 0 );
+  narrow->SetLabelMap( CopyImage( labelMaps[0].GetPointer() ) );
+  narrow->Update();
+  for( unsigned int c = 0; c < 2; c++ )
+    {
+    filters[3]->SetClassSampleHistogram( c, CopyImage(
+      narrow->GetClassSampleHistogram( c ).GetPointer() ) );
+    }
+  filters[3]->SetLabelMap( CopyImage( labelMaps[1].GetPointer() ) );
+  filters[3]->UpdateFromLabelMapChanges( labelMaps[0] );
+
+  for( unsigned int f = 1; f < 4; f++ )
+    {
+    if( filters[f]->GetRetrainedAllClasses() != ( f == 3 ) )
+      {
+      std::cerr << "Filter " << f << ": retrained all classes = "
+        << filters[f]->GetRetrainedAllClasses() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  for( unsigned int f = 1; f < 4; f++ )
+    {
+    for( unsigned int c = 0; c < 2; c++ )
+      {
+      if( !ImagesAreEqual( filters[0]->GetClassSampleHistogram( c )
+        .GetPointer(), filters[f]->GetClassSampleHistogram( c )
+        .GetPointer() ) )
+        {
+        std::cerr << "Filter " << f << ": sample histogram " << c
+          << " differs from a full training." << std::endl;
+        return EXIT_FAILURE;
+        }
+      if( !ImagesAreEqual( filters[0]->GetClassPDFImage( c ).GetPointer(),
+        filters[f]->GetClassPDFImage( c ).GetPointer() ) )
+        {
+        std::cerr << "Filter " << f << ": PDF " << c
+          << " differs from a full training." << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // The classifications agree as well
+  for( unsigned int f = 0; f < 4; f++ )
+    {
+    filters[f]->ClassifyImages();
+    }
+  for( unsigned int f = 1; f < 4; f++ )
+    {
+    if( !ImagesAreEqual( filters[0]->GetLabelMap(),
+      filters[f]->GetLabelMap() ) )
+      {
+      std::cerr << "Filter " << f
+        << ": label map differs from a full training." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // An update needs the sample histograms of a previous training
+  FilterType::Pointer untrained = FilterType::New();
+  untrained->SetObjectId( 255 );
+  untrained->AddObjectId( 127 );
+  untrained->SetLabelMap( labelMaps[1] );
+  bool caught = false;
+  try
+    {
+    untrained->UpdateFromLabelMapChanges( labelMaps[0] );
+    }
+  catch( itk::ExceptionObject & )
+    {
+    caught = true;
+    }
+  if( !caught )
+    {
+    std::cerr << "Expected an exception without sample histograms."
+      << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
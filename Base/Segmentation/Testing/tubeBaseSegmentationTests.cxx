@@ -31,6 +31,7 @@ void RegisterTests( void )
   REGISTER_TEST( tubeBaseSegmentationPrintTest );
   REGISTER_TEST( itktubeCVTImageFilterTest );
   REGISTER_TEST( itktubePDFSegmenterTest );
+  REGISTER_TEST( itktubePDFSegmenterIncrementalTest );
   REGISTER_TEST( itktubeRidgeExtractorTest );
   REGISTER_TEST( itktubeRidgeExtractorTest2 );
   REGISTER_TEST( itktubeRidgeSeedFilterTest );
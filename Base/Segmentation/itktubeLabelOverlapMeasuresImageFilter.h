@@ -24,11 +24,12 @@ limitations under the License.
 #ifndef __itktubeLabelOverlapMeasuresImageFilter_h
 #define __itktubeLabelOverlapMeasuresImageFilter_h
 
-#include <itkFastMutexLock.h>
 #include <itkInPlaceImageFilter.h>
 #include <itkNumericTraits.h>
 #include <itksys/hash_map.hxx>
 
+#include <vector>
+
 namespace itk
 {
 
@@ -39,6 +40,17 @@ namespace tube
  * \brief Computes overlap measures between the set same set of labels of
  * pixels of two images.  Background is assumed to be 0.
  *
+ * Each thread counts the (source label, target label) pairs of its region
+ * in a dense confusion table, indexed by the labels in the order the
+ * thread first meets them.  The tables are merged once at the end, and
+ * every measure is derived from the merged counts.
+ *
+ * When NumberOfStreamDivisions is greater than one, the two inputs are
+ * requested and updated one slab at a time along the slowest dimension,
+ * so that images read from disk by a streaming capable reader are never
+ * held in memory in full.  The output image is not generated in that
+ * case; only the measures are.
+ *
  * \sa LabelOverlapMeasuresImageFilter
  *
  * \ingroup MultiThreaded
@@ -136,6 +148,12 @@ public:
   MapType GetLabelSetMeasures( void )
     { return this->m_LabelSetMeasures; }
 
+  /** Set/Get the number of slabs the inputs are streamed in.  One, the
+   * default, requests the whole inputs at once. */
+  itkSetClampMacro( NumberOfStreamDivisions, unsigned int, 1,
+    NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
   /**
    * tric overlap measures
    */
@@ -177,6 +195,9 @@ protected:
 
   void PrintSelf( std::ostream& os, Indent indent ) const;
 
+  /** Stream the inputs when NumberOfStreamDivisions is greater than one. */
+  void GenerateData( void );
+
   void BeforeThreadedGenerateData( void );
 
   void AfterThreadedGenerateData( void );
@@ -196,11 +217,44 @@ private:
   //purposely not implemented
   void operator=( const Self& );
 
-  std::vector<MapType>                          m_LabelSetMeasuresPerThread;
+  /** \class ConfusionTable
+   * \brief Dense counts of (source, target) label pairs for one thread */
+  class ConfusionTable
+    {
+    public:
+      ConfusionTable( void ) : m_Capacity( 0 ) {}
+
+      void Clear( void )
+        {
+        m_Labels.clear();
+        m_Index.clear();
+        m_Counts.clear();
+        m_Capacity = 0;
+        }
+
+      /** Return the count of a label pair, adding the labels as needed.
+       * Pointers to earlier counts are invalidated if the table grows. */
+      SizeValueType & GetCount( LabelType source, LabelType target )
+        {
+        const unsigned int sourceIndex = this->GetIndex( source );
+        const unsigned int targetIndex = this->GetIndex( target );
+        return m_Counts[ sourceIndex * m_Capacity + targetIndex ];
+        }
+
+      std::vector< LabelType >                      m_Labels;
+      itksys::hash_map< LabelType, unsigned int >   m_Index;
+      std::vector< SizeValueType >                  m_Counts;
+      unsigned int                                  m_Capacity;
+
+    private:
+      unsigned int GetIndex( LabelType label );
+    }; // End class ConfusionTable
+
+  unsigned int                                  m_NumberOfStreamDivisions;
+
+  std::vector< ConfusionTable >                 m_ConfusionTablePerThread;
   MapType                                       m_LabelSetMeasures;
 
-  SimpleFastMutexLock                           m_Mutex;
-
 }; // End class LabelOverlapMeasuresImageFilter
 
 } // End namespace tube
@@ -26,31 +26,58 @@ limitations under the License.
 
 #include "itktubeLabelOverlapMeasuresImageFilter.h"
 
-#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionSplitter.h>
+#include <itkImageScanlineConstIterator.h>
 #include <itkProgressReporter.h>
 
+#include <algorithm>
+
 namespace itk
 {
 
 namespace tube
 {
 
-//NOTE: This class needs a mutex for gnu 2.95
-#if defined(__GNUC__) && (__GNUC__ <= 2)
-/** Used for mutex locking */
-#define LOCK_HASHMAP this->m_Mutex.Lock()
-#define UNLOCK_HASHMAP this->m_Mutex.Unlock()
-#else
-#define LOCK_HASHMAP
-#define UNLOCK_HASHMAP
-#endif
-
 template< class TLabelImage >
 LabelOverlapMeasuresImageFilter< TLabelImage >
 ::LabelOverlapMeasuresImageFilter( void )
 {
   // this filter requires two input images
   this->SetNumberOfRequiredInputs( 2 );
+
+  m_NumberOfStreamDivisions = 1;
+}
+
+template< class TLabelImage >
+unsigned int
+LabelOverlapMeasuresImageFilter< TLabelImage >::ConfusionTable
+::GetIndex( LabelType label )
+{
+  typename itksys::hash_map< LabelType, unsigned int >::const_iterator
+    indexIt = m_Index.find( label );
+  if( indexIt != m_Index.end() )
+    {
+    return indexIt->second;
+    }
+
+  const unsigned int index = static_cast< unsigned int >( m_Labels.size() );
+  if( index >= m_Capacity )
+    {
+    // Grow the square table, keeping the existing counts in place.
+    const unsigned int capacity = m_Capacity == 0 ? 8 : 2 * m_Capacity;
+    std::vector< SizeValueType > counts( capacity * capacity, 0 );
+    for( unsigned int i = 0; i < m_Capacity; i++ )
+      {
+      std::copy( m_Counts.begin() + i * m_Capacity,
+        m_Counts.begin() + ( i + 1 ) * m_Capacity,
+        counts.begin() + i * capacity );
+      }
+    m_Counts.swap( counts );
+    m_Capacity = capacity;
+    }
+  m_Labels.push_back( label );
+  m_Index[label] = index;
+  return index;
 }
 
 template< class TLabelImage >
@@ -59,17 +86,29 @@ LabelOverlapMeasuresImageFilter< TLabelImage >
 ::GenerateInputRequestedRegion( void )
 {
   Superclass::GenerateInputRequestedRegion();
-  if( this->GetSourceImage() )
-    {
-    typename LabelImageType::Pointer source = const_cast
-      <LabelImageType *>( this->GetSourceImage() );
-    source->SetRequestedRegionToLargestPossibleRegion();
-    }
-  if( this->GetTargetImage() )
+  for( unsigned int i = 0; i < 2; i++ )
     {
-    typename LabelImageType::Pointer target = const_cast
-      <LabelImageType *>( this->GetTargetImage() );
-    target->SetRequestedRegionToLargestPossibleRegion();
+    LabelImageType * input = const_cast< LabelImageType * >(
+      this->GetInput( i ) );
+    if( !input )
+      {
+      continue;
+      }
+    if( m_NumberOfStreamDivisions > 1 )
+      {
+      // GenerateData requests the remaining slabs
+      typedef ImageRegionSplitter< ImageDimension > SplitterType;
+      typename SplitterType::Pointer splitter = SplitterType::New();
+      const RegionType largestRegion = input->GetLargestPossibleRegion();
+      const unsigned int numberOfSlabs = splitter->GetNumberOfSplits(
+        largestRegion, m_NumberOfStreamDivisions );
+      input->SetRequestedRegion( splitter->GetSplit( 0, numberOfSlabs,
+        largestRegion ) );
+      }
+    else
+      {
+      input->SetRequestedRegionToLargestPossibleRegion();
+      }
     }
 }
 
@@ -86,17 +125,76 @@ LabelOverlapMeasuresImageFilter< TLabelImage >
 template< class TLabelImage >
 void
 LabelOverlapMeasuresImageFilter< TLabelImage >
-::BeforeThreadedGenerateData( void )
+::GenerateData( void )
 {
-  int numberOfThreads = this->GetNumberOfThreads();
+  if( m_NumberOfStreamDivisions <= 1 )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  LabelImageType * source = const_cast< LabelImageType * >(
+    this->GetSourceImage() );
+  LabelImageType * target = const_cast< LabelImageType * >(
+    this->GetTargetImage() );
+  LabelImageType * output = this->GetOutput();
+
+  if( source->GetLargestPossibleRegion()
+    != target->GetLargestPossibleRegion() )
+    {
+    itkExceptionMacro( << "The source and target images must have the "
+      << "same largest possible region." );
+    }
+  const RegionType largestRegion = source->GetLargestPossibleRegion();
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfSlabs = splitter->GetNumberOfSplits(
+    largestRegion, m_NumberOfStreamDivisions );
 
-  // Resize the thread temporaries
-  this->m_LabelSetMeasuresPerThread.resize( numberOfThreads );
+  this->BeforeThreadedGenerateData();
 
-  // Initialize the temporaries
-  for( int n = 0; n < numberOfThreads; n++ )
+  for( unsigned int slab = 0; slab < numberOfSlabs; slab++ )
     {
-    this->m_LabelSetMeasuresPerThread[n].clear();
+    const RegionType slabRegion = splitter->GetSplit( slab, numberOfSlabs,
+      largestRegion );
+
+    source->SetRequestedRegion( slabRegion );
+    source->PropagateRequestedRegion();
+    source->UpdateOutputData();
+    target->SetRequestedRegion( slabRegion );
+    target->PropagateRequestedRegion();
+    target->UpdateOutputData();
+
+    // The threads split the output requested region, which is not
+    // allocated while streaming.
+    output->SetRequestedRegion( slabRegion );
+
+    typename Superclass::ThreadStruct str;
+    str.Filter = this;
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    this->UpdateProgress( static_cast< float >( slab + 1 ) / numberOfSlabs );
+    }
+
+  this->AfterThreadedGenerateData();
+}
+
+
+template< class TLabelImage >
+void
+LabelOverlapMeasuresImageFilter< TLabelImage >
+::BeforeThreadedGenerateData( void )
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+
+  // Resize and clear the thread temporaries
+  this->m_ConfusionTablePerThread.resize( numberOfThreads );
+  for( ThreadIdType n = 0; n < numberOfThreads; n++ )
+    {
+    this->m_ConfusionTablePerThread[n].Clear();
     }
 
   // Initialize the final map
@@ -108,38 +206,50 @@ void
 LabelOverlapMeasuresImageFilter< TLabelImage >
 ::AfterThreadedGenerateData( void )
 {
-  // Run through the map for each thread and accumulate the set measures.
-  for( ThreadIdType n = 0; n < this->GetNumberOfThreads(); n++ )
+  typedef typename MapType::value_type MapValueType;
+
+  // Run through the confusion table of each thread and accumulate the set
+  // measures.
+  for( ThreadIdType n = 0; n < this->m_ConfusionTablePerThread.size(); n++ )
     {
-    // iterate over the map for this thread
-    for( MapConstIterator threadIt =
-        this->m_LabelSetMeasuresPerThread[n].begin();
-      threadIt != this->m_LabelSetMeasuresPerThread[n].end();
-      ++threadIt )
+    const ConfusionTable & table = this->m_ConfusionTablePerThread[n];
+    const unsigned int numberOfLabels =
+      static_cast< unsigned int >( table.m_Labels.size() );
+    for( unsigned int i = 0; i < numberOfLabels; i++ )
       {
-      // does this label exist in the cumulative stucture yet?
-      MapIterator mapIt = this->m_LabelSetMeasures.find(
-        ( *threadIt ).first );
-      if( mapIt == this->m_LabelSetMeasures.end() )
+      const LabelType sourceLabel = table.m_Labels[i];
+      for( unsigned int j = 0; j < numberOfLabels; j++ )
         {
-        // create a new entry
-        typedef typename MapType::value_type MapValueType;
-        mapIt = this->m_LabelSetMeasures.insert( MapValueType(
-          (*threadIt).first, LabelSetMeasures() ) ).first;
+        const SizeValueType count = table.m_Counts[i * table.m_Capacity + j];
+        if( count == 0 )
+          {
+          continue;
+          }
+        const LabelType targetLabel = table.m_Labels[j];
+
+        LabelSetMeasures & sourceMeasures = this->m_LabelSetMeasures.insert(
+          MapValueType( sourceLabel, LabelSetMeasures() ) ).first->second;
+        sourceMeasures.m_Source += count;
+        sourceMeasures.m_Union += count;
+        if( i == j )
+          {
+          sourceMeasures.m_Target += count;
+          sourceMeasures.m_Intersection += count;
+          }
+        else
+          {
+          sourceMeasures.m_SourceComplement += count;
+
+          LabelSetMeasures & targetMeasures =
+            this->m_LabelSetMeasures.insert( MapValueType( targetLabel,
+              LabelSetMeasures() ) ).first->second;
+          targetMeasures.m_Target += count;
+          targetMeasures.m_Union += count;
+          targetMeasures.m_TargetComplement += count;
+          }
         }
-
-      // accumulate the information from this thread
-      (*mapIt).second.m_Source += (*threadIt).second.m_Source;
-      (*mapIt).second.m_Target += (*threadIt).second.m_Target;
-      (*mapIt).second.m_Union += (*threadIt).second.m_Union;
-      (*mapIt).second.m_Intersection +=
-        (*threadIt).second.m_Intersection;
-      (*mapIt).second.m_SourceComplement +=
-        (*threadIt).second.m_SourceComplement;
-      (*mapIt).second.m_TargetComplement +=
-        (*threadIt).second.m_TargetComplement;
-      } // end of thread map iterator loop
-    } // end of thread loop
+      }
+    }
 }
 
 template< class TLabelImage >
@@ -148,63 +258,45 @@ LabelOverlapMeasuresImageFilter< TLabelImage >
 ::ThreadedGenerateData( const RegionType& outputRegionForThread,
   ThreadIdType threadId )
 {
-  ImageRegionConstIterator<LabelImageType > ItS( this->GetSourceImage(),
+  ImageScanlineConstIterator< LabelImageType > ItS( this->GetSourceImage(),
     outputRegionForThread );
-  ImageRegionConstIterator<LabelImageType > ItT( this->GetTargetImage(),
+  ImageScanlineConstIterator< LabelImageType > ItT( this->GetTargetImage(),
     outputRegionForThread );
 
   // support progress methods/callbacks
   ProgressReporter progress( this, threadId,
-    2*outputRegionForThread.GetNumberOfPixels() );
+    outputRegionForThread.GetNumberOfPixels()
+    / outputRegionForThread.GetSize()[0] );
 
-  for( ItS.GoToBegin(), ItT.GoToBegin(); !ItS.IsAtEnd(); ++ItS, ++ItT )
-    {
-    LabelType sourceLabel = ItS.Get();
-    LabelType targetLabel = ItT.Get();
-
-    // is the label already in this thread?
-    MapIterator mapItS =
-      this->m_LabelSetMeasuresPerThread[threadId].find( sourceLabel );
-    MapIterator mapItT =
-      this->m_LabelSetMeasuresPerThread[threadId].find( targetLabel );
-
-    if( mapItS == this->m_LabelSetMeasuresPerThread[threadId].end() )
-      {
-      // create a new label set measures object
-      typedef typename MapType::value_type MapValueType;
-      LOCK_HASHMAP;
-      mapItS = this->m_LabelSetMeasuresPerThread[threadId].insert(
-        MapValueType( sourceLabel, LabelSetMeasures() ) ).first;
-      UNLOCK_HASHMAP;
-      }
-
-    if( mapItT == this->m_LabelSetMeasuresPerThread[threadId].end() )
-      {
-      // create a new label set measures object
-      typedef typename MapType::value_type MapValueType;
-      LOCK_HASHMAP;
-      mapItT = this->m_LabelSetMeasuresPerThread[threadId].insert(
-        MapValueType( targetLabel, LabelSetMeasures() ) ).first;
-      UNLOCK_HASHMAP;
-      }
+  ConfusionTable & table = this->m_ConfusionTablePerThread[threadId];
 
-    (*mapItS).second.m_Source++;
-    (*mapItT).second.m_Target++;
+  // Neighboring pixels mostly share their pair of labels, so the count of
+  // the previous pair is kept at hand.
+  SizeValueType * count = NULL;
+  LabelType previousSourceLabel = NumericTraits< LabelType >::Zero;
+  LabelType previousTargetLabel = NumericTraits< LabelType >::Zero;
 
-    if( sourceLabel == targetLabel )
-      {
-      (*mapItS).second.m_Intersection++;
-      (*mapItS).second.m_Union++;
-      }
-    else
+  ItS.GoToBegin();
+  ItT.GoToBegin();
+  while( !ItS.IsAtEnd() )
+    {
+    while( !ItS.IsAtEndOfLine() )
       {
-      (*mapItS).second.m_Union++;
-      (*mapItT).second.m_Union++;
-
-      (*mapItS).second.m_SourceComplement++;
-      (*mapItT).second.m_TargetComplement++;
+      const LabelType sourceLabel = ItS.Get();
+      const LabelType targetLabel = ItT.Get();
+      if( count == NULL || sourceLabel != previousSourceLabel
+        || targetLabel != previousTargetLabel )
+        {
+        count = &( table.GetCount( sourceLabel, targetLabel ) );
+        previousSourceLabel = sourceLabel;
+        previousTargetLabel = targetLabel;
+        }
+      ++( *count );
+      ++ItS;
+      ++ItT;
       }
-
+    ItS.NextLine();
+    ItT.NextLine();
     progress.CompletedPixel();
     }
 }
@@ -431,6 +523,10 @@ LabelOverlapMeasuresImageFilter< TLabelImage >
 {
   Superclass::PrintSelf( os, indent );
 
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions
+     << std::endl;
+  os << indent << "Number of labels: " << m_LabelSetMeasures.size()
+     << std::endl;
 }
 
 } // End namespace tube
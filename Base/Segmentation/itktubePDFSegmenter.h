@@ -26,6 +26,7 @@ limitations under the License.
 
 #include <itkImage.h>
 #include <itkListSample.h>
+#include <itkVectorImage.h>
 
 #include <vector>
 
@@ -76,8 +77,16 @@ public:
   typedef HistogramPixelType                   PDFPixelType;
   typedef HistogramImageType                   PDFImageType;
 
+  typedef double                               SampleHistogramPixelType;
+  typedef Image< SampleHistogramPixelType, N > SampleHistogramImageType;
+
   typedef Image< LabelMapPixelType, N >        LabeledFeatureSpaceType;
 
+  /** Pixel-interleaved features, such as those of
+   *  FeatureVectorGenerator::GetFeatureVectorImage() */
+  typedef VectorImage< PixelType, TImage::ImageDimension >
+                                               FeatureVectorImageType;
+
   typedef std::vector< double >                VectorDoubleType;
   typedef std::vector< int >                   VectorIntType;
   typedef std::vector< unsigned int >          VectorUIntType;
@@ -88,6 +97,11 @@ public:
   void SetInput( unsigned int featureNumber,
     typename ImageType::Pointer vol );
 
+  /** Read the features from the first N components of an interleaved
+   *   image instead of from the images given to SetInput(). */
+  void SetFeatureVectorImage(
+    typename FeatureVectorImageType::Pointer featureVectorImage );
+
   void ClearObjectIds( void );
   void SetObjectId( ObjectIdType objectId );
   void AddObjectId( ObjectIdType objectId );
@@ -136,6 +150,30 @@ public:
   void SetClassPDFImage( unsigned int classNum,
     typename PDFImageType::Pointer classPDF );
 
+  /** Joint histogram of the feature values of the samples of a class,
+   *   before outlier rejection and smoothing.  Kept by Update() so that
+   *   the PDFs can later be retrained incrementally. */
+  typename SampleHistogramImageType::Pointer GetClassSampleHistogram(
+    unsigned int classNum ) const;
+
+  /** Set the sample histogram of a class from a previous training.  Its
+   *   origin, spacing, and size define the histogram bins. */
+  void SetClassSampleHistogram( unsigned int classNum,
+    typename SampleHistogramImageType::Pointer classHistogram );
+
+  /** Retrain after the label map has been edited.  The samples of the
+   *   voxels whose label differs from previousLabelMap are moved between
+   *   the class sample histograms, and only the PDFs of the classes that
+   *   changed are regenerated.  The sample histograms must come from
+   *   Update() or SetClassSampleHistogram(), for the same features.  If a
+   *   class sample lies outside of their bins, all of the classes are
+   *   retrained by Update() instead. */
+  void UpdateFromLabelMapChanges( const LabelMapType * previousLabelMap );
+
+  /** Whether the last UpdateFromLabelMapChanges() fell back to retraining
+   *   all of the classes by Update(). */
+  itkGetMacro( RetrainedAllClasses, bool );
+
   const VectorUIntType & GetNumberOfBinsPerFeature( void ) const;
   void             SetNumberOfBinsPerFeature( const VectorUIntType & nBin );
   const VectorDoubleType & GetBinMin( void ) const;
@@ -180,6 +218,15 @@ protected:
 
   void GenerateSample( void );
   void GeneratePDFs( void );
+
+  /** Build the class sample histograms from the class samples. */
+  void GenerateSampleHistograms( void );
+
+  /** Reject the outliers of, and smooth, one class sample histogram.
+   *   The class samples decide which samples of the boundary bins are
+   *   rejected. */
+  void GeneratePDF( unsigned int classNum );
+
   void ApplyPDFs( void );
 
   void PrintSelf( std::ostream & os, Indent indent ) const;
@@ -199,6 +246,25 @@ private:
   typedef itk::Statistics::ListSample< ListVectorType >   ListSampleType;
   typedef std::vector< typename ListSampleType::Pointer > ClassListSampleType;
 
+  typedef std::vector< typename SampleHistogramImageType::Pointer >
+    ClassSampleHistogramImageType;
+
+  /** Feature i of the voxel at buffer offset v is
+   *   buffers[i][v * stride], whether the features come from the input
+   *   images or from the feature vector image. */
+  void GetFeatureBuffers( std::vector< const PixelType * > & buffers,
+    SizeValueType & stride ) const;
+
+  /** Image defining the grid of the features */
+  const ImageBase< ImageDimension > * GetFeatureGeometry( void ) const;
+
+  /** Histogram bin of the features of a sample, clamped to the bins. */
+  typename SampleHistogramImageType::IndexType GetSampleBin(
+    const ListVectorType & sample ) const;
+
+  /** Whether the features of a sample lie within the histogram bins. */
+  bool IsSampleInBinRange( const ListVectorType & sample ) const;
+
   bool                                     m_SampleUpToDate;
   bool                                     m_PDFsUpToDate;
   bool                                     m_ImagesUpToDate;
@@ -206,6 +272,7 @@ private:
   ClassListSampleType                      m_InClassList;
   typename ListSampleType::Pointer         m_OutClassList;
 
+  ClassSampleHistogramImageType            m_InClassSampleHistogram;
   ClassHistogramImageType                  m_InClassHistogram;
   VectorDoubleType                         m_HistogramBinMin;
   VectorDoubleType                         m_HistogramBinSize;
@@ -213,6 +280,7 @@ private:
 
   //  Data
   std::vector< typename ImageType::Pointer > m_InputImageList;
+  typename FeatureVectorImageType::Pointer   m_FeatureVectorImage;
 
   typename LabelMapType::Pointer  m_LabelMap;
 
@@ -231,6 +299,7 @@ private:
   bool                            m_ReclassifyObjectLabels;
   bool                            m_ReclassifyNotObjectLabels;
   bool                            m_ForceClassification;
+  bool                            m_RetrainedAllClasses;
 
   ProbabilityImageVectorType      m_ProbabilityImageVector;
 
@@ -43,8 +43,6 @@ limitations under the License.
 #include <itkTimeProbesCollectorBase.h>
 #include <itkVotingBinaryIterativeHoleFillingImageFilter.h>
 
-#include <vnl/vnl_matrix.h>
-
 #include <limits>
 
 namespace itk
@@ -63,6 +61,7 @@ PDFSegmenter< TImage, N, TLabelMap >
 
   m_InClassList.clear();
   m_OutClassList = NULL;
+  m_InClassSampleHistogram.clear();
   m_InClassHistogram.clear();
 
   m_HistogramBinMin.resize( N, 0 );
@@ -71,6 +70,7 @@ PDFSegmenter< TImage, N, TLabelMap >
 
   m_InputImageList.clear();
   m_InputImageList.resize( N, NULL );
+  m_FeatureVectorImage = NULL;
 
   m_LabelMap = NULL;
 
@@ -87,6 +87,7 @@ PDFSegmenter< TImage, N, TLabelMap >
   m_ReclassifyObjectLabels = false;
   m_ReclassifyNotObjectLabels = false;
   m_ForceClassification = false;
+  m_RetrainedAllClasses = false;
 
   m_ProbabilityImageVector.resize( 0 );
 
@@ -258,6 +259,41 @@ PDFSegmenter< TImage, N, TLabelMap >
   m_ImagesUpToDate = false;
 }
 
+template< class TImage, unsigned int N, class TLabelMap >
+typename PDFSegmenter< TImage, N, TLabelMap >::SampleHistogramImageType::Pointer
+PDFSegmenter< TImage, N, TLabelMap >
+::GetClassSampleHistogram( unsigned int classNum ) const
+{
+  if( classNum < m_InClassSampleHistogram.size() )
+    {
+    return m_InClassSampleHistogram[classNum];
+    }
+  return NULL;
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::SetClassSampleHistogram( unsigned int classNum,
+  typename SampleHistogramImageType::Pointer classHistogram )
+{
+  if( m_ObjectIdList.size() != m_InClassSampleHistogram.size() )
+    {
+    m_InClassSampleHistogram.resize( m_ObjectIdList.size() );
+    }
+  m_InClassSampleHistogram[classNum] = classHistogram;
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    m_HistogramBinMin[i] = classHistogram->GetOrigin()[i];
+    m_HistogramBinSize[i] = classHistogram->GetSpacing()[i];
+    m_HistogramNumberOfBin[i] =
+      classHistogram->GetLargestPossibleRegion().GetSize()[i];
+    }
+  m_SampleUpToDate = false;
+  m_PDFsUpToDate = false;
+  m_ImagesUpToDate = false;
+}
+
 template< class TImage, unsigned int N, class TLabelMap >
 const typename PDFSegmenter< TImage, N, TLabelMap >::VectorUIntType &
 PDFSegmenter< TImage, N, TLabelMap >
@@ -317,6 +353,59 @@ PDFSegmenter< TImage, N, TLabelMap >
     }
 }
 
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::SetFeatureVectorImage(
+  typename FeatureVectorImageType::Pointer featureVectorImage )
+{
+  if( featureVectorImage.IsNotNull()
+    && featureVectorImage->GetNumberOfComponentsPerPixel() < N )
+    {
+    itkExceptionMacro( << "The feature vector image needs at least " << N
+      << " components." );
+    }
+  m_FeatureVectorImage = featureVectorImage;
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::GetFeatureBuffers( std::vector< const PixelType * > & buffers,
+  SizeValueType & stride ) const
+{
+  buffers.resize( N );
+  if( m_FeatureVectorImage.IsNotNull() )
+    {
+    stride = m_FeatureVectorImage->GetNumberOfComponentsPerPixel();
+    const PixelType * buffer = m_FeatureVectorImage->GetBufferPointer();
+    for( unsigned int i = 0; i < N; i++ )
+      {
+      buffers[i] = buffer + i;
+      }
+    }
+  else
+    {
+    stride = 1;
+    for( unsigned int i = 0; i < N; i++ )
+      {
+      buffers[i] = m_InputImageList[i]->GetBufferPointer();
+      }
+    }
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+const ImageBase< TImage::ImageDimension > *
+PDFSegmenter< TImage, N, TLabelMap >
+::GetFeatureGeometry( void ) const
+{
+  if( m_FeatureVectorImage.IsNotNull() )
+    {
+    return m_FeatureVectorImage.GetPointer();
+    }
+  return m_InputImageList[0].GetPointer();
+}
+
 template< class TImage, unsigned int N, class TLabelMap >
 void
 PDFSegmenter< TImage, N, TLabelMap >
@@ -342,21 +431,22 @@ PDFSegmenter< TImage, N, TLabelMap >
 
   typedef itk::ImageRegionConstIteratorWithIndex< LabelMapType >
     ConstLabelMapIteratorType;
-  typedef itk::ImageRegionConstIteratorWithIndex< ImageType >
-    ConstImageIteratorType;
 
   ConstLabelMapIteratorType itInLabelMap( m_LabelMap,
     m_LabelMap->GetLargestPossibleRegion() );
   itInLabelMap.GoToBegin();
 
-  ConstImageIteratorType * itInIm[N];
+  // The features are read straight from the buffers, at the offset of
+  //   the label map voxel
+  std::vector< const PixelType * > featureBuffer;
+  SizeValueType featureStride;
+  this->GetFeatureBuffers( featureBuffer, featureStride );
+  SizeValueType featureOffset = 0;
+
   VectorDoubleType histogramBinMax;
   histogramBinMax.resize( N );
   for( unsigned int i = 0; i < N; i++ )
     {
-    itInIm[i] = new ConstImageIteratorType( m_InputImageList[i],
-      m_InputImageList[i]->GetLargestPossibleRegion() );
-    itInIm[i]->GoToBegin();
     m_HistogramBinMin[i] = 99999999999;
     histogramBinMax[i] = -99999999999;
     }
@@ -368,7 +458,7 @@ PDFSegmenter< TImage, N, TLabelMap >
     indx = itInLabelMap.GetIndex();
     for( unsigned int i = 0; i < N; i++ )
       {
-      v[i] = static_cast< PixelType >( itInIm[i]->Get() );
+      v[i] = featureBuffer[i][ featureOffset * featureStride ];
       }
     for( unsigned int i = 0; i < ImageDimension; i++ )
       {
@@ -406,19 +496,13 @@ PDFSegmenter< TImage, N, TLabelMap >
         }
       }
     ++itInLabelMap;
-    for( unsigned int i = 0; i < N; i++ )
-      {
-      ++( *( itInIm[i] ) );
-      }
+    ++featureOffset;
     if( m_Draft )
       {
       for( unsigned int count = 1; count < 4; count++ )
         {
         ++itInLabelMap;
-        for( unsigned int i = 0; i < N; i++ )
-          {
-          ++( *( itInIm[i] ) );
-          }
+        ++featureOffset;
         }
       }
     }
@@ -432,11 +516,6 @@ PDFSegmenter< TImage, N, TLabelMap >
       << std::endl;
     }
 
-  for( unsigned int i = 0; i < N; i++ )
-    {
-    delete itInIm[i];
-    }
-
   timeCollector.Stop( "GenerateSample" );
 
   timeCollector.Report();
@@ -457,234 +536,519 @@ PDFSegmenter< TImage, N, TLabelMap >
 
   unsigned int numClasses = m_ObjectIdList.size();
 
-  //
-  // Convert lists to histograms that have the same span ( using range
-  //   defined above )
-  //
-
   timeCollector.Start( "ListsToHistograms" );
-  // Inside
+  this->GenerateSampleHistograms();
+  timeCollector.Stop( "ListsToHistograms" );
 
-  std::vector< VectorDoubleType > clipMin;
-  std::vector< VectorDoubleType > clipMax;
-  if( true ) // creating a local context to limit memory footprint
+  timeCollector.Start( "HistogramToPDF" );
+  m_InClassHistogram.resize( numClasses );
+  for( unsigned int c = 0; c < numClasses; c++ )
     {
-    clipMin.resize( numClasses );
-    clipMax.resize( numClasses );
+    this->GeneratePDF( c );
+    }
+  timeCollector.Stop( "HistogramToPDF" );
 
-    std::vector< vnl_matrix< double > > inImHistogram;
-    inImHistogram.resize( numClasses );
-    for( unsigned int c = 0; c < numClasses; c++ )
+  timeCollector.Report();
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+typename PDFSegmenter< TImage, N, TLabelMap >::SampleHistogramImageType::IndexType
+PDFSegmenter< TImage, N, TLabelMap >
+::GetSampleBin( const ListVectorType & sample ) const
+{
+  typename SampleHistogramImageType::IndexType binIndex;
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    double binV = sample[i];
+    binV = ( int )( ( binV - m_HistogramBinMin[i] )
+      / m_HistogramBinSize[i] + 0.5 );
+    if( binV>m_HistogramNumberOfBin[i]-1 )
       {
-      clipMin[c].resize( N );
-      clipMax[c].resize( N );
-      unsigned int maxN = m_HistogramNumberOfBin[0];
-      for( unsigned int i = 1; i < N; ++i )
-        {
-        if( m_HistogramNumberOfBin[i] > maxN )
-          {
-          maxN = m_HistogramNumberOfBin[i];
-          }
-        }
-      inImHistogram[c].set_size( N, maxN );
-      inImHistogram[c].fill( 0 );
+      binV = m_HistogramNumberOfBin[i]-1;
       }
-
-    unsigned int totalIn = 0;
-    itk::Array<unsigned int> totalInClass( numClasses );
-    totalInClass.Fill( 0 );
-    for( unsigned int c = 0; c < numClasses; c++ )
+    else if( binV<0 )
       {
-      typename ListSampleType::ConstIterator
-        inClassListIt( m_InClassList[c]->Begin() );
-      typename ListSampleType::ConstIterator
-        inClassListItEnd( m_InClassList[c]->End() );
-      double binV;
-      while( inClassListIt != inClassListItEnd )
-        {
-        for( unsigned int i = 0; i < N; i++ )
-          {
-          binV = inClassListIt.GetMeasurementVector()[i];
-          binV = ( int )( ( binV - m_HistogramBinMin[i] )
-            / m_HistogramBinSize[i] + 0.5 );
-          if( binV>m_HistogramNumberOfBin[i]-1 )
-            {
-            binV = m_HistogramNumberOfBin[i]-1;
-            }
-          else if( binV<0 )
-            {
-            binV = 0;
-            }
-          ++( ( inImHistogram[c][i] )[( int )binV] );
-          }
-        ++totalIn;
-        ++totalInClass[c];
-        ++inClassListIt;
-        }
+      binV = 0;
       }
+    binIndex[i] = static_cast< long >( binV );
+    }
+  return binIndex;
+}
 
-    unsigned int count;
-    for( unsigned int c = 0; c < numClasses; c++ )
+template< class TImage, unsigned int N, class TLabelMap >
+bool
+PDFSegmenter< TImage, N, TLabelMap >
+::IsSampleInBinRange( const ListVectorType & sample ) const
+{
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    const double binMax = m_HistogramBinMin[i]
+      + m_HistogramNumberOfBin[i] * m_HistogramBinSize[i];
+    if( sample[i] < m_HistogramBinMin[i] || sample[i] > binMax )
       {
-      double tailReject = totalInClass[c] * ( m_OutlierRejectPortion/2 );
-      for( unsigned int i = 0; i < N; i++ )
-        {
-        count = 0;
-        for( unsigned int b = 0; b < m_HistogramNumberOfBin[i]; b++ )
-          {
-          count += static_cast<unsigned int>( inImHistogram[c][i][b] );
-          if( count>=tailReject )
-            {
-            clipMin[c][i] =  b * m_HistogramBinSize[i]
-              + m_HistogramBinMin[i];
-            break;
-            }
-          }
-        count = 0;
-        for( int b = ( int )m_HistogramNumberOfBin[i]-1; b >= 0; b-- )
-          {
-          count += static_cast<unsigned int>( inImHistogram[c][i][b] );
-          if( count>=tailReject )
-            {
-            clipMax[c][i] =  b * m_HistogramBinSize[i]
-              + m_HistogramBinMin[i];
-            break;
-            }
-          }
-        }
+      return false;
       }
     }
-  timeCollector.Stop( "ListsToHistograms" );
+  return true;
+}
 
-  //
-  //  Create joint histograms
-  //
-  timeCollector.Start( "JointClassHistogram" );
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::GenerateSampleHistograms( void )
+{
+  unsigned int numClasses = m_ObjectIdList.size();
 
-  typename HistogramImageType::SizeType size;
-  typename HistogramImageType::SpacingType spacing;
-  typename HistogramImageType::PointType origin;
-  typename HistogramImageType::RegionType region;
+  typename SampleHistogramImageType::SizeType size;
+  typename SampleHistogramImageType::SpacingType spacing;
+  typename SampleHistogramImageType::PointType origin;
   for( unsigned int i = 0; i < N; i++ )
     {
     spacing[i] = m_HistogramBinSize[i];
     origin[i] = m_HistogramBinMin[i];
     size[i] = m_HistogramNumberOfBin[i];
     }
-  region.SetSize( size );
 
-  m_InClassHistogram.resize( numClasses );
+  m_InClassSampleHistogram.resize( numClasses );
   for( unsigned int c = 0; c < numClasses; c++ )
     {
-    m_InClassHistogram[c] = HistogramImageType::New();
-    m_InClassHistogram[c]->SetRegions( size );
-    m_InClassHistogram[c]->SetOrigin( origin );
-    m_InClassHistogram[c]->SetSpacing( spacing );
-    m_InClassHistogram[c]->Allocate();
-    m_InClassHistogram[c]->FillBuffer( 0 );
+    m_InClassSampleHistogram[c] = SampleHistogramImageType::New();
+    m_InClassSampleHistogram[c]->SetRegions( size );
+    m_InClassSampleHistogram[c]->SetOrigin( origin );
+    m_InClassSampleHistogram[c]->SetSpacing( spacing );
+    m_InClassSampleHistogram[c]->Allocate();
+    m_InClassSampleHistogram[c]->FillBuffer( 0 );
 
-    unsigned int count = 0;
     typename ListSampleType::ConstIterator
       inClassListIt( m_InClassList[c]->Begin() );
     typename ListSampleType::ConstIterator
       inClassListItEnd( m_InClassList[c]->End() );
-    typename HistogramImageType::IndexType indxHistogram;
     while( inClassListIt != inClassListItEnd )
       {
-      bool valid = true;
+      ++( m_InClassSampleHistogram[c]->GetPixel(
+        this->GetSampleBin( inClassListIt.GetMeasurementVector() ) ) );
+      ++inClassListIt;
+      }
+    }
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::GeneratePDF( unsigned int c )
+{
+  const SampleHistogramImageType * sampleHistogram =
+    m_InClassSampleHistogram[c];
+  const typename SampleHistogramImageType::RegionType region =
+    sampleHistogram->GetLargestPossibleRegion();
+
+  //
+  // Reject the tails of the histogram of each feature.  The cut lies at
+  //   the center of the first and of the last kept bins.
+  //
+  std::vector< VectorDoubleType > featureHistogram( N );
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    featureHistogram[i].resize( m_HistogramNumberOfBin[i], 0 );
+    }
+  double totalInClass = 0;
+  itk::ImageRegionConstIteratorWithIndex< SampleHistogramImageType >
+    sampleIt( sampleHistogram, region );
+  while( !sampleIt.IsAtEnd() )
+    {
+    const double count = sampleIt.Get();
+    if( count > 0 )
+      {
+      totalInClass += count;
       for( unsigned int i = 0; i < N; i++ )
         {
-        double binV = inClassListIt.GetMeasurementVector()[i];
-        if( binV >= clipMin[c][i] && binV <= clipMax[c][i] )
-          {
-          binV = ( int )( ( binV - m_HistogramBinMin[i] )
-            / m_HistogramBinSize[i] + 0.5 );
-          if( binV<0 || binV>=m_HistogramNumberOfBin[i] )
-            {
-            valid = false;
-            break;
-            }
-          indxHistogram[i] = ( int )binV;
-          }
-        else
-          {
-          valid = false;
-          break;
-          }
+        featureHistogram[i][ sampleIt.GetIndex()[i] ] += count;
         }
-      if( valid )
+      }
+    ++sampleIt;
+    }
+
+  VectorIntType clipMin( N, 0 );
+  VectorIntType clipMax( N, 0 );
+  double tailReject = totalInClass * ( m_OutlierRejectPortion/2 );
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    clipMax[i] = ( int )m_HistogramNumberOfBin[i]-1;
+    double count = 0;
+    for( unsigned int b = 0; b < m_HistogramNumberOfBin[i]; b++ )
+      {
+      count += featureHistogram[i][b];
+      if( count>=tailReject )
         {
-        ++count;
-        ++( m_InClassHistogram[c]->GetPixel( indxHistogram ) );
+        clipMin[i] = b;
+        break;
+        }
+      }
+    count = 0;
+    for( int b = ( int )m_HistogramNumberOfBin[i]-1; b >= 0; b-- )
+      {
+      count += featureHistogram[i][b];
+      if( count>=tailReject )
+        {
+        clipMax[i] = b;
+        break;
         }
-      ++inClassListIt;
       }
     }
-  timeCollector.Stop( "JointClassHistogram" );
 
   //
-  //  Convert histograms to images so that we can perform blurring to
-  //    generate parzen window density estimates
+  //  Joint histogram of the samples within the clipped range
   //
-  timeCollector.Start( "HistogramToPDF" );
-  if( true ) // creating a local context to limit memory footprint
+  if( m_InClassHistogram.size() != m_ObjectIdList.size() )
     {
-    typedef itk::RecursiveGaussianImageFilter< HistogramImageType,
-      HistogramImageType > HistogramBlurGenType;
-    typename HistogramImageType::SpacingType tempSpacing;
-    typename HistogramImageType::SpacingType oneSpacing;
-    oneSpacing.Fill( 1 );
-    for( unsigned int c = 0; c < numClasses; c++ )
+    m_InClassHistogram.resize( m_ObjectIdList.size() );
+    }
+  m_InClassHistogram[c] = HistogramImageType::New();
+  m_InClassHistogram[c]->SetRegions( region );
+  m_InClassHistogram[c]->CopyInformation( sampleHistogram );
+  m_InClassHistogram[c]->Allocate();
+
+  itk::ImageRegionIterator< HistogramImageType > inClassHistogramIt(
+    m_InClassHistogram[c], region );
+  sampleIt.GoToBegin();
+  while( !sampleIt.IsAtEnd() )
+    {
+    bool valid = true;
+    for( unsigned int i = 0; i < N; i++ )
       {
-      double inPTotal = 0;
+      const int b = sampleIt.GetIndex()[i];
+      if( b < clipMin[i] || b > clipMax[i] )
+        {
+        valid = false;
+        break;
+        }
+      }
+    inClassHistogramIt.Set( valid ? sampleIt.Get() : 0 );
+    ++sampleIt;
+    ++inClassHistogramIt;
+    }
 
-      tempSpacing = m_InClassHistogram[c]->GetSpacing();
-      m_InClassHistogram[c]->SetSpacing( oneSpacing );
+  // The samples of the first and last kept bins that lie beyond the
+  //   center of their bin are rejected as well
+  VectorDoubleType clipMinValue( N );
+  VectorDoubleType clipMaxValue( N );
+  for( unsigned int i = 0; i < N; i++ )
+    {
+    clipMinValue[i] = clipMin[i] * m_HistogramBinSize[i]
+      + m_HistogramBinMin[i];
+    clipMaxValue[i] = clipMax[i] * m_HistogramBinSize[i]
+      + m_HistogramBinMin[i];
+    }
+  typename ListSampleType::ConstIterator
+    inClassListIt( m_InClassList[c]->Begin() );
+  typename ListSampleType::ConstIterator
+    inClassListItEnd( m_InClassList[c]->End() );
+  while( inClassListIt != inClassListItEnd )
+    {
+    const ListVectorType & sample = inClassListIt.GetMeasurementVector();
+    const typename SampleHistogramImageType::IndexType binIndex =
+      this->GetSampleBin( sample );
+    bool kept = true;
+    bool beyond = false;
+    for( unsigned int i = 0; i < N; i++ )
+      {
+      if( binIndex[i] < clipMin[i] || binIndex[i] > clipMax[i] )
+        {
+        kept = false;
+        break;
+        }
+      if( sample[i] < clipMinValue[i] || sample[i] > clipMaxValue[i] )
+        {
+        beyond = true;
+        }
+      }
+    if( kept && beyond )
+      {
+      --( m_InClassHistogram[c]->GetPixel( binIndex ) );
+      }
+    ++inClassListIt;
+    }
+
+  //
+  //  Blur the histogram to generate a parzen window density estimate
+  //
+  typedef itk::RecursiveGaussianImageFilter< HistogramImageType,
+    HistogramImageType > HistogramBlurGenType;
+  typename HistogramImageType::SpacingType tempSpacing;
+  typename HistogramImageType::SpacingType oneSpacing;
+  oneSpacing.Fill( 1 );
+
+  double inPTotal = 0;
+
+  tempSpacing = m_InClassHistogram[c]->GetSpacing();
+  m_InClassHistogram[c]->SetSpacing( oneSpacing );
+
+  typename HistogramBlurGenType::Pointer inClassHistogramBlurGen =
+    HistogramBlurGenType::New();
+  for( unsigned int f = 0; f < N; f++ )
+    {
+    inClassHistogramBlurGen->SetInput( m_InClassHistogram[c] );
+    inClassHistogramBlurGen->SetDirection( f );
+    inClassHistogramBlurGen->SetOrder(
+      HistogramBlurGenType::ZeroOrder );
+    inClassHistogramBlurGen->SetSigma(
+      m_HistogramSmoothingStandardDeviation );
+    inClassHistogramBlurGen->Update();
+    m_InClassHistogram[c] = inClassHistogramBlurGen->GetOutput();
+    }
 
-      typename HistogramBlurGenType::Pointer inClassHistogramBlurGen =
-        HistogramBlurGenType::New();
-      for( unsigned int f = 0; f < N; f++ )
+  m_InClassHistogram[c]->SetSpacing( tempSpacing );
+
+  inClassHistogramIt = itk::ImageRegionIterator< HistogramImageType >(
+    m_InClassHistogram[c],
+    m_InClassHistogram[c]->GetLargestPossibleRegion() );
+  while( !inClassHistogramIt.IsAtEnd() )
+    {
+    double tf = inClassHistogramIt.Get();
+    inPTotal += tf;
+    ++inClassHistogramIt;
+    }
+
+  if( inPTotal > 0 )
+    {
+    inClassHistogramIt.GoToBegin();
+    while( !inClassHistogramIt.IsAtEnd() )
+      {
+      double tf = inClassHistogramIt.Get() / inPTotal;
+      if( tf < 0 )
         {
-        inClassHistogramBlurGen->SetInput( m_InClassHistogram[c] );
-        inClassHistogramBlurGen->SetDirection( f );
-        inClassHistogramBlurGen->SetOrder(
-          HistogramBlurGenType::ZeroOrder );
-        inClassHistogramBlurGen->SetSigma(
-          m_HistogramSmoothingStandardDeviation );
-        inClassHistogramBlurGen->Update();
-        m_InClassHistogram[c] = inClassHistogramBlurGen->GetOutput();
+        tf = 0;
         }
+      inClassHistogramIt.Set( tf );
+      ++inClassHistogramIt;
+      }
+    }
+}
+
+template< class TImage, unsigned int N, class TLabelMap >
+void
+PDFSegmenter< TImage, N, TLabelMap >
+::UpdateFromLabelMapChanges( const LabelMapType * previousLabelMap )
+{
+  m_RetrainedAllClasses = false;
+
+  unsigned int numClasses = m_ObjectIdList.size();
+
+  if( m_InClassSampleHistogram.size() != numClasses )
+    {
+    itkExceptionMacro( << "A sample histogram is needed for each class." );
+    }
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    if( m_InClassSampleHistogram[c].IsNull() )
+      {
+      itkExceptionMacro( << "Sample histogram " << c << " is not set." );
+      }
+    }
+  if( m_LabelMap.IsNull() || previousLabelMap == NULL
+    || m_LabelMap->GetLargestPossibleRegion()
+    != previousLabelMap->GetLargestPossibleRegion() )
+    {
+    itkExceptionMacro(
+      << "The label maps must be set and span the same region." );
+    }
 
-      m_InClassHistogram[c]->SetSpacing( tempSpacing );
+  itk::TimeProbesCollectorBase timeCollector;
 
-      itk::ImageRegionIterator<HistogramImageType> inClassHistogramIt(
-        m_InClassHistogram[c],
-        m_InClassHistogram[c]->GetLargestPossibleRegion() );
-      while( !inClassHistogramIt.IsAtEnd() )
+  timeCollector.Start( "LabelMapChanges" );
+
+  //
+  //  Rebuild the sample lists, which only requires reading the features
+  //    of labeled voxels, and find the region spanned by the voxels whose
+  //    label changed.  The voxels are those visited by GenerateSample.
+  //
+  m_InClassList.resize( numClasses );
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    m_InClassList[c] = ListSampleType::New();
+    }
+  m_OutClassList = ListSampleType::New();
+
+  std::vector< const PixelType * > featureBuffer;
+  SizeValueType featureStride;
+  this->GetFeatureBuffers( featureBuffer, featureStride );
+
+  const LabelMapPixelType * labels = m_LabelMap->GetBufferPointer();
+  const LabelMapPixelType * previousLabels =
+    previousLabelMap->GetBufferPointer();
+  const SizeValueType numberOfVoxels =
+    m_LabelMap->GetLargestPossibleRegion().GetNumberOfPixels();
+  const SizeValueType step = ( m_Draft ) ? 4 : 1;
+
+  typename LabelMapType::IndexType changedMin;
+  typename LabelMapType::IndexType changedMax;
+  changedMin.Fill( 0 );
+  changedMax.Fill( 0 );
+  bool changed = false;
+  bool inRange = true;
+
+  ListVectorType v;
+  typename LabelMapType::IndexType indx;
+  for( SizeValueType featureOffset = 0; featureOffset < numberOfVoxels;
+    featureOffset += step )
+    {
+    if( labels[featureOffset] != previousLabels[featureOffset] )
+      {
+      indx = m_LabelMap->ComputeIndex( featureOffset );
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        if( !changed || indx[i] < changedMin[i] )
+          {
+          changedMin[i] = indx[i];
+          }
+        if( !changed || indx[i] > changedMax[i] )
+          {
+          changedMax[i] = indx[i];
+          }
+        }
+      changed = true;
+      }
+    const int val = labels[featureOffset];
+    if( val == m_VoidId )
+      {
+      continue;
+      }
+    for( unsigned int i = 0; i < N; i++ )
+      {
+      v[i] = featureBuffer[i][ featureOffset * featureStride ];
+      }
+    indx = m_LabelMap->ComputeIndex( featureOffset );
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      v[N+i] = indx[i];
+      }
+    int valClass = -1;
+    for( unsigned int c = 0; c < numClasses; c++ )
+      {
+      if( val == m_ObjectIdList[c] )
         {
-        double tf = inClassHistogramIt.Get();
-        inPTotal += tf;
-        ++inClassHistogramIt;
+        valClass = c;
+        break;
         }
+      }
+    if( valClass >= 0 )
+      {
+      m_InClassList[valClass]->PushBack( v );
+      inRange = inRange && this->IsSampleInBinRange( v );
+      }
+    else
+      {
+      m_OutClassList->PushBack( v );
+      }
+    }
 
-      if( inPTotal > 0 )
+  //
+  //  Move the changed voxels between the class sample histograms.  Only
+  //    the region spanned by the changes is visited.
+  //
+  std::vector< bool > classChanged( numClasses, false );
+  if( changed && inRange )
+    {
+    typename LabelMapType::RegionType changedRegion;
+    changedRegion.SetIndex( changedMin );
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      changedRegion.SetSize( i, changedMax[i] - changedMin[i] + 1 );
+      }
+
+    itk::ImageRegionConstIteratorWithIndex< LabelMapType > itChanged(
+      m_LabelMap, changedRegion );
+    while( !itChanged.IsAtEnd() && inRange )
+      {
+      const SizeValueType featureOffset =
+        m_LabelMap->ComputeOffset( itChanged.GetIndex() );
+      if( featureOffset % step != 0
+        || labels[featureOffset] == previousLabels[featureOffset] )
         {
-        inClassHistogramIt.GoToBegin();
-        while( !inClassHistogramIt.IsAtEnd() )
+        ++itChanged;
+        continue;
+        }
+      const int val = labels[featureOffset];
+      const int prevVal = previousLabels[featureOffset];
+      int valClass = -1;
+      int prevValClass = -1;
+      for( unsigned int c = 0; c < numClasses; c++ )
+        {
+        if( val == m_ObjectIdList[c] )
+          {
+          valClass = c;
+          }
+        if( prevVal == m_ObjectIdList[c] )
+          {
+          prevValClass = c;
+          }
+        }
+      if( valClass != prevValClass )
+        {
+        for( unsigned int i = 0; i < N; i++ )
           {
-          double tf = inClassHistogramIt.Get() / inPTotal;
-          if( tf < 0 )
+          v[i] = featureBuffer[i][ featureOffset * featureStride ];
+          }
+        if( !this->IsSampleInBinRange( v ) )
+          {
+          inRange = false;
+          break;
+          }
+        const typename SampleHistogramImageType::IndexType binIndex =
+          this->GetSampleBin( v );
+        if( prevValClass >= 0 )
+          {
+          SampleHistogramPixelType & count =
+            m_InClassSampleHistogram[prevValClass]->GetPixel( binIndex );
+          if( count >= 1 )
             {
-            tf = 0;
+            --count;
             }
-          inClassHistogramIt.Set( tf );
-          ++inClassHistogramIt;
+          classChanged[prevValClass] = true;
+          }
+        if( valClass >= 0 )
+          {
+          ++( m_InClassSampleHistogram[valClass]->GetPixel( binIndex ) );
+          classChanged[valClass] = true;
           }
         }
+      ++itChanged;
+      }
+    }
+
+  timeCollector.Stop( "LabelMapChanges" );
+
+  if( !inRange )
+    {
+    // The sample histograms do not cover the features of the current
+    //   samples, so the PDFs are trained from scratch
+    itkDebugMacro( << "Samples lie outside of the histogram bins of the "
+      << "previous training; retraining all classes." );
+    timeCollector.Report();
+    this->Update();
+    m_RetrainedAllClasses = true;
+    m_ImagesUpToDate = false;
+    return;
+    }
+
+  m_SampleUpToDate = true;
+
+  timeCollector.Start( "HistogramToPDF" );
+  for( unsigned int c = 0; c < numClasses; c++ )
+    {
+    if( classChanged[c] || c >= m_InClassHistogram.size()
+      || m_InClassHistogram[c].IsNull() )
+      {
+      this->GeneratePDF( c );
       }
     }
   timeCollector.Stop( "HistogramToPDF" );
 
+  m_PDFsUpToDate = true;
+  m_ImagesUpToDate = false;
+
+  this->GenerateLabeledFeatureSpace();
+
   timeCollector.Report();
 }
 
@@ -807,8 +1171,9 @@ PDFSegmenter< TImage, N, TLabelMap >
     {
     m_ProbabilityImageVector[c] = ProbabilityImageType::New();
     m_ProbabilityImageVector[c]->SetRegions(
-      m_InputImageList[0]->GetLargestPossibleRegion() );
-    m_ProbabilityImageVector[c]->CopyInformation( m_InputImageList[0] );
+      this->GetFeatureGeometry()->GetLargestPossibleRegion() );
+    m_ProbabilityImageVector[c]->CopyInformation(
+      this->GetFeatureGeometry() );
     m_ProbabilityImageVector[c]->Allocate();
 
     itk::ImageRegionIterator<ProbabilityImageType> probIt(
@@ -816,15 +1181,10 @@ PDFSegmenter< TImage, N, TLabelMap >
       m_ProbabilityImageVector[c]->GetLargestPossibleRegion() );
     probIt.GoToBegin();
 
-    typedef itk::ImageRegionConstIteratorWithIndex< ImageType >
-      ConstImageIteratorType;
-    std::vector< ConstImageIteratorType * > itInIm(N);
-    for( unsigned int i = 0; i < N; i++ )
-      {
-      itInIm[i] = new ConstImageIteratorType( m_InputImageList[i],
-        m_InputImageList[i]->GetLargestPossibleRegion() );
-      itInIm[i]->GoToBegin();
-      }
+    std::vector< const PixelType * > featureBuffer;
+    SizeValueType featureStride;
+    this->GetFeatureBuffers( featureBuffer, featureStride );
+    SizeValueType featureOffset = 0;
 
     typename HistogramImageType::IndexType binIndex;
     while( !probIt.IsAtEnd() )
@@ -832,7 +1192,7 @@ PDFSegmenter< TImage, N, TLabelMap >
       bool valid = true;
       for( unsigned int i = 0; i < N; i++ )
         {
-        double binV = itInIm[i]->Get();
+        double binV = featureBuffer[i][ featureOffset * featureStride ];
         binV = ( int )( ( binV - m_HistogramBinMin[i] )
           / m_HistogramBinSize[i] + 0.5 );
         if( binV<0 || binV>m_HistogramNumberOfBin[i]-1 )
@@ -852,17 +1212,9 @@ PDFSegmenter< TImage, N, TLabelMap >
           }
         }
       probIt.Set( prob );
-      for( unsigned int i = 0; i < N; i++ )
-        {
-        ++( *( itInIm[i] ) );
-        }
+      ++featureOffset;
       ++probIt;
       }
-
-    for( unsigned int i = 0; i < N; i++ )
-      {
-      delete itInIm[i];
-      }
     }
   timeCollector.Stop( "ProbabilityImage" );
 
@@ -890,9 +1242,9 @@ PDFSegmenter< TImage, N, TLabelMap >
   typename LabelMapType::IndexType labelImageIndex;
 
   typename LabelMapType::Pointer tmpLabelImage = LabelMapType::New();
-  tmpLabelImage->SetRegions( m_InputImageList[0]
+  tmpLabelImage->SetRegions( this->GetFeatureGeometry()
     ->GetLargestPossibleRegion() );
-  tmpLabelImage->CopyInformation( m_InputImageList[0] );
+  tmpLabelImage->CopyInformation( this->GetFeatureGeometry() );
   tmpLabelImage->Allocate();
 
   if( m_LabelMap.IsNull() )
@@ -1371,6 +1723,16 @@ PDFSegmenter< TImage, N, TLabelMap >
   os << indent << "Input volume list size = " << m_InputImageList.size()
     << std::endl;
 
+  if( m_FeatureVectorImage.IsNotNull() )
+    {
+    os << indent << "FeatureVectorImage = " << m_FeatureVectorImage
+      << std::endl;
+    }
+  else
+    {
+    os << indent << "FeatureVectorImage = NULL" << std::endl;
+    }
+
   if( m_LabelMap.IsNotNull() )
     {
     os << indent << "LabelMap = " << m_LabelMap << std::endl;
@@ -1395,6 +1757,8 @@ PDFSegmenter< TImage, N, TLabelMap >
     << std::endl;
   os << indent << "ReclassifyNotObjectLabels = "
     << m_ReclassifyNotObjectLabels << std::endl;
+  os << indent << "RetrainedAllClasses = " << m_RetrainedAllClasses
+    << std::endl;
   os << indent << "Number of probability images = "
     << m_ProbabilityImageVector.size() << std::endl;
   os << indent << "InClassList size = "
@@ -1407,6 +1771,8 @@ PDFSegmenter< TImage, N, TLabelMap >
     {
     os << indent << "OutClassList = NULL" << std::endl;
     }
+  os << indent << "InClassSampleHistogram size = "
+    << m_InClassSampleHistogram.size() << std::endl;
   os << indent << "InClassHistogram size = "
     << m_InClassHistogram.size() << std::endl;
   os << indent << "HistogramBinMin = " << m_HistogramBinMin[0]
@@ -355,14 +355,11 @@ RidgeSeedFilter< TImage, TLabelMap >
 
     m_SeedFeatureGenerator->GenerateBasis();
 
-    m_PDFSegmenter->SetInput( 0,
-      m_SeedFeatureGenerator->GetFeatureImage( 0 ) );
-    m_PDFSegmenter->SetInput( 1,
-      m_SeedFeatureGenerator->GetFeatureImage( 1 ) );
-    m_PDFSegmenter->SetInput( 2,
-      m_SeedFeatureGenerator->GetFeatureImage( 2 ) );
-    m_PDFSegmenter->SetInput( 3,
-      m_SeedFeatureGenerator->GetFeatureImage( 3 ) );
+    // One pass projects the training voxels onto only the basis vectors
+    //   the classifier uses
+    m_PDFSegmenter->SetFeatureVectorImage(
+      m_SeedFeatureGenerator->GetFeatureVectorImage(
+        m_PDFSegmenter->GetNumberOfFeatures() ) );
 
     m_PDFSegmenter->Update();
     }
@@ -373,18 +370,15 @@ void
 RidgeSeedFilter< TImage, TLabelMap >
 ::ClassifyImages( void )
 {
+  // Project every voxel onto the basis once, instead of once per basis
+  //   image, and onto only the basis vectors the classifier uses
   typename LabelMapType::Pointer tmpLabelMap =
     m_SeedFeatureGenerator->GetLabelMap();
   m_SeedFeatureGenerator->SetLabelMap( NULL );
 
-  m_PDFSegmenter->SetInput( 0,
-    m_SeedFeatureGenerator->GetFeatureImage( 0 ) );
-  m_PDFSegmenter->SetInput( 1,
-    m_SeedFeatureGenerator->GetFeatureImage( 1 ) );
-  m_PDFSegmenter->SetInput( 2,
-    m_SeedFeatureGenerator->GetFeatureImage( 2 ) );
-  m_PDFSegmenter->SetInput( 3,
-    m_SeedFeatureGenerator->GetFeatureImage( 3 ) );
+  m_PDFSegmenter->SetFeatureVectorImage(
+    m_SeedFeatureGenerator->GetFeatureVectorImage(
+      m_PDFSegmenter->GetNumberOfFeatures() ) );
 
   m_PDFSegmenter->ClassifyImages();
 
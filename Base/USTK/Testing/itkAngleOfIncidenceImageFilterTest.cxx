@@ -21,6 +21,8 @@
 
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkStreamingImageFilter.h>
 #include <itkThresholdImageFilter.h>
 
 int itkAngleOfIncidenceImageFilterTest( int argc, char * argv[] )
@@ -128,6 +130,38 @@ int itkAngleOfIncidenceImageFilterTest( int argc, char * argv[] )
   angleOfIncidenceWriter->SetInput(filterAngleOfIncidence->GetOutput());
   angleOfIncidenceWriter->Update();
 
+  // Streaming the filter must not change the angles
+  AngleOfIncidenceImageFilterType::Pointer streamedAngleOfIncidence =
+    AngleOfIncidenceImageFilterType::New();
+  streamedAngleOfIncidence->SetUltrasoundProbeOrigin(
+    UltrasoundProbeOriginVector );
+  streamedAngleOfIncidence->SetInput( thresholdFilter->GetOutput() );
+
+  typedef itk::StreamingImageFilter< AngleOfIncidencesImageType,
+    AngleOfIncidencesImageType > StreamingFilterType;
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput( streamedAngleOfIncidence->GetOutput() );
+  streamer->SetNumberOfStreamDivisions( 5 );
+  streamer->Update();
+
+  typedef itk::ImageRegionConstIterator< AngleOfIncidencesImageType >
+    AngleIteratorType;
+  AngleIteratorType angleIt( filterAngleOfIncidence->GetOutput(),
+    filterAngleOfIncidence->GetOutput()->GetLargestPossibleRegion() );
+  AngleIteratorType streamedIt( streamer->GetOutput(),
+    streamer->GetOutput()->GetLargestPossibleRegion() );
+  while( !angleIt.IsAtEnd() )
+    {
+    if( vnl_math_abs( angleIt.Get() - streamedIt.Get() ) > 1e-6 )
+      {
+      std::cerr << "Streamed angle differs at " << angleIt.GetIndex()
+        << ": " << streamedIt.Get() << " != " << angleIt.Get()
+        << std::endl;
+      return EXIT_FAILURE;
+      }
+    ++angleIt;
+    ++streamedIt;
+    }
 
   return EXIT_SUCCESS;
 }
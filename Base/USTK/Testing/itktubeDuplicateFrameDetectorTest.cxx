@@ -0,0 +1,170 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "itktubeDuplicateFrameDetector.h"
+
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkTestingMacros.h>
+
+#include <algorithm>
+#include <vector>
+
+int itktubeDuplicateFrameDetectorTest( int itkNotUsed( argc ),
+  char * itkNotUsed( argv )[] )
+{
+  typedef unsigned char PixelType;
+  typedef itk::tube::DuplicateFrameDetector< PixelType > DetectorType;
+
+  const itk::SizeValueType width = 37;
+  const itk::SizeValueType height = 23;
+  const itk::SizeValueType numberOfPixels = width * height;
+  const PixelType tolerance = 3;
+  const double fractionalThreshold = 0.7;
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator
+    RandomType;
+  RandomType::Pointer random = RandomType::New();
+  random->Initialize( 1234 );
+
+  // Build a sequence with exact duplicates, noisy duplicates, partially
+  // refreshed frames, and new frames.
+  typedef std::vector< PixelType > FrameType;
+  std::vector< FrameType > frames;
+  FrameType frame( numberOfPixels );
+  for( itk::SizeValueType ii = 0; ii < numberOfPixels; ++ii )
+    {
+    frame[ii] = static_cast< PixelType >( random->GetIntegerVariate( 255 ) );
+    }
+  for( unsigned int ff = 0; ff < 40; ++ff )
+    {
+    frames.push_back( frame );
+    switch( ff % 5 )
+      {
+      case 0:
+        // Exact duplicate
+        break;
+      case 1:
+        // Analog noise within the tolerance on most pixels
+        for( itk::SizeValueType ii = 0; ii < numberOfPixels; ++ii )
+          {
+          const int noise = static_cast< int >(
+            random->GetIntegerVariate( 8 ) ) - 4;
+          const int value = frame[ii] + noise;
+          frame[ii] = static_cast< PixelType >( value < 0 ? 0 :
+            ( value > 255 ? 255 : value ) );
+          }
+        break;
+      case 2:
+        // Incomplete refresh of a varying number of lines
+        {
+        const itk::SizeValueType lines = ( ff * 7 ) % height;
+        for( itk::SizeValueType ii = 0; ii < lines * width; ++ii )
+          {
+          frame[ii] = static_cast< PixelType >(
+            random->GetIntegerVariate( 255 ) );
+          }
+        }
+        break;
+      default:
+        // New frame
+        for( itk::SizeValueType ii = 0; ii < numberOfPixels; ++ii )
+          {
+          frame[ii] = static_cast< PixelType >(
+            random->GetIntegerVariate( 255 ) );
+          }
+      }
+    }
+
+  // Brute force reference
+  DetectorType::FrameListType expectedInvalidFrames;
+  for( itk::SizeValueType ff = 0; ff + 1 < frames.size(); ++ff )
+    {
+    itk::SizeValueType sameCount = 0;
+    for( itk::SizeValueType ii = 0; ii < numberOfPixels; ++ii )
+      {
+      const float absDifference = vcl_abs(
+        static_cast< float >( frames[ff][ii] )
+        - static_cast< float >( frames[ff + 1][ii] ) );
+      if( absDifference <= tolerance )
+        {
+        ++sameCount;
+        }
+      }
+    if( sameCount / static_cast< float >( numberOfPixels )
+      > fractionalThreshold )
+      {
+      expectedInvalidFrames.push_back( ff );
+      }
+    }
+
+  DetectorType::Pointer detector = DetectorType::New();
+  detector->SetTolerance( tolerance );
+  TEST_EXPECT_EQUAL( detector->GetTolerance(), tolerance );
+  detector->SetFractionalThreshold( fractionalThreshold );
+  TEST_EXPECT_EQUAL( detector->GetFractionalThreshold(),
+    fractionalThreshold );
+
+  const unsigned int blockSizes[] = { 1, 4, 8, 64 };
+  for( unsigned int bb = 0; bb < 4; ++bb )
+    {
+    detector->SetBlockSize( blockSizes[bb] );
+    detector->SetFrameSize( width, height );
+    for( itk::SizeValueType ff = 0; ff < frames.size(); ++ff )
+      {
+      const bool previousIsDuplicate =
+        detector->AddFrame( &( frames[ff][0] ) );
+      const bool expected = ff > 0 && std::find(
+        expectedInvalidFrames.begin(), expectedInvalidFrames.end(),
+        ff - 1 ) != expectedInvalidFrames.end();
+      if( previousIsDuplicate != expected )
+        {
+        std::cerr << "Block size " << blockSizes[bb] << ", frame " << ff - 1
+                  << ": expected " << expected << ", got "
+                  << previousIsDuplicate << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    TEST_EXPECT_EQUAL( detector->GetNumberOfFrames(), frames.size() );
+    TEST_EXPECT_TRUE( detector->GetInvalidFrames() == expectedInvalidFrames );
+    TEST_EXPECT_TRUE( detector->GetNumberOfFullComparisons()
+      < frames.size() - 1 );
+    std::cout << "Block size " << blockSizes[bb] << ": "
+              << detector->GetNumberOfFullComparisons()
+              << " full comparisons" << std::endl;
+    }
+
+  itk::MetaDataDictionary dictionary;
+  for( DetectorType::FrameListType::const_iterator it =
+    expectedInvalidFrames.begin(); it != expectedInvalidFrames.end(); ++it )
+    {
+    DetectorType::MarkFrameInvalid( dictionary, *it );
+    }
+  TEST_EXPECT_EQUAL( dictionary.GetKeys().size(),
+    expectedInvalidFrames.size() );
+  TEST_EXPECT_TRUE( dictionary.HasKey(
+    "Seq_Frame0000_ProbeToTrackerTransformStatus" ) );
+
+  std::cout << detector << std::endl;
+
+  return EXIT_SUCCESS;
+}
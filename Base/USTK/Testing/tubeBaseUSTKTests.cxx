@@ -35,6 +35,7 @@ void RegisterTests( void )
   REGISTER_TEST( itkUltrasoundProbeGeometryCalculatorTest );
   REGISTER_TEST( itkUltrasoundProbeGeometryCalculatorTest2 );
   REGISTER_TEST( SyncRecordTest );
+  REGISTER_TEST( itktubeDuplicateFrameDetectorTest );
   REGISTER_TEST( itktubeInnerOpticToPlusImageReaderTest );
   REGISTER_TEST( itktubeMarkDuplicateFramesInvalidImageFilterTest );
 }
@@ -59,6 +59,11 @@ namespace itk
  * It is possible to specify the filter used to calculate the gradient
  * magnitude with \c SetGradientMagnitudeFilter.
  *
+ * Only the output requested region of the angle of incidence image and
+ * of the gradient magnitude is computed, so the filter can be streamed
+ * together with a region-aware angle of incidence filter such as
+ * AngleOfIncidenceImageFilter.
+ *
  * \ingroup ImageToImageFilter
  */
 template< class TInputImage, class TOutputImage, class TOperatorValue = float >
@@ -108,6 +113,9 @@ protected:
 
   virtual void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Pad the impedance requested region for the gradient operator. */
+  virtual void GenerateInputRequestedRegion( void );
+
   virtual void BeforeThreadedGenerateData( void );
   virtual void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
     ThreadIdType threadId );
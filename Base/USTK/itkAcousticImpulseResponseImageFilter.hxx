@@ -46,6 +46,29 @@ AcousticImpulseResponseImageFilter< TInputImage, TOutputImage, TOperatorValue >
 }
 
 
+template< class TInputImage, class TOutputImage, class TOperatorValue >
+void
+AcousticImpulseResponseImageFilter< TInputImage, TOutputImage, TOperatorValue >
+::GenerateInputRequestedRegion( void )
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >(
+    this->GetInput( 0 ) );
+  if( !input )
+    {
+    return;
+    }
+
+  // A first-order gradient operator needs one extra voxel on each side
+  typename InputImageType::RegionType requestedRegion =
+    this->GetOutput()->GetRequestedRegion();
+  requestedRegion.PadByRadius( 1 );
+  requestedRegion.Crop( input->GetLargestPossibleRegion() );
+  input->SetRequestedRegion( requestedRegion );
+}
+
+
 template< class TInputImage, class TOutputImage, class TOperatorValue >
 void
 AcousticImpulseResponseImageFilter< TInputImage, TOutputImage, TOperatorValue >
@@ -54,7 +77,9 @@ AcousticImpulseResponseImageFilter< TInputImage, TOutputImage, TOperatorValue >
   this->m_CastImageFilter->SetInput( this->GetInput() );
   this->m_GradientMagnitudeFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
   this->m_GradientMagnitudeFilter->SetInput( this->m_CastImageFilter->GetOutput() );
-  this->m_GradientMagnitudeFilter->Update();
+  this->m_GradientMagnitudeFilter->GetOutput()->SetRequestedRegion(
+    this->GetOutput()->GetRequestedRegion() );
+  this->m_GradientMagnitudeFilter->GetOutput()->Update();
 }
 
 
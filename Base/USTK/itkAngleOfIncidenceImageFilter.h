@@ -24,13 +24,10 @@ limitations under the License.
 #ifndef __itkAngleOfIncidenceImageFilter_h
 #define __itkAngleOfIncidenceImageFilter_h
 
-#include "itktubeSymmetricEigenVectorAnalysisImageFilter.h"
-
-#include <itkHessianRecursiveGaussianImageFilter.h>
-#include <itkImageRegionIteratorWithIndex.h>
 #include <itkImageToImageFilter.h>
-#include <itkSymmetricEigenAnalysisImageFilter.h>
-#include <itkVectorImage.h>
+#include <itkVector.h>
+
+#include <vector>
 
 namespace itk
 {
@@ -40,6 +37,19 @@ namespace itk
  * The angle of incidence is defined as the angle between the beam
  * direction at a organ boundary and the normal to the boundary.
  *
+ * The boundary normal at each voxel is the eigenvector of the local
+ * Hessian whose eigenvalue has the largest magnitude.  The Hessian is
+ * computed at scale Sigma (in physical units) by convolving the
+ * neighborhood of the voxel with sampled Gaussian derivative kernels, so
+ * the Hessian, its eigen-decomposition and the angle are computed per
+ * voxel in one threaded pass and only the output image is allocated.  The
+ * input requested region is the output requested region padded by the
+ * kernel radius, so the filter streams.
+ *
+ * The output is the absolute cosine of the angle; voxels with a
+ * negligible Hessian are set to zero.  The ultrasound probe origin is
+ * given in index coordinates.
+ *
  * \ingroup ImageToImageFilter
  */
 template< class TInputImage, class TOutputImage >
@@ -67,6 +77,7 @@ public:
   typedef typename InputImageType::ConstPointer InputImagePointer;
   typedef typename InputImageType::RegionType   InputImageRegionType;
   typedef typename InputImageType::PixelType    InputImagePixelType;
+  typedef typename InputImageType::SizeType     InputImageSizeType;
 
 
   /** typedef for the origin type */
@@ -78,65 +89,48 @@ public:
   typedef typename OutputImageType::RegionType OutputImageRegionType;
   typedef typename OutputImageType::PixelType  OutputImagePixelType;
 
-  /** typedef to generate surface normal vector using eigen analysis */
-  typedef typename itk::HessianRecursiveGaussianImageFilter< InputImageType >
-    HessianFilterType;
-
-  typedef SymmetricSecondRankTensor< double, ImageDimension >
-    SymmetricSecondRankTensorType;
-  typedef Image< SymmetricSecondRankTensorType, ImageDimension >
-    SymmetricSecondRankTensorImageType;
-  typedef Matrix< double, ImageDimension, ImageDimension >
-    EigenVectorMatrixType;
-  typedef Image< EigenVectorMatrixType, ImageDimension >
-    EigenVectorMatrixImageType;
-  typedef FixedArray< double, ImageDimension >
-    EigenValueArrayType;
-  typedef Image< EigenValueArrayType, ImageDimension >
-    EigenValueImageType;
-
-  typedef itk::VectorImage< double, ImageDimension >    EigenVectorImageType;
-
-  typedef itk::SymmetricEigenAnalysisImageFilter
-    <SymmetricSecondRankTensorImageType, EigenValueImageType>
-    EigenValueAnalysisFilterType;
-
-  typedef itk::tube::SymmetricEigenVectorAnalysisImageFilter
-        <SymmetricSecondRankTensorImageType, EigenValueImageType,
-         EigenVectorMatrixImageType>
-    EigenVectorAnalysisFilterType;
-
   /** Set/Get Ultrasound origin vector */
   itkSetMacro( UltrasoundProbeOrigin, VectorType );
   itkGetConstMacro( UltrasoundProbeOrigin, VectorType );
 
+  /** Set/Get the scale of the Hessian, in physical units */
+  itkSetMacro( Sigma, double );
+  itkGetConstMacro( Sigma, double );
+
 protected:
   AngleOfIncidenceImageFilter( void );
   virtual ~AngleOfIncidenceImageFilter( void ) {}
   void PrintSelf(std::ostream & os, Indent indent) const;
 
-  /* Generate Data */
-  void GenerateData( void );
+  /** Pad the input requested region by the Hessian kernel radius */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** Sample the Hessian kernels for the input spacing */
+  virtual void BeforeThreadedGenerateData( void );
+
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId );
 
-  void ComputeNormalVectorImage( void );
 private:
   AngleOfIncidenceImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);          //purposely not implemented
 
+  InputImageSizeType ComputeKernelRadius( void ) const;
+
   /* Ultrasound origin*/
   VectorType m_UltrasoundProbeOrigin;
 
-  /* Hessian analysis filter */
-  typename HessianFilterType::Pointer m_HessianFilter;
-
-  /* eigenvalue analysis filter */
-  typename EigenValueAnalysisFilterType::Pointer m_EigenValueAnalysisFilter;
+  /* Hessian scale */
+  double m_Sigma;
 
-  /* eigenvector analysis filter */
-  typename EigenVectorAnalysisFilterType::Pointer m_EigenVectorAnalysisFilter;
+  /* Neighborhood radius of the Hessian kernels */
+  InputImageSizeType m_KernelRadius;
 
-  // Primary eigenvector image
-  typename EigenVectorImageType::Pointer m_PrimaryEigenVectorImage;
+  /* Hessian kernel weights, interleaved by neighborhood offset: the
+   * weight of upper-triangular component c at offset k is stored at
+   * k * NumberOfComponents + c */
+  std::vector< double > m_HessianKernels;
 
 }; // End class AngleOfIncidenceImageFilter
 
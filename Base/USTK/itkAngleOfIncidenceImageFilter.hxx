@@ -26,10 +26,11 @@ limitations under the License.
 
 #include "itkAngleOfIncidenceImageFilter.h"
 
-#include <itkImageRegionConstIterator.h>
-#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkConstNeighborhoodIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkNeighborhoodAlgorithm.h>
 #include <itkProgressReporter.h>
-#include <itkResampleImageFilter.h>
+#include <itkSymmetricEigenAnalysis.h>
 
 namespace itk
 {
@@ -41,243 +42,249 @@ AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
 ::AngleOfIncidenceImageFilter( void )
 {
   m_UltrasoundProbeOrigin.Fill(0);
+  m_Sigma = 0.5;
+  m_KernelRadius.Fill(1);
+}
 
-  //eigenvector analysis filter
-  m_EigenVectorAnalysisFilter = EigenVectorAnalysisFilterType::New();
-  m_EigenVectorAnalysisFilter->SetDimension( ImageDimension );
-  m_EigenVectorAnalysisFilter->OrderEigenValuesBy(
-      EigenVectorAnalysisFilterType::FunctorType::OrderByValue );
-
-  //eigenvalue analysis filter
-  m_EigenValueAnalysisFilter = EigenValueAnalysisFilterType::New();
-  m_EigenValueAnalysisFilter->SetDimension( ImageDimension );
-  m_EigenValueAnalysisFilter->OrderEigenValuesBy(
-        EigenValueAnalysisFilterType::FunctorType::OrderByValue );
-
-  //Hessian filter
-  m_HessianFilter = HessianFilterType::New();
-
-  //eigenvector image
-  m_PrimaryEigenVectorImage = EigenVectorImageType::New();
-  unsigned int vectorLength = 3; // Eigenvector length
-  m_PrimaryEigenVectorImage->SetVectorLength ( vectorLength );
+template< class TInputImage, class TOutputImage >
+typename AngleOfIncidenceImageFilter< TInputImage,
+  TOutputImage >::InputImageSizeType
+AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
+::ComputeKernelRadius( void ) const
+{
+  const typename InputImageType::SpacingType spacing =
+    this->GetInput()->GetSpacing();
 
+  InputImageSizeType radius;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    radius[d] = static_cast< SizeValueType >(
+      vcl_ceil( 3.0 * m_Sigma / spacing[d] ) );
+    if( radius[d] < 1 )
+      {
+      radius[d] = 1;
+      }
+    }
+  return radius;
 }
 
 template< class TInputImage, class TOutputImage >
 void
 AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
-::GenerateData( void )
+::GenerateInputRequestedRegion( void )
 {
-  typedef typename TInputImage::SizeType          InputImageSizeType;
-  typedef typename TInputImage::PointType         InputImagePointType;
-  typedef typename TInputImage::SpacingType       InputImageSpacingType;
-  typedef ImageRegionConstIterator< TInputImage > InputImageConstIteratorType;
-
-  typedef typename TOutputImage::IndexType    ImageIndexType;
-  typedef typename TOutputImage::PixelType    PixelType;
-  typedef ImageRegionIterator< TOutputImage > OutputImageIteratorType;
-
-
-  typename TInputImage::ConstPointer inputImagePtr(
-    dynamic_cast< const TInputImage  * >(
-      this->ProcessObject::GetInput(0) ) );
-  typename TOutputImage::Pointer outputImagePtr(
-    dynamic_cast< TOutputImage * >(
-      this->ProcessObject::GetOutput(0) ) );
-
-  Point< double> originInput;
-  originInput.Fill(0.0);
-  outputImagePtr->SetOrigin(originInput);
-  outputImagePtr->SetSpacing( inputImagePtr->GetSpacing() );
-  outputImagePtr->SetDirection( inputImagePtr->GetDirection() );
-
-  outputImagePtr->SetRequestedRegion( inputImagePtr->GetRequestedRegion() );
-  outputImagePtr->SetBufferedRegion( inputImagePtr->GetBufferedRegion() );
-  outputImagePtr->SetLargestPossibleRegion( inputImagePtr->GetLargestPossibleRegion() );
-  outputImagePtr->Allocate();
-  outputImagePtr->FillBuffer(0);
+  Superclass::GenerateInputRequestedRegion();
 
-  InputImageConstIteratorType inputIt( inputImagePtr,
-    inputImagePtr->GetLargestPossibleRegion() );
-  OutputImageIteratorType     outputIt( outputImagePtr,
-    outputImagePtr->GetLargestPossibleRegion() );
-
-  outputIt.GoToBegin();
-  inputIt.GoToBegin();
-
-  //Compute the Normal Vector Image
-  this->ComputeNormalVectorImage();
-
-  //Iterator for the primary eigenvector image with the largest eigenvector
-  itk::ImageRegionIterator<EigenVectorImageType> primaryEigenVectorImageIterator;
-  primaryEigenVectorImageIterator = itk::ImageRegionIterator<EigenVectorImageType>(
-      m_PrimaryEigenVectorImage, m_PrimaryEigenVectorImage->GetRequestedRegion());
-  primaryEigenVectorImageIterator.GoToBegin();
-
-
-  InputImageSpacingType inputImageSpacing;
-  InputImagePointType   inputImageOrigin;
-
-  while( !inputIt.IsAtEnd() )
+  InputImageType * input = const_cast< InputImageType * >(
+    this->GetInput() );
+  if( !input )
     {
-    //Compute the angle and set it to output iterator.
-
-    itk::VariableLengthVector<double> vectorPixel;
-    vectorPixel.SetSize(3);
-    vectorPixel[0] = primaryEigenVectorImageIterator.Get()[0];
-    vectorPixel[1] = primaryEigenVectorImageIterator.Get()[1];
-    vectorPixel[2] = primaryEigenVectorImageIterator.Get()[2];
-
-    itk::Vector<double,3>  primaryEigenVector;
-
-    primaryEigenVector[0] = vectorPixel[0];
-    primaryEigenVector[1] = vectorPixel[1];
-    primaryEigenVector[2] = vectorPixel[2];
+    return;
+    }
 
-    //Vector from the probe origin to the surface voxel
-    itk::Vector<double, 3>    beamVector;
+  InputImageRegionType requestedRegion =
+    this->GetOutput()->GetRequestedRegion();
+  requestedRegion.PadByRadius( this->ComputeKernelRadius() );
+  requestedRegion.Crop( input->GetLargestPossibleRegion() );
+  input->SetRequestedRegion( requestedRegion );
+}
 
-    beamVector[0] = inputIt.GetIndex()[0] - m_UltrasoundProbeOrigin[0];
-    beamVector[1] = inputIt.GetIndex()[1] - m_UltrasoundProbeOrigin[1];
-    beamVector[2] = inputIt.GetIndex()[2] - m_UltrasoundProbeOrigin[2];
+template< class TInputImage, class TOutputImage >
+void
+AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  const typename InputImageType::SpacingType spacing =
+    this->GetInput()->GetSpacing();
+  m_KernelRadius = this->ComputeKernelRadius();
+
+  // Sampled Gaussian and its first and second derivatives along each
+  // dimension, in physical units
+  std::vector< std::vector< double > > gaussian( ImageDimension );
+  std::vector< std::vector< double > > firstDerivative( ImageDimension );
+  std::vector< std::vector< double > > secondDerivative( ImageDimension );
+  const double variance = m_Sigma * m_Sigma;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const int radius = static_cast< int >( m_KernelRadius[d] );
+    double gaussianSum = 0;
+    for( int o = -radius; o <= radius; o++ )
+      {
+      const double x = o * spacing[d];
+      const double g = vcl_exp( -0.5 * x * x / variance );
+      gaussian[d].push_back( g );
+      gaussianSum += g;
+      }
+    double secondSum = 0;
+    for( int o = -radius; o <= radius; o++ )
+      {
+      const double x = o * spacing[d];
+      double & g = gaussian[d][o + radius];
+      g /= gaussianSum;
+      firstDerivative[d].push_back( -x / variance * g );
+      secondDerivative[d].push_back( ( x * x / variance - 1 ) / variance
+        * g );
+      secondSum += secondDerivative[d].back();
+      }
+    // The second derivative of a constant image is zero
+    for( int o = -radius; o <= radius; o++ )
+      {
+      secondDerivative[d][o + radius] -= secondSum * gaussian[d][o + radius];
+      }
+    }
 
-    /*
-    std::cout << "Beam vector for("  << inputIt.GetIndex()[0]  << ","
-                                     << inputIt.GetIndex()[1]  << ","
-                                     << inputIt.GetIndex()[2]  << "):=("
-                                     << beamVector[0]        << ","
-                                     << beamVector[1]        << ","
-                                     << beamVector[2]        << ")" << std::endl;
-    */
+  // Separable products for each upper-triangular Hessian component
+  const unsigned int numberOfComponents =
+    ImageDimension * ( ImageDimension + 1 ) / 2;
 
-    //Normalize the vectors
-    const double zeroNormVectorTolerance = 1e-8;
+  Neighborhood< double, ImageDimension > neighborhood;
+  neighborhood.SetRadius( m_KernelRadius );
+  const unsigned int neighborhoodSize = neighborhood.Size();
 
-    if( (beamVector.GetNorm() > zeroNormVectorTolerance) &&
-         (primaryEigenVector.GetNorm() > zeroNormVectorTolerance) )
+  m_HessianKernels.assign( neighborhoodSize * numberOfComponents, 0 );
+  for( unsigned int k = 0; k < neighborhoodSize; k++ )
+    {
+    const typename Neighborhood< double, ImageDimension >::OffsetType
+      offset = neighborhood.GetOffset( k );
+    unsigned int c = 0;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
       {
-      beamVector.Normalize();
-      primaryEigenVector.Normalize();
-
-      //compute dot product
-      double dotProduct = beamVector*primaryEigenVector;
-
-      outputIt.Set( vnl_math_abs(dotProduct) );
+      for( unsigned int j = i; j < ImageDimension; j++, c++ )
+        {
+        double weight = 1;
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          const unsigned int o = offset[d] + m_KernelRadius[d];
+          if( d == i && d == j )
+            {
+            weight *= secondDerivative[d][o];
+            }
+          else if( d == i || d == j )
+            {
+            weight *= firstDerivative[d][o];
+            }
+          else
+            {
+            weight *= gaussian[d][o];
+            }
+          }
+        m_HessianKernels[k * numberOfComponents + c] = weight;
+        }
       }
-
-    ++inputIt;
-    ++outputIt;
-    ++primaryEigenVectorImageIterator;
     }
 }
 
 template< class TInputImage, class TOutputImage >
 void
 AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
-::ComputeNormalVectorImage( void )
+::ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
 {
-  m_HessianFilter->SetInput( this->GetInput() );
-
-  double sigma = 0.5;
-  m_HessianFilter->SetSigma ( sigma );
-  m_HessianFilter->Update();
-
-  m_EigenValueAnalysisFilter->SetInput( m_HessianFilter->GetOutput() );
-  m_EigenValueAnalysisFilter->Update();
-
-  m_EigenVectorAnalysisFilter->SetInput( m_HessianFilter->GetOutput() );
-  m_EigenVectorAnalysisFilter->Update();
-
-  //Generate an image with eigenvector pixel that correspond to the largest eigenvalue
-  typename EigenVectorMatrixImageType::ConstPointer eigenVectorImage =
-                    m_EigenVectorAnalysisFilter->GetOutput();
-
-  typename EigenVectorMatrixImageType::RegionType region;
-  region.SetSize(eigenVectorImage->GetLargestPossibleRegion().GetSize());
-  region.SetIndex(eigenVectorImage->GetLargestPossibleRegion().GetIndex());
-  m_PrimaryEigenVectorImage->SetRegions( region );
-  m_PrimaryEigenVectorImage->SetOrigin(eigenVectorImage->GetOrigin());
-  m_PrimaryEigenVectorImage->SetSpacing(eigenVectorImage->GetSpacing());
-  m_PrimaryEigenVectorImage->Allocate();
-
-  //Fill up the buffer with null vector
-  unsigned int vectorLength = 3;
-  itk::VariableLengthVector< double > nullVector( vectorLength );
-  for( unsigned int i=0; i < vectorLength; i++ )
-    {
-    nullVector[i] = 0.0;
-    }
-  m_PrimaryEigenVectorImage->FillBuffer( nullVector );
-
-  //Setup the iterators
-  //
-  //Iterator for the eigenvector matrix image
-  itk::ImageRegionConstIterator<EigenVectorMatrixImageType> eigenVectorImageIterator;
-  eigenVectorImageIterator = itk::ImageRegionConstIterator<EigenVectorMatrixImageType>(
-      eigenVectorImage, eigenVectorImage->GetRequestedRegion());
-  eigenVectorImageIterator.GoToBegin();
-
-  //Iterator for the output image with the largest eigenvector
-  itk::ImageRegionIterator<EigenVectorImageType> primaryEigenVectorImageIterator;
-  primaryEigenVectorImageIterator = itk::ImageRegionIterator<EigenVectorImageType>(
-      m_PrimaryEigenVectorImage, m_PrimaryEigenVectorImage->GetRequestedRegion());
-  primaryEigenVectorImageIterator.GoToBegin();
-
-  //Iterator for the eigenvalue image
-  typename EigenValueImageType::ConstPointer eigenImage
-    = m_EigenValueAnalysisFilter->GetOutput();
-  itk::ImageRegionConstIterator<EigenValueImageType> eigenValueImageIterator;
-  eigenValueImageIterator = itk::ImageRegionConstIterator<EigenValueImageType>(
-      eigenImage, eigenImage->GetRequestedRegion());
-  eigenValueImageIterator.GoToBegin();
+  typedef Matrix< double, ImageDimension, ImageDimension > MatrixType;
+  typedef FixedArray< double, ImageDimension >             EigenValueArrayType;
+  typedef SymmetricEigenAnalysis< MatrixType, EigenValueArrayType,
+    MatrixType >                                           EigenAnalysisType;
+
+  typedef ConstNeighborhoodIterator< InputImageType > NeighborhoodIteratorType;
+  typedef NeighborhoodAlgorithm::ImageBoundaryFacesCalculator< InputImageType >
+    FacesCalculatorType;
 
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+
+  const unsigned int numberOfComponents =
+    ImageDimension * ( ImageDimension + 1 ) / 2;
+  std::vector< double > hessian( numberOfComponents );
+
+  EigenAnalysisType eigenAnalysis( ImageDimension );
+  eigenAnalysis.SetOrderEigenValues( true );
+
+  const double zeroNormVectorTolerance = 1e-8;
   const double toleranceEigenValues = 1e-4;
 
-  while(!eigenValueImageIterator.IsAtEnd())
-    {
-    // Get the eigenvalue
-    EigenValueArrayType eigenValue;
-    eigenValue = eigenValueImageIterator.Get();
+  ProgressReporter progress( this, threadId,
+    outputRegionForThread.GetNumberOfPixels() );
 
-    // Find the largest eigenvalue
-    double largest = vnl_math_abs( eigenValue[0] );
-    unsigned int largestEigenValueIndex=0;
+  FacesCalculatorType facesCalculator;
+  typename FacesCalculatorType::FaceListType faceList = facesCalculator(
+    input, outputRegionForThread, m_KernelRadius );
 
-    for( unsigned int i=1; i <=2; i++ )
+  typename FacesCalculatorType::FaceListType::iterator faceIt;
+  for( faceIt = faceList.begin(); faceIt != faceList.end(); ++faceIt )
+    {
+    NeighborhoodIteratorType inputIt( m_KernelRadius, input, *faceIt );
+    ImageRegionIterator< OutputImageType > outputIt( output, *faceIt );
+    const unsigned int neighborhoodSize = inputIt.Size();
+
+    for( inputIt.GoToBegin(), outputIt.GoToBegin(); !inputIt.IsAtEnd();
+         ++inputIt, ++outputIt )
       {
-      if(  vnl_math_abs( eigenValue[i] > largest ) )
+      std::fill( hessian.begin(), hessian.end(), 0.0 );
+      const double * kernel = &( m_HessianKernels[0] );
+      for( unsigned int k = 0; k < neighborhoodSize; k++ )
         {
-        largest = vnl_math_abs( eigenValue[i] );
-        largestEigenValueIndex = i;
+        const double value = static_cast< double >( inputIt.GetPixel( k ) );
+        for( unsigned int c = 0; c < numberOfComponents; c++ )
+          {
+          hessian[c] += value * kernel[c];
+          }
+        kernel += numberOfComponents;
         }
-      }
 
-    EigenVectorMatrixType   matrixPixel;
-    matrixPixel = eigenVectorImageIterator.Get();
-
-    /*
-    std::cout << "EigenValues(" << eigenValueImageIterator.GetIndex()[0] << ","
-                                         << eigenValueImageIterator.GetIndex()[1] << ","
-                                         << eigenValueImageIterator.GetIndex()[2] <<")\t="
-                                         << smallest << ","
-                                         << largest << ")" << std::endl;
-    */
-    if( vnl_math_abs(largest) >  toleranceEigenValues  )
-      {
-      //Assuming eigenvectors are rows
-      itk::VariableLengthVector<double> primaryEigenVector( vectorLength );
-      for( unsigned int i=0; i < vectorLength; i++ )
+      MatrixType hessianMatrix;
+      unsigned int c = 0;
+      for( unsigned int i = 0; i < ImageDimension; i++ )
         {
-        primaryEigenVector[i] = matrixPixel[largestEigenValueIndex][i];
+        for( unsigned int j = i; j < ImageDimension; j++, c++ )
+          {
+          hessianMatrix[i][j] = hessian[c];
+          hessianMatrix[j][i] = hessian[c];
+          }
         }
 
-      primaryEigenVectorImageIterator.Set( primaryEigenVector );
-      }
+      EigenValueArrayType eigenValues;
+      MatrixType eigenVectors;
+      eigenAnalysis.ComputeEigenValuesAndVectors( hessianMatrix, eigenValues,
+        eigenVectors );
+
+      // Boundary normal: eigenvector of the largest-magnitude eigenvalue
+      unsigned int largestEigenValueIndex = 0;
+      double largest = vnl_math_abs( eigenValues[0] );
+      for( unsigned int i = 1; i < ImageDimension; i++ )
+        {
+        if( vnl_math_abs( eigenValues[i] ) > largest )
+          {
+          largest = vnl_math_abs( eigenValues[i] );
+          largestEigenValueIndex = i;
+          }
+        }
 
-    ++eigenValueImageIterator;
-    ++eigenVectorImageIterator;
-    ++primaryEigenVectorImageIterator;
+      OutputImagePixelType angle = 0;
+      if( largest > toleranceEigenValues )
+        {
+        //Vector from the probe origin to the surface voxel
+        VectorType beamVector;
+        VectorType primaryEigenVector;
+        for( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          beamVector[i] = inputIt.GetIndex()[i] - m_UltrasoundProbeOrigin[i];
+          //Assuming eigenvectors are rows
+          primaryEigenVector[i] = eigenVectors[largestEigenValueIndex][i];
+          }
+
+        const double beamNorm = beamVector.GetNorm();
+        const double normalNorm = primaryEigenVector.GetNorm();
+        if( beamNorm > zeroNormVectorTolerance
+          && normalNorm > zeroNormVectorTolerance )
+          {
+          angle = static_cast< OutputImagePixelType >( vnl_math_abs(
+            beamVector * primaryEigenVector / ( beamNorm * normalNorm ) ) );
+          }
+        }
+      outputIt.Set( angle );
+
+      progress.CompletedPixel();
+      }
     }
 }
 
@@ -292,6 +299,8 @@ AngleOfIncidenceImageFilter< TInputImage, TOutputImage >
      << static_cast< typename NumericTraits< VectorType >::PrintType >
   ( m_UltrasoundProbeOrigin )
   << std::endl;
+  os << indent << "Sigma : " << m_Sigma << std::endl;
+  os << indent << "Kernel radius : " << m_KernelRadius << std::endl;
 }
 
 } // End namespace itk
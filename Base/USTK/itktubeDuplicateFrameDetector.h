@@ -0,0 +1,181 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeDuplicateFrameDetector_h
+#define __itktubeDuplicateFrameDetector_h
+
+#include <itkMetaDataDictionary.h>
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+
+#include <vector>
+
+namespace itk
+{
+
+namespace tube
+{
+
+/** \class DuplicateFrameDetector
+ *
+ * \brief Detect duplicate video frames as they arrive.
+ *
+ * Frames are passed one at a time to AddFrame as contiguous buffers of
+ * FrameWidth x FrameHeight pixels.  A frame is a duplicate of the frame that
+ * follows it when the fraction of pixels whose absolute difference is within
+ * Tolerance exceeds FractionalThreshold; as in
+ * MarkDuplicateFramesInvalidImageFilter, the earlier frame of such a pair is
+ * the one reported invalid.
+ *
+ * Each frame is summarized by a fingerprint: a checksum of its pixels and the
+ * mean, minimum and maximum of each BlockSize x BlockSize block.  Identical
+ * checksums, confirmed with a memory comparison, mark a duplicate without
+ * counting pixels.  Otherwise, the block statistics bound
+ * the number of pixels that can lie within Tolerance of each other, and the
+ * pixel-by-pixel comparison is only run when that bound exceeds the
+ * threshold, so the result is the same as always comparing every pixel.
+ * Only the previous frame and its fingerprint are kept.
+ */
+template< typename TPixel >
+class DuplicateFrameDetector : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef DuplicateFrameDetector                Self;
+  typedef Object                                Superclass;
+  typedef SmartPointer< Self >                  Pointer;
+  typedef SmartPointer< const Self >            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( DuplicateFrameDetector, Object );
+
+  typedef TPixel                                PixelType;
+  typedef std::vector< SizeValueType >          FrameListType;
+
+  /** Compact summary of one frame. */
+  struct FingerprintType
+    {
+    unsigned long long     Checksum;
+    std::vector< double >  BlockMean;
+    std::vector< double >  BlockMinimum;
+    std::vector< double >  BlockMaximum;
+    };
+
+  /** Set the tolerance which determines if a pixel is unchanged.  This is
+   * considered inclusive. */
+  itkSetMacro( Tolerance, PixelType );
+  itkGetConstMacro( Tolerance, PixelType );
+
+  /** Set the fractional threshold after which a frame is considered a
+   * duplicate. */
+  itkSetMacro( FractionalThreshold, double );
+  itkGetConstMacro( FractionalThreshold, double );
+
+  /** Set the edge length, in pixels, of the fingerprint blocks. */
+  itkSetClampMacro( BlockSize, unsigned int, 1,
+    NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( BlockSize, unsigned int );
+
+  /** Set the frame dimensions.  This resets the detector. */
+  void SetFrameSize( SizeValueType width, SizeValueType height );
+  itkGetConstMacro( FrameWidth, SizeValueType );
+  itkGetConstMacro( FrameHeight, SizeValueType );
+
+  /** Forget previous frames and detected duplicates. */
+  void Reset( void );
+
+  /** Add the next frame.  Returns true if the previous frame was found to be
+   * a duplicate of this one, in which case it was appended to the invalid
+   * frame list. */
+  bool AddFrame( const PixelType * frame );
+
+  /** Number of frames added since the last reset. */
+  itkGetConstMacro( NumberOfFrames, SizeValueType );
+
+  /** Number of pixel-by-pixel comparisons run since the last reset. */
+  itkGetConstMacro( NumberOfFullComparisons, SizeValueType );
+
+  /** Invalid frame indices found so far, in increasing order. */
+  const FrameListType & GetInvalidFrames( void ) const;
+
+  /** Compute the fingerprint of a frame.  Thread safe. */
+  void ComputeFingerprint( const PixelType * frame,
+    FingerprintType & fingerprint ) const;
+
+  /** Decide if frame a is a duplicate of frame b.  Thread safe; returns
+   * whether a full comparison was needed in fullComparison. */
+  bool IsDuplicate( const PixelType * a, const FingerprintType & aFingerprint,
+    const PixelType * b, const FingerprintType & bFingerprint,
+    bool & fullComparison ) const;
+
+  /** Mark a frame invalid in a Plus ultrasound format MetaDataDictionary. */
+  static void MarkFrameInvalid( MetaDataDictionary & dictionary,
+    SizeValueType frame );
+
+protected:
+  DuplicateFrameDetector( void );
+  virtual ~DuplicateFrameDetector( void ) {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+  DuplicateFrameDetector( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  /** Upper bound on the number of pixels within Tolerance. */
+  SizeValueType ComputeSameCountUpperBound( const FingerprintType & a,
+    const FingerprintType & b ) const;
+
+  /** Count the pixels within Tolerance. */
+  SizeValueType ComputeSameCount( const PixelType * a,
+    const PixelType * b ) const;
+
+  PixelType                 m_Tolerance;
+  double                    m_FractionalThreshold;
+  unsigned int              m_BlockSize;
+
+  SizeValueType             m_FrameWidth;
+  SizeValueType             m_FrameHeight;
+
+  SizeValueType             m_NumberOfFrames;
+  SizeValueType             m_NumberOfFullComparisons;
+
+  std::vector< PixelType >  m_PreviousFrame;
+  FingerprintType           m_PreviousFingerprint;
+
+  FrameListType             m_InvalidFrames;
+
+}; // End class DuplicateFrameDetector
+
+} // End namespace tube
+
+} // End namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itktubeDuplicateFrameDetector.hxx"
+#endif
+
+#endif // End !defined(__itktubeDuplicateFrameDetector_h)
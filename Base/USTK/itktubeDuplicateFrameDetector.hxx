@@ -0,0 +1,336 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#ifndef __itktubeDuplicateFrameDetector_hxx
+#define __itktubeDuplicateFrameDetector_hxx
+
+#include "itktubeDuplicateFrameDetector.h"
+
+#include <itkMetaDataObject.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace itk
+{
+
+namespace tube
+{
+
+template< typename TPixel >
+DuplicateFrameDetector< TPixel >
+::DuplicateFrameDetector( void ):
+  m_Tolerance( 2 ),
+  m_FractionalThreshold( 0.7 ),
+  m_BlockSize( 8 ),
+  m_FrameWidth( 0 ),
+  m_FrameHeight( 0 ),
+  m_NumberOfFrames( 0 ),
+  m_NumberOfFullComparisons( 0 )
+{
+  m_PreviousFingerprint.Checksum = 0;
+}
+
+
+template< typename TPixel >
+void
+DuplicateFrameDetector< TPixel >
+::SetFrameSize( SizeValueType width, SizeValueType height )
+{
+  m_FrameWidth = width;
+  m_FrameHeight = height;
+  this->Reset();
+  this->Modified();
+}
+
+
+template< typename TPixel >
+void
+DuplicateFrameDetector< TPixel >
+::Reset( void )
+{
+  m_NumberOfFrames = 0;
+  m_NumberOfFullComparisons = 0;
+  m_PreviousFrame.clear();
+  m_PreviousFingerprint.Checksum = 0;
+  m_PreviousFingerprint.BlockMean.clear();
+  m_PreviousFingerprint.BlockMinimum.clear();
+  m_PreviousFingerprint.BlockMaximum.clear();
+  m_InvalidFrames.clear();
+}
+
+
+template< typename TPixel >
+bool
+DuplicateFrameDetector< TPixel >
+::AddFrame( const PixelType * frame )
+{
+  const SizeValueType numberOfPixels = m_FrameWidth * m_FrameHeight;
+  if( numberOfPixels == 0 )
+    {
+    itkExceptionMacro( << "Frame size not set." );
+    }
+
+  FingerprintType fingerprint;
+  this->ComputeFingerprint( frame, fingerprint );
+
+  bool previousIsDuplicate = false;
+  if( m_NumberOfFrames > 0 )
+    {
+    bool fullComparison = false;
+    previousIsDuplicate = this->IsDuplicate( &( m_PreviousFrame[0] ),
+      m_PreviousFingerprint, frame, fingerprint, fullComparison );
+    if( fullComparison )
+      {
+      ++m_NumberOfFullComparisons;
+      }
+    if( previousIsDuplicate )
+      {
+      m_InvalidFrames.push_back( m_NumberOfFrames - 1 );
+      }
+    }
+
+  m_PreviousFrame.assign( frame, frame + numberOfPixels );
+  std::swap( m_PreviousFingerprint, fingerprint );
+  ++m_NumberOfFrames;
+
+  return previousIsDuplicate;
+}
+
+
+template< typename TPixel >
+const typename DuplicateFrameDetector< TPixel >::FrameListType &
+DuplicateFrameDetector< TPixel >
+::GetInvalidFrames( void ) const
+{
+  return m_InvalidFrames;
+}
+
+
+template< typename TPixel >
+void
+DuplicateFrameDetector< TPixel >
+::ComputeFingerprint( const PixelType * frame,
+  FingerprintType & fingerprint ) const
+{
+  const SizeValueType blocksX = ( m_FrameWidth + m_BlockSize - 1 )
+    / m_BlockSize;
+  const SizeValueType blocksY = ( m_FrameHeight + m_BlockSize - 1 )
+    / m_BlockSize;
+  const SizeValueType numberOfBlocks = blocksX * blocksY;
+
+  fingerprint.BlockMean.assign( numberOfBlocks, 0.0 );
+  fingerprint.BlockMinimum.assign( numberOfBlocks,
+    NumericTraits< double >::max() );
+  fingerprint.BlockMaximum.assign( numberOfBlocks,
+    NumericTraits< double >::NonpositiveMin() );
+
+  // 64-bit FNV-1a over the pixel bytes
+  unsigned long long checksum = 14695981039346656037ULL;
+
+  const PixelType * pixel = frame;
+  for( SizeValueType y = 0; y < m_FrameHeight; ++y )
+    {
+    const SizeValueType blockRow = ( y / m_BlockSize ) * blocksX;
+    for( SizeValueType x = 0; x < m_FrameWidth; ++x, ++pixel )
+      {
+      const unsigned char * bytes =
+        reinterpret_cast< const unsigned char * >( pixel );
+      for( unsigned int i = 0; i < sizeof( PixelType ); ++i )
+        {
+        checksum = ( checksum ^ bytes[i] ) * 1099511628211ULL;
+        }
+
+      const SizeValueType block = blockRow + x / m_BlockSize;
+      const double value = static_cast< double >( *pixel );
+      fingerprint.BlockMean[block] += value;
+      if( value < fingerprint.BlockMinimum[block] )
+        {
+        fingerprint.BlockMinimum[block] = value;
+        }
+      if( value > fingerprint.BlockMaximum[block] )
+        {
+        fingerprint.BlockMaximum[block] = value;
+        }
+      }
+    }
+  fingerprint.Checksum = checksum;
+
+  for( SizeValueType by = 0; by < blocksY; ++by )
+    {
+    const SizeValueType height = std::min< SizeValueType >( m_BlockSize,
+      m_FrameHeight - by * m_BlockSize );
+    for( SizeValueType bx = 0; bx < blocksX; ++bx )
+      {
+      const SizeValueType width = std::min< SizeValueType >( m_BlockSize,
+        m_FrameWidth - bx * m_BlockSize );
+      fingerprint.BlockMean[by * blocksX + bx] /= width * height;
+      }
+    }
+}
+
+
+template< typename TPixel >
+SizeValueType
+DuplicateFrameDetector< TPixel >
+::ComputeSameCountUpperBound( const FingerprintType & a,
+  const FingerprintType & b ) const
+{
+  const SizeValueType blocksX = ( m_FrameWidth + m_BlockSize - 1 )
+    / m_BlockSize;
+  const SizeValueType blocksY = ( m_FrameHeight + m_BlockSize - 1 )
+    / m_BlockSize;
+  const double tolerance = static_cast< double >( m_Tolerance );
+
+  // In a block of n pixels whose differences are bounded by R, s pixels
+  // within the tolerance t give |mean difference| <= ( s t + ( n - s ) R ) / n,
+  // so s <= n ( R - |mean difference| ) / ( R - t )
+  double bound = 0;
+  for( SizeValueType by = 0; by < blocksY; ++by )
+    {
+    const SizeValueType height = std::min< SizeValueType >( m_BlockSize,
+      m_FrameHeight - by * m_BlockSize );
+    for( SizeValueType bx = 0; bx < blocksX; ++bx )
+      {
+      const SizeValueType block = by * blocksX + bx;
+      const double n = static_cast< double >( height
+        * std::min< SizeValueType >( m_BlockSize,
+          m_FrameWidth - bx * m_BlockSize ) );
+      const double range =
+        std::max( a.BlockMaximum[block], b.BlockMaximum[block] )
+        - std::min( a.BlockMinimum[block], b.BlockMinimum[block] );
+      // Allow for rounding in the accumulated means
+      const double meanDifference = vnl_math_abs( a.BlockMean[block]
+        - b.BlockMean[block] ) - 1e-6 * ( 1.0 + range );
+      if( meanDifference <= tolerance || range <= tolerance )
+        {
+        bound += n;
+        }
+      else
+        {
+        bound += n * ( range - meanDifference ) / ( range - tolerance );
+        }
+      }
+    }
+  return static_cast< SizeValueType >( vcl_ceil( bound ) );
+}
+
+
+template< typename TPixel >
+SizeValueType
+DuplicateFrameDetector< TPixel >
+::ComputeSameCount( const PixelType * a, const PixelType * b ) const
+{
+  const float tolerance = static_cast< float >( m_Tolerance );
+  const SizeValueType numberOfPixels = m_FrameWidth * m_FrameHeight;
+
+  // Branch-free so that the compiler can vectorize the loop
+  SizeValueType sameCount = 0;
+  for( SizeValueType i = 0; i < numberOfPixels; ++i )
+    {
+    const float absDifference = vcl_abs( static_cast< float >( a[i] )
+      - static_cast< float >( b[i] ) );
+    sameCount += ( absDifference <= tolerance );
+    }
+  return sameCount;
+}
+
+
+template< typename TPixel >
+bool
+DuplicateFrameDetector< TPixel >
+::IsDuplicate( const PixelType * a, const FingerprintType & aFingerprint,
+  const PixelType * b, const FingerprintType & bFingerprint,
+  bool & fullComparison ) const
+{
+  const double numberOfPixels = static_cast< double >( m_FrameWidth
+    * m_FrameHeight );
+
+  fullComparison = false;
+  if( aFingerprint.Checksum == bFingerprint.Checksum
+    && std::memcmp( a, b, m_FrameWidth * m_FrameHeight * sizeof( PixelType ) )
+      == 0 )
+    {
+    return 1.0 > m_FractionalThreshold;
+    }
+  if( this->ComputeSameCountUpperBound( aFingerprint, bFingerprint )
+    / numberOfPixels <= m_FractionalThreshold )
+    {
+    return false;
+    }
+
+  fullComparison = true;
+  return this->ComputeSameCount( a, b ) / numberOfPixels
+    > m_FractionalThreshold;
+}
+
+
+template< typename TPixel >
+void
+DuplicateFrameDetector< TPixel >
+::MarkFrameInvalid( MetaDataDictionary & dictionary, SizeValueType frame )
+{
+  std::ostringstream keyPrefix;
+  keyPrefix << "Seq_Frame";
+  keyPrefix.fill( '0' );
+  keyPrefix.width( 4 );
+  keyPrefix << frame;
+  EncapsulateMetaData< std::string >( dictionary,
+                                      keyPrefix.str() + "_ProbeToTrackerTransformStatus",
+                                      std::string( "INVALID" ) );
+}
+
+
+template< typename TPixel >
+void
+DuplicateFrameDetector< TPixel >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Tolerance: "
+     << static_cast< typename NumericTraits< PixelType >::PrintType >(
+       m_Tolerance ) << std::endl;
+  os << indent << "FractionalThreshold: " << m_FractionalThreshold
+     << std::endl;
+  os << indent << "BlockSize: " << m_BlockSize << std::endl;
+  os << indent << "FrameWidth: " << m_FrameWidth << std::endl;
+  os << indent << "FrameHeight: " << m_FrameHeight << std::endl;
+  os << indent << "NumberOfFrames: " << m_NumberOfFrames << std::endl;
+  os << indent << "NumberOfFullComparisons: " << m_NumberOfFullComparisons
+     << std::endl;
+  os << indent << "InvalidFrames:";
+  for( typename FrameListType::const_iterator it = m_InvalidFrames.begin();
+    it != m_InvalidFrames.end(); ++it )
+    {
+    os << " " << *it;
+    }
+  os << std::endl;
+}
+
+} // End namespace tube
+
+} // End namespace itk
+
+#endif // End !defined(__itktubeDuplicateFrameDetector_hxx)
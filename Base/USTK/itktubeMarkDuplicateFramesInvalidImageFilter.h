@@ -24,6 +24,8 @@ limitations under the License.
 #ifndef __itktubeMarkDuplicateFramesInvalidImageFilter_h
 #define __itktubeMarkDuplicateFramesInvalidImageFilter_h
 
+#include "itktubeDuplicateFrameDetector.h"
+
 #include <itkProcessObject.h>
 #include <itkDomainThreader.h>
 #include <itkSimpleDataObjectDecorator.h>
@@ -95,6 +97,10 @@ private:
  * parameter.  Frames are considered the same if same-valued pixels exceed the
  * FractionalThreshold parameter.
  *
+ * The comparisons are made with DuplicateFrameDetector, so frame pairs that
+ * are clearly different, as judged from their fingerprints, are rejected
+ * without comparing every pixel.
+ *
  */
 template< typename TInputImage >
 class MarkDuplicateFramesInvalidImageFilter
@@ -124,6 +130,8 @@ public:
   typedef SimpleDataObjectDecorator< MetaDataDictionary >
     DecoratedMetaDataDictionaryType;
 
+  typedef DuplicateFrameDetector< InputImagePixelType > DetectorType;
+
   /** Set the tolerance which determines if a pixel is unchanged.  Noise with
    * analog framegrabbers requires this to be non-zero. This is considered
    * inclusive. */
@@ -155,6 +163,8 @@ protected:
 
   virtual void GenerateData( void );
 
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
 private:
   MarkDuplicateFramesInvalidImageFilter( const Self & );
   void operator=( const Self & ); // purposely not implemented
@@ -164,6 +174,8 @@ private:
 
   const MetaDataDictionary * m_InputMetaDataDictionary;
 
+  typename DetectorType::Pointer m_Detector;
+
   friend class MarkDuplicateFramesInvalidImageFilterThreader< Self >;
   typedef MarkDuplicateFramesInvalidImageFilterThreader< Self >
     ThreaderType;
@@ -26,8 +26,7 @@ limitations under the License.
 
 #include "itktubeMarkDuplicateFramesInvalidImageFilter.h"
 
-#include <itkImageSliceConstIteratorWithIndex.h>
-#include <itkMetaDataObject.h>
+#include <algorithm>
 
 namespace itk
 {
@@ -58,78 +57,52 @@ MarkDuplicateFramesInvalidImageFilterThreader< TAssociate >
   typedef typename AssociateType::InputImageType InputImageType;
   typedef typename AssociateType::InputImageRegionType
     InputImageRegionType;
+  typedef typename AssociateType::InputImagePixelType
+    InputImagePixelType;
+  typedef typename AssociateType::DetectorType DetectorType;
 
   const InputImageType * inputImage = this->m_Associate->GetInput();
-  const InputImageRegionType largestRegion =
-    inputImage->GetLargestPossibleRegion();
-  const typename InputImageRegionType::IndexType largestIndex =
-    largestRegion.GetIndex();
-  const typename InputImageRegionType::SizeType largestSize =
-    largestRegion.GetSize();
-
-  InputImageRegionType nextSliceRegion = regionForThread;
-  typename InputImageType::IndexType nextSliceIndex =
-    nextSliceRegion.GetIndex();
-  ++nextSliceIndex[2];
-  typename InputImageType::SizeType nextSliceSize =
-    nextSliceRegion.GetSize();
-  InputImageRegionType currentSliceRegion = regionForThread;
-  const typename InputImageType::IndexType currentSliceIndex =
-    currentSliceRegion.GetIndex();
-  typename InputImageType::SizeType currentSliceSize =
-    currentSliceRegion.GetSize();
-  if( currentSliceIndex[2] + currentSliceSize[2] ==
-        largestIndex[2] + largestSize[2] )
+  const DetectorType * detector = this->m_Associate->m_Detector;
+
+  const InputImageRegionType bufferedRegion =
+    inputImage->GetBufferedRegion();
+  const SizeValueType lastFrame = bufferedRegion.GetIndex()[2]
+    + bufferedRegion.GetSize()[2] - 1;
+  const SizeValueType sliceStride = bufferedRegion.GetSize()[0]
+    * bufferedRegion.GetSize()[1];
+
+  // The buffered region spans whole slices, so each frame is contiguous.
+  SizeValueType currentFrame = regionForThread.GetIndex()[2];
+  SizeValueType endFrame = currentFrame + regionForThread.GetSize()[2];
+  if( endFrame > lastFrame )
     {
-    --nextSliceSize[2];
-    --currentSliceSize[2];
+    endFrame = lastFrame;
     }
-  nextSliceRegion.SetIndex( nextSliceIndex );
-  nextSliceRegion.SetSize( nextSliceSize );
-  currentSliceRegion.SetSize( currentSliceSize );
-
-  typedef ImageSliceConstIteratorWithIndex< InputImageType > IteratorType;
-  IteratorType nextSliceIt( inputImage, nextSliceRegion );
-  IteratorType currentSliceIt( inputImage, currentSliceRegion );
-
-  nextSliceIt.GoToBegin();
-  nextSliceIt.SetFirstDirection( 0 );
-  nextSliceIt.SetSecondDirection( 1 );
-  currentSliceIt.GoToBegin();
-  currentSliceIt.SetFirstDirection( 0 );
-  currentSliceIt.SetSecondDirection( 1 );
-  const float tolerance = static_cast< float >( this->m_Associate->m_Tolerance );
-  const float numberOfSlicePixels =
-    static_cast< float >( largestSize[0] * largestSize[1] );
-  SizeValueType currentFrame = currentSliceIndex[2];
-  while( !currentSliceIt.IsAtEnd() )
+  if( currentFrame >= endFrame )
     {
-    SizeValueType sameCount = 0;
-    while( !currentSliceIt.IsAtEndOfSlice() )
-      {
-      while( !currentSliceIt.IsAtEndOfLine() )
-        {
-        const float absDifference =
-          vcl_abs( static_cast< float >( currentSliceIt.Get() ) -
-            static_cast< float >( nextSliceIt.Get() ) );
-        if( absDifference <= tolerance )
-          {
-          ++sameCount;
-          }
-        ++currentSliceIt;
-        ++nextSliceIt;
-        }
-      currentSliceIt.NextLine();
-      nextSliceIt.NextLine();
-      }
-    //std::cout << sameCount / numberOfSlicePixels << std::endl;
-    if( sameCount / numberOfSlicePixels > this->m_Associate->m_FractionalThreshold )
+    return;
+    }
+
+  typename InputImageType::IndexType sliceIndex = bufferedRegion.GetIndex();
+  sliceIndex[2] = currentFrame;
+  const InputImagePixelType * current = inputImage->GetBufferPointer()
+    + inputImage->ComputeOffset( sliceIndex );
+
+  typename DetectorType::FingerprintType currentFingerprint;
+  typename DetectorType::FingerprintType nextFingerprint;
+  detector->ComputeFingerprint( current, currentFingerprint );
+  for( ; currentFrame < endFrame; ++currentFrame )
+    {
+    const InputImagePixelType * next = current + sliceStride;
+    detector->ComputeFingerprint( next, nextFingerprint );
+    bool fullComparison;
+    if( detector->IsDuplicate( current, currentFingerprint, next,
+      nextFingerprint, fullComparison ) )
       {
       m_InvalidFramesPerThread[threadId].push_back( currentFrame );
       }
-    currentSliceIt.NextSlice();
-    nextSliceIt.NextSlice();
-    ++currentFrame;
+    std::swap( currentFingerprint, nextFingerprint );
+    current = next;
     }
 }
 
@@ -142,7 +115,6 @@ MarkDuplicateFramesInvalidImageFilterThreader< TAssociate >
   MetaDataDictionary newDictionary =
     *(this->m_Associate->GetInputMetaDataDictionary());
   const ThreadIdType numberOfThreads = this->GetNumberOfThreadsUsed();
-  std::ostringstream keyPrefix;
   for( ThreadIdType ii = 0; ii < numberOfThreads; ++ii )
     {
     for( typename InvalidFramesType::const_iterator invalidIt =
@@ -150,14 +122,8 @@ MarkDuplicateFramesInvalidImageFilterThreader< TAssociate >
       invalidIt != m_InvalidFramesPerThread[ii].end();
       ++invalidIt )
       {
-      keyPrefix.str("");
-      keyPrefix << "Seq_Frame";
-      keyPrefix.fill( '0' );
-      keyPrefix.width( 4 );
-      keyPrefix << *invalidIt;
-      EncapsulateMetaData< std::string >( newDictionary,
-                                          keyPrefix.str() + "_ProbeToTrackerTransformStatus",
-                                          std::string( "INVALID" ) );
+      AssociateType::DetectorType::MarkFrameInvalid( newDictionary,
+        *invalidIt );
       }
     }
   DataObject * outputDataObject =
@@ -173,6 +139,7 @@ MarkDuplicateFramesInvalidImageFilter< TInputImage >
   m_FractionalThreshold( 0.7 ),
   m_InputMetaDataDictionary( NULL )
 {
+  m_Detector = DetectorType::New();
   m_Threader = ThreaderType::New();
 
   this->SetNumberOfRequiredInputs( 1 );
@@ -258,7 +225,33 @@ MarkDuplicateFramesInvalidImageFilter< TInputImage >
 ::GenerateData( void )
 {
   const InputImageType * inputImage = this->GetInput();
-  this->m_Threader->Execute( this, inputImage->GetBufferedRegion() );
+  const InputImageRegionType bufferedRegion =
+    inputImage->GetBufferedRegion();
+
+  m_Detector->SetFrameSize( bufferedRegion.GetSize()[0],
+    bufferedRegion.GetSize()[1] );
+  m_Detector->SetTolerance( m_Tolerance );
+  m_Detector->SetFractionalThreshold( m_FractionalThreshold );
+
+  this->m_Threader->Execute( this, bufferedRegion );
+}
+
+
+template< typename TInputImage >
+void
+MarkDuplicateFramesInvalidImageFilter< TInputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Tolerance: "
+     << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >(
+       m_Tolerance ) << std::endl;
+  os << indent << "FractionalThreshold: " << m_FractionalThreshold
+     << std::endl;
+  os << indent << "InputMetaDataDictionary: " << m_InputMetaDataDictionary
+     << std::endl;
+  os << indent << "Detector: " << m_Detector.GetPointer() << std::endl;
 }
 
 } // End namespace tube
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "vtkTubeLevelOfDetailGenerator.h"
+
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+int vtkTubeLevelOfDetailGeneratorTest( int argc, char * argv[] )
+{
+  if( argc > 1 )
+    {
+    std::cerr << "Usage: " << argv[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Two tubes: one of 9 points and one of 2 points
+  vtkNew< vtkPoints > points;
+  vtkNew< vtkDoubleArray > radius;
+  radius->SetName( "TubeRadius" );
+  vtkNew< vtkCellArray > lines;
+
+  lines->InsertNextCell( 9 );
+  for( vtkIdType i = 0; i < 9; ++i )
+    {
+    lines->InsertCellPoint( points->InsertNextPoint( i, 0, 0 ) );
+    radius->InsertNextValue( 1 + 0.1 * i );
+    }
+  lines->InsertNextCell( 2 );
+  for( vtkIdType i = 0; i < 2; ++i )
+    {
+    lines->InsertCellPoint( points->InsertNextPoint( 0, i, 5 ) );
+    radius->InsertNextValue( 2 );
+    }
+
+  vtkNew< vtkPolyData > polyData;
+  polyData->SetPoints( points.GetPointer() );
+  polyData->SetLines( lines.GetPointer() );
+  polyData->GetPointData()->AddArray( radius.GetPointer() );
+  polyData->GetPointData()->SetActiveScalars( "TubeRadius" );
+
+  vtkNew< vtkTubeLevelOfDetailGenerator > generator;
+  generator->SetInput( polyData.GetPointer() );
+  generator->Print( std::cout );
+
+  int returnStatus = EXIT_SUCCESS;
+
+  if( generator->GetNumberOfLevels() != 4 )
+    {
+    std::cerr << "Expected 4 levels, got "
+              << generator->GetNumberOfLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Levels of points along the first tube; the end points are always drawn
+  const int expectedPointLevels[] = { 3, 0, 1, 0, 2, 0, 1, 0, 3, 3, 3 };
+  for( vtkIdType i = 0; i < 11; ++i )
+    {
+    if( generator->GetPointLevel( i ) != expectedPointLevels[i] )
+      {
+      std::cerr << "Point " << i << ": expected level "
+                << expectedPointLevels[i] << ", got "
+                << generator->GetPointLevel( i ) << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  // Number of line points drawn at each level
+  const vtkIdType expectedLinePoints[] = { 11, 7, 5, 4 };
+  for( int level = 0; level < 4; ++level )
+    {
+    vtkPolyData * levelPolyData = generator->GetLevelPolyData( level );
+    if( levelPolyData->GetPoints() != polyData->GetPoints()
+      || levelPolyData->GetPointData()->GetArray( "TubeRadius" )
+        != radius.GetPointer() )
+      {
+      std::cerr << "Level " << level << " does not share the input points"
+                << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    if( levelPolyData->GetNumberOfLines() != 2 )
+      {
+      std::cerr << "Level " << level << ": expected 2 lines, got "
+                << levelPolyData->GetNumberOfLines() << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+
+    vtkIdType linePoints = 0;
+    vtkIdType numberOfPointsInCell;
+    vtkIdType * pointIds;
+    vtkCellArray * levelLines = levelPolyData->GetLines();
+    for( levelLines->InitTraversal();
+      levelLines->GetNextCell( numberOfPointsInCell, pointIds ); )
+      {
+      for( vtkIdType i = 0; i < numberOfPointsInCell; ++i )
+        {
+        if( generator->GetPointLevel( pointIds[i] ) < level )
+          {
+          std::cerr << "Level " << level << " draws point " << pointIds[i]
+                    << std::endl;
+          returnStatus = EXIT_FAILURE;
+          }
+        }
+      linePoints += numberOfPointsInCell;
+      }
+    if( linePoints != expectedLinePoints[level] )
+      {
+      std::cerr << "Level " << level << ": expected "
+                << expectedLinePoints[level] << " line points, got "
+                << linePoints << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    if( std::fabs( generator->GetLevelRatio( level )
+      - expectedLinePoints[level] / 11. ) > 1e-12 )
+      {
+      std::cerr << "Level " << level << ": wrong ratio "
+                << generator->GetLevelRatio( level ) << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+
+  // Selecting levels from subsampling ratios
+  const double ratios[] = { 1.0, 0.6, 0.5, 0.4, 0.0 };
+  const int expectedLevels[] = { 0, 1, 1, 2, 3 };
+  for( int i = 0; i < 5; ++i )
+    {
+    if( generator->GetLevelForRatio( ratios[i] ) != expectedLevels[i] )
+      {
+      std::cerr << "Ratio " << ratios[i] << ": expected level "
+                << expectedLevels[i] << ", got "
+                << generator->GetLevelForRatio( ratios[i] ) << std::endl;
+      returnStatus = EXIT_FAILURE;
+      }
+    }
+  if( generator->GetPolyDataForRatio( 1.0 ) != polyData.GetPointer() )
+    {
+    std::cerr << "The finest level is not the input" << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  // Changing the input rebuilds the levels
+  vtkNew< vtkCellArray > shortLines;
+  shortLines->InsertNextCell( 2 );
+  shortLines->InsertCellPoint( 9 );
+  shortLines->InsertCellPoint( 10 );
+  polyData->SetLines( shortLines.GetPointer() );
+  if( generator->GetNumberOfLevels() != 1 )
+    {
+    std::cerr << "Expected 1 level after the update, got "
+              << generator->GetNumberOfLevels() << std::endl;
+    returnStatus = EXIT_FAILURE;
+    }
+
+  return returnStatus;
+}
@@ -0,0 +1,269 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+#include "vtkTubeLevelOfDetailGenerator.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkTubeLevelOfDetailGenerator);
+
+//------------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkTubeLevelOfDetailGenerator, Input, vtkPolyData);
+
+//------------------------------------------------------------------------------
+vtkTubeLevelOfDetailGenerator::vtkTubeLevelOfDetailGenerator( void )
+{
+  this->Input = NULL;
+  this->MaximumNumberOfLevels = 16;
+}
+
+//------------------------------------------------------------------------------
+vtkTubeLevelOfDetailGenerator::~vtkTubeLevelOfDetailGenerator( void )
+{
+  this->SetInput(NULL);
+}
+
+//------------------------------------------------------------------------------
+void vtkTubeLevelOfDetailGenerator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os,indent);
+
+  os << indent << "Input: " << this->Input << std::endl;
+  os << indent << "MaximumNumberOfLevels: "
+     << this->MaximumNumberOfLevels << std::endl;
+  os << indent << "NumberOfLevels: " << this->Levels.size() << std::endl;
+}
+
+//------------------------------------------------------------------------------
+void vtkTubeLevelOfDetailGenerator::Update( void )
+{
+  unsigned long mTime = this->GetMTime();
+  if(this->Input)
+    {
+    mTime = std::max(mTime, this->Input->GetMTime());
+    }
+
+  if(mTime > this->BuildTime.GetMTime())
+    {
+    this->BuildLevels();
+    }
+}
+
+//------------------------------------------------------------------------------
+int vtkTubeLevelOfDetailGenerator::GetNumberOfLevels( void )
+{
+  this->Update();
+
+  return static_cast<int>(this->Levels.size());
+}
+
+//------------------------------------------------------------------------------
+int vtkTubeLevelOfDetailGenerator::GetPointLevel(vtkIdType pointId)
+{
+  this->Update();
+
+  if(pointId < 0
+    || pointId >= static_cast<vtkIdType>(this->PointLevels.size()))
+    {
+    return 0;
+    }
+
+  return this->PointLevels[pointId];
+}
+
+//------------------------------------------------------------------------------
+double vtkTubeLevelOfDetailGenerator::GetLevelRatio(int level)
+{
+  this->Update();
+
+  if(level < 0 || level >= static_cast<int>(this->LevelRatios.size()))
+    {
+    return 0.;
+    }
+
+  return this->LevelRatios[level];
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData* vtkTubeLevelOfDetailGenerator::GetLevelPolyData(int level)
+{
+  this->Update();
+
+  if(this->Levels.empty())
+    {
+    return NULL;
+    }
+
+  // Clamp
+  const int numberOfLevels = static_cast<int>(this->Levels.size());
+  level = (level < 0 ? 0 : (level >= numberOfLevels ? numberOfLevels - 1
+    : level));
+
+  return this->Levels[level];
+}
+
+//------------------------------------------------------------------------------
+int vtkTubeLevelOfDetailGenerator::GetLevelForRatio(double ratio)
+{
+  this->Update();
+
+  for(int level = static_cast<int>(this->LevelRatios.size()) - 1;
+    level > 0; --level)
+    {
+    if(this->LevelRatios[level] >= ratio)
+      {
+      return level;
+      }
+    }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData* vtkTubeLevelOfDetailGenerator::GetPolyDataForRatio(double ratio)
+{
+  return this->GetLevelPolyData(this->GetLevelForRatio(ratio));
+}
+
+//------------------------------------------------------------------------------
+void vtkTubeLevelOfDetailGenerator::BuildLevels( void )
+{
+  this->PointLevels.clear();
+  this->LevelRatios.clear();
+  this->Levels.clear();
+  this->BuildTime.Modified();
+
+  if(!this->Input || !this->Input->GetPoints())
+    {
+    return;
+    }
+
+  vtkCellArray* lines = this->Input->GetLines();
+  vtkIdType numberOfPointsInCell;
+  vtkIdType* pointIds;
+
+  // The longest line bounds the number of levels that differ from each
+  // other: level L drops points only if 2^(L-1) is an inner index of a line.
+  vtkIdType maximumLineLength = 0;
+  for(lines->InitTraversal();
+      lines->GetNextCell(numberOfPointsInCell, pointIds); )
+    {
+    maximumLineLength = std::max(maximumLineLength, numberOfPointsInCell);
+    }
+
+  int numberOfLevels = 1;
+  while(numberOfLevels < this->MaximumNumberOfLevels
+    && (static_cast<vtkIdType>(1) << (numberOfLevels - 1))
+       < maximumLineLength - 1)
+    {
+    ++numberOfLevels;
+    }
+  const int topLevel = numberOfLevels - 1;
+
+  // The point at index i of a line is drawn up to the level L for which i
+  // is a multiple of 2^L. The end points of a line are always drawn.
+  this->PointLevels.assign(this->Input->GetNumberOfPoints(), 0);
+  std::vector<vtkIdType> linePointsUpToLevel(numberOfLevels, 0);
+  vtkIdType numberOfLinePoints = 0;
+  for(lines->InitTraversal();
+      lines->GetNextCell(numberOfPointsInCell, pointIds); )
+    {
+    for(vtkIdType i = 0; i < numberOfPointsInCell; ++i)
+      {
+      int level = topLevel;
+      if(i > 0 && i < numberOfPointsInCell - 1)
+        {
+        level = 0;
+        while(level < topLevel && (i & ((static_cast<vtkIdType>(2) << level)
+          - 1)) == 0)
+          {
+          ++level;
+          }
+        }
+      unsigned char& pointLevel = this->PointLevels[pointIds[i]];
+      pointLevel = std::max(pointLevel, static_cast<unsigned char>(level));
+      ++linePointsUpToLevel[level];
+      ++numberOfLinePoints;
+      }
+    }
+
+  // A line point is drawn at its own level and at all finer levels
+  this->LevelRatios.assign(numberOfLevels, 1.);
+  vtkIdType linePointsAtLevel = 0;
+  for(int level = topLevel; level >= 0; --level)
+    {
+    linePointsAtLevel += linePointsUpToLevel[level];
+    if(numberOfLinePoints > 0)
+      {
+      this->LevelRatios[level] =
+        static_cast<double>(linePointsAtLevel) / numberOfLinePoints;
+      }
+    }
+
+  // Level 0 is the input itself. The coarser levels only own their lines
+  this->Levels.resize(numberOfLevels);
+  this->Levels[0] = this->Input;
+  for(int level = 1; level < numberOfLevels; ++level)
+    {
+    const vtkIdType step = static_cast<vtkIdType>(1) << level;
+
+    vtkSmartPointer<vtkCellArray> levelLines =
+      vtkSmartPointer<vtkCellArray>::New();
+    levelLines->Allocate(static_cast<vtkIdType>(this->LevelRatios[level]
+      * numberOfLinePoints) + lines->GetNumberOfCells());
+    for(lines->InitTraversal();
+        lines->GetNextCell(numberOfPointsInCell, pointIds); )
+      {
+      if(numberOfPointsInCell < 2)
+        {
+        levelLines->InsertNextCell(numberOfPointsInCell, pointIds);
+        continue;
+        }
+
+      levelLines->InsertNextCell((numberOfPointsInCell - 2) / step + 2);
+      for(vtkIdType i = 0; i < numberOfPointsInCell - 1; i += step)
+        {
+        levelLines->InsertCellPoint(pointIds[i]);
+        }
+      levelLines->InsertCellPoint(pointIds[numberOfPointsInCell - 1]);
+      }
+
+    vtkSmartPointer<vtkPolyData> levelPolyData =
+      vtkSmartPointer<vtkPolyData>::New();
+    levelPolyData->SetPoints(this->Input->GetPoints());
+    levelPolyData->GetPointData()->ShallowCopy(this->Input->GetPointData());
+    levelPolyData->SetLines(levelLines);
+    this->Levels[level] = levelPolyData;
+    }
+
+  vtkDebugMacro(<< "Built " << numberOfLevels << " levels for "
+                << numberOfLinePoints << " line points");
+}
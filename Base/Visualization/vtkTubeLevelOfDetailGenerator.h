@@ -0,0 +1,114 @@
+/*=========================================================================
+
+Library:   TubeTK
+
+Copyright 2010 Kitware Inc. 28 Corporate Drive,
+Clifton Park, NY, 12065, USA.
+
+All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+=========================================================================*/
+
+/// vtkTubeLevelOfDetailGenerator -
+/// Level-of-detail polylines for tube centerlines.
+///
+/// The input is a vtkPolyData whose lines are the centerlines of tubes, as
+/// produced from a tube tree. The generator assigns each point the coarsest
+/// level at which it is still drawn, which gives a hierarchy of point sets:
+/// level 0 draws every point, and level L draws every 2^L-th point of each
+/// line plus its two end points. The polylines of every level are built once
+/// and share the points and point data of the input, so choosing another
+/// level does not copy or regenerate any geometry.
+
+#ifndef __vtkTubeLevelOfDetailGenerator_h
+#define __vtkTubeLevelOfDetailGenerator_h
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+
+#include <vector>
+
+class vtkPolyData;
+
+class vtkTubeLevelOfDetailGenerator : public vtkObject
+{
+public:
+  static vtkTubeLevelOfDetailGenerator* New( void );
+  vtkTypeMacro(vtkTubeLevelOfDetailGenerator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Set the full resolution polydata. Its lines are the tube centerlines.
+  virtual void SetInput(vtkPolyData* input);
+  vtkGetObjectMacro(Input, vtkPolyData);
+
+  ///
+  /// Upper bound on the number of levels that are built.
+  vtkSetClampMacro(MaximumNumberOfLevels, int, 1, 31);
+  vtkGetMacro(MaximumNumberOfLevels, int);
+
+  ///
+  /// Build the levels if the input or the settings changed since the last
+  /// build. Called by all the methods below.
+  virtual void Update( void );
+
+  ///
+  /// Get the number of levels. It is 0 without an input.
+  int GetNumberOfLevels( void );
+
+  ///
+  /// Get the coarsest level at which a point of the input is drawn.
+  int GetPointLevel(vtkIdType pointId);
+
+  ///
+  /// Get the fraction of the line points of the input drawn at a level.
+  double GetLevelRatio(int level);
+
+  ///
+  /// Get the polydata of a level. Level 0 is the input itself.
+  vtkPolyData* GetLevelPolyData(int level);
+
+  ///
+  /// Get the coarsest level that draws at least the given fraction of the
+  /// line points of the input.
+  int GetLevelForRatio(double ratio);
+
+  ///
+  /// Get the polydata of the level selected by GetLevelForRatio().
+  vtkPolyData* GetPolyDataForRatio(double ratio);
+
+protected:
+  vtkTubeLevelOfDetailGenerator( void );
+  ~vtkTubeLevelOfDetailGenerator( void );
+
+  /// Compute the point levels and the polylines of all levels.
+  virtual void BuildLevels( void );
+
+  vtkPolyData* Input;
+  int MaximumNumberOfLevels;
+
+  std::vector<unsigned char> PointLevels;
+  std::vector<double> LevelRatios;
+  std::vector< vtkSmartPointer<vtkPolyData> > Levels;
+  vtkTimeStamp BuildTime;
+
+private:
+  vtkTubeLevelOfDetailGenerator(const vtkTubeLevelOfDetailGenerator&);
+  void operator=(const vtkTubeLevelOfDetailGenerator&);
+
+}; // End class vtkTubeLevelOfDetailGenerator
+
+#endif // End !defined(__vtkTubeLevelOfDetailGenerator_h)
@@ -517,6 +517,31 @@ class InteractiveConnectedComponentsUsingParzenPDFsLogic(LabelEffect.LabelEffect
     cliParameters["reclassifyNotObjectMask"] = int(self.getParameter("reclassifyNotObjectMask"))
     cliParameters["forceClassification"] = int(self.getParameter("forceClassification"))
 
+    # Retrain incrementally from the label edits made since the last run,
+    # as long as the same label map is edited and the input volumes and
+    # the labels are unchanged.  The modified time of the image data
+    # tells when the content of a volume changed.
+    stateBase = os.path.join(slicer.app.temporaryPath, 'PDFSegmenterState')
+    labelNode = cliParameters["labelmap"]
+    stateSignature = [labelNode.GetID(),
+                      str(labelNode.GetImageData().GetDimensions())]
+    for i in range(1,4):
+      node = cliParameters["inputVolume"+str(i)]
+      if node and node.GetImageData():
+        stateSignature += [node.GetID(),
+                           str(node.GetImageData().GetMTime())]
+      else:
+        stateSignature += ["", ""]
+    stateSignature += [self.getParameter("voidId"),
+                       self.getParameter("objectId"),
+                       self.getParameter("draft")]
+    stateSignature = ";".join(stateSignature)
+    if (self.getParameter("pdfStateSignature") == stateSignature and
+        os.path.exists(stateBase + ".labelmap.mha")):
+      cliParameters["loadPDFStateBase"] = stateBase
+    cliParameters["savePDFStateBase"] = stateBase
+    self.setParameter("pdfStateSignature", stateSignature)
+
     module = slicer.modules.segmentconnectedcomponentsusingparzenpdfs
     cliNode = self.getCLINode(module, "PDFSegmenterEditorEffect")
     slicer.cli.run(module, cliNode, cliParameters)
@@ -23,13 +23,11 @@ limitations under the License.
 
 // VTK includes
 #include <vtkCellArray.h>
-#include <vtkCleanPolyData.h>
 #include <vtkCommand.h>
 #include <vtkDoubleArray.h>
 #include <vtkEventBroker.h>
 #include <vtkExtractPolyDataGeometry.h>
 #include <vtkExtractSelectedPolyDataIds.h>
-#include <vtkIdTypeArray.h>
 #include <vtkInformation.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -39,6 +37,9 @@ limitations under the License.
 #include <vtkSelection.h>
 #include <vtkSelectionNode.h>
 
+// TubeTK includes
+#include <vtkTubeLevelOfDetailGenerator.h>
+
 // TractographyMRML includes
 #include "vtkMRMLSpatialObjectsGlyphDisplayNode.h"
 #include "vtkMRMLSpatialObjectsLineDisplayNode.h"
@@ -52,8 +53,6 @@ limitations under the License.
 
 // STD includes
 #include <cmath>
-#include <vector>
-#include <algorithm>
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSpatialObjectsNode);
@@ -189,8 +188,12 @@ void vtkMRMLSpatialObjectsNode::UpdateReferences( void )
 //------------------------------------------------------------------------------
 vtkPolyData* vtkMRMLSpatialObjectsNode::GetFilteredPolyData( void )
 {
-  return this->PolyData;
-  //return this->CleanPolyDataPostSubsampling->GetOutput();
+  if(!this->PolyData)
+    {
+    return this->PolyData;
+    }
+
+  return this->LevelOfDetail->GetPolyDataForRatio(this->SubsamplingRatio);
 }
 
 //------------------------------------------------------------------------------
@@ -340,27 +343,16 @@ void vtkMRMLSpatialObjectsNode::SetAndObservePolyData(vtkPolyData* polyData)
 {
   vtkMRMLModelNode::SetAndObservePolyData(polyData);
 
+  // The levels of detail are built once here, changing the subsampling
+  // ratio afterwards only selects one of them.
+  this->LevelOfDetail->SetInput(polyData);
+
   if(!polyData)
     {
     return;
     }
 
-  const vtkIdType numberOfPairs = polyData->GetNumberOfLines();
-
-  std::vector<vtkIdType> idVector;
-  for(vtkIdType i = 0; i < numberOfPairs; ++i )
-    {
-    idVector.push_back(i);
-    }
-
-  random_shuffle(idVector.begin(), idVector.end());
-
-  this->ShuffledIds->Initialize();
-  this->ShuffledIds->SetNumberOfTuples(numberOfPairs);
-  for(vtkIdType i = 0;  i < numberOfPairs; ++i)
-    {
-    this->ShuffledIds->SetValue(i, idVector[i]);
-    }
+  this->LevelOfDetail->Update();
 
   float subsamplingRatio = 1.f;
   this->SetSubsamplingRatio(subsamplingRatio);
@@ -379,8 +371,13 @@ void vtkMRMLSpatialObjectsNode::SetSubsamplingRatio(float ratio)
     (ratio < 0. ? 0. : (ratio > 1. ? 1.: ratio));
   if(oldSubsampling != newSubsamplingRatio)
     {
+    // The display nodes only need a new input if another level is selected
+    const int oldLevel = this->LevelOfDetail->GetLevelForRatio(oldSubsampling);
     this->SubsamplingRatio = newSubsamplingRatio;
-    this->UpdateSubsampling();
+    if(this->LevelOfDetail->GetLevelForRatio(newSubsamplingRatio) != oldLevel)
+      {
+      this->UpdateSubsampling();
+      }
     this->Modified();
     }
 }
@@ -388,14 +385,8 @@ void vtkMRMLSpatialObjectsNode::SetSubsamplingRatio(float ratio)
 //------------------------------------------------------------------------------
 void vtkMRMLSpatialObjectsNode::PrepareSubsampling( void )
 {
-  this->ShuffledIds = vtkIdTypeArray::New();
-  this->CleanPolyDataPostSubsampling = vtkCleanPolyData::New();
-  this->CleanPolyDataPostSubsampling->ConvertLinesToPointsOff();
-  this->CleanPolyDataPostSubsampling->ConvertPolysToLinesOff();
-  this->CleanPolyDataPostSubsampling->ConvertStripsToPolysOff();
-  this->CleanPolyDataPostSubsampling->PointMergingOff();
-
-  this->CleanPolyDataPostSubsampling->SetInput(this->PolyData);
+  this->LevelOfDetail = vtkTubeLevelOfDetailGenerator::New();
+  this->LevelOfDetail->SetInput(this->PolyData);
 }
 
 //------------------------------------------------------------------------------
@@ -431,8 +422,7 @@ void vtkMRMLSpatialObjectsNode::UpdateSubsampling( void )
 //------------------------------------------------------------------------------
 void vtkMRMLSpatialObjectsNode::CleanSubsampling( void )
 {
-  this->CleanPolyDataPostSubsampling->Delete();
-  this->ShuffledIds->Delete();
+  this->LevelOfDetail->Delete();
 }
 
 //------------------------------------------------------------------------------
@@ -26,6 +26,8 @@ limitations under the License.
 ///
 /// vtkMRMLSpatialObjects nodes contain trajectories ("tubes")
 /// from vessels, internally represented as vtkPolyData.
+/// The polydata is subsampled through precomputed levels of detail, see
+/// vtkTubeLevelOfDetailGenerator.
 /// A SpatialObjects node contains many tubes and forms the smallest
 /// logical unit of the vessel network.
 /// that MRML will manage/read/write
@@ -45,10 +47,9 @@ limitations under the License.
 class vtkMRMLSpatialObjectsDisplayNode;
 class vtkExtractSelectedPolyDataIds;
 class vtkMRMLAnnotationNode;
-class vtkIdTypeArray;
 class vtkExtractPolyDataGeometry;
 class vtkPlanes;
-class vtkCleanPolyData;
+class vtkTubeLevelOfDetailGenerator;
 
 class VTK_SLICER_SPATIALOBJECTS_MODULE_MRML_EXPORT vtkMRMLSpatialObjectsNode
   : public vtkMRMLModelNode
@@ -100,8 +101,9 @@ public:
   /// Get the subsampling ratio for the polydata
   vtkGetMacro(SubsamplingRatio, float);
 
-  /// Set the subsampling ratio for the polydata
-  //
+  /// Set the subsampling ratio for the polydata.
+  /// This selects the coarsest level of detail that still draws the given
+  /// fraction of the tube points; no geometry is regenerated.
   virtual void SetSubsamplingRatio(float);
   virtual float GetSubsamplingRatioMinValue( void ) {return 0.;}
   virtual float GetSubsamplingRatioMaxValue( void ) {return 1.;}
@@ -166,13 +168,11 @@ protected:
   // for object processing and editions.
   TubeNetPointerType SpatialObject;
 
-  vtkIdTypeArray* ShuffledIds;
-
   virtual void PrepareSubsampling( void );
   virtual void UpdateSubsampling( void );
   virtual void CleanSubsampling( void );
 
-  vtkCleanPolyData* CleanPolyDataPostSubsampling;
+  vtkTubeLevelOfDetailGenerator* LevelOfDetail;
   float SubsamplingRatio;
 
 }; // End class vtkMRMLSpatialObjectsNode